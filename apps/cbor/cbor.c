@@ -0,0 +1,665 @@
+//+------------------------------------------------------------------------------------------------+
+//| Streaming CBOR (RFC 8949) encoder and decoder.                                                 |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <string.h>
+
+#include "cbor.h"
+
+//Major types.
+#define MAJOR_UINT    0
+#define MAJOR_NINT    1
+#define MAJOR_BYTES   2
+#define MAJOR_TEXT    3
+#define MAJOR_ARRAY   4
+#define MAJOR_MAP     5
+#define MAJOR_TAG     6
+#define MAJOR_SIMPLE  7
+
+//Additional information values.
+#define AI_1BYTE      24
+#define AI_2BYTES     25
+#define AI_4BYTES     26
+#define AI_8BYTES     27
+#define AI_INDEFINITE 31
+
+//Initial bytes of floats and breaks.
+#define INITIAL_HALF    0xF9
+#define INITIAL_SINGLE  0xFA
+#define INITIAL_BREAK   0xFF
+
+//--------------------------------------------------------------------------------------------------
+//Encoder.
+
+//Appends data to the buffer, flushing it whenever it fills up if there's a flush function.
+static void put(struct cbor_writer *w, const void *data, uint32_t length) {
+  const uint8_t *src = data;
+  uint32_t chunk;
+
+  if (w->error != CBOR_OK)
+    return;
+
+  //Fast path, for everything but long strings.
+  if (w->size - w->length >= length) {
+    memcpy(w->data + w->length, src, length);
+    w->length += length;
+    w->total += length;
+    return;
+  }
+
+  if (w->flush == NULL) {
+    w->error = CBOR_ERR_OVERFLOW;
+    return;
+  }
+
+  while (length > 0) {
+    if (w->length == w->size) {
+      w->flush(w->data, w->length, w->ptr);
+      w->length = 0;
+    }
+
+    chunk = w->size - w->length;
+    if (chunk > length)
+      chunk = length;
+
+    memcpy(w->data + w->length, src, chunk);
+    w->length += chunk;
+    w->total += chunk;
+    src += chunk;
+    length -= chunk;
+  }
+}
+
+//Writes the initial byte and the argument of an item, in the shortest form.
+static void put_head(struct cbor_writer *w, uint8_t major, uint64_t argument) {
+  uint8_t head[9];
+  uint8_t length;
+  uint8_t i;
+
+  major <<= 5;
+
+  //Fast path for small values (most keys, counts and lengths), written in place.
+  if (argument < AI_1BYTE && w->length < w->size && w->error == CBOR_OK) {
+    w->data[w->length++] = major | argument;
+    w->total++;
+    return;
+  }
+
+  if (argument < AI_1BYTE) {
+    head[0] = major | argument;
+    length = 1;
+  }
+  else if (argument <= 0xFF) {
+    head[0] = major | AI_1BYTE;
+    length = 2;
+  }
+  else if (argument <= 0xFFFF) {
+    head[0] = major | AI_2BYTES;
+    length = 3;
+  }
+  else if (argument <= 0xFFFFFFFF) {
+    head[0] = major | AI_4BYTES;
+    length = 5;
+  }
+  else {
+    head[0] = major | AI_8BYTES;
+    length = 9;
+  }
+
+  //Big endian argument.
+  for (i = length - 1; i > 0; i--) {
+    head[i] = argument;
+    argument >>= 8;
+  }
+
+  put(w, head, length);
+}
+
+//Converts a single precision float to half precision, if it can be done with no loss. Returns
+//nonzero on success.
+static int float_to_half(uint32_t bits, uint16_t *half) {
+  uint16_t sign = (bits >> 16) & 0x8000;
+  int32_t exponent = (bits >> 23) & 0xFF;
+  uint32_t mantissa = bits & 0x7FFFFF;
+  uint8_t shift;
+
+  //Infinities and NaNs (these keep their upper payload bits).
+  if (exponent == 0xFF) {
+    if (mantissa & 0x1FFF)
+      return 0;
+    *half = sign | 0x7C00 | (mantissa >> 13);
+    return 1;
+  }
+
+  //Zeros. Single precision subnormals are too small for half precision.
+  if (exponent == 0) {
+    if (mantissa != 0)
+      return 0;
+    *half = sign;
+    return 1;
+  }
+
+  exponent -= 127;
+
+  //Normals.
+  if (exponent >= -14 && exponent <= 15) {
+    if (mantissa & 0x1FFF)
+      return 0;
+    *half = sign | ((exponent + 15) << 10) | (mantissa >> 13);
+    return 1;
+  }
+
+  //Half precision subnormals (multiples of 2^-24).
+  if (exponent >= -24 && exponent < -14) {
+    mantissa |= 0x800000;
+    shift = -1 - exponent;
+    if (mantissa & ((1 << shift) - 1))
+      return 0;
+    *half = sign | (mantissa >> shift);
+    return 1;
+  }
+
+  return 0;
+}
+
+//Makes the writer encode into a buffer of the given size. Writing past its end is an error.
+void cbor_writer_init(struct cbor_writer *w, void *buffer, uint32_t size) {
+  cbor_writer_stream(w, buffer, size, NULL, NULL);
+}
+
+//Makes the writer encode into a buffer that is passed to the flush function every time it fills
+//up, and once more by cbor_writer_end().
+void cbor_writer_stream(struct cbor_writer *w, void *buffer, uint32_t size, cbor_flush_t flush,
+                        void *ptr) {
+  w->data = buffer;
+  w->size = size;
+  w->length = 0;
+  w->total = 0;
+  w->flush = flush;
+  w->ptr = ptr;
+  w->error = CBOR_OK;
+}
+
+//Finishes writing, flushing the rest of the data if streaming. Returns the number of bytes
+//written or an error code.
+int32_t cbor_writer_end(struct cbor_writer *w) {
+  if (w->error != CBOR_OK)
+    return w->error;
+
+  if (w->flush != NULL && w->length > 0) {
+    w->flush(w->data, w->length, w->ptr);
+    w->length = 0;
+  }
+
+  return w->total;
+}
+
+void cbor_put_uint(struct cbor_writer *w, uint32_t value) {
+  put_head(w, MAJOR_UINT, value);
+}
+
+void cbor_put_int(struct cbor_writer *w, int32_t value) {
+  if (value >= 0)
+    put_head(w, MAJOR_UINT, value);
+  else
+    put_head(w, MAJOR_NINT, -1 - value);
+}
+
+void cbor_put_uint64(struct cbor_writer *w, uint64_t value) {
+  put_head(w, MAJOR_UINT, value);
+}
+
+void cbor_put_int64(struct cbor_writer *w, int64_t value) {
+  if (value >= 0)
+    put_head(w, MAJOR_UINT, value);
+  else
+    put_head(w, MAJOR_NINT, -1 - value);
+}
+
+void cbor_put_bytes(struct cbor_writer *w, const void *data, uint32_t length) {
+  put_head(w, MAJOR_BYTES, length);
+  put(w, data, length);
+}
+
+void cbor_put_text(struct cbor_writer *w, const char *text) {
+  cbor_put_text_n(w, text, strlen(text));
+}
+
+void cbor_put_text_n(struct cbor_writer *w, const char *text, uint32_t length) {
+  put_head(w, MAJOR_TEXT, length);
+  put(w, text, length);
+}
+
+//Starts an array of count items, which are written next. With CBOR_INDEFINITE, the items are
+//ended by cbor_put_break().
+void cbor_put_array(struct cbor_writer *w, uint32_t count) {
+  uint8_t initial = (MAJOR_ARRAY << 5) | AI_INDEFINITE;
+
+  if (count == CBOR_INDEFINITE)
+    put(w, &initial, 1);
+  else
+    put_head(w, MAJOR_ARRAY, count);
+}
+
+//Starts a map of count pairs, written next as key and value. With CBOR_INDEFINITE, the pairs are
+//ended by cbor_put_break().
+void cbor_put_map(struct cbor_writer *w, uint32_t count) {
+  uint8_t initial = (MAJOR_MAP << 5) | AI_INDEFINITE;
+
+  if (count == CBOR_INDEFINITE)
+    put(w, &initial, 1);
+  else
+    put_head(w, MAJOR_MAP, count);
+}
+
+void cbor_put_tag(struct cbor_writer *w, uint64_t tag) {
+  put_head(w, MAJOR_TAG, tag);
+}
+
+void cbor_put_simple(struct cbor_writer *w, uint8_t value) {
+  //Values 24 to 31 are reserved.
+  if (value >= 24 && value < 32) {
+    if (w->error == CBOR_OK)
+      w->error = CBOR_ERR_INVALID;
+    return;
+  }
+
+  put_head(w, MAJOR_SIMPLE, value);
+}
+
+void cbor_put_bool(struct cbor_writer *w, int value) {
+  cbor_put_simple(w, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void cbor_put_null(struct cbor_writer *w) {
+  cbor_put_simple(w, CBOR_NULL);
+}
+
+//Writes a float in half precision when exact, in single precision otherwise.
+void cbor_put_float(struct cbor_writer *w, float value) {
+  uint8_t data[5];
+  uint32_t bits;
+  uint16_t half;
+
+  memcpy(&bits, &value, 4);
+
+  if (float_to_half(bits, &half)) {
+    data[0] = INITIAL_HALF;
+    data[1] = half >> 8;
+    data[2] = half;
+    put(w, data, 3);
+    return;
+  }
+
+  data[0] = INITIAL_SINGLE;
+  data[1] = bits >> 24;
+  data[2] = bits >> 16;
+  data[3] = bits >> 8;
+  data[4] = bits;
+  put(w, data, 5);
+}
+
+void cbor_put_break(struct cbor_writer *w) {
+  uint8_t initial = INITIAL_BREAK;
+
+  put(w, &initial, 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+//Decoder.
+
+//Converts a half precision float to single precision.
+static float half_to_float(uint16_t half) {
+  uint32_t exponent = (half >> 10) & 0x1F;
+  uint32_t mantissa = half & 0x3FF;
+  uint32_t bits;
+  float value;
+
+  //Subnormals (multiples of 2^-24, exact in single precision).
+  if (exponent == 0) {
+    value = mantissa * (1.0f / 16777216.0f);
+    return (half & 0x8000) ? -value : value;
+  }
+
+  if (exponent == 0x1F)
+    bits = 0x7F800000 | (mantissa << 13);
+  else
+    bits = ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+  bits |= (uint32_t) (half & 0x8000) << 16;
+  memcpy(&value, &bits, 4);
+  return value;
+}
+
+//Reads a big endian value of the given size.
+static uint64_t get_be(const uint8_t *data, uint8_t length) {
+  uint64_t value = 0;
+
+  while (length-- > 0)
+    value = (value << 8) | *data++;
+
+  return value;
+}
+
+void cbor_reader_init(struct cbor_reader *r, const void *data, uint32_t size) {
+  r->data = data;
+  r->size = size;
+  r->pos = 0;
+}
+
+//Decodes the next item. On errors the read position is left unchanged.
+int cbor_read(struct cbor_reader *r, struct cbor_item *item) {
+  uint32_t pos = r->pos;
+  uint32_t available = r->size - pos;
+  uint8_t initial;
+  uint8_t major;
+  uint8_t info;
+  uint8_t length;
+  uint64_t argument;
+  double real;
+
+  if (available == 0)
+    return CBOR_ERR_END;
+
+  initial = r->data[pos++];
+  available--;
+  major = initial >> 5;
+  info = initial & 0x1F;
+
+  //Argument.
+  if (info < AI_1BYTE)
+    argument = info;
+  else if (info <= AI_8BYTES) {
+    length = 1 << (info - AI_1BYTE);
+    if (available < length)
+      return CBOR_ERR_TRUNCATED;
+    argument = get_be(r->data + pos, length);
+    pos += length;
+    available -= length;
+  }
+  else if (info == AI_INDEFINITE)
+    argument = CBOR_INDEFINITE;
+  else
+    return CBOR_ERR_INVALID;
+
+  //Indefinite lengths only apply to strings and containers (and to breaks).
+  if (info == AI_INDEFINITE && (major < MAJOR_BYTES || major == MAJOR_TAG))
+    return CBOR_ERR_INVALID;
+
+  switch (major) {
+    case MAJOR_UINT:
+    case MAJOR_NINT:
+      item->type = major == MAJOR_UINT ? CBOR_UINT : CBOR_NINT;
+      item->value.uint = argument;
+      break;
+
+    case MAJOR_BYTES:
+    case MAJOR_TEXT:
+      item->type = major == MAJOR_BYTES ? CBOR_BYTES : CBOR_TEXT;
+      item->value.string.data = r->data + pos;
+      if (info == AI_INDEFINITE)
+        item->value.string.length = CBOR_INDEFINITE;
+      else {
+        if (argument > available)
+          return CBOR_ERR_TRUNCATED;
+        item->value.string.length = argument;
+        pos += argument;
+      }
+      break;
+
+    case MAJOR_ARRAY:
+    case MAJOR_MAP:
+      //Counts that could never fit in the message are rejected early.
+      if (info != AI_INDEFINITE && argument > available)
+        return CBOR_ERR_TRUNCATED;
+      item->type = major == MAJOR_ARRAY ? CBOR_ARRAY : CBOR_MAP;
+      item->value.count = argument;
+      break;
+
+    case MAJOR_TAG:
+      item->type = CBOR_TAG;
+      item->value.tag = argument;
+      break;
+
+    default:
+      if (info == AI_INDEFINITE)
+        item->type = CBOR_BREAK;
+      else if (info == AI_2BYTES) {
+        item->type = CBOR_FLOAT;
+        item->value.real = half_to_float(argument);
+      }
+      else if (info == AI_4BYTES) {
+        uint32_t bits = argument;
+
+        item->type = CBOR_FLOAT;
+        memcpy(&item->value.real, &bits, 4);
+      }
+      else if (info == AI_8BYTES) {
+        memcpy(&real, &argument, 8);
+        item->type = CBOR_FLOAT;
+        item->value.real = real;
+      }
+      else {
+        //Two byte simple values below 32 are not well formed.
+        if (info == AI_1BYTE && argument < 32)
+          return CBOR_ERR_INVALID;
+        item->type = CBOR_SIMPLE;
+        item->value.simple = argument;
+      }
+      break;
+  }
+
+  r->pos = pos;
+  return CBOR_OK;
+}
+
+//Steps over the next item, including the contents of containers and tags, and the chunks of
+//indefinite length strings. On errors the read position is left unchanged.
+int cbor_skip(struct cbor_reader *r) {
+  struct cbor_item item;
+  uint32_t start = r->pos;
+  uint32_t pending = 1;                     //Items left in the current definite length stretch
+  uint32_t saved[CBOR_SKIP_DEPTH];          //Pending counts of the enclosing stretches
+  uint8_t depth = 0;                        //Indefinite length items open
+  int error;
+
+  while (pending > 0 || depth > 0) {
+    error = cbor_read(r, &item);
+    if (error != CBOR_OK) {
+      r->pos = start;
+      return error;
+    }
+
+    if (item.type == CBOR_BREAK) {
+      //Breaks end indefinite items, once their contents are complete.
+      if (depth == 0 || pending > 0) {
+        r->pos = start;
+        return CBOR_ERR_INVALID;
+      }
+      pending = saved[--depth];
+      continue;
+    }
+
+    if (pending > 0)
+      pending--;
+
+    if (item.type == CBOR_TAG)
+      pending++;
+    else if ((item.type == CBOR_ARRAY || item.type == CBOR_MAP) &&
+             item.value.count != CBOR_INDEFINITE) {
+      //Every item takes at least a byte, so counts beyond the rest of the message are truncated.
+      pending += item.value.count << (item.type == CBOR_MAP);
+      if (pending > r->size - r->pos) {
+        r->pos = start;
+        return CBOR_ERR_TRUNCATED;
+      }
+    }
+    else if (item.type == CBOR_ARRAY || item.type == CBOR_MAP ||
+             ((item.type == CBOR_BYTES || item.type == CBOR_TEXT) &&
+              item.value.string.length == CBOR_INDEFINITE)) {
+      //Indefinite length items hold everything up to their break.
+      if (depth == CBOR_SKIP_DEPTH) {
+        r->pos = start;
+        return CBOR_ERR_DEPTH;
+      }
+      saved[depth++] = pending;
+      pending = 0;
+    }
+  }
+
+  return CBOR_OK;
+}
+
+//Reads the next item, checking its type.
+static int read_type(struct cbor_reader *r, struct cbor_item *item, uint8_t type) {
+  uint32_t start = r->pos;
+  int error;
+
+  error = cbor_read(r, item);
+  if (error != CBOR_OK)
+    return error;
+
+  if (item->type != type) {
+    r->pos = start;
+    return CBOR_ERR_TYPE;
+  }
+
+  return CBOR_OK;
+}
+
+int cbor_get_uint(struct cbor_reader *r, uint32_t *value) {
+  struct cbor_item item;
+  uint32_t start = r->pos;
+  int error;
+
+  error = read_type(r, &item, CBOR_UINT);
+  if (error != CBOR_OK)
+    return error;
+
+  if (item.value.uint > 0xFFFFFFFF) {
+    r->pos = start;
+    return CBOR_ERR_RANGE;
+  }
+
+  *value = item.value.uint;
+  return CBOR_OK;
+}
+
+int cbor_get_int(struct cbor_reader *r, int32_t *value) {
+  struct cbor_item item;
+  uint32_t start = r->pos;
+  int error;
+
+  error = cbor_read(r, &item);
+  if (error != CBOR_OK)
+    return error;
+
+  if (item.type != CBOR_UINT && item.type != CBOR_NINT) {
+    r->pos = start;
+    return CBOR_ERR_TYPE;
+  }
+
+  if (item.value.uint > 0x7FFFFFFF) {
+    r->pos = start;
+    return CBOR_ERR_RANGE;
+  }
+
+  *value = item.type == CBOR_UINT ? (int32_t) item.value.uint : -1 - (int32_t) item.value.uint;
+  return CBOR_OK;
+}
+
+//Reads a float. Integers are taken too, as encoders may write integral values that way.
+int cbor_get_float(struct cbor_reader *r, float *value) {
+  struct cbor_item item;
+  uint32_t start = r->pos;
+  int error;
+
+  error = cbor_read(r, &item);
+  if (error != CBOR_OK)
+    return error;
+
+  if (item.type == CBOR_FLOAT)
+    *value = item.value.real;
+  else if (item.type == CBOR_UINT)
+    *value = item.value.uint;
+  else if (item.type == CBOR_NINT)
+    *value = -1.0f - item.value.uint;
+  else {
+    r->pos = start;
+    return CBOR_ERR_TYPE;
+  }
+
+  return CBOR_OK;
+}
+
+int cbor_get_bool(struct cbor_reader *r, int *value) {
+  struct cbor_item item;
+  uint32_t start = r->pos;
+  int error;
+
+  error = read_type(r, &item, CBOR_SIMPLE);
+  if (error != CBOR_OK)
+    return error;
+
+  if (item.value.simple != CBOR_FALSE && item.value.simple != CBOR_TRUE) {
+    r->pos = start;
+    return CBOR_ERR_TYPE;
+  }
+
+  *value = item.value.simple == CBOR_TRUE;
+  return CBOR_OK;
+}
+
+//Reads a definite length string, returning a pointer into the message (not null terminated).
+static int get_string(struct cbor_reader *r, uint8_t type, const uint8_t **data,
+                      uint32_t *length) {
+  struct cbor_item item;
+  uint32_t start = r->pos;
+  int error;
+
+  error = read_type(r, &item, type);
+  if (error != CBOR_OK)
+    return error;
+
+  //Indefinite strings have to be walked chunk by chunk with cbor_read().
+  if (item.value.string.length == CBOR_INDEFINITE) {
+    r->pos = start;
+    return CBOR_ERR_TYPE;
+  }
+
+  *data = item.value.string.data;
+  *length = item.value.string.length;
+  return CBOR_OK;
+}
+
+int cbor_get_text(struct cbor_reader *r, const char **text, uint32_t *length) {
+  return get_string(r, CBOR_TEXT, (const uint8_t **) text, length);
+}
+
+int cbor_get_bytes(struct cbor_reader *r, const uint8_t **data, uint32_t *length) {
+  return get_string(r, CBOR_BYTES, data, length);
+}
+
+int cbor_get_array(struct cbor_reader *r, uint32_t *count) {
+  struct cbor_item item;
+  int error;
+
+  error = read_type(r, &item, CBOR_ARRAY);
+  if (error == CBOR_OK)
+    *count = item.value.count;
+
+  return error;
+}
+
+int cbor_get_map(struct cbor_reader *r, uint32_t *count) {
+  struct cbor_item item;
+  int error;
+
+  error = read_type(r, &item, CBOR_MAP);
+  if (error == CBOR_OK)
+    *count = item.value.count;
+
+  return error;
+}
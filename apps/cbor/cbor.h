@@ -0,0 +1,141 @@
+//+------------------------------------------------------------------------------------------------+
+//| Streaming CBOR (RFC 8949) encoder and decoder.                                                 |
+//|                                                                                                |
+//| The writer encodes items one at a time straight into the caller's buffer, such as the payload  |
+//| area of an outgoing packet, so messages are never built elsewhere and copied. Optionally, a    |
+//| flush function is called whenever the buffer fills up, and writing goes on from its start: the |
+//| buffer then works as a window onto a stream (a SLIP or UART link, for instance), and messages  |
+//| can be longer than it. Writing past the end of a buffer without flush function sets a sticky   |
+//| error, checked once at the end.                                                                |
+//|                                                                                                |
+//| The reader is pull style: every call decodes the next item of a message. Containers only give  |
+//| their item count (arrays) or pair count (maps), and their contents follow as the next items,   |
+//| so the caller walks messages with its own code and no callbacks. Strings are returned as       |
+//| pointers into the message, with no copies. cbor_skip() steps over whole items, containers      |
+//| included.                                                                                      |
+//|                                                                                                |
+//| Neither side allocates memory or recurses, so stack use is small and fixed. Integers up to 64  |
+//| bits are supported both ways. Floats are written in half precision when no precision is lost,  |
+//| and in single precision otherwise; doubles are read back as single precision floats.           |
+//|                                                                                                |
+//| This module doesn't depend on contiki, so it builds on the host as is.                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef CBOR_H_
+#define CBOR_H_
+
+#include <stdint.h>
+
+//Maximum nesting of indefinite length containers stepped over by cbor_skip().
+#ifdef CBOR_CONF_SKIP_DEPTH
+#define CBOR_SKIP_DEPTH CBOR_CONF_SKIP_DEPTH
+#else
+#define CBOR_SKIP_DEPTH 8
+#endif
+
+//Item types.
+#define CBOR_UINT     0   //Unsigned integer
+#define CBOR_NINT     1   //Negative integer
+#define CBOR_BYTES    2   //Byte string (or chunk of an indefinite one)
+#define CBOR_TEXT     3   //UTF-8 text string (or chunk of an indefinite one)
+#define CBOR_ARRAY    4
+#define CBOR_MAP      5
+#define CBOR_TAG      6
+#define CBOR_SIMPLE   7   //Simple values, including false, true, null and undefined
+#define CBOR_FLOAT    8
+#define CBOR_BREAK    9   //End of an indefinite length item
+
+//Simple values.
+#define CBOR_FALSE      20
+#define CBOR_TRUE       21
+#define CBOR_NULL       22
+#define CBOR_UNDEFINED  23
+
+//Count of indefinite length items.
+#define CBOR_INDEFINITE 0xFFFFFFFF
+
+//Error codes.
+#define CBOR_OK             0
+#define CBOR_ERR_END        -1  //No more data
+#define CBOR_ERR_TRUNCATED  -2  //Item cut short by the end of the data
+#define CBOR_ERR_INVALID    -3  //Malformed item
+#define CBOR_ERR_TYPE       -4  //Item of another type than expected
+#define CBOR_ERR_RANGE      -5  //Value out of the range of the requested type
+#define CBOR_ERR_DEPTH      -6  //Indefinite length items nested too deep to skip
+#define CBOR_ERR_OVERFLOW   -7  //Buffer too short for the encoded data
+
+//Flush function of streaming writers. Takes the full buffer (or the last part of the message, on
+//cbor_writer_end()).
+typedef void (* cbor_flush_t)(const uint8_t *data, uint32_t length, void *ptr);
+
+struct cbor_writer {
+  uint8_t *data;
+  uint32_t size;
+  uint32_t length;          //Bytes in the buffer
+  uint32_t total;           //Bytes written, including the ones flushed
+  cbor_flush_t flush;
+  void *ptr;
+  int8_t error;
+};
+
+struct cbor_reader {
+  const uint8_t *data;
+  uint32_t size;
+  uint32_t pos;
+};
+
+//Decoded item. For strings, data points into the message (and length is CBOR_INDEFINITE at the
+//start of an indefinite length string, whose chunks follow). For containers, count is the number
+//of items (arrays) or pairs (maps), or CBOR_INDEFINITE. Negative integers are kept as the CBOR
+//argument n, for a value of -1 - n.
+struct cbor_item {
+  uint8_t type;
+  union {
+    uint64_t uint;
+    uint64_t tag;
+    uint8_t simple;
+    float real;
+    uint32_t count;
+    struct {
+      const uint8_t *data;
+      uint32_t length;
+    } string;
+  } value;
+};
+
+void cbor_writer_init(struct cbor_writer *w, void *buffer, uint32_t size);
+void cbor_writer_stream(struct cbor_writer *w, void *buffer, uint32_t size, cbor_flush_t flush,
+                        void *ptr);
+int32_t cbor_writer_end(struct cbor_writer *w);
+
+void cbor_put_uint(struct cbor_writer *w, uint32_t value);
+void cbor_put_int(struct cbor_writer *w, int32_t value);
+void cbor_put_uint64(struct cbor_writer *w, uint64_t value);
+void cbor_put_int64(struct cbor_writer *w, int64_t value);
+void cbor_put_bytes(struct cbor_writer *w, const void *data, uint32_t length);
+void cbor_put_text(struct cbor_writer *w, const char *text);
+void cbor_put_text_n(struct cbor_writer *w, const char *text, uint32_t length);
+void cbor_put_array(struct cbor_writer *w, uint32_t count);
+void cbor_put_map(struct cbor_writer *w, uint32_t count);
+void cbor_put_tag(struct cbor_writer *w, uint64_t tag);
+void cbor_put_simple(struct cbor_writer *w, uint8_t value);
+void cbor_put_bool(struct cbor_writer *w, int value);
+void cbor_put_null(struct cbor_writer *w);
+void cbor_put_float(struct cbor_writer *w, float value);
+void cbor_put_break(struct cbor_writer *w);
+
+void cbor_reader_init(struct cbor_reader *r, const void *data, uint32_t size);
+int cbor_read(struct cbor_reader *r, struct cbor_item *item);
+int cbor_skip(struct cbor_reader *r);
+int cbor_get_uint(struct cbor_reader *r, uint32_t *value);
+int cbor_get_int(struct cbor_reader *r, int32_t *value);
+int cbor_get_float(struct cbor_reader *r, float *value);
+int cbor_get_bool(struct cbor_reader *r, int *value);
+int cbor_get_text(struct cbor_reader *r, const char **text, uint32_t *length);
+int cbor_get_bytes(struct cbor_reader *r, const uint8_t **data, uint32_t *length);
+int cbor_get_array(struct cbor_reader *r, uint32_t *count);
+int cbor_get_map(struct cbor_reader *r, uint32_t *count);
+
+#endif //CBOR_H_
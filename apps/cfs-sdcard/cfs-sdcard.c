@@ -0,0 +1,663 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the Contiki file system on the SD card.                                        |
+//|                                                                                                |
+//| The card runs one transfer at a time, owned either by a file (data) or by the metadata queue.  |
+//| step() ends the running transfer once its callback has reported the result, and starts the     |
+//| next one: metadata first, then data of the files in turn. The storage process steps each time  |
+//| the callback polls it, serving the queued requests in between, while the card is free. When    |
+//| someone else holds the card, the driver polls it again once the card is released. The waiting  |
+//| calls queue a request of their own and step until it completes.                                |
+//|                                                                                                |
+//| Completed requests leave the queue right away, so the ones behind them (waiting calls          |
+//| included) don't depend on the event queue. Those whose event couldn't be posted wait in a list |
+//| of their own, posted in order later.                                                           |
+//|                                                                                                |
+//| Rings are indexed by file offset, modulo their size. A writer keeps in its ring the data from  |
+//| the block holding the end of what's on the card (which is written whole again) up to the end   |
+//| of what's been accepted. A reader keeps the data from the block holding the application        |
+//| position up to the end of what's been read ahead.                                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <string.h>
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "cfs-sdcard.h"
+#include "fat.h"
+#include "sdcard.h"
+
+#define RING_SIZE   (CFS_SDCARD_BUFFER_BLOCKS * FAT_BLOCK_SIZE)
+#define CHUNK_SIZE  (CFS_SDCARD_CHUNK_BLOCKS * FAT_BLOCK_SIZE)
+#define BLOCK_MASK  (FAT_BLOCK_SIZE - 1)
+
+//Metadata blocks queued for writing at most.
+#define META_BLOCKS 4
+
+//Status of the running transfer until it ends.
+#define PENDING 1
+
+//Request types.
+#define REQUEST_READ  0
+#define REQUEST_WRITE 1
+#define REQUEST_SYNC  2
+
+//Request states.
+#define QUEUED      0
+#define COMMITTING  1   //Barrier waiting for the metadata to reach the card
+#define COMPLETED   2   //Result ready
+
+struct file {
+  struct fat_file f;
+  char name[13];
+  uint8_t mode;                   //CFS_READ or CFS_WRITE, 0 if free
+  uint8_t failed;                 //A data transfer failed
+  uint8_t flush;                  //Write the last chunk too, even if partial
+  uint32_t position;              //Application offset (the end of the data, for writers)
+  uint32_t card;                  //End of the data on the card (writers) or in the ring (readers)
+  uint32_t ring[RING_SIZE / 4];
+};
+
+static struct fat fs;
+static struct fat_device device;
+static uint8_t mounted;
+static struct file files[CFS_SDCARD_FILES];
+static uint8_t next_file;
+
+//Running transfer: the file it belongs to (none for metadata) and where its data ends.
+static uint8_t running;
+static struct file *owner;
+static uint32_t owner_end;
+static volatile int status;
+
+//Metadata write queue.
+static uint32_t meta_buffer[META_BLOCKS][FAT_BLOCK_SIZE / 4];
+static uint32_t meta_block[META_BLOCKS];
+static uint8_t meta_first, meta_count, meta_failed;
+
+//Request queue, and completed requests waiting for room in the event queue.
+static struct cfs_request *first_request, *last_request;
+static struct cfs_request *first_notice, *last_notice;
+
+process_event_t cfs_async_event;
+
+PROCESS(cfs_sdcard_process, "SD card file system");
+
+//--------------------------------------------------------------------------------------------------
+//Transfers.
+
+//Completion callback of the transfers.
+static void transfer_done(int result, void *ptr) {
+  status = result;
+  process_poll(&cfs_sdcard_process);
+}
+
+//Called by the driver once the card is released.
+static void card_released(int result, void *ptr) {
+  process_poll(&cfs_sdcard_process);
+}
+
+//Starts a transfer. If someone else has the card, it's retried from the storage process once the
+//card is released.
+static void start_transfer(struct file *f, uint32_t end, uint32_t block, void *buffer,
+                           uint16_t count, uint8_t flags) {
+  int result;
+
+  owner = f;
+  owner_end = end;
+  status = PENDING;
+  running = 1;
+
+  result = sdcard_start(block, buffer, count, flags, transfer_done, NULL);
+  if (result == SDCARD_ERR_BUSY) {
+    running = 0;
+    if (sdcard_notify(card_released, NULL) == SDCARD_ERR_BUSY)
+      return;
+  }
+  else if (result != SDCARD_OK)
+    status = result;
+  if (result != SDCARD_OK)
+    process_poll(&cfs_sdcard_process);
+}
+
+//Starts the next data transfer of a file, if it has any. Returns nonzero if the card got busy
+//meanwhile, either with the transfer or with metadata (when the file grew).
+static uint8_t start_data(struct file *f) {
+  uint32_t start, end, block, count, run, erase = device.erase_blocks;
+
+  if (f->mode == CFS_WRITE) {
+    //Whole chunks, or everything when flushing.
+    if (f->card >= f->position)
+      return 0;
+    start = f->card & ~BLOCK_MASK;
+    end = f->flush ? (f->position + BLOCK_MASK) & ~BLOCK_MASK : f->position & ~(CHUNK_SIZE - 1);
+  }
+  else {
+    //As far ahead as the ring allows.
+    if (f->card >= f->f.size)
+      return 0;
+    start = f->card;
+    end = (f->position & ~BLOCK_MASK) + RING_SIZE;
+    if (end > ((f->f.size + BLOCK_MASK) & ~BLOCK_MASK))
+      end = (f->f.size + BLOCK_MASK) & ~BLOCK_MASK;
+  }
+  if (end <= start)
+    return 0;
+
+  count = (end - start) / FAT_BLOCK_SIZE;
+  if (count > (RING_SIZE - start % RING_SIZE) / FAT_BLOCK_SIZE)
+    count = (RING_SIZE - start % RING_SIZE) / FAT_BLOCK_SIZE;
+
+  if (fat_map(&f->f, start, &block, &run) != FAT_OK) {
+    f->failed = 1;
+    return 0;
+  }
+  if (running || meta_count > 0)
+    return 1;
+
+  if (count > run)
+    count = run;
+  if (count > SDCARD_MAX_BLOCKS)
+    count = SDCARD_MAX_BLOCKS;
+  if (f->mode == CFS_WRITE && erase > 0 && count > erase - block % erase)
+    count = erase - block % erase;
+
+  end = start + count * FAT_BLOCK_SIZE;
+  if (f->mode == CFS_WRITE) {
+    if (end > f->position)
+      end = f->position;
+  }
+  else if (end > f->f.size)
+    end = f->f.size;
+
+  start_transfer(f, end, block, (uint8_t *) f->ring + start % RING_SIZE, count,
+                 f->mode == CFS_WRITE ? SDCARD_WRITE : SDCARD_READ);
+  return 1;
+}
+
+//Ends the running transfer if done, and starts the next one if the card is free: a metadata
+//block, or data of the files (in turn) if asked for.
+static void step(uint8_t data) {
+  uint8_t i;
+
+  if (running) {
+    if (status == PENDING)
+      return;
+    running = 0;
+
+    if (owner == NULL) {
+      if (status != SDCARD_OK)
+        meta_failed = 1;
+      meta_first = (meta_first + 1) % META_BLOCKS;
+      meta_count--;
+    }
+    else if (status != SDCARD_OK)
+      owner->failed = 1;
+    else
+      owner->card = owner_end;
+  }
+
+  if (meta_count > 0) {
+    start_transfer(NULL, 0, meta_block[meta_first], meta_buffer[meta_first], 1, SDCARD_WRITE);
+    return;
+  }
+
+  for (i = 0; data && i < CFS_SDCARD_FILES; i++) {
+    if (files[next_file].mode != 0 && !files[next_file].failed && start_data(&files[next_file]))
+      data = 0;
+    next_file = (next_file + 1) % CFS_SDCARD_FILES;
+  }
+}
+
+//Metadata writes of the file system: copied to the queue, to be written in the background.
+//Errors show up at the next barrier.
+static int meta_write(uint32_t block, const void *buffer, uint16_t count) {
+  uint8_t slot;
+  uint16_t i;
+
+  for (i = 0; i < count; i++) {
+    while (meta_count == META_BLOCKS)
+      step(0);
+
+    slot = (meta_first + meta_count) % META_BLOCKS;
+    memcpy(meta_buffer[slot], (const uint8_t *) buffer + i * FAT_BLOCK_SIZE, FAT_BLOCK_SIZE);
+    meta_block[slot] = block + i;
+    meta_count++;
+    step(0);
+  }
+
+  return SDCARD_OK;
+}
+
+//Metadata reads of the file system, once the card is free (so they see what's queued, too).
+static int meta_read(uint32_t block, void *buffer, uint16_t count) {
+  while (running || meta_count > 0)
+    step(0);
+
+  return sdcard_read(block, buffer, count);
+}
+
+//--------------------------------------------------------------------------------------------------
+//Requests.
+
+//Copies data from a writer to its ring, as far as there's room. Returns the bytes copied.
+static unsigned int copy_in(struct file *f, const uint8_t *data, unsigned int length) {
+  uint32_t room = RING_SIZE - (f->position - (f->card & ~BLOCK_MASK)), offset, first;
+
+  if (length > room)
+    length = room;
+  if (length == 0)
+    return 0;
+
+  offset = f->position % RING_SIZE;
+  first = (length < RING_SIZE - offset) ? length : RING_SIZE - offset;
+  memcpy((uint8_t *) f->ring + offset, data, first);
+  memcpy(f->ring, data + first, length - first);
+  f->position += length;
+
+  process_poll(&cfs_sdcard_process);
+  return length;
+}
+
+//Copies data from the ring of a reader, as far as it's been read ahead. Returns the bytes copied.
+static unsigned int copy_out(struct file *f, uint8_t *data, unsigned int length) {
+  uint32_t ready = (f->card > f->position) ? f->card - f->position : 0, offset, first;
+
+  if (length > ready)
+    length = ready;
+  if (length == 0)
+    return 0;
+
+  offset = f->position % RING_SIZE;
+  first = (length < RING_SIZE - offset) ? length : RING_SIZE - offset;
+  memcpy(data, (uint8_t *) f->ring + offset, first);
+  memcpy(data + first, f->ring, length - first);
+  f->position += length;
+
+  process_poll(&cfs_sdcard_process);
+  return length;
+}
+
+//Makes progress on a request. Returns nonzero once it's complete.
+static uint8_t progress(struct cfs_request *r) {
+  struct file *f = &files[r->fd];
+
+  switch (r->type) {
+  case REQUEST_READ:
+    r->done += copy_out(f, r->buffer + r->done, r->length - r->done);
+    if (r->done < r->length && f->position < f->f.size && !(f->failed && f->card <= f->position))
+      return 0;
+
+    r->result = (r->done == 0 && f->failed) ? -1 : (int) r->done;
+    return 1;
+
+  case REQUEST_WRITE:
+    if (!f->failed)
+      r->done += copy_in(f, r->buffer + r->done, r->length - r->done);
+    if (r->done < r->length && !f->failed)
+      return 0;
+
+    r->result = f->failed ? -1 : (int) r->done;
+    return 1;
+
+  default:
+    if (f->mode == CFS_READ) {
+      r->result = 0;
+      return 1;
+    }
+
+    //Get the data on the card, then the size in the directory, with the card free.
+    if (r->state == QUEUED) {
+      f->flush = 1;
+      if ((!f->failed && f->card < f->position) || running || meta_count > 0)
+        return 0;
+
+      f->flush = 0;
+      if (!f->failed && (fat_set_size(&f->f, f->position) != FAT_OK || fat_sync(&f->f) != FAT_OK))
+        f->failed = 1;
+      r->state = COMMITTING;
+    }
+
+    if (meta_count > 0)
+      return 0;
+
+    r->result = (f->failed || meta_failed) ? -1 : 0;
+    meta_failed = 0;
+    return 1;
+  }
+}
+
+//Posts the events of the completed requests, in order, as far as the event queue has room.
+static void notify() {
+  struct cfs_request *r;
+
+  while ((r = first_notice) != NULL) {
+    if (process_post(r->process, cfs_async_event, r) != PROCESS_ERR_OK) {
+      process_poll(&cfs_sdcard_process);
+      return;
+    }
+
+    first_notice = r->next;
+    if (first_notice == NULL)
+      last_notice = NULL;
+  }
+}
+
+//Serves the queued requests in order, as far as the rings allow. Completed requests leave the
+//queue, and those of processes go to the notification list.
+static void serve() {
+  struct cfs_request *r;
+
+  while ((r = first_request) != NULL) {
+    if (!progress(r))
+      break;
+
+    first_request = r->next;
+    if (first_request == NULL)
+      last_request = NULL;
+
+    if (r->process != NULL) {
+      r->next = NULL;
+      if (last_notice != NULL)
+        last_notice->next = r;
+      else
+        first_notice = r;
+      last_notice = r;
+    }
+    r->state = COMPLETED;
+  }
+
+  notify();
+}
+
+//Runs the storage: ends the running transfer, serves the requests while the card is free and
+//starts the next transfer.
+static void service() {
+  step(0);
+  serve();
+  step(1);
+}
+
+//Queues a request. Requests of no process are the ones of the waiting calls.
+static int queue(struct cfs_request *r, struct process *p, int fd, uint8_t type, const void *buffer,
+                 unsigned int length) {
+  if (fd < 0 || fd >= CFS_SDCARD_FILES || files[fd].mode == 0 ||
+      (type == REQUEST_READ && files[fd].mode != CFS_READ) ||
+      (type == REQUEST_WRITE && files[fd].mode != CFS_WRITE))
+    return -1;
+
+  r->next = NULL;
+  r->process = p;
+  r->buffer = (uint8_t *) buffer;
+  r->length = length;
+  r->done = 0;
+  r->fd = fd;
+  r->result = 0;
+  r->type = type;
+  r->state = QUEUED;
+
+  if (last_request != NULL)
+    last_request->next = r;
+  else
+    first_request = r;
+  last_request = r;
+
+  process_poll(&cfs_sdcard_process);
+  return 0;
+}
+
+//Runs a request of a waiting call until it completes.
+static int run_request(int fd, uint8_t type, const void *buffer, unsigned int length) {
+  struct cfs_request r;
+
+  if (queue(&r, NULL, fd, type, buffer, length) < 0)
+    return -1;
+
+  while (r.state != COMPLETED)
+    service();
+
+  return r.result;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Files.
+
+//Mounts the card on first use and starts the storage process.
+static int mount() {
+  if (mounted)
+    return 0;
+
+  if (sdcard_blocks() == 0 && sdcard_init() != SDCARD_OK)
+    return -1;
+
+  device.read = meta_read;
+  device.write = meta_write;
+  device.blocks = sdcard_blocks();
+  device.max_blocks = SDCARD_MAX_BLOCKS;
+  device.erase_blocks = sdcard_erase_blocks();
+  if (fat_mount(&fs, &device) != FAT_OK)
+    return -1;
+
+  cfs_async_event = process_alloc_event();
+  process_start(&cfs_sdcard_process, NULL);
+  mounted = 1;
+  return 0;
+}
+
+//Compares names regardless of case.
+static uint8_t same_name(const char *a, const char *b) {
+  for (; *a != '\0' && *b != '\0'; a++, b++) {
+    if ((*a >= 'a' && *a <= 'z' ? *a - 32 : *a) != (*b >= 'a' && *b <= 'z' ? *b - 32 : *b))
+      return 0;
+  }
+
+  return *a == *b;
+}
+
+//Looks for an open file by name.
+static struct file *find_open(const char *name) {
+  uint8_t i;
+
+  for (i = 0; i < CFS_SDCARD_FILES; i++) {
+    if (files[i].mode != 0 && same_name(files[i].name, name))
+      return &files[i];
+  }
+
+  return NULL;
+}
+
+//Opens a file, either for reading or for writing (replacing it, unless appending).
+int cfs_open(const char *name, int flags) {
+  uint8_t writing = (flags & (CFS_WRITE | CFS_APPEND)) ? 1 : 0;
+  struct file *f = NULL, *other;
+  uint8_t i;
+  int error;
+
+  if (name[0] == '/')
+    name++;
+  if (strlen(name) >= sizeof(f->name) || (writing && (flags & CFS_READ)) ||
+      (!writing && !(flags & CFS_READ)) || mount() != 0)
+    return -1;
+
+  //A file being written can't be opened again, nor can a file being read be written.
+  other = find_open(name);
+  if (other != NULL && (writing || other->mode == CFS_WRITE))
+    return -1;
+
+  for (i = 0; i < CFS_SDCARD_FILES && f == NULL; i++) {
+    if (files[i].mode == 0)
+      f = &files[i];
+  }
+  if (f == NULL)
+    return -1;
+
+  if (!writing)
+    error = fat_open(&fs, &f->f, name);
+  else {
+    error = FAT_ERR_NOT_FOUND;
+    if (flags & CFS_APPEND)
+      error = fat_append(&fs, &f->f, name);
+    else
+      fat_remove(&fs, name);
+
+    //Start files without their reservation if there's no run of clusters that long.
+    if (error == FAT_ERR_NOT_FOUND) {
+      error = fat_create(&fs, &f->f, name, CFS_SDCARD_RESERVE);
+      if (error == FAT_ERR_FULL)
+        error = fat_create(&fs, &f->f, name, 0);
+    }
+  }
+  if (error != FAT_OK)
+    return -1;
+
+  //Writers append to the partial last block, which the file system read back.
+  if (writing) {
+    memcpy((uint8_t *) f->ring + (f->f.size & ~BLOCK_MASK) % RING_SIZE, f->f.buffer,
+           f->f.size & BLOCK_MASK);
+    fat_set_size(&f->f, f->f.size);
+    f->position = f->f.size;
+    f->card = f->f.size;
+  }
+  else {
+    f->position = 0;
+    f->card = 0;
+  }
+
+  strcpy(f->name, name);
+  f->mode = writing ? CFS_WRITE : CFS_READ;
+  f->failed = 0;
+  f->flush = 0;
+
+  process_poll(&cfs_sdcard_process);
+  return f - files;
+}
+
+//Closes a file, after completing its requests. Files being written are synced, and their clusters
+//past the end freed.
+void cfs_close(int fd) {
+  struct file *f = &files[fd];
+
+  if (fd < 0 || fd >= CFS_SDCARD_FILES || f->mode == 0)
+    return;
+
+  cfs_sync(fd);
+  if (f->mode == CFS_WRITE && !f->failed)
+    fat_close(&f->f);
+
+  //Wait for the read ahead to end, and for the metadata to reach the card.
+  while (running && owner == f)
+    step(0);
+  while (meta_count > 0)
+    step(0);
+
+  f->mode = 0;
+}
+
+//Reads from a file, waiting for the data to be read ahead. Returns the bytes read (fewer at the
+//end of the file), or -1 on error.
+int cfs_read(int fd, void *buffer, unsigned int length) {
+  return run_request(fd, REQUEST_READ, buffer, length);
+}
+
+//Writes to a file, waiting for room in the ring if full. Returns the bytes written, or -1 on
+//error.
+int cfs_write(int fd, const void *buffer, unsigned int length) {
+  return run_request(fd, REQUEST_WRITE, buffer, length);
+}
+
+//Moves the position of a file being read. Files being written stay at their end (the data
+//accepted so far). Returns the new position, or -1 if out of the file.
+cfs_offset_t cfs_seek(int fd, cfs_offset_t offset, int whence) {
+  struct file *f = &files[fd];
+  int32_t target;
+
+  if (fd < 0 || fd >= CFS_SDCARD_FILES || f->mode == 0)
+    return -1;
+
+  //Complete the reads queued before.
+  if (f->mode == CFS_READ)
+    cfs_sync(fd);
+
+  if (whence == CFS_SEEK_SET)
+    target = offset;
+  else if (whence == CFS_SEEK_CUR)
+    target = (int32_t) f->position + offset;
+  else
+    target = (int32_t) (f->mode == CFS_WRITE ? f->position : f->f.size) + offset;
+
+  if (f->mode == CFS_WRITE)
+    return (target == (int32_t) f->position) ? target : -1;
+  if (target < 0 || (uint32_t) target > f->f.size)
+    return -1;
+
+  //Start reading ahead from the target if it's not in the ring (keeping what's there otherwise,
+  //from the block of the current position).
+  if ((uint32_t) target < (f->position & ~BLOCK_MASK) || (uint32_t) target > f->card) {
+    while (running && owner == f)
+      step(0);
+    f->card = target & ~BLOCK_MASK;
+  }
+  f->position = target;
+
+  process_poll(&cfs_sdcard_process);
+  return target;
+}
+
+//Deletes a file, unless open.
+int cfs_remove(const char *name) {
+  if (name[0] == '/')
+    name++;
+  if (mount() != 0 || find_open(name) != NULL)
+    return -1;
+
+  return (fat_remove(&fs, name) == FAT_OK) ? 0 : -1;
+}
+
+//Directories can't be listed.
+int cfs_opendir(struct cfs_dir *dirp, const char *name) {
+  return -1;
+}
+
+int cfs_readdir(struct cfs_dir *dirp, struct cfs_dirent *dirent) {
+  return -1;
+}
+
+void cfs_closedir(struct cfs_dir *dirp) {
+}
+
+//Waits until the data written to a file so far is on the card, along with its size. Returns 0 on
+//success, or -1 if any transfer failed.
+int cfs_sync(int fd) {
+  return run_request(fd, REQUEST_SYNC, NULL, 0);
+}
+
+//Queues a read of a file. Returns 0 if queued (the result comes with the event), or -1 if the
+//file isn't open for reading.
+int cfs_async_read(struct cfs_request *r, int fd, void *buffer, unsigned int length) {
+  return queue(r, PROCESS_CURRENT(), fd, REQUEST_READ, buffer, length);
+}
+
+//Queues a write to a file. Returns 0 if queued (the result comes with the event), or -1 if the
+//file isn't open for writing.
+int cfs_async_write(struct cfs_request *r, int fd, const void *buffer, unsigned int length) {
+  return queue(r, PROCESS_CURRENT(), fd, REQUEST_WRITE, buffer, length);
+}
+
+//Queues a barrier on a file, completing once the data written before it is on the card, along
+//with its size. Returns 0 if queued, or -1 if the file isn't open.
+int cfs_async_sync(struct cfs_request *r, int fd) {
+  return queue(r, PROCESS_CURRENT(), fd, REQUEST_SYNC, NULL, 0);
+}
+
+//Storage process: runs the card each time a transfer ends or there's something new to do.
+PROCESS_THREAD(cfs_sdcard_process, ev, data) {
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    service();
+  }
+
+  PROCESS_END();
+}
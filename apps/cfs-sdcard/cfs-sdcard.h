@@ -0,0 +1,100 @@
+//+------------------------------------------------------------------------------------------------+
+//| Contiki file system on the SD card, with asynchronous requests.                                |
+//|                                                                                                |
+//| Implements the CFS API (cfs/cfs.h) over the FAT32 volume of the SD card (see apps/fat), so     |
+//| files are read on a PC afterwards. Data moves between the card and a ring buffer per open file |
+//| in background transfers, started from a storage process and ended by the SDHC interrupt, so    |
+//| the busy periods of the card (hundreds of milliseconds at times, while it erases) don't block  |
+//| the scheduler:                                                                                 |
+//| - Write-behind: cfs_write() copies data to the ring and returns. The storage process writes    |
+//|   whole chunks of CFS_SDCARD_CONF_CHUNK_BLOCKS blocks (or more at once, when they've piled up) |
+//|   as they fill.                                                                                |
+//| - Read-ahead: files open for reading are read sequentially ahead of the application, as far as |
+//|   the ring allows. Seeking out of what's in the ring starts over from there.                   |
+//| - cfs_sync() is a barrier: the data written before it reaches the card, along with the size of |
+//|   the file in the directory.                                                                   |
+//|                                                                                                |
+//| The CFS calls only wait for the card when the ring is full (writing) or empty (reading), and   |
+//| for cfs_sync() and cfs_close(). The cfs_async_*() functions queue requests instead, completed  |
+//| in order by the storage process, which posts a cfs_async_event to the requester (with the      |
+//| request as data) once done. Writes complete when their data is in the ring, reads when it's    |
+//| been copied to the caller's buffer and barriers when everything before them is on the card.    |
+//| Mixing waiting calls and queued requests on the same file is fine, since the waiting calls     |
+//| complete the queued requests first. Events that don't fit in the event queue are posted later, |
+//| in order, without holding back the requests behind them.                                       |
+//|                                                                                                |
+//| FAT sectors and directory entries are written back in the background as well, through a small  |
+//| queue of block copies. Metadata is read with waiting transfers (single blocks, with no busy    |
+//| period), when opening and closing files and when files grow past their reservation. Files      |
+//| opened for writing are created with CFS_SDCARD_CONF_RESERVE bytes pre-allocated (see           |
+//| fat_create()), so writes within that size read no metadata; the clusters left over are freed   |
+//| on close.                                                                                      |
+//|                                                                                                |
+//| Limitations: files live in the root directory, with 8.3 names (a leading '/' is skipped).      |
+//| Files are opened either for reading or for writing, not both. Writing without CFS_APPEND       |
+//| replaces the file. Files being written only seek to their end. Directories can't be listed.    |
+//|                                                                                                |
+//| The card and the volume are mounted on the first call. The FAT buffers of each file go unused, |
+//| so FAT_CONF_BUFFER_BLOCKS can be lowered to 1 if nothing else uses the file system.            |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef CFS_SDCARD_H_
+#define CFS_SDCARD_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+
+//Files open at once.
+#ifdef CFS_SDCARD_CONF_FILES
+#define CFS_SDCARD_FILES CFS_SDCARD_CONF_FILES
+#else
+#define CFS_SDCARD_FILES 2
+#endif
+
+//Size of the ring buffer of each file, in blocks (a multiple of the chunk size).
+#ifdef CFS_SDCARD_CONF_BUFFER_BLOCKS
+#define CFS_SDCARD_BUFFER_BLOCKS CFS_SDCARD_CONF_BUFFER_BLOCKS
+#else
+#define CFS_SDCARD_BUFFER_BLOCKS 32
+#endif
+
+//Least data written at once, in blocks, unless syncing.
+#ifdef CFS_SDCARD_CONF_CHUNK_BLOCKS
+#define CFS_SDCARD_CHUNK_BLOCKS CFS_SDCARD_CONF_CHUNK_BLOCKS
+#else
+#define CFS_SDCARD_CHUNK_BLOCKS 8
+#endif
+
+//Bytes pre-allocated for files opened for writing.
+#ifdef CFS_SDCARD_CONF_RESERVE
+#define CFS_SDCARD_RESERVE CFS_SDCARD_CONF_RESERVE
+#else
+#define CFS_SDCARD_RESERVE (1024ul * 1024)
+#endif
+
+//Request, kept by the caller until completed. Only the result is meant to be read.
+struct cfs_request {
+  struct cfs_request *next;
+  struct process *process;
+  uint8_t *buffer;
+  unsigned int length;
+  unsigned int done;
+  int fd;
+  int result;                     //Bytes read or written (fewer at the end of file), 0 for
+  uint8_t type;                   //barriers, or -1 on error
+  uint8_t state;
+};
+
+//Event posted to the requester when a request completes.
+extern process_event_t cfs_async_event;
+
+int cfs_sync(int fd);
+int cfs_async_read(struct cfs_request *r, int fd, void *buffer, unsigned int length);
+int cfs_async_write(struct cfs_request *r, int fd, const void *buffer, unsigned int length);
+int cfs_async_sync(struct cfs_request *r, int fd);
+
+#endif //CFS_SDCARD_H_
@@ -0,0 +1,397 @@
+//+------------------------------------------------------------------------------------------------+
+//| SPI TFT display driver (ILI9341 and compatible controllers) with partial updates.              |
+//|                                                                                                |
+//| Every dirty rectangle is sent as a window: column and page address commands followed by a      |
+//| memory write of its pixels. In framebuffer mode all windows are queued at once, and the pixel  |
+//| transactions point into the framebuffer (one line of the rectangle per transaction line). In   |
+//| line mode the display process sends one window at a time, rendering and queueing its lines one |
+//| by one and waiting only when both line buffers are in flight.                                  |
+//|                                                                                                |
+//| Transaction completion callbacks run in interrupt context, so they only poll the display       |
+//| process, which does the bookkeeping.                                                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "display.h"
+#include "spi-queue.h"
+
+//Maximum amount of dirty rectangles. More are merged into the existing ones.
+#ifdef DISPLAY_CONF_DIRTY_RECTS
+#define DIRTY_RECTS DISPLAY_CONF_DIRTY_RECTS
+#else
+#define DIRTY_RECTS 8
+#endif
+
+//Memory access control value (orientation and color order). The default selects landscape
+//orientation with BGR panels.
+#ifdef DISPLAY_CONF_MADCTL
+#define MADCTL DISPLAY_CONF_MADCTL
+#else
+#define MADCTL 0x28
+#endif
+
+//Controller commands.
+#define CMD_SWRESET 0x01
+#define CMD_SLPOUT  0x11
+#define CMD_DISPON  0x29
+#define CMD_CASET   0x2A
+#define CMD_PASET   0x2B
+#define CMD_RAMWR   0x2C
+#define CMD_MADCTL  0x36
+#define CMD_COLMOD  0x3A
+
+//Rectangle, with exclusive end coordinates.
+struct rect {
+  int16_t x0, y0, x1, y1;
+};
+
+//Initialization command, with its arguments and the time to wait after it (in milliseconds).
+struct command {
+  uint8_t cmd;
+  uint8_t length;
+  uint8_t args[2];
+  uint8_t delay;
+};
+
+static const struct command init_sequence[] = {
+  { CMD_SWRESET, 0, { 0 },      150 },
+  { CMD_SLPOUT,  0, { 0 },      150 },
+  { CMD_COLMOD,  1, { 0x55 },   0 },    //16 bits per pixel
+  { CMD_MADCTL,  1, { MADCTL }, 0 },
+  { CMD_DISPON,  0, { 0 },      0 },
+};
+
+//Transactions of a window.
+struct window {
+  struct spi_transaction caset, caset_args, paset, paset_args, ramwr, pixels;
+  uint8_t caset_data[4];
+  uint8_t paset_data[4];
+};
+
+static const uint8_t cmd_caset = CMD_CASET;
+static const uint8_t cmd_paset = CMD_PASET;
+static const uint8_t cmd_ramwr = CMD_RAMWR;
+
+//Dirty rectangles, and the ones being flushed.
+static struct rect dirty[DIRTY_RECTS];
+static uint8_t dirty_count = 0;
+static struct rect flushing[DIRTY_RECTS];
+static uint8_t flushing_count;
+
+//Driver state.
+static volatile uint8_t busy;
+static struct process *requester;
+
+#if DISPLAY_FRAMEBUFFER
+#ifdef DISPLAY_CONF_FRAMEBUFFER_SECTION
+static uint16_t framebuffer[DISPLAY_WIDTH * DISPLAY_HEIGHT]
+  __attribute__((section(DISPLAY_CONF_FRAMEBUFFER_SECTION), aligned(4)));
+#else
+static uint16_t framebuffer[DISPLAY_WIDTH * DISPLAY_HEIGHT] __attribute__((aligned(4)));
+#endif
+static struct window windows[DIRTY_RECTS];
+#else
+static struct window window;
+static display_render_t render_fn;
+static uint16_t line_buffers[2][DISPLAY_WIDTH];
+static struct spi_transaction line_tx[2];
+static volatile uint8_t line_busy[2];
+#endif
+
+process_event_t display_event_flushed;
+
+PROCESS(display_process, "Display");
+
+//Transaction callback. Just hands over to the process.
+static void poll_process(struct spi_transaction *t) {
+  process_poll(&display_process);
+}
+
+#if !DISPLAY_FRAMEBUFFER
+//Line transaction callback. Frees the line buffer.
+static void line_done(struct spi_transaction *t) {
+  line_busy[t == &line_tx[1]] = 0;
+  process_poll(&display_process);
+}
+#endif
+
+//Sets up a single line, single frame size transaction.
+static void setup(struct spi_transaction *t, const void *data, uint16_t frames, uint8_t flags) {
+  t->data = data;
+  t->frames = frames;
+  t->lines = 1;
+  t->stride = 0;
+  t->flags = flags;
+  t->callback = NULL;
+}
+
+//Queues the commands that open a window over a rectangle, and prepares its pixel transaction
+//(which is left for the caller to complete and submit).
+static void open_window(struct window *w, const struct rect *r) {
+  w->caset_data[0] = r->x0 >> 8;
+  w->caset_data[1] = r->x0;
+  w->caset_data[2] = (r->x1 - 1) >> 8;
+  w->caset_data[3] = r->x1 - 1;
+  w->paset_data[0] = r->y0 >> 8;
+  w->paset_data[1] = r->y0;
+  w->paset_data[2] = (r->y1 - 1) >> 8;
+  w->paset_data[3] = r->y1 - 1;
+
+  setup(&w->caset, &cmd_caset, 1, SPI_QUEUE_8BIT | SPI_QUEUE_DC_LOW);
+  setup(&w->caset_args, w->caset_data, 4, SPI_QUEUE_8BIT | SPI_QUEUE_DC_HIGH);
+  setup(&w->paset, &cmd_paset, 1, SPI_QUEUE_8BIT | SPI_QUEUE_DC_LOW);
+  setup(&w->paset_args, w->paset_data, 4, SPI_QUEUE_8BIT | SPI_QUEUE_DC_HIGH);
+  setup(&w->ramwr, &cmd_ramwr, 1, SPI_QUEUE_8BIT | SPI_QUEUE_DC_LOW);
+  setup(&w->pixels, NULL, r->x1 - r->x0, SPI_QUEUE_16BIT | SPI_QUEUE_DC_HIGH);
+
+  spi_queue_submit(&w->caset);
+  spi_queue_submit(&w->caset_args);
+  spi_queue_submit(&w->paset);
+  spi_queue_submit(&w->paset_args);
+  spi_queue_submit(&w->ramwr);
+}
+
+//Returns whether two rectangles overlap or touch.
+static int touching(const struct rect *a, const struct rect *b) {
+  return a->x0 <= b->x1 && b->x0 <= a->x1 && a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+//Grows a rectangle to include another one.
+static void merge(struct rect *a, const struct rect *b) {
+  if (b->x0 < a->x0) a->x0 = b->x0;
+  if (b->y0 < a->y0) a->y0 = b->y0;
+  if (b->x1 > a->x1) a->x1 = b->x1;
+  if (b->y1 > a->y1) a->y1 = b->y1;
+}
+
+//Returns the area a rectangle would have after merging another one into it.
+static int32_t merged_area(const struct rect *a, const struct rect *b) {
+  struct rect m = *a;
+
+  merge(&m, b);
+  return (int32_t) (m.x1 - m.x0) * (m.y1 - m.y0);
+}
+
+void display_init(display_render_t render) {
+#if !DISPLAY_FRAMEBUFFER
+  render_fn = render;
+  line_busy[0] = 0;
+  line_busy[1] = 0;
+#endif
+
+  busy = 1;
+  requester = PROCESS_CURRENT();
+  display_event_flushed = process_alloc_event();
+
+  spi_queue_init();
+  process_start(&display_process, NULL);
+
+  //The whole screen starts dirty.
+  display_invalidate(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+}
+
+//Marks an area as dirty. Overlapping or touching rectangles are merged, and if there's no room
+//for a new one, it's merged into the rectangle that grows the least.
+void display_invalidate(int16_t x, int16_t y, int16_t width, int16_t height) {
+  struct rect r = { x, y, x + width, y + height };
+  uint8_t i, best;
+  int32_t area, best_area;
+
+  //Clip to the screen.
+  if (r.x0 < 0) r.x0 = 0;
+  if (r.y0 < 0) r.y0 = 0;
+  if (r.x1 > DISPLAY_WIDTH) r.x1 = DISPLAY_WIDTH;
+  if (r.y1 > DISPLAY_HEIGHT) r.y1 = DISPLAY_HEIGHT;
+  if (r.x0 >= r.x1 || r.y0 >= r.y1)
+    return;
+
+  //Absorb every touching rectangle into the new one, then add it.
+  i = 0;
+  while (i < dirty_count) {
+    if (touching(&dirty[i], &r)) {
+      merge(&r, &dirty[i]);
+      dirty[i] = dirty[--dirty_count];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+
+  if (dirty_count < DIRTY_RECTS) {
+    dirty[dirty_count++] = r;
+    return;
+  }
+
+  best = 0;
+  best_area = merged_area(&dirty[0], &r);
+  for (i = 1; i < dirty_count; i++) {
+    area = merged_area(&dirty[i], &r);
+    if (area < best_area) {
+      best = i;
+      best_area = area;
+    }
+  }
+  merge(&dirty[best], &r);
+}
+
+//Starts sending the dirty areas to the display. Returns -1 if a flush (or the initialization) is
+//still in progress.
+int display_flush() {
+#if DISPLAY_FRAMEBUFFER
+  struct rect *r;
+  struct window *w;
+#endif
+  uint8_t i;
+
+  if (busy)
+    return -1;
+
+  //Take the current dirty set. Areas drawn from now on go to a new one.
+  for (i = 0; i < dirty_count; i++)
+    flushing[i] = dirty[i];
+  flushing_count = dirty_count;
+  dirty_count = 0;
+
+  requester = PROCESS_CURRENT();
+  if (flushing_count == 0) {
+    process_post(requester, display_event_flushed, NULL);
+    return 0;
+  }
+  busy = 1;
+
+#if DISPLAY_FRAMEBUFFER
+  //Queue every window, with its pixels read straight from the framebuffer.
+  for (i = 0; i < flushing_count; i++) {
+    r = &flushing[i];
+    w = &windows[i];
+    open_window(w, r);
+    w->pixels.data = &framebuffer[r->y0 * DISPLAY_WIDTH + r->x0];
+    w->pixels.lines = r->y1 - r->y0;
+    w->pixels.stride = DISPLAY_WIDTH * 2;
+    w->pixels.callback = (i == flushing_count - 1) ? poll_process : NULL;
+    spi_queue_submit(&w->pixels);
+  }
+#else
+  //The display process renders the lines.
+  process_poll(&display_process);
+#endif
+
+  return 0;
+}
+
+int display_busy() {
+  return busy;
+}
+
+#if DISPLAY_FRAMEBUFFER
+uint16_t *display_framebuffer() {
+  return framebuffer;
+}
+
+void display_set_pixel(int16_t x, int16_t y, uint16_t color) {
+  if (x < 0 || y < 0 || x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT)
+    return;
+
+  framebuffer[y * DISPLAY_WIDTH + x] = color;
+  display_invalidate(x, y, 1, 1);
+}
+
+void display_fill_rect(int16_t x, int16_t y, int16_t width, int16_t height, uint16_t color) {
+  int16_t x0 = x, y0 = y, x1 = x + width, y1 = y + height;
+  uint16_t *p;
+  int16_t i, j;
+
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > DISPLAY_WIDTH) x1 = DISPLAY_WIDTH;
+  if (y1 > DISPLAY_HEIGHT) y1 = DISPLAY_HEIGHT;
+
+  for (j = y0; j < y1; j++) {
+    p = &framebuffer[j * DISPLAY_WIDTH + x0];
+    for (i = x0; i < x1; i++)
+      *p++ = color;
+  }
+
+  display_invalidate(x, y, width, height);
+}
+#endif
+
+PROCESS_THREAD(display_process, ev, data) {
+  static struct spi_transaction cmd_tx, args_tx;
+  static uint8_t i;
+  static struct etimer et;
+#if !DISPLAY_FRAMEBUFFER
+  static struct rect *r;
+  static int16_t y;
+  static uint8_t buffer;
+#endif
+
+  PROCESS_BEGIN();
+
+  //Send the initialization sequence, one command at a time.
+  for (i = 0; i < sizeof(init_sequence) / sizeof(init_sequence[0]); i++) {
+    setup(&cmd_tx, &init_sequence[i].cmd, 1, SPI_QUEUE_8BIT | SPI_QUEUE_DC_LOW);
+    if (init_sequence[i].length > 0) {
+      setup(&args_tx, init_sequence[i].args, init_sequence[i].length,
+            SPI_QUEUE_8BIT | SPI_QUEUE_DC_HIGH);
+      args_tx.callback = poll_process;
+      spi_queue_submit(&cmd_tx);
+      spi_queue_submit(&args_tx);
+    } else {
+      cmd_tx.callback = poll_process;
+      spi_queue_submit(&cmd_tx);
+    }
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    if (init_sequence[i].delay > 0) {
+      etimer_set(&et, (init_sequence[i].delay * CLOCK_SECOND + 999) / 1000);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    }
+  }
+
+  busy = 0;
+  if (requester != NULL)
+    process_post(requester, display_event_flushed, NULL);
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL && busy);
+
+#if !DISPLAY_FRAMEBUFFER
+    //Render and queue the lines of every window, alternating the line buffers.
+    for (i = 0; i < flushing_count; i++) {
+      r = &flushing[i];
+
+      //The window is reused, so the previous one must be fully sent.
+      if (line_busy[0] || line_busy[1])
+        PROCESS_WAIT_EVENT_UNTIL(!line_busy[0] && !line_busy[1]);
+      open_window(&window, r);
+
+      for (y = r->y0; y < r->y1; y++) {
+        buffer = y & 1;
+        if (line_busy[buffer])
+          PROCESS_WAIT_EVENT_UNTIL(!line_busy[buffer]);
+
+        render_fn(y, r->x0, r->x1 - r->x0, line_buffers[buffer]);
+        setup(&line_tx[buffer], line_buffers[buffer], r->x1 - r->x0,
+              SPI_QUEUE_16BIT | SPI_QUEUE_DC_HIGH);
+        line_tx[buffer].callback = line_done;
+        line_busy[buffer] = 1;
+        spi_queue_submit(&line_tx[buffer]);
+      }
+    }
+
+    //Wait for the last lines to be sent.
+    if (line_busy[0] || line_busy[1])
+      PROCESS_WAIT_EVENT_UNTIL(!line_busy[0] && !line_busy[1]);
+#endif
+
+    busy = 0;
+    if (requester != NULL)
+      process_post(requester, display_event_flushed, NULL);
+  }
+
+  PROCESS_END();
+}
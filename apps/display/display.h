@@ -0,0 +1,66 @@
+//+------------------------------------------------------------------------------------------------+
+//| SPI TFT display driver (ILI9341 and compatible controllers) with partial updates.              |
+//|                                                                                                |
+//| Drawing marks the changed areas as dirty rectangles (overlapping ones are merged), and         |
+//| display_flush() sends only those to the display, through the DMA driven SPI transaction queue  |
+//| of the CPU. Flushing returns right away, so the application keeps computing while the display  |
+//| is refreshed; display_event_flushed is posted to the flushing process once done.               |
+//|                                                                                                |
+//| Two modes of operation are available, depending on the memory of the platform:                 |
+//| - Framebuffer mode (DISPLAY_CONF_FRAMEBUFFER set to 1): the whole screen is kept in RAM, in a  |
+//|   section given by DISPLAY_CONF_FRAMEBUFFER_SECTION if defined, and dirty rectangles are sent  |
+//|   straight from it. Areas drawn into while being flushed stay dirty for the next flush.        |
+//| - Line mode (the default): there's no framebuffer. The dirty rectangles are produced line by   |
+//|   line by a render function of the application, into two line buffers used alternately, so     |
+//|   the next line is rendered while the previous one is being sent.                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Screen size, in landscape orientation.
+#ifdef DISPLAY_CONF_WIDTH
+#define DISPLAY_WIDTH DISPLAY_CONF_WIDTH
+#else
+#define DISPLAY_WIDTH 320
+#endif
+
+#ifdef DISPLAY_CONF_HEIGHT
+#define DISPLAY_HEIGHT DISPLAY_CONF_HEIGHT
+#else
+#define DISPLAY_HEIGHT 240
+#endif
+
+#ifdef DISPLAY_CONF_FRAMEBUFFER
+#define DISPLAY_FRAMEBUFFER DISPLAY_CONF_FRAMEBUFFER
+#else
+#define DISPLAY_FRAMEBUFFER 0
+#endif
+
+//Builds an RGB565 color.
+#define DISPLAY_RGB(r, g, b) ((uint16_t) ((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3)))
+
+//Render function type (line mode). Fills the pixels of line y, from column x on.
+typedef void (* display_render_t)(uint16_t y, uint16_t x, uint16_t width, uint16_t *pixels);
+
+//Event posted once the display becomes idle: after initialization, and after every flush.
+extern process_event_t display_event_flushed;
+
+void display_init(display_render_t render);
+void display_invalidate(int16_t x, int16_t y, int16_t width, int16_t height);
+int display_flush();
+int display_busy();
+
+#if DISPLAY_FRAMEBUFFER
+uint16_t *display_framebuffer();
+void display_set_pixel(int16_t x, int16_t y, uint16_t color);
+void display_fill_rect(int16_t x, int16_t y, int16_t width, int16_t height, uint16_t color);
+#endif
+
+#endif //DISPLAY_H_
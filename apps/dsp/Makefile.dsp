@@ -0,0 +1,7 @@
+#+-------------------------------------------------------------------------------------------------+
+#| DSP kernel library makefile.                                                                    |
+#|                                                                                                 |
+#| Author: Joksan Alvarado.                                                                        |
+#+-------------------------------------------------------------------------------------------------+
+
+dsp_src = dsp-fir.c dsp-biquad.c dsp-fft.c dsp-stats.c dsp-ref.c
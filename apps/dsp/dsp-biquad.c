@@ -0,0 +1,147 @@
+//+------------------------------------------------------------------------------------------------+
+//| Biquad cascade filter kernels for the DSP library.                                             |
+//|                                                                                                |
+//| The floating point kernel uses the transposed direct form II structure, which needs only two   |
+//| state variables per stage. Fixed point kernels use the direct form I structure instead, which  |
+//| has a single accumulation point and so doesn't suffer from intermediate overflow.              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <string.h>
+
+#include "dsp.h"
+
+#if DSP_ARCH == DSP_ARCH_SIMD
+#include "dsp-simd.h"
+#endif
+
+void dsp_biquad_init(struct dsp_biquad *bq, const dsp_sample_t *coeffs, dsp_sample_t *state,
+                     uint8_t stages, uint8_t post_shift) {
+  bq->coeffs = coeffs;
+  bq->state = state;
+  bq->stages = stages;
+  bq->post_shift = post_shift;
+
+  //Clear the filter state.
+  memset(state, 0, 4 * stages * sizeof(dsp_sample_t));
+}
+
+#if DSP_ARCH == DSP_ARCH_FPU
+
+void dsp_biquad_process(struct dsp_biquad *bq, const dsp_sample_t *in, dsp_sample_t *out,
+                        uint16_t n) {
+  const float *c = bq->coeffs;
+  float *s = bq->state;
+  const float *src = in;
+  float b0, b1, b2, a1, a2, d1, d2, x, y;
+  uint8_t stage;
+  uint16_t i;
+
+  //Run each stage over the whole block, keeping coefficients and state in registers. The first
+  //stage reads from the input buffer and the rest work in place on the output buffer.
+  for (stage = 0; stage < bq->stages; stage++) {
+    b0 = c[0]; b1 = c[1]; b2 = c[2]; a1 = c[3]; a2 = c[4];
+    d1 = s[0]; d2 = s[1];
+
+    for (i = 0; i < n; i++) {
+      x = src[i];
+      y = b0 * x + d1;
+      d1 = b1 * x + a1 * y + d2;
+      d2 = b2 * x + a2 * y;
+      out[i] = y;
+    }
+
+    s[0] = d1; s[1] = d2;
+    c += 5;
+    s += 4;
+    src = out;
+  }
+}
+
+#elif DSP_ARCH == DSP_ARCH_SIMD
+
+void dsp_biquad_process(struct dsp_biquad *bq, const dsp_sample_t *in, dsp_sample_t *out,
+                        uint16_t n) {
+  const int16_t *c = bq->coeffs;
+  int16_t *s = bq->state;
+  const int16_t *src = in;
+  const uint8_t shift = 15 - bq->post_shift;
+  uint32_t b12, a12, x12, y12;
+  int32_t b0;
+  int64_t acc;
+  int16_t x, y;
+  uint8_t stage;
+  uint16_t i;
+
+  for (stage = 0; stage < bq->stages; stage++) {
+    //Keep the coefficient and state pairs packed, so each pair is handled by a single SMLALD.
+    b0 = c[0];
+    b12 = simd_read_q15x2(&c[1]);   //{b1, b2}
+    a12 = simd_read_q15x2(&c[3]);   //{a1, a2}
+    x12 = simd_read_q15x2(&s[0]);   //{x[n-1], x[n-2]}
+    y12 = simd_read_q15x2(&s[2]);   //{y[n-1], y[n-2]}
+
+    for (i = 0; i < n; i++) {
+      x = src[i];
+      acc = simd_smlald(b12, x12, b0 * x);
+      acc = simd_smlald(a12, y12, acc);
+      acc >>= shift;
+      y = (acc > 32767) ? 32767 : ((acc < -32768) ? -32768 : (int16_t) acc);
+
+      //Shift the delay lines: the newest sample goes to the low halfword.
+      x12 = (x12 << 16) | (uint16_t) x;
+      y12 = (y12 << 16) | (uint16_t) y;
+      out[i] = y;
+    }
+
+    simd_write_q15x2(&s[0], x12);
+    simd_write_q15x2(&s[2], y12);
+    c += 5;
+    s += 4;
+    src = out;
+  }
+}
+
+#else
+
+void dsp_biquad_process(struct dsp_biquad *bq, const dsp_sample_t *in, dsp_sample_t *out,
+                        uint16_t n) {
+  const int16_t *c = bq->coeffs;
+  int16_t *s = bq->state;
+  const int16_t *src = in;
+  const uint8_t shift = 15 - bq->post_shift;
+  int32_t b0, b1, b2, a1, a2, x1, x2, y1, y2;
+  int64_t acc;
+  int16_t x;
+  uint8_t stage;
+  uint16_t i;
+
+  for (stage = 0; stage < bq->stages; stage++) {
+    b0 = c[0]; b1 = c[1]; b2 = c[2]; a1 = c[3]; a2 = c[4];
+    x1 = s[0]; x2 = s[1]; y1 = s[2]; y2 = s[3];
+
+    for (i = 0; i < n; i++) {
+      x = src[i];
+
+      //Every Q30 product fits in 32 bits, but their sum may not, so accumulate in 64 bits.
+      acc = (int64_t) (b0 * x) + b1 * x1;
+      acc += b2 * x2;
+      acc += a1 * y1;
+      acc += a2 * y2;
+      acc >>= shift;
+      acc = (acc > 32767) ? 32767 : ((acc < -32768) ? -32768 : acc);
+
+      x2 = x1; x1 = x;
+      y2 = y1; y1 = (int32_t) acc;
+      out[i] = (int16_t) acc;
+    }
+
+    s[0] = x1; s[1] = x2; s[2] = y1; s[3] = y2;
+    c += 5;
+    s += 4;
+    src = out;
+  }
+}
+
+#endif
@@ -0,0 +1,342 @@
+//+------------------------------------------------------------------------------------------------+
+//| Real FFT kernels for the DSP library.                                                          |
+//|                                                                                                |
+//| A real FFT of n samples is computed as a complex radix-2 FFT of n/2 points (treating even and  |
+//| odd samples as the real and imaginary parts) followed by a split step that separates the       |
+//| spectra of both halves. Fixed point kernels scale each stage by 1/2 to prevent overflow.       |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <math.h>
+
+#include "dsp.h"
+
+#if DSP_ARCH == DSP_ARCH_SIMD
+#include "dsp-simd.h"
+#endif
+
+//Quarter wave sine table. Entry i holds sin(2 * pi * i / DSP_FFT_MAX_SIZE), for i between 0 and
+//DSP_FFT_MAX_SIZE / 4 (both inclusive). The remaining quadrants are derived from symmetry.
+#if DSP_ARCH == DSP_ARCH_FPU
+static const float sin_table[DSP_FFT_MAX_SIZE / 4 + 1] = {
+  0.000000000f, 0.006135885f, 0.012271538f, 0.018406730f, 0.024541229f, 0.030674803f,
+  0.036807223f, 0.042938257f, 0.049067674f, 0.055195244f, 0.061320736f, 0.067443920f,
+  0.073564564f, 0.079682438f, 0.085797312f, 0.091908956f, 0.098017140f, 0.104121634f,
+  0.110222207f, 0.116318631f, 0.122410675f, 0.128498111f, 0.134580709f, 0.140658239f,
+  0.146730474f, 0.152797185f, 0.158858143f, 0.164913120f, 0.170961889f, 0.177004220f,
+  0.183039888f, 0.189068664f, 0.195090322f, 0.201104635f, 0.207111376f, 0.213110320f,
+  0.219101240f, 0.225083911f, 0.231058108f, 0.237023606f, 0.242980180f, 0.248927606f,
+  0.254865660f, 0.260794118f, 0.266712757f, 0.272621355f, 0.278519689f, 0.284407537f,
+  0.290284677f, 0.296150888f, 0.302005949f, 0.307849640f, 0.313681740f, 0.319502031f,
+  0.325310292f, 0.331106306f, 0.336889853f, 0.342660717f, 0.348418680f, 0.354163525f,
+  0.359895037f, 0.365612998f, 0.371317194f, 0.377007410f, 0.382683432f, 0.388345047f,
+  0.393992040f, 0.399624200f, 0.405241314f, 0.410843171f, 0.416429560f, 0.422000271f,
+  0.427555093f, 0.433093819f, 0.438616239f, 0.444122145f, 0.449611330f, 0.455083587f,
+  0.460538711f, 0.465976496f, 0.471396737f, 0.476799230f, 0.482183772f, 0.487550160f,
+  0.492898192f, 0.498227667f, 0.503538384f, 0.508830143f, 0.514102744f, 0.519355990f,
+  0.524589683f, 0.529803625f, 0.534997620f, 0.540171473f, 0.545324988f, 0.550457973f,
+  0.555570233f, 0.560661576f, 0.565731811f, 0.570780746f, 0.575808191f, 0.580813958f,
+  0.585797857f, 0.590759702f, 0.595699304f, 0.600616479f, 0.605511041f, 0.610382806f,
+  0.615231591f, 0.620057212f, 0.624859488f, 0.629638239f, 0.634393284f, 0.639124445f,
+  0.643831543f, 0.648514401f, 0.653172843f, 0.657806693f, 0.662415778f, 0.666999922f,
+  0.671558955f, 0.676092704f, 0.680600998f, 0.685083668f, 0.689540545f, 0.693971461f,
+  0.698376249f, 0.702754744f, 0.707106781f, 0.711432196f, 0.715730825f, 0.720002508f,
+  0.724247083f, 0.728464390f, 0.732654272f, 0.736816569f, 0.740951125f, 0.745057785f,
+  0.749136395f, 0.753186799f, 0.757208847f, 0.761202385f, 0.765167266f, 0.769103338f,
+  0.773010453f, 0.776888466f, 0.780737229f, 0.784556597f, 0.788346428f, 0.792106577f,
+  0.795836905f, 0.799537269f, 0.803207531f, 0.806847554f, 0.810457198f, 0.814036330f,
+  0.817584813f, 0.821102515f, 0.824589303f, 0.828045045f, 0.831469612f, 0.834862875f,
+  0.838224706f, 0.841554977f, 0.844853565f, 0.848120345f, 0.851355193f, 0.854557988f,
+  0.857728610f, 0.860866939f, 0.863972856f, 0.867046246f, 0.870086991f, 0.873094978f,
+  0.876070094f, 0.879012226f, 0.881921264f, 0.884797098f, 0.887639620f, 0.890448723f,
+  0.893224301f, 0.895966250f, 0.898674466f, 0.901348847f, 0.903989293f, 0.906595705f,
+  0.909167983f, 0.911706032f, 0.914209756f, 0.916679060f, 0.919113852f, 0.921514039f,
+  0.923879533f, 0.926210242f, 0.928506080f, 0.930766961f, 0.932992799f, 0.935183510f,
+  0.937339012f, 0.939459224f, 0.941544065f, 0.943593458f, 0.945607325f, 0.947585591f,
+  0.949528181f, 0.951435021f, 0.953306040f, 0.955141168f, 0.956940336f, 0.958703475f,
+  0.960430519f, 0.962121404f, 0.963776066f, 0.965394442f, 0.966976471f, 0.968522094f,
+  0.970031253f, 0.971503891f, 0.972939952f, 0.974339383f, 0.975702130f, 0.977028143f,
+  0.978317371f, 0.979569766f, 0.980785280f, 0.981963869f, 0.983105487f, 0.984210092f,
+  0.985277642f, 0.986308097f, 0.987301418f, 0.988257568f, 0.989176510f, 0.990058210f,
+  0.990902635f, 0.991709754f, 0.992479535f, 0.993211949f, 0.993906970f, 0.994564571f,
+  0.995184727f, 0.995767414f, 0.996312612f, 0.996820299f, 0.997290457f, 0.997723067f,
+  0.998118113f, 0.998475581f, 0.998795456f, 0.999077728f, 0.999322385f, 0.999529418f,
+  0.999698819f, 0.999830582f, 0.999924702f, 0.999981175f, 1.000000000f,
+};
+#else
+static const int16_t sin_table[DSP_FFT_MAX_SIZE / 4 + 1] = {
+       0,    201,    402,    603,    804,   1005,   1206,   1407,   1608,   1809,   2009,   2210,
+    2410,   2611,   2811,   3012,   3212,   3412,   3612,   3811,   4011,   4210,   4410,   4609,
+    4808,   5007,   5205,   5404,   5602,   5800,   5998,   6195,   6393,   6590,   6786,   6983,
+    7179,   7375,   7571,   7767,   7962,   8157,   8351,   8545,   8739,   8933,   9126,   9319,
+    9512,   9704,   9896,  10087,  10278,  10469,  10659,  10849,  11039,  11228,  11417,  11605,
+   11793,  11980,  12167,  12353,  12539,  12725,  12910,  13094,  13279,  13462,  13645,  13828,
+   14010,  14191,  14372,  14553,  14732,  14912,  15090,  15269,  15446,  15623,  15800,  15976,
+   16151,  16325,  16499,  16673,  16846,  17018,  17189,  17360,  17530,  17700,  17869,  18037,
+   18204,  18371,  18537,  18703,  18868,  19032,  19195,  19357,  19519,  19680,  19841,  20000,
+   20159,  20317,  20475,  20631,  20787,  20942,  21096,  21250,  21403,  21554,  21705,  21856,
+   22005,  22154,  22301,  22448,  22594,  22739,  22884,  23027,  23170,  23311,  23452,  23592,
+   23731,  23870,  24007,  24143,  24279,  24413,  24547,  24680,  24811,  24942,  25072,  25201,
+   25329,  25456,  25582,  25708,  25832,  25955,  26077,  26198,  26319,  26438,  26556,  26674,
+   26790,  26905,  27019,  27133,  27245,  27356,  27466,  27575,  27683,  27790,  27896,  28001,
+   28105,  28208,  28310,  28411,  28510,  28609,  28706,  28803,  28898,  28992,  29085,  29177,
+   29268,  29358,  29447,  29534,  29621,  29706,  29791,  29874,  29956,  30037,  30117,  30195,
+   30273,  30349,  30424,  30498,  30571,  30643,  30714,  30783,  30852,  30919,  30985,  31050,
+   31113,  31176,  31237,  31297,  31356,  31414,  31470,  31526,  31580,  31633,  31685,  31736,
+   31785,  31833,  31880,  31926,  31971,  32014,  32057,  32098,  32137,  32176,  32213,  32250,
+   32285,  32318,  32351,  32382,  32412,  32441,  32469,  32495,  32521,  32545,  32567,  32589,
+   32609,  32628,  32646,  32663,  32678,  32692,  32705,  32717,  32728,  32737,  32745,  32752,
+   32757,  32761,  32765,  32766,  32767,
+};
+#endif
+
+//Returns sin(2 * pi * i / DSP_FFT_MAX_SIZE).
+static inline dsp_sample_t table_sin(uint16_t i) {
+  i &= DSP_FFT_MAX_SIZE - 1;
+  if (i <= DSP_FFT_MAX_SIZE / 4)
+    return sin_table[i];
+  else if (i <= DSP_FFT_MAX_SIZE / 2)
+    return sin_table[DSP_FFT_MAX_SIZE / 2 - i];
+  else if (i <= 3 * DSP_FFT_MAX_SIZE / 4)
+    return -sin_table[i - DSP_FFT_MAX_SIZE / 2];
+  else
+    return -sin_table[DSP_FFT_MAX_SIZE - i];
+}
+
+//Returns cos(2 * pi * i / DSP_FFT_MAX_SIZE).
+static inline dsp_sample_t table_cos(uint16_t i) {
+  return table_sin(i + DSP_FFT_MAX_SIZE / 4);
+}
+
+//Reorders the m complex points of an interleaved buffer in bit reversed index order.
+static void bit_reverse(dsp_sample_t *buf, uint16_t m) {
+  dsp_sample_t t;
+  uint16_t i, j, bit;
+
+  for (i = 1, j = 0; i < m; i++) {
+    for (bit = m >> 1; j & bit; bit >>= 1)
+      j ^= bit;
+    j |= bit;
+
+    if (i < j) {
+      t = buf[2 * i]; buf[2 * i] = buf[2 * j]; buf[2 * j] = t;
+      t = buf[2 * i + 1]; buf[2 * i + 1] = buf[2 * j + 1]; buf[2 * j + 1] = t;
+    }
+  }
+}
+
+#if DSP_ARCH == DSP_ARCH_FPU
+
+//Computes the forward complex FFT of m interleaved points in place.
+static void cfft(float *buf, uint16_t m) {
+  uint16_t len, half, step, i, j, a, b;
+  float wr, wi, tr, ti;
+
+  bit_reverse(buf, m);
+
+  for (len = 2; len <= m; len <<= 1) {
+    half = len >> 1;
+    step = DSP_FFT_MAX_SIZE / len;
+    for (j = 0; j < half; j++) {
+      wr = table_cos(j * step);
+      wi = -table_sin(j * step);
+      for (i = j; i < m; i += len) {
+        a = 2 * i;
+        b = 2 * (i + half);
+        tr = buf[b] * wr - buf[b + 1] * wi;
+        ti = buf[b] * wi + buf[b + 1] * wr;
+        buf[b] = buf[a] - tr;
+        buf[b + 1] = buf[a + 1] - ti;
+        buf[a] += tr;
+        buf[a + 1] += ti;
+      }
+    }
+  }
+}
+
+//Separates the spectra of the even and odd samples and combines them into the real FFT output.
+static void rfft_split(float *buf, uint16_t n) {
+  const uint16_t m = n >> 1;
+  const uint16_t step = DSP_FFT_MAX_SIZE / n;
+  float er, ei, odr, odi, tr, ti, c, s, dc;
+  uint16_t k, a, b;
+
+  //DC and Nyquist bins are purely real. Pack them in the first complex slot.
+  dc = buf[0];
+  buf[0] = dc + buf[1];
+  buf[1] = dc - buf[1];
+
+  for (k = 1; k <= m / 2; k++) {
+    a = 2 * k;
+    b = 2 * (m - k);
+    er = 0.5f * (buf[a] + buf[b]);
+    ei = 0.5f * (buf[a + 1] - buf[b + 1]);
+    odr = 0.5f * (buf[a] - buf[b]);
+    odi = 0.5f * (buf[a + 1] + buf[b + 1]);
+    c = table_cos(k * step);
+    s = table_sin(k * step);
+    tr = c * odi - s * odr;
+    ti = -s * odi - c * odr;
+    buf[a] = er + tr;
+    buf[a + 1] = ei + ti;
+    buf[b] = er - tr;
+    buf[b + 1] = ti - ei;
+  }
+}
+
+#elif DSP_ARCH == DSP_ARCH_SIMD
+
+//Computes the forward complex FFT of m interleaved points in place, scaled by 1/m. Each complex
+//point is handled as a packed {re, im} word, so the complex multiplication takes two dual
+//multiply instructions and the scaled butterfly two halving add/subtract instructions.
+static void cfft(int16_t *buf, uint16_t m) {
+  uint16_t len, half, step, i, j;
+  uint32_t w, x, t;
+  int32_t tr, ti;
+
+  bit_reverse(buf, m);
+
+  for (len = 2; len <= m; len <<= 1) {
+    half = len >> 1;
+    step = DSP_FFT_MAX_SIZE / len;
+    for (j = 0; j < half; j++) {
+      w = simd_pack(table_cos(j * step), -table_sin(j * step));
+      for (i = j; i < m; i += len) {
+        x = simd_read_q15x2(&buf[2 * (i + half)]);
+        tr = simd_smusd(x, w) >> 15;    //re * wr - im * wi
+        ti = simd_smuadx(x, w) >> 15;   //re * wi + im * wr
+        t = simd_pack(tr, ti);
+        x = simd_read_q15x2(&buf[2 * i]);
+        simd_write_q15x2(&buf[2 * i], simd_shadd16(x, t));
+        simd_write_q15x2(&buf[2 * (i + half)], simd_shsub16(x, t));
+      }
+    }
+  }
+}
+
+#else
+
+//Computes the forward complex FFT of m interleaved points in place, scaled by 1/m.
+static void cfft(int16_t *buf, uint16_t m) {
+  uint16_t len, half, step, i, j, a, b;
+  int32_t wr, wi, tr, ti, xr, xi;
+
+  bit_reverse(buf, m);
+
+  for (len = 2; len <= m; len <<= 1) {
+    half = len >> 1;
+    step = DSP_FFT_MAX_SIZE / len;
+    for (j = 0; j < half; j++) {
+      wr = table_cos(j * step);
+      wi = -table_sin(j * step);
+      for (i = j; i < m; i += len) {
+        a = 2 * i;
+        b = 2 * (i + half);
+        tr = (buf[b] * wr - buf[b + 1] * wi) >> 15;
+        ti = (buf[b] * wi + buf[b + 1] * wr) >> 15;
+        xr = buf[a];
+        xi = buf[a + 1];
+        buf[a] = (xr + tr) >> 1;
+        buf[a + 1] = (xi + ti) >> 1;
+        buf[b] = (xr - tr) >> 1;
+        buf[b + 1] = (xi - ti) >> 1;
+      }
+    }
+  }
+}
+
+#endif
+
+#if DSP_ARCH != DSP_ARCH_FPU
+
+//Separates the spectra of the even and odd samples and combines them into the real FFT output.
+//Every output is halved once more, so the total scaling is 1/n.
+static void rfft_split(int16_t *buf, uint16_t n) {
+  const uint16_t m = n >> 1;
+  const uint16_t step = DSP_FFT_MAX_SIZE / n;
+  int32_t er, ei, odr, odi, tr, ti, c, s, dc;
+  uint16_t k, a, b;
+
+  //DC and Nyquist bins are purely real. Pack them in the first complex slot.
+  dc = buf[0];
+  buf[0] = (dc + buf[1]) >> 1;
+  buf[1] = (dc - buf[1]) >> 1;
+
+  for (k = 1; k <= m / 2; k++) {
+    a = 2 * k;
+    b = 2 * (m - k);
+    er = (buf[a] + buf[b]) >> 1;
+    ei = (buf[a + 1] - buf[b + 1]) >> 1;
+    odr = (buf[a] - buf[b]) >> 1;
+    odi = (buf[a + 1] + buf[b + 1]) >> 1;
+    c = table_cos(k * step);
+    s = table_sin(k * step);
+    tr = (c * odi - s * odr) >> 15;
+    ti = (-s * odi - c * odr) >> 15;
+    buf[a] = (er + tr) >> 1;
+    buf[a + 1] = (ei + ti) >> 1;
+    buf[b] = (er - tr) >> 1;
+    buf[b + 1] = (ti - ei) >> 1;
+  }
+}
+
+#endif
+
+int dsp_rfft(dsp_sample_t *buf, uint16_t n) {
+  //Check that the size is a supported power of 2.
+  if (n < 4 || n > DSP_FFT_MAX_SIZE || (n & (n - 1)) != 0)
+    return -1;
+
+  cfft(buf, n >> 1);
+  rfft_split(buf, n);
+  return 0;
+}
+
+#if DSP_ARCH == DSP_ARCH_FPU
+
+void dsp_rfft_magnitude(const dsp_sample_t *spectrum, dsp_sample_t *mag, uint16_t n) {
+  uint16_t k;
+
+  mag[0] = fabsf(spectrum[0]);
+  for (k = 1; k < n / 2; k++)
+    mag[k] = sqrtf(spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1]);
+}
+
+#else
+
+//Integer square root of a 32 bit value, computed one result bit at a time.
+static uint16_t isqrt(uint32_t x) {
+  uint32_t res = 0;
+  uint32_t bit = 1UL << 30;
+
+  while (bit > x)
+    bit >>= 2;
+  while (bit != 0) {
+    if (x >= res + bit) {
+      x -= res + bit;
+      res = (res >> 1) + bit;
+    }
+    else
+      res >>= 1;
+    bit >>= 2;
+  }
+  return res;
+}
+
+void dsp_rfft_magnitude(const dsp_sample_t *spectrum, dsp_sample_t *mag, uint16_t n) {
+  uint32_t re2, im2, m;
+  uint16_t k;
+
+  mag[0] = (spectrum[0] < 0) ? -spectrum[0] : spectrum[0];
+  for (k = 1; k < n / 2; k++) {
+    //The sum of both squared Q15 values fits in 32 bits as unsigned. The square root of a Q30
+    //value is a Q15 value.
+    re2 = (int32_t) spectrum[2 * k] * spectrum[2 * k];
+    im2 = (int32_t) spectrum[2 * k + 1] * spectrum[2 * k + 1];
+    m = isqrt(re2 + im2);
+    mag[k] = (m > 32767) ? 32767 : m;
+  }
+}
+
+#endif
@@ -0,0 +1,111 @@
+//+------------------------------------------------------------------------------------------------+
+//| FIR filter kernels for the DSP library.                                                        |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <string.h>
+
+#include "dsp.h"
+
+#if DSP_ARCH == DSP_ARCH_SIMD
+#include "dsp-simd.h"
+#endif
+
+void dsp_fir_init(struct dsp_fir *fir, const dsp_sample_t *coeffs, dsp_sample_t *state,
+                  uint16_t taps) {
+  fir->coeffs = coeffs;
+  fir->state = state;
+  fir->taps = taps;
+  fir->pos = 0;
+
+  //Clear both copies of the delay line.
+  memset(state, 0, 2 * taps * sizeof(dsp_sample_t));
+}
+
+//Stores a new sample in the delay line and returns a pointer to the window of the last taps
+//samples, newest first.
+static inline const dsp_sample_t *push_sample(struct dsp_fir *fir, dsp_sample_t x) {
+  fir->pos = (fir->pos == 0) ? fir->taps - 1 : fir->pos - 1;
+  fir->state[fir->pos] = x;
+  fir->state[fir->pos + fir->taps] = x;
+  return &fir->state[fir->pos];
+}
+
+#if DSP_ARCH == DSP_ARCH_FPU
+
+void dsp_fir_process(struct dsp_fir *fir, const dsp_sample_t *in, dsp_sample_t *out, uint16_t n) {
+  const float *h = fir->coeffs;
+  const float *w;
+  float acc0, acc1, acc2, acc3;
+  uint16_t i, k;
+
+  for (i = 0; i < n; i++) {
+    w = push_sample(fir, in[i]);
+
+    //Use four independent accumulators so the multiply-accumulate instructions can be pipelined.
+    acc0 = acc1 = acc2 = acc3 = 0.0f;
+    for (k = 0; k + 4 <= fir->taps; k += 4) {
+      acc0 += h[k] * w[k];
+      acc1 += h[k + 1] * w[k + 1];
+      acc2 += h[k + 2] * w[k + 2];
+      acc3 += h[k + 3] * w[k + 3];
+    }
+    for (; k < fir->taps; k++)
+      acc0 += h[k] * w[k];
+
+    out[i] = (acc0 + acc1) + (acc2 + acc3);
+  }
+}
+
+#elif DSP_ARCH == DSP_ARCH_SIMD
+
+void dsp_fir_process(struct dsp_fir *fir, const dsp_sample_t *in, dsp_sample_t *out, uint16_t n) {
+  const int16_t *h = fir->coeffs;
+  const int16_t *w;
+  int64_t acc;
+  uint16_t i, k;
+
+  for (i = 0; i < n; i++) {
+    w = push_sample(fir, in[i]);
+
+    //Process two taps per SMLALD instruction, unrolled to four taps per iteration. The 64 bit
+    //accumulator can't overflow for any realistic amount of taps.
+    acc = 0;
+    for (k = 0; k + 4 <= fir->taps; k += 4) {
+      acc = simd_smlald(simd_read_q15x2(&h[k]), simd_read_q15x2(&w[k]), acc);
+      acc = simd_smlald(simd_read_q15x2(&h[k + 2]), simd_read_q15x2(&w[k + 2]), acc);
+    }
+    for (; k < fir->taps; k++)
+      acc += (int32_t) h[k] * w[k];
+
+    //Scale back from Q30 to Q15 and saturate.
+    acc >>= 15;
+    out[i] = (acc > 32767) ? 32767 : ((acc < -32768) ? -32768 : (int16_t) acc);
+  }
+}
+
+#else
+
+void dsp_fir_process(struct dsp_fir *fir, const dsp_sample_t *in, dsp_sample_t *out, uint16_t n) {
+  const int16_t *h = fir->coeffs;
+  const int16_t *w;
+  int64_t acc;
+  uint16_t i, k;
+
+  for (i = 0; i < n; i++) {
+    w = push_sample(fir, in[i]);
+
+    //Every Q30 product fits in 32 bits, so only the accumulation is done in 64 bits. This avoids
+    //calling the 64 bit multiplication helper on cores without a long multiply instruction.
+    acc = 0;
+    for (k = 0; k < fir->taps; k++)
+      acc += (int32_t) h[k] * w[k];
+
+    //Scale back from Q30 to Q15 and saturate.
+    acc >>= 15;
+    out[i] = (acc > 32767) ? 32767 : ((acc < -32768) ? -32768 : (int16_t) acc);
+  }
+}
+
+#endif
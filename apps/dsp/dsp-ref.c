@@ -0,0 +1,85 @@
+//+------------------------------------------------------------------------------------------------+
+//| Double precision reference kernels for the DSP library.                                        |
+//|                                                                                                |
+//| These functions favor clarity over speed and have no architecture specific code, so they can   |
+//| be compiled on the host as well. They define the expected results of the optimized kernels.    |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <math.h>
+
+#include "dsp.h"
+
+//Direct convolution, assuming a zeroed history before the first input sample.
+void dsp_ref_fir(const double *coeffs, uint16_t taps, const double *in, double *out, uint16_t n) {
+  uint16_t i, k;
+  double acc;
+
+  for (i = 0; i < n; i++) {
+    acc = 0.0;
+    for (k = 0; k < taps && k <= i; k++)
+      acc += coeffs[k] * in[i - k];
+    out[i] = acc;
+  }
+}
+
+//Direct form I cascade, with the same coefficient layout and sign convention as dsp_biquad.
+void dsp_ref_biquad(const double *coeffs, uint8_t stages, const double *in, double *out,
+                    uint16_t n) {
+  double x1, x2, y1, y2, x, y;
+  uint8_t stage;
+  uint16_t i;
+
+  for (i = 0; i < n; i++)
+    out[i] = in[i];
+
+  for (stage = 0; stage < stages; stage++) {
+    x1 = x2 = y1 = y2 = 0.0;
+    for (i = 0; i < n; i++) {
+      x = out[i];
+      y = coeffs[0] * x + coeffs[1] * x1 + coeffs[2] * x2 + coeffs[3] * y1 + coeffs[4] * y2;
+      x2 = x1; x1 = x;
+      y2 = y1; y1 = y;
+      out[i] = y;
+    }
+    coeffs += 5;
+  }
+}
+
+//Direct DFT, producing the same packed output as dsp_rfft (without any scaling).
+void dsp_ref_rfft(const double *in, double *out, uint16_t n) {
+  const double pi = 3.14159265358979323846;
+  double re, im;
+  uint16_t k, i;
+
+  for (k = 0; k <= n / 2; k++) {
+    re = im = 0.0;
+    for (i = 0; i < n; i++) {
+      re += in[i] * cos(2.0 * pi * k * i / n);
+      im -= in[i] * sin(2.0 * pi * k * i / n);
+    }
+
+    if (k == 0)
+      out[0] = re;
+    else if (k == n / 2)
+      out[1] = re;
+    else {
+      out[2 * k] = re;
+      out[2 * k + 1] = im;
+    }
+  }
+}
+
+void dsp_ref_stats(const double *x, uint16_t n, double *rms, double *peak) {
+  double sum = 0.0;
+  uint16_t i;
+
+  *peak = 0.0;
+  for (i = 0; i < n; i++) {
+    sum += x[i] * x[i];
+    if (fabs(x[i]) > *peak)
+      *peak = fabs(x[i]);
+  }
+  *rms = (n > 0) ? sqrt(sum / n) : 0.0;
+}
@@ -0,0 +1,69 @@
+//+------------------------------------------------------------------------------------------------+
+//| Cortex-M4 DSP extension helpers for the DSP kernel library.                                    |
+//|                                                                                                |
+//| The library is CPU independent and can't include a particular device header (and through it    |
+//| the CMSIS intrinsics), so the few SIMD instructions used by the kernels are wrapped here.      |
+//| This header is private to the library and only valid when DSP_ARCH is DSP_ARCH_SIMD.           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef DSP_SIMD_H_
+#define DSP_SIMD_H_
+
+#include <stdint.h>
+#include <string.h>
+
+//Reads two consecutive Q15 values as a packed word (first value in the low halfword). The memcpy
+//is turned into a single LDR, which allows unaligned addresses on the Cortex-M4.
+static inline uint32_t simd_read_q15x2(const int16_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void simd_write_q15x2(int16_t *p, uint32_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+//Packs two halfwords into a word (lo in bits 0-15, hi in bits 16-31).
+static inline uint32_t simd_pack(int16_t lo, int16_t hi) {
+  return ((uint32_t) (uint16_t) lo) | (((uint32_t) (uint16_t) hi) << 16);
+}
+
+//Dual 16 bit multiply with 64 bit accumulate: acc + x.lo * y.lo + x.hi * y.hi
+static inline int64_t simd_smlald(uint32_t x, uint32_t y, int64_t acc) {
+  uint32_t lo = (uint32_t) acc;
+  uint32_t hi = (uint32_t) ((uint64_t) acc >> 32);
+  __asm__ ("smlald %0, %1, %2, %3" : "+r" (lo), "+r" (hi) : "r" (x), "r" (y));
+  return (int64_t) (((uint64_t) hi << 32) | lo);
+}
+
+//Dual 16 bit multiply, subtract products: x.lo * y.lo - x.hi * y.hi
+static inline int32_t simd_smusd(uint32_t x, uint32_t y) {
+  int32_t r;
+  __asm__ ("smusd %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+  return r;
+}
+
+//Dual 16 bit multiply with exchange, add products: x.lo * y.hi + x.hi * y.lo
+static inline int32_t simd_smuadx(uint32_t x, uint32_t y) {
+  int32_t r;
+  __asm__ ("smuadx %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+  return r;
+}
+
+//Dual 16 bit halving add and subtract.
+static inline uint32_t simd_shadd16(uint32_t x, uint32_t y) {
+  uint32_t r;
+  __asm__ ("shadd16 %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+  return r;
+}
+
+static inline uint32_t simd_shsub16(uint32_t x, uint32_t y) {
+  uint32_t r;
+  __asm__ ("shsub16 %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+  return r;
+}
+
+#endif //DSP_SIMD_H_
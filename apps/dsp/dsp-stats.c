@@ -0,0 +1,100 @@
+//+------------------------------------------------------------------------------------------------+
+//| Block statistics (RMS and peak) kernels for the DSP library.                                   |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <math.h>
+
+#include "dsp.h"
+
+#if DSP_ARCH == DSP_ARCH_SIMD
+#include "dsp-simd.h"
+#endif
+
+#if DSP_ARCH == DSP_ARCH_FPU
+
+void dsp_stats(const dsp_sample_t *x, uint16_t n, struct dsp_stats *stats) {
+  float sum0 = 0.0f, sum1 = 0.0f, v, peak = 0.0f;
+  uint16_t i, peak_index = 0;
+
+  for (i = 0; i + 2 <= n; i += 2) {
+    sum0 += x[i] * x[i];
+    sum1 += x[i + 1] * x[i + 1];
+  }
+  if (i < n)
+    sum0 += x[i] * x[i];
+
+  for (i = 0; i < n; i++) {
+    v = fabsf(x[i]);
+    if (v > peak) {
+      peak = v;
+      peak_index = i;
+    }
+  }
+
+  stats->rms = (n > 0) ? sqrtf((sum0 + sum1) / n) : 0.0f;
+  stats->peak = peak;
+  stats->peak_index = peak_index;
+}
+
+#else
+
+//Integer square root of a 64 bit value, computed one result bit at a time.
+static uint32_t isqrt64(uint64_t x) {
+  uint64_t res = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > x)
+    bit >>= 2;
+  while (bit != 0) {
+    if (x >= res + bit) {
+      x -= res + bit;
+      res = (res >> 1) + bit;
+    }
+    else
+      res >>= 1;
+    bit >>= 2;
+  }
+  return (uint32_t) res;
+}
+
+void dsp_stats(const dsp_sample_t *x, uint16_t n, struct dsp_stats *stats) {
+  uint64_t sum = 0;
+  int32_t v, peak = 0;
+  uint32_t rms;
+  uint16_t i, peak_index = 0;
+
+#if DSP_ARCH == DSP_ARCH_SIMD
+  uint32_t pair;
+  int64_t acc = 0;
+
+  //Square and accumulate two samples per SMLALD instruction.
+  for (i = 0; i + 2 <= n; i += 2) {
+    pair = simd_read_q15x2(&x[i]);
+    acc = simd_smlald(pair, pair, acc);
+  }
+  if (i < n)
+    acc += (int32_t) x[i] * x[i];
+  sum = acc;
+#else
+  for (i = 0; i < n; i++)
+    sum += (uint32_t) ((int32_t) x[i] * x[i]);
+#endif
+
+  for (i = 0; i < n; i++) {
+    v = (x[i] < 0) ? -x[i] : x[i];
+    if (v > peak) {
+      peak = v;
+      peak_index = i;
+    }
+  }
+
+  //The mean of the Q30 squares is a Q30 value, and its square root is a Q15 value.
+  rms = (n > 0) ? isqrt64(sum / n) : 0;
+  stats->rms = (rms > 32767) ? 32767 : rms;
+  stats->peak = (peak > 32767) ? 32767 : peak;
+  stats->peak_index = peak_index;
+}
+
+#endif
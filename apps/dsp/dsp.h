@@ -0,0 +1,147 @@
+//+------------------------------------------------------------------------------------------------+
+//| Digital signal processing kernel library.                                                      |
+//|                                                                                                |
+//| This library implements a small set of signal processing kernels (FIR filters, biquad          |
+//| cascades, real FFT and block statistics) with a kernel implementation per core family, which   |
+//| is selected at compile time:                                                                   |
+//|                                                                                                |
+//| - DSP_ARCH_FPU: Single precision floating point samples. Used on cores with a hardware FPU     |
+//|   (mk66fx1m0, compiled with -mfpu=fpv4-sp-d16 -mfloat-abi=hard).                               |
+//| - DSP_ARCH_SIMD: Q15 samples with Q31/64-bit accumulators, using the Cortex-M4 DSP extension   |
+//|   instructions (SMLALD, SMUSD, SHADD16...). Used on the soft float mk20dx256.                  |
+//| - DSP_ARCH_GENERIC: Q15 samples processed with plain integer C code. Used on the Cortex-M0+    |
+//|   (mkl26z64) and on host builds, where it serves as a portable fixed point implementation.     |
+//|                                                                                                |
+//| Application code should handle samples through the dsp_sample_t type and the conversion        |
+//| helpers below, so it remains portable among all targets. The selection can be forced by        |
+//| defining DSP_CONF_ARCH in the platform or project configuration.                               |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef DSP_H_
+#define DSP_H_
+
+#include <stdint.h>
+
+//Kernel implementation identifiers.
+#define DSP_ARCH_FPU      1
+#define DSP_ARCH_SIMD     2
+#define DSP_ARCH_GENERIC  3
+
+//Select the kernel implementation from the compiler target flags unless configured explicitly.
+#ifdef DSP_CONF_ARCH
+#define DSP_ARCH DSP_CONF_ARCH
+#elif defined(__ARM_FP) && (__ARM_FP & 0x4) && defined(__ARM_PCS_VFP)
+#define DSP_ARCH DSP_ARCH_FPU
+#elif defined(__ARM_FEATURE_DSP)
+#define DSP_ARCH DSP_ARCH_SIMD
+#else
+#define DSP_ARCH DSP_ARCH_GENERIC
+#endif
+
+//Largest supported real FFT size. It's bounded by the resolution of the twiddle factor table.
+#define DSP_FFT_MAX_SIZE 1024
+
+//Sample type definitions and conversion helpers.
+#if DSP_ARCH == DSP_ARCH_FPU
+
+typedef float dsp_sample_t;
+
+#define DSP_SAMPLE(x) ((float) (x))
+
+static inline float dsp_to_float(dsp_sample_t x) {
+  return x;
+}
+
+static inline dsp_sample_t dsp_from_float(float x) {
+  return x;
+}
+
+static inline dsp_sample_t dsp_from_q15(int16_t x) {
+  return x * (1.0f / 32768.0f);
+}
+
+#else
+
+typedef int16_t dsp_sample_t;   //Q15 (1 sign bit, 15 fractional bits)
+
+//Converts a constant in the [-1, 1] range to Q15, saturating at the positive end. Meant to be used
+//for coefficient tables, where it's evaluated at compile time.
+#define DSP_SAMPLE(x) ((int16_t) (((x) >= 1.0) ? 32767 : ((x) * 32768.0)))
+
+static inline float dsp_to_float(dsp_sample_t x) {
+  return x * (1.0f / 32768.0f);
+}
+
+static inline dsp_sample_t dsp_from_float(float x) {
+  int32_t v = (int32_t) (x * 32768.0f);
+  return (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
+}
+
+static inline dsp_sample_t dsp_from_q15(int16_t x) {
+  return x;
+}
+
+#endif
+
+//FIR filter instance. The state buffer must hold 2 * taps samples; keeping the delay line
+//duplicated allows the kernels to always read the sample window as a contiguous array.
+struct dsp_fir {
+  const dsp_sample_t *coeffs;   //Coefficients h[0] ... h[taps - 1]
+  dsp_sample_t *state;          //Delay line (2 * taps samples)
+  uint16_t taps;                //Number of filter taps
+  uint16_t pos;                 //Position of the newest sample in the delay line
+};
+
+//Biquad cascade instance. Every stage takes 5 coefficients in the {b0, b1, b2, a1, a2} order and
+//implements y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2] (that is, the feedback
+//coefficients are stored already negated). The state buffer must hold 4 samples per stage.
+//
+//With fixed point samples the coefficients are Q15 values scaled down by 2^post_shift, so filters
+//with coefficients of magnitude up to 2^post_shift can be represented. The post_shift value is
+//ignored by the floating point implementation.
+struct dsp_biquad {
+  const dsp_sample_t *coeffs;   //Coefficients (5 per stage)
+  dsp_sample_t *state;          //Filter state (4 per stage)
+  uint8_t stages;               //Number of second order stages
+  uint8_t post_shift;           //Coefficient scaling (fixed point only)
+};
+
+//Block statistics.
+struct dsp_stats {
+  dsp_sample_t rms;             //Root mean square value
+  dsp_sample_t peak;            //Largest absolute sample value
+  uint16_t peak_index;          //Index of the peak sample in the block
+};
+
+void dsp_fir_init(struct dsp_fir *fir, const dsp_sample_t *coeffs, dsp_sample_t *state,
+                  uint16_t taps);
+void dsp_fir_process(struct dsp_fir *fir, const dsp_sample_t *in, dsp_sample_t *out, uint16_t n);
+
+void dsp_biquad_init(struct dsp_biquad *bq, const dsp_sample_t *coeffs, dsp_sample_t *state,
+                     uint8_t stages, uint8_t post_shift);
+void dsp_biquad_process(struct dsp_biquad *bq, const dsp_sample_t *in, dsp_sample_t *out,
+                        uint16_t n);
+
+//Computes the real FFT of n samples in place, where n is a power of 2 between 4 and
+//DSP_FFT_MAX_SIZE. The output is packed as {X[0], X[n/2], Re(X[1]), Im(X[1]), ...
+//Re(X[n/2 - 1]), Im(X[n/2 - 1])}. Fixed point outputs are scaled by 1/n to avoid overflow.
+int dsp_rfft(dsp_sample_t *buf, uint16_t n);
+
+//Computes the magnitude of the n/2 first bins of a packed real FFT output. The Nyquist bin is
+//dropped, so mag[0] holds |X[0]| and mag[k] holds |X[k]| for 0 < k < n/2.
+void dsp_rfft_magnitude(const dsp_sample_t *spectrum, dsp_sample_t *mag, uint16_t n);
+
+void dsp_stats(const dsp_sample_t *x, uint16_t n, struct dsp_stats *stats);
+
+//Double precision reference kernels. These are plain, unoptimized implementations of the same
+//algorithms (the FFT is computed as a direct DFT) meant for validating the optimized kernels,
+//either on the host or on target.
+void dsp_ref_fir(const double *coeffs, uint16_t taps, const double *in, double *out, uint16_t n);
+void dsp_ref_biquad(const double *coeffs, uint8_t stages, const double *in, double *out,
+                    uint16_t n);
+void dsp_ref_rfft(const double *in, double *out, uint16_t n);
+void dsp_ref_stats(const double *x, uint16_t n, double *rms, double *peak);
+
+#endif //DSP_H_
@@ -0,0 +1,1036 @@
+//+------------------------------------------------------------------------------------------------+
+//| FAT32 file system for logging.                                                                 |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+#include <string.h>
+
+#include "fat.h"
+
+//Block number of empty caches.
+#define NONE 0xFFFFFFFF
+
+#define BUFFER_SIZE (FAT_BUFFER_BLOCKS * FAT_BLOCK_SIZE)
+
+//FAT entries (28 bits, the upper 4 are reserved).
+#define ENTRIES_PER_BLOCK (FAT_BLOCK_SIZE / 4)
+#define ENTRY_MASK        0x0FFFFFFF
+#define ENTRY_FREE        0x00000000
+#define ENTRY_LAST        0x0FFFFFF8  //End of chain markers, from here on
+#define ENTRY_END         0x0FFFFFFF
+
+//Directory entries.
+#define DIR_ENTRY_SIZE    32
+#define DIR_END           0x00        //First name byte of the entry after the last one
+#define DIR_DELETED       0xE5
+#define ATTR_VOLUME       0x08
+#define ATTR_DIRECTORY    0x10
+#define ATTR_ARCHIVE      0x20
+#define ATTR_LONG_NAME    0x0F
+
+//Partition types of FAT32 volumes (CHS and LBA addressed).
+#define PARTITION_FAT32     0x0B
+#define PARTITION_FAT32_LBA 0x0C
+
+#define BOOT_SIGNATURE    0xAA55
+#define FSINFO_LEAD       0x41615252
+#define FSINFO_STRUCT     0x61417272
+#define UNKNOWN           0xFFFFFFFF
+
+//--------------------------------------------------------------------------------------------------
+//Little endian fields.
+
+static uint16_t get16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void put16(uint8_t *p, uint16_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Device access and caches.
+
+static int device_read(struct fat *fs, uint32_t block, void *buffer, uint16_t count) {
+  fs->reads++;
+  if (fs->device->read(block, buffer, count) != 0)
+    return FAT_ERR_IO;
+
+  return FAT_OK;
+}
+
+static int device_write(struct fat *fs, uint32_t block, const void *buffer, uint16_t count) {
+  fs->writes++;
+  if (count > fs->largest_write)
+    fs->largest_write = count;
+
+  if (fs->device->write(block, buffer, count) != 0)
+    return FAT_ERR_IO;
+
+  return FAT_OK;
+}
+
+//Writes back the cached FAT sector, to every copy of the FAT.
+static int flush_fat(struct fat *fs) {
+  uint8_t i;
+  int error;
+
+  if (!fs->fat_dirty)
+    return FAT_OK;
+
+  for (i = 0; i < fs->fats; i++) {
+    error = device_write(fs, fs->fat_block + i * fs->fat_blocks, fs->fat_cache, 1);
+    if (error != FAT_OK)
+      return error;
+  }
+
+  fs->fat_dirty = 0;
+  return FAT_OK;
+}
+
+static int load_fat(struct fat *fs, uint32_t block) {
+  int error;
+
+  if (fs->fat_block == block)
+    return FAT_OK;
+
+  error = flush_fat(fs);
+  if (error != FAT_OK)
+    return error;
+
+  fs->fat_block = NONE;
+  error = device_read(fs, block, fs->fat_cache, 1);
+  if (error == FAT_OK)
+    fs->fat_block = block;
+
+  return error;
+}
+
+static int flush_dir(struct fat *fs) {
+  int error;
+
+  if (!fs->dir_dirty)
+    return FAT_OK;
+
+  error = device_write(fs, fs->dir_block, fs->dir_cache, 1);
+  if (error == FAT_OK)
+    fs->dir_dirty = 0;
+
+  return error;
+}
+
+static int load_dir(struct fat *fs, uint32_t block) {
+  int error;
+
+  if (fs->dir_block == block)
+    return FAT_OK;
+
+  error = flush_dir(fs);
+  if (error != FAT_OK)
+    return error;
+
+  fs->dir_block = NONE;
+  error = device_read(fs, block, fs->dir_cache, 1);
+  if (error == FAT_OK)
+    fs->dir_block = block;
+
+  return error;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Clusters.
+
+static uint8_t valid_cluster(struct fat *fs, uint32_t cluster) {
+  return cluster >= 2 && cluster < fs->clusters + 2;
+}
+
+static uint32_t cluster_block(struct fat *fs, uint32_t cluster) {
+  return fs->data_start + ((cluster - 2) << fs->cluster_shift);
+}
+
+//Reads the FAT entry of a cluster (the next one in its chain).
+static int get_entry(struct fat *fs, uint32_t cluster, uint32_t *next) {
+  int error;
+
+  error = load_fat(fs, fs->fat_start + cluster / ENTRIES_PER_BLOCK);
+  if (error != FAT_OK)
+    return error;
+
+  *next = fs->fat_cache[cluster % ENTRIES_PER_BLOCK] & ENTRY_MASK;
+  return FAT_OK;
+}
+
+static int set_entry(struct fat *fs, uint32_t cluster, uint32_t next) {
+  uint32_t *entry;
+  int error;
+
+  error = load_fat(fs, fs->fat_start + cluster / ENTRIES_PER_BLOCK);
+  if (error != FAT_OK)
+    return error;
+
+  entry = &fs->fat_cache[cluster % ENTRIES_PER_BLOCK];
+  *entry = (*entry & ~ENTRY_MASK) | next;
+  fs->fat_dirty = 1;
+  return FAT_OK;
+}
+
+//Looks for a run of free clusters, from a given one on (wrapping around), optionally starting at
+//an erase unit boundary.
+static int find_run(struct fat *fs, uint32_t count, uint32_t from, uint8_t align,
+                    uint32_t *first) {
+  uint32_t erase = fs->device->erase_blocks, cluster = from, run = 0, start = 0, checked, next;
+  int error;
+
+  for (checked = 0; checked < fs->clusters; checked++, cluster++) {
+    if (!valid_cluster(fs, cluster)) {
+      cluster = 2;
+      run = 0;
+    }
+
+    if (run == 0 && align && erase > 0 && cluster_block(fs, cluster) % erase != 0)
+      continue;
+
+    error = get_entry(fs, cluster, &next);
+    if (error != FAT_OK)
+      return error;
+
+    if (next != ENTRY_FREE) {
+      run = 0;
+      continue;
+    }
+
+    if (run++ == 0)
+      start = cluster;
+    if (run == count) {
+      *first = start;
+      return FAT_OK;
+    }
+  }
+
+  return FAT_ERR_FULL;
+}
+
+//Allocates a chain of contiguous clusters, linked after a previous cluster if given (0 if not).
+//New files try to start at an erase unit boundary, and growing ones right after their end.
+static int allocate(struct fat *fs, uint32_t count, uint32_t previous, uint32_t *first) {
+  uint32_t cluster;
+  int error;
+
+  if (previous != 0)
+    error = find_run(fs, count, previous + 1, 0, first);
+  else {
+    error = find_run(fs, count, fs->next_free, 1, first);
+    if (error == FAT_ERR_FULL)
+      error = find_run(fs, count, fs->next_free, 0, first);
+  }
+  if (error != FAT_OK)
+    return error;
+
+  for (cluster = *first; cluster < *first + count; cluster++) {
+    error = set_entry(fs, cluster, cluster + 1 < *first + count ? cluster + 1 : ENTRY_END);
+    if (error != FAT_OK)
+      return error;
+  }
+
+  if (previous != 0) {
+    error = set_entry(fs, previous, *first);
+    if (error != FAT_OK)
+      return error;
+  }
+
+  if (fs->free_count != UNKNOWN)
+    fs->free_count -= count;
+  fs->next_free = *first + count;
+  fs->fsinfo_dirty = 1;
+  return FAT_OK;
+}
+
+//Frees a chain of clusters.
+static int free_chain(struct fat *fs, uint32_t cluster) {
+  uint32_t next, steps;
+  int error;
+
+  for (steps = 0; valid_cluster(fs, cluster); steps++) {
+    if (steps == fs->clusters)
+      return FAT_ERR_CORRUPT;
+
+    error = get_entry(fs, cluster, &next);
+    if (error == FAT_OK)
+      error = set_entry(fs, cluster, ENTRY_FREE);
+    if (error != FAT_OK)
+      return error;
+
+    if (fs->free_count != UNKNOWN)
+      fs->free_count++;
+    cluster = next;
+  }
+
+  fs->fsinfo_dirty = 1;
+  return FAT_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Directory.
+
+//Converts a name to the form stored in directory entries ("LOG.TXT" to "LOG     TXT").
+static int make_name(const char *name, uint8_t *entry_name) {
+  static const char invalid[] = "\"*+,./:;<=>?[\\]|";
+  uint8_t i = 0, end = 8;
+  char c;
+
+  memset(entry_name, ' ', 11);
+
+  for (; *name != '\0'; name++) {
+    c = *name;
+    if (c == '.' && end == 8 && i > 0) {
+      i = 8;
+      end = 11;
+      continue;
+    }
+
+    if (i == end || c <= ' ' || c >= 0x7F || strchr(invalid, c) != NULL)
+      return FAT_ERR_NAME;
+    entry_name[i++] = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+  }
+
+  return i > 0 ? FAT_OK : FAT_ERR_NAME;
+}
+
+//Looks for a file in the root directory. Returns FAT_OK with the location of its entry, or
+//FAT_ERR_NOT_FOUND with the location of a free entry (block 0 if the directory is full, along
+//with its last cluster).
+static int find_entry(struct fat *fs, const uint8_t *name, uint32_t *block, uint16_t *offset,
+                      uint32_t *last) {
+  uint32_t cluster = fs->root, next, steps, i;
+  uint16_t j;
+  uint8_t *entry;
+  int error;
+
+  *block = 0;
+
+  for (steps = 0; ; steps++) {
+    if (!valid_cluster(fs, cluster) || steps == fs->clusters)
+      return FAT_ERR_CORRUPT;
+
+    for (i = cluster_block(fs, cluster); i < cluster_block(fs, cluster + 1); i++) {
+      error = load_dir(fs, i);
+      if (error != FAT_OK)
+        return error;
+
+      for (j = 0; j < FAT_BLOCK_SIZE; j += DIR_ENTRY_SIZE) {
+        entry = (uint8_t *) fs->dir_cache + j;
+
+        if (entry[0] == DIR_END || entry[0] == DIR_DELETED) {
+          if (*block == 0) {
+            *block = i;
+            *offset = j;
+          }
+          if (entry[0] == DIR_END)
+            return FAT_ERR_NOT_FOUND;
+          continue;
+        }
+
+        if ((entry[11] & ATTR_LONG_NAME) == ATTR_LONG_NAME ||
+            (entry[11] & (ATTR_VOLUME | ATTR_DIRECTORY)))
+          continue;
+
+        if (memcmp(entry, name, 11) == 0) {
+          *block = i;
+          *offset = j;
+          return FAT_OK;
+        }
+      }
+    }
+
+    error = get_entry(fs, cluster, &next);
+    if (error != FAT_OK)
+      return error;
+    if (next >= ENTRY_LAST) {
+      *last = cluster;
+      return FAT_ERR_NOT_FOUND;
+    }
+    cluster = next;
+  }
+}
+
+//Looks for a file, getting its entry into the directory cache.
+static int open_entry(struct fat *fs, const char *name, uint32_t *block, uint16_t *offset) {
+  uint8_t entry_name[11];
+  uint32_t last;
+  int error;
+
+  error = make_name(name, entry_name);
+  if (error != FAT_OK)
+    return error;
+
+  error = find_entry(fs, entry_name, block, offset, &last);
+  if (error == FAT_OK)
+    error = load_dir(fs, *block);
+
+  return error;
+}
+
+//Adds a cluster to the root directory, cleared.
+static int grow_directory(struct fat *fs, uint32_t last, uint32_t *block) {
+  uint32_t cluster, i;
+  int error;
+
+  error = allocate(fs, 1, last, &cluster);
+  if (error == FAT_OK)
+    error = flush_dir(fs);
+  if (error != FAT_OK)
+    return error;
+
+  //The cache ends up holding the last block of the cluster, and the new entry goes to the first.
+  memset(fs->dir_cache, 0, FAT_BLOCK_SIZE);
+  fs->dir_block = NONE;
+  for (i = cluster_block(fs, cluster); i < cluster_block(fs, cluster + 1); i++) {
+    error = device_write(fs, i, fs->dir_cache, 1);
+    if (error != FAT_OK)
+      return error;
+  }
+  fs->dir_block = i - 1;
+
+  *block = cluster_block(fs, cluster);
+  return FAT_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Files.
+
+static void init_file(struct fat_file *f, struct fat *fs, uint32_t block, uint16_t offset,
+                      uint32_t first, uint32_t size) {
+  f->fs = fs;
+  f->entry_block = block;
+  f->entry_offset = offset;
+  f->first = first;
+  f->size = size;
+  f->position = 0;
+  f->extent = first;
+  f->extent_index = 0;
+  f->extent_length = 0;
+  f->buffer_offset = 0;
+  f->buffered = 0;
+}
+
+//Finds the device block holding a file offset, and how many blocks from it are contiguous on the
+//device. The file is followed a run of contiguous clusters (an extent) at a time, so reading the
+//FAT takes one lookup per cluster at most, and none within runs known already (a file just
+//created is a single run). Files being written grow as needed.
+static int locate(struct fat_file *f, uint32_t offset, uint32_t *block, uint32_t *count) {
+  struct fat *fs = f->fs;
+  uint32_t index = offset >> (fs->cluster_shift + 9), last, next, within, grow;
+  int error;
+
+  if (index < f->extent_index) {
+    f->extent = f->first;
+    f->extent_index = 0;
+    f->extent_length = 0;
+  }
+
+  while (index >= f->extent_index + f->extent_length) {
+    if (f->extent_length == 0) {
+      if (!valid_cluster(fs, f->extent))
+        return FAT_ERR_CORRUPT;
+      f->extent_length = 1;
+      continue;
+    }
+
+    last = f->extent + f->extent_length - 1;
+    error = get_entry(fs, last, &next);
+    if (error != FAT_OK)
+      return error;
+
+    if (next == last + 1 && valid_cluster(fs, next))
+      f->extent_length++;
+    else if (next >= ENTRY_LAST) {
+      if (!f->writing)
+        return FAT_ERR_CORRUPT;
+
+      //Grow the file, a single cluster if there's no longer run available.
+      grow = FAT_GROW_CLUSTERS;
+      error = allocate(fs, grow, last, &next);
+      if (error == FAT_ERR_FULL) {
+        grow = 1;
+        error = allocate(fs, grow, last, &next);
+      }
+      if (error != FAT_OK)
+        return error;
+
+      if (next != last + 1) {
+        f->extent_index += f->extent_length;
+        f->extent = next;
+        f->extent_length = 0;
+      }
+      f->extent_length += grow;
+    }
+    else if (valid_cluster(fs, next)) {
+      f->extent_index += f->extent_length;
+      f->extent = next;
+      f->extent_length = 0;
+    }
+    else
+      return FAT_ERR_CORRUPT;
+  }
+
+  //Extend the run as far as the cached FAT sector tells, at no cost.
+  while (1) {
+    last = f->extent + f->extent_length - 1;
+    if (fs->fat_block != fs->fat_start + last / ENTRIES_PER_BLOCK || last + 1 >= fs->clusters + 2 ||
+        (fs->fat_cache[last % ENTRIES_PER_BLOCK] & ENTRY_MASK) != last + 1)
+      break;
+    f->extent_length++;
+  }
+
+  within = (offset >> 9) & ((1 << fs->cluster_shift) - 1);
+  *block = cluster_block(fs, f->extent + index - f->extent_index) + within;
+  *count = ((f->extent_length - (index - f->extent_index)) << fs->cluster_shift) - within;
+  return FAT_OK;
+}
+
+//Writes blocks of a file from a block aligned offset, in as few transfers as its extents, the
+//device limit and the erase units allow.
+static int write_blocks(struct fat_file *f, uint32_t offset, const uint8_t *data, uint32_t count) {
+  struct fat *fs = f->fs;
+  uint32_t erase = fs->device->erase_blocks, block, run;
+  int error;
+
+  while (count > 0) {
+    error = locate(f, offset, &block, &run);
+    if (error != FAT_OK)
+      return error;
+
+    if (run > count)
+      run = count;
+    if (run > fs->device->max_blocks)
+      run = fs->device->max_blocks;
+    if (erase > 0 && run > erase - block % erase)
+      run = erase - block % erase;
+
+    error = device_write(fs, block, data, run);
+    if (error != FAT_OK)
+      return error;
+
+    offset += run * FAT_BLOCK_SIZE;
+    data += run * FAT_BLOCK_SIZE;
+    count -= run;
+  }
+
+  return FAT_OK;
+}
+
+//Writes what's in the buffer, keeping the last block if partial (it's written whole again as it
+//fills up).
+static int write_buffer(struct fat_file *f) {
+  uint32_t whole = f->buffered / FAT_BLOCK_SIZE * FAT_BLOCK_SIZE;
+  int error;
+
+  if (f->buffered == 0)
+    return FAT_OK;
+
+  error = write_blocks(f, f->buffer_offset, (const uint8_t *) f->buffer,
+                       (f->buffered + FAT_BLOCK_SIZE - 1) / FAT_BLOCK_SIZE);
+  if (error != FAT_OK)
+    return error;
+
+  if (whole > 0 && whole < f->buffered)
+    memmove(f->buffer, (uint8_t *) f->buffer + whole, f->buffered - whole);
+  f->buffer_offset += whole;
+  f->buffered -= whole;
+  return FAT_OK;
+}
+
+//Updates the directory entry of a file being written.
+static int update_entry(struct fat_file *f) {
+  struct fat *fs = f->fs;
+  uint8_t *entry;
+  int error;
+
+  error = load_dir(fs, f->entry_block);
+  if (error != FAT_OK)
+    return error;
+
+  entry = (uint8_t *) fs->dir_cache + f->entry_offset;
+  put16(entry + 20, f->first >> 16);
+  put16(entry + 22, fs->time);
+  put16(entry + 24, fs->date);
+  put16(entry + 26, f->first);
+  put32(entry + 28, f->size);
+  fs->dir_dirty = 1;
+  return FAT_OK;
+}
+
+//Tells whether a block is the boot sector of a FAT32 volume: it starts with a jump and has 512
+//byte sectors, no fixed root directory and no 16 bit FAT size.
+static uint8_t volume_boot(const uint8_t *block) {
+  return get16(block + 510) == BOOT_SIGNATURE && (block[0] == 0xEB || block[0] == 0xE9) &&
+         get16(block + 11) == FAT_BLOCK_SIZE && get16(block + 17) == 0 && get16(block + 22) == 0 &&
+         get32(block + 36) != 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Interface.
+
+//Mounts the FAT32 volume of a device: the whole device, or its first FAT32 partition.
+int fat_mount(struct fat *fs, const struct fat_device *device) {
+  uint8_t *block = (uint8_t *) fs->dir_cache;
+  uint32_t volume = 0, total, reserved, cluster_blocks, i;
+  int error;
+
+  fs->device = device;
+  fs->fat_block = NONE;
+  fs->dir_block = NONE;
+  fs->fat_dirty = 0;
+  fs->dir_dirty = 0;
+  fs->fsinfo_dirty = 0;
+  fs->reads = 0;
+  fs->writes = 0;
+  fs->largest_write = 0;
+  fat_set_time(fs, 2020, 1, 1, 0, 0, 0);
+
+  error = device_read(fs, 0, block, 1);
+  if (error != FAT_OK)
+    return error;
+
+  //Without a volume at the start, it's a master boot record. Look for a FAT32 partition.
+  if (!volume_boot(block)) {
+    for (i = 0; i < 4; i++) {
+      if (get16(block + 510) == BOOT_SIGNATURE && (block[450 + 16 * i] == PARTITION_FAT32 ||
+                                                   block[450 + 16 * i] == PARTITION_FAT32_LBA))
+        break;
+    }
+    if (i == 4)
+      return FAT_ERR_FORMAT;
+
+    volume = get32(block + 454 + 16 * i);
+    error = device_read(fs, volume, block, 1);
+    if (error != FAT_OK)
+      return error;
+    if (!volume_boot(block))
+      return FAT_ERR_FORMAT;
+  }
+
+  cluster_blocks = block[13];
+  reserved = get16(block + 14);
+  fs->fats = block[16];
+  fs->fat_blocks = get32(block + 36);
+  total = get16(block + 19) ? get16(block + 19) : get32(block + 32);
+
+  for (fs->cluster_shift = 0; (1u << fs->cluster_shift) < cluster_blocks; fs->cluster_shift++);
+  if (cluster_blocks == 0 || (1u << fs->cluster_shift) != cluster_blocks || fs->fats == 0 ||
+      total <= reserved + fs->fats * fs->fat_blocks || volume >= device->blocks ||
+      total > device->blocks - volume)
+    return FAT_ERR_FORMAT;
+
+  fs->fat_start = volume + reserved;
+  fs->data_start = fs->fat_start + fs->fats * fs->fat_blocks;
+  fs->clusters = (total - reserved - fs->fats * fs->fat_blocks) >> fs->cluster_shift;
+  if (fs->clusters > fs->fat_blocks * ENTRIES_PER_BLOCK - 2)
+    fs->clusters = fs->fat_blocks * ENTRIES_PER_BLOCK - 2;
+
+  fs->root = get32(block + 44);
+  if (!valid_cluster(fs, fs->root))
+    return FAT_ERR_FORMAT;
+
+  //Take the free cluster count and hint from the FSInfo sector, if there's one.
+  fs->fsinfo = get16(block + 48);
+  fs->free_count = UNKNOWN;
+  fs->next_free = 2;
+  if (fs->fsinfo == 0 || fs->fsinfo == 0xFFFF)
+    fs->fsinfo = 0;
+  else {
+    fs->fsinfo += volume;
+    error = device_read(fs, fs->fsinfo, block, 1);
+    if (error != FAT_OK)
+      return error;
+
+    if (get32(block) == FSINFO_LEAD && get32(block + 484) == FSINFO_STRUCT) {
+      if (get32(block + 488) <= fs->clusters)
+        fs->free_count = get32(block + 488);
+      if (valid_cluster(fs, get32(block + 492)))
+        fs->next_free = get32(block + 492);
+    }
+    else
+      fs->fsinfo = 0;
+  }
+
+  return FAT_OK;
+}
+
+//Sets the timestamp given to files created or written from now on.
+void fat_set_time(struct fat *fs, uint16_t year, uint8_t month, uint8_t day, uint8_t hour,
+                  uint8_t minute, uint8_t second) {
+  fs->date = ((year - 1980) << 9) | (month << 5) | day;
+  fs->time = (hour << 11) | (minute << 5) | (second / 2);
+}
+
+//Creates a file for writing, with the given size (in bytes) pre-allocated in contiguous clusters.
+//Fails with FAT_ERR_FULL if there's no such run of free clusters.
+int fat_create(struct fat *fs, struct fat_file *f, const char *name, uint32_t size) {
+  uint32_t cluster_size = FAT_BLOCK_SIZE << fs->cluster_shift, clusters, block, last, first;
+  uint8_t entry_name[11];
+  uint16_t offset = 0;
+  uint8_t *entry;
+  int error;
+
+  error = make_name(name, entry_name);
+  if (error != FAT_OK)
+    return error;
+
+  error = find_entry(fs, entry_name, &block, &offset, &last);
+  if (error == FAT_OK)
+    return FAT_ERR_EXISTS;
+  if (error != FAT_ERR_NOT_FOUND)
+    return error;
+
+  clusters = size > 0 ? (size - 1) / cluster_size + 1 : 1;
+  error = allocate(fs, clusters, 0, &first);
+  if (error != FAT_OK)
+    return error;
+
+  if (block == 0)
+    error = grow_directory(fs, last, &block);
+  if (error == FAT_OK)
+    error = load_dir(fs, block);
+  if (error != FAT_OK) {
+    free_chain(fs, first);
+    return error;
+  }
+
+  entry = (uint8_t *) fs->dir_cache + offset;
+  memset(entry, 0, DIR_ENTRY_SIZE);
+  memcpy(entry, entry_name, 11);
+  entry[11] = ATTR_ARCHIVE;
+  put16(entry + 14, fs->time);
+  put16(entry + 16, fs->date);
+  put16(entry + 18, fs->date);
+  fs->dir_dirty = 1;
+
+  init_file(f, fs, block, offset, first, 0);
+  f->writing = 1;
+  f->extent_length = clusters;
+
+  //Make the file exist on the card, in case of reset before the first sync.
+  error = update_entry(f);
+  if (error == FAT_OK)
+    error = fat_flush(fs);
+
+  return error;
+}
+
+//Opens a file for reading.
+int fat_open(struct fat *fs, struct fat_file *f, const char *name) {
+  uint32_t block;
+  uint16_t offset;
+  uint8_t *entry;
+  int error;
+
+  error = open_entry(fs, name, &block, &offset);
+  if (error != FAT_OK)
+    return error;
+
+  entry = (uint8_t *) fs->dir_cache + offset;
+  init_file(f, fs, block, offset, ((uint32_t) get16(entry + 20) << 16) | get16(entry + 26),
+            get32(entry + 28));
+  f->writing = 0;
+  return FAT_OK;
+}
+
+//Opens a file for writing at its end. A partial last block is read back into the buffer, to be
+//written whole again along with what follows.
+int fat_append(struct fat *fs, struct fat_file *f, const char *name) {
+  uint32_t block, count, grow = FAT_GROW_CLUSTERS;
+  int error;
+
+  error = fat_open(fs, f, name);
+  if (error != FAT_OK)
+    return error;
+
+  f->writing = 1;
+  f->position = f->size;
+  f->buffer_offset = f->size & ~(FAT_BLOCK_SIZE - 1);
+  f->buffered = f->size - f->buffer_offset;
+
+  //Empty files have no clusters yet.
+  if (f->first == 0) {
+    error = allocate(fs, grow, 0, &f->first);
+    if (error == FAT_ERR_FULL) {
+      grow = 1;
+      error = allocate(fs, grow, 0, &f->first);
+    }
+    if (error != FAT_OK)
+      return error;
+
+    f->extent = f->first;
+    f->extent_length = grow;
+    return FAT_OK;
+  }
+
+  if (f->buffered == 0)
+    return FAT_OK;
+
+  error = locate(f, f->buffer_offset, &block, &count);
+  if (error == FAT_OK)
+    error = device_read(fs, block, f->buffer, 1);
+
+  return error;
+}
+
+//Deletes a file.
+int fat_remove(struct fat *fs, const char *name) {
+  uint32_t block;
+  uint16_t offset;
+  uint8_t *entry;
+  int error;
+
+  error = open_entry(fs, name, &block, &offset);
+  if (error != FAT_OK)
+    return error;
+
+  entry = (uint8_t *) fs->dir_cache + offset;
+  entry[0] = DIR_DELETED;
+  fs->dir_dirty = 1;
+
+  error = free_chain(fs, ((uint32_t) get16(entry + 20) << 16) | get16(entry + 26));
+  if (error != FAT_OK)
+    return error;
+
+  return fat_flush(fs);
+}
+
+//Appends data to a file being written.
+int fat_write(struct fat_file *f, const void *data, uint32_t length) {
+  const uint8_t *src = data;
+  uint32_t count;
+  int error;
+
+  if (!f->writing)
+    return FAT_ERR_MODE;
+  if (length > 0xFFFFFFFF - f->position)
+    return FAT_ERR_FULL;
+
+  while (length > 0) {
+    //Writes of a buffer or more from word aligned data go straight to the device, when the buffer
+    //is empty (and so the file ends at a block boundary). Smaller ones are gathered in the buffer.
+    if (f->buffered == 0 && length >= BUFFER_SIZE && ((uintptr_t) src & 3) == 0) {
+      count = length / FAT_BLOCK_SIZE;
+      error = write_blocks(f, f->position, src, count);
+      if (error != FAT_OK)
+        return error;
+
+      count *= FAT_BLOCK_SIZE;
+      f->position += count;
+      f->size = f->position;
+      f->buffer_offset = f->position;
+      src += count;
+      length -= count;
+      continue;
+    }
+
+    count = BUFFER_SIZE - f->buffered;
+    if (count > length)
+      count = length;
+    memcpy((uint8_t *) f->buffer + f->buffered, src, count);
+    f->buffered += count;
+    f->position += count;
+    f->size = f->position;
+    src += count;
+    length -= count;
+
+    if (f->buffered == BUFFER_SIZE) {
+      error = write_buffer(f);
+      if (error != FAT_OK)
+        return error;
+    }
+  }
+
+  return FAT_OK;
+}
+
+//Reads data from a file. Returns the number of bytes read (less than asked for at the end of the
+//file), or an error code.
+int32_t fat_read(struct fat_file *f, void *data, uint32_t length) {
+  struct fat *fs = f->fs;
+  uint8_t *dst = data;
+  uint32_t done = 0, block, count, skip;
+  int error;
+
+  if (f->writing)
+    return FAT_ERR_MODE;
+  if (length > f->size - f->position)
+    length = f->size - f->position;
+  if (length > 0x7FFFFFFF)
+    length = 0x7FFFFFFF;
+
+  while (done < length) {
+    //Data in the buffer.
+    if (f->position >= f->buffer_offset && f->position < f->buffer_offset + f->buffered) {
+      skip = f->position - f->buffer_offset;
+      count = f->buffered - skip;
+      if (count > length - done)
+        count = length - done;
+
+      memcpy(dst + done, (uint8_t *) f->buffer + skip, count);
+      f->position += count;
+      done += count;
+      continue;
+    }
+
+    error = locate(f, f->position & ~(FAT_BLOCK_SIZE - 1), &block, &count);
+    if (error != FAT_OK)
+      return error;
+    if (count > fs->device->max_blocks)
+      count = fs->device->max_blocks;
+
+    //Whole blocks go straight to word aligned buffers.
+    if ((f->position & (FAT_BLOCK_SIZE - 1)) == 0 && length - done >= FAT_BLOCK_SIZE &&
+        ((uintptr_t) (dst + done) & 3) == 0) {
+      if (count > (length - done) / FAT_BLOCK_SIZE)
+        count = (length - done) / FAT_BLOCK_SIZE;
+
+      error = device_read(fs, block, dst + done, count);
+      if (error != FAT_OK)
+        return error;
+
+      f->position += count * FAT_BLOCK_SIZE;
+      done += count * FAT_BLOCK_SIZE;
+      continue;
+    }
+
+    //Otherwise, fill the buffer.
+    if (count > FAT_BUFFER_BLOCKS)
+      count = FAT_BUFFER_BLOCKS;
+
+    f->buffered = 0;
+    error = device_read(fs, block, f->buffer, count);
+    if (error != FAT_OK)
+      return error;
+    f->buffer_offset = f->position & ~(FAT_BLOCK_SIZE - 1);
+    f->buffered = count * FAT_BLOCK_SIZE;
+  }
+
+  return done;
+}
+
+//Finds the device block holding a file offset, and how many blocks from it are contiguous, for
+//callers moving file data on their own (with background transfers, for instance). Files being
+//written grow to cover the offset.
+int fat_map(struct fat_file *f, uint32_t offset, uint32_t *block, uint32_t *count) {
+  return locate(f, offset, block, count);
+}
+
+//Sets the size of a file written through fat_map(), up to which its data is on the device. Such
+//files take no fat_write() calls, since the buffer no longer follows the end of the file.
+int fat_set_size(struct fat_file *f, uint32_t size) {
+  if (!f->writing)
+    return FAT_ERR_MODE;
+
+  f->size = size;
+  f->position = size;
+  f->buffer_offset = size;
+  f->buffered = 0;
+  return FAT_OK;
+}
+
+//Writes the data of a file buffered so far, and its size, so it's safe on the card.
+int fat_sync(struct fat_file *f) {
+  int error;
+
+  if (!f->writing)
+    return FAT_OK;
+
+  error = write_buffer(f);
+  if (error == FAT_OK)
+    error = update_entry(f);
+  if (error == FAT_OK)
+    error = fat_flush(f->fs);
+
+  return error;
+}
+
+//Closes a file. Files being written are synced, and their clusters past the end freed.
+int fat_close(struct fat_file *f) {
+  struct fat *fs = f->fs;
+  uint32_t used, block, count, cluster = 0, next = ENTRY_END;
+  int error;
+
+  if (!f->writing)
+    return FAT_OK;
+
+  error = write_buffer(f);
+  if (error != FAT_OK)
+    return error;
+
+  used = f->size > 0 ? ((f->size - 1) >> (fs->cluster_shift + 9)) + 1 : 0;
+  if (used == 0) {
+    error = free_chain(fs, f->first);
+    f->first = 0;
+  }
+  else {
+    //Find the last cluster used, and end the chain there.
+    error = locate(f, (used - 1) << (fs->cluster_shift + 9), &block, &count);
+    if (error == FAT_OK) {
+      cluster = f->extent + (used - 1) - f->extent_index;
+      error = get_entry(fs, cluster, &next);
+    }
+    if (error == FAT_OK && next < ENTRY_LAST) {
+      error = set_entry(fs, cluster, ENTRY_END);
+      if (error == FAT_OK)
+        error = free_chain(fs, next);
+    }
+  }
+  if (error != FAT_OK)
+    return error;
+
+  f->writing = 0;
+  f->extent_length = 0;
+  f->extent = f->first;
+  f->extent_index = 0;
+
+  error = update_entry(f);
+  if (error == FAT_OK)
+    error = fat_flush(fs);
+
+  return error;
+}
+
+//Writes back everything cached for the volume.
+int fat_flush(struct fat *fs) {
+  uint8_t *block = (uint8_t *) fs->dir_cache;
+  int error;
+
+  error = flush_fat(fs);
+  if (error == FAT_OK)
+    error = flush_dir(fs);
+  if (error != FAT_OK || !fs->fsinfo_dirty)
+    return error;
+
+  if (fs->fsinfo != 0) {
+    error = load_dir(fs, fs->fsinfo);
+    if (error != FAT_OK)
+      return error;
+
+    put32(block + 488, fs->free_count);
+    put32(block + 492, fs->next_free);
+    error = device_write(fs, fs->fsinfo, block, 1);
+    if (error != FAT_OK)
+      return error;
+  }
+
+  fs->fsinfo_dirty = 0;
+  return FAT_OK;
+}
@@ -0,0 +1,134 @@
+//+------------------------------------------------------------------------------------------------+
+//| FAT32 file system for logging.                                                                 |
+//|                                                                                                |
+//| Reads and writes files in the root directory of a FAT32 volume (a card formatted on a PC, as a |
+//| whole or as its first FAT32 partition), with 8.3 names. It's meant for logs written at high    |
+//| rates and read on a PC later, so writes avoid what makes simple implementations slow:          |
+//| - Files are created with their expected size pre-allocated as a single run of clusters,        |
+//|   starting at an erase unit boundary of the card when possible. Writing within it touches no   |
+//|   FAT sector, and the file grows past it a run of FAT_CONF_GROW_CLUSTERS at a time.            |
+//| - Data is written with multiple block transfers, up to the device limit, split at erase unit   |
+//|   boundaries. Small writes are gathered in a per file buffer of FAT_CONF_BUFFER_BLOCKS blocks, |
+//|   and larger ones from word aligned data go straight to the device.                            |
+//| - A FAT sector and a directory sector are cached, and written back (along with the FSInfo free |
+//|   cluster count) when the cache moves to another sector, or on fat_sync() and fat_close().     |
+//|                                                                                                |
+//| With a pre-allocated file, each fat_write() call does no I/O other than writing its data, so   |
+//| its latency is bounded by the card's write time for the blocks involved. Creating, growing     |
+//| and closing files search and update the FAT, and take longer.                                  |
+//|                                                                                                |
+//| Sizes are updated in the directory on fat_sync() and fat_close(), which also frees clusters    |
+//| pre-allocated past the end of the file. After a reset without close, the file keeps its size   |
+//| at the last sync, and the clusters past it stay allocated until a PC checks the volume.        |
+//|                                                                                                |
+//| Files are read sequentially, whole blocks going straight to word aligned buffers as well.      |
+//| Each open file takes FAT_CONF_BUFFER_BLOCKS blocks of RAM, and the volume about 1KB.           |
+//|                                                                                                |
+//| Files can also be appended to, and callers with their own buffering can move the data of a     |
+//| file themselves, with fat_map() giving the device blocks of each offset.                       |
+//|                                                                                                |
+//| This module doesn't depend on contiki, so it builds on the host as is.                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef FAT_H_
+#define FAT_H_
+
+#include <stdint.h>
+
+#define FAT_BLOCK_SIZE 512
+
+//Size of the file buffers, in blocks.
+#ifdef FAT_CONF_BUFFER_BLOCKS
+#define FAT_BUFFER_BLOCKS FAT_CONF_BUFFER_BLOCKS
+#else
+#define FAT_BUFFER_BLOCKS 8
+#endif
+
+//Clusters allocated at a time by files growing past their pre-allocated size.
+#ifdef FAT_CONF_GROW_CLUSTERS
+#define FAT_GROW_CLUSTERS FAT_CONF_GROW_CLUSTERS
+#else
+#define FAT_GROW_CLUSTERS 16
+#endif
+
+//Error codes.
+#define FAT_OK              0
+#define FAT_ERR_IO          -1  //Device read or write failed
+#define FAT_ERR_FORMAT      -2  //No FAT32 volume on the device
+#define FAT_ERR_NOT_FOUND   -3  //No such file
+#define FAT_ERR_EXISTS      -4  //File exists already
+#define FAT_ERR_FULL        -5  //No room for the file (or for the pre-allocated size, contiguous)
+#define FAT_ERR_NAME        -6  //Invalid 8.3 name
+#define FAT_ERR_CORRUPT     -7  //Broken cluster chain
+#define FAT_ERR_MODE        -8  //Write to a file open for reading, or the other way around
+
+//Block device. The functions take device block numbers and return 0 on success (the sdcard
+//driver functions can be used as they are). Buffers passed are word aligned.
+struct fat_device {
+  int (* read)(uint32_t block, void *buffer, uint16_t count);
+  int (* write)(uint32_t block, const void *buffer, uint16_t count);
+  uint32_t blocks;
+  uint16_t max_blocks;            //Most blocks per transfer
+  uint32_t erase_blocks;          //Erase unit size, to align files and split writes (0 if unknown)
+};
+
+struct fat {
+  const struct fat_device *device;
+  uint32_t fat_start;             //First block of the first FAT
+  uint32_t fat_blocks;            //Blocks per FAT
+  uint32_t data_start;            //First block of cluster 2
+  uint32_t clusters;              //Data clusters (numbered from 2)
+  uint32_t root;                  //First cluster of the root directory
+  uint32_t fsinfo;                //FSInfo block (0 if none)
+  uint32_t free_count;            //Free clusters (0xFFFFFFFF if unknown)
+  uint32_t next_free;             //Where to start looking for free clusters
+  uint8_t cluster_shift;          //Blocks per cluster, as a power of 2
+  uint8_t fats;
+  uint16_t date;                  //Timestamp of files created and written, in FAT format
+  uint16_t time;
+  uint32_t fat_block;             //Blocks held by the caches
+  uint32_t dir_block;
+  uint8_t fat_dirty;
+  uint8_t dir_dirty;
+  uint8_t fsinfo_dirty;
+  uint32_t reads;                 //Device transfers so far, and the largest write in blocks
+  uint32_t writes;
+  uint32_t largest_write;
+  uint32_t fat_cache[FAT_BLOCK_SIZE / 4];
+  uint32_t dir_cache[FAT_BLOCK_SIZE / 4];
+};
+
+struct fat_file {
+  struct fat *fs;
+  uint8_t writing;
+  uint32_t entry_block;           //Directory entry location
+  uint16_t entry_offset;
+  uint32_t first;                 //First cluster (0 if empty)
+  uint32_t size;
+  uint32_t position;
+  uint32_t extent;                //Run of contiguous clusters holding the position: its first
+  uint32_t extent_index;          //cluster, the index of it in the file, and its length
+  uint32_t extent_length;
+  uint32_t buffer_offset;         //File offset of the buffer, and bytes in it
+  uint32_t buffered;
+  uint32_t buffer[FAT_BUFFER_BLOCKS * FAT_BLOCK_SIZE / 4];
+};
+
+int fat_mount(struct fat *fs, const struct fat_device *device);
+void fat_set_time(struct fat *fs, uint16_t year, uint8_t month, uint8_t day, uint8_t hour,
+                  uint8_t minute, uint8_t second);
+int fat_create(struct fat *fs, struct fat_file *f, const char *name, uint32_t size);
+int fat_open(struct fat *fs, struct fat_file *f, const char *name);
+int fat_append(struct fat *fs, struct fat_file *f, const char *name);
+int fat_remove(struct fat *fs, const char *name);
+int fat_write(struct fat_file *f, const void *data, uint32_t length);
+int32_t fat_read(struct fat_file *f, void *data, uint32_t length);
+int fat_map(struct fat_file *f, uint32_t offset, uint32_t *block, uint32_t *count);
+int fat_set_size(struct fat_file *f, uint32_t size);
+int fat_sync(struct fat_file *f);
+int fat_close(struct fat_file *f);
+int fat_flush(struct fat *fs);
+
+#endif //FAT_H_
@@ -0,0 +1,149 @@
+//+------------------------------------------------------------------------------------------------+
+//| Addressable LED strip (WS2812/SK6812) driver.                                                  |
+//|                                                                                                |
+//| This part keeps the frames and encodes them, while the CPU part moves the encoded bits to the  |
+//| SPI. Its interrupts take the SPI bits of the frame bytes one at a time, and once the frame is  |
+//| over get zeros, whose low level is the latch (reset) time of the LEDs. When enough of it has   |
+//| been sent, they stop the transfer and report the strip done, which the driver process forwards |
+//| to the process that showed the frame.                                                          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "led-strip.h"
+
+//Zero bytes sent after a frame, to hold the line low for at least 300us (the latch time of the
+//slowest LEDs). Each byte takes 32 SPI bits.
+#define RESET_BYTES ((300 * (LED_STRIP_ARCH_BIT_RATE / 1000) / 32 + 999) / 1000)
+
+//SPI bit patterns for every possible nibble (4 data bits, MSB first).
+static const uint16_t patterns[16] = {
+  0x8888, 0x888E, 0x88E8, 0x88EE, 0x8E88, 0x8E8E, 0x8EE8, 0x8EEE,
+  0xE888, 0xE88E, 0xE8E8, 0xE8EE, 0xEE88, 0xEE8E, 0xEEE8, 0xEEEE,
+};
+
+//Strips set up on every chain.
+static struct led_strip *strips[LED_STRIP_CHAINS];
+
+process_event_t led_strip_event_done;
+
+PROCESS(led_strip_process, "LED strip");
+
+//Configures a strip on the given output chain. Both buffers must hold pixels * bytes_per_pixel
+//bytes (3 for RGB strips, 4 for RGBW ones), in the order the LEDs expect them (GRB or GRBW for the
+//usual parts). Returns -1 if the CPU has no such chain.
+int led_strip_init(struct led_strip *strip, uint8_t chain, uint8_t *buffer_a, uint8_t *buffer_b,
+                   uint16_t pixels, uint8_t bytes_per_pixel) {
+  if (chain >= LED_STRIP_CHAINS)
+    return -1;
+
+  strip->chain = chain;
+  strip->buffers[0] = buffer_a;
+  strip->buffers[1] = buffer_b;
+  strip->back = 0;
+  strip->length = pixels * bytes_per_pixel;
+  strip->pixel_size = bytes_per_pixel;
+  strip->busy = 0;
+  strip->done = 0;
+  strip->requester = NULL;
+  strips[chain] = strip;
+
+  if (led_strip_event_done == 0) {
+    led_strip_event_done = process_alloc_event();
+    process_start(&led_strip_process, NULL);
+  }
+
+  led_strip_arch_init(strip);
+
+  return 0;
+}
+
+//Returns the buffer to draw the next frame into.
+uint8_t *led_strip_buffer(struct led_strip *strip) {
+  return strip->buffers[strip->back];
+}
+
+//Sets a pixel of the back buffer, in GRB(W) order. The white value is ignored on RGB strips.
+void led_strip_set_pixel(struct led_strip *strip, uint16_t index, uint8_t r, uint8_t g, uint8_t b,
+                         uint8_t w) {
+  uint8_t *pixel = &strip->buffers[strip->back][index * strip->pixel_size];
+
+  pixel[0] = g;
+  pixel[1] = r;
+  pixel[2] = b;
+  if (strip->pixel_size > 3)
+    pixel[3] = w;
+}
+
+//Starts sending the back buffer, and swaps the buffers. Returns -1 if the previous frame is still
+//being sent.
+int led_strip_show(struct led_strip *strip) {
+  if (strip->busy)
+    return -1;
+
+  strip->busy = 1;
+  strip->requester = PROCESS_CURRENT();
+  strip->source = strip->buffers[strip->back];
+  strip->back ^= 1;
+  strip->position = 0;
+  strip->reset_sent = 0;
+
+  led_strip_arch_start(strip);
+
+  return 0;
+}
+
+int led_strip_busy(struct led_strip *strip) {
+  return strip->busy;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Returns the SPI bits of the next frame byte (32 bits, sent MSB first), or zeros past the end of
+//the frame.
+uint32_t led_strip_encode(struct led_strip *strip) {
+  uint8_t data;
+
+  if (strip->position < strip->length) {
+    data = strip->source[strip->position++];
+    return ((uint32_t) patterns[data >> 4] << 16) | patterns[data & 0x0F];
+  }
+
+  strip->reset_sent++;
+  return 0;
+}
+
+//Returns 1 once the bits taken so far cover the latch time after the frame.
+int led_strip_latched(struct led_strip *strip) {
+  return strip->reset_sent >= RESET_BYTES;
+}
+
+//Marks the frame of a strip as sent.
+void led_strip_done(struct led_strip *strip) {
+  strip->busy = 0;
+  strip->done = 1;
+  process_poll(&led_strip_process);
+}
+
+//Forwards the end of frame notifications from interrupt context.
+PROCESS_THREAD(led_strip_process, ev, data) {
+  uint8_t i;
+
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    for (i = 0; i < LED_STRIP_CHAINS; i++) {
+      if (strips[i] != NULL && strips[i]->done) {
+        strips[i]->done = 0;
+        if (strips[i]->requester != NULL)
+          process_post(strips[i]->requester, led_strip_event_done, strips[i]);
+      }
+    }
+  }
+
+  PROCESS_END();
+}
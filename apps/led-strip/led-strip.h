@@ -0,0 +1,66 @@
+//+------------------------------------------------------------------------------------------------+
+//| Addressable LED strip (WS2812/SK6812) driver.                                                  |
+//|                                                                                                |
+//| The single wire protocol of these LEDs is generated by an SPI module: every data bit is sent   |
+//| as 4 SPI bits (1000 for a 0, 1110 for a 1), so only the MOSI pin is used. Pixel data is        |
+//| encoded on the fly into a small ping-pong buffer that DMA streams to the SPI, which keeps the  |
+//| memory cost at one byte per color channel regardless of the strip length. The SPI and DMA side |
+//| is implemented by every CPU (led-strip-arch.c), which also sets the available output chains    |
+//| (LED_STRIP_CHAINS) and their pins.                                                             |
+//|                                                                                                |
+//| Frames are double buffered: the application draws into the back buffer while the front one is  |
+//| being sent, and swaps them with led_strip_show(). Once a frame (including the latch time) has  |
+//| been sent, led_strip_event_done is posted to the process that showed it, with the strip as     |
+//| data.                                                                                          |
+//|                                                                                                |
+//| Sending takes 27 to 32us per RGB pixel (36 to 43us per RGBW pixel), depending on the SPI clock |
+//| of the CPU, so a chain refreshed at 60 fps holds about 500 to 600 pixels (see the figures in   |
+//| led-strip-arch.h). Longer installations are split over several chains, which send in parallel: |
+//| every chain can take a slice of the same frame buffers, so the whole frame is drawn at once    |
+//| and shown on every chain. Only the MK66 has more than one chain.                               |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef LED_STRIP_H_
+#define LED_STRIP_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+#include "led-strip-arch.h"
+
+//Strip state. Members are private to the driver.
+struct led_strip {
+  uint8_t chain;
+  uint8_t *buffers[2];
+  uint8_t back;
+  uint16_t length;
+  uint8_t pixel_size;
+
+  //Transfer state.
+  volatile uint8_t busy;
+  volatile uint8_t done;
+  const uint8_t *source;
+  uint16_t position;
+  uint16_t reset_sent;
+  struct process *requester;
+};
+
+//Event posted once a frame has been sent.
+extern process_event_t led_strip_event_done;
+
+int led_strip_init(struct led_strip *strip, uint8_t chain, uint8_t *buffer_a, uint8_t *buffer_b,
+                   uint16_t pixels, uint8_t bytes_per_pixel);
+uint8_t *led_strip_buffer(struct led_strip *strip);
+void led_strip_set_pixel(struct led_strip *strip, uint16_t index, uint8_t r, uint8_t g, uint8_t b,
+                         uint8_t w);
+int led_strip_show(struct led_strip *strip);
+int led_strip_busy(struct led_strip *strip);
+
+//Used by the CPU side of the driver, from interrupt context.
+uint32_t led_strip_encode(struct led_strip *strip);
+int led_strip_latched(struct led_strip *strip);
+void led_strip_done(struct led_strip *strip);
+
+#endif //LED_STRIP_H_
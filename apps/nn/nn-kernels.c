@@ -0,0 +1,221 @@
+//+------------------------------------------------------------------------------------------------+
+//| Optimized kernels for the neural network runtime.                                              |
+//|                                                                                                |
+//| Convolution and dense layers both reduce to dot products over contiguous int8 vectors (a       |
+//| convolution window spans kernel * in_ch consecutive values, since tensors are channels last),  |
+//| which are computed two output channels at a time so the expanded inputs are reused.            |
+//|                                                                                                |
+//| On cores with the DSP extension, 4 values are loaded per word, sign extended to pairs of       |
+//| halfwords (adding the input offset on the fly with SXTAB16) and accumulated with SMLAD.        |
+//| Pooling and rectifier layers work on 4 channels per word with the SSUB8/SEL pair. Other cores  |
+//| use plain unrolled loops. Results are bit exact with the reference kernels.                    |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include "nn.h"
+#include "nn-quant.h"
+
+#if __ARM_FEATURE_DSP
+#include "nn-simd.h"
+#endif
+
+//Computes two dot products sharing the input vector: acc0 += (x + offset) . w0, and likewise for
+//acc1 with w1.
+static inline void dot2(const int8_t *x, const int8_t *w0, const int8_t *w1, uint16_t n,
+                        int16_t offset, int32_t *acc0, int32_t *acc1) {
+  int32_t a0 = *acc0, a1 = *acc1;
+
+#if __ARM_FEATURE_DSP
+  const uint32_t offset2 = simd_dup16(offset);
+  uint32_t xv, x02, x13, wv;
+
+  for (; n >= 4; n -= 4) {
+    xv = simd_read_s8x4(x);
+    x02 = simd_sxtab16(offset2, xv);
+    x13 = simd_sxtab16_ror8(offset2, xv);
+    x += 4;
+
+    wv = simd_read_s8x4(w0);
+    a0 = simd_smlad(x02, simd_sxtb16(wv), a0);
+    a0 = simd_smlad(x13, simd_sxtb16_ror8(wv), a0);
+    w0 += 4;
+
+    wv = simd_read_s8x4(w1);
+    a1 = simd_smlad(x02, simd_sxtb16(wv), a1);
+    a1 = simd_smlad(x13, simd_sxtb16_ror8(wv), a1);
+    w1 += 4;
+  }
+#else
+  int32_t x0, x1;
+
+  for (; n >= 2; n -= 2) {
+    x0 = x[0] + offset;
+    x1 = x[1] + offset;
+    a0 += x0 * w0[0] + x1 * w0[1];
+    a1 += x0 * w1[0] + x1 * w1[1];
+    x += 2;
+    w0 += 2;
+    w1 += 2;
+  }
+#endif
+
+  for (; n > 0; n--) {
+    a0 += (*x + offset) * *w0++;
+    a1 += (*x++ + offset) * *w1++;
+  }
+
+  *acc0 = a0;
+  *acc1 = a1;
+}
+
+//Single dot product, used for the last output channel when their amount is odd.
+static inline int32_t dot1(const int8_t *x, const int8_t *w, uint16_t n, int16_t offset,
+                           int32_t acc) {
+#if __ARM_FEATURE_DSP
+  const uint32_t offset2 = simd_dup16(offset);
+  uint32_t xv, wv;
+
+  for (; n >= 4; n -= 4) {
+    xv = simd_read_s8x4(x);
+    wv = simd_read_s8x4(w);
+    acc = simd_smlad(simd_sxtab16(offset2, xv), simd_sxtb16(wv), acc);
+    acc = simd_smlad(simd_sxtab16_ror8(offset2, xv), simd_sxtb16_ror8(wv), acc);
+    x += 4;
+    w += 4;
+  }
+#endif
+
+  for (; n > 0; n--)
+    acc += (*x++ + offset) * *w++;
+
+  return acc;
+}
+
+//Computes all output channels for one input vector of n values. Weights are [out_ch][n].
+static void vector_layer(const struct nn_layer *layer, const int8_t *x, uint16_t n, int8_t *out) {
+  const int8_t *w = layer->weights;
+  int32_t acc0, acc1;
+  uint16_t o;
+
+  for (o = 0; o + 1 < layer->out_ch; o += 2) {
+    acc0 = layer->bias[o];
+    acc1 = layer->bias[o + 1];
+    dot2(x, w, w + n, n, layer->in_offset, &acc0, &acc1);
+    out[o] = nn_output(acc0, layer->multiplier, layer->shift, layer->out_offset, layer->act_min,
+                       layer->act_max);
+    out[o + 1] = nn_output(acc1, layer->multiplier, layer->shift, layer->out_offset,
+                           layer->act_min, layer->act_max);
+    w += 2 * n;
+  }
+
+  if (o < layer->out_ch) {
+    acc0 = dot1(x, w, n, layer->in_offset, layer->bias[o]);
+    out[o] = nn_output(acc0, layer->multiplier, layer->shift, layer->out_offset, layer->act_min,
+                       layer->act_max);
+  }
+}
+
+void nn_conv1d(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  const uint16_t window = layer->kernel * layer->in_ch;
+  const uint16_t step = layer->stride * layer->in_ch;
+  uint16_t p;
+
+  for (p = 0; p < layer->out_len; p++) {
+    vector_layer(layer, in, window, out);
+    in += step;
+    out += layer->out_ch;
+  }
+}
+
+void nn_dense(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  vector_layer(layer, in, layer->in_len * layer->in_ch, out);
+}
+
+void nn_relu(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  uint16_t n = layer->in_len * layer->in_ch;
+
+#if __ARM_FEATURE_DSP
+  const uint32_t min4 = simd_dup8(layer->act_min);
+  const uint32_t max4 = simd_dup8(layer->act_max);
+
+  for (; n >= 4; n -= 4) {
+    simd_write_s8x4(out, simd_min8(simd_max8(simd_read_s8x4(in), min4), max4));
+    in += 4;
+    out += 4;
+  }
+#endif
+
+  for (; n > 0; n--, in++) {
+    if (*in < layer->act_min)
+      *out++ = layer->act_min;
+    else if (*in > layer->act_max)
+      *out++ = layer->act_max;
+    else
+      *out++ = *in;
+  }
+}
+
+void nn_maxpool1d(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  const uint16_t ch = layer->in_ch;
+  const int8_t *x;
+  uint16_t p, c, k;
+  int8_t v, max;
+
+  for (p = 0; p < layer->out_len; p++) {
+    c = 0;
+
+#if __ARM_FEATURE_DSP
+    for (; c + 4 <= ch; c += 4) {
+      uint32_t max4 = simd_dup8(layer->act_min);
+
+      x = in + c;
+      for (k = 0; k < layer->kernel; k++, x += ch)
+        max4 = simd_max8(max4, simd_read_s8x4(x));
+      simd_write_s8x4(out + c, simd_min8(max4, simd_dup8(layer->act_max)));
+    }
+#endif
+
+    //Starting from act_min already applies the lower clamp.
+    for (; c < ch; c++) {
+      max = layer->act_min;
+      x = in + c;
+      for (k = 0; k < layer->kernel; k++, x += ch) {
+        v = *x;
+        if (v > max)
+          max = v;
+      }
+      out[c] = (max > layer->act_max) ? layer->act_max : max;
+    }
+
+    in += layer->stride * ch;
+    out += ch;
+  }
+}
+
+void nn_avgpool1d(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  const uint16_t ch = layer->in_ch;
+  const int32_t half = layer->kernel / 2;
+  const int8_t *x;
+  uint16_t p, c, k;
+  int32_t sum;
+
+  for (p = 0; p < layer->out_len; p++) {
+    for (c = 0; c < ch; c++) {
+      sum = 0;
+      x = in + c;
+      for (k = 0; k < layer->kernel; k++, x += ch)
+        sum += *x;
+
+      sum = (sum > 0) ? (sum + half) / layer->kernel : (sum - half) / layer->kernel;
+      if (sum < layer->act_min)
+        sum = layer->act_min;
+      if (sum > layer->act_max)
+        sum = layer->act_max;
+      out[c] = sum;
+    }
+
+    in += layer->stride * ch;
+    out += ch;
+  }
+}
@@ -0,0 +1,57 @@
+//+------------------------------------------------------------------------------------------------+
+//| Fixed point requantization helpers for the neural network runtime.                             |
+//|                                                                                                |
+//| These implement the rounding rules of the TensorFlow Lite reference kernels, and are shared    |
+//| by the optimized and reference kernels so both produce bit exact results.                      |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef NN_QUANT_H_
+#define NN_QUANT_H_
+
+#include <stdint.h>
+
+//Returns the high 32 bits of 2 * a * b, rounded to nearest.
+static inline int32_t nn_rounding_doubling_high_mul(int32_t a, int32_t b) {
+  int64_t ab;
+  int32_t nudge;
+
+  if (a == INT32_MIN && b == INT32_MIN)
+    return INT32_MAX;
+
+  ab = (int64_t) a * b;
+  nudge = (ab >= 0) ? (1 << 30) : (1 - (1 << 30));
+  return (int32_t) ((ab + nudge) / (1LL << 31));
+}
+
+//Divides by 2^exponent, rounding to nearest (ties away from zero).
+static inline int32_t nn_rounding_divide_by_pot(int32_t x, int exponent) {
+  const int32_t mask = (1L << exponent) - 1;
+  const int32_t remainder = x & mask;
+  const int32_t threshold = (mask >> 1) + (x < 0);
+
+  return (x >> exponent) + (remainder > threshold);
+}
+
+//Scales an int32 accumulator by a multiplier (Q31) and a power of two.
+static inline int32_t nn_requantize(int32_t acc, int32_t multiplier, int8_t shift) {
+  const int left = (shift > 0) ? shift : 0;
+  const int right = (shift > 0) ? 0 : -shift;
+
+  return nn_rounding_divide_by_pot(nn_rounding_doubling_high_mul(acc * (1L << left), multiplier),
+                                   right);
+}
+
+//Requantizes an accumulator, adds the output zero point and clamps to the activation range.
+static inline int8_t nn_output(int32_t acc, int32_t multiplier, int8_t shift, int16_t out_offset,
+                               int8_t act_min, int8_t act_max) {
+  acc = nn_requantize(acc, multiplier, shift) + out_offset;
+  if (acc < act_min)
+    acc = act_min;
+  if (acc > act_max)
+    acc = act_max;
+  return (int8_t) acc;
+}
+
+#endif //NN_QUANT_H_
@@ -0,0 +1,104 @@
+//+------------------------------------------------------------------------------------------------+
+//| Reference kernels for the neural network runtime.                                              |
+//|                                                                                                |
+//| These are straightforward implementations of each layer type. They favor clarity over speed    |
+//| and have no architecture specific code, so they define the results expected (bit by bit) from  |
+//| the optimized kernels both on target and on the host.                                          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include "nn.h"
+#include "nn-quant.h"
+
+void nn_ref_conv1d(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  const int8_t *w;
+  uint16_t p, o, k, c;
+  int32_t acc;
+
+  for (p = 0; p < layer->out_len; p++) {
+    for (o = 0; o < layer->out_ch; o++) {
+      acc = layer->bias[o];
+      w = &layer->weights[o * layer->kernel * layer->in_ch];
+      for (k = 0; k < layer->kernel; k++) {
+        for (c = 0; c < layer->in_ch; c++) {
+          acc += (in[(p * layer->stride + k) * layer->in_ch + c] + layer->in_offset) *
+                 w[k * layer->in_ch + c];
+        }
+      }
+      out[p * layer->out_ch + o] = nn_output(acc, layer->multiplier, layer->shift,
+                                             layer->out_offset, layer->act_min, layer->act_max);
+    }
+  }
+}
+
+void nn_ref_dense(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  const uint16_t n = layer->in_len * layer->in_ch;
+  uint16_t o, i;
+  int32_t acc;
+
+  for (o = 0; o < layer->out_ch; o++) {
+    acc = layer->bias[o];
+    for (i = 0; i < n; i++)
+      acc += (in[i] + layer->in_offset) * layer->weights[o * n + i];
+    out[o] = nn_output(acc, layer->multiplier, layer->shift, layer->out_offset, layer->act_min,
+                       layer->act_max);
+  }
+}
+
+void nn_ref_relu(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  const uint16_t n = layer->in_len * layer->in_ch;
+  uint16_t i;
+
+  for (i = 0; i < n; i++) {
+    if (in[i] < layer->act_min)
+      out[i] = layer->act_min;
+    else if (in[i] > layer->act_max)
+      out[i] = layer->act_max;
+    else
+      out[i] = in[i];
+  }
+}
+
+void nn_ref_maxpool1d(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  uint16_t p, c, k;
+  int8_t v, max;
+
+  for (p = 0; p < layer->out_len; p++) {
+    for (c = 0; c < layer->in_ch; c++) {
+      max = -128;
+      for (k = 0; k < layer->kernel; k++) {
+        v = in[(p * layer->stride + k) * layer->in_ch + c];
+        if (v > max)
+          max = v;
+      }
+      if (max < layer->act_min)
+        max = layer->act_min;
+      if (max > layer->act_max)
+        max = layer->act_max;
+      out[p * layer->in_ch + c] = max;
+    }
+  }
+}
+
+void nn_ref_avgpool1d(const struct nn_layer *layer, const int8_t *in, int8_t *out) {
+  uint16_t p, c, k;
+  int32_t sum;
+
+  for (p = 0; p < layer->out_len; p++) {
+    for (c = 0; c < layer->in_ch; c++) {
+      sum = 0;
+      for (k = 0; k < layer->kernel; k++)
+        sum += in[(p * layer->stride + k) * layer->in_ch + c];
+
+      //Round to nearest, ties away from zero.
+      sum = (sum > 0) ? (sum + layer->kernel / 2) / layer->kernel :
+                        (sum - layer->kernel / 2) / layer->kernel;
+      if (sum < layer->act_min)
+        sum = layer->act_min;
+      if (sum > layer->act_max)
+        sum = layer->act_max;
+      out[p * layer->in_ch + c] = sum;
+    }
+  }
+}
@@ -0,0 +1,89 @@
+//+------------------------------------------------------------------------------------------------+
+//| Cortex-M4 DSP extension helpers for the neural network runtime.                                |
+//|                                                                                                |
+//| The runtime is CPU independent and can't include a particular device header (and through it    |
+//| the CMSIS intrinsics), so the SIMD instructions used by the int8 kernels are wrapped here.     |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef NN_SIMD_H_
+#define NN_SIMD_H_
+
+#include <stdint.h>
+#include <string.h>
+
+//Reads four consecutive int8 values as a packed word. The memcpy is turned into a single LDR,
+//which allows unaligned addresses on the Cortex-M4.
+static inline uint32_t simd_read_s8x4(const int8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void simd_write_s8x4(int8_t *p, uint32_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+//Replicates a byte on the four lanes of a word.
+static inline uint32_t simd_dup8(int8_t x) {
+  return ((uint32_t) (uint8_t) x) * 0x01010101UL;
+}
+
+//Replicates a halfword on the two lanes of a word.
+static inline uint32_t simd_dup16(int16_t x) {
+  return ((uint32_t) (uint16_t) x) * 0x00010001UL;
+}
+
+//Sign extends bytes 0 and 2 of x into two halfwords.
+static inline uint32_t simd_sxtb16(uint32_t x) {
+  uint32_t r;
+  __asm__ ("sxtb16 %0, %1" : "=r" (r) : "r" (x));
+  return r;
+}
+
+//Sign extends bytes 1 and 3 of x into two halfwords.
+static inline uint32_t simd_sxtb16_ror8(uint32_t x) {
+  uint32_t r;
+  __asm__ ("sxtb16 %0, %1, ror #8" : "=r" (r) : "r" (x));
+  return r;
+}
+
+//Sign extends bytes 0 and 2 of x and adds them to the halfwords of a.
+static inline uint32_t simd_sxtab16(uint32_t a, uint32_t x) {
+  uint32_t r;
+  __asm__ ("sxtab16 %0, %1, %2" : "=r" (r) : "r" (a), "r" (x));
+  return r;
+}
+
+//Sign extends bytes 1 and 3 of x and adds them to the halfwords of a.
+static inline uint32_t simd_sxtab16_ror8(uint32_t a, uint32_t x) {
+  uint32_t r;
+  __asm__ ("sxtab16 %0, %1, %2, ror #8" : "=r" (r) : "r" (a), "r" (x));
+  return r;
+}
+
+//Dual 16 bit multiply with 32 bit accumulate: acc + x.lo * y.lo + x.hi * y.hi
+static inline int32_t simd_smlad(uint32_t x, uint32_t y, int32_t acc) {
+  int32_t r;
+  __asm__ ("smlad %0, %1, %2, %3" : "=r" (r) : "r" (x), "r" (y), "r" (acc));
+  return r;
+}
+
+//Per byte signed maximum of two words.
+static inline uint32_t simd_max8(uint32_t a, uint32_t b) {
+  uint32_t r;
+  __asm__ ("ssub8 %0, %1, %2\n\t"
+           "sel %0, %1, %2" : "=&r" (r) : "r" (a), "r" (b) : "cc");
+  return r;
+}
+
+//Per byte signed minimum of two words.
+static inline uint32_t simd_min8(uint32_t a, uint32_t b) {
+  uint32_t r;
+  __asm__ ("ssub8 %0, %1, %2\n\t"
+           "sel %0, %2, %1" : "=&r" (r) : "r" (a), "r" (b) : "cc");
+  return r;
+}
+
+#endif //NN_SIMD_H_
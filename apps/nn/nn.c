@@ -0,0 +1,232 @@
+//+------------------------------------------------------------------------------------------------+
+//| Quantized neural network inference runtime.                                                    |
+//|                                                                                                |
+//| Layers are evaluated one after another, with intermediate activations alternating between the  |
+//| start and the end of the arena: a layer reads its input from one end and writes its output at  |
+//| the other. The first layer reads the caller input and the last one writes the caller output    |
+//| directly, so no copies are made.                                                               |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "contiki.h"
+#include "nn.h"
+
+#ifdef NN_CONF_ARENA_SIZE
+#define NN_ARENA_SIZE NN_CONF_ARENA_SIZE
+#else
+#define NN_ARENA_SIZE 8192
+#endif
+
+//Activation arena, optionally placed in a platform specific memory block.
+#ifdef NN_CONF_ARENA_SECTION
+static int8_t arena[NN_ARENA_SIZE] __attribute__((section(NN_CONF_ARENA_SECTION), aligned(4)));
+#else
+static int8_t arena[NN_ARENA_SIZE] __attribute__((aligned(4)));
+#endif
+
+static const nn_kernel_t kernels[] = {
+  [NN_LAYER_CONV1D] = nn_conv1d,
+  [NN_LAYER_DENSE] = nn_dense,
+  [NN_LAYER_RELU] = nn_relu,
+  [NN_LAYER_MAXPOOL1D] = nn_maxpool1d,
+  [NN_LAYER_AVGPOOL1D] = nn_avgpool1d,
+};
+
+static const nn_kernel_t ref_kernels[] = {
+  [NN_LAYER_CONV1D] = nn_ref_conv1d,
+  [NN_LAYER_DENSE] = nn_ref_dense,
+  [NN_LAYER_RELU] = nn_ref_relu,
+  [NN_LAYER_MAXPOOL1D] = nn_ref_maxpool1d,
+  [NN_LAYER_AVGPOOL1D] = nn_ref_avgpool1d,
+};
+
+#define NUM_LAYER_TYPES (sizeof(kernels) / sizeof(kernels[0]))
+
+process_event_t nn_event_done;
+
+//Request being processed by the inference process (NULL when idle).
+static struct nn_request *current;
+
+PROCESS(nn_process, "NN inference");
+
+//Checks the shapes of a layer, returning the sizes (in values) of its input and output tensors.
+static int layer_sizes(const struct nn_layer *layer, uint32_t *in_size, uint32_t *out_size) {
+  uint16_t len;
+
+  if (layer->type >= NUM_LAYER_TYPES)
+    return NN_ERR_LAYER;
+
+  switch (layer->type) {
+    case NN_LAYER_CONV1D:
+    case NN_LAYER_MAXPOOL1D:
+    case NN_LAYER_AVGPOOL1D:
+      if (layer->kernel == 0 || layer->stride == 0 || layer->kernel > layer->in_len)
+        return NN_ERR_LAYER;
+      len = (layer->in_len - layer->kernel) / layer->stride + 1;
+      if (layer->out_len != len)
+        return NN_ERR_LAYER;
+      if (layer->type != NN_LAYER_CONV1D && layer->out_ch != layer->in_ch)
+        return NN_ERR_LAYER;
+      break;
+
+    case NN_LAYER_DENSE:
+      if (layer->out_len != 1)
+        return NN_ERR_LAYER;
+      break;
+
+    case NN_LAYER_RELU:
+      if (layer->out_len != layer->in_len || layer->out_ch != layer->in_ch)
+        return NN_ERR_LAYER;
+      break;
+  }
+
+  *in_size = (uint32_t) layer->in_len * layer->in_ch;
+  *out_size = (uint32_t) layer->out_len * layer->out_ch;
+  return NN_OK;
+}
+
+//Returns the buffers used by a given layer of a model, with the output placed at the start of the
+//arena for even layers and at the end of it for odd ones.
+static void layer_buffers(const struct nn_model *model, uint8_t index, const int8_t *input,
+                          int8_t *output, int8_t *buf, uint32_t buf_size, const int8_t **in,
+                          int8_t **out) {
+  const struct nn_layer *layer = &model->layers[index];
+
+  if (index == 0)
+    *in = input;
+  else if ((index - 1) & 1)
+    *in = buf + buf_size - (uint32_t) layer->in_len * layer->in_ch;
+  else
+    *in = buf;
+
+  if (index == model->num_layers - 1)
+    *out = output;
+  else if (index & 1)
+    *out = buf + buf_size - (uint32_t) layer->out_len * layer->out_ch;
+  else
+    *out = buf;
+}
+
+//Checks a model against a buffer size.
+static int check_model(const struct nn_model *model, uint32_t buf_size) {
+  uint32_t size;
+  int status;
+
+  status = nn_arena_size(model, &size);
+  if (status != NN_OK)
+    return status;
+  if (size > buf_size)
+    return NN_ERR_ARENA;
+  return NN_OK;
+}
+
+static int run(const struct nn_model *model, const int8_t *input, int8_t *output, int8_t *buf,
+               uint32_t buf_size, const nn_kernel_t *table) {
+  const int8_t *in;
+  int8_t *out;
+  uint8_t i;
+  int status;
+
+  status = check_model(model, buf_size);
+  if (status != NN_OK)
+    return status;
+
+  for (i = 0; i < model->num_layers; i++) {
+    layer_buffers(model, i, input, output, buf, buf_size, &in, &out);
+    table[model->layers[i].type](&model->layers[i], in, out);
+  }
+
+  return NN_OK;
+}
+
+void nn_init() {
+  nn_event_done = process_alloc_event();
+  process_start(&nn_process, NULL);
+}
+
+//Computes the arena size needed to run a model. Returns NN_ERR_LAYER if any of its layers is
+//invalid. A layer needs space for both its input and output, except that the first layer reads the
+//caller input and the last one writes the caller output (so single layer models need none).
+int nn_arena_size(const struct nn_model *model, uint32_t *size) {
+  uint32_t in_size, out_size, layer_size, max = 0;
+  uint8_t i;
+
+  for (i = 0; i < model->num_layers; i++) {
+    if (layer_sizes(&model->layers[i], &in_size, &out_size) != NN_OK)
+      return NN_ERR_LAYER;
+    if (i > 0 && in_size != model->layers[i - 1].out_len * model->layers[i - 1].out_ch)
+      return NN_ERR_LAYER;
+
+    layer_size = 0;
+    if (i > 0)
+      layer_size += in_size;
+    if (i < model->num_layers - 1)
+      layer_size += out_size;
+    if (layer_size > max)
+      max = layer_size;
+  }
+
+  *size = max;
+  return NN_OK;
+}
+
+//Runs a model synchronously with the optimized kernels.
+int nn_run(const struct nn_model *model, const int8_t *input, int8_t *output) {
+  if (current != NULL)
+    return NN_ERR_BUSY;
+
+  return run(model, input, output, arena, sizeof(arena), kernels);
+}
+
+int nn_ref_run(const struct nn_model *model, const int8_t *input, int8_t *output, int8_t *scratch,
+               uint32_t scratch_size) {
+  return run(model, input, output, scratch, scratch_size, ref_kernels);
+}
+
+//Queues an inference request on the inference process. The requester gets nn_event_done with the
+//request as data once finished, with the result stored in its status field.
+int nn_infer(struct nn_request *req) {
+  int status;
+
+  if (current != NULL)
+    return NN_ERR_BUSY;
+
+  status = check_model(req->model, sizeof(arena));
+  if (status != NN_OK)
+    return status;
+
+  current = req;
+  process_poll(&nn_process);
+  return NN_OK;
+}
+
+PROCESS_THREAD(nn_process, ev, data) {
+  static uint8_t i;
+  const int8_t *in;
+  int8_t *out;
+  struct nn_request *req;
+
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL && current != NULL);
+
+    //Evaluate one layer at a time, letting other processes run in between.
+    for (i = 0; i < current->model->num_layers; i++) {
+      layer_buffers(current->model, i, current->input, current->output, arena, sizeof(arena),
+                    &in, &out);
+      kernels[current->model->layers[i].type](&current->model->layers[i], in, out);
+      PROCESS_PAUSE();
+    }
+
+    req = current;
+    req->status = NN_OK;
+    current = NULL;
+    process_post(req->requester, nn_event_done, req);
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,103 @@
+//+------------------------------------------------------------------------------------------------+
+//| Quantized neural network inference runtime.                                                    |
+//|                                                                                                |
+//| This library runs small feed forward networks (1D convolutional networks, autoencoders) with   |
+//| int8 weights and activations and int32 biases, using the same quantization scheme as           |
+//| TensorFlow Lite: real = scale * (q - zero_point), with per layer requantization multipliers.   |
+//|                                                                                                |
+//| Tensors are stored channels last (element [t][c] at index t * channels + c). Models are        |
+//| described by constant layer tables, so weights stay in flash. Intermediate activations live    |
+//| in an arena owned by the runtime, whose size is set with NN_CONF_ARENA_SIZE. Platforms can     |
+//| place it in a specific memory block by defining NN_CONF_ARENA_SECTION with a section name.     |
+//|                                                                                                |
+//| Inference can be run synchronously (nn_run) or by the nn_process process (nn_infer), which     |
+//| yields between layers so other processes keep running, and posts nn_event_done when finished.  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef NN_H_
+#define NN_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Layer types.
+#define NN_LAYER_CONV1D     0   //1D convolution (valid padding)
+#define NN_LAYER_DENSE      1   //Fully connected layer
+#define NN_LAYER_RELU       2   //Standalone rectifier (clamps values below the zero point)
+#define NN_LAYER_MAXPOOL1D  3   //1D max pooling (valid padding)
+#define NN_LAYER_AVGPOOL1D  4   //1D average pooling (valid padding)
+
+//Return codes.
+#define NN_OK           0
+#define NN_ERR_ARENA    -1      //Arena too small for the model
+#define NN_ERR_LAYER    -2      //Unknown layer type or inconsistent shapes
+#define NN_ERR_BUSY     -3      //The inference process is already running a request
+
+//Layer descriptor. Shapes are given as (length, channels); dense layers use a length of 1, and
+//take their input flattened. Convolution weights are ordered as [out_ch][kernel][in_ch] and dense
+//weights as [out_ch][in_ch].
+struct nn_layer {
+  uint8_t type;
+  uint8_t kernel;               //Kernel or pooling window size
+  uint8_t stride;               //Kernel or pooling window stride
+  uint16_t in_len, in_ch;       //Input shape
+  uint16_t out_len, out_ch;     //Output shape
+  int16_t in_offset;            //Input zero point, negated
+  int16_t out_offset;           //Output zero point
+  int8_t act_min, act_max;      //Output clamping range (fused activation)
+  int32_t multiplier;           //Requantization multiplier (Q31, between 0.5 and 1)
+  int8_t shift;                 //Requantization shift (positive for left shift)
+  const int8_t *weights;
+  const int32_t *bias;
+};
+
+//Model descriptor.
+struct nn_model {
+  const struct nn_layer *layers;
+  uint8_t num_layers;
+};
+
+//Inference request, used with the inference process.
+struct nn_request {
+  const struct nn_model *model;
+  const int8_t *input;
+  int8_t *output;
+  struct process *requester;    //Process notified with nn_event_done
+  int status;                   //Result of the inference
+};
+
+//Layer kernel signature. Both the optimized and the reference kernel sets use it.
+typedef void (* nn_kernel_t)(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+
+PROCESS_NAME(nn_process);
+
+extern process_event_t nn_event_done;
+
+void nn_init();
+int nn_arena_size(const struct nn_model *model, uint32_t *size);
+int nn_run(const struct nn_model *model, const int8_t *input, int8_t *output);
+int nn_infer(struct nn_request *req);
+
+//Optimized kernels (using the Cortex-M4 DSP instructions when available).
+void nn_conv1d(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+void nn_dense(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+void nn_relu(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+void nn_maxpool1d(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+void nn_avgpool1d(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+
+//Reference kernels. Plain implementations that define the expected (bit exact) results.
+void nn_ref_conv1d(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+void nn_ref_dense(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+void nn_ref_relu(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+void nn_ref_maxpool1d(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+void nn_ref_avgpool1d(const struct nn_layer *layer, const int8_t *in, int8_t *out);
+
+//Runs a model layer by layer with the reference kernels, using a caller supplied scratch buffer of
+//at least nn_arena_size() bytes.
+int nn_ref_run(const struct nn_model *model, const int8_t *input, int8_t *output, int8_t *scratch,
+               uint32_t scratch_size);
+
+#endif //NN_H_
@@ -0,0 +1,215 @@
+//+------------------------------------------------------------------------------------------------+
+//| Periodic task service with earliest deadline first dispatching.                                |
+//|                                                                                                |
+//| The rtimer interrupt only polls the periodic process, which does all the bookkeeping. Thus the |
+//| task list and statistics are never touched from interrupt context. On every invocation the     |
+//| process releases the jobs that are due, runs the ready job with the earliest deadline and      |
+//| polls itself again; once no jobs are ready it arms the rtimer for the next release.            |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+#include <string.h>
+
+#include "periodic.h"
+
+static struct periodic_task *tasks = NULL;
+
+//Release timer.
+static struct rtimer timer;
+static volatile uint8_t timer_armed = 0;
+static rtimer_clock_t armed_time;
+
+//Load measurement window.
+static rtimer_clock_t window_start;
+static uint32_t window_busy;
+
+PROCESS(periodic_process, "Periodic tasks");
+
+//Returns the release time of a given job of a task.
+static rtimer_clock_t release_time(const struct periodic_task *task, uint32_t job) {
+  return task->base + job * task->period;
+}
+
+//Rtimer callback. Runs in interrupt context, so it only hands over to the process.
+static void timer_callback(struct rtimer *t, void *ptr) {
+  timer_armed = 0;
+  process_poll(&periodic_process);
+}
+
+//Arms the rtimer for a given (absolute) time. If it's already armed for a later time, the pending
+//timer is moved earlier (the rtimer library can't do that by itself). Should it expire meanwhile,
+//its callback polls the process, which then arms it again.
+static void arm_timer(rtimer_clock_t t) {
+  if (!timer_armed) {
+    timer_armed = 1;
+    armed_time = t;
+    rtimer_set(&timer, t, 0, timer_callback, NULL);
+  } else if (RTIMER_CLOCK_LT(t, armed_time) && rtimer_arch_reschedule(t) == 0) {
+    armed_time = t;
+  }
+}
+
+//Releases every job due by the given time. Jobs not run by the time the next one of the same task
+//is released are skipped.
+static void release_jobs(rtimer_clock_t now) {
+  struct periodic_task *task;
+  uint32_t pending;
+
+  for (task = tasks; task != NULL; task = task->next) {
+    while (!RTIMER_CLOCK_LT(now, release_time(task, task->released)))
+      task->released++;
+
+    pending = task->released - task->done;
+    if (pending > 1) {
+      task->stats.skipped += pending - 1;
+      task->done = task->released - 1;
+    }
+  }
+}
+
+//Returns the ready task whose current job has the earliest absolute deadline.
+static struct periodic_task *earliest_deadline() {
+  struct periodic_task *task, *best = NULL;
+  rtimer_clock_t deadline, best_deadline = 0;
+
+  for (task = tasks; task != NULL; task = task->next) {
+    if (task->released == task->done)
+      continue;
+
+    deadline = release_time(task, task->done) + task->deadline;
+    if (best == NULL || RTIMER_CLOCK_LT(deadline, best_deadline)) {
+      best = task;
+      best_deadline = deadline;
+    }
+  }
+
+  return best;
+}
+
+//Runs the current job of a task and updates its statistics.
+static void run_job(struct periodic_task *task) {
+  rtimer_clock_t release, start, end, response, exec;
+
+  release = release_time(task, task->done);
+  start = RTIMER_NOW();
+  task->fn(task->ptr);
+  end = RTIMER_NOW();
+
+  response = end - release;
+  exec = end - start;
+
+  task->done++;
+  task->stats.jobs++;
+  if (response > task->deadline)
+    task->stats.misses++;
+  task->stats.response_last = response;
+  if (response > task->stats.response_max)
+    task->stats.response_max = response;
+  if (exec > task->stats.exec_max)
+    task->stats.exec_max = exec;
+  task->stats.exec_total += exec;
+  window_busy += exec;
+}
+
+void periodic_init() {
+  window_start = RTIMER_NOW();
+  window_busy = 0;
+  process_start(&periodic_process, NULL);
+}
+
+//Adds a task. Its first job is released after the given phase, and then once every period. A
+//deadline of 0 sets it equal to the period.
+void periodic_add(struct periodic_task *task, const char *name, rtimer_clock_t period,
+                  rtimer_clock_t deadline, rtimer_clock_t phase, periodic_fn_t fn, void *ptr) {
+  task->name = name;
+  task->fn = fn;
+  task->ptr = ptr;
+  task->period = period;
+  task->deadline = (deadline == 0 || deadline > period) ? period : deadline;
+  task->base = RTIMER_NOW() + phase;
+  task->released = 0;
+  task->done = 0;
+  memset(&task->stats, 0, sizeof(task->stats));
+
+  task->next = tasks;
+  tasks = task;
+
+  //Have the process reconsider the release timer.
+  process_poll(&periodic_process);
+}
+
+void periodic_remove(struct periodic_task *task) {
+  struct periodic_task **t;
+
+  for (t = &tasks; *t != NULL; t = &(*t)->next) {
+    if (*t == task) {
+      *t = task->next;
+      break;
+    }
+  }
+}
+
+struct periodic_task *periodic_list() {
+  return tasks;
+}
+
+//Reports the processor load, and starts a new measurement window.
+void periodic_get_load(struct periodic_load *load) {
+  struct periodic_task *task;
+  rtimer_clock_t now = RTIMER_NOW();
+  uint32_t elapsed, demand = 0;
+
+  elapsed = now - window_start;
+  load->measured = (elapsed > 0) ? ((uint64_t) window_busy * 1000) / elapsed : 0;
+  window_start = now;
+  window_busy = 0;
+
+  //The task set is schedulable under EDF as long as the total utilisation doesn't exceed 1 (with
+  //deadlines equal to periods).
+  for (task = tasks; task != NULL; task = task->next)
+    demand += ((uint64_t) task->stats.exec_max * 1000 + task->period - 1) / task->period;
+  load->demand = (demand > 0xFFFF) ? 0xFFFF : demand;
+  load->headroom = (demand < 1000) ? 1000 - demand : 0;
+}
+
+void periodic_reset_stats() {
+  struct periodic_task *task;
+
+  for (task = tasks; task != NULL; task = task->next)
+    memset(&task->stats, 0, sizeof(task->stats));
+}
+
+PROCESS_THREAD(periodic_process, ev, data) {
+  struct periodic_task *task;
+  rtimer_clock_t next;
+
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    release_jobs(RTIMER_NOW());
+
+    //Run a single job, then yield to other processes before running the next one.
+    task = earliest_deadline();
+    if (task != NULL) {
+      run_job(task);
+      process_poll(&periodic_process);
+      continue;
+    }
+
+    //No jobs ready. Wait for the next release.
+    if (tasks != NULL) {
+      next = release_time(tasks, tasks->released);
+      for (task = tasks->next; task != NULL; task = task->next) {
+        if (RTIMER_CLOCK_LT(release_time(task, task->released), next))
+          next = release_time(task, task->released);
+      }
+      arm_timer(next);
+    }
+  }
+
+  PROCESS_END();
+}
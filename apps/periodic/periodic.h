@@ -0,0 +1,76 @@
+//+------------------------------------------------------------------------------------------------+
+//| Periodic task service with earliest deadline first dispatching.                                |
+//|                                                                                                |
+//| Periodic tasks are released at absolute times (phase + n * period, so release times never      |
+//| drift) measured with the rtimer library. Released jobs are run by the periodic process, one    |
+//| job per process invocation so normal processes keep running in between, always picking the     |
+//| ready job with the earliest absolute deadline.                                                 |
+//|                                                                                                |
+//| Every task keeps statistics on its response time (from release to completion), execution time  |
+//| and missed deadlines. A job still pending when the next one of the same task is released is    |
+//| skipped, and counted apart from missed deadlines. The service also reports the CPU share used  |
+//| by periodic tasks and the EDF utilisation headroom (how much more periodic demand would still  |
+//| be schedulable).                                                                               |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef PERIODIC_H_
+#define PERIODIC_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Converts rtimer ticks to microseconds.
+#define PERIODIC_TICKS_TO_US(t) ((uint32_t) (((uint64_t) (t) * 1000000) / RTIMER_SECOND))
+
+//Converts microseconds to rtimer ticks.
+#define PERIODIC_US_TO_TICKS(us) ((rtimer_clock_t) (((uint64_t) (us) * RTIMER_SECOND) / 1000000))
+
+//Task function type. Runs one job of the task.
+typedef void (* periodic_fn_t)(void *ptr);
+
+//Per task statistics. Times are given in rtimer ticks.
+struct periodic_stats {
+  uint32_t jobs;                //Jobs completed
+  uint32_t misses;              //Jobs completed after their deadline
+  uint32_t skipped;             //Jobs skipped since the previous one hadn't run yet
+  rtimer_clock_t response_last; //Response time (release to completion)
+  rtimer_clock_t response_max;
+  rtimer_clock_t exec_max;      //Execution time
+  uint32_t exec_total;
+};
+
+//Task descriptor. Storage is provided by the caller.
+struct periodic_task {
+  struct periodic_task *next;
+  const char *name;
+  periodic_fn_t fn;
+  void *ptr;
+  rtimer_clock_t period;
+  rtimer_clock_t deadline;      //Relative deadline (at most the period)
+  rtimer_clock_t base;          //Release time of the first job
+  uint32_t released;            //Jobs released so far
+  uint32_t done;                //Jobs completed or skipped so far
+  struct periodic_stats stats;
+};
+
+//Processor load, in parts per thousand.
+struct periodic_load {
+  uint16_t measured;            //CPU share used by periodic jobs since the last load report
+  uint16_t demand;              //Sum of worst case execution time over period of all tasks
+  uint16_t headroom;            //Remaining schedulable utilisation (1000 - demand)
+};
+
+PROCESS_NAME(periodic_process);
+
+void periodic_init();
+void periodic_add(struct periodic_task *task, const char *name, rtimer_clock_t period,
+                  rtimer_clock_t deadline, rtimer_clock_t phase, periodic_fn_t fn, void *ptr);
+void periodic_remove(struct periodic_task *task);
+struct periodic_task *periodic_list();
+void periodic_get_load(struct periodic_load *load);
+void periodic_reset_stats();
+
+#endif //PERIODIC_H_
@@ -0,0 +1,86 @@
+//+------------------------------------------------------------------------------------------------+
+//| Message accessors for the RPC framework.                                                       |
+//|                                                                                                |
+//| A message is a window over the buffer where its payload already lies: a plain buffer, or the   |
+//| receive ring of a DMA channel (in which case the payload may wrap around the end of the ring). |
+//| Fields are read and written in place, little endian, at the offsets given by the schema, so    |
+//| requests are never copied out of the ring and responses are built straight in the transmit     |
+//| buffer. The encoders and decoders generated by rpcgen.py are thin wrappers over these.         |
+//|                                                                                                |
+//| Reads past the end of the payload return zero, so a method can gain trailing fields without    |
+//| breaking older peers (which send shorter messages).                                            |
+//|                                                                                                |
+//| This file doesn't depend on contiki, so host side C code can use the generated accessors too.  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef RPC_MSG_H_
+#define RPC_MSG_H_
+
+#include <stdint.h>
+
+struct rpc_msg {
+  uint8_t *data;      //Buffer or ring holding the message
+  uint16_t mask;      //Ring size minus one (0xFFFF for plain buffers)
+  uint16_t start;     //Offset of the payload
+  uint8_t length;     //Payload length
+};
+
+static inline uint8_t rpc_get_u8(const struct rpc_msg *m, uint8_t offset) {
+  return (offset < m->length) ? m->data[(m->start + offset) & m->mask] : 0;
+}
+
+static inline uint16_t rpc_get_u16(const struct rpc_msg *m, uint8_t offset) {
+  return rpc_get_u8(m, offset) | (rpc_get_u8(m, offset + 1) << 8);
+}
+
+static inline uint32_t rpc_get_u32(const struct rpc_msg *m, uint8_t offset) {
+  return rpc_get_u16(m, offset) | ((uint32_t) rpc_get_u16(m, offset + 2) << 16);
+}
+
+static inline float rpc_get_f32(const struct rpc_msg *m, uint8_t offset) {
+  union { uint32_t u; float f; } value;
+
+  value.u = rpc_get_u32(m, offset);
+  return value.f;
+}
+
+static inline void rpc_put_u8(struct rpc_msg *m, uint8_t offset, uint8_t value) {
+  m->data[(m->start + offset) & m->mask] = value;
+}
+
+static inline void rpc_put_u16(struct rpc_msg *m, uint8_t offset, uint16_t value) {
+  rpc_put_u8(m, offset, value);
+  rpc_put_u8(m, offset + 1, value >> 8);
+}
+
+static inline void rpc_put_u32(struct rpc_msg *m, uint8_t offset, uint32_t value) {
+  rpc_put_u16(m, offset, value);
+  rpc_put_u16(m, offset + 2, value >> 16);
+}
+
+static inline void rpc_put_f32(struct rpc_msg *m, uint8_t offset, float value) {
+  union { uint32_t u; float f; } v;
+
+  v.f = value;
+  rpc_put_u32(m, offset, v.u);
+}
+
+//Copies bytes out of a message (for byte array fields).
+static inline void rpc_read(const struct rpc_msg *m, uint8_t offset, void *data, uint8_t length) {
+  uint8_t *p = data;
+
+  while (length--)
+    *p++ = rpc_get_u8(m, offset++);
+}
+
+//Copies bytes into a message.
+static inline void rpc_write(struct rpc_msg *m, uint8_t offset, const void *data, uint8_t length) {
+  const uint8_t *p = data;
+
+  while (length--)
+    rpc_put_u8(m, offset++, *p++);
+}
+
+#endif //RPC_MSG_H_
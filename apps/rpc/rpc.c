@@ -0,0 +1,179 @@
+//+------------------------------------------------------------------------------------------------+
+//| Binary RPC framework.                                                                          |
+//|                                                                                                |
+//| The RPC process is polled by the link whenever the line goes idle, and handles every complete  |
+//| frame found in the receive ring since the last time. Requests are handed to the handlers as    |
+//| windows over the ring, and responses are built in one of two transmit buffers, so the next     |
+//| response can be built while the previous one is still being sent.                              |
+//|                                                                                                |
+//| A byte that looks like a sync byte but isn't holds the receiver until enough bytes arrive to   |
+//| rule it out by length or CRC. The host gets no response to the request caught behind it, and   |
+//| its retry completes the bogus frame, after which the receiver is in sync again.                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "rpc.h"
+#include "uart-dma.h"
+
+#define RX_MASK (UART_DMA_RX_SIZE - 1)
+#define FRAME_SIZE (RPC_HEADER_SIZE + RPC_PAYLOAD_SIZE + RPC_TRAILER_SIZE)
+
+//Byte of the receive ring, relative to a position.
+#define RX(pos, offset) uart_dma_rx_ring[((pos) + (offset)) & RX_MASK]
+
+static const struct rpc_method *methods;
+static uint8_t method_count;
+
+//CRC16-CCITT lookup table.
+static uint16_t crc_table[256];
+
+//Position of the next byte to process in the receive ring.
+static uint16_t rx_tail;
+
+static uint8_t tx_buffers[2][FRAME_SIZE] __attribute__((aligned(4)));
+static uint8_t tx_index;
+
+static struct rpc_stats stats;
+
+PROCESS(rpc_process, "RPC");
+
+//Computes the CRC of a received frame, over the length, sequence, method and status bytes and the
+//payload.
+static uint16_t rx_crc(uint16_t pos, uint8_t length) {
+  uint16_t crc = 0xFFFF;
+  uint16_t i;
+
+  for (i = 1; i < RPC_HEADER_SIZE + length; i++)
+    crc = (crc << 8) ^ crc_table[(crc >> 8) ^ RX(pos, i)];
+
+  return crc;
+}
+
+//Fills the header and trailer of a response (the payload must be already in place).
+static uint16_t seal(uint8_t *frame, uint8_t seq, uint8_t method, uint8_t status, uint8_t length) {
+  uint16_t crc = 0xFFFF;
+  uint16_t i;
+
+  frame[0] = RPC_SYNC;
+  frame[1] = length;
+  frame[2] = seq;
+  frame[3] = method;
+  frame[4] = status;
+
+  for (i = 1; i < RPC_HEADER_SIZE + length; i++)
+    crc = (crc << 8) ^ crc_table[(crc >> 8) ^ frame[i]];
+  frame[i] = crc;
+  frame[i + 1] = crc >> 8;
+
+  return i + RPC_TRAILER_SIZE;
+}
+
+//Runs the method of a request frame and sends the response.
+static void call(uint16_t pos, uint8_t length) {
+  struct rpc_msg request;
+  struct rpc_msg response;
+  uint8_t *frame = tx_buffers[tx_index];
+  uint8_t method = RX(pos, 3);
+  uint8_t status;
+  uint16_t size;
+
+  request.data = (uint8_t *) uart_dma_rx_ring;
+  request.mask = RX_MASK;
+  request.start = pos + RPC_HEADER_SIZE;
+  request.length = length;
+
+  response.data = frame;
+  response.mask = 0xFFFF;
+  response.start = RPC_HEADER_SIZE;
+  response.length = 0;
+
+  if (method < method_count && methods[method].handler != NULL) {
+    response.length = methods[method].response_size;
+    status = methods[method].handler(&request, &response);
+  } else {
+    status = RPC_STATUS_METHOD;
+  }
+
+  if (status != RPC_STATUS_OK)
+    response.length = 0;
+
+  //The previous response is sent from the other buffer. Wait for it to be out before sending
+  //this one (at most a frame time, 2.5ms at 1Mbps).
+  size = seal(frame, RX(pos, 2), method, status, response.length);
+  while (uart_dma_send(frame, size) < 0);
+  tx_index ^= 1;
+
+  stats.calls++;
+}
+
+//Initializes the framework with the method table generated from the schema, and starts listening
+//on the link.
+void rpc_init(const struct rpc_method *table, uint8_t count) {
+  uint32_t i, crc;
+  uint8_t bit;
+
+  methods = table;
+  method_count = count;
+
+  //Build the CRC table (polynomial 0x1021).
+  for (i = 0; i < 256; i++) {
+    crc = i << 8;
+    for (bit = 0; bit < 8; bit++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    crc_table[i] = crc;
+  }
+
+  process_start(&rpc_process, NULL);
+  uart_dma_init(&rpc_process);
+  rx_tail = uart_dma_rx_head();
+}
+
+const struct rpc_stats *rpc_stats() {
+  return &stats;
+}
+
+//Handles the frames received, in order.
+PROCESS_THREAD(rpc_process, ev, data) {
+  uint16_t available;
+  uint8_t length;
+
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    while (1) {
+      available = (uart_dma_rx_head() - rx_tail) & RX_MASK;
+      if (available < RPC_HEADER_SIZE + RPC_TRAILER_SIZE)
+        break;
+
+      //Look for a frame start.
+      length = RX(rx_tail, 1);
+      if (RX(rx_tail, 0) != RPC_SYNC || length > RPC_PAYLOAD_SIZE) {
+        stats.skipped++;
+        rx_tail = (rx_tail + 1) & RX_MASK;
+        continue;
+      }
+
+      //Wait for the rest of the frame.
+      if (available < RPC_HEADER_SIZE + length + RPC_TRAILER_SIZE)
+        break;
+
+      if (rx_crc(rx_tail, length) != (RX(rx_tail, RPC_HEADER_SIZE + length) |
+                                      (RX(rx_tail, RPC_HEADER_SIZE + length + 1) << 8))) {
+        stats.crc_errors++;
+        stats.skipped++;
+        rx_tail = (rx_tail + 1) & RX_MASK;
+        continue;
+      }
+
+      call(rx_tail, length);
+      rx_tail = (rx_tail + RPC_HEADER_SIZE + length + RPC_TRAILER_SIZE) & RX_MASK;
+    }
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,70 @@
+//+------------------------------------------------------------------------------------------------+
+//| Binary RPC framework.                                                                          |
+//|                                                                                                |
+//| Lets a host call methods of the node over a serial link, with requests and responses laid out  |
+//| by a schema. rpcgen.py compiles the schema into C accessors for the fields (see rpc-msg.h), a  |
+//| method table for the dispatcher and a Python client module for the host. Requests are decoded  |
+//| in place from the receive ring of the link and responses are encoded in place in the transmit  |
+//| buffer, with no heap, no copies and no intermediate structures. Handlers run in the context of |
+//| the RPC process.                                                                               |
+//|                                                                                                |
+//| Frame layout (both ways):                                                                      |
+//| - Byte 0: sync byte (0xA5).                                                                    |
+//| - Byte 1: payload length (up to RPC_PAYLOAD_SIZE).                                             |
+//| - Byte 2: sequence number (chosen by the host, echoed in the response).                        |
+//| - Byte 3: method number.                                                                       |
+//| - Byte 4: status (zero in requests, RPC_STATUS_* or a method specific error in responses).     |
+//| - Bytes 5 onwards: payload.                                                                    |
+//| - Last 2 bytes: CRC16-CCITT (little endian) over bytes 1 to 4 and the payload.                 |
+//|                                                                                                |
+//| Frames with a bad CRC or length are skipped by looking for the next sync byte, so the receiver |
+//| recovers from garbage on the line by itself. Responses that aren't OK carry no payload.        |
+//|                                                                                                |
+//| The link is the DMA driven UART of the MK66 (see uart-dma.h), so the framework is only         |
+//| available on the Teensy 3.6.                                                                   |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef RPC_H_
+#define RPC_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+#include "rpc-msg.h"
+
+//Frame layout.
+#define RPC_SYNC 0xA5
+#define RPC_HEADER_SIZE 5
+#define RPC_TRAILER_SIZE 2
+#define RPC_PAYLOAD_SIZE 248
+
+//Response status codes. Methods may return their own from RPC_STATUS_USER on.
+#define RPC_STATUS_OK       0
+#define RPC_STATUS_METHOD   1   //Unknown method
+#define RPC_STATUS_USER     16
+
+//Method handler. Reads the request and fills the response (whose length is preset to the size
+//given by the schema), returning the status.
+typedef uint8_t (* rpc_handler_t)(const struct rpc_msg *request, struct rpc_msg *response);
+
+//Method table entry, indexed by method number (generated from the schema).
+struct rpc_method {
+  rpc_handler_t handler;        //NULL for unused numbers
+  uint8_t response_size;
+};
+
+//Link counters.
+struct rpc_stats {
+  uint32_t calls;               //Requests handled
+  uint32_t crc_errors;          //Frames dropped due to a bad CRC
+  uint32_t skipped;             //Bytes skipped while looking for a frame
+};
+
+PROCESS_NAME(rpc_process);
+
+void rpc_init(const struct rpc_method *methods, uint8_t count);
+const struct rpc_stats *rpc_stats();
+
+#endif //RPC_H_
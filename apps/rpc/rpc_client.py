@@ -0,0 +1,215 @@
+#+-------------------------------------------------------------------------------------------------+
+#| Host side client for the binary RPC framework.                                                  |
+#|                                                                                                 |
+#| Frames requests, matches responses by sequence number and retries on timeouts. The modules      |
+#| generated by rpcgen.py subclass RpcClient with one call per method, built on the Layout of      |
+#| their requests and responses.                                                                   |
+#|                                                                                                 |
+#| The port is either a serial port name (requires pyserial) or any object with write(), read()    |
+#| and in_waiting, like Loopback, which answers requests with Python handlers so clients can be    |
+#| tested without a board.                                                                         |
+#|                                                                                                 |
+#| USB serial adapters usually hold received data for a while before handing it to the host (the   |
+#| latency timer of FTDI adapters is 16ms by default). Set it to 1ms to get sub millisecond calls: |
+#| echo 1 > /sys/bus/usb-serial/devices/ttyUSB0/latency_timer                                      |
+#|                                                                                                 |
+#| Author: Joksan Alvarado.                                                                        |
+#+-------------------------------------------------------------------------------------------------+
+
+import struct
+import time
+
+#Frame layout (see rpc.h).
+SYNC = 0xA5
+HEADER_SIZE = 5
+TRAILER_SIZE = 2
+PAYLOAD_SIZE = 248
+
+#Response status codes.
+STATUS_OK = 0
+STATUS_METHOD = 1
+STATUS_USER = 16
+
+
+class RpcError(Exception):
+    """Raised when a call fails, with the status returned by the node (None on timeouts)."""
+
+    def __init__(self, method, status):
+        Exception.__init__(self, 'method %u failed with %s' %
+                           (method, 'a timeout' if status is None else 'status %u' % status))
+        self.method = method
+        self.status = status
+
+
+def crc16(data, crc=0xFFFF):
+    """Computes the CRC16-CCITT of a byte string."""
+    for byte in data:
+        crc ^= byte << 8
+        for bit in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def build_frame(seq, method, status, payload):
+    """Builds a frame around a payload."""
+    if len(payload) > PAYLOAD_SIZE:
+        raise ValueError('payload too long')
+    body = bytes([len(payload), seq, method, status]) + bytes(payload)
+    return bytes([SYNC]) + body + struct.pack('<H', crc16(body))
+
+
+def parse_frame(buffer):
+    """Takes the first frame out of a bytearray, skipping garbage before it. Returns (sequence,
+    method, status, payload), or None if no complete frame is there yet."""
+    while len(buffer) >= HEADER_SIZE + TRAILER_SIZE:
+        length = buffer[1]
+        if buffer[0] != SYNC or length > PAYLOAD_SIZE:
+            del buffer[0]
+            continue
+
+        size = HEADER_SIZE + length + TRAILER_SIZE
+        if len(buffer) < size:
+            return None
+
+        body = bytes(buffer[1:HEADER_SIZE + length])
+        if crc16(body) != struct.unpack_from('<H', buffer, HEADER_SIZE + length)[0]:
+            del buffer[0]
+            continue
+
+        del buffer[:size]
+        return body[1], body[2], body[3], body[4:]
+
+    return None
+
+
+class Layout:
+    """Packs and unpacks the fields of a message, given as (name, struct format, array count)
+    tuples. Byte arrays map to bytes objects, other arrays to lists."""
+
+    def __init__(self, fields):
+        self.fields = fields
+        fmt = '<'
+        for name, code, count in fields:
+            if count:
+                fmt += '%u%s' % (count, 's' if code == 'B' else code)
+            else:
+                fmt += code
+        self.struct = struct.Struct(fmt)
+
+    def pack(self, *values):
+        flat = []
+        for (name, code, count), value in zip(self.fields, values):
+            if count and code == 'B':
+                flat.append(bytes(value))
+            elif count:
+                value = list(value)[:count]
+                flat.extend(value + [0] * (count - len(value)))
+            else:
+                flat.append(value)
+        return self.struct.pack(*flat)
+
+    def unpack(self, payload):
+        #Fields missing from shorter messages (older peers) read as zero.
+        payload = bytes(payload[:self.struct.size]).ljust(self.struct.size, b'\0')
+        flat = self.struct.unpack(payload)
+        values = []
+        i = 0
+        for name, code, count in self.fields:
+            if count and code != 'B':
+                values.append(list(flat[i:i + count]))
+                i += count
+            else:
+                values.append(flat[i])
+                i += 1
+        return values
+
+
+class RpcClient:
+    def __init__(self, port, baud=1000000, timeout=0.05, retries=3):
+        if isinstance(port, str):
+            import serial
+            port = serial.Serial(port, baud, timeout=timeout)
+        self.port = port
+        self.timeout = timeout
+        self.retries = retries
+        self.seq = 0
+        self.rx = bytearray()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def close(self):
+        if hasattr(self.port, 'close'):
+            self.port.close()
+
+    def call(self, method, payload=b''):
+        """Calls a method, returning the response payload."""
+        for attempt in range(self.retries + 1):
+            self.seq = (self.seq + 1) & 0xFF
+            self.port.write(build_frame(self.seq, method, 0, payload))
+
+            response = self.receive(self.seq)
+            if response is None:
+                continue
+
+            status, payload = response
+            if status != STATUS_OK:
+                raise RpcError(method, status)
+            return payload
+
+        raise RpcError(method, None)
+
+    def receive(self, seq):
+        """Waits for the response with the given sequence number, dropping late responses to
+        earlier calls. Returns (status, payload), or None on timeout."""
+        deadline = time.monotonic() + self.timeout
+
+        while True:
+            frame = parse_frame(self.rx)
+            if frame is not None:
+                if frame[0] == seq:
+                    return frame[2], frame[3]
+                continue
+
+            if time.monotonic() > deadline:
+                return None
+            self.rx += self.port.read(max(1, self.port.in_waiting))
+
+
+class Loopback:
+    """Stands in for a serial port, answering requests right away with Python handlers: a dict
+    from method number to a function taking the request payload and returning (status, response
+    payload)."""
+
+    def __init__(self, handlers):
+        self.handlers = handlers
+        self.requests = bytearray()
+        self.responses = bytearray()
+
+    @property
+    def in_waiting(self):
+        return len(self.responses)
+
+    def write(self, data):
+        self.requests += data
+        while True:
+            frame = parse_frame(self.requests)
+            if frame is None:
+                break
+            seq, method, status, payload = frame
+            if method in self.handlers:
+                status, payload = self.handlers[method](payload)
+            else:
+                status, payload = STATUS_METHOD, b''
+            if status != STATUS_OK:
+                payload = b''
+            self.responses += build_frame(seq, method, status, payload)
+
+    def read(self, size):
+        data = bytes(self.responses[:size])
+        del self.responses[:size]
+        return data
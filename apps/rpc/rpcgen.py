@@ -0,0 +1,309 @@
+#!/usr/bin/env python3
+#+-------------------------------------------------------------------------------------------------+
+#| Schema compiler for the binary RPC framework.                                                   |
+#|                                                                                                 |
+#| Reads a schema and writes, next to it (or in the output directory given):                       |
+#| - <name>-rpc.h: method numbers, message sizes and in place field accessors for the requests     |
+#|   and responses of every method, plus the prototypes of the handlers.                           |
+#| - <name>-rpc.c: the method table, and <service>_rpc_init() which hands it to rpc_init().        |
+#| - <name>_rpc.py: a client class for the host, with one call per method.                         |
+#|                                                                                                 |
+#| Schema syntax (one declaration per line, '#' starts a comment):                                 |
+#|   service <name>                                                                                |
+#|   method <number> <name>                                                                        |
+#|     in <type> <field>[<count>]                                                                  |
+#|     out <type> <field>[<count>]                                                                 |
+#|                                                                                                 |
+#| Types are u8, i8, u16, i16, u32, i32 and f32, and the array count is optional. Fields are laid  |
+#| out in order, packed and little endian. Method numbers go from 0 to 254 and should be kept      |
+#| dense, since the method table is indexed by them. Fields may be appended to existing methods    |
+#| without breaking older peers, as missing trailing fields read as zero on both sides.            |
+#|                                                                                                 |
+#| Usage: rpcgen.py schema [-o output directory]                                                   |
+#|                                                                                                 |
+#| Author: Joksan Alvarado.                                                                        |
+#+-------------------------------------------------------------------------------------------------+
+
+import argparse
+import os
+import re
+import sys
+
+#Maximum payload of a frame (RPC_PAYLOAD_SIZE in rpc.h).
+PAYLOAD_SIZE = 248
+
+#Type name: (size, C type, accessor suffix, struct format).
+TYPES = {
+    'u8': (1, 'uint8_t', 'u8', 'B'),
+    'i8': (1, 'int8_t', 'u8', 'b'),
+    'u16': (2, 'uint16_t', 'u16', 'H'),
+    'i16': (2, 'int16_t', 'u16', 'h'),
+    'u32': (4, 'uint32_t', 'u32', 'I'),
+    'i32': (4, 'int32_t', 'u32', 'i'),
+    'f32': (4, 'float', 'f32', 'f'),
+}
+
+IDENTIFIER = r'[A-Za-z_][A-Za-z0-9_]*'
+FIELD = re.compile(r'^(in|out)\s+(\w+)\s+(%s)\s*(?:\[\s*(\d+)\s*\])?$' % IDENTIFIER)
+METHOD = re.compile(r'^method\s+(\d+)\s+(%s)$' % IDENTIFIER)
+SERVICE = re.compile(r'^service\s+(%s)$' % IDENTIFIER)
+
+
+class SchemaError(Exception):
+    """Raised on invalid schemas, with the file and line."""
+
+
+class Field:
+    def __init__(self, name, type, count, offset):
+        self.name = name
+        self.type = type
+        self.count = count
+        self.offset = offset
+        self.size, self.ctype, self.accessor, self.format = TYPES[type]
+
+
+class Message:
+    def __init__(self):
+        self.fields = []
+        self.size = 0
+
+    def add(self, name, type, count):
+        field = Field(name, type, count, self.size)
+        self.fields.append(field)
+        self.size += field.size * (count or 1)
+
+
+class Method:
+    def __init__(self, number, name):
+        self.number = number
+        self.name = name
+        self.request = Message()
+        self.response = Message()
+
+
+def parse(path):
+    """Parses a schema, returning the service name and its methods sorted by number."""
+    service = None
+    methods = []
+    method = None
+
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            where = '%s:%u' % (path, number)
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+
+            m = SERVICE.match(line)
+            if m:
+                if service is not None:
+                    raise SchemaError('%s: service already declared' % where)
+                service = m.group(1)
+                continue
+
+            m = METHOD.match(line)
+            if m:
+                method = Method(int(m.group(1)), m.group(2))
+                if method.number > 254:
+                    raise SchemaError('%s: method number out of range' % where)
+                if any(x.number == method.number or x.name == method.name for x in methods):
+                    raise SchemaError('%s: duplicate method' % where)
+                methods.append(method)
+                continue
+
+            m = FIELD.match(line)
+            if m:
+                if method is None:
+                    raise SchemaError('%s: field outside of a method' % where)
+                if m.group(2) not in TYPES:
+                    raise SchemaError('%s: unknown type %s' % (where, m.group(2)))
+                message = method.request if m.group(1) == 'in' else method.response
+                if any(x.name == m.group(3) for x in message.fields):
+                    raise SchemaError('%s: duplicate field' % where)
+                count = int(m.group(4)) if m.group(4) else 0
+                if m.group(4) and count < 1:
+                    raise SchemaError('%s: empty array' % where)
+                message.add(m.group(3), m.group(2), count)
+                if message.size > PAYLOAD_SIZE:
+                    raise SchemaError('%s: message longer than %u bytes' % (where, PAYLOAD_SIZE))
+                continue
+
+            raise SchemaError('%s: syntax error' % where)
+
+    if service is None:
+        raise SchemaError('%s: no service declared' % path)
+    if not methods:
+        raise SchemaError('%s: no methods declared' % path)
+
+    return service, sorted(methods, key=lambda x: x.number)
+
+
+def box(lines, comment):
+    """Formats a header box, as used across the source tree."""
+    width = 96 if comment == '//' else 97
+    out = [comment + '+' + '-' * width + '+']
+    out += [comment + '| ' + line.ljust(width - 1) + '|' for line in lines]
+    out.append(comment + '+' + '-' * width + '+')
+    return '\n'.join(out) + '\n'
+
+
+def accessors(prefix, message):
+    """Writes the accessors of the fields of a message."""
+    out = []
+
+    for f in message.fields:
+        cast = '' if f.ctype.startswith('u') or f.ctype == 'float' else '(%s) ' % f.ctype
+
+        if f.count:
+            offset = 'i * %u' % f.size if f.size > 1 else 'i'
+            if f.offset:
+                offset = '%u + %s' % (f.offset, offset)
+            out.append('static inline %s %s_get_%s(const struct rpc_msg *m, uint8_t i) {\n'
+                       '  return %srpc_get_%s(m, %s);\n}\n' %
+                       (f.ctype, prefix, f.name, cast, f.accessor, offset))
+            out.append('static inline void %s_set_%s(struct rpc_msg *m, uint8_t i, %s value) {\n'
+                       '  rpc_put_%s(m, %s, value);\n}\n' %
+                       (prefix, f.name, f.ctype, f.accessor, offset))
+            if f.size == 1:
+                out.append('static inline void %s_read_%s(const struct rpc_msg *m, void *data) {\n'
+                           '  rpc_read(m, %u, data, %u);\n}\n' %
+                           (prefix, f.name, f.offset, f.count))
+                out.append('static inline void %s_write_%s(struct rpc_msg *m, const void *data) {\n'
+                           '  rpc_write(m, %u, data, %u);\n}\n' %
+                           (prefix, f.name, f.offset, f.count))
+        else:
+            out.append('static inline %s %s_get_%s(const struct rpc_msg *m) {\n'
+                       '  return %srpc_get_%s(m, %u);\n}\n' %
+                       (f.ctype, prefix, f.name, cast, f.accessor, f.offset))
+            out.append('static inline void %s_set_%s(struct rpc_msg *m, %s value) {\n'
+                       '  rpc_put_%s(m, %u, value);\n}\n' %
+                       (prefix, f.name, f.ctype, f.accessor, f.offset))
+
+    return '\n'.join(out)
+
+
+def c_header(schema, base, service, methods):
+    guard = '%s_RPC_H_' % base.upper().replace('-', '_')
+    out = [box(['Protocol code for the %s service, generated by rpcgen.py from %s.' %
+                (service, schema), '', 'Do not edit: changes belong in the schema.'], '//')]
+    out.append('#ifndef %s\n#define %s\n\n#include <stdint.h>\n\n#include "rpc-msg.h"\n' %
+               (guard, guard))
+
+    out.append('//Method numbers.')
+    for m in methods:
+        out.append('#define %s_%s %u' % (service.upper(), m.name.upper(), m.number))
+    out.append('')
+
+    for m in methods:
+        prefix = '%s_%s' % (service, m.name)
+        out.append('//+' + '-' * 96 + '+')
+        out.append(('//| Method %u: %s.' % (m.number, m.name)).ljust(99) + '|')
+        out.append('//+' + '-' * 96 + '+\n')
+        out.append('#define %s_REQUEST_SIZE %u' % (prefix.upper(), m.request.size))
+        out.append('#define %s_RESPONSE_SIZE %u\n' % (prefix.upper(), m.response.size))
+        if m.request.fields:
+            out.append(accessors(prefix + '_request', m.request))
+        if m.response.fields:
+            out.append(accessors(prefix + '_response', m.response))
+
+    out.append('//Handlers, implemented by the application. They return the response status.')
+    for m in methods:
+        out.append('uint8_t %s_%s(const struct rpc_msg *request, struct rpc_msg *response);' %
+                   (service, m.name))
+    out.append('\n//Starts serving the methods above.\nvoid %s_rpc_init();\n' % service)
+    out.append('#endif //%s' % guard)
+
+    return '\n'.join(out) + '\n'
+
+
+def c_source(schema, base, service, methods):
+    out = [box(['Method table of the %s service, generated by rpcgen.py from %s.' %
+                (service, schema), '', 'Do not edit: changes belong in the schema.'], '//')]
+    out.append('#include <stddef.h>\n\n#include "rpc.h"\n#include "%s-rpc.h"\n' % base)
+
+    out.append('static const struct rpc_method methods[] = {')
+    by_number = dict((m.number, m) for m in methods)
+    for number in range(methods[-1].number + 1):
+        m = by_number.get(number)
+        if m is None:
+            out.append('  { NULL, 0 },')
+        else:
+            out.append('  { %s_%s, %s_%s_RESPONSE_SIZE },' %
+                       (service, m.name, service.upper(), m.name.upper()))
+    out.append('};\n')
+
+    out.append('void %s_rpc_init() {' % service)
+    out.append('  rpc_init(methods, sizeof(methods) / sizeof(methods[0]));')
+    out.append('}')
+
+    return '\n'.join(out) + '\n'
+
+
+def python_layout(name, message):
+    fields = ["('%s', '%s', %u)" % (f.name, f.format, f.count) for f in message.fields]
+    line = '%s = rpc_client.Layout([%s])' % (name, ', '.join(fields))
+    if len(line) <= 100:
+        return line
+    return '%s = rpc_client.Layout([\n%s])' % (name, ''.join('    %s,\n' % x for x in fields))
+
+
+def python_module(schema, service, methods):
+    out = [box(['Client for the %s service, generated by rpcgen.py from %s.' % (service, schema),
+                '', 'Do not edit: changes belong in the schema.'], '#')]
+    out.append('import collections\n\nimport rpc_client\n')
+
+    out.append('#Method numbers.')
+    for m in methods:
+        out.append('%s_%s = %u' % (service.upper(), m.name.upper(), m.number))
+    out.append('')
+
+    for m in methods:
+        out.append(python_layout(m.name.upper() + '_REQUEST', m.request))
+        out.append(python_layout(m.name.upper() + '_RESPONSE', m.response))
+        name = ''.join(x.capitalize() for x in m.name.split('_')) + 'Response'
+        out.append("%s = collections.namedtuple('%s', %s)\n" %
+                   (name, name, [f.name for f in m.response.fields]))
+
+    out.append('\nclass %s(rpc_client.RpcClient):' % ''.join(x.capitalize()
+                                                              for x in service.split('_')))
+    for m in methods:
+        name = ''.join(x.capitalize() for x in m.name.split('_')) + 'Response'
+        args = ''.join(', ' + f.name for f in m.request.fields)
+        values = ', '.join(f.name for f in m.request.fields)
+        out.append('    def %s(self%s):' % (m.name, args))
+        out.append('        payload = self.call(%s_%s, %s_REQUEST.pack(%s))' %
+                   (service.upper(), m.name.upper(), m.name.upper(), values))
+        out.append('        return %s._make(%s_RESPONSE.unpack(payload))\n' %
+                   (name, m.name.upper()))
+
+    return '\n'.join(out).rstrip() + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compiles an RPC schema into C and Python code.')
+    parser.add_argument('schema', help='schema file')
+    parser.add_argument('-o', '--output', help='output directory (default: next to the schema)')
+    args = parser.parse_args()
+
+    try:
+        service, methods = parse(args.schema)
+    except (SchemaError, OSError) as e:
+        sys.exit('rpcgen: %s' % e)
+
+    directory = args.output or os.path.dirname(args.schema) or '.'
+    base = os.path.splitext(os.path.basename(args.schema))[0]
+    schema = os.path.basename(args.schema)
+
+    outputs = {
+        '%s-rpc.h' % base: c_header(schema, base, service, methods),
+        '%s-rpc.c' % base: c_source(schema, base, service, methods),
+        '%s_rpc.py' % base.replace('-', '_'): python_module(schema, service, methods),
+    }
+
+    for name, text in outputs.items():
+        with open(os.path.join(directory, name), 'w') as f:
+            f.write(text)
+
+
+if __name__ == '__main__':
+    main()
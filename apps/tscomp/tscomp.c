@@ -0,0 +1,422 @@
+//+------------------------------------------------------------------------------------------------+
+//| Time series sample compression.                                                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <string.h>
+
+#include "tscomp.h"
+
+//Leading zero count of the XOR window before the first window is set.
+#define NO_WINDOW 0xFF
+
+//Rice coding of integer differences: the running mean of the coded values is kept scaled by
+//2^RICE_SHIFT, starting at RICE_INITIAL, and quotients of RICE_ESCAPE or more are escaped (the
+//value follows in 32 bits).
+#define RICE_SHIFT    4
+#define RICE_INITIAL  (16 << RICE_SHIFT)
+#define RICE_ESCAPE   16
+#define RICE_CLAMP    0xFFFFFF
+
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+  return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+}
+
+//Returns the Rice parameter for the given running mean (about its base 2 logarithm).
+static uint8_t rice_parameter(uint32_t mean) {
+  mean >>= RICE_SHIFT;
+  return mean ? 31 - __builtin_clz(mean) : 0;
+}
+
+//Updates the running mean with a coded value.
+static uint32_t rice_update(uint32_t mean, uint32_t value) {
+  return mean + (value < RICE_CLAMP ? value : RICE_CLAMP) - (mean >> RICE_SHIFT);
+}
+
+//--------------------------------------------------------------------------------------------------
+//Encoder.
+
+//Appends up to 32 bits to the block, most significant first. Bits past the end of the block set
+//the overflow flag instead.
+static void write_bits(struct tscomp_encoder *e, uint32_t value, uint8_t count) {
+  uint8_t *byte;
+  uint8_t offset;
+  uint8_t take;
+
+  if (e->overflow || e->bits + count > e->limit) {
+    e->overflow = 1;
+    return;
+  }
+
+  while (count > 0) {
+    byte = &e->data[e->bits >> 3];
+    offset = e->bits & 7;
+    if (offset == 0)
+      *byte = 0;
+
+    take = 8 - offset;
+    if (take > count)
+      take = count;
+
+    *byte |= ((value >> (count - take)) & ((1 << take) - 1)) << (8 - offset - take);
+    e->bits += take;
+    count -= take;
+  }
+}
+
+//Writes the timestamp of a sample, returning the new delta.
+static int32_t write_timestamp(struct tscomp_encoder *e, uint32_t timestamp) {
+  int32_t delta;
+  uint32_t dod;
+
+  if (e->count == 0) {
+    write_bits(e, timestamp, 32);
+    return 0;
+  }
+
+  delta = timestamp - e->timestamp;
+  dod = zigzag((uint32_t) delta - (uint32_t) e->delta);
+
+  if (dod == 0)
+    write_bits(e, 0x0, 1);
+  else if (dod < (1 << 7))
+    write_bits(e, (0x2 << 7) | dod, 2 + 7);
+  else if (dod < (1 << 9))
+    write_bits(e, (0x6 << 9) | dod, 3 + 9);
+  else if (dod < (1 << 12))
+    write_bits(e, (0xE << 12) | dod, 4 + 12);
+  else {
+    write_bits(e, 0xF, 4);
+    write_bits(e, dod, 32);
+  }
+
+  return delta;
+}
+
+//Ends a sample: commits the new state, or rolls the block back to the previous sample if the new
+//one didn't fit.
+static int end_sample(struct tscomp_encoder *e, uint32_t start, uint32_t timestamp,
+                      int32_t delta, uint32_t value) {
+  if (e->overflow) {
+    e->overflow = 0;
+    e->bits = start;
+
+    //Clear the bits of the sample left in the last byte.
+    if (start & 7)
+      e->data[start >> 3] &= 0xFF << (8 - (start & 7));
+
+    return TSCOMP_FULL;
+  }
+
+  e->timestamp = timestamp;
+  e->delta = delta;
+  e->value = value;
+  e->count++;
+  return TSCOMP_OK;
+}
+
+//Starts a block of the given format (TSCOMP_FLOAT or TSCOMP_INT) in a buffer of the given size.
+void tscomp_encoder_init(struct tscomp_encoder *e, void *block, uint16_t size, uint8_t format) {
+  e->data = block;
+  e->bits = TSCOMP_HEADER_SIZE * 8;
+  e->limit = (uint32_t) size * 8;
+  e->timestamp = 0;
+  e->delta = 0;
+  e->value = 0;
+  e->count = 0;
+  e->format = format;
+  e->leading = NO_WINDOW;
+  e->trailing = 0;
+  e->rice = RICE_INITIAL;
+  e->overflow = 0;
+}
+
+//Appends a sample to a float block. Returns TSCOMP_FULL if it doesn't fit (the block is left as
+//it was).
+int tscomp_put_float(struct tscomp_encoder *e, uint32_t timestamp, float value) {
+  uint32_t start = e->bits;
+  uint32_t bits;
+  uint32_t xor;
+  uint8_t leading;
+  uint8_t trailing;
+  uint8_t leading_prev = e->leading;
+  uint8_t trailing_prev = e->trailing;
+  int32_t delta;
+
+  if (e->format != TSCOMP_FLOAT)
+    return TSCOMP_ERR_FORMAT;
+  if (e->count == 0xFFFF)
+    return TSCOMP_FULL;
+
+  memcpy(&bits, &value, 4);
+  delta = write_timestamp(e, timestamp);
+
+  if (e->count == 0)
+    write_bits(e, bits, 32);
+  else {
+    xor = bits ^ e->value;
+
+    if (xor == 0)
+      write_bits(e, 0x0, 1);
+    else {
+      leading = __builtin_clz(xor);
+      trailing = __builtin_ctz(xor);
+
+      if (e->leading != NO_WINDOW && leading >= e->leading && trailing >= e->trailing) {
+        //Meaningful bits within the previous window.
+        write_bits(e, 0x2, 2);
+        write_bits(e, xor >> e->trailing, 32 - e->leading - e->trailing);
+      }
+      else {
+        //New window: leading zeros (5 bits), meaningful bits minus one (5 bits), then the bits.
+        write_bits(e, (0x3 << 10) | (leading << 5) | (31 - leading - trailing), 2 + 5 + 5);
+        write_bits(e, xor >> trailing, 32 - leading - trailing);
+        e->leading = leading;
+        e->trailing = trailing;
+      }
+    }
+  }
+
+  if (end_sample(e, start, timestamp, delta, bits) != TSCOMP_OK) {
+    e->leading = leading_prev;
+    e->trailing = trailing_prev;
+    return TSCOMP_FULL;
+  }
+
+  return TSCOMP_OK;
+}
+
+//Appends a sample to an integer block. Returns TSCOMP_FULL if it doesn't fit (the block is left
+//as it was).
+int tscomp_put_int(struct tscomp_encoder *e, uint32_t timestamp, int32_t value) {
+  uint32_t start = e->bits;
+  uint32_t coded;
+  uint32_t quotient;
+  uint8_t k;
+  int32_t delta;
+
+  if (e->format != TSCOMP_INT)
+    return TSCOMP_ERR_FORMAT;
+  if (e->count == 0xFFFF)
+    return TSCOMP_FULL;
+
+  delta = write_timestamp(e, timestamp);
+
+  //Quotient in unary (ones ended by a zero), then the k low bits.
+  coded = zigzag((uint32_t) value - e->value);
+  k = rice_parameter(e->rice);
+  quotient = coded >> k;
+
+  if (quotient < RICE_ESCAPE) {
+    write_bits(e, ((1 << quotient) - 1) << 1, quotient + 1);
+    write_bits(e, coded & ((1u << k) - 1), k);
+  }
+  else {
+    write_bits(e, (1 << RICE_ESCAPE) - 1, RICE_ESCAPE);
+    write_bits(e, coded, 32);
+  }
+
+  if (end_sample(e, start, timestamp, delta, value) != TSCOMP_OK)
+    return TSCOMP_FULL;
+
+  e->rice = rice_update(e->rice, coded);
+  return TSCOMP_OK;
+}
+
+//Appends evenly spaced unsigned samples (e.g. a block of ADC results moved by DMA) to an integer
+//block, the first one taken at the given timestamp. Returns the number of samples appended, less
+//than count if the block filled up.
+uint16_t tscomp_put_samples(struct tscomp_encoder *e, uint32_t timestamp, uint32_t interval,
+                            const uint16_t *samples, uint16_t count) {
+  uint16_t i;
+
+  for (i = 0; i < count; i++) {
+    if (tscomp_put_int(e, timestamp, samples[i]) != TSCOMP_OK)
+      break;
+    timestamp += interval;
+  }
+
+  return i;
+}
+
+//Writes the header of the block. Returns its length in bytes. Samples can still be appended after
+//it (e.g. to store a partial block and go on filling it), and the block finished again.
+uint16_t tscomp_finish(struct tscomp_encoder *e) {
+  if (e->limit < TSCOMP_HEADER_SIZE * 8)
+    return 0;
+
+  e->data[0] = e->format;
+  e->data[1] = e->count;
+  e->data[2] = e->count >> 8;
+  return (e->bits + 7) >> 3;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Decoder.
+
+//Reads up to 32 bits from the block. Reading past the end sets the overflow flag.
+static uint32_t read_bits(struct tscomp_decoder *d, uint8_t count) {
+  uint32_t value = 0;
+  uint8_t offset;
+  uint8_t take;
+
+  if (d->overflow || d->bits + count > d->limit) {
+    d->overflow = 1;
+    return 0;
+  }
+
+  while (count > 0) {
+    offset = d->bits & 7;
+    take = 8 - offset;
+    if (take > count)
+      take = count;
+
+    value = (value << take) | ((d->data[d->bits >> 3] >> (8 - offset - take)) & ((1 << take) - 1));
+    d->bits += take;
+    count -= take;
+  }
+
+  return value;
+}
+
+//Reads the timestamp of the next sample.
+static uint32_t read_timestamp(struct tscomp_decoder *d, int32_t *delta) {
+  uint32_t dod;
+
+  if (d->index == 0) {
+    *delta = 0;
+    return read_bits(d, 32);
+  }
+
+  if (read_bits(d, 1) == 0)
+    dod = 0;
+  else if (read_bits(d, 1) == 0)
+    dod = read_bits(d, 7);
+  else if (read_bits(d, 1) == 0)
+    dod = read_bits(d, 9);
+  else if (read_bits(d, 1) == 0)
+    dod = read_bits(d, 12);
+  else
+    dod = read_bits(d, 32);
+
+  *delta = (uint32_t) d->delta + (uint32_t) unzigzag(dod);
+  return d->timestamp + *delta;
+}
+
+//Starts decoding a block. Returns TSCOMP_ERR_INVALID if its header isn't valid.
+int tscomp_decoder_init(struct tscomp_decoder *d, const void *block, uint16_t length) {
+  d->data = block;
+  d->bits = TSCOMP_HEADER_SIZE * 8;
+  d->limit = (uint32_t) length * 8;
+  d->timestamp = 0;
+  d->delta = 0;
+  d->value = 0;
+  d->index = 0;
+  d->leading = NO_WINDOW;
+  d->trailing = 0;
+  d->rice = RICE_INITIAL;
+  d->overflow = 0;
+
+  if (length < TSCOMP_HEADER_SIZE) {
+    d->count = 0;
+    return TSCOMP_ERR_INVALID;
+  }
+
+  d->format = d->data[0];
+  d->count = d->data[1] | (d->data[2] << 8);
+
+  if (d->format != TSCOMP_FLOAT && d->format != TSCOMP_INT) {
+    d->count = 0;
+    return TSCOMP_ERR_INVALID;
+  }
+
+  return TSCOMP_OK;
+}
+
+//Reads the next sample of a float block. Returns TSCOMP_END after the last one.
+int tscomp_get_float(struct tscomp_decoder *d, uint32_t *timestamp, float *value) {
+  uint32_t time;
+  uint32_t bits;
+  uint8_t meaningful;
+  int32_t delta;
+
+  if (d->format != TSCOMP_FLOAT)
+    return TSCOMP_ERR_FORMAT;
+  if (d->index == d->count)
+    return TSCOMP_END;
+
+  time = read_timestamp(d, &delta);
+
+  if (d->index == 0)
+    bits = read_bits(d, 32);
+  else if (read_bits(d, 1) == 0)
+    bits = d->value;
+  else {
+    if (read_bits(d, 1) != 0) {
+      d->leading = read_bits(d, 5);
+      meaningful = read_bits(d, 5) + 1;
+      if (d->leading + meaningful > 32)
+        return TSCOMP_ERR_INVALID;
+      d->trailing = 32 - d->leading - meaningful;
+    }
+    else if (d->leading == NO_WINDOW)
+      return TSCOMP_ERR_INVALID;
+
+    bits = d->value ^ (read_bits(d, 32 - d->leading - d->trailing) << d->trailing);
+  }
+
+  if (d->overflow)
+    return TSCOMP_ERR_INVALID;
+
+  d->timestamp = time;
+  d->delta = delta;
+  d->value = bits;
+  d->index++;
+
+  *timestamp = time;
+  memcpy(value, &bits, 4);
+  return TSCOMP_OK;
+}
+
+//Reads the next sample of an integer block. Returns TSCOMP_END after the last one.
+int tscomp_get_int(struct tscomp_decoder *d, uint32_t *timestamp, int32_t *value) {
+  uint32_t time;
+  uint32_t coded;
+  uint32_t quotient = 0;
+  uint8_t k;
+  int32_t delta;
+
+  if (d->format != TSCOMP_INT)
+    return TSCOMP_ERR_FORMAT;
+  if (d->index == d->count)
+    return TSCOMP_END;
+
+  time = read_timestamp(d, &delta);
+
+  k = rice_parameter(d->rice);
+  while (quotient < RICE_ESCAPE && read_bits(d, 1) != 0)
+    quotient++;
+
+  if (quotient < RICE_ESCAPE)
+    coded = (quotient << k) | read_bits(d, k);
+  else
+    coded = read_bits(d, 32);
+
+  if (d->overflow)
+    return TSCOMP_ERR_INVALID;
+
+  d->timestamp = time;
+  d->delta = delta;
+  d->value += (uint32_t) unzigzag(coded);
+  d->rice = rice_update(d->rice, coded);
+  d->index++;
+
+  *timestamp = time;
+  *value = d->value;
+  return TSCOMP_OK;
+}
@@ -0,0 +1,89 @@
+//+------------------------------------------------------------------------------------------------+
+//| Time series sample compression.                                                                |
+//|                                                                                                |
+//| Compresses streams of timestamped samples into fixed size blocks, each one decodable on its    |
+//| own (a flash page, an SD card sector or a packet payload), following the Gorilla scheme:       |
+//| - Timestamps are stored as the difference between consecutive deltas (delta of delta), zig-zag |
+//|   encoded in buckets of 7, 9, 12 or 32 bits, or as a single bit when the sample period holds.  |
+//| - Float values are XORed with the previous one. Unchanged values take a single bit, and the    |
+//|   meaningful bits of the rest are stored within the leading and trailing zero window of the    |
+//|   previous value when they fit (2 bits of overhead) or with a new window (12 bits).            |
+//| - Integer values (ADC results, counters) are stored as the zig-zag encoded difference from the |
+//|   previous one, Rice coded (a bit granular varint) with a parameter that follows the running   |
+//|   mean of the differences, so steady signals take a few bits per sample.                       |
+//|                                                                                                |
+//| Blocks are filled a sample at a time, and a sample that doesn't fit is left out whole, so the  |
+//| caller can finish the block, hand it over (to a storage writer or the radio) and start another |
+//| one with the same sample. Encoding takes constant time per sample, never allocates memory and  |
+//| keeps all its state in the encoder, so it can run from interrupt handlers (e.g. on DMA         |
+//| completion), as long as each encoder is used from a single context.                            |
+//|                                                                                                |
+//| Block layout: format (1 byte), sample count (2 bytes, little endian), bit stream (MSB first).  |
+//|                                                                                                |
+//| This module doesn't depend on contiki, so it builds on the host as is.                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef TSCOMP_H_
+#define TSCOMP_H_
+
+#include <stdint.h>
+
+//Block formats.
+#define TSCOMP_FLOAT  1
+#define TSCOMP_INT    2
+
+//Size of the block header.
+#define TSCOMP_HEADER_SIZE 3
+
+//Return codes.
+#define TSCOMP_OK           0
+#define TSCOMP_FULL         -1  //Sample doesn't fit in the block
+#define TSCOMP_END          -2  //No more samples in the block
+#define TSCOMP_ERR_FORMAT   -3  //Sample of another format than the block's
+#define TSCOMP_ERR_INVALID  -4  //Corrupted block
+
+struct tscomp_encoder {
+  uint8_t *data;
+  uint32_t bits;            //Bits written, header included
+  uint32_t limit;           //Size of the block, in bits
+  uint32_t timestamp;       //Previous sample
+  int32_t delta;
+  uint32_t value;
+  uint32_t rice;            //Running mean of the coded differences (integers)
+  uint16_t count;
+  uint8_t format;
+  uint8_t leading;          //Window of the previous XOR (floats)
+  uint8_t trailing;
+  uint8_t overflow;
+};
+
+struct tscomp_decoder {
+  const uint8_t *data;
+  uint32_t bits;            //Bits read, header included
+  uint32_t limit;           //Size of the block, in bits
+  uint32_t timestamp;       //Previous sample
+  int32_t delta;
+  uint32_t value;
+  uint32_t rice;
+  uint16_t count;
+  uint16_t index;
+  uint8_t format;
+  uint8_t leading;
+  uint8_t trailing;
+  uint8_t overflow;
+};
+
+void tscomp_encoder_init(struct tscomp_encoder *e, void *block, uint16_t size, uint8_t format);
+int tscomp_put_float(struct tscomp_encoder *e, uint32_t timestamp, float value);
+int tscomp_put_int(struct tscomp_encoder *e, uint32_t timestamp, int32_t value);
+uint16_t tscomp_put_samples(struct tscomp_encoder *e, uint32_t timestamp, uint32_t interval,
+                            const uint16_t *samples, uint16_t count);
+uint16_t tscomp_finish(struct tscomp_encoder *e);
+
+int tscomp_decoder_init(struct tscomp_decoder *d, const void *block, uint16_t length);
+int tscomp_get_float(struct tscomp_decoder *d, uint32_t *timestamp, float *value);
+int tscomp_get_int(struct tscomp_decoder *d, uint32_t *timestamp, int32_t *value);
+
+#endif //TSCOMP_H_
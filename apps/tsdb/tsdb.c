@@ -0,0 +1,606 @@
+//+------------------------------------------------------------------------------------------------+
+//| Append only time series store.                                                                 |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <string.h>
+
+#include "tsdb.h"
+
+#define MAGIC   0x42445354    //"TSDB"
+#define VERSION 1
+
+//Block number of empty caches.
+#define NONE 0xFFFFFFFF
+
+#define ENTRIES_PER_BLOCK (TSDB_BLOCK_SIZE / sizeof(struct tsdb_entry))
+#define ROLLUPS_PER_BLOCK (TSDB_BLOCK_SIZE / sizeof(struct tsdb_rollup))
+
+struct superblock {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t tag;
+  struct tsdb_config config;
+};
+
+//Length of the rollup periods, in seconds.
+static const uint16_t period_seconds[TSDB_LEVELS] = {1, 60, 3600};
+
+//--------------------------------------------------------------------------------------------------
+//Device access and caches.
+
+static int device_read(struct tsdb *db, uint32_t block, void *buffer) {
+  db->reads++;
+  if (db->device->read(db->device->start + block, buffer, 1) != 0)
+    return TSDB_ERR_IO;
+
+  return TSDB_OK;
+}
+
+static int device_write(struct tsdb *db, uint32_t block, const void *buffer) {
+  if (block == db->scratch_block)
+    db->scratch_block = NONE;
+
+  db->writes++;
+  if (db->device->write(db->device->start + block, buffer, 1) != 0)
+    return TSDB_ERR_IO;
+
+  return TSDB_OK;
+}
+
+//Reads a block into the scratch buffer, unless it's there already.
+static int read_scratch(struct tsdb *db, uint32_t block) {
+  int error;
+
+  if (db->scratch_block == block)
+    return TSDB_OK;
+
+  db->scratch_block = NONE;
+  error = device_read(db, block, db->scratch);
+  if (error == TSDB_OK)
+    db->scratch_block = block;
+
+  return error;
+}
+
+//Computes the layout of the region. Returns the number of blocks it takes.
+static uint32_t layout(struct tsdb *db) {
+  uint32_t next;
+  uint8_t level;
+
+  db->index_start = 1;
+  next = 1 + (db->config.data_blocks + ENTRIES_PER_BLOCK - 1) / ENTRIES_PER_BLOCK;
+
+  for (level = 0; level < TSDB_LEVELS; level++) {
+    db->rollup_start[level] = next;
+    next += (db->config.rollups[level] + ROLLUPS_PER_BLOCK - 1) / ROLLUPS_PER_BLOCK;
+    db->period_ticks[level] = db->config.ticks_per_second * period_seconds[level];
+  }
+
+  db->data_start = next;
+  return next + db->config.data_blocks;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Index.
+
+static uint32_t data_slot(struct tsdb *db, uint32_t seq) {
+  return (seq - 1) % db->config.data_blocks;
+}
+
+//Reads the index entry of a data ring slot. Entries of other stores come back with a sequence
+//number of 0.
+static int read_slot_entry(struct tsdb *db, uint32_t slot, struct tsdb_entry *entry) {
+  uint32_t block = db->index_start + slot / ENTRIES_PER_BLOCK;
+  const uint8_t *src;
+  int error;
+
+  if (block == db->index_block)
+    src = (const uint8_t *) db->index;
+  else {
+    error = read_scratch(db, block);
+    if (error != TSDB_OK)
+      return error;
+    src = (const uint8_t *) db->scratch;
+  }
+
+  memcpy(entry, src + slot % ENTRIES_PER_BLOCK * sizeof(*entry), sizeof(*entry));
+  if (entry->tag != db->tag)
+    entry->seq = 0;
+
+  return TSDB_OK;
+}
+
+//Gets the index entry of a data block, the open one included. If the block was overwritten (or
+//never written), the entry comes back with another sequence number.
+static int get_entry(struct tsdb *db, uint32_t seq, struct tsdb_entry *entry) {
+  if (seq == db->seq) {
+    *entry = db->entry;
+    return TSDB_OK;
+  }
+
+  return read_slot_entry(db, data_slot(db, seq), entry);
+}
+
+//Writes the index entry of a data block.
+static int put_entry(struct tsdb *db, const struct tsdb_entry *entry) {
+  uint32_t slot = data_slot(db, entry->seq);
+  uint32_t block = db->index_start + slot / ENTRIES_PER_BLOCK;
+  int error;
+
+  //Other entries of the block stay valid, so it's read first.
+  if (block != db->index_block) {
+    db->index_block = NONE;
+    error = device_read(db, block, db->index);
+    if (error != TSDB_OK)
+      return error;
+    db->index_block = block;
+  }
+
+  memcpy((uint8_t *) db->index + slot % ENTRIES_PER_BLOCK * sizeof(*entry), entry,
+         sizeof(*entry));
+  return device_write(db, block, db->index);
+}
+
+//--------------------------------------------------------------------------------------------------
+//Rollups.
+
+static uint32_t rollup_block(struct tsdb *db, uint8_t level, uint32_t period) {
+  return db->rollup_start[level] + period % db->config.rollups[level] / ROLLUPS_PER_BLOCK;
+}
+
+static uint8_t *rollup_record(struct tsdb *db, uint8_t level, uint32_t period) {
+  return (uint8_t *) db->rollup[level] +
+         period % db->config.rollups[level] % ROLLUPS_PER_BLOCK * sizeof(struct tsdb_rollup);
+}
+
+//Brings the block holding the rollup of a period into the cache of its level, writing back the
+//previous one if needed.
+static int cache_rollup(struct tsdb *db, uint8_t level, uint32_t period) {
+  uint32_t block = rollup_block(db, level, period);
+  int error;
+
+  if (db->rollup_block[level] == block)
+    return TSDB_OK;
+
+  if (db->rollup_dirty[level]) {
+    error = device_write(db, db->rollup_block[level], db->rollup[level]);
+    if (error != TSDB_OK)
+      return error;
+    db->rollup_dirty[level] = 0;
+  }
+
+  db->rollup_block[level] = NONE;
+  error = device_read(db, block, db->rollup[level]);
+  if (error == TSDB_OK)
+    db->rollup_block[level] = block;
+
+  return error;
+}
+
+//Stores a rollup in the cache.
+static int store_rollup(struct tsdb *db, uint8_t level, const struct tsdb_rollup *record) {
+  int error;
+
+  error = cache_rollup(db, level, record->period);
+  if (error != TSDB_OK)
+    return error;
+
+  memcpy(rollup_record(db, level, record->period), record, sizeof(*record));
+  db->rollup_dirty[level] = 1;
+  return TSDB_OK;
+}
+
+//Gets the rollup of a period, without disturbing the caches. Periods with no samples (or no
+//longer kept) come back with a count of 0.
+static int get_rollup(struct tsdb *db, uint8_t level, uint32_t period,
+                      struct tsdb_rollup *record) {
+  uint32_t block = rollup_block(db, level, period);
+  const uint8_t *src;
+  int error;
+
+  if (db->live[level].count > 0 && db->live[level].period == period) {
+    *record = db->live[level];
+    return TSDB_OK;
+  }
+
+  if (block == db->rollup_block[level])
+    src = rollup_record(db, level, period);
+  else {
+    error = read_scratch(db, block);
+    if (error != TSDB_OK)
+      return error;
+    src = (const uint8_t *) db->scratch +
+          period % db->config.rollups[level] % ROLLUPS_PER_BLOCK * sizeof(*record);
+  }
+
+  memcpy(record, src, sizeof(*record));
+  if (record->tag != db->tag || record->period != period) {
+    memset(record, 0, sizeof(*record));
+    record->period = period;
+  }
+
+  return TSDB_OK;
+}
+
+//Adds a sample to the live rollups, storing the ones of the periods it leaves behind. Periods
+//resumed after a mount continue from their stored rollup.
+static int update_rollups(struct tsdb *db, uint32_t timestamp, float value) {
+  struct tsdb_rollup *live;
+  uint32_t period;
+  uint8_t level;
+  int error;
+
+  for (level = 0; level < TSDB_LEVELS; level++) {
+    live = &db->live[level];
+    period = timestamp / db->period_ticks[level];
+
+    if (live->count == 0 || live->period != period) {
+      if (live->count > 0) {
+        error = store_rollup(db, level, live);
+        if (error != TSDB_OK)
+          return error;
+      }
+
+      error = cache_rollup(db, level, period);
+      if (error != TSDB_OK)
+        return error;
+
+      memcpy(live, rollup_record(db, level, period), sizeof(*live));
+      if (live->tag != db->tag || live->period != period) {
+        memset(live, 0, sizeof(*live));
+        live->period = period;
+        live->block = db->seq;
+        live->tag = db->tag;
+      }
+    }
+
+    if (live->count == 0 || value < live->min)
+      live->min = value;
+    if (live->count == 0 || value > live->max)
+      live->max = value;
+    live->sum += value;
+    live->count++;
+  }
+
+  return TSDB_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Data blocks.
+
+static void open_block(struct tsdb *db) {
+  tscomp_encoder_init(&db->encoder, db->data, TSDB_BLOCK_SIZE, TSCOMP_FLOAT);
+  memset(&db->entry, 0, sizeof(db->entry));
+  db->entry.seq = db->seq;
+  db->entry.tag = db->tag;
+}
+
+//Writes the open data block as it is, and its index entry.
+static int write_block(struct tsdb *db) {
+  int error;
+
+  tscomp_finish(&db->encoder);
+  error = device_write(db, db->data_start + data_slot(db, db->seq), db->data);
+  if (error != TSDB_OK)
+    return error;
+
+  return put_entry(db, &db->entry);
+}
+
+//--------------------------------------------------------------------------------------------------
+//Interface.
+
+//Creates an empty store in the region of the device, then mounts it. Records of a previous store
+//in the region are told apart by their tag, so nothing else has to be erased.
+int tsdb_format(struct tsdb *db, const struct tsdb_device *device,
+                const struct tsdb_config *config) {
+  struct superblock *super = (struct superblock *) db->scratch;
+  uint32_t tag = 1;
+  uint8_t level;
+  int error;
+
+  db->device = device;
+  db->config = *config;
+  db->scratch_block = NONE;
+
+  if (config->ticks_per_second == 0 || config->data_blocks < 2)
+    return TSDB_ERR_RANGE;
+  for (level = 0; level < TSDB_LEVELS; level++) {
+    if (config->rollups[level] == 0)
+      return TSDB_ERR_RANGE;
+  }
+  if (layout(db) > device->blocks)
+    return TSDB_ERR_RANGE;
+
+  error = device_read(db, 0, db->scratch);
+  if (error != TSDB_OK)
+    return error;
+  if (super->magic == MAGIC && super->tag + 1 != 0)
+    tag = super->tag + 1;
+
+  memset(db->scratch, 0, TSDB_BLOCK_SIZE);
+  super->magic = MAGIC;
+  super->version = VERSION;
+  super->tag = tag;
+  super->config = *config;
+
+  error = device_write(db, 0, db->scratch);
+  if (error != TSDB_OK)
+    return error;
+
+  return tsdb_mount(db, device);
+}
+
+//Opens the store in the region of the device, finding the last data block written (with a binary
+//search of the index). Appending resumes on a new data block.
+int tsdb_mount(struct tsdb *db, const struct tsdb_device *device) {
+  struct superblock *super = (struct superblock *) db->scratch;
+  struct tsdb_entry entry;
+  uint32_t first, low, high, middle;
+  uint8_t level;
+  int error;
+
+  db->device = device;
+  db->index_block = NONE;
+  db->scratch_block = NONE;
+  db->reads = 0;
+  db->writes = 0;
+  for (level = 0; level < TSDB_LEVELS; level++) {
+    db->rollup_block[level] = NONE;
+    db->rollup_dirty[level] = 0;
+  }
+  memset(db->live, 0, sizeof(db->live));
+
+  error = device_read(db, 0, db->scratch);
+  if (error != TSDB_OK)
+    return error;
+  if (super->magic != MAGIC || super->version != VERSION)
+    return TSDB_ERR_FORMAT;
+
+  db->tag = super->tag;
+  db->config = super->config;
+  if (db->config.ticks_per_second == 0 || db->config.data_blocks < 2 ||
+      layout(db) > device->blocks)
+    return TSDB_ERR_FORMAT;
+
+  //The ring holds consecutive sequence numbers from slot 0 up to the last block written, and
+  //older (or no) blocks after it.
+  db->seq = 0;
+  error = read_slot_entry(db, 0, &entry);
+  if (error != TSDB_OK)
+    return error;
+  first = entry.seq;
+
+  if (first != 0) {
+    low = 0;
+    high = db->config.data_blocks - 1;
+    while (low < high) {
+      middle = (low + high + 1) / 2;
+      error = read_slot_entry(db, middle, &entry);
+      if (error != TSDB_OK)
+        return error;
+
+      if (entry.seq >= first)
+        low = middle;
+      else
+        high = middle - 1;
+    }
+
+    error = read_slot_entry(db, low, &entry);
+    if (error != TSDB_OK)
+      return error;
+    db->last = entry.last;
+  }
+
+  db->seq = entry.seq + 1;
+  if (first == 0) {
+    db->seq = 1;
+    db->last = 0;
+  }
+
+  open_block(db);
+  return TSDB_OK;
+}
+
+//Appends a sample. Timestamps must not decrease.
+int tsdb_append(struct tsdb *db, uint32_t timestamp, float value) {
+  int error;
+
+  if (timestamp < db->last && (db->seq > 1 || db->entry.count > 0))
+    return TSDB_ERR_ORDER;
+
+  error = update_rollups(db, timestamp, value);
+  if (error != TSDB_OK)
+    return error;
+
+  //Full block: write it and start the next one.
+  if (tscomp_put_float(&db->encoder, timestamp, value) != TSCOMP_OK) {
+    error = write_block(db);
+    if (error != TSDB_OK)
+      return error;
+
+    db->seq++;
+    open_block(db);
+    tscomp_put_float(&db->encoder, timestamp, value);
+  }
+
+  if (db->entry.count == 0) {
+    db->entry.first = timestamp;
+    db->entry.min = value;
+    db->entry.max = value;
+  }
+  else if (value < db->entry.min)
+    db->entry.min = value;
+  else if (value > db->entry.max)
+    db->entry.max = value;
+
+  db->entry.last = timestamp;
+  db->entry.count++;
+  db->last = timestamp;
+  return TSDB_OK;
+}
+
+//Writes everything pending: the live rollups, the cached rollup blocks and the partial data block
+//(which keeps filling up afterwards).
+int tsdb_sync(struct tsdb *db) {
+  uint8_t level;
+  int error;
+
+  for (level = 0; level < TSDB_LEVELS; level++) {
+    if (db->live[level].count > 0) {
+      error = store_rollup(db, level, &db->live[level]);
+      if (error != TSDB_OK)
+        return error;
+    }
+
+    if (db->rollup_dirty[level]) {
+      error = device_write(db, db->rollup_block[level], db->rollup[level]);
+      if (error != TSDB_OK)
+        return error;
+      db->rollup_dirty[level] = 0;
+    }
+  }
+
+  if (db->entry.count > 0)
+    return write_block(db);
+
+  return TSDB_OK;
+}
+
+//Starts a query of the samples from one timestamp to another (both included) with values within
+//a range (both included; use -INFINITY and INFINITY for any value). Samples are read with
+//tsdb_next().
+int tsdb_query(struct tsdb *db, struct tsdb_cursor *c, uint32_t from, uint32_t to, float min,
+               float max) {
+  struct tsdb_rollup record;
+  struct tsdb_entry entry;
+  uint32_t oldest, low, high, middle;
+  int error;
+
+  c->db = db;
+  c->from = from;
+  c->to = to;
+  c->min = min;
+  c->max = max;
+  c->loaded = 0;
+
+  oldest = db->seq > db->config.data_blocks ? db->seq - db->config.data_blocks + 1 : 1;
+
+  //The rollup of the first second tells where it starts, if there were samples in it.
+  error = get_rollup(db, TSDB_SECOND, from / db->period_ticks[TSDB_SECOND], &record);
+  if (error != TSDB_OK)
+    return error;
+
+  if (record.count > 0) {
+    c->seq = record.block > oldest ? record.block : oldest;
+    return TSDB_OK;
+  }
+
+  //Otherwise, look for the first block ending at or after the start.
+  low = oldest;
+  high = db->seq;
+  while (low < high) {
+    middle = low + (high - low) / 2;
+    error = get_entry(db, middle, &entry);
+    if (error != TSDB_OK)
+      return error;
+
+    if (entry.seq == middle && entry.count > 0 && entry.last >= from)
+      high = middle;
+    else
+      low = middle + 1;
+  }
+
+  c->seq = low;
+  return TSDB_OK;
+}
+
+//Reads the next sample of a query. Returns TSDB_END after the last one. Damaged data blocks are
+//reported with TSDB_ERR_CORRUPT, and the query can go on with the next one.
+int tsdb_next(struct tsdb_cursor *c, uint32_t *timestamp, float *value) {
+  struct tsdb *db = c->db;
+  struct tsdb_entry entry;
+  int error;
+
+  while (1) {
+    if (!c->loaded) {
+      if (c->seq > db->seq)
+        return TSDB_END;
+
+      error = get_entry(db, c->seq, &entry);
+      if (error != TSDB_OK)
+        return error;
+
+      //Skip overwritten blocks, and the ones out of the time and value ranges.
+      if (entry.seq != c->seq || entry.count == 0 || entry.last < c->from ||
+          entry.max < c->min || entry.min > c->max) {
+        c->seq++;
+        continue;
+      }
+
+      if (entry.first > c->to) {
+        c->seq = db->seq + 1;
+        return TSDB_END;
+      }
+
+      //The open block is copied as it is now.
+      if (c->seq == db->seq) {
+        tscomp_finish(&db->encoder);
+        memcpy(c->block, db->data, TSDB_BLOCK_SIZE);
+      }
+      else {
+        error = device_read(db, db->data_start + data_slot(db, c->seq), c->block);
+        if (error != TSDB_OK)
+          return error;
+      }
+
+      if (tscomp_decoder_init(&c->decoder, c->block, TSDB_BLOCK_SIZE) != TSCOMP_OK) {
+        c->seq++;
+        return TSDB_ERR_CORRUPT;
+      }
+      c->loaded = 1;
+    }
+
+    error = tscomp_get_float(&c->decoder, timestamp, value);
+    if (error != TSCOMP_OK) {
+      c->loaded = 0;
+      c->seq++;
+      if (error == TSCOMP_END)
+        continue;
+      return TSDB_ERR_CORRUPT;
+    }
+
+    if (*timestamp > c->to) {
+      c->loaded = 0;
+      c->seq = db->seq + 1;
+      return TSDB_END;
+    }
+
+    if (*timestamp >= c->from && *value >= c->min && *value <= c->max)
+      return TSDB_OK;
+  }
+}
+
+//Reads the rollups of a number of consecutive periods of a level (TSDB_SECOND, TSDB_MINUTE or
+//TSDB_HOUR), from the one holding the given timestamp. Periods with no samples, or no longer kept,
+//have a count of 0. Returns the number of rollups read or an error code.
+int tsdb_rollups(struct tsdb *db, uint8_t level, uint32_t from, struct tsdb_rollup *records,
+                 uint16_t count) {
+  uint32_t period;
+  uint16_t i;
+  int error;
+
+  if (level >= TSDB_LEVELS)
+    return TSDB_ERR_RANGE;
+
+  period = from / db->period_ticks[level];
+  for (i = 0; i < count; i++) {
+    error = get_rollup(db, level, period + i, &records[i]);
+    if (error != TSDB_OK)
+      return error;
+  }
+
+  return count;
+}
@@ -0,0 +1,149 @@
+//+------------------------------------------------------------------------------------------------+
+//| Append only time series store.                                                                 |
+//|                                                                                                |
+//| Keeps a series of timestamped float samples in a region of a block device (an SD card, or any  |
+//| storage read and written in 512 byte blocks), with room for a fixed amount of history: once    |
+//| full, the oldest data is overwritten. The region is laid out as follows:                       |
+//| - Superblock: geometry and the tag that marks the records of this store.                       |
+//| - Data blocks: compressed samples (blocks of the tscomp library), used as a ring.              |
+//| - Index: an entry per data block with its sequence number, time span, sample count and value   |
+//|   range, so blocks can be located and skipped without reading them.                            |
+//| - Rollups: count, minimum, maximum and sum of the samples of every second, minute and hour,    |
+//|   each level a ring addressed directly by period number. Every record also holds the data      |
+//|   block where its period starts, which works as a time directory for queries.                  |
+//|                                                                                                |
+//| Index entries and rollups are computed incrementally as samples are appended, in RAM. Data and |
+//| index blocks are written as data blocks fill up, and rollup blocks as the periods move past    |
+//| them, so the device is written about once per data block on steady appends. tsdb_sync()        |
+//| writes everything pending (including the partial data block), and should be called             |
+//| periodically: anything appended after the last sync is lost on reset.                          |
+//|                                                                                                |
+//| Queries read only what they need: rollup queries read the records of the periods asked for     |
+//| (directly addressed), and sample queries find their first data block through the rollups of    |
+//| the second where they start (or, if there are none, a binary search of the index), then read   |
+//| the data blocks whose time span and value range match. The cost doesn't depend on the length   |
+//| of the history.                                                                                |
+//|                                                                                                |
+//| Timestamps are 32 bit ticks of the rate given at format time (e.g. milliseconds), and must not |
+//| decrease. They don't wrap around, which bounds the life of a store (49 days in milliseconds,   |
+//| 497 days in hundredths of a second).                                                           |
+//|                                                                                                |
+//| Stores take about 3KB of RAM, plus 0.5KB per open query cursor. Requires the tscomp app. This  |
+//| module doesn't depend on contiki, so it builds on the host as is.                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef TSDB_H_
+#define TSDB_H_
+
+#include <stdint.h>
+
+#include "tscomp.h"
+
+#define TSDB_BLOCK_SIZE 512
+
+//Rollup levels.
+#define TSDB_SECOND 0
+#define TSDB_MINUTE 1
+#define TSDB_HOUR   2
+#define TSDB_LEVELS 3
+
+//Error codes.
+#define TSDB_OK           0
+#define TSDB_END          -1  //No more samples in the query
+#define TSDB_ERR_IO       -2  //Device read or write failed
+#define TSDB_ERR_FORMAT   -3  //No valid store in the region
+#define TSDB_ERR_RANGE    -4  //Store doesn't fit in the region, or invalid parameters
+#define TSDB_ERR_ORDER    -5  //Timestamp older than the last one appended
+#define TSDB_ERR_CORRUPT  -6  //Damaged data block
+
+//Block device. The functions take device block numbers and return 0 on success (the sdcard
+//driver functions can be used as they are). The store uses blocks start to start + blocks - 1.
+//Buffers passed are word aligned.
+struct tsdb_device {
+  int (* read)(uint32_t block, void *buffer, uint16_t count);
+  int (* write)(uint32_t block, const void *buffer, uint16_t count);
+  uint32_t start;
+  uint32_t blocks;
+};
+
+//Store geometry, given at format time.
+struct tsdb_config {
+  uint32_t ticks_per_second;
+  uint32_t data_blocks;
+  uint32_t rollups[TSDB_LEVELS];  //Periods kept by each rollup level
+};
+
+//Rollup of a period. Its start time is period times the period length (in ticks).
+struct tsdb_rollup {
+  uint32_t period;
+  uint32_t count;
+  float min;
+  float max;
+  float sum;
+  uint32_t block;                 //Sequence number of the data block where the period starts
+  uint32_t tag;
+};
+
+//Index entry of a data block.
+struct tsdb_entry {
+  uint32_t seq;                   //Sequence number (blocks are numbered from 1 as written)
+  uint32_t first;                 //Timestamps of the first and last samples
+  uint32_t last;
+  float min;
+  float max;
+  uint32_t count;
+  uint32_t tag;
+};
+
+struct tsdb {
+  const struct tsdb_device *device;
+  struct tsdb_config config;
+  uint32_t tag;
+  uint32_t index_start;           //Region offsets, in blocks
+  uint32_t rollup_start[TSDB_LEVELS];
+  uint32_t data_start;
+  uint32_t period_ticks[TSDB_LEVELS];
+  uint32_t seq;                   //Sequence number of the open data block
+  uint32_t last;                  //Timestamp of the last sample
+  struct tscomp_encoder encoder;
+  struct tsdb_entry entry;        //Index entry of the open data block
+  struct tsdb_rollup live[TSDB_LEVELS];
+  uint32_t index_block;           //Blocks held by the caches
+  uint32_t rollup_block[TSDB_LEVELS];
+  uint32_t scratch_block;
+  uint8_t rollup_dirty[TSDB_LEVELS];
+  uint32_t reads;                 //Device blocks read and written so far
+  uint32_t writes;
+  uint32_t data[TSDB_BLOCK_SIZE / 4];
+  uint32_t index[TSDB_BLOCK_SIZE / 4];
+  uint32_t rollup[TSDB_LEVELS][TSDB_BLOCK_SIZE / 4];
+  uint32_t scratch[TSDB_BLOCK_SIZE / 4];
+};
+
+//Sample query in progress.
+struct tsdb_cursor {
+  struct tsdb *db;
+  uint32_t from;
+  uint32_t to;
+  float min;
+  float max;
+  uint32_t seq;                   //Data block being read, or next to read
+  uint8_t loaded;
+  struct tscomp_decoder decoder;
+  uint32_t block[TSDB_BLOCK_SIZE / 4];
+};
+
+int tsdb_format(struct tsdb *db, const struct tsdb_device *device,
+                const struct tsdb_config *config);
+int tsdb_mount(struct tsdb *db, const struct tsdb_device *device);
+int tsdb_append(struct tsdb *db, uint32_t timestamp, float value);
+int tsdb_sync(struct tsdb *db);
+int tsdb_query(struct tsdb *db, struct tsdb_cursor *c, uint32_t from, uint32_t to, float min,
+               float max);
+int tsdb_next(struct tsdb_cursor *c, uint32_t *timestamp, float *value);
+int tsdb_rollups(struct tsdb *db, uint8_t level, uint32_t from, struct tsdb_rollup *records,
+                 uint16_t count);
+
+#endif //TSDB_H_
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+#+-------------------------------------------------------------------------------------------------+
+#| Compressor for the initial data of the .data section.                                           |
+#|                                                                                                 |
+#| Used by the cpu makefiles when building with COMPRESS_DATA=1. Reads the load image of .data     |
+#| (extracted from a first link with objcopy -O binary -j .data) and writes an assembly file that  |
+#| places it, compressed, in the .data_image section, which the linker scripts put at the end of   |
+#| flash. The startup code unpacks it into RAM before main().                                      |
+#|                                                                                                 |
+#| The format is an LZ4 block: sequences of a token byte (literal count in the upper nibble, match |
+#| length minus 4 in the lower one, 15 meaning more length bytes follow, each adding up to 255),   |
+#| the literals, and the match offset back into the output (2 bytes, little endian). The last      |
+#| sequence has literals only. The decoder is small and copies bytes at a time, so matches are     |
+#| searched thoroughly here (the image is a few KB at most) to keep the sequences few and long.    |
+#|                                                                                                 |
+#| Usage: compress-data.py [-q] [-n name] image output.s                                           |
+#|                                                                                                 |
+#| Author: Joksan Alvarado.                                                                        |
+#+-------------------------------------------------------------------------------------------------+
+
+import argparse
+import sys
+
+MIN_MATCH = 4
+MAX_OFFSET = 65535
+
+#Block end rules of the format: the last 5 bytes are literals, and the last match starts at least
+#12 bytes before the end.
+LAST_LITERALS = 5
+MATCH_LIMIT = 12
+
+#Candidates tried per position, newest first.
+SEARCH_DEPTH = 1024
+
+
+def longest_match(data, position, end, chains):
+    """Returns the (length, offset) of the longest earlier match at position, or (0, 0)."""
+    best_length, best_offset = 0, 0
+    for candidate in reversed(chains.get(data[position:position + MIN_MATCH], [])[-SEARCH_DEPTH:]):
+        offset = position - candidate
+        if offset > MAX_OFFSET:
+            break
+        length = 0
+        while position + length < end and data[candidate + length] == data[position + length]:
+            length += 1
+        if length > best_length:
+            best_length, best_offset = length, offset
+    return best_length, best_offset
+
+
+def length_bytes(length):
+    """Returns the extra bytes of a nibble length of 15 or more."""
+    out = bytearray()
+    length -= 15
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+    return out
+
+
+def sequence(literals, match_length, offset):
+    """Encodes a sequence, with a match unless match_length is 0."""
+    literal_count = len(literals)
+    match_code = match_length - MIN_MATCH if match_length else 0
+    out = bytearray([(min(literal_count, 15) << 4) | min(match_code, 15)])
+    if literal_count >= 15:
+        out += length_bytes(literal_count)
+    out += literals
+    if match_length:
+        out += bytes([offset & 0xFF, offset >> 8])
+        if match_code >= 15:
+            out += length_bytes(match_code)
+    return out
+
+
+def compress(data):
+    """Compresses data into an LZ4 block, choosing matches greedily with a one byte lookahead."""
+    out = bytearray()
+    chains = {}
+    indexed = 0
+    literal_start = 0
+    position = 0
+    match_end = len(data) - LAST_LITERALS
+    search_end = len(data) - MATCH_LIMIT
+
+    #Matches are searched among the positions before the current one.
+    def find(p):
+        nonlocal indexed
+        while indexed < p:
+            chains.setdefault(data[indexed:indexed + MIN_MATCH], []).append(indexed)
+            indexed += 1
+        return longest_match(data, p, match_end, chains)
+
+    while position < search_end:
+        length, offset = find(position)
+        if length < MIN_MATCH:
+            position += 1
+            continue
+
+        #Prefer a longer match starting at the next byte.
+        if position + 1 < search_end:
+            next_length, next_offset = find(position + 1)
+            if next_length > length + 1:
+                position += 1
+                length, offset = next_length, next_offset
+
+        out += sequence(data[literal_start:position], length, offset)
+        position += length
+        literal_start = position
+
+    out += sequence(data[literal_start:], 0, 0)
+    return bytes(out)
+
+
+def decompress(block, size):
+    """Unpacks an LZ4 block of known output size, the way the startup code does."""
+    out = bytearray()
+    i = 0
+    while len(out) < size:
+        token = block[i]
+        i += 1
+        length = token >> 4
+        if length == 15:
+            while True:
+                length += block[i]
+                i += 1
+                if block[i - 1] != 255:
+                    break
+        out += block[i:i + length]
+        i += length
+        if len(out) >= size:
+            break
+
+        offset = block[i] | (block[i + 1] << 8)
+        i += 2
+        length = token & 0xF
+        if length == 15:
+            while True:
+                length += block[i]
+                i += 1
+                if block[i - 1] != 255:
+                    break
+        for _ in range(length + MIN_MATCH):
+            out.append(out[-offset])
+    return bytes(out)
+
+
+def assembly(block):
+    """Returns the assembly source placing the block in the .data_image section."""
+    lines = [
+        '/* Compressed initial data of the .data section, generated by compress-data.py */',
+        '',
+        '  .section .data_image, "a", %progbits',
+    ]
+    for i in range(0, len(block), 16):
+        lines.append('  .byte ' + ', '.join('0x%02X' % b for b in block[i:i + 16]))
+    return '\n'.join(lines) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compresses the initial data of .data.')
+    parser.add_argument('image', help='load image of .data (raw binary)')
+    parser.add_argument('output', help='assembly file to write')
+    parser.add_argument('-n', '--name', help='name printed along with the sizes (default: image)')
+    parser.add_argument('-q', '--quiet', action='store_true', help="don't print the sizes")
+    args = parser.parse_args()
+
+    try:
+        with open(args.image, 'rb') as f:
+            data = f.read()
+    except OSError as e:
+        sys.exit('compress-data: %s' % e)
+
+    block = compress(data)
+    if decompress(block, len(data)) != data:
+        sys.exit('compress-data: %s: compressed image does not unpack back' % args.image)
+
+    with open(args.output, 'w') as f:
+        f.write(assembly(block))
+
+    if args.quiet:
+        return
+
+    #Account for the word alignment of both images in flash.
+    size = (len(data) + 3) & ~3
+    compressed = (len(block) + 3) & ~3
+    print('%s: .data of %d bytes, compressed to %d (%d bytes of flash saved)' %
+          (args.name or args.image, size, compressed, size - compressed))
+
+
+if __name__ == '__main__':
+    main()
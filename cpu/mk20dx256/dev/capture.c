@@ -0,0 +1,286 @@
+//+------------------------------------------------------------------------------------------------+
+//| Logic analyzer capture driver for Kinetis MK20 MCU.                                            |
+//|                                                                                                |
+//| The DMAMUX periodic trigger gates an always enabled request source with PIT3, so the channel   |
+//| moves one byte from GPIOD->PDIR every timer period. The channel runs circularly over the ring  |
+//| buffer with half and major loop interrupts. Each interrupt scans the half just filled for the  |
+//| trigger (while the other half is being filled), and checks whether enough samples have been    |
+//| taken after it.                                                                                |
+//|                                                                                                |
+//| Sample positions are counted since the start of the capture with 64 bit counters, so waiting   |
+//| for a trigger is not limited in time.                                                          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "capture.h"
+
+#include "mk20.h"
+#include "mk20-sim.h"
+#include "mk20-port.h"
+#include "mk20-gpio.h"
+#include "mk20-pit.h"
+#include "mk20-dma.h"
+#include "mk20-dmamux.h"
+
+//DMA channel used by the driver (triggered by the PIT channel of the same number).
+#define DMA_CHANNEL 3
+
+#define BUS_CLOCK 36000000
+
+//Samples per half of the ring buffer, and ring buffer index of a sample position.
+#define HALF_SIZE (CAPTURE_BUFFER_SIZE / 2)
+#define INDEX(pos) ((uint32_t) (pos) & (CAPTURE_BUFFER_SIZE - 1))
+
+//Interrupt priority. Scanning a half takes a while, so it's the lowest one.
+#define DMA_PRIORITY 15
+
+//Capture states.
+#define STATE_IDLE      0
+#define STATE_ARMED     1  //Waiting for the trigger
+#define STATE_TRIGGERED 2  //Taking the samples after the trigger
+#define STATE_DONE      3
+
+static uint8_t ring[CAPTURE_BUFFER_SIZE] __attribute__((aligned(4)));
+
+//Capture state.
+static volatile uint8_t state = STATE_IDLE;
+static struct capture_trigger condition;
+static uint8_t previous;
+static uint32_t pre_samples;
+static uint32_t post_samples;
+static uint32_t sample_rate;
+static uint64_t written;
+static uint64_t trigger_pos;
+static uint64_t end_pos;
+static struct process *requester;
+
+//Capture result and readout state.
+static uint64_t first;
+static uint32_t count;
+static uint32_t encoded;
+static uint8_t pending[CAPTURE_HEADER_SIZE];
+static uint8_t pending_length;
+static uint8_t pending_pos;
+
+process_event_t capture_event_done;
+
+PROCESS(capture_process, "Capture");
+
+//Stores a 32 bit value in little endian byte order.
+static void put_u32(uint8_t *dst, uint32_t value) {
+  dst[0] = value;
+  dst[1] = value >> 8;
+  dst[2] = value >> 16;
+  dst[3] = value >> 24;
+}
+
+//Stops sampling. The trigger goes first, so no request is left pending.
+static void stop_sampling() {
+  PIT->TCTRL3 = PIT_TCTRL_TEN_Disabled;
+  DMA->CERQ = DMA_CHANNEL;
+}
+
+void capture_init() {
+  uint8_t i;
+
+  state = STATE_IDLE;
+
+  capture_event_done = process_alloc_event();
+  process_start(&capture_process, NULL);
+
+  //Enable the module clocks and set the inputs as GPIOs.
+  SIM->SCGC5 |= SIM_SCGC5_PORTD_Enabled;
+  SIM->SCGC6 |= SIM_SCGC6_PIT_Enabled | SIM_SCGC6_DMAMUX_Enabled;
+  SIM->SCGC7 |= SIM_SCGC7_DMA_Enabled;
+  for (i = 0; i < 8; i++)
+    PORTD->PCR[i] = PORT_PCR_MUX_Gpio;
+  GPIOD->PDDR &= ~0xFF;
+
+  //Sampling channel: PDIR (lower byte) to the ring buffer, wrapping around at its end.
+  DMA->CERQ = DMA_CHANNEL;
+  DMAMUX->CHCFG[DMA_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[DMA_CHANNEL].SADDR = (uint32_t) &GPIOD->PDIR;
+  DMA->TCD[DMA_CHANNEL].SOFF = 0;
+  DMA->TCD[DMA_CHANNEL].ATTR = DMA_ATTR_SSIZE_8Bit | DMA_ATTR_DSIZE_8Bit;
+  DMA->TCD[DMA_CHANNEL].NBYTES = 1;
+  DMA->TCD[DMA_CHANNEL].SLAST = 0;
+  DMA->TCD[DMA_CHANNEL].DADDR = (uint32_t) ring;
+  DMA->TCD[DMA_CHANNEL].DOFF = 1;
+  DMA->TCD[DMA_CHANNEL].CITER = CAPTURE_BUFFER_SIZE;
+  DMA->TCD[DMA_CHANNEL].BITER = CAPTURE_BUFFER_SIZE;
+  DMA->TCD[DMA_CHANNEL].DLASTSGA = -CAPTURE_BUFFER_SIZE;
+  DMA->TCD[DMA_CHANNEL].CSR = DMA_CSR_INTMAJOR_Enabled | DMA_CSR_INTHALF_Enabled;
+  DMAMUX->CHCFG[DMA_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_CHCFG_TRIG_Enabled |
+                               DMAMUX_SOURCE_AlwaysOn0;
+
+  NVIC_SetPriority(DmaChannel_3_IRQn, DMA_PRIORITY);
+  NVIC_EnableIRQ(DmaChannel_3_IRQn);
+}
+
+//Starts a capture at the given rate (in Hz, rounded to a divisor of the bus clock). pre is the
+//amount of samples kept before the trigger, and post the amount of samples from the trigger on
+//(at least 1). Returns -1 if a capture is in progress or the parameters are out of range.
+int capture_start(uint32_t rate, const struct capture_trigger *trigger, uint32_t pre,
+                  uint32_t post) {
+  uint32_t period;
+
+  if (capture_busy())
+    return -1;
+  if (rate == 0 || rate > CAPTURE_MAX_RATE || post == 0 || pre + post > CAPTURE_MAX_SAMPLES)
+    return -1;
+
+  period = (BUS_CLOCK + rate / 2) / rate;
+  sample_rate = BUS_CLOCK / period;
+  requester = PROCESS_CURRENT();
+  post_samples = post;
+  written = 0;
+
+  if (trigger != NULL) {
+    condition = *trigger;
+    pre_samples = pre;
+    previous = GPIOD->PDIR;
+    state = STATE_ARMED;
+  } else {
+    pre_samples = 0;
+    trigger_pos = 0;
+    end_pos = post;
+    state = STATE_TRIGGERED;
+  }
+
+  //Restart the ring from its beginning, then the timer.
+  DMA->TCD[DMA_CHANNEL].DADDR = (uint32_t) ring;
+  DMA->TCD[DMA_CHANNEL].CITER = CAPTURE_BUFFER_SIZE;
+  DMA->CINT = DMA_CHANNEL;
+  DMA->SERQ = DMA_CHANNEL;
+  PIT->LDVAL3 = period - 1;
+  PIT->TCTRL3 = PIT_TCTRL_TEN_Enabled;
+
+  return 0;
+}
+
+//Aborts the capture in progress, if any.
+void capture_stop() {
+  NVIC_DisableIRQ(DmaChannel_3_IRQn);
+  stop_sampling();
+  state = STATE_IDLE;
+  NVIC_EnableIRQ(DmaChannel_3_IRQn);
+}
+
+int capture_busy() {
+  return state == STATE_ARMED || state == STATE_TRIGGERED;
+}
+
+//Encodes the next part of the last capture into a buffer, returning the amount of bytes written
+//(0 once the whole capture has been encoded). Can be called repeatedly with small buffers, so the
+//capture can be streamed without blocking for long.
+uint16_t capture_encode(uint8_t *buffer, uint16_t size) {
+  uint16_t n = 0;
+  uint32_t run;
+  uint8_t value;
+
+  if (state != STATE_DONE)
+    return 0;
+
+  while (n < size) {
+    //Bytes left from the header or the last run go first.
+    if (pending_pos < pending_length) {
+      buffer[n++] = pending[pending_pos++];
+      continue;
+    }
+
+    if (encoded >= count)
+      break;
+
+    //Measure the next run and encode it.
+    value = ring[INDEX(first + encoded)];
+    run = 1;
+    while (encoded + run < count && ring[INDEX(first + encoded + run)] == value)
+      run++;
+    encoded += run;
+
+    pending[0] = value;
+    pending_length = 1;
+    pending_pos = 0;
+    run--;
+    do {
+      pending[pending_length] = run & 0x7F;
+      run >>= 7;
+      if (run > 0)
+        pending[pending_length] |= 0x80;
+      pending_length++;
+    } while (run > 0);
+  }
+
+  return n;
+}
+
+void dma_channel_3_handler() {
+  const uint8_t *half;
+  uint64_t stop;
+  uint32_t i;
+  uint8_t sample;
+
+  DMA->CINT = DMA_CHANNEL;
+
+  //Interrupts alternate between the first half (half loop) and the second one (major loop).
+  half = &ring[INDEX(written)];
+  written += HALF_SIZE;
+
+  if (state == STATE_ARMED) {
+    for (i = 0; i < HALF_SIZE; i++) {
+      sample = half[i];
+      if ((sample & condition.mask) == condition.value &&
+          ((sample ^ previous) & condition.edges) == condition.edges) {
+        trigger_pos = written - HALF_SIZE + i;
+        end_pos = trigger_pos + post_samples;
+        state = STATE_TRIGGERED;
+        break;
+      }
+      previous = sample;
+    }
+  }
+
+  if (state != STATE_TRIGGERED || written < end_pos)
+    return;
+
+  //Enough samples have been taken. Those taken since this interrupt was requested have already
+  //overwritten the oldest ones.
+  stop_sampling();
+  stop = written + INDEX(CAPTURE_BUFFER_SIZE - DMA->TCD[DMA_CHANNEL].CITER - INDEX(written));
+
+  first = (trigger_pos > pre_samples) ? trigger_pos - pre_samples : 0;
+  if (stop > CAPTURE_BUFFER_SIZE && first < stop - CAPTURE_BUFFER_SIZE)
+    first = stop - CAPTURE_BUFFER_SIZE;
+  count = end_pos - first;
+
+  //Prepare the readout, starting with the header.
+  pending[0] = CAPTURE_MAGIC[0];
+  pending[1] = CAPTURE_MAGIC[1];
+  pending[2] = CAPTURE_MAGIC[2];
+  pending[3] = CAPTURE_MAGIC[3];
+  put_u32(&pending[4], sample_rate);
+  put_u32(&pending[8], count);
+  put_u32(&pending[12], trigger_pos - first);
+  pending_length = CAPTURE_HEADER_SIZE;
+  pending_pos = 0;
+  encoded = 0;
+
+  state = STATE_DONE;
+  process_poll(&capture_process);
+}
+
+//Forwards the end of capture notification from interrupt context.
+PROCESS_THREAD(capture_process, ev, data) {
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    if (requester != NULL)
+      process_post(requester, capture_event_done, NULL);
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,68 @@
+//+------------------------------------------------------------------------------------------------+
+//| Logic analyzer capture driver for Kinetis MK20 MCU.                                            |
+//|                                                                                                |
+//| Samples the 8 lower bits of port D at a fixed rate, entirely by DMA: PIT3 triggers eDMA        |
+//| channel 3, which copies the port input register into a ring buffer. The buffer is scanned for  |
+//| the trigger condition half by half as it fills, and once the requested amount of samples after |
+//| the trigger has been taken, the capture stops and capture_event_done is posted to the process  |
+//| that started it. The capture can then be read out with capture_encode(), in a compact run      |
+//| length encoded format meant to be streamed to a host (see CAPTURE_MAGIC below).                |
+//|                                                                                                |
+//| A trigger fires on the first sample whose channels selected by mask equal value, and in which  |
+//| the channels selected by edges changed from the previous sample. A null trigger fires on the   |
+//| first sample.                                                                                  |
+//|                                                                                                |
+//| Sampling rates go up to 4MHz. Samples may be delayed by a few bus cycles by other DMA channels |
+//| or bus contention, so channels should be sampled well above their toggle rate.                 |
+//|                                                                                                |
+//| Inputs (Teensy 3.2 pin numbers in parenthesis): channel 0 on PTD0 (2), 1 on PTD1 (14), 2 on    |
+//| PTD2 (7), 3 on PTD3 (8), 4 on PTD4 (6), 5 on PTD5 (20), 6 on PTD6 (21), 7 on PTD7 (5).         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Ring buffer size, in samples (a power of two, up to 16384).
+#ifdef CAPTURE_CONF_BUFFER_SIZE
+#define CAPTURE_BUFFER_SIZE CAPTURE_CONF_BUFFER_SIZE
+#else
+#define CAPTURE_BUFFER_SIZE 8192
+#endif
+
+//Limits of a capture. Samples before plus after the trigger may take up to half the ring buffer,
+//minus some margin for the interrupt latency.
+#define CAPTURE_MAX_RATE 4000000
+#define CAPTURE_MAX_SAMPLES (CAPTURE_BUFFER_SIZE / 2 - CAPTURE_BUFFER_SIZE / 8)
+
+//Encoded capture format. All values are little endian:
+//- Header: CAPTURE_MAGIC (4 bytes), sample rate in Hz (4 bytes), amount of samples (4 bytes) and
+//  index of the trigger sample (4 bytes).
+//- Body: runs of equal samples, each one as the sample value (1 byte) followed by the run length
+//  minus one (LEB128 encoded). Run lengths add up to the amount of samples.
+#define CAPTURE_MAGIC "KLA1"
+#define CAPTURE_HEADER_SIZE 16
+
+//Trigger condition.
+struct capture_trigger {
+  uint8_t mask;   //Channels that must match value
+  uint8_t value;
+  uint8_t edges;  //Channels that must have just changed
+};
+
+//Event posted once a capture is complete.
+extern process_event_t capture_event_done;
+
+void capture_init();
+int capture_start(uint32_t rate, const struct capture_trigger *trigger, uint32_t pre,
+                  uint32_t post);
+void capture_stop();
+int capture_busy();
+uint16_t capture_encode(uint8_t *buffer, uint16_t size);
+
+#endif //CAPTURE_H_
@@ -0,0 +1,128 @@
+//+------------------------------------------------------------------------------------------------+
+//| Addressable LED strip (WS2812/SK6812) output for Kinetis MK20 MCU.                             |
+//|                                                                                                |
+//| The DMA channel runs in circular fashion over both halves of the transfer buffer, with half    |
+//| and major loop interrupts. Every interrupt refills the half just sent with the next encoded    |
+//| bytes, until the strip has sent its latch time, when the channel is stopped.                   |
+//|                                                                                                |
+//| Every data byte becomes two 16 bit SPI frames, pushed as complete PUSHR words (command and     |
+//| data). Frame boundaries fall on the low part of a data bit, so the small delays inserted by    |
+//| the SPI module between frames only stretch low times, which the LEDs tolerate.                 |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "led-strip.h"
+
+#include "mk20.h"
+#include "mk20-sim.h"
+#include "mk20-port.h"
+#include "mk20-spi.h"
+#include "mk20-dma.h"
+#include "mk20-dmamux.h"
+
+//DMA channel used by the driver.
+#define DMA_CHANNEL 0
+
+#define SPI_CTAR_BAUD (SPI_CTAR_PBR_Div_5 | (0 << SPI_CTAR_BR_Pos))
+
+//Pixel bytes encoded per half buffer, and PUSHR words per half buffer.
+#define HALF_BYTES 48
+#define HALF_WORDS (HALF_BYTES * 2)
+
+//Interrupt priority. Refills are due once every half buffer (~430us), so it can be low.
+#define DMA_PRIORITY 6
+
+//Transfer buffer, split in two halves.
+static uint32_t transfer[HALF_WORDS * 2];
+
+//Transfer state.
+static struct led_strip *strip_sent;
+static uint8_t last_half[2];
+static uint8_t sending;
+
+//Fills one half of the transfer buffer with the next encoded bytes.
+static void fill_half(uint8_t half) {
+  uint32_t *dst = &transfer[half * HALF_WORDS];
+  uint32_t bits;
+  uint16_t i;
+
+  for (i = 0; i < HALF_BYTES; i++) {
+    bits = led_strip_encode(strip_sent);
+    *dst++ = SPI_PUSHR_CTAS_CTAR0 | (bits >> 16);
+    *dst++ = SPI_PUSHR_CTAS_CTAR0 | (bits & 0xFFFF);
+  }
+
+  last_half[half] = led_strip_latched(strip_sent);
+}
+
+//Sets up SPI0 and the DMA channel.
+void led_strip_arch_init(struct led_strip *strip) {
+  strip_sent = strip;
+
+  //Enable the module clocks and route MOSI. The pulldown keeps the line low while idle.
+  SIM->SCGC6 |= SIM_SCGC6_SPI0_Enabled | SIM_SCGC6_DMAMUX_Enabled;
+  SIM->SCGC7 |= SIM_SCGC7_DMA_Enabled;
+  PORTC->PCR[6] = PORT_PCR_MUX_Alt2 | PORT_PCR_DSE_High | PORT_PCR_PE_Enabled |
+                  PORT_PCR_PS_Pulldown;
+
+  //Master mode with the receive FIFO disabled (received data is ignored), 16 bit frames and
+  //minimum delays.
+  SPI0->MCR = SPI_MCR_MSTR_Master | SPI_MCR_DIS_RXF_Enabled | SPI_MCR_CLR_TXF_Set |
+              SPI_MCR_HALT_Enabled;
+  SPI0->CTAR0 = SPI_CTAR_BAUD | (15 << SPI_CTAR_FMSZ_Pos) | SPI_CTAR_CPOL_Low |
+                SPI_CTAR_CPHA_Leading | SPI_CTAR_LSBFE_MSB;
+  SPI0->RSER = SPI_RSER_TFFF_RE_Enabled | SPI_RSER_TFFF_DIRS_DMA;
+  SPI0->MCR = SPI_MCR_MSTR_Master | SPI_MCR_DIS_RXF_Enabled | SPI_MCR_HALT_Disabled;
+
+  //Feed the FIFO one PUSHR word per request, circularly over the transfer buffer.
+  DMA->CERQ = DMA_CHANNEL;
+  DMAMUX->CHCFG[DMA_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[DMA_CHANNEL].SADDR = (uint32_t) transfer;
+  DMA->TCD[DMA_CHANNEL].SOFF = 4;
+  DMA->TCD[DMA_CHANNEL].ATTR = DMA_ATTR_SSIZE_32Bit | DMA_ATTR_DSIZE_32Bit;
+  DMA->TCD[DMA_CHANNEL].NBYTES = 4;
+  DMA->TCD[DMA_CHANNEL].SLAST = -(int32_t) sizeof(transfer);
+  DMA->TCD[DMA_CHANNEL].DADDR = (uint32_t) &SPI0->PUSHR;
+  DMA->TCD[DMA_CHANNEL].DOFF = 0;
+  DMA->TCD[DMA_CHANNEL].CITER = HALF_WORDS * 2;
+  DMA->TCD[DMA_CHANNEL].DLASTSGA = 0;
+  DMA->TCD[DMA_CHANNEL].CSR = DMA_CSR_INTHALF_Enabled | DMA_CSR_INTMAJOR_Enabled;
+  DMA->TCD[DMA_CHANNEL].BITER = HALF_WORDS * 2;
+  DMAMUX->CHCFG[DMA_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_SPI0_Tx;
+
+  NVIC_SetPriority(DmaChannel_0_IRQn, DMA_PRIORITY);
+  NVIC_EnableIRQ(DmaChannel_0_IRQn);
+}
+
+//Starts sending the frame of the strip.
+void led_strip_arch_start(struct led_strip *strip) {
+  //Prepare both halves and start from the first one.
+  sending = 0;
+  fill_half(0);
+  fill_half(1);
+
+  DMA->TCD[DMA_CHANNEL].SADDR = (uint32_t) transfer;
+  DMA->TCD[DMA_CHANNEL].CITER = HALF_WORDS * 2;
+  DMA->SERQ = DMA_CHANNEL;
+}
+
+void dma_channel_0_handler() {
+  uint8_t half;
+
+  DMA->CINT = DMA_CHANNEL;
+
+  //Interrupts alternate between the first half (half loop) and the second one (major loop).
+  half = sending;
+  sending ^= 1;
+
+  if (last_half[half]) {
+    //Enough of the latch time has been sent. What remains in flight is also zeros.
+    DMA->CERQ = DMA_CHANNEL;
+    led_strip_done(strip_sent);
+  } else {
+    fill_half(half);
+  }
+}
@@ -0,0 +1,27 @@
+//+------------------------------------------------------------------------------------------------+
+//| Addressable LED strip (WS2812/SK6812) output for Kinetis MK20 MCU.                             |
+//|                                                                                                |
+//| The MCU has a single SPI module, so there's a single chain (0), with data output on PTC6       |
+//| (Teensy 3.2 pin 11) and fed by eDMA channel 0. It refreshes up to about 610 RGB pixels at 60   |
+//| fps, so 1000 pixel installations at that rate are out of reach of this MCU: they need the      |
+//| Teensy 3.6, which drives three chains. Parallel output through a GPIO port (FTM triggered DMA) |
+//| isn't implemented.                                                                             |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef LED_STRIP_ARCH_H_
+#define LED_STRIP_ARCH_H_
+
+//Number of output chains.
+#define LED_STRIP_CHAINS 1
+
+//SPI clock: 36MHz bus / 5 / 2 = 3.6MHz, for a 1.11us data bit.
+#define LED_STRIP_ARCH_BIT_RATE 3600000
+
+struct led_strip;
+
+void led_strip_arch_init(struct led_strip *strip);
+void led_strip_arch_start(struct led_strip *strip);
+
+#endif //LED_STRIP_ARCH_H_
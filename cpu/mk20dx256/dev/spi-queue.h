@@ -0,0 +1,58 @@
+//+------------------------------------------------------------------------------------------------+
+//| DMA driven SPI transaction queue for Kinetis MK20 MCU.                                         |
+//|                                                                                                |
+//| Transactions are sent by SPI0 in the order they were submitted, entirely by DMA: eDMA channel  |
+//| 1 feeds the transmit FIFO and channel 2 drains the receive FIFO (data received is discarded),  |
+//| so the end of a transaction is known to be the moment its last frame was shifted out. The CPU  |
+//| only steps in between lines and transactions.                                                  |
+//|                                                                                                |
+//| A transaction sends a rectangle of frames: a number of lines of the same amount of frames,     |
+//| each line starting a given amount of bytes after the previous one. This allows sending parts   |
+//| of a framebuffer without copying them, and a plain buffer is just a single line. Frames are 8  |
+//| or 16 bits wide; 16 bit frames are read from memory as native halfwords and sent MSB first.    |
+//|                                                                                                |
+//| Besides the SPI signals, the queue drives a chip select line (asserted while transactions are  |
+//| pending) and a data/command line, whose level is set per transaction, as used by displays.     |
+//|                                                                                                |
+//| The SPI module is shared with the LED strip driver, so both can't be used at once.             |
+//|                                                                                                |
+//| Pins (Teensy 3.2 pin numbers in parenthesis): MOSI on PTC6 (11), SCK on PTC5 (13), chip select |
+//| on PTC4 (10), data/command on PTC3 (9). The SPI clock runs at 18MHz.                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef SPI_QUEUE_H_
+#define SPI_QUEUE_H_
+
+#include <stdint.h>
+
+//Transaction flags.
+#define SPI_QUEUE_8BIT    0x00  //8 bit frames
+#define SPI_QUEUE_16BIT   0x01  //16 bit frames
+#define SPI_QUEUE_DC_LOW  0x00  //Data/command line low (command)
+#define SPI_QUEUE_DC_HIGH 0x02  //Data/command line high (data)
+
+struct spi_transaction;
+
+//Completion callback type. Called from interrupt context once the transaction has been sent.
+typedef void (* spi_queue_callback_t)(struct spi_transaction *t);
+
+//Transaction descriptor. Storage is provided by the caller, and must remain valid (along with the
+//data) until the transaction completes.
+struct spi_transaction {
+  struct spi_transaction *next;
+  const void *data;               //First frame of the first line
+  uint16_t frames;                //Frames per line (1 to 32767)
+  uint16_t lines;                 //Amount of lines
+  uint32_t stride;                //Bytes from the start of a line to the start of the next one
+  uint8_t flags;
+  spi_queue_callback_t callback;  //Optional
+  void *ptr;                      //Free for the submitter's use
+};
+
+void spi_queue_init();
+void spi_queue_submit(struct spi_transaction *t);
+int spi_queue_idle();
+
+#endif //SPI_QUEUE_H_
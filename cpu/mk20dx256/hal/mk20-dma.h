@@ -0,0 +1,125 @@
+//+------------------------------------------------------------------------------------------------+
+//| eDMA (enhanced direct memory access) peripheral registers for Kinetis MK20 MCU.                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK20_DMA_H_
+#define MK20_DMA_H_
+
+#include <stdint.h>
+
+//Transfer control descriptor.
+struct DMA_TCD_type {
+  uint32_t SADDR;         //Source address
+  int16_t SOFF;           //Signed source address offset
+  uint16_t ATTR;          //Transfer attributes
+  uint32_t NBYTES;        //Minor byte count (minor loop mapping disabled)
+  int32_t SLAST;          //Last source address adjustment
+  uint32_t DADDR;         //Destination address
+  int16_t DOFF;           //Signed destination address offset
+  uint16_t CITER;         //Current minor loop link, major loop count (channel linking disabled)
+  int32_t DLASTSGA;       //Last destination address adjustment/scatter gather address
+  uint16_t CSR;           //Control and status
+  uint16_t BITER;         //Beginning minor loop link, major loop count (channel linking disabled)
+};
+
+struct DMA_type {
+  uint32_t CR;            //Control register
+  uint32_t ES;            //Error status register
+  uint32_t reserved0;
+  uint32_t ERQ;           //Enable request register
+  uint32_t reserved1;
+  uint32_t EEI;           //Enable error interrupt register
+  uint8_t CEEI;           //Clear enable error interrupt register
+  uint8_t SEEI;           //Set enable error interrupt register
+  uint8_t CERQ;           //Clear enable request register
+  uint8_t SERQ;           //Set enable request register
+  uint8_t CDNE;           //Clear DONE status bit register
+  uint8_t SSRT;           //Set START bit register
+  uint8_t CERR;           //Clear error register
+  uint8_t CINT;           //Clear interrupt request register
+  uint32_t reserved2;
+  uint32_t INT;           //Interrupt request register
+  uint32_t reserved3;
+  uint32_t ERR;           //Error register
+  uint32_t reserved4;
+  uint32_t HRS;           //Hardware request status register
+  uint32_t reserved5[50];
+  uint8_t DCHPRI[16];     //Channel priority registers (in reverse order within each word)
+  uint32_t reserved6[956];
+  struct DMA_TCD_type TCD[16];
+};
+
+#define DMA ((volatile struct DMA_type *) 0x40008000)
+
+//Index of the priority register of a given channel.
+#define DMA_DCHPRI_Index(ch)  ((ch) ^ 3)
+
+//Control register bitfields
+#define DMA_CR_EDBG_Disabled    (0 << 1)  //Enable debug
+#define DMA_CR_EDBG_Enabled     (1 << 1)
+#define DMA_CR_ERCA_Fixed       (0 << 2)  //Enable round robin channel arbitration
+#define DMA_CR_ERCA_RoundRobin  (1 << 2)
+#define DMA_CR_ERGA_Fixed       (0 << 3)  //Enable round robin group arbitration
+#define DMA_CR_ERGA_RoundRobin  (1 << 3)
+#define DMA_CR_HOE_Disabled     (0 << 4)  //Halt on error
+#define DMA_CR_HOE_Enabled      (1 << 4)
+#define DMA_CR_HALT_Disabled    (0 << 5)  //Halt DMA operations
+#define DMA_CR_HALT_Enabled     (1 << 5)
+#define DMA_CR_CLM_Disabled     (0 << 6)  //Continuous link mode
+#define DMA_CR_CLM_Enabled      (1 << 6)
+#define DMA_CR_EMLM_Disabled    (0 << 7)  //Enable minor loop mapping
+#define DMA_CR_EMLM_Enabled     (1 << 7)
+#define DMA_CR_ECX_Set          (1 << 16) //Error cancel transfer
+#define DMA_CR_CX_Set           (1 << 17) //Cancel transfer
+
+//Channel priority register bitfields
+#define DMA_DCHPRI_CHPRI_Msk    0x0F      //Channel arbitration priority
+#define DMA_DCHPRI_CHPRI_Pos    0
+#define DMA_DCHPRI_DPA_Enabled  (0 << 6)  //Disable preempt ability
+#define DMA_DCHPRI_DPA_Disabled (1 << 6)
+#define DMA_DCHPRI_ECP_Disabled (0 << 7)  //Enable channel preemption
+#define DMA_DCHPRI_ECP_Enabled  (1 << 7)
+
+//Transfer attributes bitfields
+#define DMA_ATTR_DSIZE_8Bit     (0 << 0)  //Destination data transfer size
+#define DMA_ATTR_DSIZE_16Bit    (1 << 0)
+#define DMA_ATTR_DSIZE_32Bit    (2 << 0)
+#define DMA_ATTR_DSIZE_16Byte   (4 << 0)
+#define DMA_ATTR_DMOD_Msk       0x00F8    //Destination address modulo
+#define DMA_ATTR_DMOD_Pos       3
+#define DMA_ATTR_SSIZE_8Bit     (0 << 8)  //Source data transfer size
+#define DMA_ATTR_SSIZE_16Bit    (1 << 8)
+#define DMA_ATTR_SSIZE_32Bit    (2 << 8)
+#define DMA_ATTR_SSIZE_16Byte   (4 << 8)
+#define DMA_ATTR_SMOD_Msk       0xF800    //Source address modulo
+#define DMA_ATTR_SMOD_Pos       11
+
+//Current and beginning major iteration count bitfields (channel linking disabled)
+#define DMA_ITER_Msk            0x7FFF
+#define DMA_ITER_Pos            0
+#define DMA_ITER_ELINK_Disabled (0 << 15) //Enable channel linking on minor loop complete
+#define DMA_ITER_ELINK_Enabled  (1 << 15)
+
+//Control and status bitfields
+#define DMA_CSR_START_Set             (1 << 0)  //Channel start
+#define DMA_CSR_INTMAJOR_Disabled     (0 << 1)  //Interrupt on major loop completion
+#define DMA_CSR_INTMAJOR_Enabled      (1 << 1)
+#define DMA_CSR_INTHALF_Disabled      (0 << 2)  //Interrupt on major loop half completion
+#define DMA_CSR_INTHALF_Enabled       (1 << 2)
+#define DMA_CSR_DREQ_Disabled         (0 << 3)  //Clear ERQ when major loop completes
+#define DMA_CSR_DREQ_Enabled          (1 << 3)
+#define DMA_CSR_ESG_Disabled          (0 << 4)  //Enable scatter/gather processing
+#define DMA_CSR_ESG_Enabled           (1 << 4)
+#define DMA_CSR_MAJORELINK_Disabled   (0 << 5)  //Enable channel linking when major loop completes
+#define DMA_CSR_MAJORELINK_Enabled    (1 << 5)
+#define DMA_CSR_ACTIVE_Msk            0x0040    //Channel active
+#define DMA_CSR_DONE_Msk              0x0080    //Channel done
+#define DMA_CSR_MAJORLINKCH_Msk       0x0F00    //Link channel number
+#define DMA_CSR_MAJORLINKCH_Pos       8
+#define DMA_CSR_BWC_None              (0 << 14) //Bandwidth control
+#define DMA_CSR_BWC_Stall_4           (2 << 14)
+#define DMA_CSR_BWC_Stall_8           (3 << 14)
+
+#endif //MK20_DMA_H_
@@ -0,0 +1,140 @@
+//+------------------------------------------------------------------------------------------------+
+//| SPI (DSPI) peripheral registers for Kinetis MK20 MCU.                                          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK20_SPI_H_
+#define MK20_SPI_H_
+
+#include <stdint.h>
+
+struct SPI_type {
+  uint32_t MCR;           //Module configuration register
+  uint32_t reserved0;
+  uint32_t TCR;           //Transfer count register
+  uint32_t CTAR0;         //Clock and transfer attributes register 0
+  uint32_t CTAR1;         //Clock and transfer attributes register 1
+  uint32_t reserved1[6];
+  uint32_t SR;            //Status register
+  uint32_t RSER;          //DMA/interrupt request select and enable register
+  uint32_t PUSHR;         //Push TX FIFO register
+  uint32_t POPR;          //Pop RX FIFO register
+  uint32_t TXFR[4];       //Transmit FIFO registers
+  uint32_t reserved2[12];
+  uint32_t RXFR[4];       //Receive FIFO registers
+};
+
+#define SPI0 ((volatile struct SPI_type *) 0x4002C000)
+#define SPI1 ((volatile struct SPI_type *) 0x4002D000)
+
+//Module configuration register bitfields
+#define SPI_MCR_HALT_Disabled       (0 << 0)  //Halt
+#define SPI_MCR_HALT_Enabled        (1 << 0)
+#define SPI_MCR_SMPL_PT_0           (0 << 8)  //Sample point (master mode with CPHA 0)
+#define SPI_MCR_SMPL_PT_1           (1 << 8)
+#define SPI_MCR_SMPL_PT_2           (2 << 8)
+#define SPI_MCR_CLR_RXF_Set         (1 << 10) //Flush RX FIFO
+#define SPI_MCR_CLR_TXF_Set         (1 << 11) //Clear TX FIFO
+#define SPI_MCR_DIS_RXF_Disabled    (0 << 12) //Disable receive FIFO
+#define SPI_MCR_DIS_RXF_Enabled     (1 << 12)
+#define SPI_MCR_DIS_TXF_Disabled    (0 << 13) //Disable transmit FIFO
+#define SPI_MCR_DIS_TXF_Enabled     (1 << 13)
+#define SPI_MCR_MDIS_Enabled        (0 << 14) //Module disable
+#define SPI_MCR_MDIS_Disabled       (1 << 14)
+#define SPI_MCR_DOZE_Disabled       (0 << 15) //Doze enable
+#define SPI_MCR_DOZE_Enabled        (1 << 15)
+#define SPI_MCR_PCSIS_Msk           0x003F0000  //Peripheral chip select x inactive state
+#define SPI_MCR_PCSIS_Pos           16
+#define SPI_MCR_ROOE_Ignore         (0 << 24) //Receive FIFO overflow overwrite enable
+#define SPI_MCR_ROOE_Shift          (1 << 24)
+#define SPI_MCR_MTFE_Disabled       (0 << 26) //Modified transfer format enable
+#define SPI_MCR_MTFE_Enabled        (1 << 26)
+#define SPI_MCR_FRZ_DbgRun          (0 << 27) //Freeze
+#define SPI_MCR_FRZ_DbgStop         (1 << 27)
+#define SPI_MCR_DCONF_SPI           (0 << 28) //SPI configuration
+#define SPI_MCR_CONT_SCKE_Disabled  (0 << 30) //Continuous SCK enable
+#define SPI_MCR_CONT_SCKE_Enabled   (1 << 30)
+#define SPI_MCR_MSTR_Slave          (0 << 31) //Master/slave mode select
+#define SPI_MCR_MSTR_Master         (1 << 31)
+
+//Clock and transfer attributes register bitfields (master mode)
+#define SPI_CTAR_BR_Msk             0x0000000F  //Baud rate scaler
+#define SPI_CTAR_BR_Pos             0
+#define SPI_CTAR_DT_Msk             0x000000F0  //Delay after transfer scaler
+#define SPI_CTAR_DT_Pos             4
+#define SPI_CTAR_ASC_Msk            0x00000F00  //After SCK delay scaler
+#define SPI_CTAR_ASC_Pos            8
+#define SPI_CTAR_CSSCK_Msk          0x0000F000  //PCS to SCK delay scaler
+#define SPI_CTAR_CSSCK_Pos          12
+#define SPI_CTAR_PBR_Div_2          (0 << 16) //Baud rate prescaler
+#define SPI_CTAR_PBR_Div_3          (1 << 16)
+#define SPI_CTAR_PBR_Div_5          (2 << 16)
+#define SPI_CTAR_PBR_Div_7          (3 << 16)
+#define SPI_CTAR_PDT_Div_1          (0 << 18) //Delay after transfer prescaler
+#define SPI_CTAR_PDT_Div_3          (1 << 18)
+#define SPI_CTAR_PDT_Div_5          (2 << 18)
+#define SPI_CTAR_PDT_Div_7          (3 << 18)
+#define SPI_CTAR_PASC_Div_1         (0 << 20) //After SCK delay prescaler
+#define SPI_CTAR_PASC_Div_3         (1 << 20)
+#define SPI_CTAR_PASC_Div_5         (2 << 20)
+#define SPI_CTAR_PASC_Div_7         (3 << 20)
+#define SPI_CTAR_PCSSCK_Div_1       (0 << 22) //PCS to SCK delay prescaler
+#define SPI_CTAR_PCSSCK_Div_3       (1 << 22)
+#define SPI_CTAR_PCSSCK_Div_5       (2 << 22)
+#define SPI_CTAR_PCSSCK_Div_7       (3 << 22)
+#define SPI_CTAR_LSBFE_MSB          (0 << 24) //LSB first
+#define SPI_CTAR_LSBFE_LSB          (1 << 24)
+#define SPI_CTAR_CPHA_Leading       (0 << 25) //Clock phase
+#define SPI_CTAR_CPHA_Trailing      (1 << 25)
+#define SPI_CTAR_CPOL_Low           (0 << 26) //Clock polarity
+#define SPI_CTAR_CPOL_High          (1 << 26)
+#define SPI_CTAR_FMSZ_Msk           0x78000000  //Frame size (minus one)
+#define SPI_CTAR_FMSZ_Pos           27
+#define SPI_CTAR_DBR_Disabled       (0 << 31) //Double baud rate
+#define SPI_CTAR_DBR_Enabled        (1 << 31)
+
+//Status register bitfields
+#define SPI_SR_RFDF_Msk             0x00020000  //Receive FIFO drain flag
+#define SPI_SR_RFOF_Msk             0x00080000  //Receive FIFO overflow flag
+#define SPI_SR_TFFF_Msk             0x02000000  //Transmit FIFO fill flag
+#define SPI_SR_TFUF_Msk             0x08000000  //Transmit FIFO underflow flag
+#define SPI_SR_EOQF_Msk             0x10000000  //End of queue flag
+#define SPI_SR_TXRXS_Msk            0x40000000  //TX and RX status
+#define SPI_SR_TCF_Msk              0x80000000  //Transfer complete flag
+#define SPI_SR_TXCTR_Msk            0x0000F000  //TX FIFO counter
+#define SPI_SR_TXCTR_Pos            12
+#define SPI_SR_RXCTR_Msk            0x000000F0  //RX FIFO counter
+#define SPI_SR_RXCTR_Pos            4
+
+//DMA/interrupt request select and enable register bitfields
+#define SPI_RSER_RFDF_DIRS_Interrupt  (0 << 16) //Receive FIFO drain DMA or interrupt request select
+#define SPI_RSER_RFDF_DIRS_DMA        (1 << 16)
+#define SPI_RSER_RFDF_RE_Disabled     (0 << 17) //Receive FIFO drain request enable
+#define SPI_RSER_RFDF_RE_Enabled      (1 << 17)
+#define SPI_RSER_RFOF_RE_Disabled     (0 << 19) //Receive FIFO overflow request enable
+#define SPI_RSER_RFOF_RE_Enabled      (1 << 19)
+#define SPI_RSER_TFFF_DIRS_Interrupt  (0 << 24) //Transmit FIFO fill DMA or interrupt request select
+#define SPI_RSER_TFFF_DIRS_DMA        (1 << 24)
+#define SPI_RSER_TFFF_RE_Disabled     (0 << 25) //Transmit FIFO fill request enable
+#define SPI_RSER_TFFF_RE_Enabled      (1 << 25)
+#define SPI_RSER_TFUF_RE_Disabled     (0 << 27) //Transmit FIFO underflow request enable
+#define SPI_RSER_TFUF_RE_Enabled      (1 << 27)
+#define SPI_RSER_EOQF_RE_Disabled     (0 << 28) //DSPI finished request enable
+#define SPI_RSER_EOQF_RE_Enabled      (1 << 28)
+#define SPI_RSER_TCF_RE_Disabled      (0 << 31) //Transmission complete request enable
+#define SPI_RSER_TCF_RE_Enabled       (1 << 31)
+
+//Push TX FIFO register bitfields (master mode)
+#define SPI_PUSHR_TXDATA_Msk        0x0000FFFF  //Transmit data
+#define SPI_PUSHR_TXDATA_Pos        0
+#define SPI_PUSHR_PCS_Msk           0x003F0000  //Select which PCS signals are to be asserted
+#define SPI_PUSHR_PCS_Pos           16
+#define SPI_PUSHR_CTCNT_Set         (1 << 26) //Clear transfer counter
+#define SPI_PUSHR_EOQ_Set           (1 << 27) //End of queue
+#define SPI_PUSHR_CTAS_CTAR0        (0 << 28) //Clock and transfer attributes select
+#define SPI_PUSHR_CTAS_CTAR1        (1 << 28)
+#define SPI_PUSHR_CONT_Disabled     (0 << 31) //Continuous peripheral chip select enable
+#define SPI_PUSHR_CONT_Enabled      (1 << 31)
+
+#endif //MK20_SPI_H_
@@ -87,6 +87,27 @@ void clock_delay_usec(uint16_t dt) {
   }
 }
 
+//Moves the time forward by the given ticks, for time spent with the timer stopped (in low power
+//modes).
+void clock_adjust_ticks(clock_time_t ticks) {
+  NVIC_DisableIRQ(PIT_0_IRQn);
+
+  tick_count += ticks;
+  seconds_count += ticks / CLOCK_SECOND;
+  subseconds_count += ticks % CLOCK_SECOND;
+  if (subseconds_count >= CLOCK_SECOND) {
+    seconds_count++;
+    subseconds_count -= CLOCK_SECOND;
+  }
+
+  NVIC_EnableIRQ(PIT_0_IRQn);
+
+  //Timers may have expired meanwhile.
+  if (etimer_pending()) {
+    etimer_request_poll();
+  }
+}
+
 void pit_0_handler() {
   //Clear the interrupt flag.
   PIT->TFLG0 |= PIT_TFLG_TIF_Set;
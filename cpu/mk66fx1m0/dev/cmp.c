@@ -0,0 +1,253 @@
+//+------------------------------------------------------------------------------------------------+
+//| Analog comparator driver for Kinetis MK66 MCU.                                                 |
+//|                                                                                                |
+//| The selected input goes to the plus side of the comparator and the DAC to the minus side, so   |
+//| the output is high while the input is above the threshold. Edge flags are collected by the     |
+//| interrupt and reported by the driver process, so several edges between two runs of the         |
+//| process come as a single event.                                                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "cmp.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-cmp.h"
+#include "mk66-llwu.h"
+
+//Interrupt priority.
+#define CMP_PRIORITY 9
+
+#define CMP_COUNT 4
+
+//Comparator state.
+struct comparator {
+  volatile struct CMP_type *regs;
+  IRQn_Type irq;
+  uint8_t wakeup;             //LLWU module bit
+  struct cmp_config config;
+  volatile uint8_t edges;     //Edges seen since the last event
+  struct process *requester;
+};
+
+static struct comparator comparators[CMP_COUNT] = {
+  { CMP0, CMP_0_IRQn, LLWU_ME_WUME1_CMP0 },
+  { CMP1, CMP_1_IRQn, LLWU_ME_WUME2_CMP1 },
+  { CMP2, CMP_2_IRQn, LLWU_ME_WUME3_CMP2_3 },
+  { CMP3, CMP_3_IRQn, LLWU_ME_WUME3_CMP2_3 },
+};
+
+//Port and pin of the inputs of each comparator that have one.
+static volatile struct PORT_type * const input_ports[CMP_COUNT][4] = {
+  { PORTC, PORTC, PORTC, PORTC },
+  { PORTC, PORTC, NULL, NULL },
+  { PORTA, PORTA, NULL, NULL },
+  { NULL, NULL, NULL, NULL },
+};
+static const uint8_t input_pins[CMP_COUNT][4] = {
+  { 6, 7, 8, 9 },
+  { 2, 3, 0, 0 },
+  { 12, 13, 0, 0 },
+  { 0, 0, 0, 0 },
+};
+
+//Comparators in use, and those armed for wakeup.
+static uint8_t active;
+static uint8_t armed;
+
+process_event_t cmp_event;
+
+PROCESS(cmp_process, "CMP");
+
+//--------------------------------------------------------------------------------------------------
+
+//Applies a configuration. Without low_power, the configured filter is used, and the comparator runs
+//in high speed mode. Otherwise, it runs unfiltered in low speed mode, which keeps working in LLS
+//modes.
+static void configure(struct comparator *c, int low_power) {
+  const struct cmp_config *config = &c->config;
+  uint8_t cr0, cr1, fpr;
+
+  cr0 = (config->hysteresis << CMP_CR0_HYSTCTR_Pos) & CMP_CR0_HYSTCTR_Msk;
+  cr1 = CMP_CR1_EN_Enabled | CMP_CR1_COS_Filtered | CMP_CR1_SE_Disabled;
+  fpr = 0;
+
+  if (low_power) {
+    cr1 |= CMP_CR1_PMODE_Low_Speed;
+  } else {
+    cr1 |= CMP_CR1_PMODE_High_Speed;
+    if (config->filter_count > 0) {
+      cr0 |= (config->filter_count << CMP_CR0_FILTER_CNT_Pos) & CMP_CR0_FILTER_CNT_Msk;
+      fpr = (config->filter_period > 0) ? config->filter_period : 1;
+    }
+  }
+
+  //Reconfigure while disabled, and discard the edges it may cause.
+  c->regs->CR1 = CMP_CR1_EN_Disabled;
+  c->regs->CR0 = cr0;
+  c->regs->FPR = fpr;
+  c->regs->CR1 = cr1;
+  c->regs->SCR = CMP_SCR_CFF_Clear | CMP_SCR_CFR_Clear |
+                 ((config->edges & CMP_EDGE_RISING) ? CMP_SCR_IER_Enabled : CMP_SCR_IER_Disabled) |
+                 ((config->edges & CMP_EDGE_FALLING) ? CMP_SCR_IEF_Enabled : CMP_SCR_IEF_Disabled);
+}
+
+//Configures and enables a comparator. The calling process gets its events. Returns -1 if the
+//comparator doesn't exist or windowing is asked for (the PDB isn't set up to drive the window
+//signal), otherwise 0.
+int cmp_init(uint8_t id, const struct cmp_config *config) {
+  struct comparator *c;
+
+  if (id >= CMP_COUNT || config->windowed)
+    return -1;
+  c = &comparators[id];
+
+  if (cmp_event == 0) {
+    cmp_event = process_alloc_event();
+    process_start(&cmp_process, NULL);
+  }
+
+  SIM->SCGC4 |= SIM_SCGC4_CMP_Enabled;
+
+  NVIC_DisableIRQ(c->irq);
+
+  c->config = *config;
+  c->edges = 0;
+  c->requester = PROCESS_CURRENT();
+
+  if (config->input < 4 && input_ports[id][config->input] != NULL)
+    input_ports[id][config->input]->PCR[input_pins[id][config->input]] = PORT_PCR_MUX_Analog;
+
+  //Input on the plus side, DAC (referenced to the supply voltage) on the minus side.
+  c->regs->DACCR = CMP_DACCR_DACEN_Enabled | CMP_DACCR_VRSEL_Vin2 |
+                   ((config->level << CMP_DACCR_VOSEL_Pos) & CMP_DACCR_VOSEL_Msk);
+  c->regs->MUXCR = ((config->input << CMP_MUXCR_PSEL_Pos) & CMP_MUXCR_PSEL_Msk) |
+                   (CMP_INPUT_DAC << CMP_MUXCR_MSEL_Pos);
+  configure(c, 0);
+  active |= 1 << id;
+
+  NVIC_SetPriority(c->irq, CMP_PRIORITY);
+  NVIC_EnableIRQ(c->irq);
+
+  return 0;
+}
+
+//Disables a comparator.
+void cmp_stop(uint8_t id) {
+  struct comparator *c = &comparators[id];
+
+  NVIC_DisableIRQ(c->irq);
+  cmp_wake_disarm(id);
+  active &= ~(1 << id);
+  c->regs->SCR = CMP_SCR_CFF_Clear | CMP_SCR_CFR_Clear;
+  c->regs->CR1 = CMP_CR1_EN_Disabled;
+  c->regs->DACCR = CMP_DACCR_DACEN_Disabled;
+}
+
+//Changes the threshold of a comparator (0 to 63).
+void cmp_set_level(uint8_t id, uint8_t level) {
+  struct comparator *c = &comparators[id];
+
+  c->config.level = level;
+  c->regs->DACCR = CMP_DACCR_DACEN_Enabled | CMP_DACCR_VRSEL_Vin2 |
+                   ((level << CMP_DACCR_VOSEL_Pos) & CMP_DACCR_VOSEL_Msk);
+}
+
+//Returns the output of a comparator (nonzero while the input is above the threshold).
+int cmp_output(uint8_t id) {
+  return comparators[id].regs->SCR & CMP_SCR_COUT_Msk;
+}
+
+//Enables a comparator as a low leakage wakeup source, running it unfiltered. Its edge interrupts
+//wake the MCU from LLS modes.
+void cmp_wake_arm(uint8_t id) {
+  struct comparator *c = &comparators[id];
+
+  configure(c, 1);
+  armed |= 1 << id;
+  LLWU->ME |= c->wakeup;
+}
+
+//Restores the configured filter of a comparator, and stops using it as a wakeup source.
+void cmp_wake_disarm(uint8_t id) {
+  struct comparator *c = &comparators[id];
+  uint8_t i;
+
+  if (!(armed & (1 << id)))
+    return;
+
+  armed &= ~(1 << id);
+  configure(c, 0);
+
+  //The last two comparators share their wakeup source.
+  for (i = 0; i < CMP_COUNT; i++)
+    if ((armed & (1 << i)) && comparators[i].wakeup == c->wakeup)
+      return;
+  LLWU->ME &= ~c->wakeup;
+}
+
+//Collects the edge flags (clearing them) and notifies the driver process.
+static void handler(struct comparator *c) {
+  uint8_t scr = c->regs->SCR;
+
+  c->regs->SCR = scr;
+  if (scr & CMP_SCR_CFR_Msk)
+    c->edges |= CMP_EDGE_RISING;
+  if (scr & CMP_SCR_CFF_Msk)
+    c->edges |= CMP_EDGE_FALLING;
+
+  process_poll(&cmp_process);
+}
+
+void cmp_0_handler() {
+  handler(&comparators[0]);
+}
+
+void cmp_1_handler() {
+  handler(&comparators[1]);
+}
+
+void cmp_2_handler() {
+  handler(&comparators[2]);
+}
+
+void cmp_3_handler() {
+  handler(&comparators[3]);
+}
+
+//Reports the edges of each comparator to its requester.
+PROCESS_THREAD(cmp_process, ev, data) {
+  static struct cmp_change change;
+  static uint8_t i;
+
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    for (i = 0; i < CMP_COUNT; i++) {
+      struct comparator *c = &comparators[i];
+
+      if (!(active & (1 << i)))
+        continue;
+
+      NVIC_DisableIRQ(c->irq);
+      change.edges = c->edges & c->config.edges;
+      c->edges = 0;
+      NVIC_EnableIRQ(c->irq);
+
+      if (change.edges == 0)
+        continue;
+
+      change.id = i;
+      change.output = cmp_output(i) ? 1 : 0;
+      process_post_synch(c->requester, cmp_event, &change);
+    }
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,80 @@
+//+------------------------------------------------------------------------------------------------+
+//| Analog comparator driver for Kinetis MK66 MCU.                                                 |
+//|                                                                                                |
+//| Watches an analog input against a threshold set by the 6 bit DAC of the comparator (1/64ths    |
+//| of the supply voltage), so crossings are detected in hardware instead of by sampling the ADC.  |
+//| The processes that initialized the comparators get a cmp_event on the selected output edges.   |
+//|                                                                                                |
+//| Noise is dealt with by the hysteresis of the comparator and by its digital filter. With        |
+//| filtering, the output is sampled every filter_period bus clocks and only changes after         |
+//| filter_count samples in a row agree (up to 7). Without it, the comparator runs in continuous   |
+//| mode. The comparator can also hold its output while a window signal is low, but that signal    |
+//| comes from the PDB pulse outputs, which nothing sets up: cmp_init() rejects windowed           |
+//| configurations.                                                                                |
+//|                                                                                                |
+//| For low power operation, cmp_wake_arm() enables the comparator as a low leakage wakeup source, |
+//| so its edges wake the MCU from LLS modes. The filter needs the bus clock, so the comparator    |
+//| runs in continuous mode while armed (count on the hysteresis to reject noise meanwhile).       |
+//|                                                                                                |
+//| Inputs (Teensy 3.6 pin numbers in parenthesis):                                                |
+//| - CMP_0: IN0 PTC6 (11), IN1 PTC7 (12), IN2 PTC8 (35), IN3 PTC9 (36).                           |
+//| - CMP_1: IN0 PTC2 (23), IN1 PTC3 (9).                                                          |
+//| - CMP_2: IN0 PTA12 (3), IN1 PTA13 (4).                                                         |
+//| The remaining inputs connect to dedicated analog pins or to internal signals. PTA12 and PTA13  |
+//| are shared with the first encoder, and PTC6 and PTC7 with SPI0.                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef CMP_H_
+#define CMP_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Comparator identifiers.
+#define CMP_0 0
+#define CMP_1 1
+#define CMP_2 2
+#define CMP_3 3
+
+//Output edges, for the edges field of the configuration and the event data.
+#define CMP_EDGE_RISING   (1 << 0)
+#define CMP_EDGE_FALLING  (1 << 1)
+
+//Hysteresis levels (typical values, at high speed).
+#define CMP_HYSTERESIS_5MV    0
+#define CMP_HYSTERESIS_10MV   1
+#define CMP_HYSTERESIS_20MV   2
+#define CMP_HYSTERESIS_30MV   3
+
+struct cmp_config {
+  uint8_t input;          //Input channel (0 to 7), compared against the DAC threshold
+  uint8_t level;          //DAC threshold, as (level + 1) / 64 of the supply voltage (0 to 63)
+  uint8_t hysteresis;     //Hysteresis level (CMP_HYSTERESIS_*)
+  uint8_t filter_count;   //Samples that must agree for the output to change (0 for no filter)
+  uint8_t filter_period;  //Filter sampling period, in bus clocks (1 to 255)
+  uint8_t windowed;       //Must be 0 (windowing isn't supported)
+  uint8_t edges;          //Output edges that generate events (CMP_EDGE_*)
+};
+
+//Event data: the comparator, the edges seen since the last event and the output level.
+struct cmp_change {
+  uint8_t id;
+  uint8_t edges;
+  uint8_t output;
+};
+
+//Event posted to the process that initialized a comparator when its output changes. Data points to
+//a struct cmp_change, valid during the event only.
+extern process_event_t cmp_event;
+
+int cmp_init(uint8_t id, const struct cmp_config *config);
+void cmp_stop(uint8_t id);
+void cmp_set_level(uint8_t id, uint8_t level);
+int cmp_output(uint8_t id);
+void cmp_wake_arm(uint8_t id);
+void cmp_wake_disarm(uint8_t id);
+
+#endif //CMP_H_
@@ -0,0 +1,248 @@
+//+------------------------------------------------------------------------------------------------+
+//| Fixed rate control loop service for Kinetis MK66 MCU.                                          |
+//|                                                                                                |
+//| PIT1 is reloaded every period and its interrupt runs the registered loop functions. Since the  |
+//| timer counts down from the load value, reading its counter gives the time elapsed since the    |
+//| start of the current period, which is used to measure latency and execution time without any   |
+//| additional timer. An overrun is detected when the timer flag is set again before the loop      |
+//| functions finish; the pending interrupt then starts the next iteration right away.             |
+//|                                                                                                |
+//| Nothing here masks the loop interrupt. Processes only change what it reads with single pointer |
+//| writes, and ask it to reset the statistics instead of clearing them behind its back.           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+#include <string.h>
+
+#include "control-loop.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-pit.h"
+
+//Interrupt priority of the loop. Defaults to the highest one, preempting every other interrupt.
+#ifdef CONTROL_LOOP_CONF_PRIORITY
+#define CONTROL_LOOP_PRIORITY CONTROL_LOOP_CONF_PRIORITY
+#else
+#define CONTROL_LOOP_PRIORITY 0
+#endif
+
+//Registered loop functions.
+static struct control_loop_task *tasks = NULL;
+
+//Loop statistics, updated by the interrupt. The sequence counter allows processes to take a
+//consistent copy without disabling the interrupt. While the loop runs, resets are left to the
+//interrupt, so the statistics only have one writer.
+static struct control_loop_stats stats;
+static volatile uint32_t stats_sequence;
+static volatile uint8_t reset_requested;
+static uint8_t running;
+
+//Compiler barrier. The core doesn't reorder memory accesses, so preventing the compiler from doing
+//it is enough to order buffer updates against the interrupt.
+#define BARRIER() __asm__ volatile ("" ::: "memory")
+
+//Sets the statistics to their initial values.
+static void clear_stats(struct control_loop_stats *s) {
+  memset(s, 0, sizeof(*s));
+  s->exec_min = UINT32_MAX;
+  s->latency_min = UINT32_MAX;
+}
+
+void control_loop_init(uint32_t rate) {
+  //Make sure the PIT is clocked and running. This is normally done already by the clock library.
+  SIM->SCGC6 |= SIM_SCGC6_PIT_Enabled;
+  PIT->MCR = PIT_MCR_MDIS_Enabled | PIT_MCR_FRZ_DbgStop;
+
+  //Configure the period, but leave the timer stopped.
+  PIT->TCTRL1 = PIT_TCTRL_TEN_Disabled;
+  PIT->LDVAL1 = (CONTROL_LOOP_TIMER_FREQ / rate) - 1;
+  PIT->TFLG1 = PIT_TFLG_TIF_Set;
+
+  //Have the core save the FPU context automatically on exception entry (lazily, so the registers
+  //are only stacked when the loop functions actually use the FPU). These are the reset values, but
+  //the loop functions depend on them.
+  FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+
+  control_loop_reset_stats();
+
+  NVIC_SetPriority(PIT_1_IRQn, CONTROL_LOOP_PRIORITY);
+}
+
+//Adds a loop function. Functions run in registration order. The divider allows running slower
+//tasks at an integer fraction of the loop rate.
+void control_loop_register(struct control_loop_task *task, control_loop_fn_t fn, void *ctx,
+                           uint16_t divider) {
+  struct control_loop_task **t;
+
+  task->next = NULL;
+  task->fn = fn;
+  task->ctx = ctx;
+  task->divider = (divider == 0) ? 1 : divider;
+  task->count = 0;
+
+  //Append the task to the end of the list. The single pointer write makes it visible to the
+  //interrupt atomically.
+  for (t = &tasks; *t != NULL; t = &(*t)->next);
+  BARRIER();
+  *t = task;
+}
+
+void control_loop_unregister(struct control_loop_task *task) {
+  struct control_loop_task **t;
+
+  //Unlinking is also a single pointer write. The interrupt either runs the task before it, or
+  //skips it after. Processes can't run in the middle of an iteration, so once this returns the task
+  //is no longer in use. The task keeps its next pointer, in case it unregisters itself.
+  for (t = &tasks; *t != NULL; t = &(*t)->next) {
+    if (*t == task) {
+      *t = task->next;
+      break;
+    }
+  }
+  BARRIER();
+}
+
+void control_loop_start() {
+  //Apply a reset asked for after the last iteration.
+  if (reset_requested) {
+    clear_stats(&stats);
+    stats_sequence++;
+    reset_requested = 0;
+  }
+
+  running = 1;
+  PIT->TFLG1 = PIT_TFLG_TIF_Set;
+  NVIC_ClearPendingIRQ(PIT_1_IRQn);
+  NVIC_EnableIRQ(PIT_1_IRQn);
+  PIT->TCTRL1 = PIT_TCTRL_TEN_Enabled | PIT_TCTRL_TIE_Enabled;
+}
+
+void control_loop_stop() {
+  PIT->TCTRL1 = PIT_TCTRL_TEN_Disabled;
+  NVIC_DisableIRQ(PIT_1_IRQn);
+  running = 0;
+}
+
+//Takes a consistent copy of the loop statistics, retrying if an iteration updated them meanwhile.
+//Gives the initial values while a reset is pending.
+void control_loop_get_stats(struct control_loop_stats *s) {
+  uint32_t sequence;
+
+  do {
+    sequence = stats_sequence;
+    BARRIER();
+    if (reset_requested)
+      clear_stats(s);
+    else
+      *s = stats;
+    BARRIER();
+  } while (sequence != stats_sequence);
+}
+
+//Resets the statistics. While the loop runs, the interrupt does it at the start of its next
+//update, so this doesn't wait for it.
+void control_loop_reset_stats() {
+  if (running) {
+    reset_requested = 1;
+    return;
+  }
+
+  clear_stats(&stats);
+  stats_sequence++;
+  reset_requested = 0;
+}
+
+void pit_1_handler() {
+  struct control_loop_task *task;
+  uint32_t reload, start, end, latency, exec;
+  uint8_t overrun;
+
+  //Capture the time elapsed since the start of the period, then clear the interrupt flag.
+  reload = PIT->LDVAL1;
+  start = PIT->CVAL1;
+  PIT->TFLG1 = PIT_TFLG_TIF_Set;
+
+  //Run the loop functions.
+  for (task = tasks; task != NULL; task = task->next) {
+    if (++task->count >= task->divider) {
+      task->count = 0;
+      task->fn(task->ctx);
+    }
+  }
+
+  //If the timer expired again while running, this iteration overran its period. The counter has
+  //wrapped around in that case, so account for a full period.
+  end = PIT->CVAL1;
+  exec = start - end;
+  overrun = (PIT->TFLG1 & PIT_TFLG_TIF_Msk) ? 1 : 0;
+  if (overrun)
+    exec += reload + 1;
+  latency = reload - start;
+
+  //Update the statistics, starting over first if a process asked to.
+  if (reset_requested) {
+    clear_stats(&stats);
+    reset_requested = 0;
+  }
+  stats.iterations++;
+  stats.overruns += overrun;
+  stats.exec_last = exec;
+  if (exec < stats.exec_min)
+    stats.exec_min = exec;
+  if (exec > stats.exec_max)
+    stats.exec_max = exec;
+  if (latency < stats.latency_min)
+    stats.latency_min = latency;
+  if (latency > stats.latency_max)
+    stats.latency_max = latency;
+  stats.jitter = stats.latency_max - stats.latency_min;
+  BARRIER();
+  stats_sequence++;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Control buffers follow a single writer, single reader discipline:
+//- A process writing to the interrupt fills the buffer returned by control_buffer_back() and then
+//  calls control_buffer_publish(). The interrupt reads control_buffer_front() directly, since the
+//  process can't run while the interrupt does.
+//- The interrupt writing to a process does the same, and the process reads a copy with
+//  control_buffer_read(), which retries if the interrupt published meanwhile.
+//Note that the back buffer holds the data published two times before, so writers should fill all
+//of it.
+
+void control_buffer_init(struct control_buffer *cb, void *buf0, void *buf1, uint16_t size) {
+  cb->buf[0] = buf0;
+  cb->buf[1] = buf1;
+  cb->size = size;
+  cb->front = 0;
+  cb->sequence = 0;
+}
+
+void *control_buffer_back(struct control_buffer *cb) {
+  return cb->buf[cb->front ^ 1];
+}
+
+void control_buffer_publish(struct control_buffer *cb) {
+  BARRIER();
+  cb->front ^= 1;
+  cb->sequence++;
+}
+
+const void *control_buffer_front(const struct control_buffer *cb) {
+  return cb->buf[cb->front];
+}
+
+void control_buffer_read(const struct control_buffer *cb, void *dst) {
+  uint32_t sequence;
+
+  do {
+    sequence = cb->sequence;
+    BARRIER();
+    memcpy(dst, cb->buf[cb->front], cb->size);
+    BARRIER();
+  } while (sequence != cb->sequence);
+}
@@ -0,0 +1,78 @@
+//+------------------------------------------------------------------------------------------------+
+//| Fixed rate control loop service for Kinetis MK66 MCU.                                          |
+//|                                                                                                |
+//| Registered loop functions are called from the PIT1 interrupt at a fixed rate (e.g. 10-20KHz),  |
+//| independently of the cooperative scheduling of contiki processes. The interrupt runs at a      |
+//| priority above every other peripheral used by the platform, and loop functions may freely use  |
+//| the FPU. Each iteration measures its start latency (time from the timer reload to the start of |
+//| the loop functions) and its execution time, and overruns (iterations lasting more than a       |
+//| period) are detected and counted. No call of the service masks the loop interrupt: while the   |
+//| loop runs, resetting the statistics takes effect at the next iteration.                        |
+//|                                                                                                |
+//| Loop functions exchange data with processes through control buffers: lock free double buffers  |
+//| with a single writer and a single reader, where either side may be the interrupt.              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef CONTROL_LOOP_H_
+#define CONTROL_LOOP_H_
+
+#include <stdint.h>
+
+//Frequency of the timer used for measurements (the bus clock).
+#define CONTROL_LOOP_TIMER_FREQ 60000000
+
+//Converts a measurement from timer cycles to nanoseconds.
+#define CONTROL_LOOP_CYCLES_TO_NS(c) ((uint32_t) (((uint64_t) (c) * 1000000000) / \
+                                                  CONTROL_LOOP_TIMER_FREQ))
+
+//Loop function type. Receives the context pointer given at registration.
+typedef void (* control_loop_fn_t)(void *ctx);
+
+//Loop function registration entry. Storage is provided by the caller.
+struct control_loop_task {
+  struct control_loop_task *next;
+  control_loop_fn_t fn;
+  void *ctx;
+  uint16_t divider;       //Run the function once every divider iterations
+  uint16_t count;
+};
+
+//Loop statistics. Times are given in timer cycles (see CONTROL_LOOP_TIMER_FREQ).
+struct control_loop_stats {
+  uint32_t iterations;    //Iterations run since the last reset
+  uint32_t overruns;      //Iterations that lasted more than a period
+  uint32_t exec_last;     //Execution time of the loop functions
+  uint32_t exec_min;
+  uint32_t exec_max;
+  uint32_t latency_min;   //Time from the timer reload to the start of the loop functions
+  uint32_t latency_max;
+  uint32_t jitter;        //Start time variation (latency_max - latency_min)
+};
+
+//Lock free double buffer. The writer fills the back buffer and then publishes it, swapping it with
+//the front one. Both buffers must be provided by the caller and have the same size.
+struct control_buffer {
+  void *buf[2];
+  uint16_t size;
+  volatile uint8_t front;
+  volatile uint32_t sequence;   //Incremented on every publication
+};
+
+void control_loop_init(uint32_t rate);
+void control_loop_register(struct control_loop_task *task, control_loop_fn_t fn, void *ctx,
+                           uint16_t divider);
+void control_loop_unregister(struct control_loop_task *task);
+void control_loop_start();
+void control_loop_stop();
+void control_loop_get_stats(struct control_loop_stats *stats);
+void control_loop_reset_stats();
+
+void control_buffer_init(struct control_buffer *cb, void *buf0, void *buf1, uint16_t size);
+void *control_buffer_back(struct control_buffer *cb);
+void control_buffer_publish(struct control_buffer *cb);
+const void *control_buffer_front(const struct control_buffer *cb);
+void control_buffer_read(const struct control_buffer *cb, void *dst);
+
+#endif //CONTROL_LOOP_H_
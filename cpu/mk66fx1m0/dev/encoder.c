@@ -0,0 +1,206 @@
+//+------------------------------------------------------------------------------------------------+
+//| Quadrature encoder driver for Kinetis MK66 MCU.                                                |
+//|                                                                                                |
+//| The counters run from 0 to 0xFFFF. On every overflow the timer sets its TOF flag and records   |
+//| the counting direction in TOFDIR, which the overflow interrupt uses to update a count of       |
+//| wraps. The position is then wraps * 65536 + CNT, read consistently even from interrupts of     |
+//| higher priority than the overflow interrupt (see read_raw()).                                  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "encoder.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-pit.h"
+#include "mk66-ftm.h"
+
+//Amount of samples over which velocity is estimated. Longer windows give finer velocity resolution
+//at low speeds, at the expense of a slower response.
+#ifdef ENCODER_CONF_VELOCITY_WINDOW
+#define VELOCITY_WINDOW ENCODER_CONF_VELOCITY_WINDOW
+#else
+#define VELOCITY_WINDOW 8
+#endif
+
+//Bus clock frequency, used by the PIT.
+#define BUS_CLK 60000000
+
+//Interrupt priorities. Overflows are serviced above the sampling interrupt, and both stay below
+//the control loop (which may read positions at any time).
+#define OVERFLOW_PRIORITY 1
+#define SAMPLING_PRIORITY 2
+
+struct encoder_state {
+  volatile struct FTM_type *ftm;
+  IRQn_Type irq;
+  uint8_t enabled;
+  volatile int32_t wraps;                   //Counter overflows (positive when counting up)
+  int64_t offset;                           //Offset applied to reported positions
+  int64_t samples[VELOCITY_WINDOW];         //Position samples, used as a ring
+  uint8_t sample_index;
+  uint8_t sample_count;
+  volatile int32_t velocity;                //Counts per second
+};
+
+static struct encoder_state encoders[2] = {
+  { .ftm = FTM1, .irq = FTM_1_IRQn },
+  { .ftm = FTM2, .irq = FTM_2_IRQn },
+};
+
+static uint32_t sampling_rate;
+
+//Reads the extended hardware position. If the counter overflowed but the interrupt hasn't been
+//serviced yet (because this is called with interrupts masked or from a higher priority interrupt),
+//the pending overflow is accounted here.
+static int64_t read_raw(struct encoder_state *enc) {
+  int32_t wraps, pending;
+  uint16_t count;
+
+  do {
+    wraps = enc->wraps;
+    pending = 0;
+    count = enc->ftm->CNT;
+    if (enc->ftm->SC & FTM_SC_TOF_Msk) {
+      count = enc->ftm->CNT;
+      pending = (enc->ftm->QDCTRL & FTM_QDCTRL_TOFDIR_Msk) ? 1 : -1;
+    }
+  } while (wraps != enc->wraps);
+
+  return ((int64_t) (wraps + pending) << 16) + count;
+}
+
+//Configures an encoder. The filter value (0-15) sets the minimum phase pulse width, in multiples
+//of 4 bus cycles (0 disables filtering), and invert swaps the counting direction.
+void encoder_init(uint8_t id, uint8_t filter, uint8_t invert) {
+  struct encoder_state *enc = &encoders[id];
+  volatile struct FTM_type *ftm = enc->ftm;
+
+  //Enable the module clock and route the phase inputs.
+  if (id == ENCODER_1) {
+    SIM->SCGC6 |= SIM_SCGC6_FTM1_Enabled;
+    PORTA->PCR[12] = PORT_PCR_MUX_Alt7;
+    PORTA->PCR[13] = PORT_PCR_MUX_Alt7;
+  } else {
+    SIM->SCGC6 |= SIM_SCGC6_FTM2_Enabled;
+    PORTB->PCR[18] = PORT_PCR_MUX_Alt6;
+    PORTB->PCR[19] = PORT_PCR_MUX_Alt6;
+  }
+
+  //Stop the timer and unlock the write protected registers.
+  ftm->MODE = FTM_MODE_WPDIS_Disabled;
+  ftm->SC = FTM_SC_CLKS_None;
+  ftm->MODE = FTM_MODE_FTMEN_Enabled | FTM_MODE_WPDIS_Disabled;
+
+  //Count over the full 16 bit range.
+  ftm->CNTIN = 0;
+  ftm->MOD = FTM_COUNT_Msk;
+  ftm->CNT = 0;
+
+  //Enable the quadrature decoder, with the input filters if requested.
+  ftm->FILTER = ((filter << FTM_FILTER_CH0FVAL_Pos) & FTM_FILTER_CH0FVAL_Msk) |
+                ((filter << FTM_FILTER_CH1FVAL_Pos) & FTM_FILTER_CH1FVAL_Msk);
+  ftm->QDCTRL = FTM_QDCTRL_QUADEN_Enabled | FTM_QDCTRL_QUADMODE_Phase_AB |
+                (invert ? FTM_QDCTRL_PHBPOL_Inverted : FTM_QDCTRL_PHBPOL_Normal) |
+                (filter ? (FTM_QDCTRL_PHAFLTREN_Enabled | FTM_QDCTRL_PHBFLTREN_Enabled) : 0);
+
+  enc->wraps = 0;
+  enc->offset = 0;
+  enc->sample_index = 0;
+  enc->sample_count = 0;
+  enc->velocity = 0;
+  enc->enabled = 1;
+
+  //Start the timer (it must be clocked even in quadrature mode) with the overflow interrupt.
+  ftm->SC = FTM_SC_CLKS_System | FTM_SC_PS_Div_1 | FTM_SC_TOIE_Enabled;
+  NVIC_SetPriority(enc->irq, OVERFLOW_PRIORITY);
+  NVIC_EnableIRQ(enc->irq);
+}
+
+//Starts sampling the encoder positions at the given rate (in Hz) for velocity estimation.
+void encoder_sampling_start(uint32_t rate) {
+  sampling_rate = rate;
+
+  SIM->SCGC6 |= SIM_SCGC6_PIT_Enabled;
+  PIT->MCR = PIT_MCR_MDIS_Enabled | PIT_MCR_FRZ_DbgStop;
+  PIT->TCTRL3 = PIT_TCTRL_TEN_Disabled;
+  PIT->LDVAL3 = (BUS_CLK / rate) - 1;
+  PIT->TFLG3 = PIT_TFLG_TIF_Set;
+  PIT->TCTRL3 = PIT_TCTRL_TEN_Enabled | PIT_TCTRL_TIE_Enabled;
+
+  NVIC_SetPriority(PIT_3_IRQn, SAMPLING_PRIORITY);
+  NVIC_EnableIRQ(PIT_3_IRQn);
+}
+
+void encoder_sampling_stop() {
+  PIT->TCTRL3 = PIT_TCTRL_TEN_Disabled;
+  NVIC_DisableIRQ(PIT_3_IRQn);
+}
+
+//Returns the position of an encoder in counts (4 per quadrature cycle).
+int64_t encoder_position(uint8_t id) {
+  return read_raw(&encoders[id]) + encoders[id].offset;
+}
+
+//Sets the current position of an encoder. To be called from process context only.
+void encoder_set_position(uint8_t id, int64_t position) {
+  encoders[id].offset = position - read_raw(&encoders[id]);
+}
+
+//Returns the velocity of an encoder in counts per second, as of the last sample.
+int32_t encoder_velocity(uint8_t id) {
+  return encoders[id].velocity;
+}
+
+static void overflow_handler(struct encoder_state *enc) {
+  uint32_t sc = enc->ftm->SC;
+
+  //The flag is cleared by writing 0 to it after reading it set.
+  if (sc & FTM_SC_TOF_Msk) {
+    enc->ftm->SC = sc & ~FTM_SC_TOF_Msk;
+    enc->wraps += (enc->ftm->QDCTRL & FTM_QDCTRL_TOFDIR_Msk) ? 1 : -1;
+  }
+}
+
+void ftm_1_handler() {
+  overflow_handler(&encoders[ENCODER_1]);
+}
+
+void ftm_2_handler() {
+  overflow_handler(&encoders[ENCODER_2]);
+}
+
+void pit_3_handler() {
+  struct encoder_state *enc;
+  int64_t position, displacement;
+  uint8_t i;
+
+  PIT->TFLG3 = PIT_TFLG_TIF_Set;
+
+  for (i = 0; i < 2; i++) {
+    enc = &encoders[i];
+    if (!enc->enabled)
+      continue;
+
+    //The oldest sample in the ring is the one being replaced.
+    position = read_raw(enc);
+    if (enc->sample_count > 0) {
+      if (enc->sample_count < VELOCITY_WINDOW) {
+        displacement = position - enc->samples[0];
+        enc->velocity = displacement * sampling_rate / enc->sample_count;
+      } else {
+        displacement = position - enc->samples[enc->sample_index];
+        enc->velocity = displacement * sampling_rate / VELOCITY_WINDOW;
+      }
+    }
+    if (enc->sample_count < VELOCITY_WINDOW)
+      enc->sample_count++;
+
+    enc->samples[enc->sample_index] = position;
+    enc->sample_index = (enc->sample_index + 1) % VELOCITY_WINDOW;
+  }
+}
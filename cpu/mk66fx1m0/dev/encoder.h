@@ -0,0 +1,33 @@
+//+------------------------------------------------------------------------------------------------+
+//| Quadrature encoder driver for Kinetis MK66 MCU.                                                |
+//|                                                                                                |
+//| Encoders are decoded by FTM1 and FTM2 in quadrature decoder mode, so counting takes no CPU     |
+//| time regardless of the shaft speed. The 16 bit hardware counters are extended to 64 bits with  |
+//| their overflow interrupts (one every 65536 counts). Velocity is estimated by sampling the      |
+//| positions at a fixed rate from the PIT3 interrupt, and dividing the displacement over a window |
+//| of samples by its duration.                                                                    |
+//|                                                                                                |
+//| Phase inputs (Teensy 3.6 pin numbers in parenthesis):                                          |
+//| - ENCODER_1 (FTM1): phase A on PTA12 (3), phase B on PTA13 (4).                                |
+//| - ENCODER_2 (FTM2): phase A on PTB18 (29), phase B on PTB19 (30).                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef ENCODER_H_
+#define ENCODER_H_
+
+#include <stdint.h>
+
+//Encoder identifiers.
+#define ENCODER_1 0
+#define ENCODER_2 1
+
+void encoder_init(uint8_t id, uint8_t filter, uint8_t invert);
+void encoder_sampling_start(uint32_t rate);
+void encoder_sampling_stop();
+int64_t encoder_position(uint8_t id);
+void encoder_set_position(uint8_t id, int64_t position);
+int32_t encoder_velocity(uint8_t id);
+
+#endif //ENCODER_H_
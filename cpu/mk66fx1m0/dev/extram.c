@@ -0,0 +1,166 @@
+//+------------------------------------------------------------------------------------------------+
+//| External SRAM driver for Kinetis MK66 MCU.                                                     |
+//|                                                                                                |
+//| The allocation pool is a first fit free list kept in address order, so adjacent free blocks    |
+//| are merged when released. Every block starts with an 8 byte header holding its size, which is  |
+//| a multiple of 8 (including the header). Free blocks use the rest of the header to link the     |
+//| list. The headers live in external memory too, as do the blocks themselves.                    |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "extram.h"
+
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-fb.h"
+
+//Block header.
+struct block {
+  uint32_t size;          //Size of the block, including the header
+  struct block *next;     //Next free block (only while free)
+};
+
+#define HEADER_SIZE sizeof(struct block)
+#define ALIGNMENT 8
+
+//Symbols exported by the linker script.
+extern uint8_t __extram_start__;
+extern uint8_t __extram_end__;
+extern uint8_t __extram_pool_start__;
+
+//Pin assignments of the address/data lines, from FB_AD0 on.
+static volatile struct PORT_type * const ad_ports[] = {
+  PORTD, PORTD, PORTD, PORTD, PORTD, PORTC, PORTC, PORTC, PORTC, PORTC, PORTC, PORTC,
+  PORTC, PORTC, PORTC, PORTB, PORTB, PORTB, PORTB, PORTB, PORTB, PORTB, PORTB, PORTB,
+};
+static const uint8_t ad_pins[] = {
+  6, 5, 4, 3, 2, 10, 9, 8, 7, 6, 5, 4,
+  2, 1, 0, 18, 17, 16, 11, 10, 9, 8, 7, 6,
+};
+
+#define PIN_CONFIG (PORT_PCR_DSE_High | PORT_PCR_SRE_Fast | PORT_PCR_MUX_Alt5)
+
+//Free list, sorted by address.
+static struct block *free_list;
+
+//--------------------------------------------------------------------------------------------------
+
+//Configures the FlexBus chip select 0 for the external memory and its pins. Leaves the memory
+//contents alone, including the allocation pool.
+void extram_init() {
+  uint32_t size = &__extram_end__ - &__extram_start__;
+  uint8_t i, lines;
+
+  //Count the address lines that reach the memory. The lower 16 are always used for data.
+  for (lines = 16; lines < sizeof(ad_pins) && (1UL << lines) < size; lines++);
+
+  //Enable the FlexBus clock and let it be accessed for data.
+  SIM->SCGC7 |= SIM_SCGC7_FLEXBUS_Enabled;
+  SIM->SOPT2 |= SIM_SOPT2_FBSL_Allow_Data;
+
+  //Configure the pins.
+  for (i = 0; i < lines; i++)
+    ad_ports[i]->PCR[ad_pins[i]] = PIN_CONFIG;
+  PORTD->PCR[0] = PIN_CONFIG;     //FB_ALE
+  PORTD->PCR[1] = PIN_CONFIG;     //FB_CS0
+  PORTB->PCR[19] = PIN_CONFIG;    //FB_OE
+  PORTC->PCR[11] = PIN_CONFIG;    //FB_RW
+  PORTC->PCR[17] = PIN_CONFIG;    //FB_BLS7_0
+  PORTC->PCR[16] = PIN_CONFIG;    //FB_BLS15_8
+
+  //Select the address latch enable and the byte lane strobes on the shared pins.
+  FB->CSPMCR = FB_CSPMCR_GROUP1_ALE | FB_CSPMCR_GROUP2_BE31_24 | FB_CSPMCR_GROUP3_BE23_16;
+
+  //Configure chip select 0: 16 bit port with right justified data, byte lane strobes on both reads
+  //and writes, internal acknowledge after the wait states.
+  FB->CS[0].CSAR = (uint32_t) &__extram_start__ & FB_CSAR_BA_Msk;
+  FB->CS[0].CSCR = ((EXTRAM_WAIT_STATES << FB_CSCR_WS_Pos) & FB_CSCR_WS_Msk) | FB_CSCR_AA_Enabled |
+                   FB_CSCR_PS_16Bit | FB_CSCR_BLS_Right | FB_CSCR_BEM_Read_Write;
+  FB->CS[0].CSMR = (((size - 1) >> 16) << FB_CSMR_BAM_Pos) | FB_CSMR_V_Valid;
+}
+
+//Sets up the allocation pool with the space not taken by the .extram section, freeing any blocks
+//allocated before.
+void extram_pool_init() {
+  //The whole pool starts as a single free block.
+  free_list = (struct block *) &__extram_pool_start__;
+  free_list->size = (&__extram_end__ - &__extram_pool_start__) & ~(ALIGNMENT - 1);
+  free_list->next = NULL;
+  if (free_list->size < 2 * HEADER_SIZE)
+    free_list = NULL;
+}
+
+//Allocates a block from the pool. Returns NULL if there's no free block large enough.
+void *extram_alloc(uint32_t size) {
+  struct block **link, *b, *rest;
+
+  size = (size + HEADER_SIZE + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+  for (link = &free_list; (b = *link) != NULL; link = &b->next) {
+    if (b->size < size)
+      continue;
+
+    //Split the block if the remainder can hold an allocation, otherwise take it whole.
+    if (b->size - size >= 2 * HEADER_SIZE) {
+      rest = (struct block *) ((uint8_t *) b + size);
+      rest->size = b->size - size;
+      rest->next = b->next;
+      b->size = size;
+      *link = rest;
+    } else {
+      *link = b->next;
+    }
+
+    return (uint8_t *) b + HEADER_SIZE;
+  }
+
+  return NULL;
+}
+
+//Returns a block to the pool, merging it with its free neighbours.
+void extram_free(void *ptr) {
+  struct block *b, *prev, *next;
+
+  if (ptr == NULL)
+    return;
+
+  b = (struct block *) ((uint8_t *) ptr - HEADER_SIZE);
+
+  //Find the free blocks around it.
+  prev = NULL;
+  for (next = free_list; next != NULL && next < b; next = next->next)
+    prev = next;
+
+  //Link it, merging with the next block if adjacent.
+  if (next != NULL && (uint8_t *) b + b->size == (uint8_t *) next) {
+    b->size += next->size;
+    b->next = next->next;
+  } else {
+    b->next = next;
+  }
+
+  //Merge with the previous block if adjacent.
+  if (prev == NULL) {
+    free_list = b;
+  } else if ((uint8_t *) prev + prev->size == (uint8_t *) b) {
+    prev->size += b->size;
+    prev->next = b->next;
+  } else {
+    prev->next = b;
+  }
+}
+
+//Returns the size of the largest block that can be allocated.
+uint32_t extram_available() {
+  uint32_t largest = 0;
+  struct block *b;
+
+  for (b = free_list; b != NULL; b = b->next)
+    if (b->size > largest)
+      largest = b->size;
+
+  return largest > HEADER_SIZE ? largest - HEADER_SIZE : 0;
+}
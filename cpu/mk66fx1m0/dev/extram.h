@@ -0,0 +1,64 @@
+//+------------------------------------------------------------------------------------------------+
+//| External SRAM driver for Kinetis MK66 MCU.                                                     |
+//|                                                                                                |
+//| Extends the memory space with an asynchronous SRAM (or PSRAM in asynchronous mode) attached to |
+//| the FlexBus. The memory is mapped at 0x60000000, with its size set by the EXTRAM region of the |
+//| linker script (512KB by default). Variables are placed there with the EXTRAM_DATA attribute,   |
+//| and the space the linker leaves unused is managed as an allocation pool. Neither is            |
+//| initialized at startup. The pool is reset with extram_pool_init(), which the platform skips    |
+//| when resuming from a suspend, so allocated blocks survive it along with the variables.         |
+//|                                                                                                |
+//| The bus runs in multiplexed mode at 60MHz, with a 16 bit port whose data lanes are FB_AD[15:0] |
+//| (right justified). The memory is connected as follows:                                         |
+//| - FB_AD[15:0] to the memory data lines, and to the inputs of a 16 bit transparent latch        |
+//|   (74LVC16373 or similar) enabled by FB_ALE. Latch outputs 15 to 1 drive memory lines A14-A0.  |
+//| - FB_AD16 and up drive memory lines A15 and up directly, as they hold the address for the      |
+//|   whole cycle.                                                                                 |
+//| - FB_CS0 to chip enable, FB_OE to output enable and FB_RW to write enable.                     |
+//| - FB_BLS7_0 to the lower byte enable and FB_BLS15_8 to the upper byte enable.                  |
+//|                                                                                                |
+//| Pins used: FB_AD0-4 on PTD6-2, FB_AD5-11 on PTC10-4, FB_AD12-14 on PTC2-0, FB_AD15-17 on       |
+//| PTB18-16, FB_AD18-23 on PTB11-6, FB_ALE on PTD0, FB_CS0 on PTD1, FB_OE on PTB19, FB_RW on      |
+//| PTC11, FB_BLS7_0 on PTC17 and FB_BLS15_8 on PTC16. They overlap the pins of SPI0 and of the    |
+//| logic capture inputs, so those drivers can't be used along with external memory. As FB_AD16    |
+//| and FB_AD17 sit on the default console pins, the platform moves the console to PTA14 (TX) and  |
+//| PTA15 (RX) when external memory is enabled.                                                    |
+//|                                                                                                |
+//| Each bus cycle takes a few clocks plus the wait states, 32 bit accesses take two of them, and  |
+//| external memory isn't cached. It suits large buffers accessed in bulk (preferably by DMA)      |
+//| rather than hot variables. See the extram-bench example for figures.                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef EXTRAM_H_
+#define EXTRAM_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Enables external memory at platform initialization.
+#ifdef EXTRAM_CONF_ENABLED
+#define EXTRAM_ENABLED EXTRAM_CONF_ENABLED
+#else
+#define EXTRAM_ENABLED 0
+#endif
+
+//Wait states added to each access (0 to 63). One wait state suits 10ns parts.
+#ifdef EXTRAM_CONF_WAIT_STATES
+#define EXTRAM_WAIT_STATES EXTRAM_CONF_WAIT_STATES
+#else
+#define EXTRAM_WAIT_STATES 1
+#endif
+
+//Attribute that places a variable in external memory.
+#define EXTRAM_DATA __attribute__((section(".extram")))
+
+void extram_init();
+void extram_pool_init();
+void *extram_alloc(uint32_t size);
+void extram_free(void *ptr);
+uint32_t extram_available();
+
+#endif //EXTRAM_H_
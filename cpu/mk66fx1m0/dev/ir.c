@@ -0,0 +1,247 @@
+//+------------------------------------------------------------------------------------------------+
+//| Infrared transmitter driver for Kinetis MK66 MCU.                                              |
+//|                                                                                                |
+//| The CMT latches the mark and space registers when a cycle starts, so they're always written a  |
+//| cycle ahead: the first two pairs before starting, then one per end of cycle interrupt. Once    |
+//| the last pair has been latched, the extended space mode keeps the modulator from sending marks |
+//| after it, and the modulator is disabled when it ends.                                          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "ir.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-cmt.h"
+
+//Interrupt priority. A cycle lasts hundreds of microseconds at least, so latency is not an issue.
+#define IR_PRIORITY 10
+
+//The bus clock divided by 8 clocks the carrier generator, and that divided by 8 the modulator.
+#define BUS_CLOCK 60000000
+#define CMT_CLOCK (BUS_CLOCK / 8)
+
+//Converts microseconds to modulator ticks (16/15 of a microsecond each).
+#define TICKS(us) (((uint32_t) (us) * 15 + 8) / 16)
+
+//NEC timings.
+#define NEC_LEADER_MARK 9000
+#define NEC_LEADER_SPACE 4500
+#define NEC_REPEAT_SPACE 2250
+#define NEC_BIT_MARK 562
+#define NEC_ZERO_SPACE 562
+#define NEC_ONE_SPACE 1687
+
+//RC5 half bit time.
+#define RC5_HALF_BIT 889
+
+//Transmission state.
+static const uint16_t *sequence;
+static uint16_t length;
+static uint16_t cycles;
+static uint16_t loaded;
+static uint16_t ended;
+static volatile uint8_t busy;
+static struct process *requester;
+
+process_event_t ir_event;
+
+PROCESS(ir_process, "IR");
+
+//--------------------------------------------------------------------------------------------------
+
+//Writes a mark/space pair of the sequence into the modulator registers. A missing final space is
+//taken as the shortest one.
+static void load(uint16_t cycle) {
+  uint32_t mark = TICKS(sequence[2 * cycle]);
+  uint32_t space = (2 * cycle + 1 < length) ? TICKS(sequence[2 * cycle + 1]) : 1;
+
+  //Marks last one tick more than the value written.
+  mark = (mark > 0) ? mark - 1 : 0;
+  if (space == 0)
+    space = 1;
+
+  CMT->CMD1 = mark >> 8;
+  CMT->CMD2 = mark;
+  CMT->CMD3 = space >> 8;
+  CMT->CMD4 = space;
+}
+
+//Initializes the CMT and its output pin. The output stays low while idle.
+void ir_init() {
+  ir_event = process_alloc_event();
+  process_start(&ir_process, NULL);
+
+  SIM->SCGC4 |= SIM_SCGC4_CMT_Enabled;
+
+  CMT->MSC = 0;
+  CMT->PPS = (BUS_CLOCK / CMT_CLOCK - 1) << CMT_PPS_PPSDIV_Pos;
+  CMT->OC = CMT_OC_IROPEN_Enabled | CMT_OC_CMTPOL_High | CMT_OC_IROL_Low;
+  CMT->DMA = CMT_DMA_DMA_Interrupt;
+
+  PORTD->PCR[7] = PORT_PCR_DSE_High | PORT_PCR_MUX_Alt2;
+
+  busy = 0;
+
+  NVIC_SetPriority(CMT_IRQn, IR_PRIORITY);
+  NVIC_EnableIRQ(CMT_IRQn);
+}
+
+//Starts sending a sequence of count durations (in microseconds, alternating mark and space),
+//modulated with the given carrier frequency (in Hz) and duty cycle (in percent). Returns -1 if a
+//transmission is in progress or the carrier can't be generated, otherwise 0. The calling process
+//gets an ir_event when it ends.
+int ir_send(const uint16_t *durations, uint16_t count, uint32_t carrier, uint8_t duty) {
+  uint32_t period, high, low;
+
+  if (busy || count == 0 || carrier < IR_CARRIER_MIN || carrier > IR_CARRIER_MAX)
+    return -1;
+
+  //Carrier high and low times, in carrier generator clocks. Each one fits in 8 bits, so carriers
+  //with periods longer than 255 clocks only fit duty cycles close enough to 50%.
+  period = (CMT_CLOCK + carrier / 2) / carrier;
+  high = (period * duty + 50) / 100;
+  high = (high < 1) ? 1 : high;
+  low = (period > high) ? period - high : 1;
+  if (high > 255 || low > 255)
+    return -1;
+
+  requester = PROCESS_CURRENT();
+
+  CMT->CGH1 = high;
+  CMT->CGL1 = low;
+
+  sequence = durations;
+  length = count;
+  cycles = (count + 1) / 2;
+  ended = 0;
+  busy = 1;
+
+  //Start with the first pair, and queue the second one once it has been latched (after the first
+  //modulator tick). A single pair is followed by spaces right away.
+  load(0);
+  CMT->MSC = CMT_MSC_MCGEN_Enabled | CMT_MSC_EOCIE_Enabled | CMT_MSC_FSK_Time |
+             CMT_MSC_BASE_Disabled | CMT_MSC_CMTDIV_Div1;
+  clock_delay_usec(2);
+  if (cycles > 1)
+    load(1);
+  else
+    CMT->MSC |= CMT_MSC_EXSPC_Enabled;
+  loaded = 2;
+
+  return 0;
+}
+
+//Returns nonzero while a transmission is in progress.
+int ir_busy() {
+  return busy;
+}
+
+//Encodes a NEC frame. Addresses above 255 are sent as extended (16 bit) ones, otherwise the address
+//is followed by its complement. Returns the number of durations (IR_NEC_LENGTH).
+uint16_t ir_encode_nec(uint16_t *durations, uint16_t address, uint8_t command) {
+  uint32_t data;
+  uint16_t n = 0;
+  uint8_t i;
+
+  if (address > 0xFF)
+    data = address;
+  else
+    data = address | ((address ^ 0xFF) << 8);
+  data |= ((uint32_t) command << 16) | ((uint32_t) (command ^ 0xFF) << 24);
+
+  durations[n++] = NEC_LEADER_MARK;
+  durations[n++] = NEC_LEADER_SPACE;
+
+  //Bits go least significant first.
+  for (i = 0; i < 32; i++) {
+    durations[n++] = NEC_BIT_MARK;
+    durations[n++] = (data & (1UL << i)) ? NEC_ONE_SPACE : NEC_ZERO_SPACE;
+  }
+
+  //Stop bit.
+  durations[n++] = NEC_BIT_MARK;
+
+  return n;
+}
+
+//Encodes a NEC repeat code, sent every 110ms while a key is held after its frame. Returns the
+//number of durations (IR_NEC_REPEAT_LENGTH).
+uint16_t ir_encode_nec_repeat(uint16_t *durations) {
+  durations[0] = NEC_LEADER_MARK;
+  durations[1] = NEC_REPEAT_SPACE;
+  durations[2] = NEC_BIT_MARK;
+
+  return 3;
+}
+
+//Encodes an RC5 frame. Commands above 63 are sent as RC5X (with the second start bit inverted).
+//Returns the number of durations (up to IR_RC5_LENGTH).
+uint16_t ir_encode_rc5(uint16_t *durations, uint8_t toggle, uint8_t address, uint8_t command) {
+  uint16_t frame, n = 0;
+  uint8_t i, half, mark;
+
+  frame = (1 << 13) | ((command & 0x40) ? 0 : (1 << 12)) | ((toggle & 1) << 11) |
+          ((address & 0x1F) << 6) | (command & 0x3F);
+
+  //Bits go most significant first, each a space and a mark for ones and the opposite for zeros.
+  //Half bits of the same level are merged, and the leading space is dropped.
+  for (i = 0; i < 14; i++) {
+    for (half = 0; half < 2; half++) {
+      mark = ((frame >> (13 - i)) & 1) == half;
+
+      if (n == 0) {
+        if (mark)
+          durations[n++] = RC5_HALF_BIT;
+      } else if (((n - 1) % 2 == 0) == mark) {
+        durations[n - 1] += RC5_HALF_BIT;
+      } else {
+        durations[n++] = RC5_HALF_BIT;
+      }
+    }
+  }
+
+  //Drop the trailing space as well.
+  if (n % 2 == 0)
+    n--;
+
+  return n;
+}
+
+//End of cycle.
+void cmt_handler() {
+  //Reading the status register and then accessing a modulator data register clears the flag.
+  (void) CMT->MSC;
+  ended++;
+
+  if (ended == cycles) {
+    //Done.
+    (void) CMT->CMD2;
+    CMT->MSC = 0;
+    busy = 0;
+    process_poll(&ir_process);
+  } else if (loaded < cycles) {
+    //Queue the pair after the one just started.
+    load(loaded++);
+  } else {
+    //The last pair just started, no more marks after it.
+    (void) CMT->CMD2;
+    CMT->MSC |= CMT_MSC_EXSPC_Enabled;
+  }
+}
+
+//Notifies the requester of the end of transmissions.
+PROCESS_THREAD(ir_process, ev, data) {
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    process_post(requester, ir_event, NULL);
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,57 @@
+//+------------------------------------------------------------------------------------------------+
+//| Infrared transmitter driver for Kinetis MK66 MCU.                                              |
+//|                                                                                                |
+//| Sends infrared remote control sequences with the carrier modulator transmitter (CMT). A        |
+//| sequence is a list of durations in microseconds, alternating mark (carrier on) and space       |
+//| (carrier off) and starting with a mark, like the raw codes of LIRC. The CMT generates the      |
+//| carrier and times every mark/space pair in hardware, running in time mode. Its end of cycle    |
+//| interrupt loads the pair after the next one, so the CPU runs a few microseconds per pair (once |
+//| every millisecond or so) and never waits on the sequence. When the last pair ends, the         |
+//| process that started the transmission gets an ir_event.                                        |
+//|                                                                                                |
+//| Durations go up to 65535us, in steps of 1.07us. Carriers go from 30KHz to 1MHz with any duty   |
+//| cycle (given in percent), and down to 15KHz with duty cycles near 50%. Others are rejected.    |
+//| The sequence buffer must stay untouched until the transmission ends.                           |
+//| Helper functions encode NEC and RC5 frames into such buffers.                                  |
+//|                                                                                                |
+//| Output on CMT_IRO, PTD7 (Teensy 3.6 pin 5). The pin has a high current driver, able to drive   |
+//| an infrared LED through a series resistor (about 100mA peak with 20 ohms). It's shared with    |
+//| channel 7 of the logic capture driver.                                                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef IR_H_
+#define IR_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Carrier frequencies and duty cycles of the supported protocols.
+#define IR_NEC_CARRIER 38000
+#define IR_NEC_DUTY 33
+#define IR_RC5_CARRIER 36000
+#define IR_RC5_DUTY 25
+
+//Carrier frequency range, in Hz.
+#define IR_CARRIER_MIN 15000
+#define IR_CARRIER_MAX 1000000
+
+//Maximum sequence lengths of the supported protocols.
+#define IR_NEC_LENGTH 67
+#define IR_NEC_REPEAT_LENGTH 3
+#define IR_RC5_LENGTH 27
+
+//Event posted to the process that started a transmission, once it ends.
+extern process_event_t ir_event;
+
+void ir_init();
+int ir_send(const uint16_t *durations, uint16_t count, uint32_t carrier, uint8_t duty);
+int ir_busy();
+
+uint16_t ir_encode_nec(uint16_t *durations, uint16_t address, uint8_t command);
+uint16_t ir_encode_nec_repeat(uint16_t *durations);
+uint16_t ir_encode_rc5(uint16_t *durations, uint8_t toggle, uint8_t address, uint8_t command);
+
+#endif //IR_H_
@@ -0,0 +1,170 @@
+//+------------------------------------------------------------------------------------------------+
+//| Addressable LED strip (WS2812/SK6812) output for Kinetis MK66 MCU.                             |
+//|                                                                                                |
+//| The DMA channel of a chain runs in circular fashion over both halves of its transfer buffer,   |
+//| with half and major loop interrupts. Every interrupt refills the half just sent with the next  |
+//| encoded bytes, until the strip has sent its latch time, when the channel is stopped.           |
+//|                                                                                                |
+//| Every data byte becomes two 16 bit SPI frames, pushed as complete PUSHR words (command and     |
+//| data). Frame boundaries fall on the low part of a data bit, so the small delays inserted by    |
+//| the SPI module between frames only stretch low times, which the LEDs tolerate.                 |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "led-strip.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-spi.h"
+#include "mk66-dma.h"
+#include "mk66-dmamux.h"
+
+#define SPI_CTAR_BAUD (SPI_CTAR_PBR_Div_3 | (2 << SPI_CTAR_BR_Pos))
+
+//Pixel bytes encoded per half buffer, and PUSHR words per half buffer.
+#define HALF_BYTES 48
+#define HALF_WORDS (HALF_BYTES * 2)
+
+//Interrupt priority. Refills are due once every half buffer (~460us), so it can be low.
+#define DMA_PRIORITY 6
+
+//Hardware of every chain.
+struct chain {
+  volatile struct SPI_type *spi;
+  uint8_t dma_channel;
+  uint8_t dma_source;
+  volatile struct PORT_type *port;
+  uint8_t pin;
+  uint32_t mux;
+};
+
+static const struct chain chains[LED_STRIP_CHAINS] = {
+  { SPI0, 0, DMAMUX_SOURCE_SPI0_Tx, PORTC, 6, PORT_PCR_MUX_Alt2 },
+  { SPI1, 8, DMAMUX_SOURCE_SPI1, PORTD, 6, PORT_PCR_MUX_Alt7 },
+  { SPI2, 9, DMAMUX_SOURCE_SPI2, PORTB, 22, PORT_PCR_MUX_Alt2 },
+};
+
+//Transfer state of every chain.
+struct transfer {
+  uint32_t words[HALF_WORDS * 2];
+  struct led_strip *strip;
+  uint8_t last_half[2];
+  uint8_t sending;
+};
+
+static struct transfer transfers[LED_STRIP_CHAINS];
+
+//Fills one half of the transfer buffer of a chain with the next encoded bytes.
+static void fill_half(struct transfer *t, uint8_t half) {
+  uint32_t *dst = &t->words[half * HALF_WORDS];
+  uint32_t bits;
+  uint16_t i;
+
+  for (i = 0; i < HALF_BYTES; i++) {
+    bits = led_strip_encode(t->strip);
+    *dst++ = SPI_PUSHR_CTAS_CTAR0 | (bits >> 16);
+    *dst++ = SPI_PUSHR_CTAS_CTAR0 | (bits & 0xFFFF);
+  }
+
+  t->last_half[half] = led_strip_latched(t->strip);
+}
+
+//Sets up the SPI module and DMA channel of the chain of a strip.
+void led_strip_arch_init(struct led_strip *strip) {
+  const struct chain *c = &chains[strip->chain];
+  struct transfer *t = &transfers[strip->chain];
+
+  t->strip = strip;
+
+  //Enable the module clocks and route MOSI. The pulldown keeps the line low while idle.
+  if (c->spi == SPI0)
+    SIM->SCGC6 |= SIM_SCGC6_SPI0_Enabled;
+  else if (c->spi == SPI1)
+    SIM->SCGC6 |= SIM_SCGC6_SPI1_Enabled;
+  else
+    SIM->SCGC3 |= SIM_SCGC3_SPI2_Enabled;
+  SIM->SCGC6 |= SIM_SCGC6_DMAMUX_Enabled;
+  SIM->SCGC7 |= SIM_SCGC7_DMA_Enabled;
+  c->port->PCR[c->pin] = c->mux | PORT_PCR_DSE_High | PORT_PCR_PE_Enabled | PORT_PCR_PS_Pulldown;
+
+  //Master mode with the receive FIFO disabled (received data is ignored), 16 bit frames and
+  //minimum delays.
+  c->spi->MCR = SPI_MCR_MSTR_Master | SPI_MCR_DIS_RXF_Enabled | SPI_MCR_CLR_TXF_Set |
+                SPI_MCR_HALT_Enabled;
+  c->spi->CTAR0 = SPI_CTAR_BAUD | (15 << SPI_CTAR_FMSZ_Pos) | SPI_CTAR_CPOL_Low |
+                  SPI_CTAR_CPHA_Leading | SPI_CTAR_LSBFE_MSB;
+  c->spi->RSER = SPI_RSER_TFFF_RE_Enabled | SPI_RSER_TFFF_DIRS_DMA;
+  c->spi->MCR = SPI_MCR_MSTR_Master | SPI_MCR_DIS_RXF_Enabled | SPI_MCR_HALT_Disabled;
+
+  //Feed the FIFO one PUSHR word per request, circularly over the transfer buffer.
+  DMA->CERQ = c->dma_channel;
+  DMAMUX->CHCFG[c->dma_channel] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[c->dma_channel].SADDR = (uint32_t) t->words;
+  DMA->TCD[c->dma_channel].SOFF = 4;
+  DMA->TCD[c->dma_channel].ATTR = DMA_ATTR_SSIZE_32Bit | DMA_ATTR_DSIZE_32Bit;
+  DMA->TCD[c->dma_channel].NBYTES = 4;
+  DMA->TCD[c->dma_channel].SLAST = -(int32_t) sizeof(t->words);
+  DMA->TCD[c->dma_channel].DADDR = (uint32_t) &c->spi->PUSHR;
+  DMA->TCD[c->dma_channel].DOFF = 0;
+  DMA->TCD[c->dma_channel].CITER = HALF_WORDS * 2;
+  DMA->TCD[c->dma_channel].DLASTSGA = 0;
+  DMA->TCD[c->dma_channel].CSR = DMA_CSR_INTHALF_Enabled | DMA_CSR_INTMAJOR_Enabled;
+  DMA->TCD[c->dma_channel].BITER = HALF_WORDS * 2;
+  DMAMUX->CHCFG[c->dma_channel] = DMAMUX_CHCFG_ENBL_Enabled | c->dma_source;
+
+  //Interrupt numbers of the DMA channels match the channel numbers.
+  NVIC_SetPriority((IRQn_Type) c->dma_channel, DMA_PRIORITY);
+  NVIC_EnableIRQ((IRQn_Type) c->dma_channel);
+}
+
+//Starts sending the frame of a strip.
+void led_strip_arch_start(struct led_strip *strip) {
+  const struct chain *c = &chains[strip->chain];
+  struct transfer *t = &transfers[strip->chain];
+
+  //Prepare both halves and start from the first one.
+  t->sending = 0;
+  fill_half(t, 0);
+  fill_half(t, 1);
+
+  DMA->TCD[c->dma_channel].SADDR = (uint32_t) t->words;
+  DMA->TCD[c->dma_channel].CITER = HALF_WORDS * 2;
+  DMA->SERQ = c->dma_channel;
+}
+
+//Common DMA interrupt handling.
+static void dma_handler(uint8_t index) {
+  const struct chain *c = &chains[index];
+  struct transfer *t = &transfers[index];
+  uint8_t half;
+
+  DMA->CINT = c->dma_channel;
+
+  //Interrupts alternate between the first half (half loop) and the second one (major loop).
+  half = t->sending;
+  t->sending ^= 1;
+
+  if (t->last_half[half]) {
+    //Enough of the latch time has been sent. What remains in flight is also zeros.
+    DMA->CERQ = c->dma_channel;
+    led_strip_done(t->strip);
+  } else {
+    fill_half(t, half);
+  }
+}
+
+void dma_channel_0_16_handler() {
+  dma_handler(0);
+}
+
+void dma_channel_8_24_handler() {
+  dma_handler(1);
+}
+
+void dma_channel_9_25_handler() {
+  dma_handler(2);
+}
@@ -0,0 +1,29 @@
+//+------------------------------------------------------------------------------------------------+
+//| Addressable LED strip (WS2812/SK6812) output for Kinetis MK66 MCU.                             |
+//|                                                                                                |
+//| Every SPI module drives a chain, fed by its own eDMA channel:                                  |
+//| - Chain 0: SPI0, data output on PTC6 (Teensy 3.6 pin 11), eDMA channel 0.                      |
+//| - Chain 1: SPI1, data output on PTD6 (Teensy 3.6 pin 21), eDMA channel 8.                      |
+//| - Chain 2: SPI2, data output on PTB22 (Teensy 3.6 pin 44), eDMA channel 9.                     |
+//|                                                                                                |
+//| Each chain refreshes up to about 560 RGB pixels at 60 fps, so all three together reach about   |
+//| 1700. The pins of chains 0 and 1 are taken by the external memory bus when it's enabled.       |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef LED_STRIP_ARCH_H_
+#define LED_STRIP_ARCH_H_
+
+//Number of output chains.
+#define LED_STRIP_CHAINS 3
+
+//SPI clock: 60MHz bus / 3 / 6 = 3.33MHz, for a 1.2us data bit.
+#define LED_STRIP_ARCH_BIT_RATE 3333333
+
+struct led_strip;
+
+void led_strip_arch_init(struct led_strip *strip);
+void led_strip_arch_start(struct led_strip *strip);
+
+#endif //LED_STRIP_ARCH_H_
@@ -0,0 +1,248 @@
+//+------------------------------------------------------------------------------------------------+
+//| Low power modes driver for Kinetis MK66 MCU.                                                   |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "lowpower.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-smc.h"
+#include "mk66-mcg.h"
+#include "mk66-llwu.h"
+#include "mk66-lptmr.h"
+#include "mk66-startup.h"
+
+//Event broadcast after resuming from lowpower_suspend().
+process_event_t lowpower_resume_event;
+
+//Pending suspend request, and the time asked for.
+static uint8_t suspend_requested;
+static uint32_t suspend_ms;
+
+//Symbols exported by the linker script.
+extern uint32_t __relocate_sram_start__;
+extern uint32_t __stack_end__;
+extern uint32_t __retained_start__;
+extern uint32_t __retained_end__;
+extern uint32_t __ram2_start__;
+extern uint32_t __ram2_end__;
+
+//Stop mode and stop control settings of each mode.
+static const uint8_t stop_modes[] = {
+  SMC_PMCTRL_STOPM_LLSx,    //LLS3
+  SMC_PMCTRL_STOPM_LLSx,    //LLS2
+  SMC_PMCTRL_STOPM_VLLSx,   //VLLS3
+  SMC_PMCTRL_STOPM_VLLSx,   //VLLS2
+  SMC_PMCTRL_STOPM_VLLSx,   //VLLS1
+};
+static const uint8_t stop_controls[] = {
+  SMC_STOPCTRL_LLSM_VLLS3_LLS3,
+  SMC_STOPCTRL_LLSM_VLLS2_LLS2,
+  SMC_STOPCTRL_LLSM_VLLS3_LLS3,
+  SMC_STOPCTRL_LLSM_VLLS2_LLS2 | SMC_STOPCTRL_RAM2PO_Powered,
+  SMC_STOPCTRL_LLSM_VLLS1,
+};
+
+//Clock function used to account for the time slept.
+extern void clock_adjust_ticks(clock_time_t ticks);
+
+//--------------------------------------------------------------------------------------------------
+
+//Starts the LPTMR as a wakeup source, expiring after the given milliseconds. The counter is 16 bits
+//wide, so longer times are prescaled (rounding down to the prescaler period).
+static void start_timer(uint32_t ms) {
+  uint8_t prescale = 0;
+
+  SIM->SCGC5 |= SIM_SCGC5_LPTMR_Enabled;
+  LPTMR0->CSR = 0;
+
+  if (ms <= 0x10000)
+    LPTMR0->PSR = LPTMR_PSR_PCS_LPO | LPTMR_PSR_PBYP_Bypassed;
+  else {
+    while ((ms >> (prescale + 1)) > 0x10000)
+      prescale++;
+    LPTMR0->PSR = LPTMR_PSR_PCS_LPO | LPTMR_PSR_PBYP_Enabled | (prescale << LPTMR_PSR_PRESCALE_Pos);
+    ms >>= prescale + 1;
+  }
+
+  //The interrupt request wakes the MCU up through the LLWU, but stays disabled in the NVIC.
+  LPTMR0->CMR = ms - 1;
+  LPTMR0->CSR = LPTMR_CSR_TEN_Enabled | LPTMR_CSR_TMS_Time | LPTMR_CSR_TFC_Reset |
+                LPTMR_CSR_TIE_Enabled;
+  LLWU->ME |= LLWU_ME_WUME0_LPTMR0;
+}
+
+//Stops the LPTMR wakeup source, if it was started (possibly before a VLLS wakeup, which leaves it
+//running but resets its clock gate). Returns the milliseconds it counted, or 0 if it wasn't
+//started.
+static uint32_t stop_timer() {
+  uint32_t count;
+
+  if (!(LLWU->ME & LLWU_ME_WUME0_LPTMR0))
+    return 0;
+
+  //The counter is read after writing it. Once expired, it starts over from 0.
+  SIM->SCGC5 |= SIM_SCGC5_LPTMR_Enabled;
+  if (LPTMR0->CSR & LPTMR_CSR_TCF_Msk)
+    count = LPTMR0->CMR + 1;
+  else {
+    LPTMR0->CNR = 0;
+    count = LPTMR0->CNR;
+  }
+  if (!(LPTMR0->PSR & LPTMR_PSR_PBYP_Bypassed))
+    count <<= ((LPTMR0->PSR & LPTMR_PSR_PRESCALE_Msk) >> LPTMR_PSR_PRESCALE_Pos) + 1;
+
+  LLWU->ME &= ~LLWU_ME_WUME0_LPTMR0;
+  LPTMR0->CSR = LPTMR_CSR_TCF_Set;
+  NVIC_ClearPendingIRQ(LPTMR_0_IRQn);
+
+  return count;
+}
+
+//Moves the system clock forward by the given milliseconds.
+static void advance_clock(uint32_t ms) {
+  clock_adjust_ticks((uint64_t) ms * CLOCK_SECOND / 1000);
+}
+
+//Leaves HSRUN mode for RUN mode, which allows stop modes. The core clock must be within the RUN
+//mode limit first, so the system switches to the crystal oscillator (PBE mode, keeping the PLL
+//locked).
+static void leave_hsrun() {
+  MCG->C1 = MCG_C1_CLKS_External | MCG_C1_FRDIV_Div_16_512 | MCG_C1_IREFS_External;
+  while ((MCG->S & MCG_S_CLKST_Msk) != MCG_S_CLKST_External);
+
+  SMC->PMCTRL = SMC_PMCTRL_RUNM_RUN;
+  while (SMC->PMSTAT != SMC_PMSTAT_RUN);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Returns whether all the memory of the application (data, heap and stack) lies in the RAM2
+//partition.
+static uint8_t fits_ram2() {
+  return &__relocate_sram_start__ >= &__ram2_start__ && &__stack_end__ <= &__ram2_end__;
+}
+
+//Returns the low power mode with the least leakage that keeps the given state (LOWPOWER_KEEP_*).
+uint8_t lowpower_select(uint8_t keep) {
+  switch (keep) {
+    case LOWPOWER_KEEP_RUNNING:
+      return fits_ram2() ? LOWPOWER_LLS2 : LOWPOWER_LLS3;
+
+    case LOWPOWER_KEEP_RAM:
+      return fits_ram2() ? LOWPOWER_VLLS2 : LOWPOWER_VLLS3;
+
+    case LOWPOWER_KEEP_RETAINED:
+      if (&__retained_end__ > &__retained_start__)
+        return LOWPOWER_VLLS2;
+      return LOWPOWER_VLLS1;
+
+    default:
+      return LOWPOWER_VLLS1;
+  }
+}
+
+//Enters a low power mode, with interrupts disabled by the caller. Interrupts still end WFI (or
+//abort the mode entry, if already pending), but only run once the clocks are back and the caller
+//enables them again.
+static int stop(uint8_t mode, uint32_t ms) {
+  uint8_t hsrun;
+  int result = LOWPOWER_OK;
+
+  stop_timer();
+  if (ms > 0)
+    start_timer(ms);
+
+  hsrun = (SMC->PMSTAT == SMC_PMSTAT_HSRUN);
+  if (hsrun)
+    leave_hsrun();
+
+  //Select the mode, reading it back so the write completes before stopping.
+  SMC->STOPCTRL = stop_controls[mode];
+  SMC->PMCTRL = SMC_PMCTRL_RUNM_RUN | stop_modes[mode];
+  (void) SMC->PMCTRL;
+
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  __DSB();
+  __WFI();
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+  if ((SMC->PMCTRL & SMC_PMCTRL_STOPA_Aborted) == SMC_PMCTRL_STOPA_Aborted)
+    result = LOWPOWER_ERR_ABORTED;
+
+  //The MCG comes out of LLS in PBE mode, so the PLL is engaged in any case.
+  if (hsrun)
+    startup_engage_pll();
+
+  advance_clock(stop_timer());
+
+  return result;
+}
+
+//Sleeps in the given low power mode (LOWPOWER_LLS3 and so on) until a wakeup source fires, or for
+//the given milliseconds if not 0. LLS modes return once woken up, with the clocks restored. VLLS
+//modes wake up through reset, so they only return if the mode couldn't be entered, because of a
+//pending interrupt. Returns LOWPOWER_OK, or LOWPOWER_ERR_ABORTED in that case.
+int lowpower_sleep(uint8_t mode, uint32_t ms) {
+  int result;
+
+  __disable_irq();
+  result = stop(mode, ms);
+  __enable_irq();
+
+  return result;
+}
+
+//Asks to suspend the system once idle, for the given milliseconds if not 0 (otherwise until an
+//armed wakeup source fires). The calling process then waits for lowpower_resume_event. Processes
+//and timers are kept as they are, while the peripherals are reset.
+void lowpower_suspend(uint32_t ms) {
+  if (lowpower_resume_event == 0)
+    lowpower_resume_event = process_alloc_event();
+
+  suspend_requested = 1;
+  suspend_ms = ms;
+}
+
+//Sleeps until there's something to do. Called by the platform when no process has anything to do.
+//Enters the requested suspend, if any: the VLLS mode that keeps all the memory of the application,
+//asking startup code to resume it on wakeup, which only returns if the mode couldn't be entered (to
+//be tried again next time). Otherwise, the core sleeps until the next interrupt.
+//
+//Interrupts are disabled from the check for pending events and polls until the sleep, so one that
+//posts or polls in between isn't missed: it stays pending, and ends the sleep (or aborts the mode
+//entry) right away.
+void lowpower_idle() {
+  __disable_irq();
+  if (process_nevents() > 0) {
+    __enable_irq();
+    return;
+  }
+
+  if (suspend_requested) {
+    startup_resume_on_wakeup(1);
+    stop(lowpower_select(LOWPOWER_KEEP_RAM), suspend_ms);
+    startup_resume_on_wakeup(0);
+  }
+  else {
+    __DSB();
+    __WFI();
+  }
+
+  __enable_irq();
+}
+
+//Completes a suspend after the system was resumed (see startup_resumed()). Called by the platform
+//once the clock and the standard output are up again. Moves the clock forward by the time slept
+//(as counted by the wakeup timer) and broadcasts lowpower_resume_event, so processes restart the
+//peripherals they use.
+void lowpower_resume() {
+  advance_clock(stop_timer());
+
+  suspend_requested = 0;
+  process_post(PROCESS_BROADCAST, lowpower_resume_event, NULL);
+}
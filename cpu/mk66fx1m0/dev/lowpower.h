@@ -0,0 +1,79 @@
+//+------------------------------------------------------------------------------------------------+
+//| Low power modes driver for Kinetis MK66 MCU.                                                   |
+//|                                                                                                |
+//| Puts the MCU to sleep in the low leakage stop mode with the least leakage that still keeps the |
+//| state asked for. lowpower_select() picks the mode:                                             |
+//| - LOWPOWER_KEEP_RUNNING: execution resumes after lowpower_sleep(), so all RAM in use must stay |
+//|   powered. LLS3 keeps all RAM. LLS2 keeps the RAM2 partition only (the first 32K of the upper  |
+//|   SRAM block), so it's picked when the data, heap and stack all lie in it (by moving the SRAM  |
+//|   region of the linker script there, for small applications).                                  |
+//| - LOWPOWER_KEEP_RAM: VLLS3, which keeps all RAM and wakes up through reset (or VLLS2 with the  |
+//|   RAM2 partition powered, when the application fits in it as above).                           |
+//| - LOWPOWER_KEEP_RETAINED: VLLS2 with the RAM2 partition powered, which keeps the .retained     |
+//|   section, or VLLS1 if it's empty. Wakes up through reset.                                     |
+//| - LOWPOWER_KEEP_NOTHING: VLLS1, which keeps no RAM and wakes up through reset.                 |
+//|                                                                                                |
+//| Variables are placed in the retained section with the LOWPOWER_RETAINED attribute. They start  |
+//| at zero on a cold boot and keep their values across wakeups from the modes that keep them      |
+//| (startup_retained() tells whether they did). The rest of the RAM is initialized as usual after |
+//| a VLLS wakeup, which runs startup code and main() again.                                       |
+//|                                                                                                |
+//| Applications that wake up often (to take a sample every few seconds, for instance) can skip    |
+//| most of that work with lowpower_suspend(), which keeps all their memory and resumes them: a    |
+//| process asks for it and waits for lowpower_resume_event. Once no process has anything to do,   |
+//| the platform calls lowpower_idle(), which sleeps in VLLS3 (or VLLS2) with a resume request for |
+//| startup code. The wakeup skips memory and libc initialization, and the platform only restarts  |
+//| the clock and the standard output before calling lowpower_resume(), leaving processes and      |
+//| timers as they were. Other peripherals are reset by the wakeup, so processes restart the ones  |
+//| they use when they get the event (broadcast to all of them). With no suspend asked for,        |
+//| lowpower_idle() just stops the core until the next interrupt (the clock tick, at the latest).  |
+//|                                                                                                |
+//| The system runs in HSRUN mode, from which stop modes can't be entered, so lowpower_sleep()     |
+//| switches to the crystal oscillator and RUN mode first, and engages the PLL and HSRUN mode      |
+//| again after an LLS wakeup. The system clock doesn't count while sleeping, but it's moved       |
+//| forward by the time counted by the wakeup timer, if any.                                       |
+//|                                                                                                |
+//| Wakeup sources are armed by their drivers (see cmp_wake_arm() and tsi_wake_arm()), and         |
+//| lowpower_sleep() adds a wakeup timer on the LPTMR, clocked by the 1KHz LPO, when given a time. |
+//| The TSI driver scans with the LPTMR, so the timer can't be used along with it.                 |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef LOWPOWER_H_
+#define LOWPOWER_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//State that must survive sleeping, for lowpower_select().
+#define LOWPOWER_KEEP_NOTHING   0
+#define LOWPOWER_KEEP_RETAINED  1
+#define LOWPOWER_KEEP_RAM       2
+#define LOWPOWER_KEEP_RUNNING   3
+
+//Low power modes, from the most to the least leakage.
+#define LOWPOWER_LLS3   0
+#define LOWPOWER_LLS2   1
+#define LOWPOWER_VLLS3  2
+#define LOWPOWER_VLLS2  3
+#define LOWPOWER_VLLS1  4
+
+//Return codes.
+#define LOWPOWER_OK           0
+#define LOWPOWER_ERR_ABORTED  -1    //An interrupt was pending when entering the mode
+
+//Event broadcast after resuming from lowpower_suspend().
+extern process_event_t lowpower_resume_event;
+
+//Places a variable in the retained section.
+#define LOWPOWER_RETAINED __attribute__((section(".retained")))
+
+uint8_t lowpower_select(uint8_t keep);
+int lowpower_sleep(uint8_t mode, uint32_t ms);
+void lowpower_suspend(uint32_t ms);
+void lowpower_idle();
+void lowpower_resume();
+
+#endif //LOWPOWER_H_
@@ -0,0 +1,168 @@
+//+------------------------------------------------------------------------------------------------+
+//| Low voltage warning driver for Kinetis MK66 MCU.                                               |
+//|                                                                                                |
+//| The warning flag stays set while the supply is below the warning level, so the interrupt is    |
+//| disabled once taken, and the driver process acknowledges the flag periodically until it stays  |
+//| clear. The time taken by the hooks is measured with the rtimer.                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "lowvoltage.h"
+
+#include "mk66.h"
+#include "mk66-pmc.h"
+
+//Interrupt priority (the lowest).
+#define LOWVOLTAGE_PRIORITY 15
+
+//Period of the supply checks after a warning.
+#define CHECK_PERIOD (CLOCK_SECOND / 4)
+
+//Registered hooks, in calling order.
+static struct lowvoltage_hook *hooks;
+
+//Whether the supply is below the warning level, and the time taken by the hooks at the last
+//warning, in microseconds, along with the amount of hooks skipped.
+static volatile uint8_t low;
+static uint32_t flush_time;
+static uint8_t skipped;
+
+process_event_t lowvoltage_event;
+
+PROCESS(lowvoltage_process, "Low voltage");
+
+//--------------------------------------------------------------------------------------------------
+
+//Returns the time since the given rtimer value, in microseconds.
+static uint32_t elapsed(rtimer_clock_t start) {
+  return (uint32_t) (RTIMER_NOW() - start) / (RTIMER_ARCH_SECOND / 1000000);
+}
+
+//Enables the low voltage detect reset at the high level and the warning at the configured one.
+void lowvoltage_init() {
+  if (lowvoltage_event == 0) {
+    lowvoltage_event = process_alloc_event();
+    process_start(&lowvoltage_process, NULL);
+  }
+
+  NVIC_DisableIRQ(LowVoltage_IRQn);
+
+  PMC->LVDSC1 = PMC_LVDSC1_LVDV_High | PMC_LVDSC1_LVDRE_Enabled | PMC_LVDSC1_LVDIE_Disabled |
+                PMC_LVDSC1_LVDACK;
+  PMC->LVDSC2 = PMC_LVDSC2_LVWIE_Enabled | PMC_LVDSC2_LVWACK |
+                ((LOWVOLTAGE_WARNING << PMC_LVDSC2_LVWV_Pos) & PMC_LVDSC2_LVWV_Msk);
+
+  NVIC_SetPriority(LowVoltage_IRQn, LOWVOLTAGE_PRIORITY);
+  NVIC_EnableIRQ(LowVoltage_IRQn);
+}
+
+//Adds a hook, to be called after those registered before. Returns LOWVOLTAGE_ERR_BUDGET if its
+//budget doesn't fit along with theirs.
+int lowvoltage_register(struct lowvoltage_hook *hook) {
+  struct lowvoltage_hook **h;
+  uint32_t total = hook->budget;
+
+  for (h = &hooks; *h != NULL; h = &(*h)->next)
+    total += (*h)->budget;
+  if (total > LOWVOLTAGE_BUDGET)
+    return LOWVOLTAGE_ERR_BUDGET;
+
+  //The list is walked from the interrupt.
+  NVIC_DisableIRQ(LowVoltage_IRQn);
+  hook->next = NULL;
+  *h = hook;
+  NVIC_EnableIRQ(LowVoltage_IRQn);
+
+  return LOWVOLTAGE_OK;
+}
+
+//Removes a hook.
+void lowvoltage_unregister(struct lowvoltage_hook *hook) {
+  struct lowvoltage_hook **h;
+
+  NVIC_DisableIRQ(LowVoltage_IRQn);
+  for (h = &hooks; *h != NULL; h = &(*h)->next) {
+    if (*h == hook) {
+      *h = hook->next;
+      break;
+    }
+  }
+  NVIC_EnableIRQ(LowVoltage_IRQn);
+}
+
+//Returns 1 if the supply was below the warning level at the last check, 0 otherwise.
+int lowvoltage_low() {
+  return low;
+}
+
+//Returns the time taken by the hooks at the last warning, in microseconds (to check the budgets
+//given to them).
+uint32_t lowvoltage_flush_time() {
+  return flush_time;
+}
+
+//Returns the amount of hooks skipped at the last warning, because the ones before them took longer
+//than their budgets.
+uint8_t lowvoltage_skipped() {
+  return skipped;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Low voltage warning interrupt handler. Runs the hooks until one overruns its budget.
+void low_voltage_handler() {
+  rtimer_clock_t start = RTIMER_NOW();
+  struct lowvoltage_hook *h;
+  uint32_t spent = 0, now;
+  uint8_t overrun = 0;
+
+  PMC->LVDSC2 &= ~PMC_LVDSC2_LVWIE_Enabled;
+  low = 1;
+  skipped = 0;
+
+  for (h = hooks; h != NULL; h = h->next) {
+    h->time = 0;
+    if (overrun || spent + h->budget > LOWVOLTAGE_BUDGET) {
+      skipped++;
+      continue;
+    }
+
+    h->flush(h->ptr);
+    now = elapsed(start);
+    h->time = now - spent;
+    spent = now;
+    if (h->time > h->budget)
+      overrun = 1;
+  }
+
+  flush_time = spent;
+  process_poll(&lowvoltage_process);
+}
+
+//Driver process. Reports the warning and waits for the supply to recover.
+PROCESS_THREAD(lowvoltage_process, ev, data) {
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    process_post(PROCESS_BROADCAST, lowvoltage_event, NULL);
+
+    //The flag only clears when acknowledged with the supply over the warning level.
+    do {
+      etimer_set(&et, CHECK_PERIOD);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+      PMC->LVDSC2 |= PMC_LVDSC2_LVWACK;
+    } while (PMC->LVDSC2 & PMC_LVDSC2_LVWF);
+
+    low = 0;
+    PMC->LVDSC2 |= PMC_LVDSC2_LVWIE_Enabled;
+    process_post(PROCESS_BROADCAST, lowvoltage_event, NULL);
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,80 @@
+//+------------------------------------------------------------------------------------------------+
+//| Low voltage warning driver for Kinetis MK66 MCU.                                               |
+//|                                                                                                |
+//| Gives an early warning of a failing supply, so data held in RAM (write-back caches, log        |
+//| buffers) gets to storage before a brown-out. The PMC resets the MCU when the supply drops      |
+//| below the high low voltage detect level (2.56V typical), and warns with an interrupt at a      |
+//| level above it: LOWVOLTAGE_WARN_1 to LOWVOLTAGE_WARN_4 (2.70V, 2.80V, 2.90V and 3.00V).        |
+//|                                                                                                |
+//| Flush hooks are registered with the time they take at worst, and lowvoltage_register() only    |
+//| accepts them while the total fits in LOWVOLTAGE_CONF_BUDGET microseconds: the time the supply  |
+//| takes to fall from the warning to the reset level, with the board's capacitance and load       |
+//| (C * dV / I: 470uF going from 3.0V to 2.56V at 100mA last about 2ms). On a warning, the hooks  |
+//| run from the interrupt in registration order. The interrupt has the lowest priority, so it     |
+//| preempts processes but not other drivers, and hooks can wait for transfers ended by their      |
+//| interrupts (sdcard_write(), for instance). Hooks may interrupt the code that fills the data    |
+//| they flush, so that code must leave it consistent at every step.                               |
+//|                                                                                                |
+//| A running hook can't be stopped, so the budgets are only as good as the figures given. The     |
+//| time every hook takes is measured and kept in the hook; once one takes longer than its budget, |
+//| the time left can't be trusted and the hooks after it are skipped. lowvoltage_skipped() tells  |
+//| how many were skipped at the last warning.                                                     |
+//|                                                                                                |
+//| After the hooks, processes get a lowvoltage_event (broadcast), and the driver checks the       |
+//| supply every quarter of a second until it's back over the warning level, when they get another |
+//| one and the warning is armed again. lowvoltage_low() tells both events apart.                  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef LOWVOLTAGE_H_
+#define LOWVOLTAGE_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Warning levels.
+#define LOWVOLTAGE_WARN_1   0
+#define LOWVOLTAGE_WARN_2   1
+#define LOWVOLTAGE_WARN_3   2
+#define LOWVOLTAGE_WARN_4   3
+
+//Warning level used.
+#ifdef LOWVOLTAGE_CONF_WARNING
+#define LOWVOLTAGE_WARNING LOWVOLTAGE_CONF_WARNING
+#else
+#define LOWVOLTAGE_WARNING LOWVOLTAGE_WARN_4
+#endif
+
+//Time available to the flush hooks after a warning, in microseconds.
+#ifdef LOWVOLTAGE_CONF_BUDGET
+#define LOWVOLTAGE_BUDGET LOWVOLTAGE_CONF_BUDGET
+#else
+#define LOWVOLTAGE_BUDGET 1000
+#endif
+
+//Return codes.
+#define LOWVOLTAGE_OK           0
+#define LOWVOLTAGE_ERR_BUDGET   -1  //The hook doesn't fit in the time left
+
+//Flush hook, kept by the caller while registered.
+struct lowvoltage_hook {
+  struct lowvoltage_hook *next;
+  void (* flush)(void *ptr);      //Called from interrupt context
+  void *ptr;
+  uint32_t budget;                //Worst case time of the flush, in microseconds
+  uint32_t time;                  //Time taken at the last warning, in microseconds (0 if skipped)
+};
+
+//Event broadcast after a warning, and once the supply recovers.
+extern process_event_t lowvoltage_event;
+
+void lowvoltage_init();
+int lowvoltage_register(struct lowvoltage_hook *hook);
+void lowvoltage_unregister(struct lowvoltage_hook *hook);
+int lowvoltage_low();
+uint32_t lowvoltage_flush_time();
+uint8_t lowvoltage_skipped();
+
+#endif //LOWVOLTAGE_H_
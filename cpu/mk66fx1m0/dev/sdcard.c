@@ -0,0 +1,488 @@
+//+------------------------------------------------------------------------------------------------+
+//| SD card driver for Kinetis MK66 MCU.                                                           |
+//|                                                                                                |
+//| Initialization follows the SD physical layer identification sequence, busy waiting on each     |
+//| command (the SDHC interrupt stays masked meanwhile). Transfers issue a single read/write       |
+//| command with its data moved by ADMA2, after a descriptor table built over the caller's buffer. |
+//| Multiple block transfers let the SDHC send the stop command on its own (auto CMD12), so the    |
+//| only interrupt is the one at the end (transfer complete, or an error).                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "contiki.h"
+#include "sdcard.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-mpu.h"
+#include "mk66-sdhc.h"
+
+//Interrupt priority. Matches the one of the USB mass storage driver, so neither interrupts the
+//other.
+#define SDCARD_PRIORITY 7
+
+//Card commands.
+#define CMD_GO_IDLE_STATE         0
+#define CMD_ALL_SEND_CID          2
+#define CMD_SEND_RELATIVE_ADDR    3
+#define CMD_SELECT_CARD           7
+#define CMD_SEND_IF_COND          8
+#define CMD_SEND_CSD              9
+#define CMD_STOP_TRANSMISSION     12
+#define CMD_SET_BLOCKLEN          16
+#define CMD_READ_SINGLE_BLOCK     17
+#define CMD_READ_MULTIPLE_BLOCK   18
+#define CMD_WRITE_BLOCK           24
+#define CMD_WRITE_MULTIPLE_BLOCK  25
+#define CMD_APP_CMD               55
+#define ACMD_SET_BUS_WIDTH        6
+#define ACMD_SD_STATUS            13
+#define ACMD_SD_SEND_OP_COND      41
+
+#define CMD(index) (((index) << SDHC_XFERTYP_CMDINX_Pos) & SDHC_XFERTYP_CMDINX_Msk)
+
+//Response types, as transfer type bits.
+#define RESP_NONE SDHC_XFERTYP_RSPTYP_None
+#define RESP_R1   (SDHC_XFERTYP_RSPTYP_48 | SDHC_XFERTYP_CCCEN_Enabled | SDHC_XFERTYP_CICEN_Enabled)
+#define RESP_R1B  (SDHC_XFERTYP_RSPTYP_48_Busy | SDHC_XFERTYP_CCCEN_Enabled | \
+                   SDHC_XFERTYP_CICEN_Enabled)
+#define RESP_R2   (SDHC_XFERTYP_RSPTYP_136 | SDHC_XFERTYP_CCCEN_Enabled)
+#define RESP_R3   SDHC_XFERTYP_RSPTYP_48
+#define RESP_R6   RESP_R1
+#define RESP_R7   RESP_R1
+
+//Operation conditions register bits (ACMD41).
+#define OCR_VOLTAGE_3V3   0x00300000  //3.2V to 3.4V
+#define OCR_HCS           0x40000000  //Host supports high capacity cards
+#define OCR_CCS           0x40000000  //Card is high capacity
+#define OCR_POWERED_UP    0x80000000  //Card finished its power up
+
+//Interface condition (CMD8) argument: 2.7V to 3.6V, and a check pattern the card echoes.
+#define IF_COND 0x000001AA
+
+//SD clock settings, dividing the 180MHz system clock by the prescaler and the divisor.
+#define CLOCK_IDENTIFICATION  ((0x40 << SDHC_SYSCTL_SDCLKFS_Pos) | \
+                               (3 << SDHC_SYSCTL_DVS_Pos))     //180MHz / 128 / 4 = 352KHz
+#define CLOCK_TRANSFER        ((0x01 << SDHC_SYSCTL_SDCLKFS_Pos) | \
+                               (3 << SDHC_SYSCTL_DVS_Pos))     //180MHz / 2 / 4 = 22.5MHz
+
+//Data timeout, as 2^27 SD clock cycles (about 6 seconds at 22.5MHz, above any write time).
+#define DATA_TIMEOUT (14 << SDHC_SYSCTL_DTOCV_Pos)
+
+//Time for the card to finish its power up.
+#define INIT_TIMEOUT CLOCK_SECOND
+
+#define IRQ_COMMAND_ERRORS (SDHC_IRQSTAT_CTOE_Msk | SDHC_IRQSTAT_CCE_Msk | SDHC_IRQSTAT_CEBE_Msk | \
+                            SDHC_IRQSTAT_CIE_Msk)
+#define IRQ_ERRORS (IRQ_COMMAND_ERRORS | SDHC_IRQSTAT_DTOE_Msk | SDHC_IRQSTAT_DCE_Msk | \
+                    SDHC_IRQSTAT_DEBE_Msk | SDHC_IRQSTAT_AC12E_Msk | SDHC_IRQSTAT_DMAE_Msk)
+#define IRQ_ALL (SDHC_IRQSTAT_CC_Msk | SDHC_IRQSTAT_TC_Msk | SDHC_IRQSTAT_DINT_Msk | IRQ_ERRORS)
+
+//Pin configurations. The command and data lines are open drain on the card side of the bus.
+#define DATA_PIN_CONFIG (PORT_PCR_MUX_Alt4 | PORT_PCR_DSE_High | PORT_PCR_PE_Enabled | \
+                         PORT_PCR_PS_Pullup)
+#define CLOCK_PIN_CONFIG (PORT_PCR_MUX_Alt4 | PORT_PCR_DSE_High)
+
+//Blocks moved by each ADMA2 descriptor (their lengths are 16 bit).
+#define DESCRIPTOR_BLOCKS 64
+#define DESCRIPTOR_COUNT ((SDCARD_MAX_BLOCKS + DESCRIPTOR_BLOCKS - 1) / DESCRIPTOR_BLOCKS)
+
+//Status of the transfers started by the waiting functions, until their callback.
+#define PENDING 1
+
+//Card state.
+static uint8_t ready;
+static uint8_t high_capacity;   //Addressed by block instead of by byte
+static uint8_t protect;
+static uint32_t rca;            //Relative card address
+static uint32_t blocks;
+static uint32_t erase_blocks;   //Allocation unit size
+
+//Transfer state.
+static volatile uint8_t busy;
+static volatile uint8_t started;  //The claimed transfer was issued to the card
+static sdcard_callback_t callback;
+static void *callback_ptr;
+static sdcard_callback_t release_callback;  //Waiting for the card to be released
+static void *release_ptr;
+static struct SDHC_ADMA2_type adma_table[DESCRIPTOR_COUNT] __attribute__((aligned(4)));
+
+//--------------------------------------------------------------------------------------------------
+
+//Changes the SD clock frequency.
+static void set_clock(uint32_t divisors) {
+  SDHC->SYSCTL &= ~SDHC_SYSCTL_SDCLKEN_Enabled;
+  SDHC->SYSCTL = SDHC_SYSCTL_IPGEN_Enabled | SDHC_SYSCTL_HCKEN_Enabled | SDHC_SYSCTL_PEREN_Enabled |
+                 DATA_TIMEOUT | divisors;
+  while (!(SDHC->PRSSTAT & SDHC_PRSSTAT_SDSTB_Msk));
+  SDHC->SYSCTL |= SDHC_SYSCTL_SDCLKEN_Enabled;
+}
+
+//Sends a command and waits for its response (and for the end of the busy signal, if the response
+//has one). The SDHC times out on its own if the card doesn't answer.
+static int command(uint32_t xfertyp, uint32_t arg) {
+  uint32_t irqstat;
+
+  while (SDHC->PRSSTAT & (SDHC_PRSSTAT_CIHB_Msk | SDHC_PRSSTAT_CDIHB_Msk));
+
+  SDHC->IRQSTAT = IRQ_ALL;
+  SDHC->CMDARG = arg;
+  SDHC->XFERTYP = xfertyp;
+
+  do {
+    irqstat = SDHC->IRQSTAT;
+  } while (!(irqstat & (SDHC_IRQSTAT_CC_Msk | IRQ_COMMAND_ERRORS)));
+
+  if ((xfertyp & SDHC_XFERTYP_RSPTYP_48_Busy) == SDHC_XFERTYP_RSPTYP_48_Busy &&
+      !(irqstat & IRQ_COMMAND_ERRORS)) {
+    do {
+      irqstat = SDHC->IRQSTAT;
+    } while (!(irqstat & (SDHC_IRQSTAT_TC_Msk | IRQ_ERRORS)));
+  }
+
+  SDHC->IRQSTAT = irqstat;
+  if (irqstat & IRQ_ERRORS) {
+    SDHC->SYSCTL |= SDHC_SYSCTL_RSTC_Msk | SDHC_SYSCTL_RSTD_Msk;
+    while (SDHC->SYSCTL & (SDHC_SYSCTL_RSTC_Msk | SDHC_SYSCTL_RSTD_Msk));
+    return SDCARD_ERR_IO;
+  }
+
+  return SDCARD_OK;
+}
+
+//Sends an application specific command.
+static int app_command(uint32_t xfertyp, uint32_t arg) {
+  if (command(CMD(CMD_APP_CMD) | RESP_R1, rca << 16) != SDCARD_OK)
+    return SDCARD_ERR_IO;
+  return command(xfertyp, arg);
+}
+
+//Computes the size of the card in blocks, from the CSD register just read. The SDHC drops the CRC
+//of long responses, so bit n of the register is at bit n - 8 of the response.
+static uint32_t csd_blocks() {
+  uint32_t c_size, c_size_mult, read_bl_len;
+
+  //Version 2 (high capacity): C_SIZE at bits 69:48, in units of 512KB.
+  if (((SDHC->CMDRSP[3] >> 22) & 0x3) == 1) {
+    c_size = (SDHC->CMDRSP[1] >> 8) & 0x3FFFFF;
+    return (c_size + 1) << 10;
+  }
+
+  //Version 1: C_SIZE at bits 73:62, C_SIZE_MULT at bits 49:47 and READ_BL_LEN at bits 83:80.
+  c_size = ((SDHC->CMDRSP[1] >> 22) & 0x3FF) | ((SDHC->CMDRSP[2] & 0x3) << 10);
+  c_size_mult = (SDHC->CMDRSP[1] >> 7) & 0x7;
+  read_bl_len = (SDHC->CMDRSP[2] >> 8) & 0xF;
+  return (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+}
+
+//Reads the SD status register (a 64 byte data transfer) and returns the allocation unit size it
+//reports, in blocks, or 0 if unknown. Runs with the card selected, before transfers are enabled.
+static uint32_t read_erase_blocks() {
+  //Sizes of allocation unit codes 0xA to 0xF (SDXC cards), in blocks.
+  static const uint32_t large_sizes[] = {16384, 24576, 32768, 49152, 65536, 131072};
+  static uint8_t status[64] __attribute__((aligned(4)));
+  uint32_t irqstat;
+  uint8_t code;
+
+  adma_table[0].ADDR = (uint32_t) status;
+  adma_table[0].ATTR = (sizeof(status) << SDHC_ADMA2_LENGTH_Pos) | SDHC_ADMA2_ACT_Transfer |
+                       SDHC_ADMA2_VALID_Msk | SDHC_ADMA2_END_Msk;
+  SDHC->ADSADDR = (uint32_t) adma_table;
+  SDHC->BLKATTR = (1 << SDHC_BLKATTR_BLKCNT_Pos) | sizeof(status);
+
+  if (app_command(CMD(ACMD_SD_STATUS) | RESP_R1 | SDHC_XFERTYP_DPSEL_Data |
+                  SDHC_XFERTYP_DMAEN_Enabled | SDHC_XFERTYP_DTDSEL_Read, 0) != SDCARD_OK)
+    return 0;
+
+  do {
+    irqstat = SDHC->IRQSTAT;
+  } while (!(irqstat & (SDHC_IRQSTAT_TC_Msk | IRQ_ERRORS)));
+
+  SDHC->IRQSTAT = irqstat;
+  if (irqstat & IRQ_ERRORS) {
+    SDHC->SYSCTL |= SDHC_SYSCTL_RSTC_Msk | SDHC_SYSCTL_RSTD_Msk;
+    while (SDHC->SYSCTL & (SDHC_SYSCTL_RSTC_Msk | SDHC_SYSCTL_RSTD_Msk));
+    return 0;
+  }
+
+  //The register comes most significant byte first. AU_SIZE is at bits 431:428: codes 1 to 9 are
+  //16KB to 4MB, in powers of 2.
+  code = status[10] >> 4;
+  if (code == 0)
+    return 0;
+  if (code <= 9)
+    return 32 << (code - 1);
+  return large_sizes[code - 0xA];
+}
+
+//Initializes the SDHC and the card in the slot, leaving it ready for transfers. Returns
+//SDCARD_ERR_NO_CARD if there's no card, or if it failed to initialize.
+int sdcard_init() {
+  clock_time_t start;
+  uint32_t ocr;
+  uint8_t version_2;
+
+  ready = 0;
+  rca = 0;
+
+  //Enable the SDHC clock (it runs from the system clock, the reset default) and let it access
+  //memory as a bus master.
+  SIM->SCGC3 |= SIM_SCGC3_SDHC_Enabled;
+  SYSMPU->RGDAAC[0] |= SYSMPU_RGDAAC_M5WE_Msk | SYSMPU_RGDAAC_M5RE_Msk;
+
+  NVIC_DisableIRQ(SDHC_IRQn);
+
+  //Configure the pins.
+  PORTE->PCR[0] = DATA_PIN_CONFIG;    //D1
+  PORTE->PCR[1] = DATA_PIN_CONFIG;    //D0
+  PORTE->PCR[2] = CLOCK_PIN_CONFIG;   //CLK
+  PORTE->PCR[3] = DATA_PIN_CONFIG;    //CMD
+  PORTE->PCR[4] = DATA_PIN_CONFIG;    //D3
+  PORTE->PCR[5] = DATA_PIN_CONFIG;    //D2
+
+  //Reset the SDHC, then set it up for little endian ADMA2 transfers on a 1 bit bus, at the
+  //identification frequency.
+  SDHC->SYSCTL = SDHC_SYSCTL_RSTA_Msk;
+  while (SDHC->SYSCTL & SDHC_SYSCTL_RSTA_Msk);
+  SDHC->PROCTL = SDHC_PROCTL_EMODE_Little | SDHC_PROCTL_DTW_1_Bit | SDHC_PROCTL_DMAS_ADMA2;
+  SDHC->WML = (16 << SDHC_WML_RDWML_Pos) | (16 << SDHC_WML_WRWML_Pos);
+  SDHC->IRQSTATEN = IRQ_ALL;
+  SDHC->IRQSIGEN = 0;
+  set_clock(CLOCK_IDENTIFICATION);
+
+  //Send the 80 clock cycles the card needs before the first command.
+  SDHC->SYSCTL |= SDHC_SYSCTL_INITA_Msk;
+  while (SDHC->SYSCTL & SDHC_SYSCTL_INITA_Msk);
+
+  //Reset the card. Only version 2 cards answer the interface condition, echoing the pattern.
+  command(CMD(CMD_GO_IDLE_STATE) | RESP_NONE, 0);
+  version_2 = command(CMD(CMD_SEND_IF_COND) | RESP_R7, IF_COND) == SDCARD_OK &&
+              (SDHC->CMDRSP[0] & 0xFFF) == IF_COND;
+
+  //Wait for the card to power up, offering high capacity support if it's a version 2 card.
+  start = clock_time();
+  do {
+    if (clock_time() - start > INIT_TIMEOUT)
+      return SDCARD_ERR_NO_CARD;
+    if (app_command(CMD(ACMD_SD_SEND_OP_COND) | RESP_R3,
+                    OCR_VOLTAGE_3V3 | (version_2 ? OCR_HCS : 0)) != SDCARD_OK)
+      return SDCARD_ERR_NO_CARD;
+    ocr = SDHC->CMDRSP[0];
+  } while (!(ocr & OCR_POWERED_UP));
+  high_capacity = (ocr & OCR_CCS) ? 1 : 0;
+
+  //Get the relative address of the card, its size, and select it.
+  if (command(CMD(CMD_ALL_SEND_CID) | RESP_R2, 0) != SDCARD_OK ||
+      command(CMD(CMD_SEND_RELATIVE_ADDR) | RESP_R6, 0) != SDCARD_OK)
+    return SDCARD_ERR_NO_CARD;
+  rca = SDHC->CMDRSP[0] >> 16;
+
+  if (command(CMD(CMD_SEND_CSD) | RESP_R2, rca << 16) != SDCARD_OK)
+    return SDCARD_ERR_NO_CARD;
+  blocks = csd_blocks();
+
+  if (command(CMD(CMD_SELECT_CARD) | RESP_R1B, rca << 16) != SDCARD_OK)
+    return SDCARD_ERR_NO_CARD;
+
+  //Switch to the 4 bit bus, set the block length (standard capacity cards only) and raise the
+  //clock to the transfer frequency.
+  if (app_command(CMD(ACMD_SET_BUS_WIDTH) | RESP_R1, 2) != SDCARD_OK)
+    return SDCARD_ERR_NO_CARD;
+  SDHC->PROCTL = SDHC_PROCTL_EMODE_Little | SDHC_PROCTL_DTW_4_Bit | SDHC_PROCTL_DMAS_ADMA2;
+
+  if (command(CMD(CMD_SET_BLOCKLEN) | RESP_R1, SDCARD_BLOCK_SIZE) != SDCARD_OK)
+    return SDCARD_ERR_NO_CARD;
+
+  set_clock(CLOCK_TRANSFER);
+  erase_blocks = read_erase_blocks();
+
+  busy = 0;
+  ready = 1;
+
+  NVIC_SetPriority(SDHC_IRQn, SDCARD_PRIORITY);
+  NVIC_EnableIRQ(SDHC_IRQn);
+
+  return SDCARD_OK;
+}
+
+//Returns the size of the card in blocks (0 if not initialized).
+uint32_t sdcard_blocks() {
+  return ready ? blocks : 0;
+}
+
+//Returns the allocation unit size of the card in blocks (0 if unknown or not initialized). Writes
+//of whole units, aligned to them, are the fastest the card can do.
+uint32_t sdcard_erase_blocks() {
+  return ready ? erase_blocks : 0;
+}
+
+//Starts a transfer of count blocks from the given one, in the direction set by the flags. Returns
+//SDCARD_OK if started, in which case the callback (if any) gets the result once it ends. Can be
+//called from interrupt context, including from a completion callback.
+int sdcard_start(uint32_t block, void *buffer, uint16_t count, uint8_t flags,
+                 sdcard_callback_t cb, void *ptr) {
+  uint32_t primask, xfertyp, address;
+  uint16_t remaining, length;
+  uint8_t i;
+
+  if (!ready)
+    return SDCARD_ERR_NO_CARD;
+  if (count == 0 || count > SDCARD_MAX_BLOCKS || block >= blocks || count > blocks - block)
+    return SDCARD_ERR_RANGE;
+  if ((flags & SDCARD_WRITE) && protect && !(flags & SDCARD_FORCE))
+    return SDCARD_ERR_PROTECTED;
+
+  //Claim the card. Callers in interrupt context may be racing with the application.
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if (busy) {
+    __set_PRIMASK(primask);
+    return SDCARD_ERR_BUSY;
+  }
+  busy = 1;
+  started = 0;
+  __set_PRIMASK(primask);
+
+  callback = cb;
+  callback_ptr = ptr;
+
+  //Describe the buffer to the ADMA2 engine.
+  address = (uint32_t) buffer;
+  for (i = 0, remaining = count; remaining > 0; i++) {
+    length = (remaining > DESCRIPTOR_BLOCKS) ? DESCRIPTOR_BLOCKS : remaining;
+    adma_table[i].ADDR = address;
+    adma_table[i].ATTR = ((length * SDCARD_BLOCK_SIZE) << SDHC_ADMA2_LENGTH_Pos) |
+                         SDHC_ADMA2_ACT_Transfer | SDHC_ADMA2_VALID_Msk;
+    address += length * SDCARD_BLOCK_SIZE;
+    remaining -= length;
+  }
+  adma_table[i - 1].ATTR |= SDHC_ADMA2_END_Msk;
+
+  xfertyp = SDHC_XFERTYP_DPSEL_Data | SDHC_XFERTYP_DMAEN_Enabled | RESP_R1;
+  if (count > 1)
+    xfertyp |= SDHC_XFERTYP_MSBSEL_Multi | SDHC_XFERTYP_BCEN_Enabled | SDHC_XFERTYP_AC12EN_Enabled;
+  if (flags & SDCARD_WRITE)
+    xfertyp |= SDHC_XFERTYP_DTDSEL_Write |
+               CMD((count > 1) ? CMD_WRITE_MULTIPLE_BLOCK : CMD_WRITE_BLOCK);
+  else
+    xfertyp |= SDHC_XFERTYP_DTDSEL_Read |
+               CMD((count > 1) ? CMD_READ_MULTIPLE_BLOCK : CMD_READ_SINGLE_BLOCK);
+
+  //The previous transfer ended with the card idle, so the lines are normally free already.
+  while (SDHC->PRSSTAT & (SDHC_PRSSTAT_CIHB_Msk | SDHC_PRSSTAT_CDIHB_Msk));
+
+  SDHC->ADSADDR = (uint32_t) adma_table;
+  SDHC->BLKATTR = ((uint32_t) count << SDHC_BLKATTR_BLKCNT_Pos) | SDCARD_BLOCK_SIZE;
+  SDHC->IRQSTAT = IRQ_ALL;
+  SDHC->IRQSIGEN = SDHC_IRQSTAT_TC_Msk | IRQ_ERRORS;
+  SDHC->CMDARG = high_capacity ? block : block * SDCARD_BLOCK_SIZE;
+  SDHC->XFERTYP = xfertyp;
+  started = 1;
+
+  return SDCARD_OK;
+}
+
+//Asks for a call (with SDCARD_OK, from interrupt context) once the running transfer ends and the
+//card is released. Returns SDCARD_ERR_BUSY if the call is due, or SDCARD_OK if the card is free
+//already, in which case no call comes. Only one caller waits at a time: a new request replaces the
+//previous one.
+int sdcard_notify(sdcard_callback_t cb, void *ptr) {
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if (!busy) {
+    __set_PRIMASK(primask);
+    return SDCARD_OK;
+  }
+  release_callback = cb;
+  release_ptr = ptr;
+  __set_PRIMASK(primask);
+
+  return SDCARD_ERR_BUSY;
+}
+
+//Completion callback of the waiting functions.
+static void wait_callback(int status, void *ptr) {
+  *(volatile int *) ptr = status;
+}
+
+//Runs a transfer, waiting for the card to be free and then for the transfer to end. From interrupt
+//context, it only waits for a transfer that was already issued: one still being set up by the
+//preempted code can't go on until the interrupt returns, so SDCARD_ERR_BUSY is returned instead.
+static int transfer(uint32_t block, void *buffer, uint16_t count, uint8_t flags) {
+  volatile int status = PENDING;
+  int result;
+
+  while ((result = sdcard_start(block, buffer, count, flags, wait_callback, (void *) &status)) ==
+         SDCARD_ERR_BUSY) {
+    if (__get_IPSR() != 0 && busy && !started)
+      return SDCARD_ERR_BUSY;
+  }
+  if (result != SDCARD_OK)
+    return result;
+
+  while (status == PENDING);
+  return status;
+}
+
+//Reads blocks, waiting until done.
+int sdcard_read(uint32_t block, void *buffer, uint16_t count) {
+  return transfer(block, buffer, count, SDCARD_READ);
+}
+
+//Writes blocks, waiting until done. Fails while the card is write protected.
+int sdcard_write(uint32_t block, const void *buffer, uint16_t count) {
+  return transfer(block, (void *) buffer, count, SDCARD_WRITE);
+}
+
+//Enables or disables the write protection for the application.
+void sdcard_protect(int enable) {
+  protect = enable ? 1 : 0;
+}
+
+//Returns nonzero while the card is write protected for the application.
+int sdcard_protected() {
+  return protect;
+}
+
+//Ends the running transfer and reports its result.
+void sdhc_handler() {
+  uint32_t irqstat = SDHC->IRQSTAT;
+  sdcard_callback_t cb;
+  void *ptr;
+  int status;
+
+  SDHC->IRQSTAT = irqstat;
+  if (!(irqstat & (SDHC_IRQSTAT_TC_Msk | IRQ_ERRORS)))
+    return;
+
+  SDHC->IRQSIGEN = 0;
+
+  status = SDCARD_OK;
+  if (irqstat & IRQ_ERRORS) {
+    //Reset the lines and make sure the card leaves the data transfer state.
+    SDHC->SYSCTL |= SDHC_SYSCTL_RSTC_Msk | SDHC_SYSCTL_RSTD_Msk;
+    while (SDHC->SYSCTL & (SDHC_SYSCTL_RSTC_Msk | SDHC_SYSCTL_RSTD_Msk));
+    command(CMD(CMD_STOP_TRANSMISSION) | RESP_R1B | SDHC_XFERTYP_CMDTYP_Abort, 0);
+    status = SDCARD_ERR_IO;
+  }
+
+  //Release the card before calling back, so the callback can start the next transfer.
+  cb = callback;
+  ptr = callback_ptr;
+  busy = 0;
+  if (cb != NULL)
+    cb(status, ptr);
+
+  //Then tell whoever was waiting for the card (who may find it taken again by the callback).
+  cb = release_callback;
+  ptr = release_ptr;
+  release_callback = NULL;
+  if (cb != NULL)
+    cb(SDCARD_OK, ptr);
+}
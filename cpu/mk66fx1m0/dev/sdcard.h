@@ -0,0 +1,68 @@
+//+------------------------------------------------------------------------------------------------+
+//| SD card driver for Kinetis MK66 MCU.                                                           |
+//|                                                                                                |
+//| Accesses the card in the on-board slot through the SDHC, on a 4 bit bus at 22.5MHz (about      |
+//| 11MB/s). Blocks are 512 bytes long and transfers of several blocks use the multiple block      |
+//| commands, moved by the ADMA2 engine of the SDHC with no CPU involvement. Buffers must be word  |
+//| aligned.                                                                                       |
+//|                                                                                                |
+//| sdcard_start() begins a transfer in the background and calls back from interrupt context when  |
+//| it ends, so the caller can start the next one right away (and keep several buffers in flight   |
+//| with other DMA driven peripherals). sdcard_read() and sdcard_write() wait for the transfer to  |
+//| end instead. Only one transfer runs at a time; while one is running, sdcard_start() fails with |
+//| SDCARD_ERR_BUSY, and the waiting functions retry until they get the card. From interrupt       |
+//| context they only wait for a transfer already running, and fail with SDCARD_ERR_BUSY if the    |
+//| interrupted code was still setting one up (it could never finish while they wait). Background  |
+//| users that found the card busy can ask sdcard_notify() for a call once it's released, instead  |
+//| of retrying.                                                                                   |
+//|                                                                                                |
+//| The allocation unit size of the card (its erase unit, from 16KB to 64MB) is read at            |
+//| initialization and reported by sdcard_erase_blocks(), so writers can align to it.              |
+//|                                                                                                |
+//| The card can be write protected for the application with sdcard_protect() (for instance, while |
+//| the USB host owns its contents). Writes then fail with SDCARD_ERR_PROTECTED, unless requested  |
+//| with SDCARD_FORCE by the owner.                                                                |
+//|                                                                                                |
+//| Pins (all on the SD slot): D0 PTE1, D1 PTE0, D2 PTE5, D3 PTE4, CMD PTE3, CLK PTE2.             |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef SDCARD_H_
+#define SDCARD_H_
+
+#include <stdint.h>
+
+#define SDCARD_BLOCK_SIZE 512
+
+//Maximum blocks per transfer.
+#define SDCARD_MAX_BLOCKS 128
+
+//Transfer flags.
+#define SDCARD_READ   0x00
+#define SDCARD_WRITE  0x01
+#define SDCARD_FORCE  0x02  //Write even when protected
+
+//Error codes.
+#define SDCARD_OK             0
+#define SDCARD_ERR_NO_CARD    -1  //No card, or the card didn't initialize
+#define SDCARD_ERR_BUSY       -2  //Another transfer is running
+#define SDCARD_ERR_PROTECTED  -3  //Write protected
+#define SDCARD_ERR_RANGE      -4  //Blocks out of the card, or too many blocks
+#define SDCARD_ERR_IO         -5  //Command or data error (timeout, CRC, DMA)
+
+//Completion callback type. Called from interrupt context with the result of the transfer.
+typedef void (* sdcard_callback_t)(int status, void *ptr);
+
+int sdcard_init();
+uint32_t sdcard_blocks();
+uint32_t sdcard_erase_blocks();
+int sdcard_start(uint32_t block, void *buffer, uint16_t count, uint8_t flags,
+                 sdcard_callback_t callback, void *ptr);
+int sdcard_read(uint32_t block, void *buffer, uint16_t count);
+int sdcard_write(uint32_t block, const void *buffer, uint16_t count);
+int sdcard_notify(sdcard_callback_t callback, void *ptr);
+void sdcard_protect(int enable);
+int sdcard_protected();
+
+#endif //SDCARD_H_
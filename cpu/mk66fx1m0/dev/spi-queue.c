@@ -0,0 +1,179 @@
+//+------------------------------------------------------------------------------------------------+
+//| DMA driven SPI transaction queue for Kinetis MK66 MCU.                                         |
+//|                                                                                                |
+//| Every line of a transaction is a major loop of both DMA channels. Only the receive channel     |
+//| interrupts, once the last frame of the line has been received (and thus fully sent); the next  |
+//| line is then started, or the transaction completed. The frame size and data/command line are   |
+//| changed between transactions only, when the SPI is idle.                                       |
+//|                                                                                                |
+//| The transmit channel writes 8 or 16 bits to PUSHR, which pushes the whole register with its    |
+//| command half left at zero (CTAR0 attributes, no hardware chip select).                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "spi-queue.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-gpio.h"
+#include "mk66-spi.h"
+#include "mk66-dma.h"
+#include "mk66-dmamux.h"
+
+//DMA channels used by the queue.
+#define TX_CHANNEL 1
+#define RX_CHANNEL 2
+
+//Chip select and data/command pins (on port C).
+#define CS_PIN 4
+#define DC_PIN 3
+
+//SPI clock: 60MHz bus / 2 * 2 / 2 = 30MHz, mode 0.
+#define SPI_CTAR_BASE (SPI_CTAR_PBR_Div_2 | (0 << SPI_CTAR_BR_Pos) | SPI_CTAR_DBR_Enabled | \
+                       SPI_CTAR_CPOL_Low | SPI_CTAR_CPHA_Leading | SPI_CTAR_LSBFE_MSB)
+
+//Interrupt priority.
+#define DMA_PRIORITY 5
+
+//Transaction queue. The head is the transaction being sent.
+static struct spi_transaction *head = NULL;
+static struct spi_transaction *tail = NULL;
+static uint16_t line;
+
+//Received frames are dropped here.
+static uint32_t discard;
+
+//Programs both channels for a line of the current transaction and starts them.
+static void start_line() {
+  const uint8_t *src = (const uint8_t *) head->data + (uint32_t) line * head->stride;
+  uint8_t size = (head->flags & SPI_QUEUE_16BIT) ? 2 : 1;
+
+  //The receive channel must be ready before the first frame is pushed.
+  DMA->TCD[RX_CHANNEL].CITER = head->frames;
+  DMA->TCD[RX_CHANNEL].BITER = head->frames;
+  DMA->SERQ = RX_CHANNEL;
+
+  DMA->TCD[TX_CHANNEL].SADDR = (uint32_t) src;
+  DMA->TCD[TX_CHANNEL].SOFF = size;
+  DMA->TCD[TX_CHANNEL].ATTR = (size == 2) ? (DMA_ATTR_SSIZE_16Bit | DMA_ATTR_DSIZE_16Bit) :
+                                            (DMA_ATTR_SSIZE_8Bit | DMA_ATTR_DSIZE_8Bit);
+  DMA->TCD[TX_CHANNEL].NBYTES = size;
+  DMA->TCD[TX_CHANNEL].CITER = head->frames;
+  DMA->TCD[TX_CHANNEL].BITER = head->frames;
+  DMA->SERQ = TX_CHANNEL;
+}
+
+//Starts the transaction at the head of the queue. The SPI must be idle.
+static void start_transaction() {
+  uint32_t fmsz = (head->flags & SPI_QUEUE_16BIT) ? 15 : 7;
+
+  //The frame size can only be changed while the module is halted.
+  SPI0->MCR = SPI_MCR_MSTR_Master | SPI_MCR_HALT_Enabled;
+  SPI0->CTAR0 = SPI_CTAR_BASE | (fmsz << SPI_CTAR_FMSZ_Pos);
+  SPI0->MCR = SPI_MCR_MSTR_Master | SPI_MCR_HALT_Disabled;
+
+  if (head->flags & SPI_QUEUE_DC_HIGH)
+    GPIOC->PSOR = 1 << DC_PIN;
+  else
+    GPIOC->PCOR = 1 << DC_PIN;
+  GPIOC->PCOR = 1 << CS_PIN;
+
+  line = 0;
+  start_line();
+}
+
+void spi_queue_init() {
+  //Enable the module clocks and route the pins. Chip select starts deasserted.
+  SIM->SCGC6 |= SIM_SCGC6_SPI0_Enabled | SIM_SCGC6_DMAMUX_Enabled;
+  SIM->SCGC7 |= SIM_SCGC7_DMA_Enabled;
+  PORTC->PCR[6] = PORT_PCR_MUX_Alt2 | PORT_PCR_DSE_High;
+  PORTC->PCR[5] = PORT_PCR_MUX_Alt2 | PORT_PCR_DSE_High;
+  PORTC->PCR[CS_PIN] = PORT_PCR_MUX_Gpio | PORT_PCR_DSE_High;
+  PORTC->PCR[DC_PIN] = PORT_PCR_MUX_Gpio | PORT_PCR_DSE_High;
+  GPIOC->PSOR = (1 << CS_PIN) | (1 << DC_PIN);
+  GPIOC->PDDR |= (1 << CS_PIN) | (1 << DC_PIN);
+
+  //Master mode, with DMA requests for both FIFOs.
+  SPI0->MCR = SPI_MCR_MSTR_Master | SPI_MCR_CLR_TXF_Set | SPI_MCR_CLR_RXF_Set |
+              SPI_MCR_HALT_Enabled;
+  SPI0->CTAR0 = SPI_CTAR_BASE | (7 << SPI_CTAR_FMSZ_Pos);
+  SPI0->RSER = SPI_RSER_TFFF_RE_Enabled | SPI_RSER_TFFF_DIRS_DMA | SPI_RSER_RFDF_RE_Enabled |
+               SPI_RSER_RFDF_DIRS_DMA;
+  SPI0->MCR = SPI_MCR_MSTR_Master | SPI_MCR_HALT_Disabled;
+
+  //Transmit channel: memory to PUSHR, reprogrammed for every line. The request is cleared when
+  //the line is over.
+  DMA->CERQ = TX_CHANNEL;
+  DMAMUX->CHCFG[TX_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[TX_CHANNEL].SLAST = 0;
+  DMA->TCD[TX_CHANNEL].DADDR = (uint32_t) &SPI0->PUSHR;
+  DMA->TCD[TX_CHANNEL].DOFF = 0;
+  DMA->TCD[TX_CHANNEL].DLASTSGA = 0;
+  DMA->TCD[TX_CHANNEL].CSR = DMA_CSR_DREQ_Enabled;
+  DMAMUX->CHCFG[TX_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_SPI0_Tx;
+
+  //Receive channel: POPR to a dummy word, interrupting at the end of every line.
+  DMA->CERQ = RX_CHANNEL;
+  DMAMUX->CHCFG[RX_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[RX_CHANNEL].SADDR = (uint32_t) &SPI0->POPR;
+  DMA->TCD[RX_CHANNEL].SOFF = 0;
+  DMA->TCD[RX_CHANNEL].ATTR = DMA_ATTR_SSIZE_32Bit | DMA_ATTR_DSIZE_32Bit;
+  DMA->TCD[RX_CHANNEL].NBYTES = 4;
+  DMA->TCD[RX_CHANNEL].SLAST = 0;
+  DMA->TCD[RX_CHANNEL].DADDR = (uint32_t) &discard;
+  DMA->TCD[RX_CHANNEL].DOFF = 0;
+  DMA->TCD[RX_CHANNEL].DLASTSGA = 0;
+  DMA->TCD[RX_CHANNEL].CSR = DMA_CSR_DREQ_Enabled | DMA_CSR_INTMAJOR_Enabled;
+  DMAMUX->CHCFG[RX_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_SPI0_Rx;
+
+  NVIC_SetPriority(DmaChannel_2_18_IRQn, DMA_PRIORITY);
+  NVIC_EnableIRQ(DmaChannel_2_18_IRQn);
+}
+
+//Appends a transaction to the queue, starting it right away if the queue was idle. May be called
+//from completion callbacks.
+void spi_queue_submit(struct spi_transaction *t) {
+  t->next = NULL;
+
+  NVIC_DisableIRQ(DmaChannel_2_18_IRQn);
+  if (head == NULL) {
+    head = tail = t;
+    start_transaction();
+  } else {
+    tail->next = t;
+    tail = t;
+  }
+  NVIC_EnableIRQ(DmaChannel_2_18_IRQn);
+}
+
+int spi_queue_idle() {
+  return head == NULL;
+}
+
+void dma_channel_2_18_handler() {
+  struct spi_transaction *done;
+
+  DMA->CINT = RX_CHANNEL;
+
+  //Move on to the next line, if any.
+  if (++line < head->lines) {
+    start_line();
+    return;
+  }
+
+  //The transaction is over. Start the next one before running the callback, so the SPI is kept
+  //busy meanwhile.
+  done = head;
+  head = head->next;
+  if (head != NULL)
+    start_transaction();
+  else
+    GPIOC->PSOR = 1 << CS_PIN;
+
+  if (done->callback != NULL)
+    done->callback(done);
+}
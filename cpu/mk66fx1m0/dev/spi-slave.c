@@ -0,0 +1,356 @@
+//+------------------------------------------------------------------------------------------------+
+//| SPI slave coprocessor interface for Kinetis MK66 MCU.                                          |
+//|                                                                                                |
+//| eDMA channel 4 drains the receive FIFO into the receive ring and channel 5 feeds the transmit  |
+//| FIFO from the transmit ring. Both channels run forever, with major loops of one frame and the  |
+//| ring wrap around done by the address modulo feature (which is why the rings are aligned to     |
+//| their size), so no reprogramming is needed between frames.                                     |
+//|                                                                                                |
+//| The chip select rising edge interrupt marks the end of every frame: it checks the receive      |
+//| channel is exactly at the start of the next slot, recycles the transmit slot just sent as an   |
+//| idle frame and hands the received frame over to the driver process.                            |
+//|                                                                                                |
+//| Frame numbers are counted since initialization. Frame n uses slot n modulo the ring size on    |
+//| both rings. The transmit slots of the frame in progress and the next one are considered        |
+//| committed (the DMA channel reads ahead of the bus), so frames are queued 2 slots ahead.        |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+#include <string.h>
+
+#include "spi-slave.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-gpio.h"
+#include "mk66-spi.h"
+#include "mk66-dma.h"
+#include "mk66-dmamux.h"
+
+//DMA channels used by the driver.
+#define RX_CHANNEL 4
+#define TX_CHANNEL 5
+
+//Chip select and data ready pins (on port C).
+#define CS_PIN 4
+#define DR_PIN 3
+
+//Ring sizes, in bytes.
+#define RX_RING_SIZE (SPI_SLAVE_RX_FRAMES * SPI_SLAVE_FRAME_SIZE)
+#define TX_RING_SIZE (SPI_SLAVE_TX_FRAMES * SPI_SLAVE_FRAME_SIZE)
+
+//Frame slots.
+#define RX_FRAME(n) (&rx_ring[((n) & (SPI_SLAVE_RX_FRAMES - 1)) * SPI_SLAVE_FRAME_SIZE])
+#define TX_FRAME(n) (&tx_ring[((n) & (SPI_SLAVE_TX_FRAMES - 1)) * SPI_SLAVE_FRAME_SIZE])
+
+//Interrupt priority. The end of frame work must be done before the next frame ends.
+#define PORT_PRIORITY 3
+
+static uint8_t rx_ring[RX_RING_SIZE] __attribute__((aligned(RX_RING_SIZE)));
+static uint8_t tx_ring[TX_RING_SIZE] __attribute__((aligned(TX_RING_SIZE)));
+
+//CRC16-CCITT lookup table.
+static uint16_t crc_table[256];
+
+//Frame counters: frames transferred, next received frame to process and next transmit slot to
+//fill.
+static volatile uint32_t frames;
+static uint32_t rx_read;
+static uint32_t tx_next;
+
+static struct spi_slave_stats stats;
+static struct process *receiver;
+
+uint8_t spi_slave_registers[SPI_SLAVE_REGISTERS];
+
+process_event_t spi_slave_event_register;
+process_event_t spi_slave_event_mailbox;
+
+PROCESS(spi_slave_process, "SPI slave");
+
+//Returns the base 2 logarithm of a power of two.
+static uint8_t log2_of(uint32_t value) {
+  uint8_t n = 0;
+
+  while (value > 1) {
+    value >>= 1;
+    n++;
+  }
+
+  return n;
+}
+
+//Computes the CRC of a frame, over the first 4 header bytes and the payload.
+static uint16_t frame_crc(const uint8_t *frame) {
+  uint16_t crc = 0xFFFF;
+  uint16_t i;
+
+  for (i = 0; i < 4; i++)
+    crc = (crc << 8) ^ crc_table[(crc >> 8) ^ frame[i]];
+  for (i = 0; i < frame[3]; i++)
+    crc = (crc << 8) ^ crc_table[(crc >> 8) ^ frame[SPI_SLAVE_HEADER_SIZE + i]];
+
+  return crc;
+}
+
+//Fills the header of a frame, including its CRC (the payload must be already in place).
+static void seal(uint8_t *frame, uint8_t type, uint8_t seq, uint8_t id, uint8_t length) {
+  uint16_t crc;
+
+  frame[0] = type;
+  frame[1] = seq;
+  frame[2] = id;
+  frame[3] = length;
+  crc = frame_crc(frame);
+  frame[4] = crc;
+  frame[5] = crc >> 8;
+}
+
+//Puts a frame in the first free transmit slot. Returns -1 if there's none.
+static int queue_frame(uint8_t type, uint8_t id, const void *data, uint8_t length) {
+  uint32_t n;
+  uint8_t *frame;
+
+  NVIC_DisableIRQ(PORT_C_IRQn);
+
+  n = tx_next;
+  if ((int32_t) (n - (frames + 2)) < 0)
+    n = frames + 2;
+  if ((int32_t) (n - (frames + SPI_SLAVE_TX_FRAMES)) >= 0) {
+    NVIC_EnableIRQ(PORT_C_IRQn);
+    return -1;
+  }
+
+  frame = TX_FRAME(n);
+  memcpy(&frame[SPI_SLAVE_HEADER_SIZE], data, length);
+  seal(frame, type, n, id, length);
+  tx_next = n + 1;
+  GPIOC->PSOR = 1 << DR_PIN;
+
+  NVIC_EnableIRQ(PORT_C_IRQn);
+  return 0;
+}
+
+//Restarts both rings at the slots of the current frame, dropping anything in the FIFOs.
+static void realign() {
+  DMA->CERQ = RX_CHANNEL;
+  DMA->CERQ = TX_CHANNEL;
+  SPI0->MCR = SPI_MCR_MSTR_Slave | SPI_MCR_CLR_TXF_Set | SPI_MCR_CLR_RXF_Set |
+              SPI_MCR_HALT_Enabled;
+
+  DMA->TCD[RX_CHANNEL].DADDR = (uint32_t) RX_FRAME(frames);
+  DMA->TCD[RX_CHANNEL].CITER = SPI_SLAVE_FRAME_SIZE;
+  DMA->TCD[TX_CHANNEL].SADDR = (uint32_t) TX_FRAME(frames);
+  DMA->TCD[TX_CHANNEL].CITER = SPI_SLAVE_FRAME_SIZE;
+  DMA->SERQ = RX_CHANNEL;
+  DMA->SERQ = TX_CHANNEL;
+
+  SPI0->MCR = SPI_MCR_MSTR_Slave | SPI_MCR_HALT_Disabled;
+}
+
+void spi_slave_init() {
+  uint32_t i, crc;
+  uint8_t bit;
+
+  //Build the CRC table (polynomial 0x1021).
+  for (i = 0; i < 256; i++) {
+    crc = i << 8;
+    for (bit = 0; bit < 8; bit++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    crc_table[i] = crc;
+  }
+
+  //Every transmit slot starts as an idle frame.
+  frames = 0;
+  rx_read = 0;
+  tx_next = 0;
+  for (i = 0; i < SPI_SLAVE_TX_FRAMES; i++)
+    seal(TX_FRAME(i), SPI_SLAVE_TYPE_IDLE, i, 0, 0);
+
+  receiver = PROCESS_CURRENT();
+  spi_slave_event_register = process_alloc_event();
+  spi_slave_event_mailbox = process_alloc_event();
+  process_start(&spi_slave_process, NULL);
+
+  //Enable the module clocks and route the pins. The chip select pin also interrupts on its rising
+  //edge (end of frame).
+  SIM->SCGC5 |= SIM_SCGC5_PORTC_Enabled;
+  SIM->SCGC6 |= SIM_SCGC6_SPI0_Enabled | SIM_SCGC6_DMAMUX_Enabled;
+  SIM->SCGC7 |= SIM_SCGC7_DMA_Enabled;
+  PORTC->PCR[7] = PORT_PCR_MUX_Alt2;
+  PORTC->PCR[6] = PORT_PCR_MUX_Alt2 | PORT_PCR_DSE_High;
+  PORTC->PCR[5] = PORT_PCR_MUX_Alt2;
+  PORTC->PCR[CS_PIN] = PORT_PCR_MUX_Alt2 | PORT_PCR_PE_Enabled | PORT_PCR_PS_Pullup |
+                       PORT_PCR_IRQC_Int_Rise | PORT_PCR_ISF_Set;
+  PORTC->PCR[DR_PIN] = PORT_PCR_MUX_Gpio | PORT_PCR_DSE_High;
+  GPIOC->PCOR = 1 << DR_PIN;
+  GPIOC->PDDR |= 1 << DR_PIN;
+
+  //Slave mode, 8 bit frames, mode 0, with DMA requests for both FIFOs.
+  SPI0->MCR = SPI_MCR_MSTR_Slave | SPI_MCR_CLR_TXF_Set | SPI_MCR_CLR_RXF_Set |
+              SPI_MCR_HALT_Enabled;
+  SPI0->CTAR0 = (7 << SPI_CTAR_FMSZ_Pos) | SPI_CTAR_CPOL_Low | SPI_CTAR_CPHA_Leading;
+  SPI0->RSER = SPI_RSER_TFFF_RE_Enabled | SPI_RSER_TFFF_DIRS_DMA | SPI_RSER_RFDF_RE_Enabled |
+               SPI_RSER_RFDF_DIRS_DMA;
+
+  //Receive channel: POPR to the receive ring.
+  DMA->CERQ = RX_CHANNEL;
+  DMAMUX->CHCFG[RX_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[RX_CHANNEL].SADDR = (uint32_t) &SPI0->POPR;
+  DMA->TCD[RX_CHANNEL].SOFF = 0;
+  DMA->TCD[RX_CHANNEL].ATTR = DMA_ATTR_SSIZE_8Bit | DMA_ATTR_DSIZE_8Bit |
+                              (log2_of(RX_RING_SIZE) << DMA_ATTR_DMOD_Pos);
+  DMA->TCD[RX_CHANNEL].NBYTES = 1;
+  DMA->TCD[RX_CHANNEL].SLAST = 0;
+  DMA->TCD[RX_CHANNEL].DOFF = 1;
+  DMA->TCD[RX_CHANNEL].BITER = SPI_SLAVE_FRAME_SIZE;
+  DMA->TCD[RX_CHANNEL].DLASTSGA = 0;
+  DMA->TCD[RX_CHANNEL].CSR = 0;
+  DMAMUX->CHCFG[RX_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_SPI0_Rx;
+
+  //Transmit channel: transmit ring to PUSHR.
+  DMA->CERQ = TX_CHANNEL;
+  DMAMUX->CHCFG[TX_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[TX_CHANNEL].SOFF = 1;
+  DMA->TCD[TX_CHANNEL].ATTR = DMA_ATTR_SSIZE_8Bit | DMA_ATTR_DSIZE_8Bit |
+                              (log2_of(TX_RING_SIZE) << DMA_ATTR_SMOD_Pos);
+  DMA->TCD[TX_CHANNEL].NBYTES = 1;
+  DMA->TCD[TX_CHANNEL].SLAST = 0;
+  DMA->TCD[TX_CHANNEL].DADDR = (uint32_t) &SPI0->PUSHR;
+  DMA->TCD[TX_CHANNEL].DOFF = 0;
+  DMA->TCD[TX_CHANNEL].BITER = SPI_SLAVE_FRAME_SIZE;
+  DMA->TCD[TX_CHANNEL].DLASTSGA = 0;
+  DMA->TCD[TX_CHANNEL].CSR = 0;
+  DMAMUX->CHCFG[TX_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_SPI0_Tx;
+
+  //Start both rings at frame 0.
+  realign();
+
+  NVIC_SetPriority(PORT_C_IRQn, PORT_PRIORITY);
+  NVIC_EnableIRQ(PORT_C_IRQn);
+}
+
+//Queues a message for the host in a mailbox. Returns -1 if the message is too long or the
+//transmit ring is full.
+int spi_slave_send(uint8_t mailbox, const void *data, uint8_t length) {
+  if (length > SPI_SLAVE_PAYLOAD_SIZE)
+    return -1;
+
+  return queue_frame(SPI_SLAVE_TYPE_MAILBOX, mailbox, data, length);
+}
+
+//Returns the amount of frames that can be queued right now.
+int spi_slave_tx_free() {
+  uint32_t first = frames + 2;
+
+  if ((int32_t) (tx_next - first) < 0)
+    return SPI_SLAVE_TX_FRAMES - 2;
+
+  return SPI_SLAVE_TX_FRAMES - 2 - (tx_next - first);
+}
+
+const struct spi_slave_stats *spi_slave_stats() {
+  stats.frames = frames;
+  return &stats;
+}
+
+//Handles a frame received from the host.
+static void handle_frame(const uint8_t *frame) {
+  struct spi_slave_message message;
+  uint8_t address, length;
+
+  if (frame[0] == SPI_SLAVE_TYPE_IDLE)
+    return;
+
+  if (frame[3] > SPI_SLAVE_PAYLOAD_SIZE ||
+      frame_crc(frame) != (frame[4] | (frame[5] << 8))) {
+    stats.crc_errors++;
+    return;
+  }
+
+  address = frame[2];
+  length = frame[3];
+
+  switch (frame[0]) {
+  case SPI_SLAVE_TYPE_REG_WRITE:
+    if (length > SPI_SLAVE_REGISTERS - address)
+      length = SPI_SLAVE_REGISTERS - address;
+    memcpy(&spi_slave_registers[address], &frame[SPI_SLAVE_HEADER_SIZE], length);
+    process_post_synch(receiver, spi_slave_event_register, &address);
+    break;
+
+  case SPI_SLAVE_TYPE_REG_READ:
+    if (length < 1)
+      break;
+    length = frame[SPI_SLAVE_HEADER_SIZE];
+    if (length > SPI_SLAVE_REGISTERS - address)
+      length = SPI_SLAVE_REGISTERS - address;
+    if (length > SPI_SLAVE_PAYLOAD_SIZE)
+      length = SPI_SLAVE_PAYLOAD_SIZE;
+    queue_frame(SPI_SLAVE_TYPE_REG_DATA, address, &spi_slave_registers[address], length);
+    break;
+
+  case SPI_SLAVE_TYPE_MAILBOX:
+    message.mailbox = address;
+    message.length = length;
+    message.data = &frame[SPI_SLAVE_HEADER_SIZE];
+    process_post_synch(receiver, spi_slave_event_mailbox, &message);
+    break;
+  }
+}
+
+//End of frame.
+void port_c_handler() {
+  uint8_t spin;
+
+  PORTC->ISFR = 1 << CS_PIN;
+
+  //The last bytes may still be on their way out of the receive FIFO.
+  for (spin = 0; spin < 32 && (SPI0->SR & SPI_SR_RXCTR_Msk); spin++);
+
+  //A transfer of other than one frame leaves the receive channel elsewhere. The transmit slot is
+  //kept, so its frame is sent again.
+  if (DMA->TCD[RX_CHANNEL].DADDR != (uint32_t) RX_FRAME(frames + 1)) {
+    stats.realigns++;
+    realign();
+    return;
+  }
+
+  //The slot just sent comes around again TX_FRAMES frames later.
+  seal(TX_FRAME(frames), SPI_SLAVE_TYPE_IDLE, frames + SPI_SLAVE_TX_FRAMES, 0, 0);
+  frames++;
+
+  if ((int32_t) (tx_next - frames) <= 0)
+    GPIOC->PCOR = 1 << DR_PIN;
+
+  process_poll(&spi_slave_process);
+}
+
+//Processes the received frames, in order.
+PROCESS_THREAD(spi_slave_process, ev, data) {
+  uint32_t pending;
+
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    while (rx_read != frames) {
+      //The slot of the frame in progress is being written, so at most RX_FRAMES - 1 frames can
+      //be waiting.
+      pending = frames - rx_read;
+      if (pending > SPI_SLAVE_RX_FRAMES - 1) {
+        stats.overruns += pending - (SPI_SLAVE_RX_FRAMES - 1);
+        rx_read += pending - (SPI_SLAVE_RX_FRAMES - 1);
+      }
+
+      handle_frame(RX_FRAME(rx_read));
+      rx_read++;
+    }
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,110 @@
+//+------------------------------------------------------------------------------------------------+
+//| SPI slave coprocessor interface for Kinetis MK66 MCU.                                          |
+//|                                                                                                |
+//| Lets a host (such as a Linux board) use the MCU as an I/O coprocessor over SPI0, in slave      |
+//| mode. The host transfers fixed size frames, one per chip select assertion, and every frame     |
+//| goes both ways: while the host sends a frame, it receives one from the slave. Both directions  |
+//| run from DMA ring buffers, so the CPU is involved once per frame, never per byte.              |
+//|                                                                                                |
+//| Frame layout (SPI_SLAVE_FRAME_SIZE bytes):                                                     |
+//| - Byte 0: frame type (SPI_SLAVE_TYPE_*).                                                       |
+//| - Byte 1: sequence number (frame counter of the sender).                                       |
+//| - Byte 2: register address or mailbox number.                                                  |
+//| - Byte 3: payload length.                                                                      |
+//| - Bytes 4 and 5: CRC16-CCITT (little endian) over bytes 0 to 3 and the payload.                |
+//| - Bytes 6 onwards: payload.                                                                    |
+//|                                                                                                |
+//| Frame types:                                                                                   |
+//| - IDLE: no content. Sent by the host to clock out slave frames, and by the slave when it has   |
+//|   nothing to send.                                                                             |
+//| - REG_WRITE (host to slave): writes the payload into the register file, from the address on.   |
+//| - REG_READ (host to slave): asks for payload[0] registers from the address on. The slave       |
+//|   answers with a REG_DATA frame.                                                               |
+//| - MAILBOX (both ways): a message for the given mailbox. Its meaning is up to the application.  |
+//|                                                                                                |
+//| The data ready line is driven high while the slave has frames queued, so the host only needs   |
+//| to clock frames when told to. A queued frame leaves the slave 2 frames after being queued at   |
+//| the earliest, as the transmit FIFO and the DMA channel work ahead of the bus. Frames received  |
+//| with a bad CRC are dropped. If a transfer isn't exactly one frame long, both rings are         |
+//| realigned and the frame sent by the slave is repeated in the next transfer.                    |
+//|                                                                                                |
+//| SPI mode 0, up to 15MHz. SPI0 is shared with the LED strip driver and the SPI transaction      |
+//| queue, so only one of them can be used at a time.                                              |
+//|                                                                                                |
+//| Pins (Teensy 3.6 pin numbers in parenthesis): host MOSI to PTC7 (12), host MISO to PTC6 (11),  |
+//| SCK to PTC5 (13), chip select to PTC4 (10), data ready output on PTC3 (9).                     |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef SPI_SLAVE_H_
+#define SPI_SLAVE_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Frame size (a power of two, from 16 to 256 bytes).
+#ifdef SPI_SLAVE_CONF_FRAME_SIZE
+#define SPI_SLAVE_FRAME_SIZE SPI_SLAVE_CONF_FRAME_SIZE
+#else
+#define SPI_SLAVE_FRAME_SIZE 256
+#endif
+
+//Frames in the receive and transmit rings (powers of two, at least 4).
+#ifdef SPI_SLAVE_CONF_RX_FRAMES
+#define SPI_SLAVE_RX_FRAMES SPI_SLAVE_CONF_RX_FRAMES
+#else
+#define SPI_SLAVE_RX_FRAMES 16
+#endif
+
+#ifdef SPI_SLAVE_CONF_TX_FRAMES
+#define SPI_SLAVE_TX_FRAMES SPI_SLAVE_CONF_TX_FRAMES
+#else
+#define SPI_SLAVE_TX_FRAMES 8
+#endif
+
+//Frame layout.
+#define SPI_SLAVE_HEADER_SIZE 6
+#define SPI_SLAVE_PAYLOAD_SIZE (SPI_SLAVE_FRAME_SIZE - SPI_SLAVE_HEADER_SIZE)
+
+//Frame types.
+#define SPI_SLAVE_TYPE_IDLE       0
+#define SPI_SLAVE_TYPE_REG_WRITE  1
+#define SPI_SLAVE_TYPE_REG_READ   2
+#define SPI_SLAVE_TYPE_REG_DATA   3
+#define SPI_SLAVE_TYPE_MAILBOX    4
+
+//Size of the register file.
+#define SPI_SLAVE_REGISTERS 256
+
+//Message received in a mailbox. Only valid while the event is being handled.
+struct spi_slave_message {
+  uint8_t mailbox;
+  uint8_t length;
+  const uint8_t *data;
+};
+
+//Error counters.
+struct spi_slave_stats {
+  uint32_t frames;      //Frames transferred
+  uint32_t crc_errors;  //Frames dropped due to a bad CRC
+  uint32_t overruns;    //Frames dropped because they weren't processed in time
+  uint32_t realigns;    //Transfers that weren't one frame long
+};
+
+//Events posted to the process that initialized the driver: a register write by the host (data
+//points to the address of the first register written), and a mailbox message (data points to a
+//struct spi_slave_message). Both are delivered synchronously.
+extern process_event_t spi_slave_event_register;
+extern process_event_t spi_slave_event_mailbox;
+
+//Register file, read and written by the host.
+extern uint8_t spi_slave_registers[SPI_SLAVE_REGISTERS];
+
+void spi_slave_init();
+int spi_slave_send(uint8_t mailbox, const void *data, uint8_t length);
+int spi_slave_tx_free();
+const struct spi_slave_stats *spi_slave_stats();
+
+#endif //SPI_SLAVE_H_
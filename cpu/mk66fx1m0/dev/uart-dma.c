@@ -0,0 +1,149 @@
+//+------------------------------------------------------------------------------------------------+
+//| DMA driven UART link for Kinetis MK66 MCU.                                                     |
+//|                                                                                                |
+//| eDMA channel 6 moves every received byte into the receive ring. It runs forever, with a major  |
+//| loop of the whole ring and the wrap around done by the address modulo feature (which is why    |
+//| the ring is aligned to its size), so the write position is just its destination address.       |
+//| Channel 7 feeds the transmitter from the buffer being sent, and stops at the end of it.        |
+//|                                                                                                |
+//| The idle line interrupt fires once the line stays idle for a character time after receiving,   |
+//| which is when a sender is done with a message (or a burst of them).                            |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "uart-dma.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-port.h"
+#include "mk66-uart.h"
+#include "mk66-dma.h"
+#include "mk66-dmamux.h"
+
+//DMA channels used by the driver.
+#define RX_CHANNEL 6
+#define TX_CHANNEL 7
+
+//UART3 runs from the bus clock. The divider has a fractional part of 5 bits, in 1/32 steps.
+#define BUS_CLOCK 60000000
+#define DIVIDER_X32 ((2 * BUS_CLOCK + UART_DMA_BAUD / 2) / UART_DMA_BAUD)
+
+//Interrupt priority. Only wakes up the receiver process.
+#define UART_PRIORITY 11
+
+static uint8_t rx_ring[UART_DMA_RX_SIZE] __attribute__((aligned(UART_DMA_RX_SIZE)));
+static struct process *receiver;
+
+const uint8_t *const uart_dma_rx_ring = rx_ring;
+
+//Returns the base 2 logarithm of a power of two.
+static uint8_t log2_of(uint32_t value) {
+  uint8_t n = 0;
+
+  while (value > 1) {
+    value >>= 1;
+    n++;
+  }
+
+  return n;
+}
+
+//Initializes UART3 and both DMA channels. The receiver process is polled whenever the line goes
+//idle after receiving.
+void uart_dma_init(struct process *p) {
+  receiver = p;
+
+  SIM->SCGC4 |= SIM_SCGC4_UART3_Enabled;
+  SIM->SCGC5 |= SIM_SCGC5_PORTB_Enabled;
+  SIM->SCGC6 |= SIM_SCGC6_DMAMUX_Enabled;
+  SIM->SCGC7 |= SIM_SCGC7_DMA_Enabled;
+  PORTB->PCR[10] = PORT_PCR_MUX_Alt3 | PORT_PCR_PE_Enabled | PORT_PCR_PS_Pullup;  //RX
+  PORTB->PCR[11] = PORT_PCR_MUX_Alt3 | PORT_PCR_DSE_High;                         //TX
+
+  //8 data bits, no parity, 1 stop bit. Idle time is counted from the end of the stop bit, so the
+  //stop bit of the last byte doesn't count towards it.
+  UART3->C2 = 0;
+  UART3->BDH = (((DIVIDER_X32 >> 13) & UART_BDH_SBR_Msk) << UART_BDH_SBR_Pos) | UART_BDH_SBNS_1;
+  UART3->BDL = ((DIVIDER_X32 >> 5) & UART_BDL_SBR_Msk) << UART_BDL_SBR_Pos;
+  UART3->C4 = (DIVIDER_X32 & UART_C4_BRFA_Msk) << UART_C4_BRFA_Pos;
+  UART3->C1 = UART_C1_PE_Disabled | UART_C1_M_8Bit | UART_C1_ILT_Stop;
+  UART3->C5 = UART_C5_RDMAS_DMA | UART_C5_TDMAS_DMA;
+
+  //Receive channel: data register to the receive ring, forever.
+  DMA->CERQ = RX_CHANNEL;
+  DMAMUX->CHCFG[RX_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[RX_CHANNEL].SADDR = (uint32_t) &UART3->D;
+  DMA->TCD[RX_CHANNEL].SOFF = 0;
+  DMA->TCD[RX_CHANNEL].ATTR = DMA_ATTR_SSIZE_8Bit | DMA_ATTR_DSIZE_8Bit |
+                              (log2_of(UART_DMA_RX_SIZE) << DMA_ATTR_DMOD_Pos);
+  DMA->TCD[RX_CHANNEL].NBYTES = 1;
+  DMA->TCD[RX_CHANNEL].SLAST = 0;
+  DMA->TCD[RX_CHANNEL].DADDR = (uint32_t) rx_ring;
+  DMA->TCD[RX_CHANNEL].DOFF = 1;
+  DMA->TCD[RX_CHANNEL].CITER = UART_DMA_RX_SIZE;
+  DMA->TCD[RX_CHANNEL].BITER = UART_DMA_RX_SIZE;
+  DMA->TCD[RX_CHANNEL].DLASTSGA = 0;
+  DMA->TCD[RX_CHANNEL].CSR = 0;
+  DMAMUX->CHCFG[RX_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_UART3_Rx;
+  DMA->SERQ = RX_CHANNEL;
+
+  //Transmit channel: buffer to data register, armed for every transmission.
+  DMA->CERQ = TX_CHANNEL;
+  DMAMUX->CHCFG[TX_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->TCD[TX_CHANNEL].SOFF = 1;
+  DMA->TCD[TX_CHANNEL].ATTR = DMA_ATTR_SSIZE_8Bit | DMA_ATTR_DSIZE_8Bit;
+  DMA->TCD[TX_CHANNEL].NBYTES = 1;
+  DMA->TCD[TX_CHANNEL].SLAST = 0;
+  DMA->TCD[TX_CHANNEL].DADDR = (uint32_t) &UART3->D;
+  DMA->TCD[TX_CHANNEL].DOFF = 0;
+  DMA->TCD[TX_CHANNEL].DLASTSGA = 0;
+  DMA->TCD[TX_CHANNEL].CSR = DMA_CSR_DREQ_Enabled;
+  DMAMUX->CHCFG[TX_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_UART3_Tx;
+
+  UART3->C2 = UART_C2_RE_Enable | UART_C2_TE_Enable | UART_C2_RIE_Enabled | UART_C2_TIE_Enabled |
+              UART_C2_ILIE_Enabled;
+
+  NVIC_SetPriority(UART_3_Status_IRQn, UART_PRIORITY);
+  NVIC_EnableIRQ(UART_3_Status_IRQn);
+}
+
+//Returns the ring position the next received byte will be written to.
+uint16_t uart_dma_rx_head() {
+  return (DMA->TCD[RX_CHANNEL].DADDR - (uint32_t) rx_ring) & (UART_DMA_RX_SIZE - 1);
+}
+
+//Starts sending a buffer, which must stay untouched until sent. Returns -1 if a transmission is
+//still in progress.
+int uart_dma_send(const void *data, uint16_t length) {
+  if (uart_dma_busy())
+    return -1;
+  if (length == 0)
+    return 0;
+
+  DMA->TCD[TX_CHANNEL].SADDR = (uint32_t) data;
+  DMA->TCD[TX_CHANNEL].CITER = length;
+  DMA->TCD[TX_CHANNEL].BITER = length;
+  DMA->SERQ = TX_CHANNEL;
+
+  return 0;
+}
+
+//Returns nonzero while a transmission is in progress (the last byte may still be on the line).
+int uart_dma_busy() {
+  return (DMA->ERQ & (1 << TX_CHANNEL)) != 0;
+}
+
+//Idle line. The flag is cleared by reading the status register and then the data register. The
+//latter is only read when empty, so no byte is taken away from the receive channel.
+void uart_3_status_handler() {
+  if (UART3->S1 & UART_S1_IDLE_Msk) {
+    if (!(UART3->S1 & UART_S1_RDRF_Msk)) {
+      (void) UART3->D;
+      UART3->SFIFO = UART_SFIFO_RXUF_Set;
+    }
+    process_poll(receiver);
+  }
+}
@@ -0,0 +1,49 @@
+//+------------------------------------------------------------------------------------------------+
+//| DMA driven UART link for Kinetis MK66 MCU.                                                     |
+//|                                                                                                |
+//| A binary link on UART3, kept apart from the console (UART0) so printf() output never gets in   |
+//| the way. Received bytes are written by DMA into a ring buffer, where the consumer reads them   |
+//| in place, and transmissions are moved by DMA straight from the caller's buffer. The CPU is     |
+//| involved once per burst of received data (the idle line interrupt, which polls the process     |
+//| given at initialization) and once per transmission, never per byte.                            |
+//|                                                                                                |
+//| The consumer keeps its own read position and must keep up with the sender: the ring holds      |
+//| UART_DMA_RX_SIZE bytes, and older ones get overwritten. Request/response protocols, where the  |
+//| sender waits for answers, stay well within it.                                                 |
+//|                                                                                                |
+//| Pins (Teensy 3.6 pin numbers in parenthesis): RX on PTB10 (31), TX on PTB11 (32). They are     |
+//| shared with the external memory bus (see extram.h), so both can't be used at once.             |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef UART_DMA_H_
+#define UART_DMA_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Baud rate (the UART runs from the 60MHz bus clock, up to 3.75Mbps).
+#ifdef UART_DMA_CONF_BAUD
+#define UART_DMA_BAUD UART_DMA_CONF_BAUD
+#else
+#define UART_DMA_BAUD 1000000
+#endif
+
+//Receive ring size (a power of two, up to 32KB).
+#ifdef UART_DMA_CONF_RX_SIZE
+#define UART_DMA_RX_SIZE UART_DMA_CONF_RX_SIZE
+#else
+#define UART_DMA_RX_SIZE 1024
+#endif
+
+//Receive ring, written by DMA.
+extern const uint8_t *const uart_dma_rx_ring;
+
+void uart_dma_init(struct process *receiver);
+uint16_t uart_dma_rx_head();
+int uart_dma_send(const void *data, uint16_t length);
+int uart_dma_busy();
+
+#endif //UART_DMA_H_
@@ -0,0 +1,1294 @@
+//+------------------------------------------------------------------------------------------------+
+//| USB mass storage driver for Kinetis MK66 MCU.                                                  |
+//|                                                                                                |
+//| The USB module moves packets by itself, following buffer descriptors (two banks per endpoint   |
+//| and direction, used alternately). Endpoint 0 handles the standard and class requests, while    |
+//| endpoint 1 (bulk in) and endpoint 2 (bulk out) carry the bulk only transport: a command block  |
+//| from the host, an optional data stage and a status block from the device. Both banks of the    |
+//| bulk endpoints are kept queued during data stages, so packets flow back to back.               |
+//|                                                                                                |
+//| Data stages of reads and writes run on a pipeline of two buffers. Each buffer is either free,  |
+//| being transferred by the card, waiting for or being transferred by the host, or full (writes   |
+//| only, waiting for the card). Buffers go to the card and to the host in turns, so the card is   |
+//| always a buffer ahead of the host when reading, and a buffer behind when writing. Responses to |
+//| other commands are small, and go through a separate buffer.                                    |
+//|                                                                                                |
+//| The USB and SDHC interrupts share their priority, so the pipeline is only ever updated from    |
+//| one of them at a time. If the application holds the card when a transfer is due, it's retried  |
+//| on the next start of frame (every millisecond).                                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+#include <string.h>
+
+#include "usb-msc.h"
+#include "sdcard.h"
+
+#include "mk66.h"
+#include "mk66-sim.h"
+#include "mk66-mpu.h"
+#include "mk66-usb.h"
+
+//Interrupt priority. Matches the one of the SD card driver.
+#define USB_MSC_PRIORITY 7
+
+//Endpoints.
+#define EP0_SIZE 64
+#define BULK_SIZE 64
+#define EP_IN 1
+#define EP_OUT 2
+#define ENDPOINTS 3
+
+#define EP0_CONFIG (USB_ENDPT_EPRXEN_Enabled | USB_ENDPT_EPTXEN_Enabled | USB_ENDPT_EPHSHK_Enabled)
+
+//Requests, as the request code and the request type (direction, type and recipient) together.
+#define REQUEST(type, request) (((request) << 8) | (type))
+
+#define REQ_GET_DEVICE_STATUS      REQUEST(0x80, 0)
+#define REQ_GET_INTERFACE_STATUS   REQUEST(0x81, 0)
+#define REQ_GET_ENDPOINT_STATUS    REQUEST(0x82, 0)
+#define REQ_CLEAR_ENDPOINT_FEATURE REQUEST(0x02, 1)
+#define REQ_SET_ENDPOINT_FEATURE   REQUEST(0x02, 3)
+#define REQ_SET_ADDRESS            REQUEST(0x00, 5)
+#define REQ_GET_DESCRIPTOR         REQUEST(0x80, 6)
+#define REQ_GET_CONFIGURATION      REQUEST(0x80, 8)
+#define REQ_SET_CONFIGURATION      REQUEST(0x00, 9)
+#define REQ_GET_INTERFACE          REQUEST(0x81, 10)
+#define REQ_SET_INTERFACE          REQUEST(0x01, 11)
+#define REQ_MSC_RESET              REQUEST(0x21, 0xFF)
+#define REQ_MSC_GET_MAX_LUN        REQUEST(0xA1, 0xFE)
+
+#define FEATURE_ENDPOINT_HALT 0
+
+//Descriptor types.
+#define DESC_DEVICE         1
+#define DESC_CONFIGURATION  2
+#define DESC_STRING         3
+
+//Bulk only transport blocks.
+#define CBW_SIGNATURE 0x43425355
+#define CBW_LENGTH 31
+#define CSW_SIGNATURE 0x53425355
+#define CSW_LENGTH 13
+
+#define CSW_PASSED 0
+#define CSW_FAILED 1
+#define CSW_PHASE_ERROR 2
+
+//SCSI commands.
+#define SCSI_TEST_UNIT_READY          0x00
+#define SCSI_REQUEST_SENSE            0x03
+#define SCSI_INQUIRY                  0x12
+#define SCSI_MODE_SENSE_6             0x1A
+#define SCSI_START_STOP_UNIT          0x1B
+#define SCSI_PREVENT_ALLOW_REMOVAL    0x1E
+#define SCSI_READ_FORMAT_CAPACITIES   0x23
+#define SCSI_READ_CAPACITY_10         0x25
+#define SCSI_READ_10                  0x28
+#define SCSI_WRITE_10                 0x2A
+#define SCSI_VERIFY_10                0x2F
+#define SCSI_SYNCHRONIZE_CACHE_10     0x35
+#define SCSI_MODE_SENSE_10            0x5A
+
+//Sense keys and additional sense codes.
+#define SENSE_NONE              0x00
+#define SENSE_NOT_READY         0x02
+#define SENSE_MEDIUM_ERROR      0x03
+#define SENSE_ILLEGAL_REQUEST   0x05
+
+#define ASC_NONE                0x00
+#define ASC_WRITE_ERROR         0x0C
+#define ASC_READ_ERROR          0x11
+#define ASC_INVALID_COMMAND     0x20
+#define ASC_LBA_OUT_OF_RANGE    0x21
+#define ASC_INVALID_FIELD       0x24
+#define ASC_MEDIUM_NOT_PRESENT  0x3A
+
+//Transport states.
+#define STATE_IDLE      0   //Not configured
+#define STATE_CBW       1   //Waiting for a command block
+#define STATE_DATA_IN   2   //Sending data
+#define STATE_DATA_OUT  3   //Receiving data
+#define STATE_CSW       4   //Sending the status block (or waiting to)
+#define STATE_RESET     5   //Invalid command block received, waiting for a reset
+
+//Buffer states.
+#define BUFFER_FREE 0
+#define BUFFER_CARD 1       //Being transferred by the card
+#define BUFFER_HOST 2       //Waiting for or being transferred by the host
+#define BUFFER_FULL 3       //Received from the host, waiting for the card
+
+#define BUFFER_SIZE (USB_MSC_BUFFER_BLOCKS * SDCARD_BLOCK_SIZE)
+
+//Data buffer.
+struct buffer {
+  uint8_t *data;
+  uint8_t state;
+  uint32_t length;        //Bytes to transfer
+  uint32_t queued;        //Bytes handed to the USB module
+  uint32_t done;          //Bytes transferred by the USB module
+};
+
+//Bulk endpoint state.
+struct endpoint {
+  uint8_t number;
+  uint8_t tx;
+  uint8_t odd;                //Next bank to queue
+  uint8_t data01;             //Next data toggle
+  uint8_t pending;            //Banks queued
+  uint8_t halted;
+  struct buffer *owner[2];    //Buffer of the packet queued on each bank (NULL for transport blocks)
+};
+
+//Device descriptor.
+static const uint8_t device_descriptor[] = {
+  18,                                 //bLength
+  DESC_DEVICE,                        //bDescriptorType
+  0x00, 0x02,                         //bcdUSB (2.0)
+  0x00,                               //bDeviceClass (per interface)
+  0x00,                               //bDeviceSubClass
+  0x00,                               //bDeviceProtocol
+  EP0_SIZE,                           //bMaxPacketSize0
+  USB_MSC_VENDOR_ID & 0xFF, USB_MSC_VENDOR_ID >> 8,     //idVendor
+  USB_MSC_PRODUCT_ID & 0xFF, USB_MSC_PRODUCT_ID >> 8,   //idProduct
+  0x00, 0x01,                         //bcdDevice (1.0)
+  1,                                  //iManufacturer
+  2,                                  //iProduct
+  3,                                  //iSerialNumber
+  1,                                  //bNumConfigurations
+};
+
+//Configuration descriptor, along with the interface and endpoint descriptors.
+static const uint8_t configuration_descriptor[] = {
+  9,                                  //bLength
+  DESC_CONFIGURATION,                 //bDescriptorType
+  32, 0,                              //wTotalLength
+  1,                                  //bNumInterfaces
+  1,                                  //bConfigurationValue
+  0,                                  //iConfiguration
+  0x80,                               //bmAttributes (bus powered)
+  50,                                 //bMaxPower (100mA)
+
+  9,                                  //bLength
+  4,                                  //bDescriptorType (interface)
+  0,                                  //bInterfaceNumber
+  0,                                  //bAlternateSetting
+  2,                                  //bNumEndpoints
+  0x08,                               //bInterfaceClass (mass storage)
+  0x06,                               //bInterfaceSubClass (SCSI transparent command set)
+  0x50,                               //bInterfaceProtocol (bulk only transport)
+  0,                                  //iInterface
+
+  7,                                  //bLength
+  5,                                  //bDescriptorType (endpoint)
+  0x80 | EP_IN,                       //bEndpointAddress
+  0x02,                               //bmAttributes (bulk)
+  BULK_SIZE, 0,                       //wMaxPacketSize
+  0,                                  //bInterval
+
+  7,                                  //bLength
+  5,                                  //bDescriptorType (endpoint)
+  EP_OUT,                             //bEndpointAddress
+  0x02,                               //bmAttributes (bulk)
+  BULK_SIZE, 0,                       //wMaxPacketSize
+  0,                                  //bInterval
+};
+
+//String descriptor 0 (supported languages: US english).
+static const uint8_t language_descriptor[] = { 4, DESC_STRING, 0x09, 0x04 };
+
+//Inquiry response: removable direct access device, SPC-2.
+static const uint8_t inquiry_response[36] = {
+  0x00, 0x80, 0x04, 0x02, 31, 0x00, 0x00, 0x00,
+  'C', 'o', 'n', 't', 'i', 'k', 'i', ' ',
+  'T', 'e', 'e', 'n', 's', 'y', ' ', 'S', 'D', ' ', 'c', 'a', 'r', 'd', ' ', ' ',
+  '1', '.', '0', ' ',
+};
+
+static const char manufacturer_string[] = "Contiki";
+static const char product_string[] = "Teensy 3.6 SD card";
+static char serial_string[17];
+
+//Buffer descriptor table, only as long as the endpoints in use.
+static struct USB_BD_type bdt[ENDPOINTS * 4] __attribute__((aligned(512)));
+
+//Endpoint 0 state.
+static uint8_t ep0_rx[2][EP0_SIZE] __attribute__((aligned(4)));
+static uint8_t ep0_reply[EP0_SIZE] __attribute__((aligned(4)));
+static const uint8_t *ep0_data;     //Data left to send
+static uint16_t ep0_left;
+static uint8_t ep0_zlp;             //A zero length packet must end the data stage
+static uint8_t ep0_odd;
+static uint8_t ep0_data01;
+static uint8_t ep0_pending;
+static uint8_t address;
+static uint8_t configuration;
+
+//Bulk endpoints.
+static struct endpoint bulk_in = { EP_IN, 1 };
+static struct endpoint bulk_out = { EP_OUT, 0 };
+
+//Transport state.
+static uint8_t state;
+static uint8_t cbw[BULK_SIZE] __attribute__((aligned(4)));
+static uint8_t csw[CSW_LENGTH] __attribute__((aligned(4)));
+static uint32_t tag;
+static uint32_t host_length;        //Data stage length expected by the host
+static uint8_t host_in;             //Data stage direction expected by the host
+static uint8_t csw_status;
+static uint8_t csw_pending;         //Status block waiting for the bulk in endpoint to be cleared
+static uint8_t sense_key;
+static uint8_t sense_asc;
+
+//Data stage state.
+static uint32_t data_total;         //Bytes to transfer
+static uint32_t data_queued;        //Bytes handed to the USB module
+static uint32_t data_done;          //Bytes transferred by the USB module
+static uint8_t writing;
+
+//Buffers and card transfers.
+static uint8_t buffer_data[2][BUFFER_SIZE] __attribute__((aligned(4)));
+static uint8_t reply_data[EP0_SIZE] __attribute__((aligned(4)));
+static struct buffer buffers[2] = { { buffer_data[0] }, { buffer_data[1] } };
+static struct buffer reply = { reply_data };
+static struct buffer *usb_buffer;   //Next buffer for the host
+static struct buffer *card_buffer;  //Next buffer for the card
+static uint32_t block;              //Next block for the card
+static uint32_t blocks_left;        //Blocks left to read
+static uint8_t card_active;
+static uint8_t card_stale;          //Running transfer belongs to an aborted command
+static uint8_t card_retry;
+static uint8_t card_failed;
+
+//Mount state.
+static uint8_t ejected;
+static uint8_t suspended;
+static uint8_t mounted;
+static struct process *requester;
+
+process_event_t usb_msc_event;
+
+PROCESS(usb_msc_process, "USB MSC");
+
+static void sd_next();
+
+//--------------------------------------------------------------------------------------------------
+
+static uint16_t get_le16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t get_be16(const uint8_t *p) {
+  return (p[0] << 8) | p[1];
+}
+
+static uint32_t get_be32(const uint8_t *p) {
+  return ((uint32_t) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void put_le32(uint8_t *p, uint32_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+static void put_be32(uint8_t *p, uint32_t value) {
+  p[0] = value >> 24;
+  p[1] = value >> 16;
+  p[2] = value >> 8;
+  p[3] = value;
+}
+
+static struct buffer *other(struct buffer *b) {
+  return (b == &buffers[0]) ? &buffers[1] : &buffers[0];
+}
+
+//Updates the mount state, write protecting the card while mounted.
+static void update_mount() {
+  uint8_t m = configuration != 0 && !ejected && !suspended && sdcard_blocks() > 0;
+
+  if (m == mounted)
+    return;
+
+  mounted = m;
+  sdcard_protect(m);
+  process_poll(&usb_msc_process);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Queues a packet on the next bank of a bulk endpoint.
+static void queue(struct endpoint *e, struct buffer *owner, uint8_t *data, uint16_t size) {
+  volatile struct USB_BD_type *bd = &bdt[USB_BDT_Index(e->number, e->tx, e->odd)];
+
+  e->owner[e->odd] = owner;
+  bd->ADDR = (uint32_t) data;
+  bd->DESC = ((uint32_t) size << USB_BD_BC_Pos) | (e->data01 ? USB_BD_DATA1 : USB_BD_DATA0) |
+             USB_BD_DTS_Msk | USB_BD_OWN_Msk;
+
+  e->odd ^= 1;
+  e->data01 ^= 1;
+  e->pending++;
+}
+
+//Takes back the banks queued on a bulk endpoint, as if they were never queued.
+static void cancel(struct endpoint *e) {
+  while (e->pending > 0) {
+    e->odd ^= 1;
+    e->data01 ^= 1;
+    e->pending--;
+    bdt[USB_BDT_Index(e->number, e->tx, e->odd)].DESC = 0;
+  }
+}
+
+//Halts a bulk endpoint.
+static void stall(struct endpoint *e) {
+  USB0->ENDPOINT[e->number].ENDPT |= USB_ENDPT_EPSTALL_Msk;
+  e->halted = 1;
+}
+
+//Clears the halt of a bulk endpoint, which resets its data toggle. Banks already queued (held back
+//by the halt) get their toggles rewritten.
+static void unstall(struct endpoint *e) {
+  uint8_t odd = e->odd ^ (e->pending & 1);
+  uint8_t i;
+
+  for (i = 0; i < e->pending; i++, odd ^= 1) {
+    volatile struct USB_BD_type *bd = &bdt[USB_BDT_Index(e->number, e->tx, odd)];
+    bd->DESC = (bd->DESC & ~USB_BD_DATA1) | ((i & 1) ? USB_BD_DATA1 : USB_BD_DATA0);
+  }
+  e->data01 = e->pending & 1;
+
+  USB0->ENDPOINT[e->number].ENDPT &= ~USB_ENDPT_EPSTALL_Msk;
+  e->halted = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Waits for the next command block.
+static void receive_cbw() {
+  state = STATE_CBW;
+  queue(&bulk_out, NULL, cbw, BULK_SIZE);
+}
+
+//Sends the status block, once the bulk in endpoint isn't halted.
+static void send_csw() {
+  state = STATE_CSW;
+
+  if (bulk_in.halted) {
+    csw_pending = 1;
+    return;
+  }
+
+  csw_pending = 0;
+  put_le32(&csw[0], CSW_SIGNATURE);
+  put_le32(&csw[4], tag);
+  put_le32(&csw[8], host_length - data_done);
+  csw[12] = csw_status;
+  queue(&bulk_in, NULL, csw, CSW_LENGTH);
+}
+
+//Ends a command without data stage. If the host expected one, its endpoint is halted.
+static void no_data(uint8_t status) {
+  csw_status = status;
+  data_done = 0;
+  if (host_length > 0)
+    stall(host_in ? &bulk_in : &bulk_out);
+  send_csw();
+}
+
+//Ends a command with an error.
+static void fail(uint8_t key, uint8_t asc) {
+  sense_key = key;
+  sense_asc = asc;
+  no_data(CSW_FAILED);
+}
+
+//Drops the command in progress. A transfer the card may be running is left to end on its own.
+static void abort_command() {
+  cancel(&bulk_in);
+  cancel(&bulk_out);
+
+  buffers[0].state = (buffers[0].state == BUFFER_CARD) ? BUFFER_CARD : BUFFER_FREE;
+  buffers[1].state = (buffers[1].state == BUFFER_CARD) ? BUFFER_CARD : BUFFER_FREE;
+  if (card_active)
+    card_stale = 1;
+  card_retry = 0;
+  USB0->INTEN &= ~USB_ISTAT_SOFTOK_Msk;
+
+  csw_pending = 0;
+  state = configuration ? STATE_CBW : STATE_IDLE;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Queues packets of the data in stage, as long as banks and data ready to send are available.
+static void in_fill() {
+  struct buffer *b;
+  uint16_t size;
+
+  while (bulk_in.pending < 2 && data_queued < data_total) {
+    b = usb_buffer;
+    if (b->state != BUFFER_HOST || b->queued == b->length)
+      break;
+
+    size = (b->length - b->queued > BULK_SIZE) ? BULK_SIZE : b->length - b->queued;
+    queue(&bulk_in, b, b->data + b->queued, size);
+    b->queued += size;
+    data_queued += size;
+
+    if (b->queued == b->length && b != &reply)
+      usb_buffer = other(b);
+  }
+}
+
+//Ends the data in stage. If the host expected more data, the bulk in endpoint is halted.
+static void end_in() {
+  if (data_done < host_length)
+    stall(&bulk_in);
+  send_csw();
+}
+
+//Accounts for a packet sent.
+static void in_done(struct buffer *b, uint16_t size) {
+  b->done += size;
+  data_done += size;
+
+  if (b->done == b->length) {
+    b->state = BUFFER_FREE;
+    if (b != &reply)
+      sd_next();
+  }
+
+  if (data_done == data_total)
+    end_in();
+  else
+    in_fill();
+}
+
+//Queues banks for the data out stage, as long as banks and buffer space are available.
+static void out_fill() {
+  struct buffer *b;
+  uint16_t size;
+
+  while (bulk_out.pending < 2 && data_queued < data_total) {
+    b = usb_buffer;
+    if (b->state == BUFFER_FREE) {
+      b->state = BUFFER_HOST;
+      b->length = (data_total - data_queued > BUFFER_SIZE) ? BUFFER_SIZE : data_total - data_queued;
+      b->queued = 0;
+      b->done = 0;
+    } else if (b->state != BUFFER_HOST || b->queued == b->length) {
+      break;
+    }
+
+    size = (b->length - b->queued > BULK_SIZE) ? BULK_SIZE : b->length - b->queued;
+    queue(&bulk_out, b, b->data + b->queued, size);
+    b->queued += size;
+    data_queued += size;
+
+    if (b->queued == b->length)
+      usb_buffer = other(b);
+  }
+}
+
+//Ends the data out stage. If the host had more data to send, the bulk out endpoint is halted.
+static void end_out() {
+  if (data_done < host_length)
+    stall(&bulk_out);
+  send_csw();
+}
+
+//Accounts for a packet received.
+static void out_done(struct buffer *b, uint16_t size) {
+  b->done += size;
+  data_done += size;
+
+  if (b->done == b->length) {
+    b->state = BUFFER_FULL;
+    sd_next();
+  }
+
+  out_fill();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Handles the end of a card transfer on a buffer.
+static void card_done(struct buffer *b, int status) {
+  if (!writing) {
+    //On read errors, the data stage is cut short to the data already queued.
+    if (status != SDCARD_OK) {
+      b->state = BUFFER_FREE;
+      blocks_left = 0;
+      sense_key = SENSE_MEDIUM_ERROR;
+      sense_asc = ASC_READ_ERROR;
+      csw_status = CSW_FAILED;
+      data_total = data_queued;
+      if (data_done == data_total)
+        end_in();
+      return;
+    }
+
+    b->state = BUFFER_HOST;
+    card_buffer = other(b);
+    in_fill();
+    sd_next();
+    return;
+  }
+
+  //On write errors, the rest of the data is still received, but no longer written.
+  if (status != SDCARD_OK && !card_failed) {
+    card_failed = 1;
+    sense_key = SENSE_MEDIUM_ERROR;
+    sense_asc = ASC_WRITE_ERROR;
+    csw_status = CSW_FAILED;
+  }
+
+  b->state = BUFFER_FREE;
+  card_buffer = other(b);
+  out_fill();
+  sd_next();
+
+  if (state == STATE_DATA_OUT && data_done == data_total && !card_active &&
+      buffers[0].state == BUFFER_FREE && buffers[1].state == BUFFER_FREE)
+    end_out();
+}
+
+//Completion callback of the card transfers.
+static void sd_callback(int status, void *ptr) {
+  struct buffer *b = ptr;
+
+  card_active = 0;
+
+  if (card_stale) {
+    card_stale = 0;
+    b->state = BUFFER_FREE;
+    if (state == STATE_DATA_OUT)
+      out_fill();
+    sd_next();
+    return;
+  }
+
+  card_done(b, status);
+}
+
+//Starts the next card transfer of the data stage, if due. When the application holds the card,
+//the transfer is retried on the next start of frame.
+static void sd_next() {
+  struct buffer *b = card_buffer;
+  uint16_t count;
+  int result;
+
+  if (card_active)
+    return;
+
+  if (state == STATE_DATA_IN && !writing) {
+    if (blocks_left == 0 || b->state != BUFFER_FREE)
+      return;
+
+    count = (blocks_left > USB_MSC_BUFFER_BLOCKS) ? USB_MSC_BUFFER_BLOCKS : blocks_left;
+    b->length = count * SDCARD_BLOCK_SIZE;
+    b->queued = 0;
+    b->done = 0;
+    result = sdcard_start(block, b->data, count, SDCARD_READ, sd_callback, b);
+    if (result == SDCARD_ERR_BUSY) {
+      card_retry = 1;
+      USB0->INTEN |= USB_ISTAT_SOFTOK_Msk;
+      return;
+    }
+    blocks_left -= count;
+  } else if (state == STATE_DATA_OUT) {
+    if (b->state != BUFFER_FULL)
+      return;
+
+    count = b->length / SDCARD_BLOCK_SIZE;
+    result = card_failed ? SDCARD_ERR_IO :
+             sdcard_start(block, b->data, count, SDCARD_WRITE | SDCARD_FORCE, sd_callback, b);
+    if (result == SDCARD_ERR_BUSY) {
+      card_retry = 1;
+      USB0->INTEN |= USB_ISTAT_SOFTOK_Msk;
+      return;
+    }
+  } else {
+    return;
+  }
+
+  block += count;
+  b->state = BUFFER_CARD;
+
+  if (result == SDCARD_OK)
+    card_active = 1;
+  else
+    card_done(b, result);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Returns nonzero if the host can access the card.
+static int present() {
+  return !ejected && sdcard_blocks() > 0;
+}
+
+//Sends a response from the reply buffer, up to the length expected by the host.
+static void send_reply(uint32_t length) {
+  if (!host_in && host_length > 0) {
+    no_data(CSW_PHASE_ERROR);
+    return;
+  }
+  if (length > host_length)
+    length = host_length;
+  if (length == 0) {
+    no_data(CSW_PASSED);
+    return;
+  }
+
+  reply.state = BUFFER_HOST;
+  reply.length = length;
+  reply.queued = 0;
+  reply.done = 0;
+
+  state = STATE_DATA_IN;
+  csw_status = CSW_PASSED;
+  data_total = length;
+  data_queued = 0;
+  data_done = 0;
+  usb_buffer = &reply;
+  in_fill();
+}
+
+//Starts reading blocks for the host.
+static void start_read(uint32_t lba, uint16_t count) {
+  uint32_t length = (uint32_t) count * SDCARD_BLOCK_SIZE;
+
+  if (!host_in || host_length < length) {
+    no_data(CSW_PHASE_ERROR);
+    return;
+  }
+
+  state = STATE_DATA_IN;
+  writing = 0;
+  csw_status = CSW_PASSED;
+  data_total = length;
+  data_queued = 0;
+  data_done = 0;
+  block = lba;
+  blocks_left = count;
+  usb_buffer = &buffers[0];
+  card_buffer = &buffers[0];
+  sd_next();
+}
+
+//Starts receiving blocks to write from the host.
+static void start_write(uint32_t lba, uint16_t count) {
+  uint32_t length = (uint32_t) count * SDCARD_BLOCK_SIZE;
+
+  if (host_in || host_length < length) {
+    no_data(CSW_PHASE_ERROR);
+    return;
+  }
+
+  state = STATE_DATA_OUT;
+  writing = 1;
+  card_failed = 0;
+  csw_status = CSW_PASSED;
+  data_total = length;
+  data_queued = 0;
+  data_done = 0;
+  block = lba;
+  usb_buffer = &buffers[0];
+  card_buffer = &buffers[0];
+  out_fill();
+}
+
+//Runs a SCSI command.
+static void scsi_command(const uint8_t *cdb) {
+  uint32_t capacity = present() ? sdcard_blocks() : 0;
+  uint32_t lba;
+  uint16_t count;
+
+  switch (cdb[0]) {
+    case SCSI_TEST_UNIT_READY:
+    case SCSI_VERIFY_10:
+    case SCSI_SYNCHRONIZE_CACHE_10:
+      if (capacity == 0)
+        fail(SENSE_NOT_READY, ASC_MEDIUM_NOT_PRESENT);
+      else
+        no_data(CSW_PASSED);
+      break;
+
+    case SCSI_REQUEST_SENSE:
+      memset(reply_data, 0, 18);
+      reply_data[0] = 0x70;             //Current error, fixed format
+      reply_data[2] = sense_key;
+      reply_data[7] = 10;               //Additional sense length
+      reply_data[12] = sense_asc;
+      sense_key = SENSE_NONE;
+      sense_asc = ASC_NONE;
+      send_reply((cdb[4] < 18) ? cdb[4] : 18);
+      break;
+
+    case SCSI_INQUIRY:
+      //Vital product data pages aren't supported.
+      if (cdb[1] & 0x01) {
+        fail(SENSE_ILLEGAL_REQUEST, ASC_INVALID_FIELD);
+        break;
+      }
+      memcpy(reply_data, inquiry_response, sizeof(inquiry_response));
+      count = get_be16(&cdb[3]);
+      send_reply((count < sizeof(inquiry_response)) ? count : sizeof(inquiry_response));
+      break;
+
+    case SCSI_MODE_SENSE_6:
+      //Header only: no pages, not write protected.
+      memset(reply_data, 0, 4);
+      reply_data[0] = 3;
+      send_reply((cdb[4] < 4) ? cdb[4] : 4);
+      break;
+
+    case SCSI_MODE_SENSE_10:
+      memset(reply_data, 0, 8);
+      reply_data[1] = 6;
+      count = get_be16(&cdb[7]);
+      send_reply((count < 8) ? count : 8);
+      break;
+
+    case SCSI_START_STOP_UNIT:
+      //Eject (or load) when asked to.
+      if (cdb[4] & 0x02) {
+        ejected = (cdb[4] & 0x01) ? 0 : 1;
+        update_mount();
+      }
+      no_data(CSW_PASSED);
+      break;
+
+    case SCSI_PREVENT_ALLOW_REMOVAL:
+      no_data(CSW_PASSED);
+      break;
+
+    case SCSI_READ_FORMAT_CAPACITIES:
+      if (capacity == 0) {
+        fail(SENSE_NOT_READY, ASC_MEDIUM_NOT_PRESENT);
+        break;
+      }
+      memset(reply_data, 0, 12);
+      reply_data[3] = 8;                //Capacity list length
+      put_be32(&reply_data[4], capacity);
+      put_be32(&reply_data[8], (0x02 << 24) | SDCARD_BLOCK_SIZE);   //Formatted media
+      count = get_be16(&cdb[7]);
+      send_reply((count < 12) ? count : 12);
+      break;
+
+    case SCSI_READ_CAPACITY_10:
+      if (capacity == 0) {
+        fail(SENSE_NOT_READY, ASC_MEDIUM_NOT_PRESENT);
+        break;
+      }
+      put_be32(&reply_data[0], capacity - 1);
+      put_be32(&reply_data[4], SDCARD_BLOCK_SIZE);
+      send_reply(8);
+      break;
+
+    case SCSI_READ_10:
+    case SCSI_WRITE_10:
+      if (capacity == 0) {
+        fail(SENSE_NOT_READY, ASC_MEDIUM_NOT_PRESENT);
+        break;
+      }
+      lba = get_be32(&cdb[2]);
+      count = get_be16(&cdb[7]);
+      if (lba >= capacity || count > capacity - lba)
+        fail(SENSE_ILLEGAL_REQUEST, ASC_LBA_OUT_OF_RANGE);
+      else if (count == 0)
+        no_data(CSW_PASSED);
+      else if (cdb[0] == SCSI_READ_10)
+        start_read(lba, count);
+      else
+        start_write(lba, count);
+      break;
+
+    default:
+      fail(SENSE_ILLEGAL_REQUEST, ASC_INVALID_COMMAND);
+      break;
+  }
+}
+
+//Handles a command block.
+static void command(uint16_t size) {
+  //An invalid block halts both endpoints until the host resets the transport.
+  if (size != CBW_LENGTH || get_le32(&cbw[0]) != CBW_SIGNATURE) {
+    state = STATE_RESET;
+    stall(&bulk_in);
+    stall(&bulk_out);
+    return;
+  }
+
+  tag = get_le32(&cbw[4]);
+  host_length = get_le32(&cbw[8]);
+  host_in = (cbw[12] & 0x80) ? 1 : 0;
+  scsi_command(&cbw[15]);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+//Sends the next packet of the data stage of a control transfer.
+static void ep0_send() {
+  uint16_t size = (ep0_left > EP0_SIZE) ? EP0_SIZE : ep0_left;
+  volatile struct USB_BD_type *bd = &bdt[USB_BDT_Index(0, 1, ep0_odd)];
+
+  bd->ADDR = (uint32_t) ep0_data;
+  bd->DESC = ((uint32_t) size << USB_BD_BC_Pos) | (ep0_data01 ? USB_BD_DATA1 : USB_BD_DATA0) |
+             USB_BD_DTS_Msk | USB_BD_OWN_Msk;
+
+  ep0_odd ^= 1;
+  ep0_data01 ^= 1;
+  ep0_pending = 1;
+  ep0_data += size;
+  ep0_left -= size;
+}
+
+//Starts the data stage of a control transfer (or the status stage, if there's no data). A data
+//stage shorter than requested that ends on a full packet needs a zero length packet after it.
+static void ep0_transmit(const uint8_t *data, uint16_t length, uint16_t requested) {
+  if (length > requested)
+    length = requested;
+
+  ep0_data = data;
+  ep0_left = length;
+  ep0_zlp = length > 0 && length < requested && (length % EP0_SIZE) == 0;
+  ep0_send();
+}
+
+//Builds a string descriptor from an ASCII string, on the reply buffer of endpoint 0.
+static uint16_t string_descriptor(const char *s) {
+  uint8_t i;
+
+  for (i = 0; s[i] != '\0' && i < (EP0_SIZE - 2) / 2; i++) {
+    ep0_reply[2 + i * 2] = s[i];
+    ep0_reply[3 + i * 2] = 0;
+  }
+  ep0_reply[0] = 2 + i * 2;
+  ep0_reply[1] = DESC_STRING;
+
+  return ep0_reply[0];
+}
+
+//Returns the bulk endpoint with the given address, if configured.
+static struct endpoint *bulk_endpoint(uint16_t address) {
+  if (configuration == 0)
+    return NULL;
+  if (address == (0x80 | EP_IN))
+    return &bulk_in;
+  if (address == EP_OUT)
+    return &bulk_out;
+  return NULL;
+}
+
+//Sets the configuration.
+static void configure(uint8_t value) {
+  abort_command();
+  configuration = value;
+
+  if (value) {
+    USB0->ENDPOINT[EP_IN].ENDPT = USB_ENDPT_EPTXEN_Enabled | USB_ENDPT_EPHSHK_Enabled |
+                                  USB_ENDPT_EPCTLDIS_Disabled;
+    USB0->ENDPOINT[EP_OUT].ENDPT = USB_ENDPT_EPRXEN_Enabled | USB_ENDPT_EPHSHK_Enabled |
+                                   USB_ENDPT_EPCTLDIS_Disabled;
+    bulk_in.data01 = 0;
+    bulk_in.halted = 0;
+    bulk_out.data01 = 0;
+    bulk_out.halted = 0;
+    receive_cbw();
+  } else {
+    USB0->ENDPOINT[EP_IN].ENDPT = 0;
+    USB0->ENDPOINT[EP_OUT].ENDPT = 0;
+    state = STATE_IDLE;
+  }
+
+  update_mount();
+}
+
+//Handles a setup packet.
+static void setup(const uint8_t *packet) {
+  uint16_t request = get_le16(&packet[0]);
+  uint16_t value = get_le16(&packet[2]);
+  uint16_t index = get_le16(&packet[4]);
+  uint16_t length = get_le16(&packet[6]);
+  const uint8_t *data = NULL;
+  uint16_t size = 0;
+  struct endpoint *e;
+
+  switch (request) {
+    case REQ_GET_DEVICE_STATUS:
+    case REQ_GET_INTERFACE_STATUS:
+      ep0_reply[0] = 0;
+      ep0_reply[1] = 0;
+      data = ep0_reply;
+      size = 2;
+      break;
+
+    case REQ_GET_ENDPOINT_STATUS:
+      e = bulk_endpoint(index);
+      if (e == NULL && index != 0 && index != 0x80)
+        goto stall;
+      ep0_reply[0] = (e != NULL) ? e->halted : 0;
+      ep0_reply[1] = 0;
+      data = ep0_reply;
+      size = 2;
+      break;
+
+    case REQ_CLEAR_ENDPOINT_FEATURE:
+      e = bulk_endpoint(index);
+      if (e == NULL || value != FEATURE_ENDPOINT_HALT)
+        goto stall;
+      //Both endpoints stay halted after an invalid command block, until the transport reset.
+      if (state != STATE_RESET) {
+        unstall(e);
+        if (e == &bulk_in && csw_pending)
+          send_csw();
+      }
+      break;
+
+    case REQ_SET_ENDPOINT_FEATURE:
+      e = bulk_endpoint(index);
+      if (e == NULL || value != FEATURE_ENDPOINT_HALT)
+        goto stall;
+      stall(e);
+      break;
+
+    case REQ_SET_ADDRESS:
+      //Takes effect after the status stage.
+      address = value & 0x7F;
+      break;
+
+    case REQ_GET_DESCRIPTOR:
+      switch (value >> 8) {
+        case DESC_DEVICE:
+          data = device_descriptor;
+          size = sizeof(device_descriptor);
+          break;
+        case DESC_CONFIGURATION:
+          data = configuration_descriptor;
+          size = sizeof(configuration_descriptor);
+          break;
+        case DESC_STRING:
+          data = ep0_reply;
+          switch (value & 0xFF) {
+            case 0:
+              data = language_descriptor;
+              size = sizeof(language_descriptor);
+              break;
+            case 1:
+              size = string_descriptor(manufacturer_string);
+              break;
+            case 2:
+              size = string_descriptor(product_string);
+              break;
+            case 3:
+              size = string_descriptor(serial_string);
+              break;
+            default:
+              goto stall;
+          }
+          break;
+        default:
+          goto stall;
+      }
+      break;
+
+    case REQ_GET_CONFIGURATION:
+      ep0_reply[0] = configuration;
+      data = ep0_reply;
+      size = 1;
+      break;
+
+    case REQ_SET_CONFIGURATION:
+      if (value > 1)
+        goto stall;
+      configure(value);
+      break;
+
+    case REQ_GET_INTERFACE:
+      if (configuration == 0 || index != 0)
+        goto stall;
+      ep0_reply[0] = 0;
+      data = ep0_reply;
+      size = 1;
+      break;
+
+    case REQ_SET_INTERFACE:
+      if (configuration == 0 || index != 0 || value != 0)
+        goto stall;
+      break;
+
+    case REQ_MSC_RESET:
+      if (configuration == 0 || index != 0)
+        goto stall;
+      abort_command();
+      receive_cbw();
+      break;
+
+    case REQ_MSC_GET_MAX_LUN:
+      if (configuration == 0 || index != 0)
+        goto stall;
+      ep0_reply[0] = 0;
+      data = ep0_reply;
+      size = 1;
+      break;
+
+    default:
+      goto stall;
+  }
+
+  ep0_transmit(data, size, length);
+  return;
+
+stall:
+  //The halt lasts until the next setup packet.
+  USB0->ENDPOINT[0].ENDPT = EP0_CONFIG | USB_ENDPT_EPSTALL_Msk;
+}
+
+//Handles a transaction of endpoint 0.
+static void ep0_token(volatile struct USB_BD_type *bd, uint8_t tx) {
+  uint8_t packet[8];
+
+  if (tx) {
+    ep0_pending = 0;
+
+    //Apply a new address once the status stage of its request is done.
+    if (USB0->ADDR != address)
+      USB0->ADDR = address;
+
+    if (ep0_left > 0 || ep0_zlp) {
+      if (ep0_left == 0)
+        ep0_zlp = 0;
+      ep0_send();
+    }
+    return;
+  }
+
+  //Setup packets drop whatever was left of the previous control transfer. The USB module suspends
+  //token processing when it receives one, until released.
+  if (((bd->DESC & USB_BD_TOK_PID_Msk) >> USB_BD_TOK_PID_Pos) == USB_PID_SETUP) {
+    memcpy(packet, (const void *) bd->ADDR, sizeof(packet));
+    bd->DESC = (EP0_SIZE << USB_BD_BC_Pos) | USB_BD_DATA1 | USB_BD_DTS_Msk | USB_BD_OWN_Msk;
+
+    if (ep0_pending) {
+      ep0_odd ^= 1;
+      bdt[USB_BDT_Index(0, 1, ep0_odd)].DESC = 0;
+      ep0_pending = 0;
+    }
+    ep0_left = 0;
+    ep0_zlp = 0;
+    ep0_data01 = 1;
+    USB0->ENDPOINT[0].ENDPT = EP0_CONFIG;
+
+    setup(packet);
+    USB0->CTL = USB_CTL_USBENSOFEN_Enabled;
+    return;
+  }
+
+  //Status stage of a control read (no request used has an out data stage).
+  bd->DESC = (EP0_SIZE << USB_BD_BC_Pos) | USB_BD_DATA1 | USB_BD_DTS_Msk | USB_BD_OWN_Msk;
+}
+
+//Handles a finished transaction.
+static void token(uint8_t stat) {
+  uint8_t ep = (stat & USB_STAT_ENDP_Msk) >> USB_STAT_ENDP_Pos;
+  uint8_t tx = (stat & USB_STAT_TX_Msk) ? 1 : 0;
+  uint8_t odd = (stat & USB_STAT_ODD_Msk) ? 1 : 0;
+  volatile struct USB_BD_type *bd = &bdt[USB_BDT_Index(ep, tx, odd)];
+  uint16_t size = (bd->DESC & USB_BD_BC_Msk) >> USB_BD_BC_Pos;
+  struct buffer *b;
+
+  if (ep == 0) {
+    ep0_token(bd, tx);
+  } else if (ep == EP_IN && tx) {
+    bulk_in.pending--;
+    b = bulk_in.owner[odd];
+    if (b == NULL)
+      receive_cbw();
+    else if (state == STATE_DATA_IN)
+      in_done(b, size);
+  } else if (ep == EP_OUT && !tx) {
+    bulk_out.pending--;
+    b = bulk_out.owner[odd];
+    if (b == NULL)
+      command(size);
+    else if (state == STATE_DATA_OUT)
+      out_done(b, size);
+  }
+}
+
+//Handles a bus reset, returning to the default state.
+static void bus_reset() {
+  abort_command();
+
+  //Reset all endpoints to their even banks, and wait for setup packets on endpoint 0.
+  USB0->CTL = USB_CTL_ODDRST_Msk;
+  memset(bdt, 0, sizeof(bdt));
+  bdt[USB_BDT_Index(0, 0, 0)].ADDR = (uint32_t) ep0_rx[0];
+  bdt[USB_BDT_Index(0, 0, 0)].DESC = (EP0_SIZE << USB_BD_BC_Pos) | USB_BD_DTS_Msk | USB_BD_OWN_Msk;
+  bdt[USB_BDT_Index(0, 0, 1)].ADDR = (uint32_t) ep0_rx[1];
+  bdt[USB_BDT_Index(0, 0, 1)].DESC = (EP0_SIZE << USB_BD_BC_Pos) | USB_BD_DTS_Msk | USB_BD_OWN_Msk;
+  ep0_odd = 0;
+  ep0_pending = 0;
+  ep0_left = 0;
+  ep0_zlp = 0;
+  bulk_in.odd = 0;
+  bulk_out.odd = 0;
+
+  USB0->ENDPOINT[0].ENDPT = EP0_CONFIG;
+  USB0->ENDPOINT[EP_IN].ENDPT = 0;
+  USB0->ENDPOINT[EP_OUT].ENDPT = 0;
+  USB0->ADDR = 0;
+  address = 0;
+  configuration = 0;
+  state = STATE_IDLE;
+  ejected = 0;
+  suspended = 0;
+  update_mount();
+
+  USB0->ERRSTAT = 0xFF;
+  USB0->ISTAT = 0xFF;
+  USB0->ERREN = 0xFF;
+  USB0->INTEN = USB_ISTAT_USBRST_Msk | USB_ISTAT_ERROR_Msk | USB_ISTAT_TOKDNE_Msk |
+                USB_ISTAT_SLEEP_Msk | USB_ISTAT_STALL_Msk;
+  USB0->CTL = USB_CTL_USBENSOFEN_Enabled;
+}
+
+//Builds the serial number string from the unique identification of the MCU.
+static void make_serial() {
+  uint32_t words[2] = { SIM->UIDML, SIM->UIDL };
+  uint8_t i, digit;
+
+  for (i = 0; i < 16; i++) {
+    digit = (words[i / 8] >> (28 - (i % 8) * 4)) & 0xF;
+    serial_string[i] = (digit < 10) ? '0' + digit : 'A' + digit - 10;
+  }
+  serial_string[16] = '\0';
+}
+
+//Initializes the USB module and attaches to the bus. The calling process gets the mount events.
+void usb_msc_init() {
+  requester = PROCESS_CURRENT();
+
+  if (usb_msc_event == 0) {
+    usb_msc_event = process_alloc_event();
+    process_start(&usb_msc_process, NULL);
+  }
+
+  make_serial();
+
+  //48MHz can't be derived from the 180MHz PLL, so the USB module runs from the IRC48M instead,
+  //kept in trim by the start of frame packets of the host. Enable its clock and let it access
+  //memory as a bus master.
+  SIM->SOPT2 |= SIM_SOPT2_USBSRC_Internal | SIM_SOPT2_PLLFLLSEL_IRC48;
+  SIM->CLKDIV2 = (0 << SIM_CLKDIV2_USBDIV_Pos) | (0 << SIM_CLKDIV2_USBFRAC_Pos);
+  SIM->SCGC4 |= SIM_SCGC4_USBOTG_Enabled;
+  SYSMPU->RGDAAC[0] |= SYSMPU_RGDAAC_M4WE_Msk | SYSMPU_RGDAAC_M4RE_Msk;
+
+  NVIC_DisableIRQ(USBFS_OTG_IRQn);
+
+  //Reset the module and start the clock recovery.
+  USB0->USBTRC0 = USB_USBTRC0_USBRESET_Msk;
+  while (USB0->USBTRC0 & USB_USBTRC0_USBRESET_Msk);
+  USB0->CLK_RECOVER_IRC_EN = USB_CLK_RECOVER_IRC_EN_REG_EN_Enabled |
+                             USB_CLK_RECOVER_IRC_EN_IRC_EN_Enabled;
+  USB0->CLK_RECOVER_CTRL = USB_CLK_RECOVER_CTRL_CLOCK_RECOVER_EN_Enabled |
+                           USB_CLK_RECOVER_CTRL_RESTART_IFRTRIM_EN_Enabled;
+
+  //Set up device mode, waiting for the first bus reset.
+  USB0->BDTPAGE1 = (uint32_t) bdt >> 8;
+  USB0->BDTPAGE2 = (uint32_t) bdt >> 16;
+  USB0->BDTPAGE3 = (uint32_t) bdt >> 24;
+  USB0->ISTAT = 0xFF;
+  USB0->ERRSTAT = 0xFF;
+  USB0->OTGISTAT = 0xFF;
+  USB0->USBTRC0 |= USB_USBTRC0_Reserved_Set;
+  USB0->CTL = USB_CTL_USBENSOFEN_Enabled;
+  USB0->USBCTRL = USB_USBCTRL_PDE_Disabled | USB_USBCTRL_SUSP_Disabled;
+  USB0->INTEN = USB_ISTAT_USBRST_Msk;
+
+  NVIC_SetPriority(USBFS_OTG_IRQn, USB_MSC_PRIORITY);
+  NVIC_EnableIRQ(USBFS_OTG_IRQn);
+
+  //Signal the attachment to the host with the pullup on D+.
+  USB0->CONTROL = USB_CONTROL_DPPULLUPNONOTG_Enabled;
+}
+
+//Returns nonzero while the host has the disk mounted.
+int usb_msc_mounted() {
+  return mounted;
+}
+
+void usbfs_otg_handler() {
+  uint8_t istat = USB0->ISTAT & USB0->INTEN;
+  uint8_t stat;
+
+  if (istat & USB_ISTAT_USBRST_Msk) {
+    bus_reset();
+    return;
+  }
+
+  //Finished transactions queue up in the status register, one per token done flag clear.
+  while (USB0->ISTAT & USB_ISTAT_TOKDNE_Msk) {
+    stat = USB0->STAT;
+    USB0->ISTAT = USB_ISTAT_TOKDNE_Msk;
+    token(stat);
+  }
+
+  if (istat & USB_ISTAT_SOFTOK_Msk) {
+    USB0->ISTAT = USB_ISTAT_SOFTOK_Msk;
+    USB0->INTEN &= ~USB_ISTAT_SOFTOK_Msk;
+    if (card_retry) {
+      card_retry = 0;
+      sd_next();
+    }
+  }
+
+  //Halts of endpoint 0 only last for the request that caused them.
+  if (istat & USB_ISTAT_STALL_Msk) {
+    USB0->ISTAT = USB_ISTAT_STALL_Msk;
+    USB0->ENDPOINT[0].ENDPT = EP0_CONFIG;
+  }
+
+  if (istat & USB_ISTAT_ERROR_Msk) {
+    USB0->ERRSTAT = 0xFF;
+    USB0->ISTAT = USB_ISTAT_ERROR_Msk;
+  }
+
+  //The resume interrupt must be enabled only while suspended.
+  if (istat & USB_ISTAT_SLEEP_Msk) {
+    USB0->ISTAT = USB_ISTAT_SLEEP_Msk | USB_ISTAT_RESUME_Msk;
+    USB0->INTEN |= USB_ISTAT_RESUME_Msk;
+    suspended = 1;
+    update_mount();
+  }
+
+  if (istat & USB_ISTAT_RESUME_Msk) {
+    USB0->ISTAT = USB_ISTAT_RESUME_Msk;
+    USB0->INTEN &= ~USB_ISTAT_RESUME_Msk;
+    suspended = 0;
+    update_mount();
+  }
+}
+
+//Notifies the requester of mount state changes.
+PROCESS_THREAD(usb_msc_process, ev, data) {
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    process_post(requester, usb_msc_event, NULL);
+  }
+
+  PROCESS_END();
+}
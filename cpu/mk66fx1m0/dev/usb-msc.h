@@ -0,0 +1,59 @@
+//+------------------------------------------------------------------------------------------------+
+//| USB mass storage driver for Kinetis MK66 MCU.                                                  |
+//|                                                                                                |
+//| Exposes the SD card to the USB host as a removable disk, through the USB OTG full speed module |
+//| (the micro USB connector of the Teensy 3.6), using the bulk only transport and the SCSI        |
+//| transparent command set. The host gets to read and write the card while the node keeps         |
+//| running: everything happens in interrupt context, driven by the USB and SDHC interrupts.       |
+//|                                                                                                |
+//| Reads and writes go through two buffers of USB_MSC_BUFFER_BLOCKS blocks each, so the card      |
+//| fills one by DMA while the USB module (also a bus master) sends the other, and the other way   |
+//| around for writes. Packets are sent and received straight from and to these buffers. The card  |
+//| outruns full speed USB several times, so the transfer rate is the one of the bus (around 1MB/s |
+//| in practice). The application may still read the card meanwhile, interleaving its transfers    |
+//| with the ones of the host.                                                                     |
+//|                                                                                                |
+//| While the host has the disk mounted (configured, not ejected nor suspended), the card is write |
+//| protected for the application (see sdcard_protect()), since the host file system caches        |
+//| what's on it. The process that initialized the driver gets a usb_msc_event whenever this       |
+//| changes. The bus has no detection of cable removal, so unplugging shows up as a suspension.    |
+//|                                                                                                |
+//| The card must be initialized with sdcard_init() first. If it isn't present, the host sees an   |
+//| empty drive.                                                                                   |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef USB_MSC_H_
+#define USB_MSC_H_
+
+#include "contiki.h"
+
+//USB vendor and product IDs (the pid.codes test IDs by default).
+#ifdef USB_MSC_CONF_VENDOR_ID
+#define USB_MSC_VENDOR_ID USB_MSC_CONF_VENDOR_ID
+#else
+#define USB_MSC_VENDOR_ID 0x1209
+#endif
+
+#ifdef USB_MSC_CONF_PRODUCT_ID
+#define USB_MSC_PRODUCT_ID USB_MSC_CONF_PRODUCT_ID
+#else
+#define USB_MSC_PRODUCT_ID 0x0001
+#endif
+
+//Size of each transfer buffer, in blocks.
+#ifdef USB_MSC_CONF_BUFFER_BLOCKS
+#define USB_MSC_BUFFER_BLOCKS USB_MSC_CONF_BUFFER_BLOCKS
+#else
+#define USB_MSC_BUFFER_BLOCKS 8
+#endif
+
+//Event posted to the process that initialized the driver when the host mounts or releases the
+//disk.
+extern process_event_t usb_msc_event;
+
+void usb_msc_init();
+int usb_msc_mounted();
+
+#endif //USB_MSC_H_
@@ -0,0 +1,80 @@
+//+------------------------------------------------------------------------------------------------+
+//| High speed comparator registers for Kinetis MK66 MCU.                                          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_CMP_H_
+#define MK66_CMP_H_
+
+#include <stdint.h>
+
+struct CMP_type {
+  uint8_t CR0;            //CMP control register 0
+  uint8_t CR1;            //CMP control register 1
+  uint8_t FPR;            //CMP filter period register
+  uint8_t SCR;            //CMP status and control register
+  uint8_t DACCR;          //DAC control register
+  uint8_t MUXCR;          //MUX control register
+};
+
+#define CMP0 ((volatile struct CMP_type *) 0x40073000)
+#define CMP1 ((volatile struct CMP_type *) 0x40073008)
+#define CMP2 ((volatile struct CMP_type *) 0x40073010)
+#define CMP3 ((volatile struct CMP_type *) 0x40073018)
+
+//CMP control register 0 bitfields
+#define CMP_CR0_HYSTCTR_Msk       0x03        //Comparator hysteresis control
+#define CMP_CR0_HYSTCTR_Pos       0
+#define CMP_CR0_FILTER_CNT_Msk    0x70        //Filter sample count
+#define CMP_CR0_FILTER_CNT_Pos    4
+
+//CMP control register 1 bitfields
+#define CMP_CR1_EN_Disabled       (0 << 0)    //Comparator module enable
+#define CMP_CR1_EN_Enabled        (1 << 0)
+#define CMP_CR1_OPE_Disabled      (0 << 1)    //Comparator output pin enable
+#define CMP_CR1_OPE_Enabled       (1 << 1)
+#define CMP_CR1_COS_Filtered      (0 << 2)    //Comparator output select
+#define CMP_CR1_COS_Unfiltered    (1 << 2)
+#define CMP_CR1_INV_Disabled      (0 << 3)    //Comparator invert
+#define CMP_CR1_INV_Enabled       (1 << 3)
+#define CMP_CR1_PMODE_Low_Speed   (0 << 4)    //Power mode select
+#define CMP_CR1_PMODE_High_Speed  (1 << 4)
+#define CMP_CR1_TRIGM_Disabled    (0 << 5)    //Trigger mode enable
+#define CMP_CR1_TRIGM_Enabled     (1 << 5)
+#define CMP_CR1_WE_Disabled       (0 << 6)    //Windowing enable
+#define CMP_CR1_WE_Enabled        (1 << 6)
+#define CMP_CR1_SE_Disabled       (0 << 7)    //Sample enable
+#define CMP_CR1_SE_Enabled        (1 << 7)
+
+//CMP status and control register bitfields
+#define CMP_SCR_COUT_Msk          (1 << 0)    //Analog comparator output
+#define CMP_SCR_CFF_Msk           (1 << 1)    //Analog comparator flag falling
+#define CMP_SCR_CFF_Clear         (1 << 1)
+#define CMP_SCR_CFR_Msk           (1 << 2)    //Analog comparator flag rising
+#define CMP_SCR_CFR_Clear         (1 << 2)
+#define CMP_SCR_IEF_Disabled      (0 << 3)    //Comparator interrupt enable falling
+#define CMP_SCR_IEF_Enabled       (1 << 3)
+#define CMP_SCR_IER_Disabled      (0 << 4)    //Comparator interrupt enable rising
+#define CMP_SCR_IER_Enabled       (1 << 4)
+#define CMP_SCR_DMAEN_Disabled    (0 << 6)    //DMA enable control
+#define CMP_SCR_DMAEN_Enabled     (1 << 6)
+
+//DAC control register bitfields
+#define CMP_DACCR_VOSEL_Msk       0x3F        //DAC output voltage select
+#define CMP_DACCR_VOSEL_Pos       0
+#define CMP_DACCR_VRSEL_Vin1      (0 << 6)    //Supply voltage reference source select
+#define CMP_DACCR_VRSEL_Vin2      (1 << 6)
+#define CMP_DACCR_DACEN_Disabled  (0 << 7)    //DAC enable
+#define CMP_DACCR_DACEN_Enabled   (1 << 7)
+
+//MUX control register bitfields
+#define CMP_MUXCR_MSEL_Msk        0x07        //Minus input mux control
+#define CMP_MUXCR_MSEL_Pos        0
+#define CMP_MUXCR_PSEL_Msk        0x38        //Plus input mux control
+#define CMP_MUXCR_PSEL_Pos        3
+
+//Input mux channel of the internal DAC.
+#define CMP_INPUT_DAC 7
+
+#endif //MK66_CMP_H_
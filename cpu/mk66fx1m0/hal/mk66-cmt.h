@@ -0,0 +1,62 @@
+//+------------------------------------------------------------------------------------------------+
+//| Carrier modulator transmitter registers for Kinetis MK66 MCU.                                  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_CMT_H_
+#define MK66_CMT_H_
+
+#include <stdint.h>
+
+struct CMT_type {
+  uint8_t CGH1;           //Carrier generator high data register 1
+  uint8_t CGL1;           //Carrier generator low data register 1
+  uint8_t CGH2;           //Carrier generator high data register 2
+  uint8_t CGL2;           //Carrier generator low data register 2
+  uint8_t OC;             //Output control register
+  uint8_t MSC;            //Modulator status and control register
+  uint8_t CMD1;           //Modulator data register mark high
+  uint8_t CMD2;           //Modulator data register mark low
+  uint8_t CMD3;           //Modulator data register space high
+  uint8_t CMD4;           //Modulator data register space low
+  uint8_t PPS;            //Primary prescaler register
+  uint8_t DMA;            //Direct memory access register
+};
+
+#define CMT ((volatile struct CMT_type *) 0x40062000)
+
+//Output control register bitfields
+#define CMT_OC_IROPEN_Disabled  (0 << 5)    //IRO pin enable
+#define CMT_OC_IROPEN_Enabled   (1 << 5)
+#define CMT_OC_CMTPOL_Low       (0 << 6)    //CMT output polarity (active level)
+#define CMT_OC_CMTPOL_High      (1 << 6)
+#define CMT_OC_IROL_Low         (0 << 7)    //IRO latch control
+#define CMT_OC_IROL_High        (1 << 7)
+
+//Modulator status and control register bitfields
+#define CMT_MSC_MCGEN_Disabled  (0 << 0)    //Modulator and carrier generator enable
+#define CMT_MSC_MCGEN_Enabled   (1 << 0)
+#define CMT_MSC_EOCIE_Disabled  (0 << 1)    //End of cycle interrupt enable
+#define CMT_MSC_EOCIE_Enabled   (1 << 1)
+#define CMT_MSC_FSK_Time        (0 << 2)    //FSK mode select
+#define CMT_MSC_FSK_FSK         (1 << 2)
+#define CMT_MSC_BASE_Disabled   (0 << 3)    //Baseband enable
+#define CMT_MSC_BASE_Enabled    (1 << 3)
+#define CMT_MSC_EXSPC_Disabled  (0 << 4)    //Extended space enable
+#define CMT_MSC_EXSPC_Enabled   (1 << 4)
+#define CMT_MSC_CMTDIV_Div1     (0 << 5)    //CMT clock divide prescaler
+#define CMT_MSC_CMTDIV_Div2     (1 << 5)
+#define CMT_MSC_CMTDIV_Div4     (2 << 5)
+#define CMT_MSC_CMTDIV_Div8     (3 << 5)
+#define CMT_MSC_EOCF_Msk        (1 << 7)    //End of cycle status flag
+
+//Primary prescaler register bitfields
+#define CMT_PPS_PPSDIV_Msk      0x0F        //Primary prescaler divider (divides by PPSDIV + 1)
+#define CMT_PPS_PPSDIV_Pos      0
+
+//Direct memory access register bitfields
+#define CMT_DMA_DMA_Interrupt   (0 << 0)    //DMA enable (end of cycle requests DMA instead)
+#define CMT_DMA_DMA_DMA         (1 << 0)
+
+#endif //MK66_CMT_H_
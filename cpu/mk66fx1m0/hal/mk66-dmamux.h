@@ -0,0 +1,83 @@
+//+------------------------------------------------------------------------------------------------+
+//| DMAMUX (DMA request multiplexer) peripheral registers for Kinetis MK66 MCU.                    |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_DMAMUX_H_
+#define MK66_DMAMUX_H_
+
+#include <stdint.h>
+
+struct DMAMUX_type {
+  uint8_t CHCFG[32];      //Channel configuration registers
+};
+
+#define DMAMUX ((volatile struct DMAMUX_type *) 0x40021000)
+
+//Channel configuration register bitfields
+#define DMAMUX_CHCFG_SOURCE_Msk       0x3F      //DMA channel source (slot)
+#define DMAMUX_CHCFG_SOURCE_Pos       0
+#define DMAMUX_CHCFG_TRIG_Disabled    (0 << 6)  //DMA channel trigger enable
+#define DMAMUX_CHCFG_TRIG_Enabled     (1 << 6)
+#define DMAMUX_CHCFG_ENBL_Disabled    (0 << 7)  //DMA channel enable
+#define DMAMUX_CHCFG_ENBL_Enabled     (1 << 7)
+
+//DMA request sources
+#define DMAMUX_SOURCE_UART0_Rx        2
+#define DMAMUX_SOURCE_UART0_Tx        3
+#define DMAMUX_SOURCE_UART1_Rx        4
+#define DMAMUX_SOURCE_UART1_Tx        5
+#define DMAMUX_SOURCE_UART2_Rx        6
+#define DMAMUX_SOURCE_UART2_Tx        7
+#define DMAMUX_SOURCE_UART3_Rx        8
+#define DMAMUX_SOURCE_UART3_Tx        9
+#define DMAMUX_SOURCE_UART4           10
+#define DMAMUX_SOURCE_I2S0_Rx         12
+#define DMAMUX_SOURCE_I2S0_Tx         13
+#define DMAMUX_SOURCE_SPI0_Rx         14
+#define DMAMUX_SOURCE_SPI0_Tx         15
+#define DMAMUX_SOURCE_SPI1            16
+#define DMAMUX_SOURCE_SPI2            17
+#define DMAMUX_SOURCE_FTM0_CH0        20
+#define DMAMUX_SOURCE_FTM0_CH1        21
+#define DMAMUX_SOURCE_FTM0_CH2        22
+#define DMAMUX_SOURCE_FTM0_CH3        23
+#define DMAMUX_SOURCE_FTM0_CH4        24
+#define DMAMUX_SOURCE_FTM0_CH5        25
+#define DMAMUX_SOURCE_FTM0_CH6        26
+#define DMAMUX_SOURCE_FTM0_CH7        27
+#define DMAMUX_SOURCE_FTM1_CH0        28
+#define DMAMUX_SOURCE_FTM1_CH1        29
+#define DMAMUX_SOURCE_FTM2_CH0        30
+#define DMAMUX_SOURCE_FTM2_CH1        31
+#define DMAMUX_SOURCE_FTM3_CH0        32
+#define DMAMUX_SOURCE_FTM3_CH1        33
+#define DMAMUX_SOURCE_FTM3_CH2        34
+#define DMAMUX_SOURCE_FTM3_CH3        35
+#define DMAMUX_SOURCE_FTM3_CH4        36
+#define DMAMUX_SOURCE_FTM3_CH5        37
+#define DMAMUX_SOURCE_FTM3_CH6        38
+#define DMAMUX_SOURCE_FTM3_CH7        39
+#define DMAMUX_SOURCE_ADC0            40
+#define DMAMUX_SOURCE_ADC1            41
+#define DMAMUX_SOURCE_CMP0            42
+#define DMAMUX_SOURCE_CMP1            43
+#define DMAMUX_SOURCE_CMP2            44
+#define DMAMUX_SOURCE_DAC0            45
+#define DMAMUX_SOURCE_DAC1            46
+#define DMAMUX_SOURCE_CMT             47
+#define DMAMUX_SOURCE_PDB             48
+#define DMAMUX_SOURCE_PORTA           49
+#define DMAMUX_SOURCE_PORTB           50
+#define DMAMUX_SOURCE_PORTC           51
+#define DMAMUX_SOURCE_PORTD           52
+#define DMAMUX_SOURCE_PORTE           53
+#define DMAMUX_SOURCE_AlwaysOn0       58
+#define DMAMUX_SOURCE_AlwaysOn1       59
+#define DMAMUX_SOURCE_AlwaysOn2       60
+#define DMAMUX_SOURCE_AlwaysOn3       61
+#define DMAMUX_SOURCE_AlwaysOn4       62
+#define DMAMUX_SOURCE_AlwaysOn5       63
+
+#endif //MK66_DMAMUX_H_
@@ -0,0 +1,85 @@
+//+------------------------------------------------------------------------------------------------+
+//| FlexBus external bus interface registers for Kinetis MK66 MCU.                                 |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_FB_H_
+#define MK66_FB_H_
+
+#include <stdint.h>
+
+//Chip select registers.
+struct FB_CS_type {
+  uint32_t CSAR;          //Chip select address register
+  uint32_t CSMR;          //Chip select mask register
+  uint32_t CSCR;          //Chip select control register
+};
+
+struct FB_type {
+  struct FB_CS_type CS[6];
+  uint32_t reserved0[6];
+  uint32_t CSPMCR;        //Chip select port multiplexing control register
+};
+
+#define FB ((volatile struct FB_type *) 0x4000C000)
+
+//Chip select address register bitfields
+#define FB_CSAR_BA_Msk  0xFFFF0000  //Base address
+#define FB_CSAR_BA_Pos  16
+
+//Chip select mask register bitfields
+#define FB_CSMR_V_Invalid     (0 << 0)    //Valid
+#define FB_CSMR_V_Valid       (1 << 0)
+#define FB_CSMR_WP_Disabled   (0 << 8)    //Write protect
+#define FB_CSMR_WP_Enabled    (1 << 8)
+#define FB_CSMR_BAM_Msk       0xFFFF0000  //Base address mask
+#define FB_CSMR_BAM_Pos       16
+
+//Chip select control register bitfields
+#define FB_CSCR_BSTW_Disabled   (0 << 3)    //Burst write enable
+#define FB_CSCR_BSTW_Enabled    (1 << 3)
+#define FB_CSCR_BSTR_Disabled   (0 << 4)    //Burst read enable
+#define FB_CSCR_BSTR_Enabled    (1 << 4)
+#define FB_CSCR_BEM_Write       (0 << 5)    //Byte enable mode
+#define FB_CSCR_BEM_Read_Write  (1 << 5)
+#define FB_CSCR_PS_32Bit        (0 << 6)    //Port size
+#define FB_CSCR_PS_8Bit         (1 << 6)
+#define FB_CSCR_PS_16Bit        (2 << 6)
+#define FB_CSCR_AA_Disabled     (0 << 8)    //Auto acknowledge enable
+#define FB_CSCR_AA_Enabled      (1 << 8)
+#define FB_CSCR_BLS_Left        (0 << 9)    //Byte lane shift
+#define FB_CSCR_BLS_Right       (1 << 9)
+#define FB_CSCR_WS_Msk          0x0000FC00  //Wait states
+#define FB_CSCR_WS_Pos          10
+#define FB_CSCR_WRAH_Msk        0x00030000  //Write address hold or deselect
+#define FB_CSCR_WRAH_Pos        16
+#define FB_CSCR_RDAH_Msk        0x000C0000  //Read address hold or deselect
+#define FB_CSCR_RDAH_Pos        18
+#define FB_CSCR_ASET_Msk        0x00300000  //Address setup
+#define FB_CSCR_ASET_Pos        20
+#define FB_CSCR_EXTS_Disabled   (0 << 22)   //Extended transfer start/extended address latch enable
+#define FB_CSCR_EXTS_Enabled    (1 << 22)
+#define FB_CSCR_SWSEN_Disabled  (0 << 23)   //Secondary wait state enable
+#define FB_CSCR_SWSEN_Enabled   (1 << 23)
+#define FB_CSCR_SWS_Msk         0xFC000000  //Secondary wait states
+#define FB_CSCR_SWS_Pos         26
+
+//Chip select port multiplexing control register bitfields
+#define FB_CSPMCR_GROUP5_TA         (0 << 12)   //FlexBus signal group 5 multiplex control
+#define FB_CSPMCR_GROUP5_CS3        (1 << 12)
+#define FB_CSPMCR_GROUP5_BE7_0      (2 << 12)
+#define FB_CSPMCR_GROUP4_TBST       (0 << 16)   //FlexBus signal group 4 multiplex control
+#define FB_CSPMCR_GROUP4_CS2        (1 << 16)
+#define FB_CSPMCR_GROUP4_BE15_8     (2 << 16)
+#define FB_CSPMCR_GROUP3_CS5        (0 << 20)   //FlexBus signal group 3 multiplex control
+#define FB_CSPMCR_GROUP3_TSIZ1      (1 << 20)
+#define FB_CSPMCR_GROUP3_BE23_16    (2 << 20)
+#define FB_CSPMCR_GROUP2_CS4        (0 << 24)   //FlexBus signal group 2 multiplex control
+#define FB_CSPMCR_GROUP2_TSIZ0      (1 << 24)
+#define FB_CSPMCR_GROUP2_BE31_24    (2 << 24)
+#define FB_CSPMCR_GROUP1_ALE        (0 << 28)   //FlexBus signal group 1 multiplex control
+#define FB_CSPMCR_GROUP1_CS1        (1 << 28)
+#define FB_CSPMCR_GROUP1_TS         (2 << 28)
+
+#endif //MK66_FB_H_
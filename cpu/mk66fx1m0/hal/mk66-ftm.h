@@ -0,0 +1,169 @@
+//+------------------------------------------------------------------------------------------------+
+//| FTM (FlexTimer) peripheral registers for Kinetis MK66 MCU.                                     |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_FTM_H_
+#define MK66_FTM_H_
+
+#include <stdint.h>
+
+struct FTM_channel_type {
+  uint32_t CnSC;          //Channel status and control register
+  uint32_t CnV;           //Channel value register
+};
+
+struct FTM_type {
+  uint32_t SC;            //Status and control register
+  uint32_t CNT;           //Counter register
+  uint32_t MOD;           //Modulo register
+  struct FTM_channel_type C[8];
+  uint32_t CNTIN;         //Counter initial value register
+  uint32_t STATUS;        //Capture and compare status register
+  uint32_t MODE;          //Features mode selection register
+  uint32_t SYNC;          //Synchronization register
+  uint32_t OUTINIT;       //Initial state for channels output register
+  uint32_t OUTMASK;       //Output mask register
+  uint32_t COMBINE;       //Function for linked channels register
+  uint32_t DEADTIME;      //Deadtime insertion control register
+  uint32_t EXTTRIG;       //External trigger register
+  uint32_t POL;           //Channels polarity register
+  uint32_t FMS;           //Fault mode status register
+  uint32_t FILTER;        //Input capture filter control register
+  uint32_t FLTCTRL;       //Fault control register
+  uint32_t QDCTRL;        //Quadrature decoder control and status register
+  uint32_t CONF;          //Configuration register
+  uint32_t FLTPOL;        //Fault input polarity register
+  uint32_t SYNCONF;       //Synchronization configuration register
+  uint32_t INVCTRL;       //Inverting control register
+  uint32_t SWOCTRL;       //Software output control register
+  uint32_t PWMLOAD;       //PWM load register
+};
+
+#define FTM0 ((volatile struct FTM_type *) 0x40038000)
+#define FTM1 ((volatile struct FTM_type *) 0x40039000)
+#define FTM2 ((volatile struct FTM_type *) 0x400B8000)
+#define FTM3 ((volatile struct FTM_type *) 0x400B9000)
+
+//Status and control register bitfields
+#define FTM_SC_PS_Div_1         (0 << 0)  //Prescale factor selection
+#define FTM_SC_PS_Div_2         (1 << 0)
+#define FTM_SC_PS_Div_4         (2 << 0)
+#define FTM_SC_PS_Div_8         (3 << 0)
+#define FTM_SC_PS_Div_16        (4 << 0)
+#define FTM_SC_PS_Div_32        (5 << 0)
+#define FTM_SC_PS_Div_64        (6 << 0)
+#define FTM_SC_PS_Div_128       (7 << 0)
+#define FTM_SC_CLKS_None        (0 << 3)  //Clock source selection
+#define FTM_SC_CLKS_System      (1 << 3)
+#define FTM_SC_CLKS_Fixed       (2 << 3)
+#define FTM_SC_CLKS_External    (3 << 3)
+#define FTM_SC_CPWMS_Up         (0 << 5)  //Center-aligned PWM select
+#define FTM_SC_CPWMS_UpDown     (1 << 5)
+#define FTM_SC_TOIE_Disabled    (0 << 6)  //Timer overflow interrupt enable
+#define FTM_SC_TOIE_Enabled     (1 << 6)
+#define FTM_SC_TOF_Msk          0x80      //Timer overflow flag
+#define FTM_SC_TOF_Clear        (0 << 7)
+#define FTM_SC_TOF_Set          (1 << 7)
+
+//Counter, modulo, channel value and counter initial value register bitfields
+#define FTM_COUNT_Msk   0xFFFF
+#define FTM_COUNT_Pos   0
+
+//Channel status and control register bitfields
+#define FTM_CnSC_DMA_Disabled   (0 << 0)  //DMA enable
+#define FTM_CnSC_DMA_Enabled    (1 << 0)
+#define FTM_CnSC_ELSA_Clear     (0 << 2)  //Edge or level select
+#define FTM_CnSC_ELSA_Set       (1 << 2)
+#define FTM_CnSC_ELSB_Clear     (0 << 3)
+#define FTM_CnSC_ELSB_Set       (1 << 3)
+#define FTM_CnSC_MSA_Clear      (0 << 4)  //Channel mode select
+#define FTM_CnSC_MSA_Set        (1 << 4)
+#define FTM_CnSC_MSB_Clear      (0 << 5)
+#define FTM_CnSC_MSB_Set        (1 << 5)
+#define FTM_CnSC_CHIE_Disabled  (0 << 6)  //Channel interrupt enable
+#define FTM_CnSC_CHIE_Enabled   (1 << 6)
+#define FTM_CnSC_CHF_Msk        0x80      //Channel flag
+#define FTM_CnSC_CHF_Clear      (0 << 7)
+#define FTM_CnSC_CHF_Set        (1 << 7)
+
+//Features mode selection register bitfields
+#define FTM_MODE_FTMEN_Disabled     (0 << 0)  //FTM enable (write protected features)
+#define FTM_MODE_FTMEN_Enabled      (1 << 0)
+#define FTM_MODE_INIT_Set           (1 << 1)  //Initialize the channels output
+#define FTM_MODE_WPDIS_Enabled      (0 << 2)  //Write protection disable
+#define FTM_MODE_WPDIS_Disabled     (1 << 2)
+#define FTM_MODE_PWMSYNC_Any        (0 << 3)  //PWM synchronization mode
+#define FTM_MODE_PWMSYNC_Hw_Only    (1 << 3)
+#define FTM_MODE_CAPTEST_Disabled   (0 << 4)  //Capture test mode enable
+#define FTM_MODE_CAPTEST_Enabled    (1 << 4)
+#define FTM_MODE_FAULTIE_Disabled   (0 << 7)  //Fault interrupt enable
+#define FTM_MODE_FAULTIE_Enabled    (1 << 7)
+
+//Synchronization register bitfields
+#define FTM_SYNC_CNTMIN_Set   (1 << 0)  //Minimum loading point enable
+#define FTM_SYNC_CNTMAX_Set   (1 << 1)  //Maximum loading point enable
+#define FTM_SYNC_REINIT_Set   (1 << 2)  //Counter reinitialization by synchronization
+#define FTM_SYNC_SYNCHOM_Set  (1 << 3)  //Output mask synchronization
+#define FTM_SYNC_TRIG0_Set    (1 << 4)  //Hardware trigger 0 enable
+#define FTM_SYNC_TRIG1_Set    (1 << 5)  //Hardware trigger 1 enable
+#define FTM_SYNC_TRIG2_Set    (1 << 6)  //Hardware trigger 2 enable
+#define FTM_SYNC_SWSYNC_Set   (1 << 7)  //Software synchronization trigger
+
+//External trigger register bitfields
+#define FTM_EXTTRIG_CH2TRIG_Set     (1 << 0)  //Channel trigger enables
+#define FTM_EXTTRIG_CH3TRIG_Set     (1 << 1)
+#define FTM_EXTTRIG_CH4TRIG_Set     (1 << 2)
+#define FTM_EXTTRIG_CH5TRIG_Set     (1 << 3)
+#define FTM_EXTTRIG_CH0TRIG_Set     (1 << 4)
+#define FTM_EXTTRIG_CH1TRIG_Set     (1 << 5)
+#define FTM_EXTTRIG_INITTRIGEN_Set  (1 << 6)  //Initialization trigger enable
+#define FTM_EXTTRIG_TRIGF_Msk       0x80      //Channel trigger flag
+
+//Fault mode status register bitfields
+#define FTM_FMS_WPEN_Msk      0x40      //Write protection enable
+#define FTM_FMS_WPEN_Clear    (0 << 6)
+#define FTM_FMS_WPEN_Set      (1 << 6)
+
+//Input capture filter control register bitfields
+#define FTM_FILTER_CH0FVAL_Msk  0x000F    //Channel 0 input filter
+#define FTM_FILTER_CH0FVAL_Pos  0
+#define FTM_FILTER_CH1FVAL_Msk  0x00F0    //Channel 1 input filter
+#define FTM_FILTER_CH1FVAL_Pos  4
+#define FTM_FILTER_CH2FVAL_Msk  0x0F00    //Channel 2 input filter
+#define FTM_FILTER_CH2FVAL_Pos  8
+#define FTM_FILTER_CH3FVAL_Msk  0xF000    //Channel 3 input filter
+#define FTM_FILTER_CH3FVAL_Pos  12
+
+//Quadrature decoder control and status register bitfields
+#define FTM_QDCTRL_QUADEN_Disabled      (0 << 0)  //Quadrature decoder mode enable
+#define FTM_QDCTRL_QUADEN_Enabled       (1 << 0)
+#define FTM_QDCTRL_TOFDIR_Msk           0x02      //Timer overflow direction
+#define FTM_QDCTRL_TOFDIR_Bottom        (0 << 1)
+#define FTM_QDCTRL_TOFDIR_Top           (1 << 1)
+#define FTM_QDCTRL_QUADIR_Msk           0x04      //Counting direction
+#define FTM_QDCTRL_QUADIR_Down          (0 << 2)
+#define FTM_QDCTRL_QUADIR_Up            (1 << 2)
+#define FTM_QDCTRL_QUADMODE_Phase_AB    (0 << 3)  //Quadrature decoder mode
+#define FTM_QDCTRL_QUADMODE_Count_Dir   (1 << 3)
+#define FTM_QDCTRL_PHBPOL_Normal        (0 << 4)  //Phase B input polarity
+#define FTM_QDCTRL_PHBPOL_Inverted      (1 << 4)
+#define FTM_QDCTRL_PHAPOL_Normal        (0 << 5)  //Phase A input polarity
+#define FTM_QDCTRL_PHAPOL_Inverted      (1 << 5)
+#define FTM_QDCTRL_PHBFLTREN_Disabled   (0 << 6)  //Phase B input filter enable
+#define FTM_QDCTRL_PHBFLTREN_Enabled    (1 << 6)
+#define FTM_QDCTRL_PHAFLTREN_Disabled   (0 << 7)  //Phase A input filter enable
+#define FTM_QDCTRL_PHAFLTREN_Enabled    (1 << 7)
+
+//Configuration register bitfields
+#define FTM_CONF_NUMTOF_Msk         0x1F      //TOF frequency
+#define FTM_CONF_NUMTOF_Pos         0
+#define FTM_CONF_BDMMODE_Stop       (0 << 6)  //Behavior in debug mode
+#define FTM_CONF_BDMMODE_Functional (3 << 6)
+#define FTM_CONF_GTBEEN_Disabled    (0 << 9)  //Global time base enable
+#define FTM_CONF_GTBEEN_Enabled     (1 << 9)
+#define FTM_CONF_GTBEOUT_Disabled   (0 << 10) //Global time base output
+#define FTM_CONF_GTBEOUT_Enabled    (1 << 10)
+
+#endif //MK66_FTM_H_
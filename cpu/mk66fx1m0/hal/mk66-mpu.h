@@ -0,0 +1,48 @@
+//+------------------------------------------------------------------------------------------------+
+//| System memory protection unit registers for Kinetis MK66 MCU.                                  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_MPU_H_
+#define MK66_MPU_H_
+
+#include <stdint.h>
+
+struct SYSMPU_type {
+  uint32_t CESR;              //Control/error status register
+  uint32_t reserved0[3];
+  struct {
+    uint32_t EAR;             //Error address register
+    uint32_t EDR;             //Error detail register
+  } SP[5];
+  uint32_t reserved1[242];
+  struct {
+    uint32_t WORD0;           //Region descriptor start address
+    uint32_t WORD1;           //Region descriptor end address
+    uint32_t WORD2;           //Region descriptor access control
+    uint32_t WORD3;           //Region descriptor valid
+  } RGD[12];
+  uint32_t reserved2[208];
+  uint32_t RGDAAC[12];        //Region descriptor alternate access control (access control only)
+};
+
+#define SYSMPU ((volatile struct SYSMPU_type *) 0x4000D000)
+
+//Control/error status register bitfields
+#define SYSMPU_CESR_VLD_Disabled  (0 << 0)    //Valid (global enable)
+#define SYSMPU_CESR_VLD_Enabled   (1 << 0)
+
+//Region descriptor access control bitfields of bus masters 4 to 7 (masters 0 to 3 have
+//supervisor/user modes). Master 4 is the USB OTG (full speed) controller, master 5 the SDHC and
+//master 6 the USB high speed controller.
+#define SYSMPU_RGDAAC_M4WE_Msk    (1 << 24)   //Bus master 4 write enable
+#define SYSMPU_RGDAAC_M4RE_Msk    (1 << 25)   //Bus master 4 read enable
+#define SYSMPU_RGDAAC_M5WE_Msk    (1 << 26)   //Bus master 5 write enable
+#define SYSMPU_RGDAAC_M5RE_Msk    (1 << 27)   //Bus master 5 read enable
+#define SYSMPU_RGDAAC_M6WE_Msk    (1 << 28)   //Bus master 6 write enable
+#define SYSMPU_RGDAAC_M6RE_Msk    (1 << 29)   //Bus master 6 read enable
+#define SYSMPU_RGDAAC_M7WE_Msk    (1 << 30)   //Bus master 7 write enable
+#define SYSMPU_RGDAAC_M7RE_Msk    (1 << 31)   //Bus master 7 read enable
+
+#endif //MK66_MPU_H_
@@ -0,0 +1,42 @@
+//+------------------------------------------------------------------------------------------------+
+//| RCM (reset control module) registers for Kinetis MK66 MCU.                                     |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_RCM_H_
+#define MK66_RCM_H_
+
+#include <stdint.h>
+
+struct RCM_type {
+  uint8_t SRS0;         //System reset status register 0
+  uint8_t SRS1;         //System reset status register 1
+  uint8_t reserved0[2];
+  uint8_t RPFC;         //Reset pin filter control register
+  uint8_t RPFW;         //Reset pin filter width register
+  uint8_t FM;           //Force mode register
+  uint8_t MR;           //Mode register
+  uint8_t SSRS0;        //Sticky system reset status register 0
+  uint8_t SSRS1;        //Sticky system reset status register 1
+};
+
+#define RCM ((volatile struct RCM_type *) 0x4007F000)
+
+//System reset status register 0 bitfields (causes of the last reset)
+#define RCM_SRS0_WAKEUP   (1 << 0)  //Low leakage wakeup (from a VLLS mode)
+#define RCM_SRS0_LVD      (1 << 1)  //Low voltage detect
+#define RCM_SRS0_LOC      (1 << 2)  //Loss of external clock
+#define RCM_SRS0_LOL      (1 << 3)  //Loss of lock
+#define RCM_SRS0_WDOG     (1 << 5)  //Watchdog
+#define RCM_SRS0_PIN      (1 << 6)  //External reset pin
+#define RCM_SRS0_POR      (1 << 7)  //Power on
+
+//System reset status register 1 bitfields
+#define RCM_SRS1_JTAG     (1 << 0)  //JTAG generated reset
+#define RCM_SRS1_LOCKUP   (1 << 1)  //Core lockup
+#define RCM_SRS1_SW       (1 << 2)  //Software (SYSRESETREQ)
+#define RCM_SRS1_MDM_AP   (1 << 3)  //MDM-AP system reset request
+#define RCM_SRS1_SACKERR  (1 << 5)  //Stop mode acknowledge error
+
+#endif //MK66_RCM_H_
@@ -0,0 +1,23 @@
+//+------------------------------------------------------------------------------------------------+
+//| System and VBAT register files for Kinetis MK66 MCU.                                           |
+//|                                                                                                |
+//| The system register file keeps its contents in all low power modes and through every reset but |
+//| power on. The VBAT register file is powered from the VBAT pin, and is only cleared when that   |
+//| supply goes away.                                                                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_RFILE_H_
+#define MK66_RFILE_H_
+
+#include <stdint.h>
+
+struct RFILE_type {
+  uint32_t REG[8];      //Register file registers
+};
+
+#define RFVBAT ((volatile struct RFILE_type *) 0x4003E000)
+#define RFSYS ((volatile struct RFILE_type *) 0x40041000)
+
+#endif //MK66_RFILE_H_
@@ -0,0 +1,162 @@
+//+------------------------------------------------------------------------------------------------+
+//| Secured digital host controller registers for Kinetis MK66 MCU.                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_SDHC_H_
+#define MK66_SDHC_H_
+
+#include <stdint.h>
+
+struct SDHC_type {
+  uint32_t DSADDR;        //DMA system address register
+  uint32_t BLKATTR;       //Block attributes register
+  uint32_t CMDARG;        //Command argument register
+  uint32_t XFERTYP;       //Transfer type register
+  uint32_t CMDRSP[4];     //Command response registers
+  uint32_t DATPORT;       //Buffer data port register
+  uint32_t PRSSTAT;       //Present state register
+  uint32_t PROCTL;        //Protocol control register
+  uint32_t SYSCTL;        //System control register
+  uint32_t IRQSTAT;       //Interrupt status register
+  uint32_t IRQSTATEN;     //Interrupt status enable register
+  uint32_t IRQSIGEN;      //Interrupt signal enable register
+  uint32_t AC12ERR;       //Auto CMD12 error status register
+  uint32_t HTCAPBLT;      //Host controller capabilities
+  uint32_t WML;           //Watermark level register
+  uint32_t reserved0[2];
+  uint32_t FEVT;          //Force event register
+  uint32_t ADMAES;        //ADMA error status register
+  uint32_t ADSADDR;       //ADMA system address register
+  uint32_t reserved1[25];
+  uint32_t VENDOR;        //Vendor specific register
+  uint32_t MMCBOOT;       //MMC boot register
+  uint32_t reserved2[13];
+  uint32_t HOSTVER;       //Host controller version
+};
+
+#define SDHC ((volatile struct SDHC_type *) 0x400B1000)
+
+//ADMA2 descriptor (must be word aligned, as the descriptor table).
+struct SDHC_ADMA2_type {
+  uint32_t ATTR;          //Attributes and length
+  uint32_t ADDR;          //Data address (word aligned)
+};
+
+//Block attributes register bitfields
+#define SDHC_BLKATTR_BLKSIZE_Msk  0x00001FFF  //Transfer block size
+#define SDHC_BLKATTR_BLKSIZE_Pos  0
+#define SDHC_BLKATTR_BLKCNT_Msk   0xFFFF0000  //Blocks count for current transfer
+#define SDHC_BLKATTR_BLKCNT_Pos   16
+
+//Transfer type register bitfields
+#define SDHC_XFERTYP_DMAEN_Disabled   (0 << 0)    //DMA enable
+#define SDHC_XFERTYP_DMAEN_Enabled    (1 << 0)
+#define SDHC_XFERTYP_BCEN_Disabled    (0 << 1)    //Block count enable
+#define SDHC_XFERTYP_BCEN_Enabled     (1 << 1)
+#define SDHC_XFERTYP_AC12EN_Disabled  (0 << 2)    //Auto CMD12 enable
+#define SDHC_XFERTYP_AC12EN_Enabled   (1 << 2)
+#define SDHC_XFERTYP_DTDSEL_Write     (0 << 4)    //Data transfer direction select
+#define SDHC_XFERTYP_DTDSEL_Read      (1 << 4)
+#define SDHC_XFERTYP_MSBSEL_Single    (0 << 5)    //Multi/single block select
+#define SDHC_XFERTYP_MSBSEL_Multi     (1 << 5)
+#define SDHC_XFERTYP_RSPTYP_None      (0 << 16)   //Response type select
+#define SDHC_XFERTYP_RSPTYP_136       (1 << 16)
+#define SDHC_XFERTYP_RSPTYP_48        (2 << 16)
+#define SDHC_XFERTYP_RSPTYP_48_Busy   (3 << 16)
+#define SDHC_XFERTYP_CCCEN_Disabled   (0 << 19)   //Command CRC check enable
+#define SDHC_XFERTYP_CCCEN_Enabled    (1 << 19)
+#define SDHC_XFERTYP_CICEN_Disabled   (0 << 20)   //Command index check enable
+#define SDHC_XFERTYP_CICEN_Enabled    (1 << 20)
+#define SDHC_XFERTYP_DPSEL_No_Data    (0 << 21)   //Data present select
+#define SDHC_XFERTYP_DPSEL_Data       (1 << 21)
+#define SDHC_XFERTYP_CMDTYP_Normal    (0 << 22)   //Command type
+#define SDHC_XFERTYP_CMDTYP_Suspend   (1 << 22)
+#define SDHC_XFERTYP_CMDTYP_Resume    (2 << 22)
+#define SDHC_XFERTYP_CMDTYP_Abort     (3 << 22)
+#define SDHC_XFERTYP_CMDINX_Msk       0x3F000000  //Command index
+#define SDHC_XFERTYP_CMDINX_Pos       24
+
+//Present state register bitfields
+#define SDHC_PRSSTAT_CIHB_Msk   (1 << 0)    //Command inhibit (CMD)
+#define SDHC_PRSSTAT_CDIHB_Msk  (1 << 1)    //Command inhibit (DATA)
+#define SDHC_PRSSTAT_DLA_Msk    (1 << 2)    //Data line active
+#define SDHC_PRSSTAT_SDSTB_Msk  (1 << 3)    //SD clock stable
+#define SDHC_PRSSTAT_CINS_Msk   (1 << 16)   //Card inserted
+#define SDHC_PRSSTAT_CLSL_Msk   (1 << 23)   //CMD line signal level
+#define SDHC_PRSSTAT_DLSL_Msk   0xFF000000  //DAT line signal level
+#define SDHC_PRSSTAT_DLSL_Pos   24
+
+//Protocol control register bitfields
+#define SDHC_PROCTL_LCTL_Off            (0 << 0)    //LED control
+#define SDHC_PROCTL_LCTL_On             (1 << 0)
+#define SDHC_PROCTL_DTW_1_Bit           (0 << 1)    //Data transfer width
+#define SDHC_PROCTL_DTW_4_Bit           (1 << 1)
+#define SDHC_PROCTL_DTW_8_Bit           (2 << 1)
+#define SDHC_PROCTL_D3CD_Disabled       (0 << 3)    //DAT3 as card detection pin
+#define SDHC_PROCTL_D3CD_Enabled        (1 << 3)
+#define SDHC_PROCTL_EMODE_Big           (0 << 4)    //Endian mode
+#define SDHC_PROCTL_EMODE_Half_Word_Big (1 << 4)
+#define SDHC_PROCTL_EMODE_Little        (2 << 4)
+#define SDHC_PROCTL_DMAS_None           (0 << 8)    //DMA select
+#define SDHC_PROCTL_DMAS_ADMA1          (1 << 8)
+#define SDHC_PROCTL_DMAS_ADMA2          (2 << 8)
+
+//System control register bitfields
+#define SDHC_SYSCTL_IPGEN_Disabled    (0 << 0)    //IPG clock enable
+#define SDHC_SYSCTL_IPGEN_Enabled     (1 << 0)
+#define SDHC_SYSCTL_HCKEN_Disabled    (0 << 1)    //System clock enable
+#define SDHC_SYSCTL_HCKEN_Enabled     (1 << 1)
+#define SDHC_SYSCTL_PEREN_Disabled    (0 << 2)    //Peripheral clock enable
+#define SDHC_SYSCTL_PEREN_Enabled     (1 << 2)
+#define SDHC_SYSCTL_SDCLKEN_Disabled  (0 << 3)    //SD clock enable
+#define SDHC_SYSCTL_SDCLKEN_Enabled   (1 << 3)
+#define SDHC_SYSCTL_DVS_Msk           0x000000F0  //Divisor (divides by DVS + 1)
+#define SDHC_SYSCTL_DVS_Pos           4
+#define SDHC_SYSCTL_SDCLKFS_Msk       0x0000FF00  //SDCLK prescaler (one bit set, 2 to 256)
+#define SDHC_SYSCTL_SDCLKFS_Pos       8
+#define SDHC_SYSCTL_DTOCV_Msk         0x000F0000  //Data timeout (2^(13 + DTOCV) SDCLK cycles)
+#define SDHC_SYSCTL_DTOCV_Pos         16
+#define SDHC_SYSCTL_RSTA_Msk          (1 << 24)   //Software reset for all
+#define SDHC_SYSCTL_RSTC_Msk          (1 << 25)   //Software reset for CMD line
+#define SDHC_SYSCTL_RSTD_Msk          (1 << 26)   //Software reset for DATA line
+#define SDHC_SYSCTL_INITA_Msk         (1 << 27)   //Initialization active
+
+//Interrupt status, status enable and signal enable registers bitfields
+#define SDHC_IRQSTAT_CC_Msk     (1 << 0)    //Command complete
+#define SDHC_IRQSTAT_TC_Msk     (1 << 1)    //Transfer complete
+#define SDHC_IRQSTAT_BGE_Msk    (1 << 2)    //Block gap event
+#define SDHC_IRQSTAT_DINT_Msk   (1 << 3)    //DMA interrupt
+#define SDHC_IRQSTAT_BWR_Msk    (1 << 4)    //Buffer write ready
+#define SDHC_IRQSTAT_BRR_Msk    (1 << 5)    //Buffer read ready
+#define SDHC_IRQSTAT_CINS_Msk   (1 << 6)    //Card insertion
+#define SDHC_IRQSTAT_CRM_Msk    (1 << 7)    //Card removal
+#define SDHC_IRQSTAT_CINT_Msk   (1 << 8)    //Card interrupt
+#define SDHC_IRQSTAT_CTOE_Msk   (1 << 16)   //Command timeout error
+#define SDHC_IRQSTAT_CCE_Msk    (1 << 17)   //Command CRC error
+#define SDHC_IRQSTAT_CEBE_Msk   (1 << 18)   //Command end bit error
+#define SDHC_IRQSTAT_CIE_Msk    (1 << 19)   //Command index error
+#define SDHC_IRQSTAT_DTOE_Msk   (1 << 20)   //Data timeout error
+#define SDHC_IRQSTAT_DCE_Msk    (1 << 21)   //Data CRC error
+#define SDHC_IRQSTAT_DEBE_Msk   (1 << 22)   //Data end bit error
+#define SDHC_IRQSTAT_AC12E_Msk  (1 << 24)   //Auto CMD12 error
+#define SDHC_IRQSTAT_DMAE_Msk   (1 << 28)   //DMA error
+
+//Watermark level register bitfields
+#define SDHC_WML_RDWML_Msk  0x000000FF  //Read watermark level (in words)
+#define SDHC_WML_RDWML_Pos  0
+#define SDHC_WML_WRWML_Msk  0x00FF0000  //Write watermark level (in words)
+#define SDHC_WML_WRWML_Pos  16
+
+//ADMA2 descriptor attribute bitfields
+#define SDHC_ADMA2_VALID_Msk      (1 << 0)    //Valid descriptor
+#define SDHC_ADMA2_END_Msk        (1 << 1)    //Last descriptor of the table
+#define SDHC_ADMA2_INT_Msk        (1 << 2)    //Interrupt (DMA interrupt flag) at the end
+#define SDHC_ADMA2_ACT_Nop        (0 << 4)    //Action
+#define SDHC_ADMA2_ACT_Transfer   (2 << 4)
+#define SDHC_ADMA2_ACT_Link       (3 << 4)
+#define SDHC_ADMA2_LENGTH_Msk     0xFFFF0000  //Data length in bytes (multiple of 4, 0 is 65536)
+#define SDHC_ADMA2_LENGTH_Pos     16
+
+#endif //MK66_SDHC_H_
@@ -44,8 +44,10 @@ struct SMC_type {
 #define SMC_STOPCTRL_LLSM_VLLS1         (1 << 0)
 #define SMC_STOPCTRL_LLSM_VLLS2_LLS2    (2 << 0)
 #define SMC_STOPCTRL_LLSM_VLLS3_LLS3    (3 << 0)
+#define SMC_STOPCTRL_LLSM_Msk           0x07
 #define SMC_STOPCTRL_RAM2PO_Unpowered   (0 << 4)  //RAM2 power option
 #define SMC_STOPCTRL_RAM2PO_Powered     (1 << 4)
+#define SMC_STOPCTRL_RAM2PO_Msk         0x10
 #define SMC_STOPCTRL_PORPO_Enabled      (0 << 5)  //POR power option
 #define SMC_STOPCTRL_PORPO_Disabled     (1 << 5)
 #define SMC_STOPCTRL_PSTOPO_STOP        (0 << 6)  //Partial stop option
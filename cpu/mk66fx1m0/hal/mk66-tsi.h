@@ -0,0 +1,81 @@
+//+------------------------------------------------------------------------------------------------+
+//| TSI (touch sensing input) peripheral registers for Kinetis MK66 MCU.                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_TSI_H_
+#define MK66_TSI_H_
+
+#include <stdint.h>
+
+struct TSI_type {
+  uint32_t GENCS;         //General control and status register
+  uint32_t DATA;          //Data register
+  uint32_t TSHD;          //Threshold register
+};
+
+#define TSI ((volatile struct TSI_type *) 0x40045000)
+
+//General control and status register bitfields
+#define TSI_GENCS_EOSF_Msk          0x00000004  //End of scan flag
+#define TSI_GENCS_EOSF_Clear        (0 << 2)
+#define TSI_GENCS_EOSF_Set          (1 << 2)
+#define TSI_GENCS_SCNIP_Msk         0x00000008  //Scan in progress status
+#define TSI_GENCS_SCNIP_Idle        (0 << 3)
+#define TSI_GENCS_SCNIP_Busy        (1 << 3)
+#define TSI_GENCS_STM_Software      (0 << 4)    //Scan trigger mode
+#define TSI_GENCS_STM_Hardware      (1 << 4)
+#define TSI_GENCS_STPE_Disabled     (0 << 5)    //TSI stop enable (keep working in low power modes)
+#define TSI_GENCS_STPE_Enabled      (1 << 5)
+#define TSI_GENCS_TSIIEN_Disabled   (0 << 6)    //Touch sensing input interrupt enable
+#define TSI_GENCS_TSIIEN_Enabled    (1 << 6)
+#define TSI_GENCS_TSIEN_Disabled    (0 << 7)    //Touch sensing input module enable
+#define TSI_GENCS_TSIEN_Enabled     (1 << 7)
+#define TSI_GENCS_NSCN_Msk          0x00001F00  //Number of scans per electrode, minus one
+#define TSI_GENCS_NSCN_Pos          8
+#define TSI_GENCS_PS_Msk            0x0000E000  //Electrode oscillator prescaler (power of two)
+#define TSI_GENCS_PS_Pos            13
+#define TSI_GENCS_EXTCHRG_500nA     (0 << 16)   //Electrode oscillator charge and discharge current
+#define TSI_GENCS_EXTCHRG_1uA       (1 << 16)
+#define TSI_GENCS_EXTCHRG_2uA       (2 << 16)
+#define TSI_GENCS_EXTCHRG_4uA       (3 << 16)
+#define TSI_GENCS_EXTCHRG_8uA       (4 << 16)
+#define TSI_GENCS_EXTCHRG_16uA      (5 << 16)
+#define TSI_GENCS_EXTCHRG_32uA      (6 << 16)
+#define TSI_GENCS_EXTCHRG_64uA      (7 << 16)
+#define TSI_GENCS_DVOLT_1_03V       (0 << 19)   //Oscillator voltage rails delta
+#define TSI_GENCS_DVOLT_0_73V       (1 << 19)
+#define TSI_GENCS_DVOLT_0_43V       (2 << 19)
+#define TSI_GENCS_DVOLT_0_29V       (3 << 19)
+#define TSI_GENCS_REFCHRG_500nA     (0 << 21)   //Reference oscillator charge and discharge current
+#define TSI_GENCS_REFCHRG_1uA       (1 << 21)
+#define TSI_GENCS_REFCHRG_2uA       (2 << 21)
+#define TSI_GENCS_REFCHRG_4uA       (3 << 21)
+#define TSI_GENCS_REFCHRG_8uA       (4 << 21)
+#define TSI_GENCS_REFCHRG_16uA      (5 << 21)
+#define TSI_GENCS_REFCHRG_32uA      (6 << 21)
+#define TSI_GENCS_REFCHRG_64uA      (7 << 21)
+#define TSI_GENCS_MODE_Capacitive   (0 << 24)   //Operation mode
+#define TSI_GENCS_ESOR_Out_Of_Range (0 << 28)   //End of scan or out of range interrupt selection
+#define TSI_GENCS_ESOR_End_Of_Scan  (1 << 28)
+#define TSI_GENCS_OUTRGF_Msk        0x80000000  //Out of range flag
+#define TSI_GENCS_OUTRGF_Clear      (0 << 31)
+#define TSI_GENCS_OUTRGF_Set        (1 << 31)
+
+//Data register bitfields
+#define TSI_DATA_TSICNT_Msk     0x0000FFFF  //Conversion counter value
+#define TSI_DATA_TSICNT_Pos     0
+#define TSI_DATA_SWTS_Start     (1 << 22)   //Software trigger start
+#define TSI_DATA_DMAEN_Disabled (0 << 23)   //DMA transfer enable
+#define TSI_DATA_DMAEN_Enabled  (1 << 23)
+#define TSI_DATA_TSICH_Msk      0xF0000000  //Measured channel
+#define TSI_DATA_TSICH_Pos      28
+
+//Threshold register bitfields
+#define TSI_TSHD_THRESL_Msk   0x0000FFFF  //Low wakeup threshold
+#define TSI_TSHD_THRESL_Pos   0
+#define TSI_TSHD_THRESH_Msk   0xFFFF0000  //High wakeup threshold
+#define TSI_TSHD_THRESH_Pos   16
+
+#endif //MK66_TSI_H_
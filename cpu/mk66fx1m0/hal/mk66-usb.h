@@ -0,0 +1,180 @@
+//+------------------------------------------------------------------------------------------------+
+//| Universal serial bus OTG (full speed) controller registers for Kinetis MK66 MCU.               |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_USB_H_
+#define MK66_USB_H_
+
+#include <stdint.h>
+
+//Registers are 8 bits wide, one every 4 bytes.
+struct USB_type {
+  uint8_t PERID;              //Peripheral ID register
+  uint8_t reserved0[3];
+  uint8_t IDCOMP;             //Peripheral ID complement register
+  uint8_t reserved1[3];
+  uint8_t REV;                //Peripheral revision register
+  uint8_t reserved2[3];
+  uint8_t ADDINFO;            //Peripheral additional info register
+  uint8_t reserved3[3];
+  uint8_t OTGISTAT;           //OTG interrupt status register
+  uint8_t reserved4[3];
+  uint8_t OTGICR;             //OTG interrupt control register
+  uint8_t reserved5[3];
+  uint8_t OTGSTAT;            //OTG status register
+  uint8_t reserved6[3];
+  uint8_t OTGCTL;             //OTG control register
+  uint8_t reserved7[99];
+  uint8_t ISTAT;              //Interrupt status register
+  uint8_t reserved8[3];
+  uint8_t INTEN;              //Interrupt enable register
+  uint8_t reserved9[3];
+  uint8_t ERRSTAT;            //Error interrupt status register
+  uint8_t reserved10[3];
+  uint8_t ERREN;              //Error interrupt enable register
+  uint8_t reserved11[3];
+  uint8_t STAT;               //Status register
+  uint8_t reserved12[3];
+  uint8_t CTL;                //Control register
+  uint8_t reserved13[3];
+  uint8_t ADDR;               //Address register
+  uint8_t reserved14[3];
+  uint8_t BDTPAGE1;           //BDT page register 1
+  uint8_t reserved15[3];
+  uint8_t FRMNUML;            //Frame number register low
+  uint8_t reserved16[3];
+  uint8_t FRMNUMH;            //Frame number register high
+  uint8_t reserved17[3];
+  uint8_t TOKEN;              //Token register
+  uint8_t reserved18[3];
+  uint8_t SOFTHLD;            //SOF threshold register
+  uint8_t reserved19[3];
+  uint8_t BDTPAGE2;           //BDT page register 2
+  uint8_t reserved20[3];
+  uint8_t BDTPAGE3;           //BDT page register 3
+  uint8_t reserved21[11];
+  struct {
+    uint8_t ENDPT;            //Endpoint control register
+    uint8_t reserved[3];
+  } ENDPOINT[16];
+  uint8_t USBCTRL;            //USB control register
+  uint8_t reserved22[3];
+  uint8_t OBSERVE;            //USB OTG observe register
+  uint8_t reserved23[3];
+  uint8_t CONTROL;            //USB OTG control register
+  uint8_t reserved24[3];
+  uint8_t USBTRC0;            //USB transceiver control register 0
+  uint8_t reserved25[7];
+  uint8_t USBFRMADJUST;       //Frame adjust register
+  uint8_t reserved26[43];
+  uint8_t CLK_RECOVER_CTRL;   //USB clock recovery control
+  uint8_t reserved27[3];
+  uint8_t CLK_RECOVER_IRC_EN; //IRC48M oscillator enable register
+  uint8_t reserved28[15];
+  uint8_t CLK_RECOVER_INT_EN; //Clock recovery combined interrupt enable
+  uint8_t reserved29[7];
+  uint8_t CLK_RECOVER_INT_STATUS; //Clock recovery separated interrupt status
+};
+
+#define USB0 ((volatile struct USB_type *) 0x40072000)
+
+//Buffer descriptor. The table holds 4 per endpoint (receive even/odd, transmit even/odd) and must
+//be aligned to 512 bytes.
+struct USB_BD_type {
+  uint32_t DESC;              //Control and status
+  uint32_t ADDR;              //Buffer address
+};
+
+//Buffer descriptor table index of an endpoint, direction (0 receive, 1 transmit) and bank.
+#define USB_BDT_Index(ep, tx, odd)  (((ep) << 2) | ((tx) << 1) | (odd))
+
+//Buffer descriptor control and status bitfields
+#define USB_BD_BDT_STALL_Msk  (1 << 2)    //Issue a STALL handshake
+#define USB_BD_DTS_Msk        (1 << 3)    //Data toggle synchronization
+#define USB_BD_NINC_Msk       (1 << 4)    //No address increment
+#define USB_BD_KEEP_Msk       (1 << 5)    //Keep ownership by the controller
+#define USB_BD_DATA0          (0 << 6)    //Data toggle
+#define USB_BD_DATA1          (1 << 6)
+#define USB_BD_OWN_Msk        (1 << 7)    //Owned by the controller
+#define USB_BD_TOK_PID_Msk    0x0000003C  //Token PID of the last transaction (written back)
+#define USB_BD_TOK_PID_Pos    2
+#define USB_BD_BC_Msk         0x03FF0000  //Byte count
+#define USB_BD_BC_Pos         16
+
+//Token PIDs
+#define USB_PID_OUT     0x1
+#define USB_PID_IN      0x9
+#define USB_PID_SETUP   0xD
+
+//Interrupt status and enable registers bitfields
+#define USB_ISTAT_USBRST_Msk  (1 << 0)    //USB reset
+#define USB_ISTAT_ERROR_Msk   (1 << 1)    //Error condition
+#define USB_ISTAT_SOFTOK_Msk  (1 << 2)    //Start of frame token
+#define USB_ISTAT_TOKDNE_Msk  (1 << 3)    //Token processing done
+#define USB_ISTAT_SLEEP_Msk   (1 << 4)    //Idle for 3ms (suspend)
+#define USB_ISTAT_RESUME_Msk  (1 << 5)    //Resume signaling
+#define USB_ISTAT_ATTACH_Msk  (1 << 6)    //Attach (host mode)
+#define USB_ISTAT_STALL_Msk   (1 << 7)    //Stall handshake
+
+//Status register bitfields
+#define USB_STAT_ODD_Msk    (1 << 2)    //Bank of the last buffer descriptor updated
+#define USB_STAT_TX_Msk     (1 << 3)    //Direction of the last transaction (1 for transmit)
+#define USB_STAT_ENDP_Msk   0xF0        //Endpoint of the last transaction
+#define USB_STAT_ENDP_Pos   4
+
+//Control register bitfields
+#define USB_CTL_USBENSOFEN_Disabled (0 << 0)    //USB enable
+#define USB_CTL_USBENSOFEN_Enabled  (1 << 0)
+#define USB_CTL_ODDRST_Msk          (1 << 1)    //Reset all buffer descriptor banks to even
+#define USB_CTL_RESUME_Msk          (1 << 2)    //Drive resume signaling
+#define USB_CTL_HOSTMODEEN_Msk      (1 << 3)    //Host mode enable
+#define USB_CTL_TXSUSPENDTOKENBUSY_Msk (1 << 5) //Token processing suspended
+#define USB_CTL_SE0_Msk             (1 << 6)    //Live single ended zero signal
+#define USB_CTL_JSTATE_Msk          (1 << 7)    //Live differential receiver J signal
+
+//Endpoint control register bitfields
+#define USB_ENDPT_EPHSHK_Disabled   (0 << 0)    //Endpoint handshaking
+#define USB_ENDPT_EPHSHK_Enabled    (1 << 0)
+#define USB_ENDPT_EPSTALL_Msk       (1 << 1)    //Endpoint stalled
+#define USB_ENDPT_EPTXEN_Disabled   (0 << 2)    //Endpoint transmit enable
+#define USB_ENDPT_EPTXEN_Enabled    (1 << 2)
+#define USB_ENDPT_EPRXEN_Disabled   (0 << 3)    //Endpoint receive enable
+#define USB_ENDPT_EPRXEN_Enabled    (1 << 3)
+#define USB_ENDPT_EPCTLDIS_Enabled  (0 << 4)    //Control (setup) transfers enable
+#define USB_ENDPT_EPCTLDIS_Disabled (1 << 4)
+
+//USB control register bitfields
+#define USB_USBCTRL_PDE_Disabled    (0 << 6)    //Weak pulldowns on D+ and D-
+#define USB_USBCTRL_PDE_Enabled     (1 << 6)
+#define USB_USBCTRL_SUSP_Disabled   (0 << 7)    //Transceiver suspend
+#define USB_USBCTRL_SUSP_Enabled    (1 << 7)
+
+//USB OTG control register bitfields
+#define USB_CONTROL_DPPULLUPNONOTG_Disabled (0 << 4)  //D+ pullup (device mode, without OTG)
+#define USB_CONTROL_DPPULLUPNONOTG_Enabled  (1 << 4)
+
+//USB transceiver control register 0 bitfields
+#define USB_USBTRC0_USB_RESUME_INT_Msk  (1 << 0)    //Asynchronous resume interrupt flag
+#define USB_USBTRC0_SYNC_DET_Msk        (1 << 1)    //Synchronous USB interrupt detect
+#define USB_USBTRC0_USBRESMEN_Disabled  (0 << 5)    //Asynchronous resume interrupt enable
+#define USB_USBTRC0_USBRESMEN_Enabled   (1 << 5)
+#define USB_USBTRC0_Reserved_Set        (1 << 6)    //Must be written as one
+#define USB_USBTRC0_USBRESET_Msk        (1 << 7)    //USB module reset
+
+//Clock recovery control register bitfields
+#define USB_CLK_RECOVER_CTRL_RESTART_IFRTRIM_EN_Disabled  (0 << 5)  //Restart from factory trim
+#define USB_CLK_RECOVER_CTRL_RESTART_IFRTRIM_EN_Enabled   (1 << 5)
+#define USB_CLK_RECOVER_CTRL_RESET_RESUME_ROUGH_EN_Disabled (0 << 6)  //Reset/resume rough adjust
+#define USB_CLK_RECOVER_CTRL_RESET_RESUME_ROUGH_EN_Enabled  (1 << 6)
+#define USB_CLK_RECOVER_CTRL_CLOCK_RECOVER_EN_Disabled    (0 << 7)  //Crystal-less USB enable
+#define USB_CLK_RECOVER_CTRL_CLOCK_RECOVER_EN_Enabled     (1 << 7)
+
+//IRC48M oscillator enable register bitfields
+#define USB_CLK_RECOVER_IRC_EN_REG_EN_Disabled  (0 << 0)  //IRC48M regulator enable
+#define USB_CLK_RECOVER_IRC_EN_REG_EN_Enabled   (1 << 0)
+#define USB_CLK_RECOVER_IRC_EN_IRC_EN_Disabled  (0 << 1)  //IRC48M enable
+#define USB_CLK_RECOVER_IRC_EN_IRC_EN_Enabled   (1 << 1)
+
+#endif //MK66_USB_H_
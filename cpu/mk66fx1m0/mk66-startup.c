@@ -8,6 +8,7 @@
 //| Author: Joksan Alvarado.                                                                       |
 //+------------------------------------------------------------------------------------------------+
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "mk66.h"
@@ -16,6 +17,10 @@
 #include "mk66-osc.h"
 #include "mk66-mcg.h"
 #include "mk66-sim.h"
+#include "mk66-rcm.h"
+#include "mk66-pmc.h"
+#include "mk66-rfile.h"
+#include "mk66-startup.h"
 
 //Interrupt vector handler function type.
 typedef void (* handler_t)();
@@ -35,38 +40,66 @@ extern uint32_t __stack_end__;
 extern const uint32_t __relocate_flash_start__;
 extern uint32_t __relocate_sram_start__;
 extern uint32_t __relocate_sram_end__;
+extern const uint8_t __data_image_start__;
 extern uint32_t __bss_start__;
 extern uint32_t __bss_end__;
+extern uint32_t __retained_start__;
+extern uint32_t __retained_end__;
 
 //External functions invoked by startup code.
 extern void __libc_init_array();
 extern void main();
 
-//--------------------------------------------------------------------------------------------------
+//Core clock frequencies of the boot phases: FLL on the slow internal reference (out of reset), FLL
+//in its 48MHz range (fast boot), external oscillator and PLL.
+#define FLL_RESET_FREQ 20971520
+#define FLL_FAST_FREQ 47972352
+#define OSC_FREQ 16000000
+#define PLL_FREQ 180000000
 
-//Startup routine, located at reset vector.
-void startup() {
-  const uint32_t *flash;
-  uint32_t *sram;
+//Boot phases, measured as core cycles spent on each clock.
+#define BOOT_PHASES 3
+static uint32_t boot_cycles[BOOT_PHASES];
+#if STARTUP_FAST_BOOT
+static const uint32_t boot_freqs[BOOT_PHASES] = { FLL_RESET_FREQ, FLL_FAST_FREQ, FLL_FAST_FREQ };
+#else
+static const uint32_t boot_freqs[BOOT_PHASES] = { FLL_RESET_FREQ, OSC_FREQ, PLL_FREQ };
+#endif
 
-  //Disable the watchdog.
-  WDOG->UNLOCK = WDOG_UNLOCK_Seq_A;
-  WDOG->UNLOCK = WDOG_UNLOCK_Seq_B;
-  WDOG->STCTRLH = WDOG_STCTRLH_WDOGEN_Disabled | WDOG_STCTRLH_ALLOWUPDATE_Yes;
+//Core cycles spent initializing the .data section (part of the last boot phase).
+static uint32_t data_cycles;
 
-  //Enable the floating point unit.
-  SCB->CPACR = (0xF << 20);
+//Whether the retained section kept its contents through the last reset.
+static uint8_t retained;
 
-  //Enable all power modes.
-  SMC->PMPROT = SMC_PMPROT_AHSRUN_Allowed | SMC_PMPROT_AVLP_Allowed | SMC_PMPROT_ALLS_Allowed |
-                SMC_PMPROT_AVLLS_Allowed;
+//Whether the last reset resumed the application, with all its memory kept.
+static uint8_t resumed;
+
+//System register file word holding the resume request, and its value when set.
+#define RESUME_REG 0
+#define RESUME_KEY 0x5E5D4E57
+
+//--------------------------------------------------------------------------------------------------
 
+//Starts the 16MHz external oscillator, and the PLL from it. The PLL clock enable keeps the PLL
+//running before it's selected, so it locks while the system runs from the FLL.
+static void start_pll() {
   //Configure the 16MHz external oscillator.
   OSC->CR = OSC_CR_ERCLKEN_Enabled | OSC_CR_SC2P_Enabled | OSC_CR_SC8P_Enabled;
   MCG->C2 = MCG_C2_RANGE_Very_High | MCG_C2_HGO_Low_Power | MCG_C2_EREFS_Oscillator;
 
-  //Switch to FBE (FLL bypassed external) mode while changing the reference to external. This causes
-  //the external oscillator to start up.
+  //Set the PLL external reference divider to divide by two, to get an input reference of 8MHz, and
+  //the multiplier to 45. Final frequency will be 8MHz * 45 / 2 = 180MHz.
+  MCG->C5 = MCG_C5_PRDIV_Div_2;
+  MCG->C6 = MCG_C6_PLLS_FLL | MCG_C6_VDIV_Div_45;
+  MCG->C5 = MCG_C5_PRDIV_Div_2 | MCG_C5_PLLCLKEN_Enabled;
+}
+
+//Engages the PLL, going from FEI (FLL engaged internal) mode through FBE and PBE into PEE mode, and
+//sets the final clock prescalers. If given, marks get the SysTick values at the FBE and PEE
+//switches.
+static void engage_pll(uint32_t *marks) {
+  //Switch to FBE (FLL bypassed external) mode while changing the reference to external.
   MCG->C1 = MCG_C1_CLKS_External | MCG_C1_FRDIV_Div_16_512 | MCG_C1_IREFS_External;
   //Note: FRDIV is set to 512 just to set an input frequency of 16MHz/512 = 31.25KHz to the FLL
   //(which requires a value around 32.768KHz). It's not really used.
@@ -75,13 +108,10 @@ void startup() {
   while ((MCG->S & MCG_S_OSCINIT0_Msk) != MCG_S_OSCINIT0_Ready);  //Wait for external oscillator
   while ((MCG->S & MCG_S_IREFST_Msk) != MCG_S_IREFST_External);   //Wait for reference switch
   while ((MCG->S & MCG_S_CLKST_Msk) != MCG_S_CLKST_External);     //Wait for system clock switch
+  if (marks != NULL)
+    marks[0] = SysTick->VAL;
 
-  //We're running on the external crystal now. Set the PLL external reference divider to divide by
-  //two, to get an input reference of 8MHz.
-  MCG->C5 = MCG_C5_PRDIV_Div_2;
-
-  //Transition to PBE (PLL bypassed external) mode. This causes to PLL to start up. Set the
-  //multiplier to 45. Final frequency will be 8MHz * 45 / 2 = 180MHz.
+  //We're running on the external crystal now. Transition to PBE (PLL bypassed external) mode.
   MCG->C6 = MCG_C6_PLLS_PLLCS | MCG_C6_VDIV_Div_45;
 
   //Wait for the PLL to become ready.
@@ -92,9 +122,11 @@ void startup() {
   SMC->PMCTRL = SMC_PMCTRL_RUNM_HSRUN;
   while (SMC->PMSTAT != SMC_PMSTAT_HSRUN);
 
-  //Configure all prescalers. Core runs at 180MHz, bus runs at 60MHz and flash runs at 25.71MHz.
+  //Configure all prescalers. Core runs at 180MHz, bus and FlexBus run at 60MHz and flash runs at
+  //25.71MHz.
   SIM->CLKDIV1 = ((0 << SIM_CLKDIV1_OUTDIV1_Pos) & SIM_CLKDIV1_OUTDIV1_Msk) |   //180 / 1 = 180MHz
                  ((2 << SIM_CLKDIV1_OUTDIV2_Pos) & SIM_CLKDIV1_OUTDIV2_Msk) |   //180 / 3 = 60MHz
+                 ((2 << SIM_CLKDIV1_OUTDIV3_Pos) & SIM_CLKDIV1_OUTDIV3_Msk) |   //180 / 3 = 60MHz
                  ((6 << SIM_CLKDIV1_OUTDIV4_Pos) & SIM_CLKDIV1_OUTDIV4_Msk);    //180 / 7 = 25.71MHz
 
   //Transition into PEE (PLL engaged external) mode. Keep the FRDIV and IRFEFS settings unchanged.
@@ -102,27 +134,231 @@ void startup() {
 
   //Wait for the PLL to be selected as a system clock source.
   while ((MCG->S & MCG_S_CLKST_Msk) != MCG_S_CLKST_PLL);
+  if (marks != NULL)
+    marks[1] = SysTick->VAL;
+}
+
+#if STARTUP_COMPRESS_DATA
+//Unpacks the compressed initial data (an LZ4 block, see cpu/compress-data.py) into the .data
+//section. The last sequence of the block has literals only, so it ends when .data is full.
+static void unpack_data() {
+  const uint8_t *in = &__data_image_start__;
+  uint8_t *out = (uint8_t *) &__relocate_sram_start__;
+  uint8_t *end = (uint8_t *) &__relocate_sram_end__;
+  const uint8_t *match;
+  uint32_t length;
+  uint8_t token;
+
+  while (out < end) {
+    token = *in++;
+
+    //Copy the literals. Lengths of 15 continue on the next bytes, for as long as they're 255.
+    length = token >> 4;
+    if (length == 15) {
+      do
+        length += *in;
+      while (*in++ == 255);
+    }
+    while (length--)
+      *out++ = *in++;
+
+    if (out >= end)
+      break;
+
+    //Copy the match from the output written so far. It may overlap the bytes being written, which
+    //repeats them.
+    match = out - (in[0] | (in[1] << 8));
+    in += 2;
+    length = token & 0xF;
+    if (length == 15) {
+      do
+        length += *in;
+      while (*in++ == 255);
+    }
+    length += 4;
+    while (length--)
+      *out++ = *match++;
+  }
+}
+#endif
+
+//Returns whether the last reset was a wakeup from a VLLS mode that kept the RAM2 partition powered,
+//and with it the retained section. The stop control register keeps the mode across the wakeup.
+static uint8_t retained_kept() {
+  uint8_t mode;
+
+  if (!(RCM->SRS0 & RCM_SRS0_WAKEUP))
+    return 0;
+
+  mode = SMC->STOPCTRL & SMC_STOPCTRL_LLSM_Msk;
+  return mode == SMC_STOPCTRL_LLSM_VLLS3_LLS3 ||
+         (mode == SMC_STOPCTRL_LLSM_VLLS2_LLS2 &&
+          (SMC->STOPCTRL & SMC_STOPCTRL_RAM2PO_Msk) == SMC_STOPCTRL_RAM2PO_Powered);
+}
+
+//Returns whether the application asked to be resumed on the next wakeup, taking the request back.
+//The register file keeps it through resets, but it only holds for the wakeup it was made for.
+static uint8_t resume_requested() {
+  uint8_t requested = (RFSYS->REG[RESUME_REG] == RESUME_KEY);
+
+  RFSYS->REG[RESUME_REG] = 0;
+  return requested;
+}
+
+//Startup routine, located at reset vector.
+void startup() {
+#if !STARTUP_COMPRESS_DATA
+  const uint32_t *flash;
+#endif
+  uint32_t *sram;
+  uint32_t marks[BOOT_PHASES];
+  uint32_t data_start, data_end;
+  uint8_t i, kept;
+
+  //Disable the watchdog.
+  WDOG->UNLOCK = WDOG_UNLOCK_Seq_A;
+  WDOG->UNLOCK = WDOG_UNLOCK_Seq_B;
+  WDOG->STCTRLH = WDOG_STCTRLH_WDOGEN_Disabled | WDOG_STCTRLH_ALLOWUPDATE_Yes;
+
+  //Count core cycles with the SysTick timer (down from 2^24 - 1) to measure the boot time.
+  SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+  //Enable the floating point unit.
+  SCB->CPACR = (0xF << 20);
+
+  //Enable all power modes.
+  SMC->PMPROT = SMC_PMPROT_AHSRUN_Allowed | SMC_PMPROT_AVLP_Allowed | SMC_PMPROT_ALLS_Allowed |
+                SMC_PMPROT_AVLLS_Allowed;
+
+  start_pll();
+
+#if STARTUP_FAST_BOOT
+  //Fast boot: keep running from the FLL while the oscillator and the PLL start, speeding it up to
+  //its 48MHz range. Core and bus run at 48MHz, FlexBus and flash run at 24MHz.
+  SIM->CLKDIV1 = ((0 << SIM_CLKDIV1_OUTDIV1_Pos) & SIM_CLKDIV1_OUTDIV1_Msk) |   //48 / 1 = 48MHz
+                 ((0 << SIM_CLKDIV1_OUTDIV2_Pos) & SIM_CLKDIV1_OUTDIV2_Msk) |   //48 / 1 = 48MHz
+                 ((1 << SIM_CLKDIV1_OUTDIV3_Pos) & SIM_CLKDIV1_OUTDIV3_Msk) |   //48 / 2 = 24MHz
+                 ((1 << SIM_CLKDIV1_OUTDIV4_Pos) & SIM_CLKDIV1_OUTDIV4_Msk);    //48 / 2 = 24MHz
+  marks[0] = SysTick->VAL;
+  MCG->C4 = (MCG->C4 & (MCG_C4_FCTRIM_Msk | MCG_C4_SCFTRIM_Msk)) | MCG_C4_DMX32_Set |
+            MCG_C4_DRST_DRS_Mid;
+
+  //There's no oscillator phase, the rest of the boot runs at 48MHz.
+  marks[1] = marks[0];
+#else
+  //Wait for the oscillator and the PLL, and engage it.
+  engage_pll(marks);
+#endif
 
   //Enable the clocks of all ports.
   SIM->SCGC5 = SIM_SCGC5_PORTA_Enabled | SIM_SCGC5_PORTB_Enabled | SIM_SCGC5_PORTC_Enabled |
                SIM_SCGC5_PORTD_Enabled | SIM_SCGC5_PORTE_Enabled;
 
-  //Copy the initial data for the data section from FLASH to RAM.
-  flash = &__relocate_flash_start__;
-  sram = &__relocate_sram_start__;
-  while (sram < &__relocate_sram_end__)
-    *sram++ = *flash++;
+  //A resumed application finds its memory as it left it, initialized already. The request is only
+  //made for modes that keep all of it (see lowpower_idle()), so a wakeup that kept the retained
+  //section kept the rest.
+  kept = retained_kept();
+  if (resume_requested() && kept) {
+    data_start = data_end = SysTick->VAL;
+    retained = 1;
+    resumed = 1;
+  }
+  else {
+    //Initialize the data section from FLASH, timing it.
+    data_start = SysTick->VAL;
+#if STARTUP_COMPRESS_DATA
+    unpack_data();
+#else
+    flash = &__relocate_flash_start__;
+    sram = &__relocate_sram_start__;
+    while (sram < &__relocate_sram_end__)
+      *sram++ = *flash++;
+#endif
+    data_end = SysTick->VAL;
+
+    //Initialize the .bss section to zeroes.
+    sram = &__bss_start__;
+    while (sram < &__bss_end__)
+      *sram++ = 0;
+
+    //Clear the retained section as well, unless it survived the reset.
+    retained = kept;
+    if (!retained) {
+      sram = &__retained_start__;
+      while (sram < &__retained_end__)
+        *sram++ = 0;
+    }
+
+    //Initialize libc.
+    __libc_init_array();
+  }
+
+  //Stop the boot time measurement and keep the cycles spent on each phase and on .data.
+  marks[2] = SysTick->VAL;
+  SysTick->CTRL = 0;
+  for (i = 0; i < BOOT_PHASES; i++)
+    boot_cycles[i] = ((i == 0 ? SysTick_LOAD_RELOAD_Msk : marks[i - 1]) - marks[i]);
+  data_cycles = data_start - data_end;
+
+  //System is up. Run the early initialization code, which may set up pins again after a VLLS
+  //wakeup before their state is released, and call the main function.
+  startup_early_init();
+  if (RCM->SRS0 & RCM_SRS0_WAKEUP)
+    PMC->REGSC |= PMC_REGSC_ACKISO;
+  main();
+}
 
-  //Initialize the .bss section to zeroes.
-  sram = &__bss_start__;
-  while (sram < &__bss_end__)
-    *sram++ = 0;
+//Engages the PLL after a fast boot, going through the same steps as the normal boot. The oscillator
+//and the PLL have been starting since reset, so there's little to wait for. Sets the final core,
+//bus, FlexBus and flash clocks: peripherals that depend on them may be set up before, for those
+//clocks, but must not be used until then. Does nothing if the PLL is engaged already.
+void startup_engage_pll() {
+  if ((MCG->S & MCG_S_CLKST_Msk) == MCG_S_CLKST_PLL)
+    return;
 
-  //Initialize libc.
-  __libc_init_array();
+  engage_pll(NULL);
+}
 
-  //System is up. Call the main function.
-  main();
+//Returns the time it took from reset to main(), in microseconds. It's the sum of the cycles spent
+//on each clock divided by its frequency, so phases run on the FLL are only as accurate as the
+//internal reference (a few percent).
+uint32_t startup_boot_time() {
+  uint64_t time = 0;
+  uint8_t i;
+
+  for (i = 0; i < BOOT_PHASES; i++)
+    time += (uint64_t) boot_cycles[i] * 1000000 / boot_freqs[i];
+
+  return time;
+}
+
+//Returns the time it took to initialize the .data section (copying or unpacking it), in
+//microseconds. It's included in the boot time.
+uint32_t startup_data_time() {
+  return (uint64_t) data_cycles * 1000000 / boot_freqs[BOOT_PHASES - 1];
+}
+
+//Returns 1 if the retained section kept its contents through the last reset (a wakeup from VLLS2
+//or VLLS3), 0 if it was cleared.
+uint8_t startup_retained() {
+  return retained;
+}
+
+//Sets whether the next wakeup from a VLLS mode resumes the application (1) or boots it again (0).
+void startup_resume_on_wakeup(uint8_t resume) {
+  RFSYS->REG[RESUME_REG] = resume ? RESUME_KEY : 0;
+}
+
+//Returns 1 if the last reset resumed the application, skipping memory initialization, 0 otherwise.
+uint8_t startup_resumed() {
+  return resumed;
+}
+
+//Default code run before main(), overridden by applications that need to set something up as soon
+//as possible after reset. Runs on the boot clocks, before any contiki initialization.
+void __attribute__((weak)) startup_early_init() {
 }
 
 //Default interrupt handler.
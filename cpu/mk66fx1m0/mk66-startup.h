@@ -0,0 +1,62 @@
+//+------------------------------------------------------------------------------------------------+
+//| Kinetis MK66 microcontroller initialization code.                                              |
+//|                                                                                                |
+//| By default, startup code waits for the external oscillator and the PLL before initializing     |
+//| memory, so main() starts with the final clocks. With fast boot enabled, the oscillator and the |
+//| PLL start in the background while the system runs from the FLL (48MHz, on the internal         |
+//| reference), so memory initialization overlaps with their startup and main() is reached sooner. |
+//| Code that must run as early as possible after reset (like driving outputs to a safe state) can |
+//| be placed in startup_early_init(), called right before main(). The platform sets up its        |
+//| peripherals and the processes while the PLL locks, and then engages it with                    |
+//| startup_engage_pll() before anything runs: bus clock dependent peripherals (timers, UARTs,     |
+//| etc.) are configured for the final frequencies, so they only run slow until then.              |
+//|                                                                                                |
+//| Variables in the .retained section (see the linker script and lowpower.h) are zeroed on a cold |
+//| boot, but keep their values when the system wakes up from a VLLS mode that kept them powered,  |
+//| which startup_retained() tells apart. Pins held since a VLLS wakeup are released right after   |
+//| startup_early_init(), so it can configure them first.                                          |
+//|                                                                                                |
+//| An application that sleeps in a VLLS mode keeping all of its memory can be resumed instead of  |
+//| booted again (see lowpower_suspend()): the request, made with startup_resume_on_wakeup(), is   |
+//| kept in the system register file, and the next wakeup skips .data, .bss and libc               |
+//| initialization. startup_resumed() tells the platform to restart the peripherals only, leaving  |
+//| processes and timers as they were.                                                             |
+//|                                                                                                |
+//| Building with COMPRESS_DATA=1 stores the initial data of the .data section compressed in       |
+//| flash (see cpu/compress-data.py), and startup code unpacks it instead of copying it. Large     |
+//| initialized tables and buffers compress well. The link prints the flash saved, and             |
+//| startup_data_time() returns the time spent initializing .data, to weigh against it. The make   |
+//| variable selects the option, which takes a second link: don't set STARTUP_CONF_COMPRESS_DATA   |
+//| by other means.                                                                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MK66_STARTUP_H_
+#define MK66_STARTUP_H_
+
+#include <stdint.h>
+
+//Enables fast boot.
+#ifdef STARTUP_CONF_FAST_BOOT
+#define STARTUP_FAST_BOOT STARTUP_CONF_FAST_BOOT
+#else
+#define STARTUP_FAST_BOOT 0
+#endif
+
+//Unpacks compressed initial data for .data (set by the cpu makefile).
+#ifdef STARTUP_CONF_COMPRESS_DATA
+#define STARTUP_COMPRESS_DATA STARTUP_CONF_COMPRESS_DATA
+#else
+#define STARTUP_COMPRESS_DATA 0
+#endif
+
+void startup_early_init();
+void startup_engage_pll();
+uint32_t startup_boot_time();
+uint32_t startup_data_time();
+uint8_t startup_retained();
+void startup_resume_on_wakeup(uint8_t resume);
+uint8_t startup_resumed();
+
+#endif //MK66_STARTUP_H_
@@ -4,4 +4,13 @@
 //| Author: Joksan Alvarado.                                                                       |
 //+------------------------------------------------------------------------------------------------+
 
-//This header is an stub for now. It currently exists to allow clean compilation.
+#ifndef RTIMER_ARCH_H_
+#define RTIMER_ARCH_H_
+
+//Rtimer ticks per second. The time base is derived from the bus clock (60MHz / 15).
+#define RTIMER_ARCH_SECOND 4000000
+
+rtimer_clock_t rtimer_arch_now();
+int rtimer_arch_reschedule(rtimer_clock_t t);
+
+#endif //RTIMER_ARCH_H_
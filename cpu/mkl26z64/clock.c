@@ -9,6 +9,7 @@
 
 #include "clock.h"
 #include "etimer.h"
+#include "rtimer.h"
 
 #include "mkl26.h"
 #include "mkl26-sim.h"
@@ -90,6 +91,13 @@ void clock_delay_usec(uint16_t dt) {
 }
 
 void pit_handler() {
+  //The interrupt is shared by both PIT channels. PIT1 is used by the rtimer library.
+  if (PIT->TFLG1 & PIT_TFLG_TIF_Msk)
+    rtimer_arch_pit_handler();
+
+  if (!(PIT->TFLG0 & PIT_TFLG_TIF_Msk))
+    return;
+
   //Clear the interrupt flag.
   PIT->TFLG0 |= PIT_TFLG_TIF_Set;
 
@@ -0,0 +1,73 @@
+//+------------------------------------------------------------------------------------------------+
+//| Analog comparator driver for Kinetis MKL26 MCU.                                                |
+//|                                                                                                |
+//| Watches an analog input against a threshold set by the 6 bit DAC of the comparator (1/64ths    |
+//| of the supply voltage), so crossings are detected in hardware instead of by sampling the ADC.  |
+//| The processes that initialized the comparators get a cmp_event on the selected output edges.   |
+//|                                                                                                |
+//| Noise is dealt with by the hysteresis of the comparator and by its digital filter. With        |
+//| filtering, the output is sampled every filter_period bus clocks and only changes after         |
+//| filter_count samples in a row agree (up to 7). Without it, the comparator runs in continuous   |
+//| mode. The MKL26 has no source for the window signal, so cmp_init() rejects windowed            |
+//| configurations.                                                                                |
+//|                                                                                                |
+//| For low power operation, cmp_wake_arm() enables the comparator as a low leakage wakeup source, |
+//| so its edges wake the MCU from LLS modes. The filter needs the bus clock, so the comparator    |
+//| runs in continuous mode while armed (count on the hysteresis to reject noise meanwhile).       |
+//|                                                                                                |
+//| Inputs (Teensy LC pin numbers in parenthesis): IN0 PTC6 (11), IN1 PTC7 (12). The remaining     |
+//| inputs connect to pins not available on the board or to internal signals. PTC6 and PTC7 are    |
+//| shared with SPI0.                                                                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef CMP_H_
+#define CMP_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Comparator identifiers.
+#define CMP_0 0
+
+//Output edges, for the edges field of the configuration and the event data.
+#define CMP_EDGE_RISING   (1 << 0)
+#define CMP_EDGE_FALLING  (1 << 1)
+
+//Hysteresis levels (typical values, at high speed).
+#define CMP_HYSTERESIS_5MV    0
+#define CMP_HYSTERESIS_10MV   1
+#define CMP_HYSTERESIS_20MV   2
+#define CMP_HYSTERESIS_30MV   3
+
+struct cmp_config {
+  uint8_t input;          //Input channel (0 to 7), compared against the DAC threshold
+  uint8_t level;          //DAC threshold, as (level + 1) / 64 of the supply voltage (0 to 63)
+  uint8_t hysteresis;     //Hysteresis level (CMP_HYSTERESIS_*)
+  uint8_t filter_count;   //Samples that must agree for the output to change (0 for no filter)
+  uint8_t filter_period;  //Filter sampling period, in bus clocks (1 to 255)
+  uint8_t windowed;       //Must be 0 (no window signal on this MCU)
+  uint8_t edges;          //Output edges that generate events (CMP_EDGE_*)
+};
+
+//Event data: the comparator, the edges seen since the last event and the output level.
+struct cmp_change {
+  uint8_t id;
+  uint8_t edges;
+  uint8_t output;
+};
+
+//Event posted to the process that initialized a comparator when its output changes. Data points to
+//a struct cmp_change, valid during the event only.
+extern process_event_t cmp_event;
+
+int cmp_init(uint8_t id, const struct cmp_config *config);
+void cmp_stop(uint8_t id);
+void cmp_set_level(uint8_t id, uint8_t level);
+int cmp_output(uint8_t id);
+void cmp_wake_arm(uint8_t id);
+void cmp_wake_disarm(uint8_t id);
+
+#endif //CMP_H_
@@ -0,0 +1,125 @@
+//+------------------------------------------------------------------------------------------------+
+//| Addressable LED strip (WS2812/SK6812) output for Kinetis MKL26 MCU.                            |
+//|                                                                                                |
+//| The DMA controller of this MCU has no circular mode with half transfer interrupts, so the      |
+//| channel is reprogrammed from its completion interrupt: it is pointed at the other half of the  |
+//| transfer buffer right away, and the half just sent is refilled afterwards with the next        |
+//| encoded bytes. Once the strip has sent its latch time, the channel is stopped.                 |
+//|                                                                                                |
+//| The SPI buffers one byte besides the one being shifted, so the channel must be reprogrammed    |
+//| within ~2.6us of the last transfer. That's why the interrupt runs at the highest priority.     |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "led-strip.h"
+
+#include "mkl26.h"
+#include "mkl26-sim.h"
+#include "mkl26-port.h"
+#include "mkl26-spi.h"
+#include "mkl26-dma.h"
+#include "mkl26-dmamux.h"
+
+//DMA channel used by the driver.
+#define DMA_CHANNEL 0
+
+#define SPI_BR_BAUD ((0 << SPI_BR_SPPR_Pos) | (2 << SPI_BR_SPR_Pos))
+
+//Pixel bytes encoded per half buffer, and SPI bytes per half buffer.
+#define HALF_BYTES 16
+#define HALF_SPI_BYTES (HALF_BYTES * 4)
+
+//Channel configuration: one byte per SPI request, from memory to the data register.
+#define DMA_DCR_CONFIG (DMA_DCR_EINT_Enabled | DMA_DCR_ERQ_Enabled | DMA_DCR_CS_Single | \
+                        DMA_DCR_SINC_Enabled | DMA_DCR_SSIZE_8Bit | DMA_DCR_DINC_Disabled | \
+                        DMA_DCR_DSIZE_8Bit)
+
+//Transfer buffer, split in two halves.
+static uint8_t transfer[HALF_SPI_BYTES * 2];
+
+//Transfer state.
+static struct led_strip *strip_sent;
+static uint8_t last_half[2];
+static uint8_t sending;
+
+//Fills one half of the transfer buffer with the next encoded bytes.
+static void fill_half(uint8_t half) {
+  uint8_t *dst = &transfer[half * HALF_SPI_BYTES];
+  uint32_t bits;
+  uint8_t i;
+
+  for (i = 0; i < HALF_BYTES; i++) {
+    bits = led_strip_encode(strip_sent);
+    *dst++ = bits >> 24;
+    *dst++ = bits >> 16;
+    *dst++ = bits >> 8;
+    *dst++ = bits;
+  }
+
+  last_half[half] = led_strip_latched(strip_sent);
+}
+
+//Points the channel to one half of the transfer buffer.
+static void start_half(uint8_t half) {
+  DMA->CH[DMA_CHANNEL].DSR_BCR = DMA_DSR_BCR_DONE_Set;
+  DMA->CH[DMA_CHANNEL].SAR = (uint32_t) &transfer[half * HALF_SPI_BYTES];
+  DMA->CH[DMA_CHANNEL].DSR_BCR = HALF_SPI_BYTES;
+  DMA->CH[DMA_CHANNEL].DCR = DMA_DCR_CONFIG;
+}
+
+//Sets up SPI0 and the DMA channel.
+void led_strip_arch_init(struct led_strip *strip) {
+  strip_sent = strip;
+
+  //Enable the module clocks and route MOSI. The pulldown keeps the line low while idle.
+  SIM->SCGC4 |= SIM_SCGC4_SPI0_Enabled;
+  SIM->SCGC6 |= SIM_SCGC6_DMAMUX_Enabled;
+  SIM->SCGC7 |= SIM_SCGC7_DMA_Enabled;
+  PORTC->PCR[6] = PORT_PCR_MUX_Alt2 | PORT_PCR_DSE_High | PORT_PCR_PE_Enabled |
+                  PORT_PCR_PS_Pulldown;
+
+  //Master mode, 8 bit transfers, with transmit DMA requests.
+  SPI0->C1 = SPI_C1_SPE_Disabled;
+  SPI0->BR = SPI_BR_BAUD;
+  SPI0->C2 = SPI_C2_SPIMODE_8Bit | SPI_C2_TXDMAE_Enabled;
+  SPI0->C1 = SPI_C1_SPE_Enabled | SPI_C1_MSTR_Master | SPI_C1_CPOL_High | SPI_C1_CPHA_Middle |
+             SPI_C1_LSBFE_MSB;
+
+  //The channel is stopped until a frame is shown.
+  DMAMUX->CHCFG[DMA_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->CH[DMA_CHANNEL].DCR = 0;
+  DMA->CH[DMA_CHANNEL].DSR_BCR = DMA_DSR_BCR_DONE_Set;
+  DMA->CH[DMA_CHANNEL].DAR = (uint32_t) &SPI0->DL;
+  DMAMUX->CHCFG[DMA_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_SPI0_Tx;
+
+  NVIC_SetPriority(DmaChannel_0_IRQn, 0);
+  NVIC_EnableIRQ(DmaChannel_0_IRQn);
+}
+
+//Starts sending the frame of the strip.
+void led_strip_arch_start(struct led_strip *strip) {
+  //Prepare both halves and start from the first one.
+  sending = 0;
+  fill_half(0);
+  fill_half(1);
+  start_half(0);
+}
+
+void dma_channel_0_handler() {
+  uint8_t half = sending;
+
+  if (last_half[half]) {
+    //Enough of the latch time has been sent.
+    DMA->CH[DMA_CHANNEL].DCR = 0;
+    DMA->CH[DMA_CHANNEL].DSR_BCR = DMA_DSR_BCR_DONE_Set;
+    led_strip_done(strip_sent);
+  } else {
+    //Keep the SPI fed first, then refill the half just sent.
+    sending ^= 1;
+    start_half(sending);
+    fill_half(half);
+  }
+}
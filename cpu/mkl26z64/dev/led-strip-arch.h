@@ -0,0 +1,26 @@
+//+------------------------------------------------------------------------------------------------+
+//| Addressable LED strip (WS2812/SK6812) output for Kinetis MKL26 MCU.                            |
+//|                                                                                                |
+//| There's a single chain (0), on SPI0 with data output on PTC6 (Teensy LC pin 11), fed by DMA    |
+//| channel 0. Its interrupt must be served within a few microseconds (see led-strip-arch.c), so   |
+//| a second chain on SPI1 couldn't be kept fed along with it. The chain refreshes up to about 510 |
+//| RGB pixels at 60 fps. Mind the RAM taken by both frame buffers, as the MCU has only 8KB of it. |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef LED_STRIP_ARCH_H_
+#define LED_STRIP_ARCH_H_
+
+//Number of output chains.
+#define LED_STRIP_CHAINS 1
+
+//SPI clock: 24MHz bus / 1 / 8 = 3MHz, for a 1.33us data bit.
+#define LED_STRIP_ARCH_BIT_RATE 3000000
+
+struct led_strip;
+
+void led_strip_arch_init(struct led_strip *strip);
+void led_strip_arch_start(struct led_strip *strip);
+
+#endif //LED_STRIP_ARCH_H_
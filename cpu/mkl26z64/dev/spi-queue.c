@@ -0,0 +1,176 @@
+//+------------------------------------------------------------------------------------------------+
+//| DMA driven SPI transaction queue for Kinetis MKL26 MCU.                                        |
+//|                                                                                                |
+//| Every line of a transaction is a block transfer of both DMA channels. Only the receive channel |
+//| interrupts, once the last frame of the line has been received (and thus fully sent); the next  |
+//| line is then started, or the transaction completed. The frame size and data/command line are  |
+//| changed between transactions only, when the SPI is idle.                                       |
+//|                                                                                                |
+//| 16 bit frames use the 16 bit mode of the SPI, in which the DMA accesses the DH:DL pair as a    |
+//| single halfword.                                                                               |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "spi-queue.h"
+
+#include "mkl26.h"
+#include "mkl26-sim.h"
+#include "mkl26-port.h"
+#include "mkl26-gpio.h"
+#include "mkl26-spi.h"
+#include "mkl26-dma.h"
+#include "mkl26-dmamux.h"
+
+//DMA channels used by the queue.
+#define TX_CHANNEL 1
+#define RX_CHANNEL 2
+
+//Chip select and data/command pins (on port C).
+#define CS_PIN 4
+#define DC_PIN 3
+
+//SPI clock: 24MHz bus / 1 / 2 = 12MHz.
+#define SPI_BR_BAUD ((0 << SPI_BR_SPPR_Pos) | (0 << SPI_BR_SPR_Pos))
+
+//SPI configuration, besides the enable bit and the frame size.
+#define SPI_C1_CONFIG (SPI_C1_MSTR_Master | SPI_C1_CPOL_High | SPI_C1_CPHA_Middle | \
+                       SPI_C1_LSBFE_MSB)
+#define SPI_C2_CONFIG (SPI_C2_TXDMAE_Enabled | SPI_C2_RXDMAE_Enabled)
+
+//Interrupt priority.
+#define DMA_PRIORITY 1
+
+//Transaction queue. The head is the transaction being sent.
+static struct spi_transaction *head = NULL;
+static struct spi_transaction *tail = NULL;
+static uint16_t line;
+
+//Received frames are dropped here.
+static uint16_t discard;
+
+//Programs both channels for a line of the current transaction and starts them.
+static void start_line() {
+  const uint8_t *src = (const uint8_t *) head->data + (uint32_t) line * head->stride;
+  uint32_t sizes, bytes;
+
+  if (head->flags & SPI_QUEUE_16BIT) {
+    sizes = DMA_DCR_SSIZE_16Bit | DMA_DCR_DSIZE_16Bit;
+    bytes = head->frames * 2;
+  } else {
+    sizes = DMA_DCR_SSIZE_8Bit | DMA_DCR_DSIZE_8Bit;
+    bytes = head->frames;
+  }
+
+  //The receive channel must be ready before the first frame is written.
+  DMA->CH[RX_CHANNEL].DSR_BCR = DMA_DSR_BCR_DONE_Set;
+  DMA->CH[RX_CHANNEL].DSR_BCR = bytes;
+  DMA->CH[RX_CHANNEL].DCR = DMA_DCR_EINT_Enabled | DMA_DCR_ERQ_Enabled | DMA_DCR_CS_Single |
+                            DMA_DCR_D_REQ_Enabled | sizes;
+
+  DMA->CH[TX_CHANNEL].DSR_BCR = DMA_DSR_BCR_DONE_Set;
+  DMA->CH[TX_CHANNEL].SAR = (uint32_t) src;
+  DMA->CH[TX_CHANNEL].DSR_BCR = bytes;
+  DMA->CH[TX_CHANNEL].DCR = DMA_DCR_ERQ_Enabled | DMA_DCR_CS_Single | DMA_DCR_D_REQ_Enabled |
+                            DMA_DCR_SINC_Enabled | sizes;
+}
+
+//Starts the transaction at the head of the queue. The SPI must be idle.
+static void start_transaction() {
+  //The frame size can only be changed while the module is disabled.
+  SPI0->C1 = SPI_C1_CONFIG | SPI_C1_SPE_Disabled;
+  SPI0->C2 = SPI_C2_CONFIG |
+             ((head->flags & SPI_QUEUE_16BIT) ? SPI_C2_SPIMODE_16Bit : SPI_C2_SPIMODE_8Bit);
+  SPI0->C1 = SPI_C1_CONFIG | SPI_C1_SPE_Enabled;
+
+  if (head->flags & SPI_QUEUE_DC_HIGH)
+    GPIOC->PSOR = 1 << DC_PIN;
+  else
+    GPIOC->PCOR = 1 << DC_PIN;
+  GPIOC->PCOR = 1 << CS_PIN;
+
+  line = 0;
+  start_line();
+}
+
+void spi_queue_init() {
+  //Enable the module clocks and route the pins. Chip select starts deasserted.
+  SIM->SCGC4 |= SIM_SCGC4_SPI0_Enabled;
+  SIM->SCGC6 |= SIM_SCGC6_DMAMUX_Enabled;
+  SIM->SCGC7 |= SIM_SCGC7_DMA_Enabled;
+  PORTC->PCR[6] = PORT_PCR_MUX_Alt2 | PORT_PCR_DSE_High;
+  PORTC->PCR[5] = PORT_PCR_MUX_Alt2 | PORT_PCR_DSE_High;
+  PORTC->PCR[CS_PIN] = PORT_PCR_MUX_Gpio | PORT_PCR_DSE_High;
+  PORTC->PCR[DC_PIN] = PORT_PCR_MUX_Gpio | PORT_PCR_DSE_High;
+  GPIOC->PSOR = (1 << CS_PIN) | (1 << DC_PIN);
+  GPIOC->PDDR |= (1 << CS_PIN) | (1 << DC_PIN);
+
+  //Master mode, with DMA requests for both directions.
+  SPI0->C1 = SPI_C1_CONFIG | SPI_C1_SPE_Disabled;
+  SPI0->BR = SPI_BR_BAUD;
+  SPI0->C2 = SPI_C2_CONFIG | SPI_C2_SPIMODE_8Bit;
+  SPI0->C1 = SPI_C1_CONFIG | SPI_C1_SPE_Enabled;
+
+  //Both channels are reprogrammed for every line, and stop at the end of it.
+  DMAMUX->CHCFG[TX_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->CH[TX_CHANNEL].DCR = 0;
+  DMA->CH[TX_CHANNEL].DSR_BCR = DMA_DSR_BCR_DONE_Set;
+  DMA->CH[TX_CHANNEL].DAR = (uint32_t) &SPI0->DL;
+  DMAMUX->CHCFG[TX_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_SPI0_Tx;
+
+  DMAMUX->CHCFG[RX_CHANNEL] = DMAMUX_CHCFG_ENBL_Disabled;
+  DMA->CH[RX_CHANNEL].DCR = 0;
+  DMA->CH[RX_CHANNEL].DSR_BCR = DMA_DSR_BCR_DONE_Set;
+  DMA->CH[RX_CHANNEL].SAR = (uint32_t) &SPI0->DL;
+  DMA->CH[RX_CHANNEL].DAR = (uint32_t) &discard;
+  DMAMUX->CHCFG[RX_CHANNEL] = DMAMUX_CHCFG_ENBL_Enabled | DMAMUX_SOURCE_SPI0_Rx;
+
+  NVIC_SetPriority(DmaChannel_2_IRQn, DMA_PRIORITY);
+  NVIC_EnableIRQ(DmaChannel_2_IRQn);
+}
+
+//Appends a transaction to the queue, starting it right away if the queue was idle. May be called
+//from completion callbacks.
+void spi_queue_submit(struct spi_transaction *t) {
+  t->next = NULL;
+
+  NVIC_DisableIRQ(DmaChannel_2_IRQn);
+  if (head == NULL) {
+    head = tail = t;
+    start_transaction();
+  } else {
+    tail->next = t;
+    tail = t;
+  }
+  NVIC_EnableIRQ(DmaChannel_2_IRQn);
+}
+
+int spi_queue_idle() {
+  return head == NULL;
+}
+
+void dma_channel_2_handler() {
+  struct spi_transaction *done;
+
+  DMA->CH[RX_CHANNEL].DSR_BCR = DMA_DSR_BCR_DONE_Set;
+
+  //Move on to the next line, if any.
+  if (++line < head->lines) {
+    start_line();
+    return;
+  }
+
+  //The transaction is over. Start the next one before running the callback, so the SPI is kept
+  //busy meanwhile.
+  done = head;
+  head = head->next;
+  if (head != NULL)
+    start_transaction();
+  else
+    GPIOC->PSOR = 1 << CS_PIN;
+
+  if (done->callback != NULL)
+    done->callback(done);
+}
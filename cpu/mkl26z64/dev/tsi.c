@@ -0,0 +1,255 @@
+//+------------------------------------------------------------------------------------------------+
+//| Capacitive touch sensing driver for Kinetis MKL26 MCU.                                         |
+//|                                                                                                |
+//| Filtered counts and baselines are kept with 4 fractional bits, so slow tracking doesn't get    |
+//| stuck on rounding.                                                                             |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "tsi.h"
+
+#include "mkl26.h"
+#include "mkl26-sim.h"
+#include "mkl26-port.h"
+#include "mkl26-tsi.h"
+#include "mkl26-lptmr.h"
+#include "mkl26-llwu.h"
+
+//Interrupt priority.
+#define TSI_PRIORITY 3
+
+//Scans that calibrate the baselines.
+#define CALIBRATION_SCANS 16
+
+//Filter and baseline tracking speeds, as right shifts of the difference per scan.
+#define FILTER_SHIFT 2
+#define BASELINE_SHIFT 6
+
+//Fractional bits of filtered counts and baselines.
+#define FRACTION_BITS 4
+
+//Module configuration: 8uA reference and 4uA electrode currents, electrode oscillator divided by 4
+//and 10 periods per scan. Scans are triggered by the LPTMR and keep running in low power modes.
+#define GENCS_CONFIG (TSI_GENCS_TSIEN_Enabled | TSI_GENCS_TSIIEN_Enabled | \
+                      TSI_GENCS_STPE_Enabled | TSI_GENCS_STM_Hardware | \
+                      TSI_GENCS_MODE_Capacitive | TSI_GENCS_REFCHRG_8uA | TSI_GENCS_EXTCHRG_4uA | \
+                      TSI_GENCS_DVOLT_1_03V | (2 << TSI_GENCS_PS_Pos) | (9 << TSI_GENCS_NSCN_Pos))
+
+struct electrode {
+  uint8_t channel;
+  uint8_t calibration;    //Calibration scans left
+  uint8_t debounce;       //Consecutive scans over the threshold
+  uint32_t filtered;
+  uint32_t baseline;
+};
+
+//Port and pin of each channel.
+static volatile struct PORT_type * const channel_ports[16] = {
+  PORTB, PORTA, PORTA, PORTA, PORTA, PORTA, PORTB, PORTB,
+  PORTB, PORTB, PORTB, PORTB, PORTB, PORTC, PORTC, PORTC,
+};
+static const uint8_t channel_pins[16] = {
+  0, 0, 1, 2, 3, 4, 1, 2,
+  3, 16, 17, 18, 19, 0, 1, 2,
+};
+
+static struct electrode electrodes[TSI_ELECTRODES];
+static uint8_t electrode_count;
+static uint8_t current;
+static volatile uint32_t touched;
+static volatile uint8_t armed;
+static struct process *requester;
+
+process_event_t tsi_event;
+
+PROCESS(tsi_process, "TSI");
+
+//--------------------------------------------------------------------------------------------------
+
+//Selects the electrode measured by the next scans.
+static void select_electrode(uint8_t index) {
+  current = index;
+  TSI->DATA = electrodes[index].channel << TSI_DATA_TSICH_Pos;
+}
+
+//Starts scanning the electrodes in turn, with end of scan interrupts.
+static void start_scanning() {
+  TSI->GENCS = 0;
+  LLWU->ME &= ~LLWU_ME_WUME4_TSI0;
+  select_electrode(current);
+  TSI->GENCS = GENCS_CONFIG | TSI_GENCS_ESOR_End_Of_Scan | TSI_GENCS_EOSF_Set |
+               TSI_GENCS_OUTRGF_Set;
+}
+
+//Processes a scan result. Returns nonzero if the electrode changed state.
+static int update(struct electrode *e, uint32_t bit, uint16_t count) {
+  uint32_t value = count << FRACTION_BITS;
+  int32_t signal, threshold;
+
+  //Calibration: settle the filter, then take the baseline.
+  if (e->calibration > 0) {
+    if (e->calibration == CALIBRATION_SCANS)
+      e->filtered = value;
+    else
+      e->filtered += ((int32_t) (value - e->filtered)) >> FILTER_SHIFT;
+    if (--e->calibration == 0)
+      e->baseline = e->filtered;
+    return 0;
+  }
+
+  e->filtered += ((int32_t) (value - e->filtered)) >> FILTER_SHIFT;
+  signal = e->filtered - e->baseline;
+  threshold = e->baseline >> TSI_THRESHOLD;
+
+  if (touched & bit) {
+    //Released once the signal falls under half the threshold.
+    if (signal < threshold / 2) {
+      touched &= ~bit;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (signal > threshold) {
+    if (++e->debounce >= TSI_DEBOUNCE) {
+      e->debounce = 0;
+      touched |= bit;
+      return 1;
+    }
+    return 0;
+  }
+
+  //Not touched: track the baseline, at once if the count dropped below it.
+  e->debounce = 0;
+  if (signal < 0)
+    e->baseline = e->filtered;
+  else
+    e->baseline += signal >> BASELINE_SHIFT;
+
+  return 0;
+}
+
+//Initializes the driver with the given TSI channels (up to TSI_ELECTRODES), and starts scanning
+//them. Electrodes are numbered in the order given.
+void tsi_init(const uint8_t *channels, uint8_t count) {
+  uint8_t i;
+
+  if (count > TSI_ELECTRODES)
+    count = TSI_ELECTRODES;
+
+  requester = PROCESS_CURRENT();
+  tsi_event = process_alloc_event();
+  process_start(&tsi_process, NULL);
+
+  SIM->SCGC5 |= SIM_SCGC5_TSI_Enabled | SIM_SCGC5_LPTMR_Enabled;
+
+  electrode_count = count;
+  touched = 0;
+  armed = 0;
+  for (i = 0; i < count; i++) {
+    electrodes[i].channel = channels[i];
+    electrodes[i].calibration = CALIBRATION_SCANS;
+    electrodes[i].debounce = 0;
+    channel_ports[channels[i]]->PCR[channel_pins[channels[i]]] = PORT_PCR_MUX_Analog;
+  }
+
+  //Scan trigger: the LPTMR counting LPO cycles (1ms each).
+  LPTMR0->CSR = 0;
+  LPTMR0->PSR = LPTMR_PSR_PCS_LPO | LPTMR_PSR_PBYP_Bypassed;
+  LPTMR0->CMR = TSI_SCAN_PERIOD - 1;
+  LPTMR0->CSR = LPTMR_CSR_TEN_Enabled | LPTMR_CSR_TMS_Time | LPTMR_CSR_TFC_Reset;
+
+  current = 0;
+  start_scanning();
+
+  NVIC_SetPriority(TSI_0_IRQn, TSI_PRIORITY);
+  NVIC_EnableIRQ(TSI_0_IRQn);
+}
+
+//Returns a bitmask of the touched electrodes.
+uint32_t tsi_touched() {
+  return touched;
+}
+
+//Returns the filtered count of an electrode minus its baseline, without fractional bits.
+int32_t tsi_signal(uint8_t electrode) {
+  return ((int32_t) (electrodes[electrode].filtered - electrodes[electrode].baseline)) >>
+         FRACTION_BITS;
+}
+
+uint16_t tsi_baseline(uint8_t electrode) {
+  return electrodes[electrode].baseline >> FRACTION_BITS;
+}
+
+//Keeps only the given electrode scanned, interrupting when it's touched, and enables the TSI as a
+//low leakage wakeup source. The electrode must be calibrated already.
+void tsi_wake_arm(uint8_t electrode) {
+  struct electrode *e = &electrodes[electrode];
+  uint32_t high = (e->baseline + (e->baseline >> TSI_THRESHOLD)) >> FRACTION_BITS;
+
+  NVIC_DisableIRQ(TSI_0_IRQn);
+
+  TSI->GENCS = 0;
+  select_electrode(electrode);
+  TSI->TSHD = (high << TSI_TSHD_THRESH_Pos) | (0 << TSI_TSHD_THRESL_Pos);
+  TSI->GENCS = GENCS_CONFIG | TSI_GENCS_ESOR_Out_Of_Range | TSI_GENCS_EOSF_Set |
+               TSI_GENCS_OUTRGF_Set;
+  LLWU->ME |= LLWU_ME_WUME4_TSI0;
+  armed = 1;
+
+  NVIC_EnableIRQ(TSI_0_IRQn);
+}
+
+//Resumes scanning all electrodes.
+void tsi_wake_disarm() {
+  NVIC_DisableIRQ(TSI_0_IRQn);
+  armed = 0;
+  start_scanning();
+  NVIC_EnableIRQ(TSI_0_IRQn);
+}
+
+//End of scan or out of range.
+void tsi_0_handler() {
+  uint32_t gencs = TSI->GENCS;
+  uint16_t count = TSI->DATA & TSI_DATA_TSICNT_Msk;
+  struct electrode *e = &electrodes[current];
+  uint32_t bit = 1 << current;
+
+  //Clear the flags.
+  TSI->GENCS = gencs;
+
+  //Touch while armed: report it and go back to scanning.
+  if (armed) {
+    if (gencs & TSI_GENCS_OUTRGF_Msk) {
+      armed = 0;
+      e->debounce = 0;
+      touched |= bit;
+      start_scanning();
+      process_poll(&tsi_process);
+    }
+    return;
+  }
+
+  if (!(gencs & TSI_GENCS_EOSF_Msk))
+    return;
+
+  if (update(e, bit, count))
+    process_poll(&tsi_process);
+
+  select_electrode((current + 1 < electrode_count) ? current + 1 : 0);
+}
+
+//Notifies the requester of touch state changes.
+PROCESS_THREAD(tsi_process, ev, data) {
+  PROCESS_BEGIN();
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    process_post(requester, tsi_event, NULL);
+  }
+
+  PROCESS_END();
+}
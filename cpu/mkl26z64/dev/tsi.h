@@ -0,0 +1,73 @@
+//+------------------------------------------------------------------------------------------------+
+//| Capacitive touch sensing driver for Kinetis MKL26 MCU.                                         |
+//|                                                                                                |
+//| Electrodes are scanned by the TSI in hardware trigger mode: the LPTMR (clocked by the 1KHz     |
+//| LPO) starts a scan every TSI_SCAN_PERIOD milliseconds, taking the electrodes in turn. The end  |
+//| of scan interrupt filters the count, tracks the baseline of the electrode and decides whether  |
+//| it is touched, so the CPU only runs once per scan and processes are only notified of changes.  |
+//|                                                                                                |
+//| Per scan, the count goes through a first order low pass filter. While an electrode isn't       |
+//| touched, its baseline slowly follows the filtered count (drifts due to temperature, humidity,  |
+//| etc.), and follows it at once if the count drops below it. An electrode is touched when the    |
+//| filtered count exceeds the baseline by TSI_THRESHOLD (a fraction of the baseline) for          |
+//| TSI_DEBOUNCE scans in a row, and released when it falls under half that. The first scans after |
+//| initialization calibrate the baselines, so electrodes must not be touched meanwhile.           |
+//|                                                                                                |
+//| For low power operation, tsi_wake_arm() keeps a single electrode scanned with the out of range |
+//| interrupt only, and enables the TSI as a low leakage wakeup source. The TSI and the LPTMR keep |
+//| running in STOP, VLPS and LLS modes, so a touch interrupts (and wakes) the CPU. Scanning of    |
+//| all electrodes resumes after that touch, or with tsi_wake_disarm().                            |
+//|                                                                                                |
+//| Channels and pins (Teensy LC pin numbers in parenthesis): 0 PTB0 (16), 2 PTA1 (3), 3 PTA2 (4), |
+//| 6 PTB1 (17), 7 PTB2 (19), 8 PTB3 (18), 9 PTB16 (0), 10 PTB17 (1), 13 PTC0 (15), 14 PTC1 (22)   |
+//| and 15 PTC2 (23). Channels 9 and 10 share the console pins. The LPTMR is taken by the driver.  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef TSI_H_
+#define TSI_H_
+
+#include <stdint.h>
+
+#include "contiki.h"
+
+//Maximum number of electrodes.
+#ifdef TSI_CONF_ELECTRODES
+#define TSI_ELECTRODES TSI_CONF_ELECTRODES
+#else
+#define TSI_ELECTRODES 8
+#endif
+
+//Time between scans, in milliseconds (each scan measures one electrode).
+#ifdef TSI_CONF_SCAN_PERIOD
+#define TSI_SCAN_PERIOD TSI_CONF_SCAN_PERIOD
+#else
+#define TSI_SCAN_PERIOD 5
+#endif
+
+//Touch threshold, as a right shift of the baseline (3 means 1/8 of it).
+#ifdef TSI_CONF_THRESHOLD
+#define TSI_THRESHOLD TSI_CONF_THRESHOLD
+#else
+#define TSI_THRESHOLD 3
+#endif
+
+//Consecutive scans over the threshold needed for a touch.
+#ifdef TSI_CONF_DEBOUNCE
+#define TSI_DEBOUNCE TSI_CONF_DEBOUNCE
+#else
+#define TSI_DEBOUNCE 2
+#endif
+
+//Event posted to the process that initialized the driver whenever the touched electrodes change.
+extern process_event_t tsi_event;
+
+void tsi_init(const uint8_t *channels, uint8_t count);
+uint32_t tsi_touched();
+int32_t tsi_signal(uint8_t electrode);
+uint16_t tsi_baseline(uint8_t electrode);
+void tsi_wake_arm(uint8_t electrode);
+void tsi_wake_disarm();
+
+#endif //TSI_H_
@@ -0,0 +1,73 @@
+//+------------------------------------------------------------------------------------------------+
+//| DMA (direct memory access) peripheral registers for Kinetis MKL26 MCU.                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MKL26_DMA_H_
+#define MKL26_DMA_H_
+
+#include <stdint.h>
+
+struct DMA_channel_type {
+  uint32_t SAR;           //Source address register
+  uint32_t DAR;           //Destination address register
+  uint32_t DSR_BCR;       //DMA status register/byte count register
+  uint32_t DCR;           //DMA control register
+};
+
+struct DMA_type {
+  struct DMA_channel_type CH[4];
+};
+
+#define DMA ((volatile struct DMA_type *) 0x40008100)
+
+//DMA status register/byte count register bitfields
+#define DMA_DSR_BCR_BCR_Msk     0x00FFFFFF  //Bytes yet to be transferred for block
+#define DMA_DSR_BCR_BCR_Pos     0
+#define DMA_DSR_BCR_DONE_Msk    0x01000000  //Transactions done
+#define DMA_DSR_BCR_DONE_Set    (1 << 24)
+#define DMA_DSR_BCR_BSY_Msk     0x02000000  //Busy
+#define DMA_DSR_BCR_REQ_Msk     0x04000000  //Request
+#define DMA_DSR_BCR_BED_Msk     0x10000000  //Bus error on destination
+#define DMA_DSR_BCR_BES_Msk     0x20000000  //Bus error on source
+#define DMA_DSR_BCR_CE_Msk      0x40000000  //Configuration error
+
+//DMA control register bitfields
+#define DMA_DCR_LCH2_Msk              0x00000003  //Link channel 2
+#define DMA_DCR_LCH2_Pos              0
+#define DMA_DCR_LCH1_Msk              0x0000000C  //Link channel 1
+#define DMA_DCR_LCH1_Pos              2
+#define DMA_DCR_LINKCC_None           (0 << 4)  //Link channel control
+#define DMA_DCR_LINKCC_Cycle_BCR      (1 << 4)
+#define DMA_DCR_LINKCC_Cycle          (2 << 4)
+#define DMA_DCR_LINKCC_BCR            (3 << 4)
+#define DMA_DCR_D_REQ_Disabled        (0 << 7)  //Disable request (clear ERQ when BCR reaches zero)
+#define DMA_DCR_D_REQ_Enabled         (1 << 7)
+#define DMA_DCR_DMOD_Msk              0x00000F00  //Destination address modulo
+#define DMA_DCR_DMOD_Pos              8
+#define DMA_DCR_SMOD_Msk              0x0000F000  //Source address modulo
+#define DMA_DCR_SMOD_Pos              12
+#define DMA_DCR_START_Set             (1 << 16) //Start transfer
+#define DMA_DCR_DSIZE_32Bit           (0 << 17) //Destination size
+#define DMA_DCR_DSIZE_8Bit            (1 << 17)
+#define DMA_DCR_DSIZE_16Bit           (2 << 17)
+#define DMA_DCR_DINC_Disabled         (0 << 19) //Destination increment
+#define DMA_DCR_DINC_Enabled          (1 << 19)
+#define DMA_DCR_SSIZE_32Bit           (0 << 20) //Source size
+#define DMA_DCR_SSIZE_8Bit            (1 << 20)
+#define DMA_DCR_SSIZE_16Bit           (2 << 20)
+#define DMA_DCR_SINC_Disabled         (0 << 22) //Source increment
+#define DMA_DCR_SINC_Enabled          (1 << 22)
+#define DMA_DCR_EADREQ_Disabled       (0 << 23) //Enable asynchronous DMA requests
+#define DMA_DCR_EADREQ_Enabled        (1 << 23)
+#define DMA_DCR_AA_Disabled           (0 << 28) //Auto-align
+#define DMA_DCR_AA_Enabled            (1 << 28)
+#define DMA_DCR_CS_Continuous         (0 << 29) //Cycle steal
+#define DMA_DCR_CS_Single             (1 << 29)
+#define DMA_DCR_ERQ_Disabled          (0 << 30) //Enable peripheral request
+#define DMA_DCR_ERQ_Enabled           (1 << 30)
+#define DMA_DCR_EINT_Disabled         (0 << 31) //Enable interrupt on completion of transfer
+#define DMA_DCR_EINT_Enabled          (1 << 31)
+
+#endif //MKL26_DMA_H_
@@ -0,0 +1,66 @@
+//+------------------------------------------------------------------------------------------------+
+//| DMAMUX (DMA request multiplexer) peripheral registers for Kinetis MKL26 MCU.                   |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MKL26_DMAMUX_H_
+#define MKL26_DMAMUX_H_
+
+#include <stdint.h>
+
+struct DMAMUX_type {
+  uint8_t CHCFG[4];       //Channel configuration registers
+};
+
+#define DMAMUX ((volatile struct DMAMUX_type *) 0x40021000)
+
+//Channel configuration register bitfields
+#define DMAMUX_CHCFG_SOURCE_Msk       0x3F      //DMA channel source (slot)
+#define DMAMUX_CHCFG_SOURCE_Pos       0
+#define DMAMUX_CHCFG_TRIG_Disabled    (0 << 6)  //DMA channel trigger enable
+#define DMAMUX_CHCFG_TRIG_Enabled     (1 << 6)
+#define DMAMUX_CHCFG_ENBL_Disabled    (0 << 7)  //DMA channel enable
+#define DMAMUX_CHCFG_ENBL_Enabled     (1 << 7)
+
+//DMA request sources
+#define DMAMUX_SOURCE_UART0_Rx        2
+#define DMAMUX_SOURCE_UART0_Tx        3
+#define DMAMUX_SOURCE_UART1_Rx        4
+#define DMAMUX_SOURCE_UART1_Tx        5
+#define DMAMUX_SOURCE_UART2_Rx        6
+#define DMAMUX_SOURCE_UART2_Tx        7
+#define DMAMUX_SOURCE_I2S0_Rx         14
+#define DMAMUX_SOURCE_I2S0_Tx         15
+#define DMAMUX_SOURCE_SPI0_Rx         16
+#define DMAMUX_SOURCE_SPI0_Tx         17
+#define DMAMUX_SOURCE_SPI1_Rx         18
+#define DMAMUX_SOURCE_SPI1_Tx         19
+#define DMAMUX_SOURCE_I2C0            22
+#define DMAMUX_SOURCE_I2C1            23
+#define DMAMUX_SOURCE_TPM0_CH0        24
+#define DMAMUX_SOURCE_TPM0_CH1        25
+#define DMAMUX_SOURCE_TPM0_CH2        26
+#define DMAMUX_SOURCE_TPM0_CH3        27
+#define DMAMUX_SOURCE_TPM0_CH4        28
+#define DMAMUX_SOURCE_TPM0_CH5        29
+#define DMAMUX_SOURCE_TPM1_CH0        32
+#define DMAMUX_SOURCE_TPM1_CH1        33
+#define DMAMUX_SOURCE_TPM2_CH0        34
+#define DMAMUX_SOURCE_TPM2_CH1        35
+#define DMAMUX_SOURCE_ADC0            40
+#define DMAMUX_SOURCE_CMP0            42
+#define DMAMUX_SOURCE_DAC0            45
+#define DMAMUX_SOURCE_PORTA           49
+#define DMAMUX_SOURCE_PORTC           51
+#define DMAMUX_SOURCE_PORTD           52
+#define DMAMUX_SOURCE_TPM0_Overflow   54
+#define DMAMUX_SOURCE_TPM1_Overflow   55
+#define DMAMUX_SOURCE_TPM2_Overflow   56
+#define DMAMUX_SOURCE_TSI             57
+#define DMAMUX_SOURCE_AlwaysOn0       60
+#define DMAMUX_SOURCE_AlwaysOn1       61
+#define DMAMUX_SOURCE_AlwaysOn2       62
+#define DMAMUX_SOURCE_AlwaysOn3       63
+
+#endif //MKL26_DMAMUX_H_
@@ -0,0 +1,53 @@
+//+------------------------------------------------------------------------------------------------+
+//| LLWU (low leakage wakeup unit) registers for Kinetis MKL26 MCU.                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MKL26_LLWU_H_
+#define MKL26_LLWU_H_
+
+#include <stdint.h>
+
+struct LLWU_type {
+  uint8_t PE[4];        //Pin enable registers (4 pins each, LLWU_P0 onwards)
+  uint8_t ME;           //Module enable register
+  uint8_t F[2];         //Pin flag registers (8 pins each, LLWU_P0 onwards)
+  uint8_t F3;           //Module flag register
+  uint8_t FILT1;        //Pin filter 1 register
+  uint8_t FILT2;        //Pin filter 2 register
+};
+
+#define LLWU ((volatile struct LLWU_type *) 0x4007C000)
+
+//Pin enable register bitfields (wakeup pin n is configured in PE[n / 4])
+#define LLWU_PE_WUPE_Disabled(n)  (0 << (2 * ((n) % 4)))  //Wakeup pin enable
+#define LLWU_PE_WUPE_Rising(n)    (1 << (2 * ((n) % 4)))
+#define LLWU_PE_WUPE_Falling(n)   (2 << (2 * ((n) % 4)))
+#define LLWU_PE_WUPE_Any(n)       (3 << (2 * ((n) % 4)))
+#define LLWU_PE_WUPE_Msk(n)       (3 << (2 * ((n) % 4)))
+
+//Module enable register bitfields
+#define LLWU_ME_WUME0_LPTMR0    (1 << 0)  //Wakeup module enables
+#define LLWU_ME_WUME1_CMP0      (1 << 1)
+#define LLWU_ME_WUME4_TSI0      (1 << 4)
+#define LLWU_ME_WUME5_RTC_Alarm (1 << 5)
+#define LLWU_ME_WUME7_RTC_Sec   (1 << 7)
+
+//Module flag register bitfields (flags are cleared through the module)
+#define LLWU_F3_MWUF0_LPTMR0    (1 << 0)  //Wakeup module flags
+#define LLWU_F3_MWUF1_CMP0      (1 << 1)
+#define LLWU_F3_MWUF4_TSI0      (1 << 4)
+#define LLWU_F3_MWUF5_RTC_Alarm (1 << 5)
+#define LLWU_F3_MWUF7_RTC_Sec   (1 << 7)
+
+//Pin filter register bitfields
+#define LLWU_FILT_FILTSEL_Msk       0x0F        //Filter pin select
+#define LLWU_FILT_FILTSEL_Pos       0
+#define LLWU_FILT_FILTE_Disabled    (0 << 5)    //Digital filter on external pin
+#define LLWU_FILT_FILTE_Rising      (1 << 5)
+#define LLWU_FILT_FILTE_Falling     (2 << 5)
+#define LLWU_FILT_FILTE_Any         (3 << 5)
+#define LLWU_FILT_FILTF_Msk         0x80        //Filter detect flag
+
+#endif //MKL26_LLWU_H_
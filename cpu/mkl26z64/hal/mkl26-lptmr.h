@@ -0,0 +1,54 @@
+//+------------------------------------------------------------------------------------------------+
+//| LPTMR (low power timer) peripheral registers for Kinetis MKL26 MCU.                            |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MKL26_LPTMR_H_
+#define MKL26_LPTMR_H_
+
+#include <stdint.h>
+
+struct LPTMR_type {
+  uint32_t CSR;           //Control status register
+  uint32_t PSR;           //Prescale register
+  uint32_t CMR;           //Compare register
+  uint32_t CNR;           //Counter register
+};
+
+#define LPTMR0 ((volatile struct LPTMR_type *) 0x40040000)
+
+//Control status register bitfields
+#define LPTMR_CSR_TEN_Disabled      (0 << 0)    //Timer enable
+#define LPTMR_CSR_TEN_Enabled       (1 << 0)
+#define LPTMR_CSR_TMS_Time          (0 << 1)    //Timer mode select
+#define LPTMR_CSR_TMS_Pulse         (1 << 1)
+#define LPTMR_CSR_TFC_Reset         (0 << 2)    //Timer free running counter
+#define LPTMR_CSR_TFC_Free_Running  (1 << 2)
+#define LPTMR_CSR_TPP_Active_High   (0 << 3)    //Timer pin polarity
+#define LPTMR_CSR_TPP_Active_Low    (1 << 3)
+#define LPTMR_CSR_TPS_Input_0       (0 << 4)    //Timer pin select
+#define LPTMR_CSR_TPS_Input_1       (1 << 4)
+#define LPTMR_CSR_TPS_Input_2       (2 << 4)
+#define LPTMR_CSR_TPS_Input_3       (3 << 4)
+#define LPTMR_CSR_TIE_Disabled      (0 << 6)    //Timer interrupt enable
+#define LPTMR_CSR_TIE_Enabled       (1 << 6)
+#define LPTMR_CSR_TCF_Msk           0x00000080  //Timer compare flag
+#define LPTMR_CSR_TCF_Clear         (0 << 7)
+#define LPTMR_CSR_TCF_Set           (1 << 7)
+
+//Prescale register bitfields
+#define LPTMR_PSR_PCS_MCGIRCLK        (0 << 0)  //Prescaler clock select
+#define LPTMR_PSR_PCS_LPO             (1 << 0)
+#define LPTMR_PSR_PCS_ERCLK32K        (2 << 0)
+#define LPTMR_PSR_PCS_OSCERCLK        (3 << 0)
+#define LPTMR_PSR_PBYP_Enabled        (0 << 2)  //Prescaler bypass
+#define LPTMR_PSR_PBYP_Bypassed       (1 << 2)
+#define LPTMR_PSR_PRESCALE_Msk        0x00000078  //Prescale value (power of two, starting at 2)
+#define LPTMR_PSR_PRESCALE_Pos        3
+
+//Compare and counter register bitfields
+#define LPTMR_CMR_COMPARE_Msk   0x0000FFFF
+#define LPTMR_CNR_COUNTER_Msk   0x0000FFFF
+
+#endif //MKL26_LPTMR_H_
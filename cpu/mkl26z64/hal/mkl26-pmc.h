@@ -0,0 +1,46 @@
+//+------------------------------------------------------------------------------------------------+
+//| PMC (power management controller) registers for Kinetis MKL26 MCU.                             |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MKL26_PMC_H_
+#define MKL26_PMC_H_
+
+#include <stdint.h>
+
+struct PMC_type {
+  uint8_t LVDSC1;     //Low voltage detect status and control 1 register
+  uint8_t LVDSC2;     //Low voltage detect status and control 2 register
+  uint8_t REGSC;      //Regulator status and control register
+};
+
+#define PMC ((volatile struct PMC_type *) 0x4007D000)
+
+//Low voltage detect status and control 1 register bitfields
+#define PMC_LVDSC1_LVDV_Low         (0 << 0)  //Low voltage detect voltage select
+#define PMC_LVDSC1_LVDV_High        (1 << 0)
+#define PMC_LVDSC1_LVDRE_Disabled   (0 << 4)  //Low voltage detect reset enable
+#define PMC_LVDSC1_LVDRE_Enabled    (1 << 4)
+#define PMC_LVDSC1_LVDIE_Disabled   (0 << 5)  //Low voltage detect interrupt enable
+#define PMC_LVDSC1_LVDIE_Enabled    (1 << 5)
+#define PMC_LVDSC1_LVDACK           (1 << 6)  //Low voltage detect acknowledge (write 1 to clear)
+#define PMC_LVDSC1_LVDF             (1 << 7)  //Low voltage detect flag
+
+//Low voltage detect status and control 2 register bitfields
+#define PMC_LVDSC2_LVWV_Msk         0x03      //Low voltage warning voltage select
+#define PMC_LVDSC2_LVWV_Pos         0
+#define PMC_LVDSC2_LVWIE_Disabled   (0 << 5)  //Low voltage warning interrupt enable
+#define PMC_LVDSC2_LVWIE_Enabled    (1 << 5)
+#define PMC_LVDSC2_LVWACK           (1 << 6)  //Low voltage warning acknowledge (write 1 to clear)
+#define PMC_LVDSC2_LVWF             (1 << 7)  //Low voltage warning flag
+
+//Regulator status and control register bitfields
+#define PMC_REGSC_BGBE_Disabled     (0 << 0)  //Bandgap buffer enable
+#define PMC_REGSC_BGBE_Enabled      (1 << 0)
+#define PMC_REGSC_REGONS            (1 << 2)  //Regulator in run regulation status
+#define PMC_REGSC_ACKISO            (1 << 3)  //Pins held since VLLS wakeup (write 1 to release)
+#define PMC_REGSC_BGEN_Disabled     (0 << 4)  //Bandgap enable in VLPx operation
+#define PMC_REGSC_BGEN_Enabled      (1 << 4)
+
+#endif //MKL26_PMC_H_
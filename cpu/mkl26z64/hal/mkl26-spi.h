@@ -0,0 +1,79 @@
+//+------------------------------------------------------------------------------------------------+
+//| SPI peripheral registers for Kinetis MKL26 MCU.                                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MKL26_SPI_H_
+#define MKL26_SPI_H_
+
+#include <stdint.h>
+
+struct SPI_type {
+  uint8_t S;              //SPI status register
+  uint8_t BR;             //SPI baud rate register
+  uint8_t C2;             //SPI control register 2
+  uint8_t C1;             //SPI control register 1
+  uint8_t ML;             //SPI match register low
+  uint8_t MH;             //SPI match register high
+  uint8_t DL;             //SPI data register low
+  uint8_t DH;             //SPI data register high
+  uint8_t reserved0[2];
+  uint8_t CI;             //SPI clear interrupt register (SPI1 only)
+  uint8_t C3;             //SPI control register 3 (SPI1 only)
+};
+
+#define SPI0 ((volatile struct SPI_type *) 0x40076000)
+#define SPI1 ((volatile struct SPI_type *) 0x40077000)
+
+//SPI status register bitfields
+#define SPI_S_RFIFOEF_Msk   0x01  //SPI read FIFO empty flag
+#define SPI_S_TXFULLF_Msk   0x02  //Transmit FIFO full flag
+#define SPI_S_MODF_Msk      0x10  //Master mode fault flag
+#define SPI_S_SPTEF_Msk     0x20  //SPI transmit buffer empty flag
+#define SPI_S_SPMF_Msk      0x40  //SPI match flag
+#define SPI_S_SPRF_Msk      0x80  //SPI read buffer full flag
+
+//SPI baud rate register bitfields
+#define SPI_BR_SPR_Msk      0x0F  //SPI baud rate divisor (2 ^ (SPR + 1))
+#define SPI_BR_SPR_Pos      0
+#define SPI_BR_SPPR_Msk     0x70  //SPI baud rate prescale divisor (SPPR + 1)
+#define SPI_BR_SPPR_Pos     4
+
+//SPI control register 2 bitfields
+#define SPI_C2_SPC0_Disabled      (0 << 0)  //SPI pin control 0
+#define SPI_C2_SPC0_Enabled       (1 << 0)
+#define SPI_C2_SPISWAI_Disabled   (0 << 1)  //SPI stop in wait mode
+#define SPI_C2_SPISWAI_Enabled    (1 << 1)
+#define SPI_C2_RXDMAE_Disabled    (0 << 2)  //Receive DMA enable
+#define SPI_C2_RXDMAE_Enabled     (1 << 2)
+#define SPI_C2_BIDIROE_Disabled   (0 << 3)  //Bidirectional mode output enable
+#define SPI_C2_BIDIROE_Enabled    (1 << 3)
+#define SPI_C2_MODFEN_Disabled    (0 << 4)  //Master mode-fault function enable
+#define SPI_C2_MODFEN_Enabled     (1 << 4)
+#define SPI_C2_TXDMAE_Disabled    (0 << 5)  //Transmit DMA enable
+#define SPI_C2_TXDMAE_Enabled     (1 << 5)
+#define SPI_C2_SPIMODE_8Bit       (0 << 6)  //SPI 8-bit or 16-bit mode
+#define SPI_C2_SPIMODE_16Bit      (1 << 6)
+#define SPI_C2_SPMIE_Disabled     (0 << 7)  //SPI match interrupt enable
+#define SPI_C2_SPMIE_Enabled      (1 << 7)
+
+//SPI control register 1 bitfields
+#define SPI_C1_LSBFE_MSB          (0 << 0)  //LSB first
+#define SPI_C1_LSBFE_LSB          (1 << 0)
+#define SPI_C1_SSOE_Disabled      (0 << 1)  //Slave select output enable
+#define SPI_C1_SSOE_Enabled       (1 << 1)
+#define SPI_C1_CPHA_Middle        (0 << 2)  //Clock phase
+#define SPI_C1_CPHA_Start         (1 << 2)
+#define SPI_C1_CPOL_High          (0 << 3)  //Clock polarity (active high or low clock)
+#define SPI_C1_CPOL_Low           (1 << 3)
+#define SPI_C1_MSTR_Slave         (0 << 4)  //Master/slave mode select
+#define SPI_C1_MSTR_Master        (1 << 4)
+#define SPI_C1_SPTIE_Disabled     (0 << 5)  //SPI transmit interrupt enable
+#define SPI_C1_SPTIE_Enabled      (1 << 5)
+#define SPI_C1_SPE_Disabled       (0 << 6)  //SPI system enable
+#define SPI_C1_SPE_Enabled        (1 << 6)
+#define SPI_C1_SPIE_Disabled      (0 << 7)  //SPI interrupt enable (SPRF and MODF)
+#define SPI_C1_SPIE_Enabled       (1 << 7)
+
+#endif //MKL26_SPI_H_
@@ -8,12 +8,15 @@
 //| Author: Joksan Alvarado.                                                                       |
 //+------------------------------------------------------------------------------------------------+
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include "mkl26.h"
 #include "mkl26-sim.h"
 #include "mkl26-smc.h"
 #include "mkl26-osc.h"
 #include "mkl26-mcg.h"
+#include "mkl26-startup.h"
 
 //Interrupt vector handler function type.
 typedef void (* handler_t)();
@@ -33,6 +36,7 @@ extern uint32_t __stack_end__;
 extern const uint32_t __relocate_flash_start__;
 extern uint32_t __relocate_sram_start__;
 extern uint32_t __relocate_sram_end__;
+extern const uint8_t __data_image_start__;
 extern uint32_t __bss_start__;
 extern uint32_t __bss_end__;
 
@@ -40,25 +44,46 @@ extern uint32_t __bss_end__;
 extern void __libc_init_array();
 extern void main();
 
-//--------------------------------------------------------------------------------------------------
-
-//Startup routine, located at reset vector.
-void startup() {
-  const uint32_t *flash;
-  uint32_t *sram;
+//Core clock frequencies of the boot phases: FLL on the slow internal reference (out of reset), FLL
+//in its 48MHz range (fast boot), external oscillator and PLL (divided by 2).
+#define FLL_RESET_FREQ 20971520
+#define FLL_FAST_FREQ 47972352
+#define OSC_FREQ 16000000
+#define PLL_FREQ 48000000
+
+//Boot phases, measured as core cycles spent on each clock.
+#define BOOT_PHASES 3
+static uint32_t boot_cycles[BOOT_PHASES];
+#if STARTUP_FAST_BOOT
+static const uint32_t boot_freqs[BOOT_PHASES] = { FLL_RESET_FREQ, FLL_FAST_FREQ, FLL_FAST_FREQ };
+#else
+static const uint32_t boot_freqs[BOOT_PHASES] = { FLL_RESET_FREQ, OSC_FREQ, PLL_FREQ };
+#endif
+
+//Core cycles spent initializing the .data section (part of the last boot phase).
+static uint32_t data_cycles;
 
-  //Disable the watchdog.
-  SIM->COPC = SIM_COPC_COPW_Normal | SIM_COPC_COPCLKS_Int_1kHz | SIM_COPC_COPT_Disabled;
-
-  //Enable all power modes.
-  SMC->PMPROT = SMC_PMPROT_AVLP_Allowed | SMC_PMPROT_ALLS_Allowed | SMC_PMPROT_AVLLS_Allowed;
+//--------------------------------------------------------------------------------------------------
 
+//Starts the 16MHz external oscillator, and the PLL from it. The PLL clock enable keeps the PLL
+//running before it's selected, so it locks while the system runs from the FLL.
+static void start_pll() {
   //Configure the 16MHz external oscillator.
   OSC->CR = OSC_CR_ERCLKEN_Enabled | OSC_CR_SC2P_Enabled | OSC_CR_SC8P_Enabled;
   MCG->C2 = MCG_C2_RANGE0_Very_High | MCG_C2_HGO0_Low_Power | MCG_C2_EREFS_Oscillator;
 
-  //Switch to FBE (FLL bypassed external) mode while changing the reference to external. This causes
-  //the external oscillator to start up.
+  //Set the PLL external reference divider to divide by 8, to get an input reference of 2MHz, and
+  //the multiplier to 48. Final frequency will be 2MHz * 48 = 96MHz.
+  MCG->C5 = MCG_C5_PRDIV0_Div_8;
+  MCG->C6 = MCG_C6_PLLS_FLL | MCG_C6_VDIV0_Div_48;
+  MCG->C5 = MCG_C5_PRDIV0_Div_8 | MCG_C5_PLLCLKEN0_Enabled;
+}
+
+//Engages the PLL, going from FEI (FLL engaged internal) mode through FBE and PBE into PEE mode, and
+//sets the final clock prescalers and peripheral clock sources. If given, marks get the SysTick
+//values at the FBE and PEE switches.
+static void engage_pll(uint32_t *marks) {
+  //Switch to FBE (FLL bypassed external) mode while changing the reference to external.
   MCG->C1 = MCG_C1_CLKS_External | MCG_C1_FRDIV_Div_16_512 | MCG_C1_IREFS_External;
   //Note: FRDIV is set to 512 just to set an input frequency of 16MHz/512 = 31.25KHz to the FLL
   //(which requires a value around 32.768KHz). It's not really used.
@@ -67,13 +92,10 @@ void startup() {
   while ((MCG->S & MCG_S_OSCINIT0_Msk) != MCG_S_OSCINIT0_Ready);  //Wait for external oscillator
   while ((MCG->S & MCG_S_IREFST_Msk) != MCG_S_IREFST_External);   //Wait for reference switch
   while ((MCG->S & MCG_S_CLKST_Msk) != MCG_S_CLKST_External);     //Wait for system clock switch
+  if (marks != NULL)
+    marks[0] = SysTick->VAL;
 
-  //We're running on the external crystal now. Set the PLL external reference divider to divide by
-  //8, to get an input reference of 2MHz.
-  MCG->C5 = MCG_C5_PRDIV0_Div_8;
-
-  //Transition to PBE (PLL bypassed external) mode. This causes to PLL to start up. Set the
-  //multiplier to 48. Final frequency will be 2MHz * 48 = 96MHz.
+  //We're running on the external crystal now. Transition to PBE (PLL bypassed external) mode.
   MCG->C6 = MCG_C6_PLLS_PLL | MCG_C6_VDIV0_Div_48;
 
   //Wait for the PLL to become ready.
@@ -89,20 +111,112 @@ void startup() {
 
   //Wait for the PLL to be selected as a system clock source.
   while ((MCG->S & MCG_S_CLKST_Msk) != MCG_S_CLKST_PLL);
+  if (marks != NULL)
+    marks[1] = SysTick->VAL;
 
   //Select the PLL/2 source (48MHz) for all peripherals that have it as an option (TPM, USB0, UART0
-  //and I2S0)
-  SIM->SOPT2 = SIM_SOPT2_PLLFLLSEL_MCGPLLCLK_Div2;
+  //and I2S0), keeping the sources they selected if set up already.
+  SIM->SOPT2 |= SIM_SOPT2_PLLFLLSEL_MCGPLLCLK_Div2;
+}
+
+#if STARTUP_COMPRESS_DATA
+//Unpacks the compressed initial data (an LZ4 block, see cpu/compress-data.py) into the .data
+//section. The last sequence of the block has literals only, so it ends when .data is full.
+static void unpack_data() {
+  const uint8_t *in = &__data_image_start__;
+  uint8_t *out = (uint8_t *) &__relocate_sram_start__;
+  uint8_t *end = (uint8_t *) &__relocate_sram_end__;
+  const uint8_t *match;
+  uint32_t length;
+  uint8_t token;
+
+  while (out < end) {
+    token = *in++;
+
+    //Copy the literals. Lengths of 15 continue on the next bytes, for as long as they're 255.
+    length = token >> 4;
+    if (length == 15) {
+      do
+        length += *in;
+      while (*in++ == 255);
+    }
+    while (length--)
+      *out++ = *in++;
+
+    if (out >= end)
+      break;
+
+    //Copy the match from the output written so far. It may overlap the bytes being written, which
+    //repeats them.
+    match = out - (in[0] | (in[1] << 8));
+    in += 2;
+    length = token & 0xF;
+    if (length == 15) {
+      do
+        length += *in;
+      while (*in++ == 255);
+    }
+    length += 4;
+    while (length--)
+      *out++ = *match++;
+  }
+}
+#endif
+
+//Startup routine, located at reset vector.
+void startup() {
+#if !STARTUP_COMPRESS_DATA
+  const uint32_t *flash;
+#endif
+  uint32_t *sram;
+  uint32_t marks[BOOT_PHASES];
+  uint32_t data_start, data_end;
+  uint8_t i;
+
+  //Disable the watchdog.
+  SIM->COPC = SIM_COPC_COPW_Normal | SIM_COPC_COPCLKS_Int_1kHz | SIM_COPC_COPT_Disabled;
+
+  //Count core cycles with the SysTick timer (down from 2^24 - 1) to measure the boot time.
+  SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+  //Enable all power modes.
+  SMC->PMPROT = SMC_PMPROT_AVLP_Allowed | SMC_PMPROT_ALLS_Allowed | SMC_PMPROT_AVLLS_Allowed;
+
+  start_pll();
+
+#if STARTUP_FAST_BOOT
+  //Fast boot: keep running from the FLL while the oscillator and the PLL start, speeding it up to
+  //its 48MHz range. Core runs at 48MHz, bus and flash run at 24MHz.
+  SIM->CLKDIV1 = ((0 << SIM_CLKDIV1_OUTDIV1_Pos) & SIM_CLKDIV1_OUTDIV1_Msk) |   //48 / 1 = 48MHz
+                 ((1 << SIM_CLKDIV1_OUTDIV4_Pos) & SIM_CLKDIV1_OUTDIV4_Msk);    //48 / 2 = 24MHz
+  marks[0] = SysTick->VAL;
+  MCG->C4 = (MCG->C4 & (MCG_C4_FCTRIM_Msk | MCG_C4_SCFTRIM_Msk)) | MCG_C4_DMX32_Set |
+            MCG_C4_DRST_DRS_Mid;
+
+  //There's no oscillator phase, the rest of the boot runs at 48MHz.
+  marks[1] = marks[0];
+#else
+  //Wait for the oscillator and the PLL, and engage it.
+  engage_pll(marks);
+#endif
 
   //Enable the clocks of all ports.
   SIM->SCGC5 = SIM_SCGC5_PORTA_Enabled | SIM_SCGC5_PORTB_Enabled | SIM_SCGC5_PORTC_Enabled |
                SIM_SCGC5_PORTD_Enabled | SIM_SCGC5_PORTE_Enabled;
 
-  //Copy the initial data for the data section from FLASH to RAM.
+  //Initialize the data section from FLASH, timing it.
+  data_start = SysTick->VAL;
+#if STARTUP_COMPRESS_DATA
+  unpack_data();
+#else
   flash = &__relocate_flash_start__;
   sram = &__relocate_sram_start__;
   while (sram < &__relocate_sram_end__)
     *sram++ = *flash++;
+#endif
+  data_end = SysTick->VAL;
 
   //Initialize the .bss section to zeroes.
   sram = &__bss_start__;
@@ -112,10 +226,54 @@ void startup() {
   //Initialize libc.
   __libc_init_array();
 
-  //System is up. Call the main function.
+  //Stop the boot time measurement and keep the cycles spent on each phase and on .data.
+  marks[2] = SysTick->VAL;
+  SysTick->CTRL = 0;
+  for (i = 0; i < BOOT_PHASES; i++)
+    boot_cycles[i] = ((i == 0 ? SysTick_LOAD_RELOAD_Msk : marks[i - 1]) - marks[i]);
+  data_cycles = data_start - data_end;
+
+  //System is up. Run the early initialization code and call the main function.
+  startup_early_init();
   main();
 }
 
+//Engages the PLL after a fast boot, going through the same steps as the normal boot. The oscillator
+//and the PLL have been starting since reset, so there's little to wait for. Sets the final core,
+//bus and flash clocks, and the PLL/FLL peripheral clock source: peripherals that depend on them may
+//be set up before, for those clocks, but must not be used until then. Does nothing if the PLL is
+//engaged already.
+void startup_engage_pll() {
+  if ((MCG->S & MCG_S_CLKST_Msk) == MCG_S_CLKST_PLL)
+    return;
+
+  engage_pll(NULL);
+}
+
+//Returns the time it took from reset to main(), in microseconds. It's the sum of the cycles spent
+//on each clock divided by its frequency, so phases run on the FLL are only as accurate as the
+//internal reference (a few percent).
+uint32_t startup_boot_time() {
+  uint64_t time = 0;
+  uint8_t i;
+
+  for (i = 0; i < BOOT_PHASES; i++)
+    time += (uint64_t) boot_cycles[i] * 1000000 / boot_freqs[i];
+
+  return time;
+}
+
+//Returns the time it took to initialize the .data section (copying or unpacking it), in
+//microseconds. It's included in the boot time.
+uint32_t startup_data_time() {
+  return (uint64_t) data_cycles * 1000000 / boot_freqs[BOOT_PHASES - 1];
+}
+
+//Default code run before main(), overridden by applications that need to set something up as soon
+//as possible after reset. Runs on the boot clocks, before any contiki initialization.
+void __attribute__((weak)) startup_early_init() {
+}
+
 //Default interrupt handler.
 static void unused_handler() {
   //The default unused handler does nothing, just stalls the CPU.
@@ -0,0 +1,48 @@
+//+------------------------------------------------------------------------------------------------+
+//| Kinetis MKL26 microcontroller initialization code.                                             |
+//|                                                                                                |
+//| By default, startup code waits for the external oscillator and the PLL before initializing     |
+//| memory, so main() starts with the final clocks. With fast boot enabled, the oscillator and the |
+//| PLL start in the background while the system runs from the FLL (48MHz, on the internal         |
+//| reference), so memory initialization overlaps with their startup and main() is reached sooner. |
+//| Code that must run as early as possible after reset (like driving outputs to a safe state) can |
+//| be placed in startup_early_init(), called right before main(). The platform sets up its        |
+//| peripherals and the processes while the PLL locks, and then engages it with                    |
+//| startup_engage_pll() before anything runs: bus clock dependent peripherals (timers, UARTs,     |
+//| etc.) are configured for the final frequencies, so they only run slow until then.              |
+//|                                                                                                |
+//| Building with COMPRESS_DATA=1 stores the initial data of the .data section compressed in       |
+//| flash (see cpu/compress-data.py), and startup code unpacks it instead of copying it. Large     |
+//| initialized tables and buffers compress well. The link prints the flash saved, and             |
+//| startup_data_time() returns the time spent initializing .data, to weigh against it. The make   |
+//| variable selects the option, which takes a second link: don't set STARTUP_CONF_COMPRESS_DATA   |
+//| by other means.                                                                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef MKL26_STARTUP_H_
+#define MKL26_STARTUP_H_
+
+#include <stdint.h>
+
+//Enables fast boot.
+#ifdef STARTUP_CONF_FAST_BOOT
+#define STARTUP_FAST_BOOT STARTUP_CONF_FAST_BOOT
+#else
+#define STARTUP_FAST_BOOT 0
+#endif
+
+//Unpacks compressed initial data for .data (set by the cpu makefile).
+#ifdef STARTUP_CONF_COMPRESS_DATA
+#define STARTUP_COMPRESS_DATA STARTUP_CONF_COMPRESS_DATA
+#else
+#define STARTUP_COMPRESS_DATA 0
+#endif
+
+void startup_early_init();
+void startup_engage_pll();
+uint32_t startup_boot_time();
+uint32_t startup_data_time();
+
+#endif //MKL26_STARTUP_H_
@@ -0,0 +1,110 @@
+//+------------------------------------------------------------------------------------------------+
+//| Platform implementation for contiki's rtimer library.                                          |
+//|                                                                                                |
+//| The current time is derived from the PIT0 timer used by the clock library: the amount of ticks |
+//| elapsed plus the progress of the current tick, scaled from bus cycles to rtimer ticks. Timers  |
+//| are scheduled with PIT1 in one-shot fashion. Since it can only count up to 2^32 bus cycles     |
+//| (~178s), longer delays are split in several shots.                                             |
+//|                                                                                                |
+//| See the header in contiki/core/sys/rtimer.h for details on the exposed interface.              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include "contiki.h"
+#include "rtimer.h"
+
+#include "mkl26.h"
+#include "mkl26-sim.h"
+#include "mkl26-pit.h"
+
+//Bus cycles per rtimer tick, and rtimer ticks per clock tick.
+#define CYCLES_PER_TICK (24000000 / RTIMER_ARCH_SECOND)
+#define TICKS_PER_CLOCK (RTIMER_ARCH_SECOND / CLOCK_SECOND)
+
+//Time at which the scheduled timer should expire, and whether it's still pending.
+static volatile rtimer_clock_t target;
+static volatile uint8_t pending = 0;
+
+void rtimer_arch_init() {
+  //The PIT module and its interrupt (shared by all channels) are enabled by the clock library.
+  //Leave PIT1 stopped until a timer is scheduled.
+  SIM->SCGC6 |= SIM_SCGC6_PIT_Enabled;
+  PIT->TCTRL1 = PIT_TCTRL_TEN_Disabled;
+  PIT->TFLG1 = PIT_TFLG_TIF_Set;
+}
+
+rtimer_clock_t rtimer_arch_now() {
+  clock_time_t ticks, adjusted;
+  uint32_t count;
+
+  //Read the tick count and the PIT0 counter consistently. If the counter reloaded but the tick
+  //interrupt hasn't been serviced yet (e.g. because this runs from a higher priority interrupt),
+  //account for the pending tick and read the counter again.
+  do {
+    ticks = clock_time();
+    adjusted = ticks;
+    count = PIT->CVAL0;
+    if (PIT->TFLG0 & PIT_TFLG_TIF_Msk) {
+      count = PIT->CVAL0;
+      adjusted++;
+    }
+  } while (ticks != clock_time());
+
+  return adjusted * TICKS_PER_CLOCK + (PIT->LDVAL0 - count) / CYCLES_PER_TICK;
+}
+
+//Programs PIT1 to expire at the target time, or as close as possible to it.
+static void schedule_shot() {
+  int32_t delta = RTIMER_CLOCK_DIFF(target, rtimer_arch_now());
+
+  if (delta < 0)
+    delta = 0;
+  if ((uint32_t) delta > UINT32_MAX / CYCLES_PER_TICK - 1)
+    delta = UINT32_MAX / CYCLES_PER_TICK - 1;
+
+  //The current time is truncated to whole ticks, so wait an extra tick to never expire early.
+  //Restarting the timer loads the new period.
+  PIT->TCTRL1 = PIT_TCTRL_TEN_Disabled;
+  PIT->LDVAL1 = (delta + 1) * CYCLES_PER_TICK - 1;
+  PIT->TFLG1 = PIT_TFLG_TIF_Set;
+  PIT->TCTRL1 = PIT_TCTRL_TEN_Enabled | PIT_TCTRL_TIE_Enabled;
+}
+
+void rtimer_arch_schedule(rtimer_clock_t t) {
+  target = t;
+  pending = 1;
+  schedule_shot();
+}
+
+//Moves the expiration of the pending rtimer to a new time, keeping its callback (the rtimer library
+//can't reschedule a pending timer by itself). Returns 0 on success, or -1 if no timer is pending
+//(it may have just expired), in which case the caller must use rtimer_set() instead.
+int rtimer_arch_reschedule(rtimer_clock_t t) {
+  int result = -1;
+
+  NVIC_DisableIRQ(PIT_IRQn);
+  if (pending) {
+    target = t;
+    schedule_shot();
+    result = 0;
+  }
+  NVIC_EnableIRQ(PIT_IRQn);
+
+  return result;
+}
+
+//PIT1 interrupt handler, called from the shared PIT interrupt handler in the clock library.
+void rtimer_arch_pit_handler() {
+  //Stop the timer, so it behaves as one-shot.
+  PIT->TCTRL1 = PIT_TCTRL_TEN_Disabled;
+  PIT->TFLG1 = PIT_TFLG_TIF_Set;
+
+  //Run the timer if due, otherwise this was an intermediate shot of a long delay.
+  if (RTIMER_CLOCK_LT(rtimer_arch_now(), target)) {
+    schedule_shot();
+  } else {
+    pending = 0;
+    rtimer_run_next();
+  }
+}
@@ -0,0 +1,46 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the boot time example.                                                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+
+//Include the startup and GPIO headers of the target.
+#if CONTIKI_TARGET_TEENSY_36
+#include "mk66-startup.h"
+#include "mk66-port.h"
+#include "mk66-gpio.h"
+#elif CONTIKI_TARGET_TEENSY_32
+#include "mk20-startup.h"
+#include "mk20-port.h"
+#include "mk20-gpio.h"
+#else
+#include "mkl26-startup.h"
+#include "mkl26-port.h"
+#include "mkl26-gpio.h"
+#endif
+
+PROCESS(boot_time, "Boot time");
+
+AUTOSTART_PROCESSES(&boot_time);
+
+//Turns the LED (pin 13, PTC5) on as soon as memory is initialized, before main().
+void startup_early_init() {
+  PORTC->PCR[5] = PORT_PCR_MUX_Gpio;
+  GPIOC->PDDR |= 1 << 5;
+  GPIOC->PSOR = 1 << 5;
+}
+
+PROCESS_THREAD(boot_time, ev, data) {
+  PROCESS_BEGIN();
+
+  printf("Boot: %s, %lu us from reset to main()\n", STARTUP_FAST_BOOT ? "fast" : "normal",
+         (unsigned long) startup_boot_time());
+  printf(".data: %s in %lu us\n", STARTUP_COMPRESS_DATA ? "unpacked" : "copied",
+         (unsigned long) startup_data_time());
+
+  PROCESS_END();
+}
@@ -0,0 +1,121 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the CBOR telemetry example.                                                    |
+//|                                                                                                |
+//| Once a second, a telemetry record is encoded as CBOR straight into a packet buffer, decoded    |
+//| back and formatted as JSON for comparison. The size and the cost in core cycles of each step   |
+//| are printed, along with the packet contents.                                                   |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "cbor.h"
+#include "telemetry.h"
+
+//Include the core header of the target, which provides access to the SysTick timer.
+#if CONTIKI_TARGET_TEENSY_36
+#include "mk66.h"
+#elif CONTIKI_TARGET_TEENSY_32
+#include "mk20.h"
+#else
+#include "mkl26.h"
+#endif
+
+//Payload size of the packets the records would be sent in (an IEEE 802.15.4 frame).
+#define PACKET_SIZE 127
+
+static uint8_t packet[PACKET_SIZE];
+static char json[128];
+
+PROCESS(cbor_telemetry, "CBOR telemetry");
+
+AUTOSTART_PROCESSES(&cbor_telemetry);
+
+//Starts the SysTick timer as a free running 24 bit down counter clocked by the core clock.
+static void cycle_counter_init() {
+  SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+static uint32_t cycle_counter_read() {
+  return SysTick->VAL;
+}
+
+//Returns the cycles elapsed since a previous counter read. Blocks must take less than 2^24 cycles.
+static uint32_t cycles_since(uint32_t start) {
+  return (start - cycle_counter_read()) & SysTick_LOAD_RELOAD_Msk;
+}
+
+//Makes up readings that change over time.
+static void sample(struct telemetry *t) {
+  uint32_t phase = t->seq % 64;
+
+  t->uptime = clock_seconds();
+  t->temperature = 2150 + (phase < 32 ? phase : 64 - phase) * 25 - 400;
+  t->battery = 4100 - t->seq % 600;
+  t->accel[0] = phase * 3 - 96;
+  t->accel[1] = 40 - phase;
+  t->accel[2] = 1000 + phase % 8;
+  t->current = 0.125f + phase * 0.015625f;
+  t->ok = t->battery > 3600;
+}
+
+static void print_hex(const uint8_t *data, int length) {
+  int i;
+
+  for (i = 0; i < length; i++)
+    printf("%02x", data[i]);
+  printf("\n");
+}
+
+PROCESS_THREAD(cbor_telemetry, ev, data) {
+  static struct etimer et;
+  static struct telemetry t;
+  struct telemetry decoded;
+  uint32_t start, encode_cycles, decode_cycles, json_cycles;
+  int cbor_length, json_length, error;
+
+  PROCESS_BEGIN();
+
+  cycle_counter_init();
+  etimer_set(&et, CLOCK_SECOND);
+
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    sample(&t);
+
+    start = cycle_counter_read();
+    cbor_length = telemetry_encode(&t, packet, sizeof(packet));
+    encode_cycles = cycles_since(start);
+
+    decoded = t;
+    decoded.seq = ~t.seq;
+    start = cycle_counter_read();
+    error = telemetry_decode(packet, cbor_length, &decoded);
+    decode_cycles = cycles_since(start);
+
+    start = cycle_counter_read();
+    json_length = telemetry_format_json(&t, json, sizeof(json));
+    json_cycles = cycles_since(start);
+
+    if (cbor_length < 0) {
+      printf("Encoding error %d\n", cbor_length);
+      continue;
+    }
+
+    printf("CBOR: %d bytes, encoded in %lu cycles, decoded in %lu cycles (%s)\n", cbor_length,
+           (unsigned long) encode_cycles, (unsigned long) decode_cycles,
+           error == CBOR_OK && decoded.seq == t.seq ? "OK" : "FAILED");
+    printf("JSON: %d bytes, formatted in %lu cycles\n", json_length, (unsigned long) json_cycles);
+    print_hex(packet, cbor_length);
+
+    t.seq++;
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,659 @@
+//+------------------------------------------------------------------------------------------------+
+//| Host test and benchmark for the CBOR library.                                                  |
+//|                                                                                                |
+//| Usage: cbor-check [test [fuzz iterations]]                                                     |
+//|        cbor-check bench                                                                        |
+//|                                                                                                |
+//| The test mode checks the encoder and decoder against the examples of RFC 8949 (appendix A),    |
+//| round trips randomly generated messages through both fixed and streaming writers, checks the   |
+//| overflow handling of every buffer size, and fuzzes the decoder with mutated and random inputs  |
+//| (build with sanitizers to catch out of bounds accesses, as the makefile does). The bench mode  |
+//| compares the telemetry record of the example encoded as CBOR and formatted as JSON.            |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "cbor.h"
+#include "telemetry.h"
+
+#define MAX_MESSAGE     4096
+#define MAX_ITEMS       1024
+#define MAX_DEPTH       4
+#define ROUND_TRIPS     2000
+#define FUZZ_ITERATIONS 200000
+#define BENCH_SECONDS   1.0
+
+//Items expected back from the decoder.
+static struct cbor_item expected[MAX_ITEMS];
+static uint32_t expected_count;
+static uint8_t pool[512];
+static uint32_t rng_state;
+static int failures;
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//Xorshift generator, so runs are reproducible.
+static uint32_t rng() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static uint64_t rng64() {
+  uint64_t value = (uint64_t) rng() << 32 | rng();
+
+  //Favor short values, so every argument size shows up.
+  return value >> (rng() % 64);
+}
+
+static void fail(const char *what, uint32_t detail) {
+  if (failures++ < 10)
+    fprintf(stderr, "FAILED: %s (%u)\n", what, detail);
+}
+
+static void hex_to_bytes(const char *hex, uint8_t *data, uint32_t *length) {
+  unsigned int byte;
+
+  *length = 0;
+  while (sscanf(hex, "%2x", &byte) == 1) {
+    data[(*length)++] = byte;
+    hex += 2;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//RFC 8949 examples.
+
+enum {V_UINT, V_INT, V_FLOAT, V_SIMPLE, V_BYTES, V_TEXT};
+
+struct vector {
+  uint8_t kind;
+  uint64_t uint;
+  double real;
+  const char *text;
+  const char *hex;
+};
+
+static const struct vector vectors[] = {
+  {V_UINT, 0, 0, NULL, "00"},
+  {V_UINT, 1, 0, NULL, "01"},
+  {V_UINT, 10, 0, NULL, "0a"},
+  {V_UINT, 23, 0, NULL, "17"},
+  {V_UINT, 24, 0, NULL, "1818"},
+  {V_UINT, 25, 0, NULL, "1819"},
+  {V_UINT, 100, 0, NULL, "1864"},
+  {V_UINT, 1000, 0, NULL, "1903e8"},
+  {V_UINT, 1000000, 0, NULL, "1a000f4240"},
+  {V_UINT, 1000000000000ULL, 0, NULL, "1b000000e8d4a51000"},
+  {V_UINT, 18446744073709551615ULL, 0, NULL, "1bffffffffffffffff"},
+  {V_INT, (uint64_t) -1, 0, NULL, "20"},
+  {V_INT, (uint64_t) -10, 0, NULL, "29"},
+  {V_INT, (uint64_t) -100, 0, NULL, "3863"},
+  {V_INT, (uint64_t) -1000, 0, NULL, "3903e7"},
+  {V_FLOAT, 0, 0.0, NULL, "f90000"},
+  {V_FLOAT, 0, -0.0, NULL, "f98000"},
+  {V_FLOAT, 0, 1.0, NULL, "f93c00"},
+  {V_FLOAT, 0, 1.5, NULL, "f93e00"},
+  {V_FLOAT, 0, 65504.0, NULL, "f97bff"},
+  {V_FLOAT, 0, 100000.0, NULL, "fa47c35000"},
+  {V_FLOAT, 0, 3.4028234663852886e+38, NULL, "fa7f7fffff"},
+  {V_FLOAT, 0, 5.960464477539063e-8, NULL, "f90001"},
+  {V_FLOAT, 0, 0.00006103515625, NULL, "f90400"},
+  {V_FLOAT, 0, -4.0, NULL, "f9c400"},
+  {V_FLOAT, 0, INFINITY, NULL, "f97c00"},
+  {V_FLOAT, 0, NAN, NULL, "f97e00"},
+  {V_FLOAT, 0, -INFINITY, NULL, "f9fc00"},
+  {V_SIMPLE, CBOR_FALSE, 0, NULL, "f4"},
+  {V_SIMPLE, CBOR_TRUE, 0, NULL, "f5"},
+  {V_SIMPLE, CBOR_NULL, 0, NULL, "f6"},
+  {V_SIMPLE, CBOR_UNDEFINED, 0, NULL, "f7"},
+  {V_SIMPLE, 16, 0, NULL, "f0"},
+  {V_SIMPLE, 255, 0, NULL, "f8ff"},
+  {V_BYTES, 0, 0, "", "40"},
+  {V_BYTES, 0, 0, "\x01\x02\x03\x04", "4401020304"},
+  {V_TEXT, 0, 0, "", "60"},
+  {V_TEXT, 0, 0, "a", "6161"},
+  {V_TEXT, 0, 0, "IETF", "6449455446"},
+  {V_TEXT, 0, 0, "\"\\", "62225c"},
+  {V_TEXT, 0, 0, "\xe6\xb0\xb4", "63e6b0b4"},
+};
+
+//Examples that are only decoded (as they are not produced by the encoder): doubles, tags,
+//containers and indefinite length items.
+static void test_decode_only() {
+  static const char *const examples[] = {
+    "fb3ff199999999999a",                       //1.1
+    "fb7e37e43c8800759c",                       //1.0e+300 (infinity as a float)
+    "c11a514b67b0",                             //1(1363896240)
+    "d82076687474703a2f2f7777772e6578616d706c652e636f6d",
+    "83010203",
+    "8301820203820405",
+    "a26161016162820203",
+    "5f42010243030405ff",                       //(_ h'0102', h'030405')
+    "7f657374726561646d696e67ff",               //(_ "strea", "ming")
+    "9f018202039f0405ffff",
+    "bf61610161629f0203ffff",
+  };
+  struct cbor_reader r;
+  uint8_t data[64];
+  uint32_t length, i;
+  float real;
+
+  for (i = 0; i < sizeof(examples) / sizeof(examples[0]); i++) {
+    hex_to_bytes(examples[i], data, &length);
+    cbor_reader_init(&r, data, length);
+    if (cbor_skip(&r) != CBOR_OK || r.pos != length)
+      fail("vector skip", i);
+  }
+
+  hex_to_bytes(examples[0], data, &length);
+  cbor_reader_init(&r, data, length);
+  if (cbor_get_float(&r, &real) != CBOR_OK || real != 1.1f)
+    fail("double decoding", 0);
+}
+
+//Malformed messages must be rejected, leaving the read position unchanged.
+static void test_malformed() {
+  static const char *const examples[] = {
+    "18", "1900", "1a000000", "1b00000000000000", "42", "5affffffff00", "1c", "1d", "1e", "1f",
+    "3f", "df", "f800", "f818", "ff", "81", "a1", "a20102", "9f", "9f01", "9f81ff"
+  };
+  struct cbor_reader r;
+  uint8_t data[16];
+  uint32_t length, i;
+
+  for (i = 0; i < sizeof(examples) / sizeof(examples[0]); i++) {
+    hex_to_bytes(examples[i], data, &length);
+    cbor_reader_init(&r, data, length);
+    if (cbor_skip(&r) == CBOR_OK)
+      fail("malformed accepted", i);
+    if (r.pos != 0)
+      fail("malformed position", i);
+  }
+}
+
+//Encodes every example and decodes it back.
+static void test_vectors() {
+  uint8_t expected_data[16], data[16];
+  uint32_t expected_length, length, i;
+  struct cbor_writer w;
+  struct cbor_reader r;
+  struct cbor_item item;
+  const struct vector *v;
+  float real;
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    v = &vectors[i];
+    hex_to_bytes(v->hex, expected_data, &expected_length);
+
+    cbor_writer_init(&w, data, sizeof(data));
+    if (v->kind == V_UINT)
+      cbor_put_uint64(&w, v->uint);
+    else if (v->kind == V_INT)
+      cbor_put_int64(&w, (int64_t) v->uint);
+    else if (v->kind == V_FLOAT)
+      cbor_put_float(&w, v->real);
+    else if (v->kind == V_SIMPLE)
+      cbor_put_simple(&w, v->uint);
+    else if (v->kind == V_BYTES)
+      cbor_put_bytes(&w, v->text, strlen(v->text));
+    else
+      cbor_put_text(&w, v->text);
+
+    length = cbor_writer_end(&w);
+    if (length != expected_length || memcmp(data, expected_data, length) != 0)
+      fail("vector encoding", i);
+
+    cbor_reader_init(&r, expected_data, expected_length);
+    if (cbor_read(&r, &item) != CBOR_OK || r.pos != expected_length) {
+      fail("vector decoding", i);
+      continue;
+    }
+
+    if (v->kind == V_FLOAT) {
+      real = v->real;
+      if (item.type != CBOR_FLOAT || (isnan(real) ? !isnan(item.value.real) :
+                                      memcmp(&real, &item.value.real, 4) != 0))
+        fail("vector float value", i);
+    }
+    else if (v->kind == V_INT) {
+      if (item.type != CBOR_NINT || item.value.uint != -1 - v->uint)
+        fail("vector negative value", i);
+    }
+    else if (v->kind == V_UINT) {
+      if (item.type != CBOR_UINT || item.value.uint != v->uint)
+        fail("vector value", i);
+    }
+    else if (v->kind == V_SIMPLE) {
+      if (item.type != CBOR_SIMPLE || item.value.simple != v->uint)
+        fail("vector simple value", i);
+    }
+    else if (item.type != (v->kind == V_BYTES ? CBOR_BYTES : CBOR_TEXT) ||
+             item.value.string.length != strlen(v->text) ||
+             memcmp(item.value.string.data, v->text, strlen(v->text)) != 0)
+      fail("vector string", i);
+  }
+
+  test_decode_only();
+  test_malformed();
+
+  printf("Vectors: %s\n", failures ? "FAILED" : "OK");
+}
+
+//--------------------------------------------------------------------------------------------------
+//Random round trips.
+
+//Records the next item expected. Messages with too many items are discarded by the callers.
+static struct cbor_item *expect_item(uint8_t type) {
+  static struct cbor_item dummy;
+  struct cbor_item *item = expected_count < MAX_ITEMS ? &expected[expected_count++] : &dummy;
+
+  memset(item, 0, sizeof(*item));
+  item->type = type;
+  return item;
+}
+
+//Writes a random item, recording what the decoder should return.
+static void generate(struct cbor_writer *w, uint8_t depth) {
+  struct cbor_item *item;
+  uint32_t count, bits, i;
+  uint64_t value;
+  int indefinite;
+  uint8_t kind = rng() % (depth < MAX_DEPTH ? 11 : 8);
+  float real;
+
+  switch (kind) {
+    case 0:
+      value = rng64();
+      cbor_put_uint64(w, value);
+      expect_item(CBOR_UINT)->value.uint = value;
+      break;
+
+    case 1:
+      value = rng64() >> 1;
+      cbor_put_int64(w, -1 - (int64_t) value);
+      expect_item(CBOR_NINT)->value.uint = value;
+      break;
+
+    case 2:
+      value = (int32_t) rng() >> (rng() % 32);
+      cbor_put_int(w, (int32_t) value);
+      if ((int32_t) value >= 0)
+        expect_item(CBOR_UINT)->value.uint = (int32_t) value;
+      else
+        expect_item(CBOR_NINT)->value.uint = -1 - (int64_t) (int32_t) value;
+      break;
+
+    case 3:
+    case 4:
+      count = rng() % 8 == 0 ? rng() % 300 : rng() % 24;
+      i = rng() % (sizeof(pool) - count);
+      if (kind == 3)
+        cbor_put_bytes(w, pool + i, count);
+      else
+        cbor_put_text_n(w, (const char *) pool + i, count);
+      item = expect_item(kind == 3 ? CBOR_BYTES : CBOR_TEXT);
+      item->value.string.data = pool + i;
+      item->value.string.length = count;
+      break;
+
+    case 5:
+      //Mostly values with short mantissas, which go as half precision.
+      bits = rng();
+      if (rng() % 2)
+        bits &= 0xFFFFE000;
+      memcpy(&real, &bits, 4);
+      cbor_put_float(w, real);
+      memcpy(&expect_item(CBOR_FLOAT)->value.real, &bits, 4);
+      break;
+
+    case 6:
+      do
+        i = rng() % 256;
+      while (i >= 24 && i < 32);
+      cbor_put_simple(w, i);
+      expect_item(CBOR_SIMPLE)->value.simple = i;
+      break;
+
+    case 7:
+      i = rng() % 2;
+      cbor_put_bool(w, i);
+      expect_item(CBOR_SIMPLE)->value.simple = i ? CBOR_TRUE : CBOR_FALSE;
+      break;
+
+    case 8:
+    case 9:
+      count = rng() % 6;
+      indefinite = rng() % 4 == 0;
+      if (kind == 8)
+        cbor_put_array(w, indefinite ? CBOR_INDEFINITE : count);
+      else
+        cbor_put_map(w, indefinite ? CBOR_INDEFINITE : count);
+      expect_item(kind == 8 ? CBOR_ARRAY : CBOR_MAP)->value.count =
+        indefinite ? CBOR_INDEFINITE : count;
+      for (i = 0; i < (kind == 8 ? count : 2 * count); i++)
+        generate(w, depth + 1);
+      if (indefinite) {
+        cbor_put_break(w);
+        expect_item(CBOR_BREAK);
+      }
+      break;
+
+    default:
+      value = rng64();
+      cbor_put_tag(w, value);
+      expect_item(CBOR_TAG)->value.tag = value;
+      generate(w, depth + 1);
+      break;
+  }
+}
+
+//Generates a message made of an array of random items. Returns its length or an error code.
+static int32_t generate_message(struct cbor_writer *w, uint32_t seed) {
+  uint32_t count, i;
+
+  rng_state = seed * 2654435761u + 1;
+  expected_count = 0;
+
+  count = 1 + rng() % 16;
+  cbor_put_array(w, count);
+  expect_item(CBOR_ARRAY)->value.count = count;
+  for (i = 0; i < count; i++)
+    generate(w, 1);
+
+  return cbor_writer_end(w);
+}
+
+//Collects streamed data.
+struct collector {
+  uint8_t data[MAX_MESSAGE];
+  uint32_t length;
+  uint32_t flushes;
+};
+
+static void collect(const uint8_t *data, uint32_t length, void *ptr) {
+  struct collector *c = ptr;
+
+  if (c->length + length <= sizeof(c->data))
+    memcpy(c->data + c->length, data, length);
+  c->length += length;
+  c->flushes++;
+}
+
+//Compares items. Floats are compared bit by bit, as no precision may be lost.
+static int compare_item(const struct cbor_item *item, const struct cbor_item *e) {
+  if (item->type != e->type)
+    return 0;
+
+  switch (item->type) {
+    case CBOR_UINT:
+    case CBOR_NINT:
+    case CBOR_TAG:
+      return item->value.uint == e->value.uint;
+    case CBOR_BYTES:
+    case CBOR_TEXT:
+      return item->value.string.length == e->value.string.length &&
+             memcmp(item->value.string.data, e->value.string.data,
+                    item->value.string.length) == 0;
+    case CBOR_ARRAY:
+    case CBOR_MAP:
+      return item->value.count == e->value.count;
+    case CBOR_SIMPLE:
+      return item->value.simple == e->value.simple;
+    case CBOR_FLOAT:
+      return memcmp(&item->value.real, &e->value.real, 4) == 0;
+    default:
+      return 1;
+  }
+}
+
+static void test_round_trips() {
+  static uint8_t message[MAX_MESSAGE], small[MAX_MESSAGE];
+  static struct collector c;
+  struct cbor_writer w;
+  struct cbor_reader r;
+  struct cbor_item item;
+  uint8_t window[32];
+  uint32_t seed, length, i;
+  int32_t result;
+  int before = failures;
+
+  for (i = 0; i < sizeof(pool); i++)
+    pool[i] = 'a' + i % 26;
+
+  for (seed = 0; seed < ROUND_TRIPS; seed++) {
+    cbor_writer_init(&w, message, sizeof(message));
+    result = generate_message(&w, seed);
+    if (result < 0 || expected_count >= MAX_ITEMS)
+      continue;
+    length = result;
+
+    //Decode item by item.
+    cbor_reader_init(&r, message, length);
+    for (i = 0; i < expected_count; i++) {
+      if (cbor_read(&r, &item) != CBOR_OK || !compare_item(&item, &expected[i])) {
+        fail("round trip item", seed);
+        break;
+      }
+    }
+    if (cbor_read(&r, &item) != CBOR_ERR_END)
+      fail("round trip end", seed);
+
+    //Skip as a whole.
+    cbor_reader_init(&r, message, length);
+    if (cbor_skip(&r) != CBOR_OK || r.pos != length)
+      fail("round trip skip", seed);
+
+    //Stream through a small window: same bytes.
+    c.length = 0;
+    c.flushes = 0;
+    cbor_writer_stream(&w, window, 1 + seed % sizeof(window), collect, &c);
+    result = generate_message(&w, seed);
+    if (result != (int32_t) length || c.length != length || memcmp(c.data, message, length) != 0)
+      fail("streaming", seed);
+
+    //Buffers too short overflow, without writing past their end.
+    if (seed % 16 == 0) {
+      for (i = 0; i < length; i++) {
+        memset(small, 0xAA, length);
+        cbor_writer_init(&w, small, i);
+        if (generate_message(&w, seed) != CBOR_ERR_OVERFLOW || small[i] != 0xAA) {
+          fail("overflow", seed);
+          break;
+        }
+      }
+    }
+  }
+
+  printf("Round trips: %s (%u messages)\n", failures > before ? "FAILED" : "OK", ROUND_TRIPS);
+}
+
+//--------------------------------------------------------------------------------------------------
+//Fuzzing.
+
+//Walks a message every way the decoder allows, checking that nothing points outside of it.
+static void decode_all(const uint8_t *data, uint32_t length) {
+  struct cbor_reader r;
+  struct cbor_item item;
+  const char *text;
+  uint32_t pos, value;
+  int32_t signed_value;
+  float real;
+  int error;
+  struct telemetry t;
+
+  cbor_reader_init(&r, data, length);
+  while ((error = cbor_read(&r, &item)) == CBOR_OK) {
+    if ((item.type == CBOR_BYTES || item.type == CBOR_TEXT) &&
+        item.value.string.length != CBOR_INDEFINITE &&
+        item.value.string.data + item.value.string.length > data + length)
+      fail("string out of bounds", r.pos);
+  }
+  if (r.pos > length)
+    fail("position out of bounds", r.pos);
+
+  cbor_reader_init(&r, data, length);
+  while (1) {
+    pos = r.pos;
+    error = cbor_skip(&r);
+    if (error != CBOR_OK) {
+      if (r.pos != pos)
+        fail("skip error moved", pos);
+      break;
+    }
+    if (r.pos <= pos || r.pos > length)
+      fail("skip position", pos);
+  }
+
+  //Typed getters fail without moving on mismatches.
+  cbor_reader_init(&r, data, length);
+  pos = 0;
+  while (r.pos < length) {
+    switch (r.pos % 5) {
+      case 0: error = cbor_get_uint(&r, &value); break;
+      case 1: error = cbor_get_int(&r, &signed_value); break;
+      case 2: error = cbor_get_float(&r, &real); break;
+      case 3: error = cbor_get_text(&r, &text, &value); break;
+      default: error = cbor_get_map(&r, &value); break;
+    }
+    if (error != CBOR_OK && r.pos != pos)
+      fail("getter error moved", pos);
+    if (error != CBOR_OK && cbor_read(&r, &item) != CBOR_OK)
+      break;
+    pos = r.pos;
+  }
+
+  telemetry_decode(data, length, &t);
+}
+
+static void mutate(uint8_t *data, uint32_t *length) {
+  static const uint8_t interesting[] = {
+    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1F, 0x3F, 0x5F, 0x7F, 0x9F, 0xBF, 0xDF, 0xF8, 0xF9, 0xFA,
+    0xFB, 0xFF, 0x00, 0x80, 0xA0, 0x5A, 0x9B
+  };
+  uint32_t mutations = 1 + rng() % 4;
+
+  while (mutations-- > 0 && *length > 0) {
+    switch (rng() % 4) {
+      case 0:
+        data[rng() % *length] ^= 1 << (rng() % 8);
+        break;
+      case 1:
+        data[rng() % *length] = interesting[rng() % sizeof(interesting)];
+        break;
+      case 2:
+        *length = rng() % *length;
+        break;
+      default:
+        data[rng() % *length] = rng();
+        break;
+    }
+  }
+}
+
+static void test_fuzz(uint32_t iterations) {
+  static uint8_t message[MAX_MESSAGE];
+  struct cbor_writer w;
+  uint32_t i, j, length;
+  uint8_t *copy;
+  int before = failures;
+  int32_t result;
+
+  for (i = 0; i < iterations; i++) {
+    if (i % 4 == 0) {
+      //Pure noise.
+      rng_state = i * 2246822519u + 7;
+      length = rng() % 64;
+      for (j = 0; j < length; j++)
+        message[j] = rng();
+    }
+    else {
+      cbor_writer_init(&w, message, sizeof(message));
+      result = generate_message(&w, i);
+      if (result < 0)
+        continue;
+      length = result;
+      mutate(message, &length);
+    }
+
+    //Exact size heap copy, so the sanitizer catches any read past the end.
+    copy = malloc(length ? length : 1);
+    memcpy(copy, message, length);
+    decode_all(copy, length);
+    free(copy);
+  }
+
+  printf("Fuzz: %s (%u inputs)\n", failures > before ? "FAILED" : "OK", iterations);
+}
+
+//--------------------------------------------------------------------------------------------------
+//Benchmark.
+
+static void bench() {
+  struct telemetry t = {123456, 86400, -1234, 3712, {12, -40, 1010}, 0.25f, 1};
+  struct telemetry decoded;
+  uint8_t packet[127];
+  char json[128];
+  uint32_t runs, cbor_length = 0, json_length = 0;
+  double start, elapsed;
+  volatile uint32_t sink = 0;
+
+  runs = 0;
+  start = now();
+  do {
+    runs++;
+    sink += telemetry_encode(&t, packet, sizeof(packet));
+  } while ((elapsed = now() - start) < BENCH_SECONDS);
+  cbor_length = telemetry_encode(&t, packet, sizeof(packet));
+  printf("CBOR encode: %u bytes, %.0f ns\n", cbor_length, elapsed / runs * 1e9);
+
+  runs = 0;
+  start = now();
+  do {
+    runs++;
+    sink += telemetry_format_json(&t, json, sizeof(json));
+  } while ((elapsed = now() - start) < BENCH_SECONDS);
+  json_length = telemetry_format_json(&t, json, sizeof(json));
+  printf("JSON format: %u bytes, %.0f ns\n", json_length, elapsed / runs * 1e9);
+
+  runs = 0;
+  start = now();
+  do {
+    runs++;
+    sink += telemetry_decode(packet, cbor_length, &decoded);
+  } while ((elapsed = now() - start) < BENCH_SECONDS);
+  printf("CBOR decode: %.0f ns, %s\n", elapsed / runs * 1e9,
+         decoded.seq == t.seq && decoded.temperature == t.temperature &&
+         decoded.accel[2] == t.accel[2] && decoded.current == t.current ? "OK" : "MISMATCH");
+  printf("%s\n", json);
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t iterations = FUZZ_ITERATIONS;
+
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    bench();
+    return 0;
+  }
+
+  if (argc > 2)
+    iterations = strtoul(argv[2], NULL, 0);
+
+  test_vectors();
+  test_round_trips();
+  test_fuzz(iterations);
+
+  return failures ? 1 : 0;
+}
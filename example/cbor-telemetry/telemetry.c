@@ -0,0 +1,140 @@
+//+------------------------------------------------------------------------------------------------+
+//| Telemetry record of the CBOR example.                                                          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cbor.h"
+#include "telemetry.h"
+
+//Number of fields in a record.
+#define FIELDS 7
+
+//Returns nonzero if a key (not null terminated) matches the given one.
+static int key_is(const char *key, uint32_t length, const char *name) {
+  return strlen(name) == length && memcmp(key, name, length) == 0;
+}
+
+//Encodes a record straight into the given buffer (e.g. the payload area of a packet). Returns the
+//length of the encoded record or a negative CBOR error code.
+int telemetry_encode(const struct telemetry *t, void *buffer, uint16_t size) {
+  struct cbor_writer w;
+  uint8_t i;
+
+  cbor_writer_init(&w, buffer, size);
+
+  cbor_put_map(&w, FIELDS);
+  cbor_put_text(&w, "seq");
+  cbor_put_uint(&w, t->seq);
+  cbor_put_text(&w, "up");
+  cbor_put_uint(&w, t->uptime);
+  cbor_put_text(&w, "temp");
+  cbor_put_int(&w, t->temperature);
+  cbor_put_text(&w, "bat");
+  cbor_put_uint(&w, t->battery);
+  cbor_put_text(&w, "acc");
+  cbor_put_array(&w, 3);
+  for (i = 0; i < 3; i++)
+    cbor_put_int(&w, t->accel[i]);
+  cbor_put_text(&w, "cur");
+  cbor_put_float(&w, t->current);
+  cbor_put_text(&w, "ok");
+  cbor_put_bool(&w, t->ok);
+
+  return cbor_writer_end(&w);
+}
+
+//Decodes a record, skipping unknown fields. Fields not present are left unchanged. Returns 0 on
+//success or a negative CBOR error code.
+int telemetry_decode(const void *data, uint16_t length, struct telemetry *t) {
+  struct cbor_reader r;
+  const char *key;
+  uint32_t key_length;
+  uint32_t count;
+  uint32_t value;
+  int32_t signed_value;
+  int bool_value;
+  uint32_t i;
+  int error;
+
+  cbor_reader_init(&r, data, length);
+
+  error = cbor_get_map(&r, &count);
+  if (error != CBOR_OK)
+    return error;
+  if (count == CBOR_INDEFINITE)
+    return CBOR_ERR_TYPE;
+
+  while (count-- > 0) {
+    error = cbor_get_text(&r, &key, &key_length);
+    if (error != CBOR_OK)
+      return error;
+
+    if (key_is(key, key_length, "seq")) {
+      error = cbor_get_uint(&r, &value);
+      t->seq = value;
+    }
+    else if (key_is(key, key_length, "up")) {
+      error = cbor_get_uint(&r, &value);
+      t->uptime = value;
+    }
+    else if (key_is(key, key_length, "temp")) {
+      error = cbor_get_int(&r, &signed_value);
+      t->temperature = signed_value;
+    }
+    else if (key_is(key, key_length, "bat")) {
+      error = cbor_get_uint(&r, &value);
+      t->battery = value;
+    }
+    else if (key_is(key, key_length, "acc")) {
+      error = cbor_get_array(&r, &value);
+      if (error == CBOR_OK && value != 3)
+        error = CBOR_ERR_TYPE;
+      for (i = 0; i < 3 && error == CBOR_OK; i++) {
+        error = cbor_get_int(&r, &signed_value);
+        t->accel[i] = signed_value;
+      }
+    }
+    else if (key_is(key, key_length, "cur"))
+      error = cbor_get_float(&r, &t->current);
+    else if (key_is(key, key_length, "ok")) {
+      error = cbor_get_bool(&r, &bool_value);
+      t->ok = bool_value;
+    }
+    else
+      error = cbor_skip(&r);
+
+    if (error != CBOR_OK)
+      return error;
+  }
+
+  return CBOR_OK;
+}
+
+//Formats a record as JSON, the way it would be sent without CBOR. Returns the length of the text.
+int telemetry_format_json(const struct telemetry *t, char *buffer, uint16_t size) {
+  int32_t temperature = t->temperature;
+  int32_t milliamps = t->current * 1000.0f;
+  const char *temperature_sign = "";
+  const char *current_sign = "";
+
+  //Format the fractional values with integer math, as the printf() of the targets lacks floats.
+  if (temperature < 0) {
+    temperature = -temperature;
+    temperature_sign = "-";
+  }
+  if (milliamps < 0) {
+    milliamps = -milliamps;
+    current_sign = "-";
+  }
+
+  return snprintf(buffer, size, "{\"seq\":%lu,\"up\":%lu,\"temp\":%s%ld.%02ld,\"bat\":%u,"
+                  "\"acc\":[%d,%d,%d],\"cur\":%s%ld.%03ld,\"ok\":%s}",
+                  (unsigned long) t->seq, (unsigned long) t->uptime, temperature_sign,
+                  (long) temperature / 100, (long) temperature % 100, t->battery, t->accel[0],
+                  t->accel[1], t->accel[2], current_sign, (long) milliamps / 1000,
+                  (long) milliamps % 1000, t->ok ? "true" : "false");
+}
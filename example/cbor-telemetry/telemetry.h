@@ -0,0 +1,30 @@
+//+------------------------------------------------------------------------------------------------+
+//| Telemetry record of the CBOR example.                                                          |
+//|                                                                                                |
+//| Records are encoded as a CBOR map with short text keys, and as the equivalent JSON object for  |
+//| comparison. Decoding skips unknown keys, so newer senders can add fields freely. This code is  |
+//| shared by the firmware and the host test program.                                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+
+struct telemetry {
+  uint32_t seq;
+  uint32_t uptime;          //Seconds
+  int16_t temperature;      //Hundredths of a degree Celsius
+  uint16_t battery;         //Millivolts
+  int16_t accel[3];         //Thousandths of g
+  float current;            //Amperes
+  uint8_t ok;
+};
+
+int telemetry_encode(const struct telemetry *t, void *buffer, uint16_t size);
+int telemetry_decode(const void *data, uint16_t length, struct telemetry *t);
+int telemetry_format_json(const struct telemetry *t, char *buffer, uint16_t size);
+
+#endif //TELEMETRY_H_
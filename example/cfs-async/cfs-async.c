@@ -0,0 +1,159 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the asynchronous file system example.                                          |
+//|                                                                                                |
+//| A logger process appends a 256 byte record to LOG.BIN on every clock tick (32KB/s) and syncs   |
+//| it every second, while a sampler process, also woken on every tick, measures how late it runs. |
+//| Every 10 seconds the logger switches between the waiting CFS calls and the queued requests,    |
+//| and prints the worst sampler jitter seen meanwhile.                                            |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "cfs-sdcard.h"
+
+#define RECORD_SIZE     256
+#define SLOTS           8
+#define PHASE_SECONDS   10
+#define PERIOD_US       (1000000 / CLOCK_SECOND)
+
+//Records queued for writing, each with its request (first, so events point to the slot).
+struct slot {
+  struct cfs_request request;
+  uint8_t busy;
+  uint32_t record[RECORD_SIZE / 4];
+};
+
+static struct slot slots[SLOTS];
+static struct cfs_request barrier;
+static uint8_t barrier_busy;
+static uint32_t record[RECORD_SIZE / 4];
+
+//Worst lateness of the sampler in the current phase, in microseconds.
+static uint32_t worst_jitter;
+
+PROCESS(logger, "Logger");
+PROCESS(sampler, "Sampler");
+
+AUTOSTART_PROCESSES(&logger);
+
+//Makes up a record: a sequence number and the time, then counting values.
+static void make_record(uint32_t *r, uint32_t sequence) {
+  uint8_t i;
+
+  r[0] = sequence;
+  r[1] = clock_time();
+  for (i = 2; i < RECORD_SIZE / 4; i++)
+    r[i] = sequence + i;
+}
+
+PROCESS_THREAD(logger, ev, data) {
+  static struct etimer et;
+  static uint32_t sequence, dropped, errors;
+  static uint16_t ticks;
+  static uint8_t queued;
+  static int fd;
+  struct slot *s = NULL;
+  uint8_t i;
+
+  PROCESS_BEGIN();
+
+  fd = cfs_open("LOG.BIN", CFS_WRITE);
+  if (fd < 0) {
+    printf("Can't create LOG.BIN\n");
+    PROCESS_EXIT();
+  }
+
+  //Measure from now on, leaving out the time the card took to mount.
+  process_start(&sampler, NULL);
+  etimer_set(&et, 1);
+  while (1) {
+    PROCESS_WAIT_EVENT();
+
+    //Completed requests free their slots.
+    if (ev == cfs_async_event) {
+      if (data == &barrier)
+        barrier_busy = 0;
+      else
+        ((struct slot *) data)->busy = 0;
+      if (((struct cfs_request *) data)->result < 0)
+        errors++;
+      continue;
+    }
+    if (!etimer_expired(&et))
+      continue;
+    etimer_reset(&et);
+
+    if (queued) {
+      for (i = 0, s = NULL; i < SLOTS && s == NULL; i++) {
+        if (!slots[i].busy)
+          s = &slots[i];
+      }
+
+      if (s == NULL)
+        dropped++;
+      else {
+        make_record(s->record, sequence++);
+        if (cfs_async_write(&s->request, fd, s->record, RECORD_SIZE) == 0)
+          s->busy = 1;
+      }
+    }
+    else {
+      make_record(record, sequence++);
+      if (cfs_write(fd, record, RECORD_SIZE) != RECORD_SIZE)
+        errors++;
+    }
+
+    if (++ticks % CLOCK_SECOND == 0) {
+      if (!queued) {
+        if (cfs_sync(fd) < 0)
+          errors++;
+      }
+      else if (!barrier_busy && cfs_async_sync(&barrier, fd) == 0)
+        barrier_busy = 1;
+    }
+
+    if (ticks == PHASE_SECONDS * CLOCK_SECOND) {
+      printf("%s: worst sampler jitter %lu us, %lu records dropped, %lu errors\n",
+             queued ? "Queued requests" : "Waiting calls", (unsigned long) worst_jitter,
+             (unsigned long) dropped, (unsigned long) errors);
+      ticks = 0;
+      dropped = 0;
+      errors = 0;
+      worst_jitter = 0;
+      queued = !queued;
+    }
+  }
+
+  PROCESS_END();
+}
+
+PROCESS_THREAD(sampler, ev, data) {
+  static struct etimer et;
+  static rtimer_clock_t last;
+  rtimer_clock_t now;
+  uint32_t interval, jitter;
+
+  PROCESS_BEGIN();
+
+  etimer_set(&et, 1);
+  last = RTIMER_NOW();
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    //Time since the last run, against the timer period.
+    now = RTIMER_NOW();
+    interval = (uint32_t) (now - last) / (RTIMER_ARCH_SECOND / 1000000);
+    last = now;
+
+    jitter = (interval > PERIOD_US) ? interval - PERIOD_US : PERIOD_US - interval;
+    if (jitter > worst_jitter)
+      worst_jitter = jitter;
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,108 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the display example.                                                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "display.h"
+
+//Box size and colors.
+#define BOX_SIZE 32
+#define BACKGROUND DISPLAY_RGB(0, 0, 64)
+#define FOREGROUND DISPLAY_RGB(255, 192, 0)
+
+//Box position and velocity.
+static int16_t box_x = 0, box_y = 0;
+static int16_t step_x = 3, step_y = 2;
+
+PROCESS(display_test, "Display test");
+
+AUTOSTART_PROCESSES(&display_test);
+
+#if DISPLAY_FRAMEBUFFER
+//Draws the box at its current position, in the given color.
+static void draw_box(uint16_t color) {
+  display_fill_rect(box_x, box_y, BOX_SIZE, BOX_SIZE, color);
+}
+#else
+//Renders a line segment of the screen from the box position.
+static void render(uint16_t y, uint16_t x, uint16_t width, uint16_t *pixels) {
+  uint16_t i;
+  int inside_y = y >= box_y && y < box_y + BOX_SIZE;
+
+  for (i = x; i < x + width; i++)
+    *pixels++ = (inside_y && i >= box_x && i < box_x + BOX_SIZE) ? FOREGROUND : BACKGROUND;
+}
+#endif
+
+//Moves the box one step, bouncing off the screen edges.
+static void move_box() {
+  box_x += step_x;
+  box_y += step_y;
+
+  if (box_x < 0 || box_x > DISPLAY_WIDTH - BOX_SIZE) {
+    step_x = -step_x;
+    box_x += 2 * step_x;
+  }
+  if (box_y < 0 || box_y > DISPLAY_HEIGHT - BOX_SIZE) {
+    step_y = -step_y;
+    box_y += 2 * step_y;
+  }
+}
+
+PROCESS_THREAD(display_test, ev, data) {
+  static struct etimer et;
+  static uint16_t frames = 0;
+  static clock_time_t start;
+
+  PROCESS_BEGIN();
+
+#if DISPLAY_FRAMEBUFFER
+  display_init(NULL);
+  display_fill_rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, BACKGROUND);
+  draw_box(FOREGROUND);
+#else
+  display_init(render);
+#endif
+
+  //Wait for the initialization, then send the first frame.
+  PROCESS_WAIT_EVENT_UNTIL(ev == display_event_flushed);
+  display_flush();
+  PROCESS_WAIT_EVENT_UNTIL(ev == display_event_flushed);
+  start = clock_time();
+
+  for (;;) {
+    //Pace frames with the etimer, and wait for the previous frame to be out before drawing the
+    //new one.
+    etimer_set(&et, CLOCK_SECOND / 64);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    if (display_busy())
+      PROCESS_WAIT_EVENT_UNTIL(ev == display_event_flushed);
+
+    //Only the old and new box areas are sent to the display.
+#if DISPLAY_FRAMEBUFFER
+    draw_box(BACKGROUND);
+    move_box();
+    draw_box(FOREGROUND);
+#else
+    display_invalidate(box_x, box_y, BOX_SIZE, BOX_SIZE);
+    move_box();
+    display_invalidate(box_x, box_y, BOX_SIZE, BOX_SIZE);
+#endif
+
+    display_flush();
+    frames++;
+
+    //Report the frame rate once per second.
+    if (clock_time() - start >= CLOCK_SECOND) {
+      printf("%u frames per second\n", frames);
+      frames = 0;
+      start += CLOCK_SECOND;
+    }
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,159 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the DSP kernel benchmark example.                                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <math.h>
+
+#include "contiki.h"
+#include "dsp.h"
+
+//Include the core header of the target, which provides access to the SysTick timer.
+#if CONTIKI_TARGET_TEENSY_36
+#include "mk66.h"
+#elif CONTIKI_TARGET_TEENSY_32
+#include "mk20.h"
+#else
+#include "mkl26.h"
+#endif
+
+//Amount of samples processed per kernel call. Kept small so the test and reference buffers fit in
+//the RAM of the smallest target.
+#define BLOCK_SIZE 64
+
+#define FIR_TAPS 32
+#define BIQUAD_STAGES 2
+
+//Test buffers.
+static double ref_in[BLOCK_SIZE];
+static double ref_out[BLOCK_SIZE];
+static dsp_sample_t in[BLOCK_SIZE];
+static dsp_sample_t out[BLOCK_SIZE];
+
+//Kernel instances and their coefficients.
+static double fir_coeffs_ref[FIR_TAPS];
+static dsp_sample_t fir_coeffs[FIR_TAPS];
+static dsp_sample_t fir_state[2 * FIR_TAPS];
+static struct dsp_fir fir;
+
+//Two stage butterworth low pass filter with a cutoff frequency of 0.1 times the sample rate. The
+//coefficients are halved so they fit in Q15, thus a post shift of 1 is used.
+static const double biquad_coeffs_ref[5 * BIQUAD_STAGES] = {
+  0.0674553, 0.1349106, 0.0674553, 1.1429805, -0.4128016,
+  0.0574221, 0.1148442, 0.0574221, 1.4216797, -0.6512683,
+};
+static dsp_sample_t biquad_coeffs[5 * BIQUAD_STAGES];
+static dsp_sample_t biquad_state[4 * BIQUAD_STAGES];
+static struct dsp_biquad biquad;
+
+PROCESS(dsp_bench, "DSP kernel benchmark");
+
+AUTOSTART_PROCESSES(&dsp_bench);
+
+//Starts the SysTick timer as a free running 24 bit down counter clocked by the core clock.
+static void cycle_counter_init() {
+  SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+static uint32_t cycle_counter_read() {
+  return SysTick->VAL;
+}
+
+//Returns the cycles elapsed since a previous counter read. Blocks must take less than 2^24 cycles.
+static uint32_t cycles_since(uint32_t start) {
+  return (start - cycle_counter_read()) & SysTick_LOAD_RELOAD_Msk;
+}
+
+//Prints a benchmark result line.
+static void report(const char *name, uint32_t cycles, double max_error) {
+  uint32_t cycles_x100 = cycles * 100 / BLOCK_SIZE;
+
+  printf("%s: %lu.%02lu cycles/sample, max error %lu ppm\n", name,
+         (unsigned long) (cycles_x100 / 100), (unsigned long) (cycles_x100 % 100),
+         (unsigned long) (max_error * 1e6));
+}
+
+//Returns the largest deviation between the kernel output and the reference output.
+static double max_deviation(const dsp_sample_t *x, const double *ref, double scale) {
+  double e, max = 0.0;
+  uint16_t i;
+
+  for (i = 0; i < BLOCK_SIZE; i++) {
+    e = fabs(dsp_to_float(x[i]) - ref[i] * scale);
+    if (e > max)
+      max = e;
+  }
+  return max;
+}
+
+PROCESS_THREAD(dsp_bench, ev, data) {
+  uint32_t start, cycles;
+  struct dsp_stats stats;
+  double rms, peak, scale;
+  uint16_t i;
+
+  PROCESS_BEGIN();
+
+  cycle_counter_init();
+
+  //Generate a test signal with two tones, and a windowed sinc low pass filter.
+  for (i = 0; i < BLOCK_SIZE; i++) {
+    ref_in[i] = 0.4 * sin(2.0 * M_PI * 3 * i / BLOCK_SIZE) +
+                0.3 * cos(2.0 * M_PI * 21 * i / BLOCK_SIZE);
+    in[i] = dsp_from_float(ref_in[i]);
+  }
+  for (i = 0; i < FIR_TAPS; i++) {
+    double t = i - (FIR_TAPS - 1) / 2.0;
+    double w = 0.54 - 0.46 * cos(2.0 * M_PI * i / (FIR_TAPS - 1));
+    fir_coeffs_ref[i] = 0.2 * w * ((t == 0.0) ? 1.0 : sin(0.2 * M_PI * t) / (0.2 * M_PI * t));
+    fir_coeffs[i] = dsp_from_float(fir_coeffs_ref[i]);
+  }
+  for (i = 0; i < 5 * BIQUAD_STAGES; i++) {
+#if DSP_ARCH == DSP_ARCH_FPU
+    biquad_coeffs[i] = biquad_coeffs_ref[i];
+#else
+    biquad_coeffs[i] = dsp_from_float(biquad_coeffs_ref[i] / 2.0);
+#endif
+  }
+
+  printf("DSP kernel benchmark, implementation %d, block size %d\n", DSP_ARCH, BLOCK_SIZE);
+
+  //FIR filter.
+  dsp_fir_init(&fir, fir_coeffs, fir_state, FIR_TAPS);
+  start = cycle_counter_read();
+  dsp_fir_process(&fir, in, out, BLOCK_SIZE);
+  cycles = cycles_since(start);
+  dsp_ref_fir(fir_coeffs_ref, FIR_TAPS, ref_in, ref_out, BLOCK_SIZE);
+  report("fir32", cycles, max_deviation(out, ref_out, 1.0));
+
+  //Biquad cascade.
+  dsp_biquad_init(&biquad, biquad_coeffs, biquad_state, BIQUAD_STAGES, 1);
+  start = cycle_counter_read();
+  dsp_biquad_process(&biquad, in, out, BLOCK_SIZE);
+  cycles = cycles_since(start);
+  dsp_ref_biquad(biquad_coeffs_ref, BIQUAD_STAGES, ref_in, ref_out, BLOCK_SIZE);
+  report("biquad2", cycles, max_deviation(out, ref_out, 1.0));
+
+  //Real FFT. Fixed point implementations scale the output by 1/n.
+  for (i = 0; i < BLOCK_SIZE; i++)
+    out[i] = in[i];
+  start = cycle_counter_read();
+  dsp_rfft(out, BLOCK_SIZE);
+  cycles = cycles_since(start);
+  dsp_ref_rfft(ref_in, ref_out, BLOCK_SIZE);
+  scale = (DSP_ARCH == DSP_ARCH_FPU) ? 1.0 : 1.0 / BLOCK_SIZE;
+  report("rfft", cycles, max_deviation(out, ref_out, scale));
+
+  //Block statistics.
+  start = cycle_counter_read();
+  dsp_stats(in, BLOCK_SIZE, &stats);
+  cycles = cycles_since(start);
+  dsp_ref_stats(ref_in, BLOCK_SIZE, &rms, &peak);
+  report("rms/peak", cycles, fabs(dsp_to_float(stats.rms) - rms));
+
+  PROCESS_END();
+}
@@ -0,0 +1,184 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the external memory benchmark example.                                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "contiki.h"
+#include "extram.h"
+#include "mk66.h"
+
+#define CORE_CLOCK_MHZ 180
+
+//Size of the buffer tested in each memory, and amount of loads in the latency test.
+#define BUFFER_SIZE 8192
+#define WORDS (BUFFER_SIZE / 4)
+#define CHASE_LOADS 1024
+
+//One buffer in each memory: the lower SRAM block (code bus), the upper SRAM block (system bus)
+//and external memory.
+static uint32_t sram_l_buffer[WORDS];
+static uint32_t sram_u_buffer[WORDS] __attribute__((section(".sram_u")));
+static uint32_t extram_buffer[WORDS] EXTRAM_DATA;
+
+//Internal buffer used as the other end of the copy tests.
+static uint32_t copy_buffer[WORDS];
+
+struct memory {
+  const char *name;
+  uint32_t *buffer;
+};
+
+static const struct memory memories[] = {
+  { "SRAM_L", sram_l_buffer },
+  { "SRAM_U", sram_u_buffer },
+  { "EXTRAM", extram_buffer },
+};
+
+PROCESS(extram_bench, "External memory benchmark");
+
+AUTOSTART_PROCESSES(&extram_bench);
+
+//Starts the SysTick timer as a free running 24 bit down counter clocked by the core clock.
+static void cycle_counter_init() {
+  SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+static uint32_t cycle_counter_read() {
+  return SysTick->VAL;
+}
+
+//Returns the cycles elapsed since a previous counter read. Tests must take less than 2^24 cycles.
+static uint32_t cycles_since(uint32_t start) {
+  return (start - cycle_counter_read()) & SysTick_LOAD_RELOAD_Msk;
+}
+
+//Prints a bandwidth in MB/s, given the bytes moved and the cycles taken.
+static void report_bandwidth(const char *test, uint32_t bytes, uint32_t cycles) {
+  uint32_t rate_x10 = (uint64_t) bytes * CORE_CLOCK_MHZ * 10 / cycles;
+
+  printf("  %-12s %4lu.%lu MB/s\n", test, (unsigned long) (rate_x10 / 10),
+         (unsigned long) (rate_x10 % 10));
+}
+
+//Test pattern of a word, scrambled from its address so address line faults show up.
+static uint32_t pattern(volatile uint32_t *word) {
+  return (uint32_t) word * 2654435761UL;
+}
+
+//Fills the memory with a pattern depending on the address and reads it back, then does the same
+//with the inverted pattern. Returns the number of mismatching words.
+static uint32_t test_memory(volatile uint32_t *buffer, uint32_t words) {
+  uint32_t i, errors = 0;
+
+  for (i = 0; i < words; i++)
+    buffer[i] = pattern(&buffer[i]);
+  for (i = 0; i < words; i++)
+    errors += buffer[i] != pattern(&buffer[i]);
+
+  for (i = 0; i < words; i++)
+    buffer[i] = ~pattern(&buffer[i]);
+  for (i = 0; i < words; i++)
+    errors += buffer[i] != ~pattern(&buffer[i]);
+
+  return errors;
+}
+
+//Links the buffer words into a single random cycle of indexes (Sattolo's algorithm), so each load
+//of the chase depends on the previous one and hits a random location.
+static void build_chase(uint32_t *buffer) {
+  uint32_t i, j, t, seed = 1;
+
+  for (i = 0; i < WORDS; i++)
+    buffer[i] = i;
+  for (i = WORDS - 1; i > 0; i--) {
+    seed = seed * 1664525 + 1013904223;
+    j = (seed >> 8) % i;
+    t = buffer[i];
+    buffer[i] = buffer[j];
+    buffer[j] = t;
+  }
+}
+
+static void benchmark(const struct memory *m) {
+  volatile uint32_t *buffer = m->buffer;
+  uint32_t i, start, cycles, sum = 0;
+
+  printf("%s at 0x%08lx:\n", m->name, (unsigned long) m->buffer);
+
+  //Word writes and reads.
+  start = cycle_counter_read();
+  for (i = 0; i < WORDS; i++)
+    buffer[i] = i;
+  cycles = cycles_since(start);
+  report_bandwidth("write", BUFFER_SIZE, cycles);
+
+  start = cycle_counter_read();
+  for (i = 0; i < WORDS; i++)
+    sum += buffer[i];
+  cycles = cycles_since(start);
+  report_bandwidth("read", BUFFER_SIZE, cycles);
+
+  //Block copies to and from internal memory.
+  start = cycle_counter_read();
+  memcpy(m->buffer, copy_buffer, BUFFER_SIZE);
+  cycles = cycles_since(start);
+  report_bandwidth("copy to", BUFFER_SIZE, cycles);
+
+  start = cycle_counter_read();
+  memcpy(copy_buffer, m->buffer, BUFFER_SIZE);
+  cycles = cycles_since(start);
+  report_bandwidth("copy from", BUFFER_SIZE, cycles);
+
+  //Dependent random loads.
+  build_chase(m->buffer);
+  start = cycle_counter_read();
+  for (i = 0; i < CHASE_LOADS; i++)
+    sum = buffer[sum % WORDS];
+  cycles = cycles_since(start);
+  printf("  %-12s %4lu cycles/load\n", "latency", (unsigned long) ((cycles + CHASE_LOADS / 2) /
+         CHASE_LOADS));
+
+  //Keep the loads from being optimized away.
+  copy_buffer[0] = sum;
+}
+
+PROCESS_THREAD(extram_bench, ev, data) {
+  uint32_t errors, available;
+  uint8_t *a, *b, *c;
+  uint8_t i;
+
+  PROCESS_BEGIN();
+
+  cycle_counter_init();
+
+  //Check the whole external memory before trusting it: the statically placed buffer and the pool
+  //(through its largest block).
+  available = extram_available();
+  a = extram_alloc(available);
+  errors = test_memory(extram_buffer, WORDS) + test_memory((uint32_t *) a, available / 4);
+  extram_free(a);
+  printf("External memory test: %lu errors\n", (unsigned long) errors);
+
+  for (i = 0; i < sizeof(memories) / sizeof(memories[0]); i++)
+    benchmark(&memories[i]);
+
+  //Exercise the pool: fragment it and check it merges back.
+  a = extram_alloc(100000);
+  b = extram_alloc(50000);
+  c = extram_alloc(100000);
+  extram_free(b);
+  printf("Pool: %lu bytes free, %lu after allocating 3 blocks and freeing the middle one\n",
+         (unsigned long) available, (unsigned long) extram_available());
+  extram_free(a);
+  extram_free(c);
+  printf("Pool: %lu bytes free after freeing all (%s)\n", (unsigned long) extram_available(),
+         extram_available() == available ? "OK" : "leak");
+
+  PROCESS_END();
+}
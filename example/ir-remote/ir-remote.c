@@ -0,0 +1,124 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the infrared remote example.                                                   |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "ir.h"
+
+//Codes sent by the demo.
+#define NEC_ADDRESS 0x04
+#define NEC_COMMAND 0x08
+#define RC5_ADDRESS 0x00
+#define RC5_COMMAND 0x0C
+
+//Pulse distance timings of the raw frame, like the ones used by air conditioners.
+#define RAW_LEADER_MARK 3400
+#define RAW_LEADER_SPACE 1700
+#define RAW_BIT_MARK 430
+#define RAW_ZERO_SPACE 430
+#define RAW_ONE_SPACE 1290
+
+//Raw frame contents (sent least significant bit first).
+static const uint8_t raw_frame[] = { 0x23, 0xCB, 0x26, 0x01, 0x00, 0x20, 0x08, 0x06, 0x30, 0x45 };
+#define RAW_LENGTH (2 + 16 * sizeof(raw_frame) + 1)
+
+static uint16_t durations[RAW_LENGTH];
+
+PROCESS(ir_remote, "IR remote");
+
+AUTOSTART_PROCESSES(&ir_remote);
+
+//Encodes the raw frame.
+static uint16_t encode_raw() {
+  uint16_t i, n = 0;
+
+  durations[n++] = RAW_LEADER_MARK;
+  durations[n++] = RAW_LEADER_SPACE;
+  for (i = 0; i < 8 * sizeof(raw_frame); i++) {
+    durations[n++] = RAW_BIT_MARK;
+    durations[n++] = (raw_frame[i / 8] & (1 << (i % 8))) ? RAW_ONE_SPACE : RAW_ZERO_SPACE;
+  }
+  durations[n++] = RAW_BIT_MARK;
+
+  return n;
+}
+
+PROCESS_THREAD(ir_remote, ev, data) {
+  static struct etimer et;
+  static rtimer_clock_t start;
+  static uint32_t polls;
+  static uint16_t count;
+  static uint8_t step, toggle, repeats;
+
+  PROCESS_BEGIN();
+
+  ir_init();
+
+  step = 0;
+  toggle = 0;
+
+  while (1) {
+    //Encode and start the next sequence.
+    switch (step) {
+      case 0:
+        count = ir_encode_nec(durations, NEC_ADDRESS, NEC_COMMAND);
+        ir_send(durations, count, IR_NEC_CARRIER, IR_NEC_DUTY);
+        printf("NEC address 0x%02X command 0x%02X", NEC_ADDRESS, NEC_COMMAND);
+        break;
+
+      case 1:
+        count = ir_encode_rc5(durations, toggle, RC5_ADDRESS, RC5_COMMAND);
+        ir_send(durations, count, IR_RC5_CARRIER, IR_RC5_DUTY);
+        printf("RC5 address 0x%02X command 0x%02X toggle %u", RC5_ADDRESS, RC5_COMMAND, toggle);
+        toggle ^= 1;
+        break;
+
+      default:
+        count = encode_raw();
+        ir_send(durations, count, IR_NEC_CARRIER, IR_NEC_DUTY);
+        printf("Raw frame of %u bytes", (unsigned) sizeof(raw_frame));
+        break;
+    }
+    start = RTIMER_NOW();
+
+    //Keep running while the frame goes out, counting the times this process gets to run.
+    polls = 0;
+    process_poll(&ir_remote);
+    do {
+      PROCESS_WAIT_EVENT();
+      if (ev == PROCESS_EVENT_POLL) {
+        polls++;
+        process_poll(&ir_remote);
+      }
+    } while (ev != ir_event);
+
+    printf(": %u durations, %lu us, process ran %lu times meanwhile\n", count,
+           (unsigned long) (RTIMER_NOW() - start) / (RTIMER_ARCH_SECOND / 1000000),
+           (unsigned long) polls);
+
+    //Hold the NEC key for a while, sending repeat codes every 110ms (from frame start to frame
+    //start). The first one is timed from the end of the frame, which lasted about 67ms.
+    if (step == 0) {
+      count = ir_encode_nec_repeat(durations);
+      etimer_set(&et, CLOCK_SECOND * 43 / 1000);
+      for (repeats = 0; repeats < 3; repeats++) {
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+        etimer_set(&et, CLOCK_SECOND * 110 / 1000);
+        ir_send(durations, count, IR_NEC_CARRIER, IR_NEC_DUTY);
+        PROCESS_WAIT_EVENT_UNTIL(ev == ir_event);
+      }
+      printf("NEC repeat codes: 3\n");
+    }
+
+    step = (step + 1) % 3;
+
+    etimer_set(&et, 2 * CLOCK_SECOND);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,102 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the LED strip example.                                                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "led-strip.h"
+
+//Strip length of every chain and pixel size (3 for RGB strips, 4 for RGBW ones).
+#define PIXELS 144
+#define BYTES_PER_PIXEL 3
+
+//Total length, over all the chains of the CPU.
+#define TOTAL_PIXELS (PIXELS * LED_STRIP_CHAINS)
+
+//Frame buffers, with a slice for every chain.
+static uint8_t frame_a[TOTAL_PIXELS * BYTES_PER_PIXEL];
+static uint8_t frame_b[TOTAL_PIXELS * BYTES_PER_PIXEL];
+
+static struct led_strip strips[LED_STRIP_CHAINS];
+
+PROCESS(led_strip_test, "LED strip test");
+
+AUTOSTART_PROCESSES(&led_strip_test);
+
+//Converts a position in the color wheel (0-767) to a dimmed color.
+static void wheel(uint16_t pos, uint8_t *r, uint8_t *g, uint8_t *b) {
+  uint8_t level = pos & 0xFF;
+
+  if (pos < 256) {
+    *r = 255 - level; *g = level; *b = 0;
+  } else if (pos < 512) {
+    *r = 0; *g = 255 - level; *b = level;
+  } else {
+    *r = level; *g = 0; *b = 255 - level;
+  }
+
+  *r >>= 3;
+  *g >>= 3;
+  *b >>= 3;
+}
+
+//Draws a rainbow scrolled by the given offset into the back buffer, across all the chains.
+static void draw(uint16_t offset) {
+  uint16_t i;
+  uint8_t r, g, b;
+
+  for (i = 0; i < TOTAL_PIXELS; i++) {
+    wheel((offset + (uint32_t) i * 768 / TOTAL_PIXELS) % 768, &r, &g, &b);
+    led_strip_set_pixel(&strips[i / PIXELS], i % PIXELS, r, g, b, 0);
+  }
+}
+
+PROCESS_THREAD(led_strip_test, ev, data) {
+  static struct etimer et;
+  static uint16_t offset = 0;
+  static uint16_t frames = 0;
+  static clock_time_t start;
+  static uint8_t i;
+
+  PROCESS_BEGIN();
+
+  for (i = 0; i < LED_STRIP_CHAINS; i++) {
+    if (led_strip_init(&strips[i], i, &frame_a[i * PIXELS * BYTES_PER_PIXEL],
+                       &frame_b[i * PIXELS * BYTES_PER_PIXEL], PIXELS, BYTES_PER_PIXEL) != 0) {
+      printf("Can't set up chain %u\n", i);
+      PROCESS_EXIT();
+    }
+  }
+  start = clock_time();
+
+  for (;;) {
+    //Draw the next frame while the current one is being sent.
+    draw(offset);
+    offset = (offset + 4) % 768;
+
+    //Pace frames with the etimer, and wait for the previous frame to be out on every chain before
+    //showing the new one.
+    etimer_set(&et, CLOCK_SECOND / 64);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    for (i = 0; i < LED_STRIP_CHAINS; i++) {
+      while (led_strip_busy(&strips[i]))
+        PROCESS_WAIT_EVENT_UNTIL(ev == led_strip_event_done);
+    }
+
+    for (i = 0; i < LED_STRIP_CHAINS; i++)
+      led_strip_show(&strips[i]);
+    frames++;
+
+    //Report the frame rate once per second.
+    if (clock_time() - start >= CLOCK_SECOND) {
+      printf("%u frames per second\n", frames);
+      frames = 0;
+      start += CLOCK_SECOND;
+    }
+  }
+
+  PROCESS_END();
+}
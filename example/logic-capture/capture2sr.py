@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+#+-------------------------------------------------------------------------------------------------+
+#| Converts a capture streamed by the logic capture example into a sigrok session file (.sr), to   |
+#| be opened with PulseView or sigrok-cli.                                                         |
+#|                                                                                                 |
+#| The input is either a file with the raw serial output of the board, or the serial port itself   |
+#| (requires pyserial). Text printed around the capture is skipped.                                |
+#|                                                                                                 |
+#| Author: Joksan Alvarado.                                                                        |
+#+-------------------------------------------------------------------------------------------------+
+
+import argparse
+import struct
+import sys
+import zipfile
+
+MAGIC = b'KLA1'
+HEADER_SIZE = 16
+CHANNELS = 8
+
+
+class Truncated(ValueError):
+    """Raised when the input ends before the capture does."""
+
+
+def read_capture(args):
+    """Reads and decodes the first capture found in the input."""
+    if args.port is None:
+        with open(args.input, 'rb') as f:
+            return decode(f.read())
+
+    #Read from the serial port until a whole capture has arrived.
+    import serial
+    data = b''
+    with serial.Serial(args.port, args.baud, timeout=args.timeout) as port:
+        while True:
+            chunk = port.read(4096)
+            if not chunk:
+                raise Truncated('no complete capture received')
+            data += chunk
+            try:
+                return decode(data)
+            except Truncated:
+                pass
+
+
+def decode(stream):
+    """Decodes a capture, returning (rate, trigger index, samples)."""
+    start = stream.find(MAGIC)
+    if start < 0 or start + HEADER_SIZE > len(stream):
+        raise Truncated('no capture found in the input')
+
+    rate, count, trigger = struct.unpack_from('<III', stream, start + len(MAGIC))
+    pos = start + HEADER_SIZE
+    samples = bytearray()
+
+    while len(samples) < count:
+        if pos >= len(stream):
+            raise Truncated('capture truncated after %u of %u samples' % (len(samples), count))
+        value = stream[pos]
+        pos += 1
+
+        #Run length minus one, LEB128 encoded.
+        run = 0
+        shift = 0
+        while True:
+            if pos >= len(stream):
+                raise Truncated('capture truncated inside a run')
+            byte = stream[pos]
+            pos += 1
+            run |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+
+        samples += bytes([value]) * (run + 1)
+
+    if len(samples) != count:
+        raise ValueError('run lengths add up to %u samples, expected %u' % (len(samples), count))
+
+    return rate, trigger, bytes(samples)
+
+
+def rate_string(rate):
+    """Formats a sample rate the way sigrok writes it."""
+    for divisor, unit in ((1000000, 'MHz'), (1000, 'kHz')):
+        if rate % divisor == 0:
+            return '%u %s' % (rate // divisor, unit)
+    return '%u Hz' % rate
+
+
+def write_session(path, rate, samples):
+    """Writes a version 2 sigrok session file with a single logic capture."""
+    metadata = ['[global]', 'sigrok version=0.5.1', '', '[device 1]', 'capturefile=logic-1',
+                'total probes=%u' % CHANNELS, 'samplerate=%s' % rate_string(rate),
+                'total analog=0']
+    metadata += ['probe%u=D%u' % (i + 1, i) for i in range(CHANNELS)]
+    metadata += ['unitsize=1', '']
+
+    with zipfile.ZipFile(path, 'w', zipfile.ZIP_DEFLATED) as z:
+        z.writestr('version', '2')
+        z.writestr('metadata', '\n'.join(metadata))
+        z.writestr('logic-1-1', samples)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts a capture to a sigrok session file.')
+    parser.add_argument('input', nargs='?', help='file with the raw serial output')
+    parser.add_argument('output', help='sigrok session file to write')
+    parser.add_argument('--port', help='read from this serial port instead of a file')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--timeout', type=float, default=30.0,
+                        help='seconds to wait for serial data')
+    args = parser.parse_args()
+
+    if args.input is None and args.port is None:
+        parser.error('either an input file or --port is required')
+
+    try:
+        rate, trigger, samples = read_capture(args)
+    except ValueError as e:
+        sys.exit('error: %s' % e)
+
+    write_session(args.output, rate, samples)
+    print('%u samples at %s, trigger at sample %u (%.1fus)' %
+          (len(samples), rate_string(rate), trigger, trigger * 1e6 / rate))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,58 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the logic capture example.                                                     |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "capture.h"
+#include "uart.h"
+
+//Capture settings: 1MHz sampling, triggering on a falling edge of channel 0, keeping 1000 samples
+//before it and 4000 from it on.
+#define RATE 1000000
+#define PRE_SAMPLES 1000
+#define POST_SAMPLES 4000
+
+static const struct capture_trigger trigger = {
+  .mask = 0x01,
+  .value = 0x00,
+  .edges = 0x01,
+};
+
+PROCESS(logic_capture, "Logic capture");
+
+AUTOSTART_PROCESSES(&logic_capture);
+
+PROCESS_THREAD(logic_capture, ev, data) {
+  static uint8_t buffer[64];
+  static struct etimer et;
+  uint16_t i, n;
+
+  PROCESS_BEGIN();
+
+  capture_init();
+
+  for (;;) {
+    printf("Waiting for trigger\n");
+    fflush(stdout);
+    capture_start(RATE, &trigger, PRE_SAMPLES, POST_SAMPLES);
+    PROCESS_WAIT_EVENT_UNTIL(ev == capture_event_done);
+
+    //Stream the capture in small chunks, letting other processes run in between.
+    while ((n = capture_encode(buffer, sizeof(buffer))) > 0) {
+      for (i = 0; i < n; i++)
+        uart_tx(UART0, buffer[i]);
+      PROCESS_PAUSE();
+    }
+    printf("\nCapture sent\n");
+
+    //Rearm after a while.
+    etimer_set(&et, CLOCK_SECOND);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+
+  PROCESS_END();
+}
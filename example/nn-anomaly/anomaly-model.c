@@ -0,0 +1,134 @@
+//+------------------------------------------------------------------------------------------------+
+//| Anomaly detection model for the neural network inference example.                              |
+//|                                                                                                |
+//| Small int8 autoencoder for windows of 64 vibration samples: a convolutional encoder (conv1d    |
+//| with 8 filters, max pooling and a dense layer down to 8 features) followed by a dense decoder  |
+//| that reconstructs the window. Weights are constant, so they stay in flash.                     |
+//|                                                                                                |
+//| The weights below are placeholders generated with a fixed seed, suitable to exercise the       |
+//| runtime and its kernels. A trained model exported with the same layer layout and quantization  |
+//| parameters can replace them without further changes.                                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include "anomaly-model.h"
+
+static const int8_t conv_weights[64] = {
+  -19, -41, -10, 23, -54, -51, 45, 8, -48, -14, 14, -53, 56, 4, -33, -56,
+  -49, -5, -7, -52, -30, -49, 10, -6, -53, 45, 12, -45, -32, 20, 20, 14,
+  -53, 13, 14, -10, -54, -32, -55, 11, 49, -43, -23, -7, -42, 9, -45, 13,
+  -21, 11, 44, 27, -37, -47, 14, 13, 21, -36, -13, -48, 10, 31, -52, 12,
+};
+static const int32_t conv_bias[8] = {
+  0, 0, 0, 0, 0, 0, 0, 0,
+};
+static const int8_t encoder_weights[448] = {
+  -33, 39, -14, 23, 28, 14, 0, 19, 34, 18, 6, -2, -9, -17, -9, -30,
+  33, -2, 27, 23, 3, 17, -4, 37, -31, -25, 25, 13, -19, 3, -21, 22,
+  13, -35, -31, 31, 33, 0, 3, 4, 36, 23, 34, 18, -32, -29, -6, 20,
+  -32, -33, -1, 33, 17, -4, 9, 4, -38, 19, 5, -19, 38, -26, 23, -33,
+  -13, -4, -24, -9, 10, 10, 23, -30, -19, 17, 11, 30, -5, -23, 15, 30,
+  -5, 13, 5, 8, -11, -21, -30, -18, -21, -11, -11, -39, 22, 35, -17, -7,
+  -4, -40, -22, 13, 28, 7, 38, 32, 0, -24, 25, 39, -34, 18, 31, 10,
+  10, 11, 10, -27, 21, 11, -33, -16, -32, -14, 16, -20, -26, 3, 36, -34,
+  -27, -40, 32, -21, 28, -28, 6, 38, -37, -31, -14, 38, 8, -21, -8, 4,
+  37, 6, 20, -25, -26, 22, 19, 21, 21, -1, -30, -22, -27, 3, -7, 21,
+  -20, 26, -38, -14, 27, 6, -22, 29, -37, 27, -2, -29, -7, 26, 6, -19,
+  5, -12, 28, 29, 24, 2, -12, 38, -16, -10, 11, -11, -15, 26, 23, 5,
+  -37, -37, -5, 20, -7, -16, 37, 4, 17, 4, 6, -30, -12, -27, -11, 20,
+  -15, 3, -14, 21, 39, 38, -40, 21, 4, -30, -25, 9, -15, 21, -18, 15,
+  2, -29, 10, 19, 11, -30, -20, -19, -24, -37, -21, 35, 19, -22, 38, 36,
+  20, 4, -21, 30, 30, -24, -38, -39, -27, 27, -23, 15, -16, -13, -37, -8,
+  -13, -3, 24, -10, 35, 1, -7, 29, 13, -24, -33, 5, 18, 34, 26, 13,
+  24, -24, 28, -21, 27, 25, -38, 16, -17, 37, -40, -21, -18, -22, 20, 39,
+  -25, 31, -33, 1, 26, 27, 31, 21, -27, 31, -33, -9, -16, -5, -35, -28,
+  24, 17, 31, -37, -32, 16, 1, 38, 24, 37, 25, -15, -5, 17, 25, 28,
+  21, 24, -9, 26, -7, 31, -15, 17, -23, 13, -25, 10, 16, 0, -31, -10,
+  14, -31, -13, -2, -25, -21, 6, -22, -8, -23, 19, -12, -28, 10, 22, -20,
+  -12, -20, 15, 25, 11, 3, 13, -15, 5, 0, -29, 6, -38, 3, 30, 18,
+  16, -38, 9, 2, 26, 39, -3, 25, -32, -26, -11, -27, -30, -7, -6, -35,
+  -17, -6, -24, 14, -7, 11, -21, 28, 25, 33, 23, 1, -29, -5, -33, -17,
+  14, -31, -6, -38, -29, -7, -30, 37, -12, -32, -7, -25, 18, -39, 3, 30,
+  13, -6, 39, -24, -35, 27, -10, -26, -20, -7, -34, -17, -15, -1, 40, -1,
+  27, -14, -3, 17, 24, -18, -6, 4, -38, -8, -36, -39, -38, 24, 30, -16,
+};
+static const int32_t encoder_bias[8] = {
+  0, 0, 0, 0, 0, 0, 0, 0,
+};
+static const int8_t decoder_weights[512] = {
+  25, 20, -9, 17, -27, 15, 23, 29, 10, 24, -1, -13, -11, 3, -15, -23,
+  11, 4, -34, -24, -39, -31, 40, -8, 15, -20, -33, -30, 8, 24, -4, 36,
+  -9, -3, -35, 18, -17, -20, -6, 17, -40, -7, 6, 2, 30, 1, -9, -36,
+  -1, -13, 5, -17, -40, 2, 8, -30, 20, -5, 24, -15, -9, 24, -40, -29,
+  -7, -29, -22, 11, 35, -35, 10, -38, -2, -2, 40, -11, -30, 34, 27, -21,
+  36, 9, 1, 23, -21, -4, 39, -22, -35, 25, 40, 14, 24, -23, 27, 24,
+  32, -38, 34, -11, -30, -37, -35, -23, 6, -27, 8, 17, 31, -34, 40, -38,
+  40, 28, -9, 22, -7, -40, 18, -32, 24, 28, -29, 27, -32, 20, -8, -31,
+  -7, -10, -14, -11, 18, 23, 8, -31, 21, -4, -35, 38, 40, -15, -31, 36,
+  -22, 2, -8, -2, 39, 32, -23, -39, 21, -33, 22, -6, -28, -13, 22, -3,
+  26, -4, 19, 19, 19, -25, 30, -15, -1, -30, 20, -38, -3, 18, -31, 24,
+  17, -6, 9, -14, -14, -31, 34, -29, -22, 27, -7, 6, -24, 37, 40, 25,
+  -5, -26, 6, -11, 23, 22, 10, -37, -20, -40, 22, 17, 11, -2, -22, 13,
+  4, 8, 0, -25, 2, -40, 1, 3, 10, -25, -15, -39, -3, -8, 7, -32,
+  10, 9, 35, -31, 6, 14, -5, -34, -5, -27, -34, -4, -21, -9, -6, 15,
+  25, 0, -16, 7, 14, -37, 40, 11, 30, 30, -14, -30, -34, 12, 17, 38,
+  -23, -4, 22, -34, 30, -24, -19, 20, 13, 3, -4, -2, -8, -7, 11, -10,
+  -2, 21, 31, 10, -25, -19, -20, -31, -14, 24, 23, 30, -12, 17, 2, 17,
+  14, -23, 30, -16, -9, -29, -18, 3, 31, -29, 0, -10, 7, -7, 32, -15,
+  -38, 12, 9, 12, 27, -14, 8, -6, 3, -33, 23, -5, 33, 6, -24, 24,
+  27, 40, -13, -29, -6, -9, 9, 11, 17, 15, -1, -38, -24, -36, 14, 20,
+  35, 22, -40, -31, 10, 27, 19, 17, -9, -27, -12, -21, -21, 26, -27, 18,
+  -30, 30, -35, -40, -24, -11, 32, -36, -2, -24, 40, -8, 27, 15, -26, -28,
+  -31, -2, 27, 34, -16, 9, -7, -12, 36, -40, -39, 28, -2, 18, -5, 0,
+  -9, 20, 27, -10, 30, -9, -37, 12, -1, -33, -38, -16, 23, 13, -30, -8,
+  -11, 14, 7, -11, 23, -36, 3, 13, 6, 10, -15, -40, -3, 24, -32, -14,
+  23, -15, -1, -16, -11, 19, -12, -7, -3, -27, 39, 23, 38, -17, -12, 22,
+  13, -33, 36, -22, 10, -34, -13, -37, 36, -22, 13, -34, -33, -17, 10, 17,
+  0, -26, -30, -19, 2, -16, -17, 27, 19, -36, -1, 8, 7, 2, 16, -19,
+  -27, -40, -30, -5, -30, 4, 13, -25, 31, -14, 8, 5, -1, 15, -29, -34,
+  20, -15, 7, 29, 17, -16, 1, 6, 20, -37, 40, 12, -9, 40, 11, -35,
+  8, -36, 19, -32, -33, -8, -16, -32, 37, 3, 6, -6, 2, 38, -35, -7,
+};
+static const int32_t decoder_bias[64] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+//Input and output tensors use a zero point of 0. Hidden activations are rectified by clamping them
+//at their zero point (act_min = 0).
+static const struct nn_layer layers[] = {
+  {
+    .type = NN_LAYER_CONV1D, .kernel = 8, .stride = 4,
+    .in_len = ANOMALY_WINDOW, .in_ch = 1, .out_len = 15, .out_ch = 8,
+    .in_offset = 0, .out_offset = 0, .act_min = 0, .act_max = 127,
+    .multiplier = 1351636979, .shift = -5,
+    .weights = conv_weights, .bias = conv_bias,
+  },
+  {
+    .type = NN_LAYER_MAXPOOL1D, .kernel = 3, .stride = 2,
+    .in_len = 15, .in_ch = 8, .out_len = 7, .out_ch = 8,
+    .act_min = -128, .act_max = 127,
+  },
+  {
+    .type = NN_LAYER_DENSE,
+    .in_len = 7, .in_ch = 8, .out_len = 1, .out_ch = 8,
+    .in_offset = 0, .out_offset = 0, .act_min = 0, .act_max = 127,
+    .multiplier = 1391395479, .shift = -8,
+    .weights = encoder_weights, .bias = encoder_bias,
+  },
+  {
+    .type = NN_LAYER_DENSE,
+    .in_len = 1, .in_ch = 8, .out_len = 1, .out_ch = ANOMALY_WINDOW,
+    .in_offset = 0, .out_offset = 0, .act_min = -128, .act_max = 127,
+    .multiplier = 1217471045, .shift = -6,
+    .weights = decoder_weights, .bias = decoder_bias,
+  },
+};
+
+const struct nn_model anomaly_model = {
+  .layers = layers,
+  .num_layers = sizeof(layers) / sizeof(layers[0]),
+};
@@ -0,0 +1,17 @@
+//+------------------------------------------------------------------------------------------------+
+//| Anomaly detection model for the neural network inference example.                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef ANOMALY_MODEL_H_
+#define ANOMALY_MODEL_H_
+
+#include "nn.h"
+
+//Samples per input window (and per reconstructed window).
+#define ANOMALY_WINDOW 64
+
+extern const struct nn_model anomaly_model;
+
+#endif //ANOMALY_MODEL_H_
@@ -0,0 +1,145 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the neural network anomaly detection example.                                  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <math.h>
+
+#include "contiki.h"
+#include "lib/random.h"
+#include "nn.h"
+#include "anomaly-model.h"
+
+//Every this many windows, a fault (periodic impacts) is injected into the synthetic signal.
+#define FAULT_PERIOD 8
+
+static int8_t window[ANOMALY_WINDOW];
+static int8_t reconstruction[ANOMALY_WINDOW];
+static int8_t ref_reconstruction[ANOMALY_WINDOW];
+static int8_t ref_scratch[256];
+
+//Model made of the first (convolution) layer alone, which needs no arena, and its output size.
+static struct nn_model conv_model;
+#define CONV_SIZE (15 * 8)
+static int8_t conv_output[CONV_SIZE];
+static int8_t ref_conv_output[CONV_SIZE];
+
+static struct nn_request request;
+static struct etimer timer;
+
+PROCESS(nn_anomaly, "NN anomaly detection");
+
+AUTOSTART_PROCESSES(&nn_anomaly);
+
+//Fills the input window with a synthetic vibration signal: two tones plus noise, and optionally a
+//train of impacts as produced by a damaged bearing. Samples are quantized with a scale of 1/100.
+static void make_window(uint16_t n, int fault) {
+  double v;
+  int32_t q;
+  uint16_t i;
+
+  for (i = 0; i < ANOMALY_WINDOW; i++) {
+    v = 0.6 * sin(2.0 * M_PI * 5 * i / ANOMALY_WINDOW + 0.3 * n) +
+        0.2 * sin(2.0 * M_PI * 11 * i / ANOMALY_WINDOW);
+    v += ((int) (random_rand() % 9) - 4) / 100.0;
+    if (fault && (i % 16) < 2)
+      v += (i % 16) ? -0.5 : 0.9;
+
+    q = lround(v * 100);
+    window[i] = (q < -128) ? -128 : (q > 127) ? 127 : q;
+  }
+}
+
+//Computes the anomaly score as the mean squared reconstruction error.
+static uint32_t anomaly_score() {
+  uint32_t sum = 0;
+  int32_t e;
+  uint16_t i;
+
+  for (i = 0; i < ANOMALY_WINDOW; i++) {
+    e = window[i] - reconstruction[i];
+    sum += e * e;
+  }
+  return sum / ANOMALY_WINDOW;
+}
+
+//Runs the reference kernels over the same window and checks the results match bit by bit.
+static int check_reference() {
+  uint16_t i;
+
+  if (nn_ref_run(&anomaly_model, window, ref_reconstruction, ref_scratch,
+                 sizeof(ref_scratch)) != NN_OK)
+    return 0;
+
+  for (i = 0; i < ANOMALY_WINDOW; i++) {
+    if (reconstruction[i] != ref_reconstruction[i])
+      return 0;
+  }
+  return 1;
+}
+
+//Runs the single layer model with both kernel sets and checks the results match bit by bit.
+static int check_single_layer() {
+  uint16_t i;
+
+  conv_model.layers = anomaly_model.layers;
+  conv_model.num_layers = 1;
+  if (nn_run(&conv_model, window, conv_output) != NN_OK ||
+      nn_ref_run(&conv_model, window, ref_conv_output, ref_scratch, 0) != NN_OK)
+    return 0;
+
+  for (i = 0; i < CONV_SIZE; i++) {
+    if (conv_output[i] != ref_conv_output[i])
+      return 0;
+  }
+  return 1;
+}
+
+PROCESS_THREAD(nn_anomaly, ev, data) {
+  static uint16_t n;
+  static clock_time_t start;
+  uint32_t size;
+  int status;
+
+  PROCESS_BEGIN();
+
+  nn_init();
+  status = nn_arena_size(&anomaly_model, &size);
+  if (status != NN_OK) {
+    printf("Invalid model: %d\n", status);
+    PROCESS_EXIT();
+  }
+  printf("NN anomaly detection, arena usage %lu bytes\n", (unsigned long) size);
+
+  //The first window also goes through the single layer model.
+  make_window(0, 0);
+  printf("Single layer model: %s\n", check_single_layer() ? "bit exact" : "MISMATCH");
+
+  etimer_set(&timer, CLOCK_SECOND / 4);
+
+  for (n = 0; ; n++) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+    etimer_reset(&timer);
+
+    //Queue the inference on the runtime process and wait for it to finish.
+    make_window(n, (n % FAULT_PERIOD) == FAULT_PERIOD - 1);
+    request.model = &anomaly_model;
+    request.input = window;
+    request.output = reconstruction;
+    request.requester = PROCESS_CURRENT();
+    start = clock_time();
+    status = nn_infer(&request);
+    if (status != NN_OK) {
+      printf("Inference failed: %d\n", status);
+      continue;
+    }
+    PROCESS_WAIT_EVENT_UNTIL(ev == nn_event_done);
+
+    printf("Window %u: score %lu, %lu ticks, %s\n", n, (unsigned long) anomaly_score(),
+           (unsigned long) (clock_time() - start), check_reference() ? "bit exact" : "MISMATCH");
+  }
+
+  PROCESS_END();
+}
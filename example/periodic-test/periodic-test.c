@@ -0,0 +1,79 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the periodic task service test example.                                        |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "periodic.h"
+
+static struct periodic_task sample_task;
+static struct periodic_task filter_task;
+static struct periodic_task beacon_task;
+
+static volatile uint32_t sample_count;
+
+PROCESS(periodic_test, "Periodic task test");
+
+AUTOSTART_PROCESSES(&periodic_test);
+
+//Busy waits for a given amount of microseconds, emulating work.
+static void work(uint32_t us) {
+  rtimer_clock_t start = RTIMER_NOW();
+
+  while (RTIMER_NOW() - start < PERIODIC_US_TO_TICKS(us));
+}
+
+//Sensor sampling task: short job, tight deadline.
+static void sample(void *ptr) {
+  sample_count++;
+  work(100);
+}
+
+//Signal processing task: long job.
+static void filter(void *ptr) {
+  work(8000);
+}
+
+//Protocol beacon task.
+static void beacon(void *ptr) {
+  work(500);
+}
+
+PROCESS_THREAD(periodic_test, ev, data) {
+  static struct etimer et;
+  struct periodic_task *task;
+  struct periodic_load load;
+
+  PROCESS_BEGIN();
+
+  periodic_init();
+  periodic_add(&sample_task, "sample", PERIODIC_US_TO_TICKS(10000), PERIODIC_US_TO_TICKS(2000), 0,
+               sample, NULL);
+  periodic_add(&filter_task, "filter", PERIODIC_US_TO_TICKS(50000), 0, 0, filter, NULL);
+  periodic_add(&beacon_task, "beacon", PERIODIC_US_TO_TICKS(100000), 0, 0, beacon, NULL);
+
+  etimer_set(&et, 2 * CLOCK_SECOND);
+
+  for (;;) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    //Print the statistics of every task and the processor load.
+    for (task = periodic_list(); task != NULL; task = task->next) {
+      printf("%s: %lu jobs, %lu missed, %lu skipped, response %lu/%lu us, exec max %lu us\n",
+             task->name, (unsigned long) task->stats.jobs, (unsigned long) task->stats.misses,
+             (unsigned long) task->stats.skipped,
+             (unsigned long) PERIODIC_TICKS_TO_US(task->stats.response_last),
+             (unsigned long) PERIODIC_TICKS_TO_US(task->stats.response_max),
+             (unsigned long) PERIODIC_TICKS_TO_US(task->stats.exec_max));
+    }
+    periodic_get_load(&load);
+    printf("load %u/1000, demand %u/1000, headroom %u/1000\n", load.measured, load.demand,
+           load.headroom);
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,218 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the power fail logger example.                                                 |
+//|                                                                                                |
+//| Logs a 32 byte record on every clock tick to a new LOGnnn.BIN file on the SD card, gathering   |
+//| them in RAM and writing 8KB at a time. A low voltage hook writes the records gathered so far   |
+//| when the supply starts failing, so none are lost to a power cut.                               |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "contiki.h"
+#include "sdcard.h"
+#include "fat.h"
+#include "lowvoltage.h"
+
+#define LOG_SIZE        (16ul * 1024 * 1024)
+#define BUFFER_BLOCKS   16
+#define BUFFER_SIZE     (BUFFER_BLOCKS * SDCARD_BLOCK_SIZE)
+
+//Worst case time of the flush (two buffers, 16KB), in microseconds. Cards take longer now and then,
+//while erasing, so the flush is sized for a good card.
+#define FLUSH_BUDGET    15000
+
+//Records are made up: a sequence number (from 1, so the zeroes left after the last one end the
+//log), the time they were taken and some counting values.
+struct record {
+  uint32_t sequence;
+  uint32_t time;
+  uint16_t values[12];
+};
+
+//Buffers of records, and the card blocks they go to. The logger fills one while writing the other
+//(the pending one), and only marks records as filled once they're complete.
+struct buffer {
+  uint32_t block;
+  volatile uint32_t filled;
+  uint32_t data[BUFFER_SIZE / 4];
+};
+
+static struct fat_device device = {sdcard_read, sdcard_write, 0, SDCARD_MAX_BLOCKS, 0};
+static struct fat fs;
+static struct fat_file file;
+static char name[] = "LOG000.BIN";
+
+static struct buffer buffers[2];
+static volatile uint8_t filling;
+static volatile int8_t pending = -1;
+
+//Set by the hook when it couldn't write the buffer being filled, for the logger to do it.
+static volatile uint8_t flush_queued;
+
+static void flush(void *ptr);
+static struct lowvoltage_hook hook = { NULL, flush, NULL, FLUSH_BUDGET, 0 };
+
+PROCESS(power_fail, "Power fail logger");
+
+AUTOSTART_PROCESSES(&power_fail);
+
+//Writes the blocks of a buffer that hold records.
+static int write_buffer(struct buffer *b) {
+  if (b->filled == 0)
+    return SDCARD_OK;
+
+  return sdcard_write(b->block, b->data, (b->filled + SDCARD_BLOCK_SIZE - 1) / SDCARD_BLOCK_SIZE);
+}
+
+//Low voltage hook. The logger may be writing the pending buffer, in which case the card driver
+//finishes that transfer first. If the logger was still setting it up, the card can't be used until
+//the hook returns, so the writes are left to the logger, which resumes right after.
+static void flush(void *ptr) {
+  if (pending >= 0 && write_buffer(&buffers[pending]) == SDCARD_ERR_BUSY) {
+    flush_queued = 1;
+    return;
+  }
+  if (write_buffer(&buffers[filling]) == SDCARD_ERR_BUSY)
+    flush_queued = 1;
+}
+
+//Prepares a buffer for the given file offset. Returns 0 on success.
+static int prepare(struct buffer *b, uint32_t offset) {
+  uint32_t count;
+
+  memset(b->data, 0, BUFFER_SIZE);
+  b->filled = 0;
+  if (fat_map(&file, offset, &b->block, &count) != FAT_OK || count < BUFFER_BLOCKS)
+    return -1;
+
+  return 0;
+}
+
+//Creates the first LOGnnn.BIN file that doesn't exist yet, with its whole size set, so the
+//directory needs no update while logging. Returns FAT_OK on success.
+static int create_log() {
+  uint16_t i;
+  int result;
+
+  for (i = 0; i < 1000; i++) {
+    name[3] = '0' + i / 100;
+    name[4] = '0' + i / 10 % 10;
+    name[5] = '0' + i % 10;
+
+    result = fat_open(&fs, &file, name);
+    if (result == FAT_ERR_NOT_FOUND)
+      break;
+    if (result != FAT_OK)
+      return result;
+    fat_close(&file);
+  }
+
+  result = fat_create(&fs, &file, name, LOG_SIZE);
+  if (result != FAT_OK)
+    return result;
+
+  //Map the whole file, then sync the size.
+  if (prepare(&buffers[0], LOG_SIZE - BUFFER_SIZE) != 0)
+    return FAT_ERR_FULL;
+  result = fat_set_size(&file, LOG_SIZE);
+  if (result == FAT_OK)
+    result = fat_sync(&file);
+
+  return result;
+}
+
+PROCESS_THREAD(power_fail, ev, data) {
+  static struct etimer et;
+  static struct record record;
+  static uint32_t offset;
+  struct buffer *b;
+  uint8_t i;
+  int result;
+
+  PROCESS_BEGIN();
+
+  result = sdcard_init();
+  if (result != SDCARD_OK) {
+    printf("No card (error %d)\n", result);
+    PROCESS_EXIT();
+  }
+
+  device.blocks = sdcard_blocks();
+  device.erase_blocks = sdcard_erase_blocks();
+  result = fat_mount(&fs, &device);
+  if (result == FAT_OK)
+    result = create_log();
+  if (result != FAT_OK || prepare(&buffers[0], 0) != 0) {
+    printf("Can't create the log (error %d)\n", result);
+    PROCESS_EXIT();
+  }
+
+  lowvoltage_init();
+  if (lowvoltage_register(&hook) != LOWVOLTAGE_OK) {
+    printf("Flush doesn't fit in the low voltage budget\n");
+    PROCESS_EXIT();
+  }
+
+  printf("Logging to %s\n", name);
+
+  etimer_set(&et, 1);
+  while (1) {
+    PROCESS_WAIT_EVENT();
+
+    if (ev == lowvoltage_event) {
+      if (lowvoltage_low())
+        printf("Supply low after %lu records, flushed in %lu us (%u hooks skipped)\n",
+               (unsigned long) record.sequence, (unsigned long) lowvoltage_flush_time(),
+               lowvoltage_skipped());
+      else
+        printf("Supply back\n");
+      continue;
+    }
+    if (!etimer_expired(&et))
+      continue;
+    etimer_reset(&et);
+
+    record.sequence++;
+    record.time = clock_time();
+    for (i = 0; i < sizeof(record.values) / sizeof(record.values[0]); i++)
+      record.values[i] = record.sequence + i;
+
+    b = &buffers[filling];
+    memcpy((uint8_t *) b->data + b->filled, &record, sizeof(record));
+    b->filled += sizeof(record);
+    if (b->filled < BUFFER_SIZE)
+      continue;
+
+    //Buffer full. Switch to the other one once it's ready, then write this one.
+    offset += BUFFER_SIZE;
+    if (offset < LOG_SIZE && prepare(&buffers[!filling], offset) != 0) {
+      printf("Map error\n");
+      break;
+    }
+    pending = filling;
+    if (offset < LOG_SIZE)
+      filling = !filling;
+
+    if (write_buffer(b) != SDCARD_OK)
+      printf("Write error\n");
+    pending = -1;
+
+    //Write the records the low voltage hook couldn't.
+    if (flush_queued) {
+      flush_queued = 0;
+      write_buffer(&buffers[filling]);
+    }
+
+    if (offset == LOG_SIZE) {
+      printf("Log full\n");
+      break;
+    }
+  }
+
+  lowvoltage_unregister(&hook);
+
+  PROCESS_END();
+}
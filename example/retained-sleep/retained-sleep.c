@@ -0,0 +1,62 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the retained sleep example.                                                    |
+//|                                                                                                |
+//| Counts boots in a retained variable and sleeps with the low power driver: a few times in a     |
+//| mode that resumes execution, then in VLLS2, which keeps only the retained section and wakes up |
+//| through reset.                                                                                 |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "lowpower.h"
+#include "mk66-startup.h"
+
+#define RESUME_SLEEPS   3
+#define RESUME_TIME     2000    //Milliseconds
+#define RETAIN_TIME     5000
+
+//Boots since power up, kept in the RAM2 partition through VLLS2. Ordinary variables start over.
+static uint32_t boots LOWPOWER_RETAINED;
+static uint32_t ordinary = 0x55AA55AA;
+
+PROCESS(retained_sleep, "Retained sleep");
+
+AUTOSTART_PROCESSES(&retained_sleep);
+
+PROCESS_THREAD(retained_sleep, ev, data) {
+  static struct etimer et;
+  static uint8_t i, mode;
+
+  PROCESS_BEGIN();
+
+  boots++;
+  printf("Boot %lu, retained section %s, ordinary variable 0x%08lX\n", (unsigned long) boots,
+         startup_retained() ? "kept" : "cleared", (unsigned long) ordinary);
+  ordinary = 0;
+
+  //Let the output out before each sleep, since the UART stops along with the clocks.
+  mode = lowpower_select(LOWPOWER_KEEP_RUNNING);
+  for (i = 0; i < RESUME_SLEEPS; i++) {
+    printf("Sleeping in %s for %u ms\n", mode == LOWPOWER_LLS2 ? "LLS2" : "LLS3", RESUME_TIME);
+    etimer_set(&et, CLOCK_SECOND / 16);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    if (lowpower_sleep(mode, RESUME_TIME) != LOWPOWER_OK)
+      printf("Sleep aborted\n");
+    else
+      printf("Woken up\n");
+  }
+
+  mode = lowpower_select(LOWPOWER_KEEP_RETAINED);
+  printf("Sleeping in %s for %u ms\n", mode == LOWPOWER_VLLS2 ? "VLLS2" : "VLLS1", RETAIN_TIME);
+  etimer_set(&et, CLOCK_SECOND / 16);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  lowpower_sleep(mode, RETAIN_TIME);
+
+  //Only reached if the mode couldn't be entered. Otherwise the board boots again.
+  printf("Sleep aborted\n");
+
+  PROCESS_END();
+}
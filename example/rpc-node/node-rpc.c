@@ -0,0 +1,23 @@
+//+------------------------------------------------------------------------------------------------+
+//| Method table of the node service, generated by rpcgen.py from node.rpc.                        |
+//|                                                                                                |
+//| Do not edit: changes belong in the schema.                                                     |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stddef.h>
+
+#include "rpc.h"
+#include "node-rpc.h"
+
+static const struct rpc_method methods[] = {
+  { node_ping, NODE_PING_RESPONSE_SIZE },
+  { node_get_stats, NODE_GET_STATS_RESPONSE_SIZE },
+  { node_set_led, NODE_SET_LED_RESPONSE_SIZE },
+  { node_set_blink, NODE_SET_BLINK_RESPONSE_SIZE },
+  { node_reverse, NODE_REVERSE_RESPONSE_SIZE },
+  { node_calibrate, NODE_CALIBRATE_RESPONSE_SIZE },
+};
+
+void node_rpc_init() {
+  rpc_init(methods, sizeof(methods) / sizeof(methods[0]));
+}
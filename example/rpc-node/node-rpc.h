@@ -0,0 +1,211 @@
+//+------------------------------------------------------------------------------------------------+
+//| Protocol code for the node service, generated by rpcgen.py from node.rpc.                      |
+//|                                                                                                |
+//| Do not edit: changes belong in the schema.                                                     |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef NODE_RPC_H_
+#define NODE_RPC_H_
+
+#include <stdint.h>
+
+#include "rpc-msg.h"
+
+//Method numbers.
+#define NODE_PING 0
+#define NODE_GET_STATS 1
+#define NODE_SET_LED 2
+#define NODE_SET_BLINK 3
+#define NODE_REVERSE 4
+#define NODE_CALIBRATE 5
+
+//+------------------------------------------------------------------------------------------------+
+//| Method 0: ping.                                                                                |
+//+------------------------------------------------------------------------------------------------+
+
+#define NODE_PING_REQUEST_SIZE 4
+#define NODE_PING_RESPONSE_SIZE 8
+
+static inline uint32_t node_ping_request_get_token(const struct rpc_msg *m) {
+  return rpc_get_u32(m, 0);
+}
+
+static inline void node_ping_request_set_token(struct rpc_msg *m, uint32_t value) {
+  rpc_put_u32(m, 0, value);
+}
+
+static inline uint32_t node_ping_response_get_token(const struct rpc_msg *m) {
+  return rpc_get_u32(m, 0);
+}
+
+static inline void node_ping_response_set_token(struct rpc_msg *m, uint32_t value) {
+  rpc_put_u32(m, 0, value);
+}
+
+static inline uint32_t node_ping_response_get_uptime_ms(const struct rpc_msg *m) {
+  return rpc_get_u32(m, 4);
+}
+
+static inline void node_ping_response_set_uptime_ms(struct rpc_msg *m, uint32_t value) {
+  rpc_put_u32(m, 4, value);
+}
+
+//+------------------------------------------------------------------------------------------------+
+//| Method 1: get_stats.                                                                           |
+//+------------------------------------------------------------------------------------------------+
+
+#define NODE_GET_STATS_REQUEST_SIZE 0
+#define NODE_GET_STATS_RESPONSE_SIZE 12
+
+static inline uint32_t node_get_stats_response_get_calls(const struct rpc_msg *m) {
+  return rpc_get_u32(m, 0);
+}
+
+static inline void node_get_stats_response_set_calls(struct rpc_msg *m, uint32_t value) {
+  rpc_put_u32(m, 0, value);
+}
+
+static inline uint32_t node_get_stats_response_get_crc_errors(const struct rpc_msg *m) {
+  return rpc_get_u32(m, 4);
+}
+
+static inline void node_get_stats_response_set_crc_errors(struct rpc_msg *m, uint32_t value) {
+  rpc_put_u32(m, 4, value);
+}
+
+static inline uint32_t node_get_stats_response_get_skipped(const struct rpc_msg *m) {
+  return rpc_get_u32(m, 8);
+}
+
+static inline void node_get_stats_response_set_skipped(struct rpc_msg *m, uint32_t value) {
+  rpc_put_u32(m, 8, value);
+}
+
+//+------------------------------------------------------------------------------------------------+
+//| Method 2: set_led.                                                                             |
+//+------------------------------------------------------------------------------------------------+
+
+#define NODE_SET_LED_REQUEST_SIZE 1
+#define NODE_SET_LED_RESPONSE_SIZE 1
+
+static inline uint8_t node_set_led_request_get_on(const struct rpc_msg *m) {
+  return rpc_get_u8(m, 0);
+}
+
+static inline void node_set_led_request_set_on(struct rpc_msg *m, uint8_t value) {
+  rpc_put_u8(m, 0, value);
+}
+
+static inline uint8_t node_set_led_response_get_was_on(const struct rpc_msg *m) {
+  return rpc_get_u8(m, 0);
+}
+
+static inline void node_set_led_response_set_was_on(struct rpc_msg *m, uint8_t value) {
+  rpc_put_u8(m, 0, value);
+}
+
+//+------------------------------------------------------------------------------------------------+
+//| Method 3: set_blink.                                                                           |
+//+------------------------------------------------------------------------------------------------+
+
+#define NODE_SET_BLINK_REQUEST_SIZE 2
+#define NODE_SET_BLINK_RESPONSE_SIZE 0
+
+static inline uint16_t node_set_blink_request_get_period_ms(const struct rpc_msg *m) {
+  return rpc_get_u16(m, 0);
+}
+
+static inline void node_set_blink_request_set_period_ms(struct rpc_msg *m, uint16_t value) {
+  rpc_put_u16(m, 0, value);
+}
+
+//+------------------------------------------------------------------------------------------------+
+//| Method 4: reverse.                                                                             |
+//+------------------------------------------------------------------------------------------------+
+
+#define NODE_REVERSE_REQUEST_SIZE 64
+#define NODE_REVERSE_RESPONSE_SIZE 64
+
+static inline uint8_t node_reverse_request_get_data(const struct rpc_msg *m, uint8_t i) {
+  return rpc_get_u8(m, i);
+}
+
+static inline void node_reverse_request_set_data(struct rpc_msg *m, uint8_t i, uint8_t value) {
+  rpc_put_u8(m, i, value);
+}
+
+static inline void node_reverse_request_read_data(const struct rpc_msg *m, void *data) {
+  rpc_read(m, 0, data, 64);
+}
+
+static inline void node_reverse_request_write_data(struct rpc_msg *m, const void *data) {
+  rpc_write(m, 0, data, 64);
+}
+
+static inline uint8_t node_reverse_response_get_data(const struct rpc_msg *m, uint8_t i) {
+  return rpc_get_u8(m, i);
+}
+
+static inline void node_reverse_response_set_data(struct rpc_msg *m, uint8_t i, uint8_t value) {
+  rpc_put_u8(m, i, value);
+}
+
+static inline void node_reverse_response_read_data(const struct rpc_msg *m, void *data) {
+  rpc_read(m, 0, data, 64);
+}
+
+static inline void node_reverse_response_write_data(struct rpc_msg *m, const void *data) {
+  rpc_write(m, 0, data, 64);
+}
+
+//+------------------------------------------------------------------------------------------------+
+//| Method 5: calibrate.                                                                           |
+//+------------------------------------------------------------------------------------------------+
+
+#define NODE_CALIBRATE_REQUEST_SIZE 12
+#define NODE_CALIBRATE_RESPONSE_SIZE 4
+
+static inline int32_t node_calibrate_request_get_raw(const struct rpc_msg *m) {
+  return (int32_t) rpc_get_u32(m, 0);
+}
+
+static inline void node_calibrate_request_set_raw(struct rpc_msg *m, int32_t value) {
+  rpc_put_u32(m, 0, value);
+}
+
+static inline float node_calibrate_request_get_gain(const struct rpc_msg *m) {
+  return rpc_get_f32(m, 4);
+}
+
+static inline void node_calibrate_request_set_gain(struct rpc_msg *m, float value) {
+  rpc_put_f32(m, 4, value);
+}
+
+static inline float node_calibrate_request_get_offset(const struct rpc_msg *m) {
+  return rpc_get_f32(m, 8);
+}
+
+static inline void node_calibrate_request_set_offset(struct rpc_msg *m, float value) {
+  rpc_put_f32(m, 8, value);
+}
+
+static inline float node_calibrate_response_get_value(const struct rpc_msg *m) {
+  return rpc_get_f32(m, 0);
+}
+
+static inline void node_calibrate_response_set_value(struct rpc_msg *m, float value) {
+  rpc_put_f32(m, 0, value);
+}
+
+//Handlers, implemented by the application. They return the response status.
+uint8_t node_ping(const struct rpc_msg *request, struct rpc_msg *response);
+uint8_t node_get_stats(const struct rpc_msg *request, struct rpc_msg *response);
+uint8_t node_set_led(const struct rpc_msg *request, struct rpc_msg *response);
+uint8_t node_set_blink(const struct rpc_msg *request, struct rpc_msg *response);
+uint8_t node_reverse(const struct rpc_msg *request, struct rpc_msg *response);
+uint8_t node_calibrate(const struct rpc_msg *request, struct rpc_msg *response);
+
+//Starts serving the methods above.
+void node_rpc_init();
+
+#endif //NODE_RPC_H_
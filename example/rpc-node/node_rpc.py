@@ -0,0 +1,71 @@
+#+-------------------------------------------------------------------------------------------------+
+#| Client for the node service, generated by rpcgen.py from node.rpc.                              |
+#|                                                                                                 |
+#| Do not edit: changes belong in the schema.                                                      |
+#+-------------------------------------------------------------------------------------------------+
+
+import collections
+
+import rpc_client
+
+#Method numbers.
+NODE_PING = 0
+NODE_GET_STATS = 1
+NODE_SET_LED = 2
+NODE_SET_BLINK = 3
+NODE_REVERSE = 4
+NODE_CALIBRATE = 5
+
+PING_REQUEST = rpc_client.Layout([('token', 'I', 0)])
+PING_RESPONSE = rpc_client.Layout([('token', 'I', 0), ('uptime_ms', 'I', 0)])
+PingResponse = collections.namedtuple('PingResponse', ['token', 'uptime_ms'])
+
+GET_STATS_REQUEST = rpc_client.Layout([])
+GET_STATS_RESPONSE = rpc_client.Layout([
+    ('calls', 'I', 0),
+    ('crc_errors', 'I', 0),
+    ('skipped', 'I', 0),
+])
+GetStatsResponse = collections.namedtuple('GetStatsResponse', ['calls', 'crc_errors', 'skipped'])
+
+SET_LED_REQUEST = rpc_client.Layout([('on', 'B', 0)])
+SET_LED_RESPONSE = rpc_client.Layout([('was_on', 'B', 0)])
+SetLedResponse = collections.namedtuple('SetLedResponse', ['was_on'])
+
+SET_BLINK_REQUEST = rpc_client.Layout([('period_ms', 'H', 0)])
+SET_BLINK_RESPONSE = rpc_client.Layout([])
+SetBlinkResponse = collections.namedtuple('SetBlinkResponse', [])
+
+REVERSE_REQUEST = rpc_client.Layout([('data', 'B', 64)])
+REVERSE_RESPONSE = rpc_client.Layout([('data', 'B', 64)])
+ReverseResponse = collections.namedtuple('ReverseResponse', ['data'])
+
+CALIBRATE_REQUEST = rpc_client.Layout([('raw', 'i', 0), ('gain', 'f', 0), ('offset', 'f', 0)])
+CALIBRATE_RESPONSE = rpc_client.Layout([('value', 'f', 0)])
+CalibrateResponse = collections.namedtuple('CalibrateResponse', ['value'])
+
+
+class Node(rpc_client.RpcClient):
+    def ping(self, token):
+        payload = self.call(NODE_PING, PING_REQUEST.pack(token))
+        return PingResponse._make(PING_RESPONSE.unpack(payload))
+
+    def get_stats(self):
+        payload = self.call(NODE_GET_STATS, GET_STATS_REQUEST.pack())
+        return GetStatsResponse._make(GET_STATS_RESPONSE.unpack(payload))
+
+    def set_led(self, on):
+        payload = self.call(NODE_SET_LED, SET_LED_REQUEST.pack(on))
+        return SetLedResponse._make(SET_LED_RESPONSE.unpack(payload))
+
+    def set_blink(self, period_ms):
+        payload = self.call(NODE_SET_BLINK, SET_BLINK_REQUEST.pack(period_ms))
+        return SetBlinkResponse._make(SET_BLINK_RESPONSE.unpack(payload))
+
+    def reverse(self, data):
+        payload = self.call(NODE_REVERSE, REVERSE_REQUEST.pack(data))
+        return ReverseResponse._make(REVERSE_RESPONSE.unpack(payload))
+
+    def calibrate(self, raw, gain, offset):
+        payload = self.call(NODE_CALIBRATE, CALIBRATE_REQUEST.pack(raw, gain, offset))
+        return CalibrateResponse._make(CALIBRATE_RESPONSE.unpack(payload))
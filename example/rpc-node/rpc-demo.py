@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+#+-------------------------------------------------------------------------------------------------+
+#| Host demo for the RPC example.                                                                  |
+#|                                                                                                 |
+#| Calls every method of the node service, then measures the round trip latency of ping and the    |
+#| throughput of reverse. Without a port, runs against a loopback that implements the service in   |
+#| Python, to check the host side without a board.                                                 |
+#|                                                                                                 |
+#| Usage: rpc-demo.py [serial port [baud rate]]                                                    |
+#|                                                                                                 |
+#| Author: Joksan Alvarado.                                                                        |
+#+-------------------------------------------------------------------------------------------------+
+
+import os
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'apps',
+                                'rpc'))
+
+import rpc_client
+import node_rpc
+
+CALLS = 1000
+
+
+def loopback():
+    """Simulates the example firmware."""
+    state = {'led': 0}
+    start = time.monotonic()
+
+    def ping(payload):
+        token, = node_rpc.PING_REQUEST.unpack(payload)
+        uptime = int((time.monotonic() - start) * 1000)
+        return 0, node_rpc.PING_RESPONSE.pack(token, uptime)
+
+    def get_stats(payload):
+        return 0, node_rpc.GET_STATS_RESPONSE.pack(0, 0, 0)
+
+    def set_led(payload):
+        on, = node_rpc.SET_LED_REQUEST.unpack(payload)
+        was_on, state['led'] = state['led'], 1 if on else 0
+        return 0, node_rpc.SET_LED_RESPONSE.pack(was_on)
+
+    def set_blink(payload):
+        period, = node_rpc.SET_BLINK_REQUEST.unpack(payload)
+        return (rpc_client.STATUS_USER if period != 0 and not 10 <= period <= 10000 else 0), b''
+
+    def reverse(payload):
+        data, = node_rpc.REVERSE_REQUEST.unpack(payload)
+        return 0, node_rpc.REVERSE_RESPONSE.pack(data[::-1])
+
+    def calibrate(payload):
+        raw, gain, offset = node_rpc.CALIBRATE_REQUEST.unpack(payload)
+        return 0, node_rpc.CALIBRATE_RESPONSE.pack(raw * gain + offset)
+
+    return rpc_client.Loopback({
+        node_rpc.NODE_PING: ping,
+        node_rpc.NODE_GET_STATS: get_stats,
+        node_rpc.NODE_SET_LED: set_led,
+        node_rpc.NODE_SET_BLINK: set_blink,
+        node_rpc.NODE_REVERSE: reverse,
+        node_rpc.NODE_CALIBRATE: calibrate,
+    })
+
+
+def check(name, condition):
+    print('%-10s %s' % (name + ':', 'OK' if condition else 'FAILED'))
+    return condition
+
+
+def main():
+    if len(sys.argv) > 1:
+        baud = int(sys.argv[2]) if len(sys.argv) > 2 else 1000000
+        node = node_rpc.Node(sys.argv[1], baud)
+    else:
+        print('No port given, using the loopback')
+        node = node_rpc.Node(loopback())
+
+    ok = True
+    with node:
+        ok &= check('Ping', node.ping(0x12345678).token == 0x12345678)
+        node.set_led(1)
+        ok &= check('LED', node.set_led(0).was_on == 1)
+        data = bytes(range(64))
+        ok &= check('Reverse', node.reverse(data).data == data[::-1])
+        ok &= check('Calibrate', abs(node.calibrate(-100, 0.5, 3.0).value + 47.0) < 1e-6)
+        try:
+            node.set_blink(5)
+            ok &= check('Errors', False)
+        except rpc_client.RpcError as e:
+            ok &= check('Errors', e.status == rpc_client.STATUS_USER)
+        node.set_blink(250)
+
+        #Round trip latency.
+        worst = 0
+        start = time.monotonic()
+        for i in range(CALLS):
+            t = time.monotonic()
+            node.ping(i)
+            worst = max(worst, time.monotonic() - t)
+        elapsed = time.monotonic() - start
+        print('Latency:   %.0f us average, %.0f us worst' % (elapsed / CALLS * 1e6, worst * 1e6))
+
+        #Payload throughput (both ways).
+        start = time.monotonic()
+        for i in range(CALLS):
+            node.reverse(data)
+        elapsed = time.monotonic() - start
+        print('Reverse:   %.1f KB/s each way' % (CALLS * len(data) / elapsed / 1024))
+
+        stats = node.get_stats()
+        print('Stats:     %u calls, %u CRC errors, %u bytes skipped' %
+              (stats.calls, stats.crc_errors, stats.skipped))
+
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == '__main__':
+    main()
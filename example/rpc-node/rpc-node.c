@@ -0,0 +1,120 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the RPC example.                                                               |
+//|                                                                                                |
+//| Implements the methods of node.rpc. The accessors and the method table come from node-rpc.h    |
+//| and node-rpc.c, generated from the schema by rpcgen.py.                                        |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "rpc.h"
+#include "node-rpc.h"
+
+#include "mk66-port.h"
+#include "mk66-gpio.h"
+
+//LED on pin 13 (PTC5).
+#define LED_PIN 5
+
+//Status returned by set_blink on invalid periods.
+#define STATUS_RANGE RPC_STATUS_USER
+
+static uint16_t blink_period;
+
+PROCESS(rpc_node, "RPC node");
+
+AUTOSTART_PROCESSES(&rpc_node);
+
+static int led_on() {
+  return (GPIOC->PDOR & (1 << LED_PIN)) != 0;
+}
+
+uint8_t node_ping(const struct rpc_msg *request, struct rpc_msg *response) {
+  node_ping_response_set_token(response, node_ping_request_get_token(request));
+  node_ping_response_set_uptime_ms(response, clock_time() * 1000 / CLOCK_SECOND);
+  return RPC_STATUS_OK;
+}
+
+uint8_t node_get_stats(const struct rpc_msg *request, struct rpc_msg *response) {
+  const struct rpc_stats *stats = rpc_stats();
+
+  node_get_stats_response_set_calls(response, stats->calls);
+  node_get_stats_response_set_crc_errors(response, stats->crc_errors);
+  node_get_stats_response_set_skipped(response, stats->skipped);
+  return RPC_STATUS_OK;
+}
+
+uint8_t node_set_led(const struct rpc_msg *request, struct rpc_msg *response) {
+  node_set_led_response_set_was_on(response, led_on());
+
+  if (node_set_led_request_get_on(request))
+    GPIOC->PSOR = 1 << LED_PIN;
+  else
+    GPIOC->PCOR = 1 << LED_PIN;
+
+  return RPC_STATUS_OK;
+}
+
+uint8_t node_set_blink(const struct rpc_msg *request, struct rpc_msg *response) {
+  uint16_t period = node_set_blink_request_get_period_ms(request);
+
+  if (period != 0 && (period < 10 || period > 10000))
+    return STATUS_RANGE;
+
+  blink_period = period;
+  process_poll(&rpc_node);
+  return RPC_STATUS_OK;
+}
+
+uint8_t node_reverse(const struct rpc_msg *request, struct rpc_msg *response) {
+  uint8_t i;
+
+  for (i = 0; i < 64; i++)
+    node_reverse_response_set_data(response, i, node_reverse_request_get_data(request, 63 - i));
+
+  return RPC_STATUS_OK;
+}
+
+uint8_t node_calibrate(const struct rpc_msg *request, struct rpc_msg *response) {
+  float value = node_calibrate_request_get_raw(request) * node_calibrate_request_get_gain(request) +
+                node_calibrate_request_get_offset(request);
+
+  node_calibrate_response_set_value(response, value);
+  return RPC_STATUS_OK;
+}
+
+//Serves the methods and blinks the LED when asked to.
+PROCESS_THREAD(rpc_node, ev, data) {
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  PORTC->PCR[LED_PIN] = PORT_PCR_MUX_Gpio;
+  GPIOC->PDDR |= 1 << LED_PIN;
+
+  node_rpc_init();
+  printf("RPC node ready\n");
+
+  while (1) {
+    PROCESS_WAIT_EVENT();
+
+    //A new period was set. Restart the timer from now.
+    if (ev == PROCESS_EVENT_POLL) {
+      if (blink_period != 0)
+        etimer_set(&et, (blink_period * CLOCK_SECOND + 500) / 1000);
+      else
+        etimer_stop(&et);
+      continue;
+    }
+
+    if (ev == PROCESS_EVENT_TIMER && etimer_expired(&et) && blink_period != 0) {
+      GPIOC->PTOR = 1 << LED_PIN;
+      etimer_reset(&et);
+    }
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,633 @@
+//+------------------------------------------------------------------------------------------------+
+//| Host test and benchmark for the FAT32 file system.                                             |
+//|                                                                                                |
+//| Usage: fat-check [test]                                                                        |
+//|        fat-check bench                                                                         |
+//|                                                                                                |
+//| The file system runs on RAM images formatted here (a partitioned card and a whole device       |
+//| volume, with different cluster sizes). The test mode writes logs with records of random sizes  |
+//| from aligned and unaligned buffers, past their pre-allocated size and interleaved with other   |
+//| files (so their chains fragment), fills the root directory past its first cluster, removes     |
+//| files, appends to them and writes them through fat_map(). Every file is read back through the  |
+//| library and through an independent checker, which also verifies the volume as a PC would       |
+//| (chains matching sizes, no cross linked or lost clusters, identical FAT copies, FSInfo free    |
+//| count). Writes to pre-allocated files must do no I/O but their data, in transfers within the   |
+//| device limit and the erase units. The bench mode compares the transfers per MB logged and the  |
+//| worst write call against single block writes.                                                  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fat.h"
+
+#define IMAGE_BLOCKS    131072    //64MB
+#define PARTITION_START 8192
+#define ERASE_BLOCKS    1024      //512KB erase units
+#define MAX_BLOCKS      128
+#define RESERVED        32
+
+#define LOG_SIZE        (4 * 1024 * 1024)
+#define LOG_WRITTEN     (6 * 1024 * 1024)
+#define RECORD_MAX      8192
+
+//Transfers of a range of calls: count, blocks, and the ones outside of the data area.
+struct transfers {
+  uint32_t reads;
+  uint32_t writes;
+  uint32_t blocks;
+  uint32_t largest;
+  uint32_t metadata;
+};
+
+//Volume layout, as formatted.
+struct layout {
+  uint32_t volume;
+  uint32_t fat_start;
+  uint32_t fat_blocks;
+  uint32_t data_start;
+  uint32_t clusters;
+  uint8_t cluster_blocks;
+};
+
+static uint8_t *image;
+static struct layout layout;
+static struct transfers io;
+static struct fat_device device = {NULL, NULL, IMAGE_BLOCKS, MAX_BLOCKS, ERASE_BLOCKS};
+static struct fat fs;
+static struct fat_file file, other;
+static uint32_t record[RECORD_MAX / 4 + 2];
+static uint32_t rng_state = 1;
+static int failures;
+
+static uint32_t rng() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static void fail(const char *what, int32_t detail) {
+  if (failures++ < 10)
+    fprintf(stderr, "FAILED: %s (%d)\n", what, detail);
+}
+
+//Contents of the test files: a pattern of the file offset, different for each file.
+static uint8_t pattern(uint32_t seed, uint32_t offset) {
+  uint32_t x = (offset / 4 + 1) * 2654435761u + seed * 40503;
+
+  return (x ^ (x >> 15)) >> (offset % 4 * 8);
+}
+
+static void fill(uint8_t *data, uint32_t seed, uint32_t offset, uint32_t length) {
+  uint32_t i;
+
+  for (i = 0; i < length; i++)
+    data[i] = pattern(seed, offset + i);
+}
+
+static uint8_t matches(const uint8_t *data, uint32_t seed, uint32_t offset, uint32_t length) {
+  uint32_t i;
+
+  for (i = 0; i < length; i++) {
+    if (data[i] != pattern(seed, offset + i))
+      return 0;
+  }
+
+  return 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+//RAM device.
+
+static void count_transfer(uint32_t block, uint16_t count, uint8_t write) {
+  if (write) {
+    io.writes++;
+    io.blocks += count;
+    if (count > io.largest)
+      io.largest = count;
+  }
+  else
+    io.reads++;
+
+  if (block < layout.data_start)
+    io.metadata++;
+
+  if (count > MAX_BLOCKS || (block % ERASE_BLOCKS + count > ERASE_BLOCKS && write))
+    fail("transfer limits", block);
+}
+
+static int ram_read(uint32_t block, void *buffer, uint16_t count) {
+  if ((uintptr_t) buffer & 3 || block + count > IMAGE_BLOCKS)
+    return -1;
+
+  count_transfer(block, count, 0);
+  memcpy(buffer, image + block * FAT_BLOCK_SIZE, count * FAT_BLOCK_SIZE);
+  return 0;
+}
+
+static int ram_write(uint32_t block, const void *buffer, uint16_t count) {
+  if ((uintptr_t) buffer & 3 || block + count > IMAGE_BLOCKS)
+    return -1;
+
+  count_transfer(block, count, 1);
+  memcpy(image + block * FAT_BLOCK_SIZE, buffer, count * FAT_BLOCK_SIZE);
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Formatting and checking, as a PC would.
+
+static void put16(uint8_t *p, uint16_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t value) {
+  put16(p, value);
+  put16(p + 2, value >> 16);
+}
+
+static uint16_t get16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return get16(p) | ((uint32_t) get16(p + 2) << 16);
+}
+
+static uint8_t *block_at(uint32_t block) {
+  return image + block * FAT_BLOCK_SIZE;
+}
+
+static uint32_t fat_entry(uint8_t copy, uint32_t cluster) {
+  return get32(block_at(layout.fat_start + copy * layout.fat_blocks) + cluster * 4) & 0x0FFFFFFF;
+}
+
+static uint8_t *cluster_at(uint32_t cluster) {
+  return block_at(layout.data_start + (cluster - 2) * layout.cluster_blocks);
+}
+
+//Formats the image with a FAT32 volume, in a partition starting at an erase unit boundary or on
+//the whole device, with its data area aligned to the erase units.
+static void format(uint8_t partitioned, uint8_t cluster_blocks) {
+  uint32_t total, reserved, fat_blocks = 1, clusters;
+  uint8_t *b;
+
+  memset(image, 0, (size_t) IMAGE_BLOCKS * FAT_BLOCK_SIZE);
+  layout.volume = partitioned ? PARTITION_START : 0;
+  layout.cluster_blocks = cluster_blocks;
+  total = IMAGE_BLOCKS - layout.volume;
+
+  //Size the FATs for the clusters left after them.
+  while (((total - RESERVED - 2 * fat_blocks) / cluster_blocks + 2) * 4 >
+         fat_blocks * FAT_BLOCK_SIZE)
+    fat_blocks++;
+
+  reserved = RESERVED + (ERASE_BLOCKS - (layout.volume + RESERVED + 2 * fat_blocks) % ERASE_BLOCKS);
+  clusters = (total - reserved - 2 * fat_blocks) / cluster_blocks;
+  layout.fat_start = layout.volume + reserved;
+  layout.fat_blocks = fat_blocks;
+  layout.data_start = layout.fat_start + 2 * fat_blocks;
+  layout.clusters = clusters;
+
+  if (partitioned) {
+    b = block_at(0);
+    b[446 + 4] = 0x0C;
+    put32(b + 446 + 8, PARTITION_START);
+    put32(b + 446 + 12, total);
+    put16(b + 510, 0xAA55);
+  }
+
+  b = block_at(layout.volume);
+  memcpy(b, "\xEB\x58\x90MSDOS5.0", 11);
+  put16(b + 11, FAT_BLOCK_SIZE);
+  b[13] = cluster_blocks;
+  put16(b + 14, reserved);
+  b[16] = 2;
+  b[21] = 0xF8;
+  put32(b + 28, layout.volume);
+  put32(b + 32, total);
+  put32(b + 36, fat_blocks);
+  put32(b + 44, 2);
+  put16(b + 48, 1);
+  put16(b + 50, 6);
+  b[66] = 0x29;
+  memcpy(b + 71, "NO NAME    FAT32   ", 19);
+  put16(b + 510, 0xAA55);
+
+  b = block_at(layout.volume + 1);
+  put32(b, 0x41615252);
+  put32(b + 484, 0x61417272);
+  put32(b + 488, clusters - 1);
+  put32(b + 492, 3);
+  put32(b + 508, 0xAA550000);
+
+  for (total = 0; total < 2; total++) {
+    b = block_at(layout.fat_start + total * fat_blocks);
+    put32(b, 0x0FFFFFF8);
+    put32(b + 4, 0x0FFFFFFF);
+    put32(b + 8, 0x0FFFFFFF);
+  }
+}
+
+//Follows a chain, marking its clusters. Returns its length, or 0 if broken or cross linked.
+static uint32_t follow(uint32_t cluster, uint8_t *used) {
+  uint32_t length = 0;
+
+  while (cluster < 0x0FFFFFF8) {
+    if (cluster < 2 || cluster >= layout.clusters + 2 || used[cluster])
+      return 0;
+
+    used[cluster] = 1;
+    length++;
+    cluster = fat_entry(0, cluster);
+  }
+
+  return length;
+}
+
+//Checks the volume, and the contents of the files whose names start with a letter and a digit
+//(written with the pattern of that digit). Lost clusters are tolerated if asked (after a reset).
+//Returns the number of files.
+static uint32_t check_volume(uint8_t lost_allowed) {
+  uint8_t *used = calloc(layout.clusters + 2, 1);
+  uint32_t files = 0, cluster = 2, first, size, length, free_count = 0, lost = 0, i, j;
+  uint8_t *entry, *data;
+
+  for (i = 0; i < layout.fat_blocks * FAT_BLOCK_SIZE; i++) {
+    if (block_at(layout.fat_start)[i] != block_at(layout.fat_start + layout.fat_blocks)[i]) {
+      fail("FAT copies differ", i);
+      break;
+    }
+  }
+
+  if (follow(2, used) == 0)
+    fail("root directory chain", 0);
+
+  //Walk the root directory.
+  for (cluster = 2; cluster < 0x0FFFFFF8; cluster = fat_entry(0, cluster)) {
+    for (i = 0; i < layout.cluster_blocks * FAT_BLOCK_SIZE; i += 32) {
+      entry = cluster_at(cluster) + i;
+      if (entry[0] == 0x00)
+        break;
+      if (entry[0] == 0xE5 || entry[11] & 0x18)
+        continue;
+
+      first = (get16(entry + 20) << 16) | get16(entry + 26);
+      size = get32(entry + 28);
+      length = first ? follow(first, used) : 0;
+      if (length != (size + layout.cluster_blocks * FAT_BLOCK_SIZE - 1) /
+                    (layout.cluster_blocks * FAT_BLOCK_SIZE) &&
+          !(lost_allowed && length > 0 &&
+            length * layout.cluster_blocks * FAT_BLOCK_SIZE >= size)) {
+        fail("chain length", files);
+        continue;
+      }
+
+      //Check the contents along the chain.
+      if (entry[0] >= 'A' && entry[0] <= 'Z' && entry[1] >= '0' && entry[1] <= '9') {
+        for (j = 0, data = NULL; j < size; j++) {
+          if (j % (layout.cluster_blocks * FAT_BLOCK_SIZE) == 0) {
+            data = cluster_at(first);
+            first = fat_entry(0, first);
+          }
+          if (data[j % (layout.cluster_blocks * FAT_BLOCK_SIZE)] != pattern(entry[1] - '0', j)) {
+            fail("file contents", files);
+            break;
+          }
+        }
+      }
+      files++;
+    }
+    if (i < layout.cluster_blocks * FAT_BLOCK_SIZE)
+      break;
+  }
+
+  for (i = 2; i < layout.clusters + 2; i++) {
+    if (fat_entry(0, i) == 0)
+      free_count++;
+    else if (!used[i])
+      lost++;
+  }
+
+  if (lost > 0 && !lost_allowed)
+    fail("lost clusters", lost);
+  if (get32(block_at(layout.volume + 1) + 488) != free_count)
+    fail("free count", free_count);
+
+  free(used);
+  return files;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Tests.
+
+static void mount(const char *what) {
+  int result = fat_mount(&fs, &device);
+
+  if (result != FAT_OK)
+    fail(what, result);
+}
+
+//Writes a log with records of random sizes, then reads it back.
+static void test_log(uint8_t partitioned, uint8_t cluster_blocks) {
+  uint32_t written = 0, length, offset, clusters, worst = 0, i;
+  uint8_t *src;
+  int32_t result;
+  int before = failures;
+
+  format(partitioned, cluster_blocks);
+  mount("mount");
+
+  if (fat_create(&fs, &file, "L1.BIN", LOG_SIZE) != FAT_OK ||
+      fat_create(&fs, &other, "M2.BIN", 0) != FAT_OK) {
+    fail("create", 0);
+    return;
+  }
+
+  //The log starts at an erase unit boundary.
+  if ((layout.data_start + (file.first - 2) * cluster_blocks) % ERASE_BLOCKS != 0)
+    fail("log alignment", file.first);
+
+  clusters = LOG_SIZE / (cluster_blocks * FAT_BLOCK_SIZE);
+  for (i = 0; written < LOG_WRITTEN; i++) {
+    length = 1 + rng() % RECORD_MAX;
+    if (rng() % 4 == 0)
+      length = (1 + rng() % 5) * FAT_BLOCK_SIZE;
+    if (length > LOG_WRITTEN - written)
+      length = LOG_WRITTEN - written;
+
+    src = (uint8_t *) record + (rng() % 2 ? 0 : 1 + rng() % 3);
+    fill(src, 1, written, length);
+
+    memset(&io, 0, sizeof(io));
+    if (fat_write(&file, src, length) != FAT_OK)
+      fail("write", i);
+
+    //Within the pre-allocated size, only data is written.
+    if (written + length <= clusters * cluster_blocks * FAT_BLOCK_SIZE) {
+      if (io.reads > 0 || io.metadata > 0)
+        fail("metadata I/O while writing", i);
+      if (io.writes > worst)
+        worst = io.writes;
+    }
+    written += length;
+
+    //Another file grows at the same time, past its first cluster, fragmenting both.
+    if (i % 16 == 0) {
+      fill((uint8_t *) record, 2, other.size, 700);
+      if (fat_write(&other, record, 700) != FAT_OK)
+        fail("other write", i);
+    }
+
+    if (i % 500 == 0 && fat_sync(&file) != FAT_OK)
+      fail("sync", i);
+  }
+
+  if (fat_close(&file) != FAT_OK || fat_close(&other) != FAT_OK)
+    fail("close", 0);
+  if (check_volume(0) != 2)
+    fail("files", 0);
+
+  //Read back with random sizes and alignments, after remounting.
+  mount("remount");
+  if (fat_open(&fs, &file, "l1.bin") != FAT_OK)
+    fail("open", 0);
+  for (offset = 0; offset < written; offset += result) {
+    length = 1 + rng() % (sizeof(record) - 4);
+    if (rng() % 4 == 0)
+      length = (1 + rng() % 5) * FAT_BLOCK_SIZE;
+    src = (uint8_t *) record + (rng() % 2 ? 0 : 1 + rng() % 3);
+    result = fat_read(&file, src, length);
+    if (result <= 0 || !matches(src, 1, offset, result)) {
+      fail("read", offset);
+      break;
+    }
+  }
+  if (fat_read(&file, record, 1) != 0)
+    fail("read past end", 0);
+
+  printf("Log (%s, %u block clusters): %s (%u bytes, at most %u transfers per write)\n",
+         partitioned ? "partition" : "whole device", cluster_blocks,
+         failures > before ? "FAILED" : "OK", written, worst);
+}
+
+//Creates many small files (growing the root directory), removes some, and checks the rest.
+static void test_directory() {
+  char name[13];
+  uint32_t i;
+  int before = failures;
+
+  format(1, 1);
+  mount("mount");
+
+  for (i = 0; i < 40; i++) {
+    sprintf(name, "F%u%03u.txt", i % 10, i);
+    if (fat_create(&fs, &file, name, i * 100) != FAT_OK) {
+      fail("create", i);
+      continue;
+    }
+    fill((uint8_t *) record, i % 10, 0, i * 37);
+    fat_write(&file, record, i * 37);
+    if (fat_close(&file) != FAT_OK)
+      fail("close", i);
+  }
+
+  for (i = 0; i < 40; i += 3) {
+    sprintf(name, "F%u%03u.TXT", i % 10, i);
+    if (fat_remove(&fs, name) != FAT_OK)
+      fail("remove", i);
+  }
+
+  if (check_volume(0) != 40 - 14)
+    fail("directory", 0);
+
+  //Freed entries are used again.
+  if (fat_create(&fs, &file, "F0000.TXT", 0) != FAT_OK || fat_close(&file) != FAT_OK ||
+      check_volume(0) != 40 - 13)
+    fail("entry reuse", 0);
+
+  if (fat_create(&fs, &file, "F1001.TXT", 0) != FAT_ERR_EXISTS)
+    fail("existing file", 0);
+  if (fat_open(&fs, &file, "F0003.TXT") != FAT_ERR_NOT_FOUND)
+    fail("missing file", 0);
+  if (fat_create(&fs, &file, "TOOLONGNAME.TXT", 0) != FAT_ERR_NAME ||
+      fat_create(&fs, &file, "A.LONG", 0) != FAT_ERR_NAME ||
+      fat_create(&fs, &file, ".TXT", 0) != FAT_ERR_NAME ||
+      fat_create(&fs, &file, "A*.TXT", 0) != FAT_ERR_NAME)
+    fail("invalid names", 0);
+  if (fat_create(&fs, &file, "HUGE.BIN", 0xFFFFFFFF) != FAT_ERR_FULL)
+    fail("oversized file", 0);
+  if (fat_open(&fs, &file, "F1001.TXT") != FAT_OK || fat_write(&file, record, 1) != FAT_ERR_MODE)
+    fail("write to reader", 0);
+
+  printf("Directory: %s\n", failures > before ? "FAILED" : "OK");
+}
+
+//Resets while logging: the file keeps the size of the last sync.
+static void test_reset() {
+  uint32_t written = 0, synced = 0, i;
+  int before = failures;
+
+  format(1, 8);
+  mount("mount");
+  fat_create(&fs, &file, "R3.BIN", 1024 * 1024);
+
+  for (i = 0; i < 300; i++) {
+    fill((uint8_t *) record, 3, written, 1000);
+    fat_write(&file, record, 1000);
+    written += 1000;
+    if (i % 100 == 50) {
+      fat_sync(&file);
+      synced = written;
+    }
+  }
+
+  //Reset: the file is read as it was synced, with clusters left over (lost until checked).
+  mount("mount after reset");
+  if (fat_open(&fs, &file, "R3.BIN") != FAT_OK || file.size != synced)
+    fail("size after reset", file.size);
+  check_volume(1);
+
+  device.blocks = 100;
+  if (fat_mount(&fs, &device) != FAT_ERR_FORMAT)
+    fail("volume past the device", 0);
+  device.blocks = IMAGE_BLOCKS;
+  memset(image, 0, FAT_BLOCK_SIZE);
+  if (fat_mount(&fs, &device) != FAT_ERR_FORMAT)
+    fail("mount without volume", 0);
+
+  printf("Reset: %s\n", failures > before ? "FAILED" : "OK");
+}
+
+//Appends to files (partial last blocks, empty files), and writes a file through fat_map() on its
+//own, past its pre-allocated size.
+static void test_append() {
+  static const uint32_t lengths[] = {1000, 3000, 5000, 512, 70000};
+  uint32_t written = 0, appended, block, count, run, i;
+  int before = failures;
+
+  format(1, 8);
+  mount("mount");
+
+  fat_create(&fs, &file, "A4.BIN", 0);
+  fat_close(&file);
+  fat_create(&fs, &other, "E5.BIN", 0);
+  fat_close(&other);
+  for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    //Nothing left in the buffer from the previous time.
+    memset(&file, 0xA5, sizeof(file));
+    if (fat_append(&fs, &file, "A4.BIN") != FAT_OK || file.size != written)
+      fail("append", i);
+    fill((uint8_t *) record, 4, written, lengths[i] % RECORD_MAX);
+    fat_write(&file, record, lengths[i] % RECORD_MAX);
+    written += lengths[i] % RECORD_MAX;
+    fat_close(&file);
+  }
+  appended = written;
+  if (fat_append(&fs, &file, "N0.BIN") != FAT_ERR_NOT_FOUND)
+    fail("append missing file", 0);
+
+  //The empty file gets its first clusters on the first append.
+  fat_append(&fs, &other, "E5.BIN");
+  fill((uint8_t *) record, 5, 0, 777);
+  fat_write(&other, record, 777);
+  fat_close(&other);
+
+  //Map blocks and write them directly, across extents and the pre-allocated size.
+  fat_create(&fs, &file, "M6.BIN", 65536);
+  for (written = 0; written < 300000; written += run * FAT_BLOCK_SIZE) {
+    if (fat_map(&file, written, &block, &count) != FAT_OK || count == 0) {
+      fail("map", written);
+      break;
+    }
+    run = count < RECORD_MAX / FAT_BLOCK_SIZE ? count : RECORD_MAX / FAT_BLOCK_SIZE;
+    fill((uint8_t *) record, 6, written, run * FAT_BLOCK_SIZE);
+    ram_write(block, record, run);
+    if (written == 65536)
+      fat_create(&fs, &other, "G7.BIN", 5000);
+  }
+  fat_close(&other);
+  if (fat_set_size(&file, written - 100) != FAT_OK || fat_close(&file) != FAT_OK)
+    fail("set size", 0);
+  if (fat_set_size(&file, 0) != FAT_ERR_MODE)
+    fail("set size of closed file", 0);
+
+  mount("remount");
+  if (fat_open(&fs, &file, "A4.BIN") != FAT_OK || file.size != appended ||
+      fat_open(&fs, &other, "M6.BIN") != FAT_OK || other.size != written - 100)
+    fail("sizes", 0);
+  if (check_volume(0) != 4)
+    fail("file count", 0);
+
+  printf("Append: %s\n", failures > before ? "FAILED" : "OK");
+}
+
+//--------------------------------------------------------------------------------------------------
+//Benchmark.
+
+//Writes a log of records of a fixed size, returning the transfers it took.
+static void log_records(struct transfers *total, uint32_t size, uint32_t *worst) {
+  uint32_t written;
+
+  format(1, 64);
+  fat_mount(&fs, &device);
+  fat_create(&fs, &file, "B0.BIN", LOG_WRITTEN);
+
+  memset(total, 0, sizeof(*total));
+  *worst = 0;
+  for (written = 0; written + size <= LOG_WRITTEN; written += size) {
+    memset(&io, 0, sizeof(io));
+    fat_write(&file, record, size);
+    total->writes += io.writes;
+    total->blocks += io.blocks;
+    if (io.largest > total->largest)
+      total->largest = io.largest;
+    if (io.writes > *worst)
+      *worst = io.writes;
+  }
+  fat_close(&file);
+}
+
+static void bench() {
+  static const uint32_t sizes[] = {64, 512, 4096, 8192};
+  struct transfers total;
+  uint32_t worst, i;
+
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    device.max_blocks = MAX_BLOCKS;
+    log_records(&total, sizes[i], &worst);
+    printf("%5u byte records: %.1f transfers/MB, largest %u blocks, worst write %u",
+           sizes[i], total.writes / (LOG_WRITTEN / 1048576.0), total.largest, worst);
+
+    device.max_blocks = 1;
+    log_records(&total, sizes[i], &worst);
+    printf("; 1 block: %.1f\n", total.writes / (LOG_WRITTEN / 1048576.0));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  image = malloc((size_t) IMAGE_BLOCKS * FAT_BLOCK_SIZE);
+  device.read = ram_read;
+  device.write = ram_write;
+
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    bench();
+    free(image);
+    return 0;
+  }
+
+  test_log(1, 8);
+  test_log(0, 1);
+  test_log(1, 64);
+  test_directory();
+  test_reset();
+  test_append();
+
+  free(image);
+  return failures ? 1 : 0;
+}
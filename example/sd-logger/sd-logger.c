@@ -0,0 +1,126 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the SD card logger example.                                                    |
+//|                                                                                                |
+//| Creates LOG.BIN in the root directory of the FAT32 formatted card, with 16MB pre-allocated,    |
+//| and appends a 64 byte record to it on every clock tick (128 times a second) for 10 minutes,    |
+//| timing each write. Every 10 seconds the file is synced and the write latencies (worst and      |
+//| average) are printed along with the card transfers done, after which the file is closed.       |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "contiki.h"
+#include "sdcard.h"
+#include "fat.h"
+
+#define LOG_NAME        "LOG.BIN"
+#define LOG_SIZE        (16ul * 1024 * 1024)
+#define LOG_SECONDS     600
+#define REPORT_SECONDS  10
+
+//Records are made up: a sequence number, the time they were taken and some counting values.
+struct record {
+  uint32_t sequence;
+  uint32_t time;
+  uint16_t values[28];
+};
+
+static struct fat_device device = {sdcard_read, sdcard_write, 0, SDCARD_MAX_BLOCKS, 0};
+static struct fat fs;
+static struct fat_file file;
+static struct record record;
+
+//Write latencies since the last report, in microseconds.
+static uint32_t worst, total, count;
+
+PROCESS(sd_logger, "SD card logger");
+
+AUTOSTART_PROCESSES(&sd_logger);
+
+static void report() {
+  printf("%lu s: worst write %lu us, average %lu us, %lu transfers (largest %lu blocks)\n",
+         (unsigned long) clock_seconds(), (unsigned long) worst,
+         (unsigned long) (count ? total / count : 0), (unsigned long) fs.writes,
+         (unsigned long) fs.largest_write);
+  worst = total = count = 0;
+}
+
+PROCESS_THREAD(sd_logger, ev, data) {
+  static struct etimer et;
+  static uint16_t ticks, reports;
+  rtimer_clock_t start;
+  uint32_t elapsed;
+  uint8_t i;
+  int result;
+
+  PROCESS_BEGIN();
+
+  result = sdcard_init();
+  if (result != SDCARD_OK) {
+    printf("No card (error %d)\n", result);
+    PROCESS_EXIT();
+  }
+
+  device.blocks = sdcard_blocks();
+  device.erase_blocks = sdcard_erase_blocks();
+  result = fat_mount(&fs, &device);
+  if (result != FAT_OK) {
+    printf("Mount error %d\n", result);
+    PROCESS_EXIT();
+  }
+
+  //Start over on every run.
+  fat_remove(&fs, LOG_NAME);
+  result = fat_create(&fs, &file, LOG_NAME, LOG_SIZE);
+  if (result != FAT_OK) {
+    printf("Create error %d\n", result);
+    PROCESS_EXIT();
+  }
+
+  printf("Logging to %s, erase unit of %lu blocks\n", LOG_NAME,
+         (unsigned long) device.erase_blocks);
+
+  etimer_set(&et, 1);
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    record.time = clock_time();
+    for (i = 0; i < sizeof(record.values) / sizeof(record.values[0]); i++)
+      record.values[i] = record.sequence + i;
+
+    //Time the write alone, in microseconds.
+    start = RTIMER_NOW();
+    result = fat_write(&file, &record, sizeof(record));
+    elapsed = (uint32_t) (RTIMER_NOW() - start) / (RTIMER_ARCH_SECOND / 1000000);
+    if (result != FAT_OK)
+      printf("Write error %d\n", result);
+
+    record.sequence++;
+    if (elapsed > worst)
+      worst = elapsed;
+    total += elapsed;
+    count++;
+
+    if (++ticks == REPORT_SECONDS * CLOCK_SECOND) {
+      ticks = 0;
+      report();
+
+      result = fat_sync(&file);
+      if (result != FAT_OK)
+        printf("Sync error %d\n", result);
+
+      if (++reports == LOG_SECONDS / REPORT_SECONDS)
+        break;
+    }
+  }
+
+  result = fat_close(&file);
+  printf("Closed %s: %lu bytes, %s\n", LOG_NAME, (unsigned long) file.size,
+         result == FAT_OK ? "done" : "error");
+
+  PROCESS_END();
+}
@@ -0,0 +1,167 @@
+//+------------------------------------------------------------------------------------------------+
+//| Demo for the SPI coprocessor host library.                                                     |
+//|                                                                                                |
+//| Usage: coproc-demo [spidev device [clock rate in Hz [data ready GPIO value file]]]             |
+//|                                                                                                |
+//| Without arguments the loopback transport is used. Checks the ID register, writes and reads     |
+//| back a register block, echoes a few messages through mailbox 0 and measures the throughput of  |
+//| the data stream (mailbox 1) for a couple of seconds.                                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "coproc.h"
+
+#define REG_ID          0x00
+#define REG_STREAM      0x10
+#define REG_SCRATCH     0x20
+#define EXPECTED_ID     0xC5
+#define MAILBOX_ECHO    0
+#define MAILBOX_DATA    1
+
+#define STREAM_SECONDS  2.0
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//Waits for a message on the given mailbox, skipping any other. Returns -1 if none arrives.
+static int wait_message(struct coproc *c, uint8_t mailbox, struct coproc_message *message) {
+  int i, result;
+
+  for (i = 0; i < 16; i++) {
+    result = coproc_receive(c, message);
+    if (result < 0)
+      return -1;
+    if (result > 0 && message->mailbox == mailbox)
+      return 0;
+  }
+
+  return -1;
+}
+
+static int test_registers(struct coproc *c) {
+  uint8_t values[32], readback[32];
+  uint8_t id;
+  size_t i;
+
+  if (coproc_read_registers(c, REG_ID, &id, 1) < 0) {
+    perror("reading the ID register");
+    return -1;
+  }
+  if (id != EXPECTED_ID) {
+    fprintf(stderr, "unexpected ID 0x%02X\n", id);
+    return -1;
+  }
+
+  for (i = 0; i < sizeof(values); i++)
+    values[i] = rand();
+  if (coproc_write_registers(c, REG_SCRATCH, values, sizeof(values)) < 0 ||
+      coproc_read_registers(c, REG_SCRATCH, readback, sizeof(readback)) < 0) {
+    perror("accessing the scratch registers");
+    return -1;
+  }
+  if (memcmp(values, readback, sizeof(values)) != 0) {
+    fprintf(stderr, "register readback mismatch\n");
+    return -1;
+  }
+
+  printf("Registers: OK (ID 0x%02X)\n", id);
+  return 0;
+}
+
+static int test_echo(struct coproc *c) {
+  struct coproc_message message;
+  uint8_t data[COPROC_PAYLOAD_SIZE];
+  int i, j, length;
+
+  for (i = 0; i < 32; i++) {
+    length = 1 + rand() % COPROC_PAYLOAD_SIZE;
+    for (j = 0; j < length; j++)
+      data[j] = rand();
+
+    if (coproc_send(c, MAILBOX_ECHO, data, length) < 0 ||
+        wait_message(c, MAILBOX_ECHO, &message) < 0) {
+      fprintf(stderr, "no echo received\n");
+      return -1;
+    }
+    if (message.length != length || memcmp(message.data, data, length) != 0) {
+      fprintf(stderr, "echo mismatch\n");
+      return -1;
+    }
+  }
+
+  printf("Echo: OK\n");
+  return 0;
+}
+
+static int test_stream(struct coproc *c) {
+  struct coproc_message message;
+  uint32_t counter, expected = 0, messages = 0, lost = 0;
+  uint8_t value;
+  double start, elapsed;
+  int result;
+
+  value = 1;
+  if (coproc_write_registers(c, REG_STREAM, &value, 1) < 0)
+    return -1;
+
+  start = now();
+  do {
+    result = coproc_receive(c, &message);
+    if (result < 0)
+      return -1;
+    if (result == 0 || message.mailbox != MAILBOX_DATA || message.length < sizeof(counter))
+      continue;
+
+    memcpy(&counter, message.data, sizeof(counter));
+    if (messages > 0 && counter != expected)
+      lost += counter - expected;
+    expected = counter + 1;
+    messages++;
+  } while ((elapsed = now() - start) < STREAM_SECONDS);
+
+  value = 0;
+  if (coproc_write_registers(c, REG_STREAM, &value, 1) < 0)
+    return -1;
+
+  printf("Stream: %u messages, %u lost, %.2f Mbit/s payload, %.2f Mbit/s on the bus\n", messages,
+         lost, messages * COPROC_PAYLOAD_SIZE * 8 / elapsed / 1e6,
+         c->stats.frames * COPROC_FRAME_SIZE * 8 / elapsed / 1e6);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  struct coproc c;
+  int result;
+
+  if (argc > 1) {
+    if (coproc_open_spidev(&c, argv[1], argc > 2 ? strtoul(argv[2], NULL, 0) : 12000000) < 0) {
+      perror(argv[1]);
+      return 1;
+    }
+    if (argc > 3 && coproc_set_ready_gpio(&c, argv[3]) < 0) {
+      perror(argv[3]);
+      return 1;
+    }
+  } else {
+    coproc_open_loopback(&c);
+    printf("Using the loopback transport\n");
+  }
+
+  result = test_registers(&c) < 0 || test_echo(&c) < 0 || test_stream(&c) < 0;
+
+  printf("Frames: %u, CRC errors: %u, sequence errors: %u, dropped: %u\n", c.stats.frames,
+         c.stats.crc_errors, c.stats.seq_errors, c.stats.dropped);
+  coproc_close(&c);
+
+  return result;
+}
@@ -0,0 +1,380 @@
+//+------------------------------------------------------------------------------------------------+
+//| Host side library for the SPI coprocessor interface.                                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+#include "coproc.h"
+
+//Frames clocked while waiting for a register read answer.
+#define READ_ATTEMPTS 16
+
+//Registers of the coprocessor example firmware, simulated by the loopback transport.
+#define LOOP_REG_ID       0x00
+#define LOOP_REG_STREAM   0x10
+#define LOOP_ID           0xC5
+#define LOOP_MAILBOX_ECHO 0
+#define LOOP_MAILBOX_DATA 1
+
+//Simulated slave state.
+struct loopback {
+  uint8_t registers[COPROC_REGISTERS];
+  uint8_t pipeline[2][COPROC_FRAME_SIZE];   //Frames committed for the next 2 transfers
+  uint8_t queue[8][COPROC_FRAME_SIZE];      //Frames queued behind those
+  unsigned int queue_head;
+  unsigned int queue_count;
+  uint32_t frames;
+  uint32_t counter;
+};
+
+//+------------------------------------------------------------------------------------------------+
+//| Frame coding.                                                                                  |
+//+------------------------------------------------------------------------------------------------+
+
+static uint16_t crc_update(uint16_t crc, uint8_t byte) {
+  uint8_t bit;
+
+  crc ^= byte << 8;
+  for (bit = 0; bit < 8; bit++)
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+
+  return crc;
+}
+
+static uint16_t frame_crc(const uint8_t *frame) {
+  uint16_t crc = 0xFFFF;
+  unsigned int i;
+
+  for (i = 0; i < 4; i++)
+    crc = crc_update(crc, frame[i]);
+  for (i = 0; i < frame[3]; i++)
+    crc = crc_update(crc, frame[COPROC_HEADER_SIZE + i]);
+
+  return crc;
+}
+
+//Builds a frame. The unused part of the payload is cleared.
+static void build_frame(uint8_t *frame, uint8_t type, uint8_t seq, uint8_t id, const void *data,
+                        uint8_t length) {
+  uint16_t crc;
+
+  memset(frame, 0, COPROC_FRAME_SIZE);
+  frame[0] = type;
+  frame[1] = seq;
+  frame[2] = id;
+  frame[3] = length;
+  if (length > 0)
+    memcpy(&frame[COPROC_HEADER_SIZE], data, length);
+  crc = frame_crc(frame);
+  frame[4] = crc;
+  frame[5] = crc >> 8;
+}
+
+static int frame_valid(const uint8_t *frame) {
+  return frame[3] <= COPROC_PAYLOAD_SIZE && frame_crc(frame) == (frame[4] | (frame[5] << 8));
+}
+
+//+------------------------------------------------------------------------------------------------+
+//| spidev transport.                                                                              |
+//+------------------------------------------------------------------------------------------------+
+
+static int spidev_transfer(struct coproc *c, const uint8_t *tx, uint8_t *rx) {
+  struct spi_ioc_transfer xfer;
+
+  memset(&xfer, 0, sizeof(xfer));
+  xfer.tx_buf = (unsigned long) tx;
+  xfer.rx_buf = (unsigned long) rx;
+  xfer.len = COPROC_FRAME_SIZE;
+  xfer.speed_hz = c->speed;
+  xfer.bits_per_word = 8;
+
+  return ioctl(c->fd, SPI_IOC_MESSAGE(1), &xfer) == COPROC_FRAME_SIZE ? 0 : -1;
+}
+
+static int gpio_data_ready(struct coproc *c) {
+  char value;
+
+  if (c->ready_fd < 0)
+    return -1;
+  if (pread(c->ready_fd, &value, 1, 0) != 1)
+    return -1;
+
+  return value == '1';
+}
+
+static void spidev_close(struct coproc *c) {
+  close(c->fd);
+  if (c->ready_fd >= 0)
+    close(c->ready_fd);
+}
+
+//Opens a spidev device (e.g. /dev/spidev0.0), in mode 0 at the given clock rate (in Hz). Returns -1
+//on failure, with errno set.
+int coproc_open_spidev(struct coproc *c, const char *device, uint32_t speed) {
+  uint8_t mode = SPI_MODE_0;
+  uint8_t bits = 8;
+
+  memset(c, 0, sizeof(*c));
+  c->ready_fd = -1;
+  c->speed = speed;
+  c->fd = open(device, O_RDWR);
+  if (c->fd < 0)
+    return -1;
+
+  if (ioctl(c->fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+      ioctl(c->fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+      ioctl(c->fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
+    close(c->fd);
+    return -1;
+  }
+
+  c->transfer = spidev_transfer;
+  c->data_ready = gpio_data_ready;
+  c->close = spidev_close;
+  return 0;
+}
+
+//Sets the GPIO the data ready line is connected to, by the path of its sysfs value file (e.g.
+///sys/class/gpio/gpio17/value, already exported as an input).
+int coproc_set_ready_gpio(struct coproc *c, const char *value_path) {
+  c->ready_fd = open(value_path, O_RDONLY);
+  return c->ready_fd < 0 ? -1 : 0;
+}
+
+//+------------------------------------------------------------------------------------------------+
+//| Loopback transport.                                                                            |
+//+------------------------------------------------------------------------------------------------+
+
+//Queues a frame in the simulated slave. Returns -1 if full.
+static int loop_queue(struct loopback *l, uint8_t type, uint8_t id, const void *data,
+                      uint8_t length) {
+  unsigned int slot;
+
+  if (l->queue_count == 8)
+    return -1;
+
+  slot = (l->queue_head + l->queue_count) % 8;
+  build_frame(l->queue[slot], type, 0, id, data, length);
+  l->queue_count++;
+  return 0;
+}
+
+static int loop_transfer(struct coproc *c, const uint8_t *tx, uint8_t *rx) {
+  struct loopback *l = c->priv;
+  uint8_t payload[COPROC_PAYLOAD_SIZE];
+  uint8_t address, length;
+  unsigned int i;
+  uint16_t crc;
+
+  //Send the oldest committed frame, numbered, and commit the next one.
+  memcpy(rx, l->pipeline[0], COPROC_FRAME_SIZE);
+  rx[1] = l->frames++;
+  crc = frame_crc(rx);
+  rx[4] = crc;
+  rx[5] = crc >> 8;
+
+  memcpy(l->pipeline[0], l->pipeline[1], COPROC_FRAME_SIZE);
+  if (l->queue_count > 0) {
+    memcpy(l->pipeline[1], l->queue[l->queue_head], COPROC_FRAME_SIZE);
+    l->queue_head = (l->queue_head + 1) % 8;
+    l->queue_count--;
+  } else {
+    build_frame(l->pipeline[1], COPROC_TYPE_IDLE, 0, 0, NULL, 0);
+  }
+
+  //Handle the frame received, like the example firmware.
+  if (tx[0] != COPROC_TYPE_IDLE && frame_valid(tx)) {
+    address = tx[2];
+    length = tx[3];
+
+    switch (tx[0]) {
+    case COPROC_TYPE_REG_WRITE:
+      if (length > COPROC_REGISTERS - address)
+        length = COPROC_REGISTERS - address;
+      memcpy(&l->registers[address], &tx[COPROC_HEADER_SIZE], length);
+      l->registers[LOOP_REG_ID] = LOOP_ID;
+      break;
+
+    case COPROC_TYPE_REG_READ:
+      if (length < 1)
+        break;
+      length = tx[COPROC_HEADER_SIZE];
+      if (length > COPROC_REGISTERS - address)
+        length = COPROC_REGISTERS - address;
+      if (length > COPROC_PAYLOAD_SIZE)
+        length = COPROC_PAYLOAD_SIZE;
+      loop_queue(l, COPROC_TYPE_REG_DATA, address, &l->registers[address], length);
+      break;
+
+    case COPROC_TYPE_MAILBOX:
+      if (address == LOOP_MAILBOX_ECHO)
+        loop_queue(l, COPROC_TYPE_MAILBOX, address, &tx[COPROC_HEADER_SIZE], length);
+      break;
+    }
+  }
+
+  //Keep the queue filled with stream data, leaving room for replies, like the firmware.
+  while (l->registers[LOOP_REG_STREAM] && l->queue_count < 6) {
+    for (i = 0; i < COPROC_PAYLOAD_SIZE; i++)
+      payload[i] = l->counter + i;
+    memcpy(payload, &l->counter, sizeof(l->counter));
+    l->counter++;
+    loop_queue(l, COPROC_TYPE_MAILBOX, LOOP_MAILBOX_DATA, payload, COPROC_PAYLOAD_SIZE);
+  }
+
+  return 0;
+}
+
+static int loop_data_ready(struct coproc *c) {
+  struct loopback *l = c->priv;
+
+  return l->pipeline[0][0] != COPROC_TYPE_IDLE || l->pipeline[1][0] != COPROC_TYPE_IDLE ||
+         l->queue_count > 0;
+}
+
+static void loop_close(struct coproc *c) {
+  free(c->priv);
+}
+
+//Opens a simulated coprocessor.
+int coproc_open_loopback(struct coproc *c) {
+  struct loopback *l;
+
+  memset(c, 0, sizeof(*c));
+  c->fd = -1;
+  c->ready_fd = -1;
+
+  l = calloc(1, sizeof(*l));
+  if (l == NULL)
+    return -1;
+  l->registers[LOOP_REG_ID] = LOOP_ID;
+  build_frame(l->pipeline[0], COPROC_TYPE_IDLE, 0, 0, NULL, 0);
+  build_frame(l->pipeline[1], COPROC_TYPE_IDLE, 0, 0, NULL, 0);
+
+  c->priv = l;
+  c->transfer = loop_transfer;
+  c->data_ready = loop_data_ready;
+  c->close = loop_close;
+  return 0;
+}
+
+//+------------------------------------------------------------------------------------------------+
+//| Protocol.                                                                                      |
+//+------------------------------------------------------------------------------------------------+
+
+void coproc_close(struct coproc *c) {
+  c->close(c);
+}
+
+//Returns whether the slave has frames to send, or -1 if unknown (no data ready line).
+int coproc_data_ready(struct coproc *c) {
+  return c->data_ready(c);
+}
+
+//Transfers a frame and handles the one received. Returns -1 on transport errors.
+static int exchange(struct coproc *c, uint8_t type, uint8_t id, const void *data,
+                    uint8_t length) {
+  uint8_t tx[COPROC_FRAME_SIZE], rx[COPROC_FRAME_SIZE];
+  struct coproc_message *message;
+
+  build_frame(tx, type, c->seq++, id, data, length);
+  if (c->transfer(c, tx, rx) < 0)
+    return -1;
+  c->stats.frames++;
+
+  if (!frame_valid(rx)) {
+    c->stats.crc_errors++;
+    return 0;
+  }
+
+  if (c->rx_started && rx[1] != (uint8_t) (c->rx_seq + 1))
+    c->stats.seq_errors++;
+  c->rx_seq = rx[1];
+  c->rx_started = 1;
+
+  switch (rx[0]) {
+  case COPROC_TYPE_REG_DATA:
+    c->reg_data_valid = 1;
+    c->reg_data_address = rx[2];
+    c->reg_data_length = rx[3];
+    memcpy(c->reg_data, &rx[COPROC_HEADER_SIZE], rx[3]);
+    break;
+
+  case COPROC_TYPE_MAILBOX:
+    if (c->queue_count == COPROC_QUEUE_LENGTH) {
+      c->stats.dropped++;
+      break;
+    }
+    message = &c->queue[(c->queue_head + c->queue_count) % COPROC_QUEUE_LENGTH];
+    message->mailbox = rx[2];
+    message->length = rx[3];
+    memcpy(message->data, &rx[COPROC_HEADER_SIZE], rx[3]);
+    c->queue_count++;
+    break;
+  }
+
+  return 0;
+}
+
+//Clocks an idle frame to fetch whatever the slave has to send.
+int coproc_poll(struct coproc *c) {
+  return exchange(c, COPROC_TYPE_IDLE, 0, NULL, 0);
+}
+
+int coproc_write_registers(struct coproc *c, uint8_t first, const uint8_t *values, uint8_t count) {
+  if (count > COPROC_PAYLOAD_SIZE)
+    return -1;
+
+  return exchange(c, COPROC_TYPE_REG_WRITE, first, values, count);
+}
+
+//Reads registers, clocking frames until the answer arrives. Returns -1 on errors or if no answer
+//arrived in time.
+int coproc_read_registers(struct coproc *c, uint8_t first, uint8_t *values, uint8_t count) {
+  int i;
+
+  c->reg_data_valid = 0;
+  if (exchange(c, COPROC_TYPE_REG_READ, first, &count, 1) < 0)
+    return -1;
+
+  for (i = 0; i < READ_ATTEMPTS; i++) {
+    if (c->reg_data_valid && c->reg_data_address == first && c->reg_data_length == count) {
+      memcpy(values, c->reg_data, count);
+      return 0;
+    }
+    if (coproc_poll(c) < 0)
+      return -1;
+  }
+
+  errno = ETIMEDOUT;
+  return -1;
+}
+
+int coproc_send(struct coproc *c, uint8_t mailbox, const void *data, uint8_t length) {
+  if (length > COPROC_PAYLOAD_SIZE)
+    return -1;
+
+  return exchange(c, COPROC_TYPE_MAILBOX, mailbox, data, length);
+}
+
+//Takes the oldest message received. If there's none, an idle frame is clocked first. Returns 1 if
+//a message was taken, 0 if there's none and -1 on errors.
+int coproc_receive(struct coproc *c, struct coproc_message *message) {
+  if (c->queue_count == 0 && coproc_poll(c) < 0)
+    return -1;
+  if (c->queue_count == 0)
+    return 0;
+
+  *message = c->queue[c->queue_head];
+  c->queue_head = (c->queue_head + 1) % COPROC_QUEUE_LENGTH;
+  c->queue_count--;
+  return 1;
+}
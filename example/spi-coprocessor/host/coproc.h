@@ -0,0 +1,83 @@
+//+------------------------------------------------------------------------------------------------+
+//| Host side library for the SPI coprocessor interface (see spi-slave.h of the MK66 CPU).         |
+//|                                                                                                |
+//| Runs on Linux, talking to the board through a spidev device. A loopback transport is also      |
+//| available: it simulates the coprocessor example firmware (including the 2 frame delay of the   |
+//| slave responses), so applications and the protocol can be tested without hardware.             |
+//|                                                                                                |
+//| Every call transfers whole frames. Mailbox messages received from the slave at any time (even  |
+//| while waiting for a register read) are queued, and handed out by coproc_receive().             |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef COPROC_H_
+#define COPROC_H_
+
+#include <stdint.h>
+
+//Protocol constants. They must match the ones of the firmware.
+#define COPROC_FRAME_SIZE     256
+#define COPROC_HEADER_SIZE    6
+#define COPROC_PAYLOAD_SIZE   (COPROC_FRAME_SIZE - COPROC_HEADER_SIZE)
+#define COPROC_REGISTERS      256
+
+#define COPROC_TYPE_IDLE      0
+#define COPROC_TYPE_REG_WRITE 1
+#define COPROC_TYPE_REG_READ  2
+#define COPROC_TYPE_REG_DATA  3
+#define COPROC_TYPE_MAILBOX   4
+
+//Received messages kept until read.
+#define COPROC_QUEUE_LENGTH 64
+
+struct coproc_message {
+  uint8_t mailbox;
+  uint8_t length;
+  uint8_t data[COPROC_PAYLOAD_SIZE];
+};
+
+struct coproc_stats {
+  uint32_t frames;      //Frames transferred
+  uint32_t crc_errors;  //Frames from the slave dropped due to a bad CRC
+  uint32_t seq_errors;  //Frames from the slave missing (sequence number jumps)
+  uint32_t dropped;     //Messages dropped because the queue was full
+};
+
+struct coproc {
+  //Transport.
+  int (* transfer)(struct coproc *c, const uint8_t *tx, uint8_t *rx);
+  int (* data_ready)(struct coproc *c);
+  void (* close)(struct coproc *c);
+  void *priv;
+  int fd;
+  int ready_fd;
+  uint32_t speed;
+
+  //Protocol state.
+  uint8_t seq;
+  uint8_t rx_seq;
+  int rx_started;
+  struct coproc_message queue[COPROC_QUEUE_LENGTH];
+  unsigned int queue_head;
+  unsigned int queue_count;
+  int reg_data_valid;
+  uint8_t reg_data_address;
+  uint8_t reg_data_length;
+  uint8_t reg_data[COPROC_PAYLOAD_SIZE];
+  struct coproc_stats stats;
+};
+
+int coproc_open_spidev(struct coproc *c, const char *device, uint32_t speed);
+int coproc_open_loopback(struct coproc *c);
+int coproc_set_ready_gpio(struct coproc *c, const char *value_path);
+void coproc_close(struct coproc *c);
+
+int coproc_data_ready(struct coproc *c);
+int coproc_poll(struct coproc *c);
+int coproc_write_registers(struct coproc *c, uint8_t first, const uint8_t *values, uint8_t count);
+int coproc_read_registers(struct coproc *c, uint8_t first, uint8_t *values, uint8_t count);
+int coproc_send(struct coproc *c, uint8_t mailbox, const void *data, uint8_t length);
+int coproc_receive(struct coproc *c, struct coproc_message *message);
+
+#endif //COPROC_H_
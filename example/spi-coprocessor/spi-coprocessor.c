@@ -0,0 +1,64 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the SPI coprocessor example.                                                   |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <string.h>
+
+#include "contiki.h"
+#include "spi-slave.h"
+
+//Registers.
+#define REG_ID      0x00  //Read only
+#define REG_STREAM  0x10  //Set to nonzero to stream data through mailbox 1
+
+#define ID 0xC5
+
+//Mailboxes.
+#define MAILBOX_ECHO  0   //Messages are sent back as they are
+#define MAILBOX_DATA  1   //Data stream
+
+PROCESS(spi_coprocessor, "SPI coprocessor");
+
+AUTOSTART_PROCESSES(&spi_coprocessor);
+
+PROCESS_THREAD(spi_coprocessor, ev, data) {
+  static uint8_t payload[SPI_SLAVE_PAYLOAD_SIZE];
+  static uint32_t counter;
+  const struct spi_slave_message *message;
+  uint16_t i;
+
+  PROCESS_BEGIN();
+
+  spi_slave_init();
+  spi_slave_registers[REG_ID] = ID;
+
+  for (;;) {
+    PROCESS_WAIT_EVENT();
+
+    if (ev == spi_slave_event_register) {
+      //Keep the ID register read only.
+      spi_slave_registers[REG_ID] = ID;
+    } else if (ev == spi_slave_event_mailbox) {
+      message = data;
+      if (message->mailbox == MAILBOX_ECHO)
+        spi_slave_send(MAILBOX_ECHO, message->data, message->length);
+    }
+
+    //While streaming, keep the transmit ring filled with counter stamped frames, leaving a couple
+    //of slots free for replies. Polling the process brings it back here once other processes ran.
+    if (spi_slave_registers[REG_STREAM]) {
+      while (spi_slave_tx_free() > 2) {
+        for (i = 0; i < SPI_SLAVE_PAYLOAD_SIZE; i++)
+          payload[i] = counter + i;
+        memcpy(payload, &counter, sizeof(counter));
+        counter++;
+        spi_slave_send(MAILBOX_DATA, payload, SPI_SLAVE_PAYLOAD_SIZE);
+      }
+      process_poll(&spi_coprocessor);
+    }
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,120 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the control loop example.                                                      |
+//|                                                                                                |
+//| A PI speed controller for a simulated DC motor (modeled as a first order system) runs at 10KHz |
+//| from the control loop service. A process changes the speed setpoint every 2 seconds and prints |
+//| the telemetry and loop timing statistics every second.                                         |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "control-loop.h"
+
+#define LOOP_RATE 10000
+
+//Motor model: time constant of 50ms and a gain of 100rad/s per volt.
+#define MOTOR_TAU 0.05f
+#define MOTOR_GAIN 100.0f
+#define SUPPLY_VOLTAGE 12.0f
+
+struct setpoint {
+  float speed;
+};
+
+struct telemetry {
+  float speed;
+  float voltage;
+  uint32_t iteration;
+};
+
+//Double buffers shared with the loop.
+static struct setpoint setpoint_buf[2];
+static struct telemetry telemetry_buf[2];
+static struct control_buffer setpoint;
+static struct control_buffer telemetry;
+
+//Controller and plant state. Only accessed by the loop.
+static float integral;
+static float speed;
+static uint32_t iteration;
+
+static struct control_loop_task controller_task;
+
+//Loop function. Runs one step of the controller and the motor model.
+static void controller(void *ctx) {
+  const float dt = 1.0f / LOOP_RATE;
+  const struct setpoint *sp = control_buffer_front(&setpoint);
+  struct telemetry *tm;
+  float error, voltage;
+
+  //PI controller with output clamping (integration stops while saturated).
+  error = sp->speed - speed;
+  voltage = 0.02f * error + integral;
+  if (voltage > SUPPLY_VOLTAGE)
+    voltage = SUPPLY_VOLTAGE;
+  else if (voltage < -SUPPLY_VOLTAGE)
+    voltage = -SUPPLY_VOLTAGE;
+  else
+    integral += 1.0f * error * dt;
+
+  //Motor model (forward euler).
+  speed += (MOTOR_GAIN * voltage - speed) * dt / MOTOR_TAU;
+
+  //Publish the telemetry.
+  tm = control_buffer_back(&telemetry);
+  tm->speed = speed;
+  tm->voltage = voltage;
+  tm->iteration = ++iteration;
+  control_buffer_publish(&telemetry);
+}
+
+PROCESS(control_loop_test, "Control loop test");
+
+AUTOSTART_PROCESSES(&control_loop_test);
+
+PROCESS_THREAD(control_loop_test, ev, data) {
+  static struct etimer et;
+  static uint8_t seconds;
+  struct control_loop_stats stats;
+  struct telemetry tm;
+  struct setpoint *sp;
+
+  PROCESS_BEGIN();
+
+  //Set up the buffers and start the loop.
+  control_buffer_init(&setpoint, &setpoint_buf[0], &setpoint_buf[1], sizeof(struct setpoint));
+  control_buffer_init(&telemetry, &telemetry_buf[0], &telemetry_buf[1], sizeof(struct telemetry));
+  control_loop_init(LOOP_RATE);
+  control_loop_register(&controller_task, controller, NULL, 1);
+  control_loop_start();
+
+  etimer_set(&et, CLOCK_SECOND);
+
+  for (;;) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    //Toggle the setpoint between 200 and 600rad/s every 2 seconds.
+    if ((seconds++ & 1) == 0) {
+      sp = control_buffer_back(&setpoint);
+      sp->speed = (seconds & 2) ? 600.0f : 200.0f;
+      control_buffer_publish(&setpoint);
+    }
+
+    //Print the telemetry and the loop timing.
+    control_buffer_read(&telemetry, &tm);
+    control_loop_get_stats(&stats);
+    printf("it %lu: speed %d rad/s, voltage %d mV\n", (unsigned long) tm.iteration,
+           (int) tm.speed, (int) (tm.voltage * 1000));
+    printf("  exec %lu..%lu ns, jitter %lu ns, overruns %lu\n",
+           (unsigned long) CONTROL_LOOP_CYCLES_TO_NS(stats.exec_min),
+           (unsigned long) CONTROL_LOOP_CYCLES_TO_NS(stats.exec_max),
+           (unsigned long) CONTROL_LOOP_CYCLES_TO_NS(stats.jitter),
+           (unsigned long) stats.overruns);
+  }
+
+  PROCESS_END();
+}
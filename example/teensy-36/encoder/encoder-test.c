@@ -0,0 +1,39 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the quadrature encoder example.                                                |
+//|                                                                                                |
+//| Reads an encoder connected to pins 3 (phase A) and 4 (phase B), and prints its position and    |
+//| velocity twice per second.                                                                     |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "encoder.h"
+
+PROCESS(encoder_test, "Encoder test");
+
+AUTOSTART_PROCESSES(&encoder_test);
+
+PROCESS_THREAD(encoder_test, ev, data) {
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  //Use a moderate input filter (8 bus cycles) and estimate velocity at 1KHz.
+  encoder_init(ENCODER_1, 2, 0);
+  encoder_sampling_start(1000);
+
+  etimer_set(&et, CLOCK_SECOND / 2);
+
+  for (;;) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    printf("Position: %ld, velocity: %ld counts/s\n", (long) encoder_position(ENCODER_1),
+           (long) encoder_velocity(ENCODER_1));
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,101 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the comparator threshold example.                                              |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "cmp.h"
+
+//Include the core and power mode headers of the target.
+#if CONTIKI_TARGET_TEENSY_36
+#include "mk66.h"
+#include "mk66-smc.h"
+#else
+#include "mkl26.h"
+#include "mkl26-smc.h"
+#endif
+
+//Input on pin 11 (IN0 of CMP_0 on both boards), with the threshold at half the supply voltage. The
+//filter takes 4 samples 1us apart (at 24MHz or 60MHz bus clocks, rounded down).
+static const struct cmp_config config = {
+  .input = 0,
+  .level = 31,
+  .hysteresis = CMP_HYSTERESIS_20MV,
+  .filter_count = 4,
+#if CONTIKI_TARGET_TEENSY_36
+  .filter_period = 60,
+#else
+  .filter_period = 24,
+#endif
+  .windowed = 0,
+  .edges = CMP_EDGE_RISING | CMP_EDGE_FALLING,
+};
+
+//Idle time before sleeping.
+#define IDLE_TIME (10 * CLOCK_SECOND)
+
+PROCESS(threshold_wake, "Threshold wake");
+
+AUTOSTART_PROCESSES(&threshold_wake);
+
+//Sleeps until the input crosses the threshold. The Teensy LC enters LLS, where only the comparator
+//keeps running. The Teensy 3.6 runs in HSRUN mode, from which stop modes can't be entered, so it
+//just waits for interrupts (the system timer keeps waking it up).
+static void sleep_until_crossing() {
+  uint8_t output = cmp_output(CMP_0) ? 1 : 0;
+
+  cmp_wake_arm(CMP_0);
+
+#if CONTIKI_TARGET_TEENSY_36
+  while ((cmp_output(CMP_0) ? 1 : 0) == output)
+    __WFI();
+#else
+  SMC->PMCTRL = SMC_PMCTRL_RUNM_RUN | SMC_PMCTRL_STOPM_LLS;
+  (void) SMC->PMCTRL;
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  while ((cmp_output(CMP_0) ? 1 : 0) == output)
+    __WFI();
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+#endif
+
+  cmp_wake_disarm(CMP_0);
+}
+
+PROCESS_THREAD(threshold_wake, ev, data) {
+  static struct etimer et;
+  struct cmp_change *change;
+
+  PROCESS_BEGIN();
+
+  if (cmp_init(CMP_0, &config) != 0) {
+    printf("Can't set up the comparator\n");
+    PROCESS_EXIT();
+  }
+  printf("Input is %s the threshold\n", cmp_output(CMP_0) ? "above" : "below");
+
+  for (;;) {
+    etimer_set(&et, IDLE_TIME);
+    PROCESS_WAIT_EVENT_UNTIL(ev == cmp_event || etimer_expired(&et));
+
+    if (ev == cmp_event) {
+      change = data;
+      printf("Edges:%s%s, input is %s the threshold\n",
+             (change->edges & CMP_EDGE_RISING) ? " rising" : "",
+             (change->edges & CMP_EDGE_FALLING) ? " falling" : "",
+             change->output ? "above" : "below");
+      continue;
+    }
+
+    //Nothing happened for a while. Let the message out, then sleep until the input crosses.
+    printf("Sleeping until the input crosses the threshold\n");
+    etimer_set(&et, CLOCK_SECOND / 16);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    sleep_until_crossing();
+    printf("Woken up\n");
+  }
+
+  PROCESS_END();
+}
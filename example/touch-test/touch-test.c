@@ -0,0 +1,87 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the capacitive touch example.                                                  |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "tsi.h"
+
+//Include the core and power mode headers of the target.
+#if CONTIKI_TARGET_TEENSY_36
+#include "mk66.h"
+#include "mk66-smc.h"
+#else
+#include "mkl26.h"
+#include "mkl26-smc.h"
+#endif
+
+//Electrodes on pins 15, 16, 17 and 18 (TSI channels 13, 0, 6 and 8 on both boards).
+static const uint8_t channels[] = { 13, 0, 6, 8 };
+#define ELECTRODES (sizeof(channels) / sizeof(channels[0]))
+
+//Idle time before sleeping.
+#define IDLE_TIME (10 * CLOCK_SECOND)
+
+PROCESS(touch_test, "Touch test");
+
+AUTOSTART_PROCESSES(&touch_test);
+
+//Sleeps until electrode 0 is touched. The Teensy LC enters VLPS, where only the TSI and the LPTMR
+//keep running. The Teensy 3.6 runs in HSRUN mode, from which stop modes can't be entered, so it
+//just waits for interrupts (the system timer keeps waking it up).
+static void sleep_until_touch() {
+  tsi_wake_arm(0);
+
+#if CONTIKI_TARGET_TEENSY_36
+  while (!(tsi_touched() & 1))
+    __WFI();
+#else
+  SMC->PMCTRL = SMC_PMCTRL_RUNM_RUN | SMC_PMCTRL_STOPM_VLPS;
+  (void) SMC->PMCTRL;
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  while (!(tsi_touched() & 1))
+    __WFI();
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+#endif
+}
+
+PROCESS_THREAD(touch_test, ev, data) {
+  static struct etimer et;
+  static uint32_t touched;
+  uint8_t i;
+
+  PROCESS_BEGIN();
+
+  printf("Calibrating, don't touch the electrodes\n");
+  tsi_init(channels, ELECTRODES);
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  for (i = 0; i < ELECTRODES; i++)
+    printf("Electrode %u: baseline %u\n", i, tsi_baseline(i));
+
+  for (;;) {
+    etimer_set(&et, IDLE_TIME);
+    PROCESS_WAIT_EVENT_UNTIL(ev == tsi_event || etimer_expired(&et));
+
+    if (ev == tsi_event) {
+      touched = tsi_touched();
+      for (i = 0; i < ELECTRODES; i++)
+        printf("%c%ld ", (touched & (1 << i)) ? '*' : ' ', (long) tsi_signal(i));
+      printf("\n");
+      continue;
+    }
+
+    //Nothing happened for a while. Let the message out, then sleep until electrode 0 is touched.
+    printf("Sleeping, touch electrode 0 to wake up\n");
+    etimer_set(&et, CLOCK_SECOND / 16);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    sleep_until_touch();
+    printf("Woken up\n");
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,319 @@
+//+------------------------------------------------------------------------------------------------+
+//| Host test and benchmark for the time series compression library.                               |
+//|                                                                                                |
+//| Usage: tscomp-check [test]                                                                     |
+//|        tscomp-check bench                                                                      |
+//|                                                                                                |
+//| The test mode round trips a set of sample streams (the signals of the example plus edge cases: |
+//| irregular and wrapping timestamps, special floats, extreme integers) through blocks of several |
+//| sizes, checking that every sample comes back bit exact, then decodes corrupted blocks (build   |
+//| with sanitizers to catch out of bounds accesses, as the makefile does). The compression ratio  |
+//| of the example signals is printed against raw storage (4 bytes per timestamp plus the value).  |
+//| The bench mode measures the encoding and decoding time per sample.                             |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tscomp.h"
+#include "signals.h"
+
+#define SAMPLES       20000
+#define MAX_BLOCK     4096
+#define CORRUPTIONS   100000
+#define BENCH_SECONDS 1.0
+
+//Test streams. Values are kept as raw bits, for both formats.
+struct stream {
+  const char *name;
+  uint8_t format;
+  uint32_t timestamps[SAMPLES];
+  uint32_t values[SAMPLES];
+};
+
+static const uint16_t block_sizes[] = {3, 4, 5, 16, 64, 127, 512, MAX_BLOCK};
+
+static struct stream streams[8];
+static uint8_t stream_count;
+static uint32_t rng_state = 1;
+static int failures;
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static void fail(const char *what, const char *stream, uint32_t detail) {
+  if (failures++ < 10)
+    fprintf(stderr, "FAILED: %s, %s (%u)\n", what, stream, detail);
+}
+
+static struct stream *new_stream(const char *name, uint8_t format) {
+  struct stream *s = &streams[stream_count++];
+
+  s->name = name;
+  s->format = format;
+  return s;
+}
+
+static void make_streams() {
+  static const uint32_t special[] = {
+    0x00000000, 0x80000000, 0x7F800000, 0xFF800000, 0x7FC00000, 0x7FC00001, 0xFFFFFFFF,
+    0x00000001, 0x007FFFFF, 0x3F800000, 0x3F800001
+  };
+  struct stream *s;
+  uint32_t i;
+  float value;
+
+  s = new_stream("sensor", TSCOMP_FLOAT);
+  for (i = 0; i < SAMPLES; i++) {
+    signals_sensor(i, &s->timestamps[i], &value);
+    memcpy(&s->values[i], &value, 4);
+  }
+
+  s = new_stream("adc", TSCOMP_INT);
+  for (i = 0; i < SAMPLES; i++) {
+    s->timestamps[i] = i * SIGNALS_ADC_INTERVAL;
+    s->values[i] = signals_adc(i);
+  }
+
+  //Random floats with special values, at irregular times wrapping around 2^32.
+  s = new_stream("special floats", TSCOMP_FLOAT);
+  for (i = 0; i < SAMPLES; i++) {
+    s->timestamps[i] = i == 0 ? 0xFFFFF000 : s->timestamps[i - 1] + (rng() >> (rng() % 32));
+    s->values[i] = rng() % 4 == 0 ? special[rng() % (sizeof(special) / sizeof(special[0]))] :
+                   rng() % 2 ? rng() : s->values[i - (i > 0)] ^ (rng() & 0xFF);
+  }
+
+  //Integers jumping between the extremes, at random times (including going backwards).
+  s = new_stream("extreme integers", TSCOMP_INT);
+  for (i = 0; i < SAMPLES; i++) {
+    s->timestamps[i] = rng();
+    s->values[i] = rng() % 3 == 0 ? 0x80000000 : rng() % 2 ? 0x7FFFFFFF : rng();
+  }
+
+  //Counter with a steady rate.
+  s = new_stream("counter", TSCOMP_INT);
+  for (i = 0; i < SAMPLES; i++) {
+    s->timestamps[i] = 5000 + 250 * i;
+    s->values[i] = 7 * i;
+  }
+}
+
+//Encodes a stream into consecutive blocks of the given size, decoding and checking each one.
+//Returns the total size of the blocks, or 0 on failure.
+static uint32_t round_trip(const struct stream *s, uint16_t size) {
+  static uint8_t block[MAX_BLOCK + 1];              //Plus a guard byte
+  struct tscomp_encoder e;
+  struct tscomp_decoder d;
+  uint32_t next = 0, first, total = 0, timestamp, bits, i;
+  uint16_t length;
+  int32_t value;
+  float real;
+  int result;
+
+  while (next < SAMPLES) {
+    first = next;
+    memset(block, 0xA5, sizeof(block));
+    tscomp_encoder_init(&e, block, size, s->format);
+
+    while (next < SAMPLES) {
+      if (s->format == TSCOMP_FLOAT) {
+        memcpy(&real, &s->values[next], 4);
+        result = tscomp_put_float(&e, s->timestamps[next], real);
+      }
+      else
+        result = tscomp_put_int(&e, s->timestamps[next], s->values[next]);
+
+      if (result != TSCOMP_OK)
+        break;
+      next++;
+    }
+
+    length = tscomp_finish(&e);
+    if (length > size || block[size] != 0xA5) {
+      fail("block overrun", s->name, size);
+      return 0;
+    }
+
+    //Blocks too small for a single sample can't make progress.
+    if (next == first) {
+      if (size >= 16)
+        fail("no progress", s->name, size);
+      return 0;
+    }
+
+    if (tscomp_decoder_init(&d, block, length) != TSCOMP_OK) {
+      fail("header", s->name, size);
+      return 0;
+    }
+
+    for (i = first; i < next; i++) {
+      if (s->format == TSCOMP_FLOAT) {
+        result = tscomp_get_float(&d, &timestamp, &real);
+        memcpy(&bits, &real, 4);
+      }
+      else {
+        result = tscomp_get_int(&d, &timestamp, &value);
+        bits = value;
+      }
+
+      if (result != TSCOMP_OK || timestamp != s->timestamps[i] || bits != s->values[i]) {
+        fail("sample mismatch", s->name, i);
+        return 0;
+      }
+    }
+
+    if ((s->format == TSCOMP_FLOAT ? tscomp_get_float(&d, &timestamp, &real) :
+         tscomp_get_int(&d, &timestamp, &value)) != TSCOMP_END)
+      fail("block end", s->name, size);
+
+    total += length;
+  }
+
+  return total;
+}
+
+static void test_round_trips() {
+  uint32_t total, raw;
+  uint8_t i, j;
+
+  for (i = 0; i < stream_count; i++) {
+    for (j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++) {
+      total = round_trip(&streams[i], block_sizes[j]);
+
+      //Report the ratios of the example signals with SD card sector sized blocks.
+      if (block_sizes[j] == 512 && i < 2 && total > 0) {
+        raw = SAMPLES * (4 + (streams[i].format == TSCOMP_FLOAT ? 4 : 2));
+        printf("%s: %u samples, %u bytes (%.2f bits/sample), %.1fx smaller than raw\n",
+               streams[i].name, SAMPLES, total, total * 8.0 / SAMPLES, (double) raw / total);
+      }
+    }
+  }
+
+  printf("Round trips: %s\n", failures ? "FAILED" : "OK");
+}
+
+//Decodes damaged blocks, which must fail or end cleanly, never reading past their end.
+static void test_corruption() {
+  static uint8_t block[512];
+  struct tscomp_encoder e;
+  struct tscomp_decoder d;
+  const struct stream *s;
+  uint32_t i, j, timestamp, start;
+  uint16_t length;
+  uint8_t *copy;
+  int32_t value;
+  float real;
+  int result;
+  int before = failures;
+
+  for (i = 0; i < CORRUPTIONS; i++) {
+    s = &streams[i % stream_count];
+    start = rng() % (SAMPLES - 200);
+    tscomp_encoder_init(&e, block, sizeof(block), s->format);
+    for (j = start; j < SAMPLES; j++) {
+      memcpy(&real, &s->values[j], 4);
+      if ((s->format == TSCOMP_FLOAT ? tscomp_put_float(&e, s->timestamps[j], real) :
+           tscomp_put_int(&e, s->timestamps[j], s->values[j])) != TSCOMP_OK)
+        break;
+    }
+    length = tscomp_finish(&e);
+
+    //Flip bits, then maybe truncate.
+    for (j = 1 + rng() % 4; j > 0; j--)
+      block[rng() % length] ^= 1 << (rng() % 8);
+    if (rng() % 2)
+      length = rng() % (length + 1);
+
+    //Exact size heap copy, so the sanitizer catches any read past the end.
+    copy = malloc(length ? length : 1);
+    memcpy(copy, block, length);
+
+    if (tscomp_decoder_init(&d, copy, length) == TSCOMP_OK) {
+      for (j = 0; j < 0x10000; j++) {
+        if (d.format == TSCOMP_FLOAT)
+          result = tscomp_get_float(&d, &timestamp, &real);
+        else
+          result = tscomp_get_int(&d, &timestamp, &value);
+        if (result != TSCOMP_OK)
+          break;
+      }
+      if (j == 0x10000)
+        fail("decoding never ended", s->name, i);
+    }
+
+    free(copy);
+  }
+
+  printf("Corruption: %s (%u blocks)\n", failures > before ? "FAILED" : "OK", CORRUPTIONS);
+}
+
+static void bench() {
+  static uint8_t block[512];
+  const struct stream *s;
+  struct tscomp_encoder e;
+  struct tscomp_decoder d;
+  uint32_t samples, timestamp, i;
+  uint16_t length;
+  double start, elapsed;
+  int32_t value;
+  float real;
+  uint8_t j;
+
+  for (j = 0; j < 2; j++) {
+    s = &streams[j];
+
+    samples = 0;
+    start = now();
+    do {
+      tscomp_encoder_init(&e, block, sizeof(block), s->format);
+      for (i = 0; i < SAMPLES; i++) {
+        memcpy(&real, &s->values[i], 4);
+        if ((s->format == TSCOMP_FLOAT ? tscomp_put_float(&e, s->timestamps[i], real) :
+             tscomp_put_int(&e, s->timestamps[i], s->values[i])) != TSCOMP_OK)
+          break;
+      }
+      samples += i;
+    } while ((elapsed = now() - start) < BENCH_SECONDS);
+    printf("%s encode: %.1f ns/sample\n", s->name, elapsed / samples * 1e9);
+
+    length = tscomp_finish(&e);
+    samples = 0;
+    start = now();
+    do {
+      tscomp_decoder_init(&d, block, length);
+      while ((s->format == TSCOMP_FLOAT ? tscomp_get_float(&d, &timestamp, &real) :
+              tscomp_get_int(&d, &timestamp, &value)) == TSCOMP_OK)
+        samples++;
+    } while ((elapsed = now() - start) < BENCH_SECONDS);
+    printf("%s decode: %.1f ns/sample\n", s->name, elapsed / samples * 1e9);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  make_streams();
+
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    bench();
+    return 0;
+  }
+
+  test_round_trips();
+  test_corruption();
+
+  return failures ? 1 : 0;
+}
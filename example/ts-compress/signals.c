@@ -0,0 +1,55 @@
+//+------------------------------------------------------------------------------------------------+
+//| Test signals of the time series compression example.                                           |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include "signals.h"
+
+//Quarter wave sine table (0 to 90 degrees in 16 steps), in units of 1/32768.
+static const uint16_t quarter_sine[17] = {
+  0, 3212, 6393, 9512, 12540, 15447, 18205, 20788, 23170, 25330, 27246, 28899, 30274, 31357, 32138,
+  32610, 32768
+};
+
+//Returns pseudo random bits for sample n (a hash, so signals can be generated in any order).
+static uint32_t noise(uint32_t n) {
+  n ^= n >> 16;
+  n *= 0x7FEB352D;
+  n ^= n >> 15;
+  n *= 0x846CA68B;
+  n ^= n >> 16;
+  return n;
+}
+
+//Returns the sine of phase (64 steps per turn), in units of 1/32768.
+static int32_t sine(uint32_t phase) {
+  phase &= 63;
+
+  if (phase < 16)
+    return quarter_sine[phase];
+  if (phase < 32)
+    return quarter_sine[32 - phase];
+  if (phase < 48)
+    return -quarter_sine[phase - 32];
+  return -quarter_sine[64 - phase];
+}
+
+//Temperature sensor read once a second (timestamps in milliseconds, with a few milliseconds of
+//jitter), with a resolution of 1/16 of a degree and a daily swing of a few degrees.
+void signals_sensor(uint32_t n, uint32_t *timestamp, float *value) {
+  int32_t sixteenths = 22 * 16 + sine(n / 1350) * 4 * 16 / 32768 + (int32_t) (noise(n) % 3) - 1;
+
+  *timestamp = 1000 * n + noise(n + 0x10000) % 4;
+  *value = sixteenths / 16.0f;
+}
+
+//12 bit ADC reading a 50Hz sine of half the full scale with 2 LSBs of noise, sampled at 1kHz. The
+//sine is stepped from a table, so it's interpolated linearly.
+uint16_t signals_adc(uint32_t n) {
+  uint32_t phase = n * 64 * 2 / 40;
+  uint32_t fraction = (n * 64 * 2) % 40;
+  int32_t level = sine(phase) + (sine(phase + 1) - sine(phase)) * (int32_t) fraction / 40;
+
+  return 2048 + level * 1024 / 32768 + (int32_t) (noise(n) % 5) - 2;
+}
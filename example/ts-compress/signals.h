@@ -0,0 +1,21 @@
+//+------------------------------------------------------------------------------------------------+
+//| Test signals of the time series compression example.                                           |
+//|                                                                                                |
+//| Deterministic stand-ins for real sensors, shared by the firmware and the host test program so  |
+//| both report the same compression ratios.                                                       |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#ifndef SIGNALS_H_
+#define SIGNALS_H_
+
+#include <stdint.h>
+
+//Sample interval of the ADC signal, in microseconds.
+#define SIGNALS_ADC_INTERVAL 1000
+
+void signals_sensor(uint32_t n, uint32_t *timestamp, float *value);
+uint16_t signals_adc(uint32_t n);
+
+#endif //SIGNALS_H_
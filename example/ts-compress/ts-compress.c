@@ -0,0 +1,188 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the time series compression example.                                           |
+//|                                                                                                |
+//| Compresses an hour of readings of a temperature sensor and about ten seconds of a 1kHz ADC     |
+//| signal into SD card sector sized blocks, the ADC one fed a DMA transfer worth of samples at a  |
+//| time as a completion callback would. Every finished block is decoded back and checked, and the |
+//| size, compression ratio and encoding cost in core cycles are printed for each signal.          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "contiki.h"
+#include "tscomp.h"
+#include "signals.h"
+
+//Include the core header of the target, which provides access to the SysTick timer.
+#if CONTIKI_TARGET_TEENSY_36
+#include "mk66.h"
+#elif CONTIKI_TARGET_TEENSY_32
+#include "mk20.h"
+#else
+#include "mkl26.h"
+#endif
+
+#define BLOCK_SIZE      512
+#define SENSOR_SAMPLES  3600
+#define ADC_TRANSFER    64        //Samples per DMA transfer
+#define ADC_SAMPLES     (160 * ADC_TRANSFER)
+
+//Compression results of a signal.
+struct result {
+  uint32_t samples;
+  uint32_t blocks;
+  uint32_t bytes;
+  uint32_t cycles;
+  uint32_t errors;
+};
+
+static uint8_t block[BLOCK_SIZE];
+static uint16_t transfer[ADC_TRANSFER];
+static struct tscomp_encoder encoder;
+
+PROCESS(ts_compress, "Time series compression");
+
+AUTOSTART_PROCESSES(&ts_compress);
+
+//Starts the SysTick timer as a free running 24 bit down counter clocked by the core clock.
+static void cycle_counter_init() {
+  SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+static uint32_t cycle_counter_read() {
+  return SysTick->VAL;
+}
+
+//Returns the cycles elapsed since a previous counter read. Blocks must take less than 2^24 cycles.
+static uint32_t cycles_since(uint32_t start) {
+  return (start - cycle_counter_read()) & SysTick_LOAD_RELOAD_Msk;
+}
+
+//Finishes the current block and checks it, as a stand in for writing it to storage. The first
+//sample is the index of the first one in the block.
+static void store_block(struct result *r, uint32_t first) {
+  struct tscomp_decoder d;
+  uint32_t timestamp, expected_timestamp, i;
+  uint16_t length = tscomp_finish(&encoder);
+  float value, expected_value;
+  int32_t sample;
+
+  r->blocks++;
+  r->bytes += length;
+
+  if (tscomp_decoder_init(&d, block, length) != TSCOMP_OK) {
+    r->errors++;
+    return;
+  }
+
+  for (i = first; i < first + d.count; i++) {
+    if (encoder.format == TSCOMP_FLOAT) {
+      signals_sensor(i, &expected_timestamp, &expected_value);
+      if (tscomp_get_float(&d, &timestamp, &value) != TSCOMP_OK ||
+          timestamp != expected_timestamp || value != expected_value)
+        r->errors++;
+    }
+    else if (tscomp_get_int(&d, &timestamp, &sample) != TSCOMP_OK ||
+             timestamp != i * SIGNALS_ADC_INTERVAL || sample != signals_adc(i))
+      r->errors++;
+  }
+}
+
+static void compress_sensor(struct result *r) {
+  uint32_t timestamp, first = 0, start, i;
+  float value;
+
+  tscomp_encoder_init(&encoder, block, sizeof(block), TSCOMP_FLOAT);
+
+  for (i = 0; i < SENSOR_SAMPLES; i++) {
+    signals_sensor(i, &timestamp, &value);
+
+    start = cycle_counter_read();
+    if (tscomp_put_float(&encoder, timestamp, value) != TSCOMP_OK) {
+      r->cycles += cycles_since(start);
+      store_block(r, first);
+      first = i;
+
+      start = cycle_counter_read();
+      tscomp_encoder_init(&encoder, block, sizeof(block), TSCOMP_FLOAT);
+      tscomp_put_float(&encoder, timestamp, value);
+    }
+    r->cycles += cycles_since(start);
+  }
+
+  store_block(r, first);
+  r->samples = SENSOR_SAMPLES;
+}
+
+static void compress_adc(struct result *r) {
+  uint32_t first = 0, start, i, j;
+  uint16_t done;
+
+  tscomp_encoder_init(&encoder, block, sizeof(block), TSCOMP_INT);
+
+  for (i = 0; i < ADC_SAMPLES; i += ADC_TRANSFER) {
+    for (j = 0; j < ADC_TRANSFER; j++)
+      transfer[j] = signals_adc(i + j);
+
+    //What a DMA completion callback would do: append the transfer, starting new blocks as the
+    //current one fills up.
+    start = cycle_counter_read();
+    done = tscomp_put_samples(&encoder, i * SIGNALS_ADC_INTERVAL, SIGNALS_ADC_INTERVAL, transfer,
+                              ADC_TRANSFER);
+    r->cycles += cycles_since(start);
+
+    while (done < ADC_TRANSFER) {
+      store_block(r, first);
+      first = i + done;
+
+      start = cycle_counter_read();
+      tscomp_encoder_init(&encoder, block, sizeof(block), TSCOMP_INT);
+      done += tscomp_put_samples(&encoder, first * SIGNALS_ADC_INTERVAL, SIGNALS_ADC_INTERVAL,
+                                 transfer + done, ADC_TRANSFER - done);
+      r->cycles += cycles_since(start);
+    }
+  }
+
+  store_block(r, first);
+  r->samples = ADC_SAMPLES;
+}
+
+//Prints the results of a signal. Raw storage takes 4 bytes per timestamp plus the value.
+static void report(const char *name, const struct result *r, uint8_t value_size) {
+  uint32_t raw = r->samples * (4 + value_size);
+  uint32_t ratio_x10 = raw * 10 / r->bytes;
+
+  printf("%s: %lu samples in %lu blocks, %lu bytes (%lu.%lux smaller), %lu cycles/sample, %s\n",
+         name, (unsigned long) r->samples, (unsigned long) r->blocks, (unsigned long) r->bytes,
+         (unsigned long) (ratio_x10 / 10), (unsigned long) (ratio_x10 % 10),
+         (unsigned long) (r->cycles / r->samples), r->errors == 0 ? "OK" : "FAILED");
+}
+
+PROCESS_THREAD(ts_compress, ev, data) {
+  static struct etimer et;
+  static struct result sensor, adc;
+
+  PROCESS_BEGIN();
+
+  cycle_counter_init();
+
+  while (1) {
+    memset(&sensor, 0, sizeof(sensor));
+    memset(&adc, 0, sizeof(adc));
+
+    compress_sensor(&sensor);
+    report("Sensor", &sensor, 4);
+    compress_adc(&adc);
+    report("ADC", &adc, 2);
+
+    etimer_set(&et, 10 * CLOCK_SECOND);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+
+  PROCESS_END();
+}
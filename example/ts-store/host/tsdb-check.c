@@ -0,0 +1,491 @@
+//+------------------------------------------------------------------------------------------------+
+//| Host test and benchmark for the time series store.                                             |
+//|                                                                                                |
+//| Usage: tsdb-check [test]                                                                       |
+//|        tsdb-check bench                                                                        |
+//|                                                                                                |
+//| The store runs on a RAM block device. The test mode appends a long signal (wrapping the data   |
+//| ring many times, with syncs and remounts along the way) and checks random range queries and    |
+//| the rollups against a brute force computation over every sample appended, along with the       |
+//| number of blocks each query reads. Then it checks recovery after a reset without sync,         |
+//| reformatting, argument errors and queries over damaged blocks (build with sanitizers to catch  |
+//| out of bounds accesses, as the makefile does). The bench mode measures the append time per     |
+//| sample and the query cost as the history grows.                                                |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tsdb.h"
+
+#define DEVICE_START    3
+#define DEVICE_BLOCKS   120
+#define SAMPLES         200000
+#define MAX_SAMPLES     (SAMPLES + 10000)
+#define CHECKPOINT      10000
+#define QUERIES         200
+#define BENCH_SECONDS   1.0
+
+//Store geometry: 64 data blocks (about 7500 samples), 10 minutes of seconds, 2 hours of minutes
+//and 2 days of hours, in milliseconds.
+static const struct tsdb_config config = {1000, 64, {600, 120, 48}};
+
+static uint32_t device_data[DEVICE_BLOCKS][TSDB_BLOCK_SIZE / 4];
+static uint8_t device_failing;
+
+static uint32_t timestamps[MAX_SAMPLES];
+static float values[MAX_SAMPLES];
+static uint32_t sample_count;
+
+static struct tsdb db;
+static struct tsdb_cursor cursor;
+static uint32_t rng_state = 1;
+static int failures;
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static void fail(const char *what, uint32_t detail) {
+  if (failures++ < 10)
+    fprintf(stderr, "FAILED: %s (%u)\n", what, detail);
+}
+
+//--------------------------------------------------------------------------------------------------
+//RAM block device.
+
+static int ram_read(uint32_t block, void *buffer, uint16_t count) {
+  if (device_failing || block < DEVICE_START || block + count > DEVICE_START + DEVICE_BLOCKS)
+    return -1;
+
+  memcpy(buffer, device_data[block - DEVICE_START], count * TSDB_BLOCK_SIZE);
+  return 0;
+}
+
+static int ram_write(uint32_t block, const void *buffer, uint16_t count) {
+  if (device_failing || block < DEVICE_START || block + count > DEVICE_START + DEVICE_BLOCKS)
+    return -1;
+
+  memcpy(device_data[block - DEVICE_START], buffer, count * TSDB_BLOCK_SIZE);
+  return 0;
+}
+
+static const struct tsdb_device device = {ram_read, ram_write, DEVICE_START, DEVICE_BLOCKS};
+
+//--------------------------------------------------------------------------------------------------
+//Signal: a slow wave plus noise, sampled every 20 to 180 ms, with some repeated timestamps.
+
+static void make_sample(uint32_t *timestamp, float *value) {
+  static uint32_t t = 1000000;
+
+  if (rng() % 50 != 0)
+    t += 20 + rng() % 161;
+
+  *timestamp = t;
+  *value = roundf((20.0f + 5.0f * sinf(t * 1e-6f) + (rng() % 1000) * 0.002f) * 100) / 100;
+}
+
+static int append(uint32_t timestamp, float value) {
+  int result = tsdb_append(&db, timestamp, value);
+
+  if (result == TSDB_OK) {
+    timestamps[sample_count] = timestamp;
+    values[sample_count] = value;
+    sample_count++;
+  }
+
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+//Queries.
+
+//Returns the index of the first sample kept by the store (older ones were overwritten), checking
+//that a query of everything returns a suffix of the samples appended. After a reset without sync,
+//the newest samples may be missing too (truncated), and the ones kept become the samples appended.
+static uint32_t first_kept(uint8_t truncated) {
+  uint32_t timestamp, first, i;
+  float value;
+  int result;
+
+  tsdb_query(&db, &cursor, 0, UINT32_MAX, -INFINITY, INFINITY);
+  result = tsdb_next(&cursor, &timestamp, &value);
+  if (result != TSDB_OK) {
+    fail("empty store", result);
+    return sample_count;
+  }
+
+  //Find the first sample among the appended ones (timestamps may repeat).
+  for (first = 0; first < sample_count; first++) {
+    if (timestamps[first] == timestamp && values[first] == value)
+      break;
+  }
+
+  for (i = first + 1; i < sample_count; i++) {
+    result = tsdb_next(&cursor, &timestamp, &value);
+    if (result == TSDB_END && truncated)
+      break;
+    if (result != TSDB_OK || timestamp != timestamps[i] || value != values[i]) {
+      fail("full query", i);
+      return sample_count;
+    }
+  }
+
+  if (i == sample_count && tsdb_next(&cursor, &timestamp, &value) != TSDB_END)
+    fail("full query end", sample_count);
+
+  sample_count = i;
+
+  return first;
+}
+
+//Runs a query, checking its result against the samples from the given one. Returns the blocks
+//read.
+static uint32_t check_query(uint32_t first, uint32_t from, uint32_t to, float min, float max) {
+  uint32_t reads = db.reads, timestamp, i;
+  float value;
+  int result;
+
+  result = tsdb_query(&db, &cursor, from, to, min, max);
+  if (result != TSDB_OK)
+    fail("query", result);
+
+  for (i = first; i < sample_count && timestamps[i] <= to; i++) {
+    if (timestamps[i] < from || values[i] < min || values[i] > max)
+      continue;
+
+    result = tsdb_next(&cursor, &timestamp, &value);
+    if (result != TSDB_OK || timestamp != timestamps[i] || value != values[i]) {
+      fail("query sample", i);
+      return 0;
+    }
+  }
+
+  if (tsdb_next(&cursor, &timestamp, &value) != TSDB_END)
+    fail("query end", from);
+
+  return db.reads - reads;
+}
+
+//Runs random queries over the samples kept. Returns the most blocks read by a query spanning a
+//few seconds.
+static uint32_t check_queries() {
+  uint32_t first = first_kept(0), span, from, to, reads, most = 0, i;
+  float min, max;
+
+  if (first >= sample_count)
+    return 0;
+
+  span = timestamps[sample_count - 1] - timestamps[first];
+  for (i = 0; i < QUERIES; i++) {
+    from = timestamps[first] - 1000 + rng() % (span + 2000);
+    min = -INFINITY;
+    max = INFINITY;
+
+    switch (i % 4) {
+      case 0:     //A few seconds
+        to = from + rng() % 5000;
+        break;
+
+      case 1:     //A few seconds, from a sample on
+        from = timestamps[first + rng() % (sample_count - first)];
+        to = from + rng() % 5000;
+        break;
+
+      case 2:     //Anything, within a value range
+        to = from + rng() % (span + 1000);
+        min = 18.0f + (rng() % 1000) * 0.01f;
+        max = min + (rng() % 200) * 0.01f;
+        break;
+
+      default:    //Anything
+        to = from + rng() % (span + 1000);
+        break;
+    }
+
+    reads = check_query(first, from, to, min, max);
+    if (i % 4 < 2 && reads > most)
+      most = reads;
+  }
+
+  return most;
+}
+
+//Checks the rollups of the periods kept by a level, from the last one back.
+static void check_rollups(uint8_t level, uint32_t periods) {
+  static struct tsdb_rollup records[600];
+  uint32_t ticks = config.ticks_per_second * (level == TSDB_SECOND ? 1 : level == TSDB_MINUTE ?
+                                              60 : 3600);
+  uint32_t last = timestamps[sample_count - 1] / ticks, period, i, j = sample_count;
+  struct tsdb_rollup expected;
+  int result;
+
+  if (periods > last + 1)
+    periods = last + 1;
+
+  result = tsdb_rollups(&db, level, (last - periods + 1) * ticks, records, periods);
+  if (result != (int) periods) {
+    fail("rollups", result);
+    return;
+  }
+
+  for (i = periods; i > 0; i--) {
+    period = last - periods + i;
+
+    //Samples of the period, in order.
+    while (j > 0 && timestamps[j - 1] / ticks >= period)
+      j--;
+    memset(&expected, 0, sizeof(expected));
+    while (j + expected.count < sample_count && timestamps[j + expected.count] / ticks == period) {
+      if (expected.count == 0 || values[j + expected.count] < expected.min)
+        expected.min = values[j + expected.count];
+      if (expected.count == 0 || values[j + expected.count] > expected.max)
+        expected.max = values[j + expected.count];
+      expected.sum += values[j + expected.count];
+      expected.count++;
+    }
+
+    if (records[i - 1].period != period || records[i - 1].count != expected.count ||
+        (expected.count > 0 && (records[i - 1].min != expected.min ||
+                                records[i - 1].max != expected.max ||
+                                records[i - 1].sum != expected.sum))) {
+      fail("rollup", period);
+      return;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//Tests.
+
+//Appends the signal, syncing and remounting along the way.
+static void test_history() {
+  uint32_t timestamp, tag, reads, most = 0, i;
+  float value;
+  int before = failures;
+
+  memset(device_data, 0xFF, sizeof(device_data));
+  if (tsdb_mount(&db, &device) != TSDB_ERR_FORMAT)
+    fail("mount of blank device", 0);
+  if (tsdb_format(&db, &device, &config) != TSDB_OK)
+    fail("format", 0);
+  tag = db.tag;
+
+  for (i = 0; i < SAMPLES; i++) {
+    make_sample(&timestamp, &value);
+    if (append(timestamp, value) != TSDB_OK)
+      fail("append", i);
+
+    if (i % 997 == 0)
+      tsdb_sync(&db);
+
+    //Reset, resuming from the last sync.
+    if (i % 23456 == 0) {
+      tsdb_sync(&db);
+      if (tsdb_mount(&db, &device) != TSDB_OK || db.tag != tag || db.last != timestamp)
+        fail("remount", i);
+    }
+
+    if ((i + 1) % CHECKPOINT == 0) {
+      reads = check_queries();
+      if (reads > most)
+        most = reads;
+    }
+  }
+
+  if (append(timestamp - 1, value) != TSDB_ERR_ORDER)
+    fail("order", 0);
+
+  //Rollups are checked as kept in RAM, then as stored.
+  check_rollups(TSDB_SECOND, config.rollups[TSDB_SECOND]);
+  check_rollups(TSDB_MINUTE, config.rollups[TSDB_MINUTE]);
+  check_rollups(TSDB_HOUR, config.rollups[TSDB_HOUR]);
+  tsdb_sync(&db);
+  tsdb_mount(&db, &device);
+  check_rollups(TSDB_SECOND, config.rollups[TSDB_SECOND]);
+  check_rollups(TSDB_MINUTE, config.rollups[TSDB_MINUTE]);
+  check_rollups(TSDB_HOUR, config.rollups[TSDB_HOUR]);
+
+  //Short queries read the rollup block, a few index blocks and the data blocks they span.
+  if (most > 8)
+    fail("query reads", most);
+
+  printf("History: %s (%u samples over %u s, %u kept, at most %u reads per short query)\n",
+         failures > before ? "FAILED" : "OK", SAMPLES,
+         (timestamps[SAMPLES - 1] - timestamps[0]) / 1000, sample_count - first_kept(0), most);
+}
+
+//Resets without syncing, which loses the samples of the open data block since it was last written.
+static void test_recovery() {
+  uint32_t synced, timestamp, i;
+  float value;
+  int before = failures;
+
+  tsdb_sync(&db);
+  synced = sample_count;
+  for (i = 0; i < 1000; i++) {
+    make_sample(&timestamp, &value);
+    append(timestamp, value);
+  }
+
+  if (tsdb_mount(&db, &device) != TSDB_OK)
+    fail("mount", 0);
+
+  //The samples kept are the ones written, which include the synced ones.
+  i = sample_count;
+  first_kept(1);
+  if (sample_count < synced || sample_count == i || db.last != timestamps[sample_count - 1])
+    fail("recovery", sample_count);
+
+  //Appending goes on.
+  for (i = 0; i < 1000; i++) {
+    make_sample(&timestamp, &value);
+    if (append(timestamp, value) != TSDB_OK)
+      fail("append after recovery", i);
+  }
+  check_queries();
+
+  printf("Recovery: %s\n", failures > before ? "FAILED" : "OK");
+}
+
+static void test_errors() {
+  struct tsdb_config bad = config;
+  struct tsdb_rollup record;
+  uint32_t timestamp, tag = db.tag;
+  float value;
+  int before = failures;
+
+  //Reformatting discards everything.
+  if (tsdb_format(&db, &device, &config) != TSDB_OK || db.tag != tag + 1)
+    fail("reformat", db.tag);
+  tsdb_query(&db, &cursor, 0, UINT32_MAX, -INFINITY, INFINITY);
+  if (tsdb_next(&cursor, &timestamp, &value) != TSDB_END)
+    fail("reformatted query", 0);
+  if (tsdb_rollups(&db, TSDB_SECOND, timestamps[sample_count - 1], &record, 1) != 1 ||
+      record.count != 0)
+    fail("reformatted rollup", record.count);
+  if (tsdb_rollups(&db, TSDB_LEVELS, 0, &record, 1) != TSDB_ERR_RANGE)
+    fail("rollup level", 0);
+
+  bad.data_blocks = DEVICE_BLOCKS;
+  if (tsdb_format(&db, &device, &bad) != TSDB_ERR_RANGE)
+    fail("oversized format", 0);
+  bad = config;
+  bad.rollups[TSDB_HOUR] = 0;
+  if (tsdb_format(&db, &device, &bad) != TSDB_ERR_RANGE)
+    fail("empty rollup format", 0);
+
+  device_failing = 1;
+  if (tsdb_mount(&db, &device) != TSDB_ERR_IO)
+    fail("failing mount", 0);
+  device_failing = 0;
+
+  printf("Errors: %s\n", failures > before ? "FAILED" : "OK");
+}
+
+//Queries a store with damaged data and index blocks, which must end, never reading past a block.
+static void test_corruption() {
+  uint32_t timestamp, block, i, j;
+  float value;
+  int result;
+  int before = failures;
+
+  for (i = 0; i < 100; i++) {
+    tsdb_format(&db, &device, &config);
+    sample_count = 0;
+    for (j = 0; j < 20000; j++) {
+      make_sample(&timestamp, &value);
+      append(timestamp, value);
+    }
+    tsdb_sync(&db);
+
+    for (j = 1 + rng() % 8; j > 0; j--) {
+      block = db.index_start + rng() % (db.data_start + config.data_blocks - db.index_start);
+      ((uint8_t *) device_data[block])[rng() % TSDB_BLOCK_SIZE] ^= 1 << (rng() % 8);
+    }
+
+    if (tsdb_mount(&db, &device) != TSDB_OK)
+      continue;
+
+    tsdb_query(&db, &cursor, 0, UINT32_MAX, -INFINITY, INFINITY);
+    for (j = 0; j < 10 * sample_count; j++) {
+      result = tsdb_next(&cursor, &timestamp, &value);
+      if (result != TSDB_OK && result != TSDB_ERR_CORRUPT)
+        break;
+    }
+    if (j == 10 * sample_count)
+      fail("query never ended", i);
+  }
+
+  printf("Corruption: %s\n", failures > before ? "FAILED" : "OK");
+}
+
+//--------------------------------------------------------------------------------------------------
+//Benchmark.
+
+static void bench() {
+  uint32_t timestamp, samples = 0, queries, reads, first, i;
+  double start, elapsed;
+  float value;
+
+  memset(device_data, 0xFF, sizeof(device_data));
+  tsdb_format(&db, &device, &config);
+
+  start = now();
+  do {
+    for (i = 0; i < 1000; i++) {
+      make_sample(&timestamp, &value);
+      tsdb_append(&db, timestamp, value);
+    }
+    samples += i;
+  } while ((elapsed = now() - start) < BENCH_SECONDS);
+  printf("Append: %.1f ns/sample, %.2f block writes per 1000 samples\n",
+         elapsed / samples * 1e9, db.writes * 1000.0 / samples);
+
+  //Queries of a second of the kept history, as it grows.
+  tsdb_format(&db, &device, &config);
+  sample_count = 0;
+  for (i = 1; i <= 100000; i++) {
+    make_sample(&timestamp, &value);
+    append(timestamp, value);
+
+    if (i == 1000 || i == 10000 || i == 100000) {
+      first = first_kept(0);
+      reads = 0;
+      for (queries = 0; queries < 1000; queries++) {
+        timestamp = timestamps[first + rng() % (sample_count - first)];
+        reads += check_query(first, timestamp, timestamp + 999, -INFINITY, INFINITY);
+      }
+      printf("History of %u samples: %.2f reads per 1 s query\n", i, (double) reads / queries);
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    bench();
+    return failures ? 1 : 0;
+  }
+
+  test_history();
+  test_recovery();
+  test_errors();
+  test_corruption();
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the time series store example.                                                 |
+//|                                                                                                |
+//| Keeps a store at the end of the SD card and appends a made up sensor reading to it 10 times a  |
+//| second, syncing it every 10 seconds. After every sync, the last minute of raw samples and the  |
+//| minute rollups of the last hour are queried, and their results printed along with the number   |
+//| of blocks each query read from the card (which doesn't grow with the history stored).          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "contiki.h"
+#include "lib/random.h"
+#include "sdcard.h"
+#include "tsdb.h"
+
+//Blocks taken from the end of the card.
+#define REGION_BLOCKS 4096
+
+//Timestamps are clock ticks. The data ring holds about 7 hours of samples, and the rollups an hour
+//of seconds, a day of minutes and a month of hours.
+static const struct tsdb_config config = {CLOCK_SECOND, 2048, {3600, 1440, 720}};
+
+static struct tsdb_device device = {sdcard_read, sdcard_write, 0, REGION_BLOCKS};
+static struct tsdb db;
+static struct tsdb_cursor cursor;
+static struct tsdb_rollup minutes[60];
+
+//The board has no calendar, so time goes on from the last sample stored.
+static uint32_t time_base;
+
+PROCESS(ts_store, "Time series store");
+
+AUTOSTART_PROCESSES(&ts_store);
+
+static uint32_t now() {
+  return time_base + clock_time();
+}
+
+//Returns the time some ticks ago, or the start of time.
+static uint32_t ago(uint32_t ticks) {
+  return now() > ticks ? now() - ticks : 0;
+}
+
+//Makes up a temperature reading that changes over time, in degrees.
+static float sample() {
+  uint32_t phase = clock_seconds() % 600;
+
+  return (2150 + (phase < 300 ? phase : 600 - phase) * 2 + (int) (random_rand() % 21) - 10) /
+         100.0f;
+}
+
+//Prints a value with two decimals.
+static void print_value(const char *name, float value) {
+  long hundredths = lroundf(value * 100);
+
+  printf(" %s %s%ld.%02ld", name, hundredths < 0 ? "-" : "", labs(hundredths) / 100,
+         labs(hundredths) % 100);
+}
+
+static void query_last_minute() {
+  uint32_t reads = db.reads, count = 0, timestamp;
+  float value, min = INFINITY, max = -INFINITY;
+  int result;
+
+  result = tsdb_query(&db, &cursor, ago(60 * CLOCK_SECOND), now(), -INFINITY, INFINITY);
+  while (result == TSDB_OK && (result = tsdb_next(&cursor, &timestamp, &value)) == TSDB_OK) {
+    if (value < min)
+      min = value;
+    if (value > max)
+      max = value;
+    count++;
+  }
+
+  printf("Last minute: %lu samples", (unsigned long) count);
+  if (count > 0) {
+    print_value("min", min);
+    print_value("max", max);
+  }
+  printf(", %lu blocks read%s\n", (unsigned long) (db.reads - reads),
+         result == TSDB_END ? "" : ", error");
+}
+
+static void query_last_hour() {
+  uint32_t reads = db.reads, count = 0, i;
+  float sum = 0;
+  int result;
+
+  result = tsdb_rollups(&db, TSDB_MINUTE, ago(59 * 60 * CLOCK_SECOND), minutes, 60);
+  for (i = 0; i < 60 && result > 0; i++) {
+    count += minutes[i].count;
+    sum += minutes[i].sum;
+  }
+
+  printf("Last hour: %lu samples", (unsigned long) count);
+  if (count > 0)
+    print_value("average", sum / count);
+  printf(", %lu blocks read%s\n", (unsigned long) (db.reads - reads), result > 0 ? "" : ", error");
+}
+
+PROCESS_THREAD(ts_store, ev, data) {
+  static struct etimer et;
+  static uint16_t samples;
+  int result;
+
+  PROCESS_BEGIN();
+
+  result = sdcard_init();
+  if (result != SDCARD_OK || sdcard_blocks() < REGION_BLOCKS) {
+    printf("No card (error %d)\n", result);
+    PROCESS_EXIT();
+  }
+
+  //Open the store, or create it the first time.
+  device.start = sdcard_blocks() - REGION_BLOCKS;
+  result = tsdb_mount(&db, &device);
+  if (result == TSDB_ERR_FORMAT) {
+    printf("Formatting store\n");
+    result = tsdb_format(&db, &device, &config);
+  }
+  if (result != TSDB_OK) {
+    printf("Store error %d\n", result);
+    PROCESS_EXIT();
+  }
+
+  time_base = db.last;
+  printf("Store mounted, %lu data blocks written so far\n", (unsigned long) (db.seq - 1));
+
+  etimer_set(&et, CLOCK_SECOND / 10);
+  while (1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    result = tsdb_append(&db, now(), sample());
+    if (result != TSDB_OK)
+      printf("Append error %d\n", result);
+
+    if (++samples == 100) {
+      samples = 0;
+      result = tsdb_sync(&db);
+      if (result != TSDB_OK)
+        printf("Sync error %d\n", result);
+
+      query_last_minute();
+      query_last_hour();
+    }
+  }
+
+  PROCESS_END();
+}
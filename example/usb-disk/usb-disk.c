@@ -0,0 +1,74 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the USB disk example.                                                          |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "sdcard.h"
+#include "usb-msc.h"
+
+//Blocks read by the speed test, and blocks per read.
+#define TEST_BLOCKS 4096
+#define TEST_CHUNK 32
+
+static uint8_t buffer[TEST_CHUNK * SDCARD_BLOCK_SIZE] __attribute__((aligned(4)));
+
+PROCESS(usb_disk, "USB disk");
+
+AUTOSTART_PROCESSES(&usb_disk);
+
+//Measures the read speed of the card, from the start of it.
+static void speed_test() {
+  clock_time_t start, elapsed;
+  uint32_t block;
+  int result = SDCARD_OK;
+
+  start = clock_time();
+  for (block = 0; block < TEST_BLOCKS && result == SDCARD_OK; block += TEST_CHUNK)
+    result = sdcard_read(block, buffer, TEST_CHUNK);
+  elapsed = clock_time() - start;
+
+  if (result != SDCARD_OK) {
+    printf("Read error %d at block %lu\n", result, (unsigned long) block);
+    return;
+  }
+
+  printf("Read %lu KB in %lu ms (%lu KB/s)\n", (unsigned long) (TEST_BLOCKS / 2),
+         (unsigned long) (elapsed * 1000 / CLOCK_SECOND),
+         (unsigned long) ((TEST_BLOCKS / 2) * CLOCK_SECOND / (elapsed ? elapsed : 1)));
+}
+
+PROCESS_THREAD(usb_disk, ev, data) {
+  int result;
+
+  PROCESS_BEGIN();
+
+  result = sdcard_init();
+  if (result == SDCARD_OK)
+    printf("Card of %lu MB\n", (unsigned long) (sdcard_blocks() / 2048));
+  else
+    printf("No card (error %d)\n", result);
+
+  if (result == SDCARD_OK)
+    speed_test();
+
+  usb_msc_init();
+
+  for (;;) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == usb_msc_event);
+
+    if (usb_msc_mounted()) {
+      printf("Mounted by the host, card write protected\n");
+    } else {
+      //The host is done with the card (or gone), so it's free again.
+      printf("Released by the host\n");
+      if (sdcard_blocks() > 0)
+        speed_test();
+    }
+  }
+
+  PROCESS_END();
+}
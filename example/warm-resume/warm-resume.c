@@ -0,0 +1,64 @@
+//+------------------------------------------------------------------------------------------------+
+//| Source code for the warm resume example.                                                       |
+//|                                                                                                |
+//| A sampler process takes a sample every 10 seconds and suspends the system in between, so each  |
+//| wakeup resumes it where it left off instead of booting it again. A second process keeps an     |
+//| event timer running across the suspends, to show that timers follow the time slept.            |
+//|                                                                                                |
+//| Author: Joksan Alvarado.                                                                       |
+//+------------------------------------------------------------------------------------------------+
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "lowpower.h"
+#include "mk66-startup.h"
+
+#define SAMPLE_PERIOD   10000   //Milliseconds
+#define MINUTE_TIMER    (60 * CLOCK_SECOND)
+
+PROCESS(sampler, "Sampler");
+PROCESS(minutes, "Minutes");
+
+AUTOSTART_PROCESSES(&sampler, &minutes);
+
+PROCESS_THREAD(sampler, ev, data) {
+  static struct etimer et;
+  static uint32_t samples;
+
+  PROCESS_BEGIN();
+
+  printf("Cold boot in %lu us\n", (unsigned long) startup_boot_time());
+
+  for (;;) {
+    //Take the sample (a count stands for it here).
+    samples++;
+    printf("Sample %lu at %lu s\n", (unsigned long) samples, (unsigned long) clock_seconds());
+
+    //Let the output out, since the UART stops along with the clocks, then suspend until the next
+    //sample is due.
+    etimer_set(&et, CLOCK_SECOND / 16);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    lowpower_suspend(SAMPLE_PERIOD);
+    PROCESS_WAIT_EVENT_UNTIL(ev == lowpower_resume_event);
+
+    printf("Resumed in %lu us\n", (unsigned long) startup_boot_time());
+  }
+
+  PROCESS_END();
+}
+
+PROCESS_THREAD(minutes, ev, data) {
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  etimer_set(&et, MINUTE_TIMER);
+  for (;;) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+    printf("A minute went by\n");
+  }
+
+  PROCESS_END();
+}
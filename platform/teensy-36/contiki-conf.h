@@ -11,9 +11,21 @@
 
 #define CLOCK_CONF_SECOND 128
 
+//Place the neural network runtime arena in the upper SRAM block.
+#define NN_CONF_ARENA_SECTION ".sram_u"
+
+//Keep a full framebuffer for the display driver, also in the upper SRAM block.
+#define DISPLAY_CONF_FRAMEBUFFER 1
+#define DISPLAY_CONF_FRAMEBUFFER_SECTION ".sram_u"
+
 typedef uint32_t clock_time_t;
 typedef uint16_t uip_stats_t;
 
+//Use 32 bit rtimer values. Contiki's rtimer.h only declares its 16 bit type when the difference
+//macro isn't defined, so both go together.
+typedef uint32_t rtimer_clock_t;
+#define RTIMER_CLOCK_DIFF(a, b) ((int32_t) ((a) - (b)))
+
 #define CCIF
 #define CLIF
 
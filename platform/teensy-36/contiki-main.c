@@ -18,28 +18,57 @@
 #include "contiki.h"
 
 #include "mk66-port.h"
+#include "mk66-startup.h"
 #include "uart.h"
+#include "extram.h"
+#include "lowpower.h"
 
 void main() {
   //Initialize the clock library, including timers.
   clock_init();
+  rtimer_init();
 
-  //Configure the port multiplexing to use the UART0 alternate function on pins PTB16 and PTB17,
-  //then initialize the UART0 peripheral (used for standard output).
+#if EXTRAM_ENABLED
+  //Bring up the external memory before anything uses it. Its bus takes pins PTB16 and PTB17, so
+  //the UART0 alternate function is used on pins PTA15 and PTA14 instead. The memory keeps its
+  //contents through a suspend, so the allocation pool is only set up on a cold boot.
+  extram_init();
+  if (!startup_resumed())
+    extram_pool_init();
+  PORTA->PCR[15] = PORT_PCR_DSE_High | PORT_PCR_MUX_Alt3;   //Use PTA15 as RX
+  PORTA->PCR[14] = PORT_PCR_DSE_High | PORT_PCR_MUX_Alt3;   //Use PTA14 as TX
+#else
+  //Configure the port multiplexing to use the UART0 alternate function on pins PTB16 and PTB17.
   PORTB->PCR[16] = PORT_PCR_DSE_High | PORT_PCR_MUX_Alt3;   //Use PTB16 as RX
   PORTB->PCR[17] = PORT_PCR_DSE_High | PORT_PCR_MUX_Alt3;   //Use PTB17 as TX
+#endif
+
+  //Initialize the UART0 peripheral (used for standard output).
   uart_init(UART0);
 
-  //Print the operating system version.
-  PRINTF("Starting %s\n", CONTIKI_VERSION_STRING);
+  //Initialize system processes, unless resumed from a suspend (they're as they were left then).
+  if (!startup_resumed()) {
+    process_init();
+    process_start(&etimer_process, NULL);
+    ctimer_init();
+  }
 
-  //Initialize system processes.
-  process_init();
-  process_start(&etimer_process, NULL);
-  ctimer_init();
+  //Engage the PLL if the system booted from the FLL, which has been locking meanwhile. The
+  //peripherals above are configured for the final clocks, and only the external memory has been
+  //used yet (its wait states are only longer on a slower FlexBus clock).
+  startup_engage_pll();
 
-  //Automatically start user processes.
-  autostart_start(autostart_processes);
+  if (startup_resumed()) {
+    //Processes and timers are as they were left, so just let them know.
+    lowpower_resume();
+  }
+  else {
+    //Print the operating system version.
+    PRINTF("Starting %s\n", CONTIKI_VERSION_STRING);
+
+    //Automatically start user processes.
+    autostart_start(autostart_processes);
+  }
 
   //Run the system.
   for (;;) {
@@ -49,6 +78,8 @@ void main() {
       n = process_run();
     } while (n > 0);
 
-    //TODO: Call sleep function here. Keep power consumption low.
+    //No process has anything left to do. Enter the suspend a process asked for, if any, or sleep
+    //until the next interrupt otherwise.
+    lowpower_idle();
   }
 }
@@ -14,6 +14,11 @@
 typedef uint32_t clock_time_t;
 typedef uint16_t uip_stats_t;
 
+//Use 32 bit rtimer values. Contiki's rtimer.h only declares its 16 bit type when the difference
+//macro isn't defined, so both go together.
+typedef uint32_t rtimer_clock_t;
+#define RTIMER_CLOCK_DIFF(a, b) ((int32_t) ((a) - (b)))
+
 #define CCIF
 #define CLIF
 
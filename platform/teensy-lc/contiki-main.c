@@ -18,11 +18,13 @@
 #include "contiki.h"
 
 #include "mkl26-port.h"
+#include "mkl26-startup.h"
 #include "uart.h"
 
 void main() {
   //Initialize the clock library, including timers.
   clock_init();
+  rtimer_init();
 
   //Configure the port multiplexing to use the UART0 alternate function on pins PTB16 and PTB17,
   //then initialize the UART0 peripheral (used for standard output).
@@ -30,14 +32,18 @@ void main() {
   PORTB->PCR[17] = PORT_PCR_DSE_High | PORT_PCR_MUX_Alt3;   //Use PTB17 as TX
   uart_init(UART0);
 
-  //Print the operating system version.
-  PRINTF("Starting %s\n", CONTIKI_VERSION_STRING);
-
   //Initialize system processes.
   process_init();
   process_start(&etimer_process, NULL);
   ctimer_init();
 
+  //Engage the PLL if the system booted from the FLL, which has been locking meanwhile. The
+  //peripherals above are configured for the final clocks, and nothing has used them yet.
+  startup_engage_pll();
+
+  //Print the operating system version.
+  PRINTF("Starting %s\n", CONTIKI_VERSION_STRING);
+
   //Automatically start user processes.
   autostart_start(autostart_processes);
 